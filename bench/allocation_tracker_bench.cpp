@@ -0,0 +1,84 @@
+#include "benchmark.hpp"
+
+#include "allocation_tracker.hpp"
+
+// Overhead of the allocation tracker : batches of small allocations (the typical churn of a frame loop, such as
+// std::function and std::string) freed in reverse order, through the C heap and through the tracker, without and with
+// callstack sampling. The benchmarks are not linked with allocation_hooks.cpp, so only the tracked allocations are
+// counted. Snapshots are measured with the counters of every thread of the benchmarks' job system.
+namespace
+{
+using namespace nether;
+using namespace nether::memory;
+
+constexpr u32 NUM_ALLOCATIONS = 1024u;
+
+template <u32 Size> void malloc_benchmark(bench::benchmark_state_t &state)
+{
+    std::array<void *, NUM_ALLOCATIONS> allocations{};
+    while (state.keep_running())
+    {
+        for (void *&allocation : allocations)
+        {
+            allocation = std::malloc(Size);
+        }
+
+        bench::clobber_memory();
+
+        for (u32 i = NUM_ALLOCATIONS; i-- > 0u;)
+        {
+            std::free(allocations[i]);
+        }
+    }
+
+    state.set_items_per_iteration(NUM_ALLOCATIONS);
+}
+
+template <u32 Size, u32 SamplingInterval> void tracked_allocation_benchmark(bench::benchmark_state_t &state)
+{
+    const memory_tag_scope_t tag_scope(memory_tag_t::render);
+    set_callstack_sampling_interval(SamplingInterval);
+
+    std::array<void *, NUM_ALLOCATIONS> allocations{};
+    while (state.keep_running())
+    {
+        for (void *&allocation : allocations)
+        {
+            allocation = tracked_allocate(Size);
+        }
+
+        bench::clobber_memory();
+
+        for (u32 i = NUM_ALLOCATIONS; i-- > 0u;)
+        {
+            tracked_free(allocations[i]);
+        }
+    }
+
+    set_callstack_sampling_interval(0u);
+    reset_callstack_samples();
+
+    state.set_items_per_iteration(NUM_ALLOCATIONS);
+}
+
+void snapshot_benchmark(bench::benchmark_state_t &state)
+{
+    // Every worker has counters.
+    bench::get_job_system().parallel_for(1024u, 1u, [](const u32, const u32, const u32) {
+        tracked_free(tracked_allocate(16u));
+    });
+
+    while (state.keep_running())
+    {
+        bench::do_not_optimize(take_memory_snapshot());
+    }
+}
+
+NETHER_BENCHMARK("allocation_tracker/malloc/32b", (malloc_benchmark<32u>));
+NETHER_BENCHMARK("allocation_tracker/malloc/1kb", (malloc_benchmark<1024u>));
+NETHER_BENCHMARK("allocation_tracker/tracked/32b", (tracked_allocation_benchmark<32u, 0u>));
+NETHER_BENCHMARK("allocation_tracker/tracked/1kb", (tracked_allocation_benchmark<1024u, 0u>));
+NETHER_BENCHMARK("allocation_tracker/tracked_sampled_1024/32b", (tracked_allocation_benchmark<32u, 1024u>));
+NETHER_BENCHMARK("allocation_tracker/tracked_sampled_64/32b", (tracked_allocation_benchmark<32u, 64u>));
+NETHER_BENCHMARK("allocation_tracker/snapshot", snapshot_benchmark);
+} // namespace
@@ -0,0 +1,249 @@
+#include "benchmark.hpp"
+
+#include "animation.hpp"
+
+#include <numbers>
+
+// Each stage of the animation pipeline for one character, then whole frames of many characters. The character
+// benchmarks report characters as items, so 1 M items/s is 1000 characters animated per millisecond.
+namespace
+{
+using namespace nether;
+
+constexpr u32 NUM_JOINTS = 64u;
+constexpr u32 NUM_FRAMES = 90u;
+
+float4_t axis_angle_rotation(const float3_t &axis, const f32 angle)
+{
+    const float3_t normalized_axis = normalize(axis);
+    const f32 sin_half_angle = std::sin(0.5f * angle);
+
+    return float4_t{normalized_axis.x * sin_half_angle, normalized_axis.y * sin_half_angle,
+                    normalized_axis.z * sin_half_angle, std::cos(0.5f * angle)};
+}
+
+// A humanoid sized skeleton : a spine with 4 branches (limbs) of 15 joints each.
+skeleton_t create_skeleton()
+{
+    std::vector<u32> parent_indices(NUM_JOINTS);
+    std::vector<joint_transform_t> bind_pose(NUM_JOINTS);
+    for (u32 i = 0u; i < NUM_JOINTS; i++)
+    {
+        if (i < 4u)
+        {
+            parent_indices[i] = i == 0u ? skeleton_t::INVALID_JOINT_INDEX : i - 1u;
+        }
+        else
+        {
+            const u32 limb_joint = (i - 4u) % 15u;
+            parent_indices[i] = limb_joint == 0u ? (i - 4u) / 15u : i - 1u;
+        }
+        bind_pose[i].translation = {0.0f, 0.2f, 0.05f * static_cast<f32>(i % 3u)};
+    }
+
+    return nether::create_skeleton(parent_indices, bind_pose);
+}
+
+raw_animation_clip_t create_raw_clip(const f32 frequency)
+{
+    raw_animation_clip_t clip = {
+        .sample_rate = 30.0f,
+        .num_frames = NUM_FRAMES,
+        .num_joints = NUM_JOINTS,
+        .samples = std::vector<joint_transform_t>(NUM_FRAMES * NUM_JOINTS),
+    };
+
+    for (u32 frame = 0u; frame < NUM_FRAMES; frame++)
+    {
+        const f32 time = static_cast<f32>(frame) / clip.sample_rate;
+        for (u32 joint = 0u; joint < NUM_JOINTS; joint++)
+        {
+            const f32 phase = 2.0f * std::numbers::pi_v<f32> * frequency * time + 0.3f * static_cast<f32>(joint);
+
+            clip.samples[frame * NUM_JOINTS + joint] = joint_transform_t{
+                .rotation =
+                    axis_angle_rotation({std::cos(static_cast<f32>(joint)), 0.5f, 0.2f}, 0.8f * std::sin(phase)),
+                .translation = {0.0f, 0.2f, 0.05f * static_cast<f32>(joint % 3u)},
+            };
+        }
+    }
+
+    return clip;
+}
+
+// Shared by the benchmarks, as compression is much slower than everything else.
+const std::array<animation_clip_t, 2> &get_clips()
+{
+    static const std::array<animation_clip_t, 2> clips = {
+        compress_animation_clip(create_raw_clip(1.0f)),
+        compress_animation_clip(create_raw_clip(1.0f / 3.0f)),
+    };
+
+    return clips;
+}
+
+void compress_benchmark(bench::benchmark_state_t &state)
+{
+    const raw_animation_clip_t raw_clip = create_raw_clip(1.0f);
+
+    while (state.keep_running())
+    {
+        const animation_clip_t clip = compress_animation_clip(raw_clip);
+        bench::do_not_optimize(clip.rotation_keys.data());
+    }
+
+    state.set_bytes_per_iteration(raw_clip.samples.size() * sizeof(joint_transform_t));
+}
+
+void sample_benchmark(bench::benchmark_state_t &state)
+{
+    const animation_clip_t &clip = get_clips()[0];
+
+    std::vector<joint_transform_soa_t> pose(get_num_soa_transforms(NUM_JOINTS));
+    animation_sampling_context_t context{};
+
+    f32 time_in_s = 0.0f;
+    while (state.keep_running())
+    {
+        sample_animation_clip(clip, time_in_s, context, pose);
+        bench::do_not_optimize(pose.data());
+
+        time_in_s = std::fmod(time_in_s + 1.0f / 60.0f, clip.get_duration_in_s());
+    }
+
+    state.set_items_per_iteration(NUM_JOINTS);
+}
+
+// Scalar sampling of every joint, for comparison with sample_benchmark.
+void sample_scalar_benchmark(bench::benchmark_state_t &state)
+{
+    const animation_clip_t &clip = get_clips()[0];
+
+    std::vector<joint_transform_t> pose(NUM_JOINTS);
+
+    f32 time_in_s = 0.0f;
+    while (state.keep_running())
+    {
+        for (u32 i = 0u; i < NUM_JOINTS; i++)
+        {
+            pose[i] = sample_animation_clip_joint(clip, time_in_s, i);
+        }
+        bench::do_not_optimize(pose.data());
+
+        time_in_s = std::fmod(time_in_s + 1.0f / 60.0f, clip.get_duration_in_s());
+    }
+
+    state.set_items_per_iteration(NUM_JOINTS);
+}
+
+void blend_benchmark(bench::benchmark_state_t &state)
+{
+    const u32 num_soa_transforms = get_num_soa_transforms(NUM_JOINTS);
+
+    std::vector<joint_transform_soa_t> a(num_soa_transforms);
+    std::vector<joint_transform_soa_t> b(num_soa_transforms);
+    std::vector<joint_transform_soa_t> result(num_soa_transforms);
+
+    animation_sampling_context_t context{};
+    sample_animation_clip(get_clips()[0], 0.5f, context, a);
+    sample_animation_clip(get_clips()[1], 1.5f, context, b);
+
+    const pose_blend_layer_t layers[] = {{a, 0.3f}, {b, 0.7f}};
+    while (state.keep_running())
+    {
+        blend_poses(layers, result);
+        bench::do_not_optimize(result.data());
+    }
+
+    state.set_items_per_iteration(NUM_JOINTS);
+}
+
+void model_matrices_benchmark(bench::benchmark_state_t &state)
+{
+    const skeleton_t skeleton = create_skeleton();
+
+    std::vector<joint_transform_soa_t> pose(get_num_soa_transforms(NUM_JOINTS));
+    animation_sampling_context_t context{};
+    sample_animation_clip(get_clips()[0], 0.5f, context, pose);
+
+    std::vector<float4x4_t> model_matrices(NUM_JOINTS);
+    while (state.keep_running())
+    {
+        compute_model_matrices(skeleton, pose, model_matrices);
+        bench::do_not_optimize(model_matrices.data());
+    }
+
+    state.set_items_per_iteration(NUM_JOINTS);
+}
+
+void skinning_matrices_benchmark(bench::benchmark_state_t &state)
+{
+    const skeleton_t skeleton = create_skeleton();
+
+    std::vector<joint_transform_soa_t> pose(get_num_soa_transforms(NUM_JOINTS));
+    animation_sampling_context_t context{};
+    sample_animation_clip(get_clips()[0], 0.5f, context, pose);
+
+    std::vector<float4x4_t> model_matrices(NUM_JOINTS);
+    compute_model_matrices(skeleton, pose, model_matrices);
+
+    const float4x4_t world_matrix = translation_matrix({1.0f, 0.0f, 3.0f});
+    std::vector<float4x4_t> skinning_matrices(NUM_JOINTS);
+    while (state.keep_running())
+    {
+        compute_skinning_matrices(skeleton, model_matrices, world_matrix, skinning_matrices);
+        bench::do_not_optimize(skinning_matrices.data());
+    }
+
+    state.set_items_per_iteration(NUM_JOINTS);
+    state.set_bytes_per_iteration(NUM_JOINTS * sizeof(float4x4_t));
+}
+
+// A frame of NumCharacters characters, each blending both clips, at different times.
+template <u32 NumCharacters, bool Parallel> void characters_benchmark(bench::benchmark_state_t &state)
+{
+    const skeleton_t skeleton = create_skeleton();
+    const std::array<animation_clip_t, 2> &clips = get_clips();
+
+    std::vector<animated_character_t> characters(NumCharacters);
+    for (u32 i = 0u; i < NumCharacters; i++)
+    {
+        animated_character_t &character = characters[i];
+        character.num_layers = 2u;
+        character.layers[0] = {.clip = &clips[0], .time_in_s = 0.01f * static_cast<f32>(i), .weight = 0.6f};
+        character.layers[1] = {.clip = &clips[1], .time_in_s = 0.02f * static_cast<f32>(i), .weight = 0.4f};
+        character.world_matrix = translation_matrix({static_cast<f32>(i % 32u), 0.0f, static_cast<f32>(i / 32u)});
+    }
+
+    std::vector<float4x4_t> skinning_matrices(NumCharacters * NUM_JOINTS);
+    while (state.keep_running())
+    {
+        state.pause_timing();
+        for (animated_character_t &character : characters)
+        {
+            for (u32 layer = 0u; layer < character.num_layers; layer++)
+            {
+                animation_layer_t &animation_layer = character.layers[layer];
+                animation_layer.time_in_s =
+                    std::fmod(animation_layer.time_in_s + 1.0f / 60.0f, animation_layer.clip->get_duration_in_s());
+            }
+        }
+        state.resume_timing();
+
+        animate_characters(skeleton, characters, skinning_matrices, Parallel ? &bench::get_job_system() : nullptr);
+        bench::do_not_optimize(skinning_matrices.data());
+    }
+
+    state.set_items_per_iteration(NumCharacters);
+    state.set_bytes_per_iteration(NumCharacters * NUM_JOINTS * sizeof(float4x4_t));
+}
+
+NETHER_BENCHMARK("animation/compress", compress_benchmark);
+NETHER_BENCHMARK("animation/sample", sample_benchmark);
+NETHER_BENCHMARK("animation/sample_scalar", sample_scalar_benchmark);
+NETHER_BENCHMARK("animation/blend", blend_benchmark);
+NETHER_BENCHMARK("animation/model_matrices", model_matrices_benchmark);
+NETHER_BENCHMARK("animation/skinning_matrices", skinning_matrices_benchmark);
+NETHER_BENCHMARK("animation/characters/1000", (characters_benchmark<1000u, false>));
+NETHER_BENCHMARK("animation/parallel_characters/1000", (characters_benchmark<1000u, true>));
+} // namespace
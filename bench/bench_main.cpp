@@ -0,0 +1,140 @@
+#include "benchmark.hpp"
+
+// Runs the benchmarks registered with NETHER_BENCHMARK (see benchmark.hpp, and nether-bench --help for the options).
+// Returns 1 if a benchmark regressed compared to the baseline.
+namespace
+{
+std::string format_time(const f64 time_in_ns)
+{
+    if (time_in_ns >= 1.0e6)
+    {
+        return std::format("{:.3f} ms", time_in_ns / 1.0e6);
+    }
+
+    if (time_in_ns >= 1.0e3)
+    {
+        return std::format("{:.3f} us", time_in_ns / 1.0e3);
+    }
+
+    return std::format("{:.2f} ns", time_in_ns);
+}
+
+std::string format_throughput(const nether::bench::benchmark_result_t &result)
+{
+    if (result.bytes_per_second > 0.0)
+    {
+        return std::format("{:.2f} GiB/s", result.bytes_per_second / (1024.0 * 1024.0 * 1024.0));
+    }
+
+    if (result.items_per_second > 0.0)
+    {
+        return std::format("{:.2f} M items/s", result.items_per_second / 1.0e6);
+    }
+
+    return "";
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        const std::vector<std::string_view> arguments(argv + 1, argv + argc);
+
+        const std::optional<nether::bench::benchmark_options_t> options =
+            nether::bench::parse_benchmark_options(arguments);
+        if (!options)
+        {
+            return 0;
+        }
+
+        std::vector<const nether::bench::benchmark_t *> benchmarks{};
+        for (const nether::bench::benchmark_t &benchmark : nether::bench::get_benchmarks())
+        {
+            if (benchmark.name.find(options->filter) != std::string::npos)
+            {
+                benchmarks.push_back(&benchmark);
+            }
+        }
+
+        if (options->list_only)
+        {
+            for (const nether::bench::benchmark_t *benchmark : benchmarks)
+            {
+                std::cout << benchmark->name << '\n';
+            }
+
+            return 0;
+        }
+
+        // Created before pinning, so that the job system's workers are not pinned to the same CPU.
+        nether::bench::get_job_system();
+
+        if (options->cpu_index >= 0 && !nether::bench::pin_current_thread_to_cpu(options->cpu_index))
+        {
+            std::cout << std::format("Warning : failed to pin the benchmark thread to CPU {}", options->cpu_index)
+                      << std::endl;
+        }
+
+        if constexpr (NETHER_DEBUG)
+        {
+            std::cout << "Warning : this is a debug build, the results are not representative" << std::endl;
+        }
+
+        std::cout << std::format("{:<48} {:>14} {:>14} {:>14} {:>8} {:>16}\n", "benchmark", "median", "min",
+                                 "stddev", "samples", "throughput");
+
+        std::vector<nether::bench::benchmark_result_t> results{};
+        for (const nether::bench::benchmark_t *benchmark : benchmarks)
+        {
+            const nether::bench::benchmark_result_t &result =
+                results.emplace_back(nether::bench::run_benchmark(*benchmark, *options));
+
+            std::cout << std::format("{:<48} {:>14} {:>14} {:>14} {:>8} {:>16}", result.name,
+                                     format_time(result.median_time_in_ns), format_time(result.min_time_in_ns),
+                                     format_time(result.standard_deviation_in_ns), result.num_samples,
+                                     format_throughput(result))
+                      << std::endl;
+        }
+
+        if (!options->json_path.empty())
+        {
+            nether::bench::write_benchmark_results(options->json_path, results);
+            std::cout << std::format("Results written to {}", options->json_path.string()) << std::endl;
+        }
+
+        if (options->baseline_path.empty())
+        {
+            return 0;
+        }
+
+        const std::vector<nether::bench::benchmark_result_t> baseline =
+            nether::bench::load_benchmark_results(options->baseline_path);
+        const std::vector<nether::bench::benchmark_comparison_t> comparisons =
+            nether::bench::compare_benchmark_results(baseline, results, options->regression_threshold_percent);
+
+        std::cout << std::format("\nComparison with {} (threshold {:.1f}%)\n", options->baseline_path.string(),
+                                 options->regression_threshold_percent);
+        std::cout << std::format("{:<48} {:>14} {:>14} {:>9}\n", "benchmark", "baseline", "median", "change");
+
+        u32 num_regressions = 0u;
+        for (const nether::bench::benchmark_comparison_t &comparison : comparisons)
+        {
+            std::cout << std::format("{:<48} {:>14} {:>14} {:>+8.1f}%{}\n", comparison.name,
+                                     format_time(comparison.baseline_median_time_in_ns),
+                                     format_time(comparison.median_time_in_ns), comparison.change_percent,
+                                     comparison.regression ? "  REGRESSION" : "");
+
+            num_regressions += comparison.regression ? 1u : 0u;
+        }
+
+        std::cout << std::format("{} of {} benchmarks regressed", num_regressions, comparisons.size()) << std::endl;
+
+        return num_regressions > 0u ? 1 : 0;
+    }
+    catch (std::exception &e)
+    {
+        std::cout << e.what() << std::endl;
+        return -1;
+    }
+}
@@ -0,0 +1,363 @@
+#include "benchmark.hpp"
+
+#include <charconv>
+#include <cmath>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace nether::bench
+{
+namespace
+{
+constexpr std::string_view USAGE = R"(Usage : nether-bench [options]
+  --filter <text>              Only run the benchmarks whose name contains text.
+  --list                       Print the names of the benchmarks and exit.
+  --samples <count>            Number of measured samples per benchmark (default 10).
+  --min-sample-time <ms>       Minimum duration of a sample (default 10).
+  --warmup <ms>                Time spent running a benchmark before measuring it (default 100).
+  --cpu <index>                CPU to pin the runner to, -1 to not pin (default 0).
+  --json <path>                Write the results to a JSON file.
+  --baseline <path>            Compare the results to a JSON file of a previous run.
+  --threshold <percent>        Slowdown of the median time above which a benchmark is a regression (default 10).
+)";
+
+// Iteration counts are capped, so that a benchmark that is optimized away does not run forever.
+constexpr u64 MAX_ITERATIONS_PER_SAMPLE = 1ull << 32u;
+
+template <typename T> T parse_number(const std::string_view option, const std::string_view text)
+{
+    T value{};
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc{} || end != text.data() + text.size())
+    {
+        throw std::runtime_error(std::format("Invalid value {} for option {}", text, option));
+    }
+
+    return value;
+}
+
+benchmark_state_t run_sample(const benchmark_t &benchmark, const u64 num_iterations)
+{
+    benchmark_state_t state(num_iterations);
+    benchmark.function(state);
+
+    if (state.get_num_remaining_iterations() != 0u)
+    {
+        throw std::runtime_error(
+            std::format("Benchmark {} did not run every iteration (keep_running must be called until it returns false)",
+                        benchmark.name));
+    }
+
+    return state;
+}
+
+// Finds "key": in a line written by write_benchmark_results, and returns what follows.
+std::optional<std::string_view> find_json_value(const std::string_view line, const std::string_view key)
+{
+    const std::string quoted_key = std::format("\"{}\": ", key);
+
+    const size_t key_position = line.find(quoted_key);
+    if (key_position == std::string_view::npos)
+    {
+        return std::nullopt;
+    }
+
+    return line.substr(key_position + quoted_key.size());
+}
+} // namespace
+
+std::vector<benchmark_t> &get_benchmarks()
+{
+    static std::vector<benchmark_t> benchmarks{};
+    return benchmarks;
+}
+
+job_system_t &get_job_system()
+{
+    static job_system_t job_system{};
+    return job_system;
+}
+
+std::optional<benchmark_options_t> parse_benchmark_options(const std::span<const std::string_view> arguments)
+{
+    benchmark_options_t options{};
+
+    for (size_t i = 0; i < arguments.size(); i++)
+    {
+        const std::string_view option = arguments[i];
+
+        if (option == "--help")
+        {
+            std::cout << USAGE;
+            return std::nullopt;
+        }
+
+        if (option == "--list")
+        {
+            options.list_only = true;
+            continue;
+        }
+
+        if (i + 1 == arguments.size())
+        {
+            throw std::runtime_error(std::format("Unknown option or missing value for option {}\n{}", option, USAGE));
+        }
+
+        const std::string_view value = arguments[++i];
+
+        if (option == "--filter")
+        {
+            options.filter = value;
+        }
+        else if (option == "--samples")
+        {
+            options.num_samples = std::max(parse_number<u32>(option, value), 1u);
+        }
+        else if (option == "--min-sample-time")
+        {
+            options.min_sample_time_in_ms = parse_number<f32>(option, value);
+        }
+        else if (option == "--warmup")
+        {
+            options.warmup_time_in_ms = parse_number<f32>(option, value);
+        }
+        else if (option == "--cpu")
+        {
+            options.cpu_index = parse_number<i32>(option, value);
+        }
+        else if (option == "--json")
+        {
+            options.json_path = value;
+        }
+        else if (option == "--baseline")
+        {
+            options.baseline_path = value;
+        }
+        else if (option == "--threshold")
+        {
+            options.regression_threshold_percent = parse_number<f32>(option, value);
+        }
+        else
+        {
+            throw std::runtime_error(std::format("Unknown option {}\n{}", option, USAGE));
+        }
+    }
+
+    return options;
+}
+
+benchmark_result_t run_benchmark(const benchmark_t &benchmark, const benchmark_options_t &options)
+{
+    const f64 min_sample_time_in_ns = options.min_sample_time_in_ms * 1.0e6;
+
+    // Grow the number of iterations until a sample is long enough for the timer's resolution and overhead to not
+    // matter. The growth per step is limited, as the first (cold) samples overestimate the time per iteration.
+    u64 num_iterations = 1u;
+    while (true)
+    {
+        const f64 time_in_ns = run_sample(benchmark, num_iterations).get_elapsed_time_in_ns();
+        if (time_in_ns >= min_sample_time_in_ns || num_iterations >= MAX_ITERATIONS_PER_SAMPLE)
+        {
+            break;
+        }
+
+        const f64 scale = time_in_ns > 0.0 ? std::clamp(1.2 * min_sample_time_in_ns / time_in_ns, 1.0, 10.0) : 10.0;
+        num_iterations = std::min(std::max(static_cast<u64>(num_iterations * scale), num_iterations + 1u),
+                                  MAX_ITERATIONS_PER_SAMPLE);
+    }
+
+    // Warm up the caches, branch predictors and CPU clocks.
+    const auto warmup_start_time = std::chrono::steady_clock::now();
+    while (std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - warmup_start_time).count() <
+           options.warmup_time_in_ms)
+    {
+        run_sample(benchmark, num_iterations);
+    }
+
+    std::vector<f64> times_in_ns(options.num_samples);
+    u64 items_per_iteration = 0u;
+    u64 bytes_per_iteration = 0u;
+
+    for (f64 &time_in_ns : times_in_ns)
+    {
+        const benchmark_state_t state = run_sample(benchmark, num_iterations);
+
+        time_in_ns = state.get_elapsed_time_in_ns() / num_iterations;
+        items_per_iteration = state.get_items_per_iteration();
+        bytes_per_iteration = state.get_bytes_per_iteration();
+    }
+
+    std::sort(times_in_ns.begin(), times_in_ns.end());
+
+    const size_t num_samples = times_in_ns.size();
+    const f64 median_time_in_ns = num_samples % 2u ? times_in_ns[num_samples / 2u]
+                                                   : 0.5 * (times_in_ns[num_samples / 2u - 1u] +
+                                                            times_in_ns[num_samples / 2u]);
+
+    f64 mean_time_in_ns = 0.0;
+    for (const f64 time_in_ns : times_in_ns)
+    {
+        mean_time_in_ns += time_in_ns / num_samples;
+    }
+
+    f64 variance = 0.0;
+    for (const f64 time_in_ns : times_in_ns)
+    {
+        variance += (time_in_ns - mean_time_in_ns) * (time_in_ns - mean_time_in_ns);
+    }
+    variance = num_samples > 1u ? variance / (num_samples - 1u) : 0.0;
+
+    return {
+        .name = benchmark.name,
+        .num_iterations_per_sample = num_iterations,
+        .num_samples = static_cast<u32>(num_samples),
+        .median_time_in_ns = median_time_in_ns,
+        .mean_time_in_ns = mean_time_in_ns,
+        .min_time_in_ns = times_in_ns.front(),
+        .max_time_in_ns = times_in_ns.back(),
+        .standard_deviation_in_ns = std::sqrt(variance),
+        .items_per_second = median_time_in_ns > 0.0 ? items_per_iteration * 1.0e9 / median_time_in_ns : 0.0,
+        .bytes_per_second = median_time_in_ns > 0.0 ? bytes_per_iteration * 1.0e9 / median_time_in_ns : 0.0,
+    };
+}
+
+bool pin_current_thread_to_cpu(const u32 cpu_index)
+{
+#if defined(_WIN32)
+    if (cpu_index >= 64u)
+    {
+        return false;
+    }
+
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1u} << cpu_index) != 0u;
+#elif defined(__linux__)
+    if (cpu_index >= CPU_SETSIZE)
+    {
+        return false;
+    }
+
+    cpu_set_t cpu_set{};
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu_index, &cpu_set);
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+    return false;
+#endif
+}
+
+void write_benchmark_results(const std::filesystem::path &path, const std::span<const benchmark_result_t> results)
+{
+    if (path.has_parent_path())
+    {
+        std::filesystem::create_directories(path.parent_path());
+    }
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error(std::format("Failed to create benchmark results file {}", path.string()));
+    }
+
+    file << std::format("{{\n  \"debug\": {},\n  \"benchmarks\": [\n", NETHER_DEBUG);
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const benchmark_result_t &result = results[i];
+
+        file << std::format("    {{\"name\": \"{}\", \"iterations\": {}, \"samples\": {}, \"median_ns\": {:.3f}, "
+                            "\"mean_ns\": {:.3f}, \"min_ns\": {:.3f}, \"max_ns\": {:.3f}, \"stddev_ns\": {:.3f}, "
+                            "\"items_per_second\": {:.1f}, \"bytes_per_second\": {:.1f}}}{}\n",
+                            result.name, result.num_iterations_per_sample, result.num_samples,
+                            result.median_time_in_ns, result.mean_time_in_ns, result.min_time_in_ns,
+                            result.max_time_in_ns, result.standard_deviation_in_ns, result.items_per_second,
+                            result.bytes_per_second, i + 1 == results.size() ? "" : ",");
+    }
+
+    file << "  ]\n}\n";
+}
+
+std::vector<benchmark_result_t> load_benchmark_results(const std::filesystem::path &path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error(std::format("Failed to open benchmark results file {}", path.string()));
+    }
+
+    const auto parse_value = [&](const std::string_view line, const std::string_view key) {
+        const std::optional<std::string_view> value = find_json_value(line, key);
+        if (!value)
+        {
+            throw std::runtime_error(std::format("Missing {} in benchmark results file {}", key, path.string()));
+        }
+
+        f64 result{};
+        std::from_chars(value->data(), value->data() + value->size(), result);
+
+        return result;
+    };
+
+    std::vector<benchmark_result_t> results{};
+
+    std::string line{};
+    while (std::getline(file, line))
+    {
+        // Benchmark names never contain quotes, so the name ends at the next one.
+        const std::optional<std::string_view> name = find_json_value(line, "name");
+        if (!name || name->size() < 2u || name->front() != '"')
+        {
+            continue;
+        }
+
+        results.push_back({
+            .name = std::string(name->substr(1u, name->find('"', 1u) - 1u)),
+            .num_iterations_per_sample = static_cast<u64>(parse_value(line, "iterations")),
+            .num_samples = static_cast<u32>(parse_value(line, "samples")),
+            .median_time_in_ns = parse_value(line, "median_ns"),
+            .mean_time_in_ns = parse_value(line, "mean_ns"),
+            .min_time_in_ns = parse_value(line, "min_ns"),
+            .max_time_in_ns = parse_value(line, "max_ns"),
+            .standard_deviation_in_ns = parse_value(line, "stddev_ns"),
+            .items_per_second = parse_value(line, "items_per_second"),
+            .bytes_per_second = parse_value(line, "bytes_per_second"),
+        });
+    }
+
+    return results;
+}
+
+std::vector<benchmark_comparison_t> compare_benchmark_results(const std::span<const benchmark_result_t> baseline,
+                                                              const std::span<const benchmark_result_t> results,
+                                                              const f32 regression_threshold_percent)
+{
+    std::vector<benchmark_comparison_t> comparisons{};
+
+    for (const benchmark_result_t &result : results)
+    {
+        const auto baseline_result = std::find_if(baseline.begin(), baseline.end(),
+                                                  [&](const benchmark_result_t &b) { return b.name == result.name; });
+        if (baseline_result == baseline.end() || baseline_result->median_time_in_ns <= 0.0)
+        {
+            continue;
+        }
+
+        const f64 baseline_median_time_in_ns = baseline_result->median_time_in_ns;
+        const f64 change_percent =
+            100.0 * (result.median_time_in_ns - baseline_median_time_in_ns) / baseline_median_time_in_ns;
+
+        comparisons.push_back({
+            .name = result.name,
+            .baseline_median_time_in_ns = baseline_median_time_in_ns,
+            .median_time_in_ns = result.median_time_in_ns,
+            .change_percent = change_percent,
+            .regression = change_percent > regression_threshold_percent,
+        });
+    }
+
+    return comparisons;
+}
+} // namespace nether::bench
@@ -0,0 +1,221 @@
+#pragma once
+
+#include "common.hpp"
+#include "job_system.hpp"
+
+#include <chrono>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// A small benchmark framework, so that the subsystems can be measured in isolation and compared between runs.
+// Benchmarks are functions registered with NETHER_BENCHMARK. Each call of the function does its setup, then runs the
+// timed loop (while (state.keep_running()) { ... }) for the number of iterations the runner asks for. The runner
+// calibrates the iterations so that a sample takes at least min_sample_time_in_ms, warms up, and then measures a
+// number of samples, of which it reports the median, mean, min, max and standard deviation of the time per iteration.
+namespace nether::bench
+{
+class benchmark_state_t
+{
+  public:
+    explicit benchmark_state_t(const u64 num_iterations) : num_remaining_iterations(num_iterations)
+    {
+    }
+
+    // Starts the timer on the first call, and stops it once every iteration has run.
+    bool keep_running()
+    {
+        if (!started)
+        {
+            started = true;
+            start_time = std::chrono::steady_clock::now();
+        }
+
+        if (num_remaining_iterations > 0u)
+        {
+            num_remaining_iterations--;
+            return true;
+        }
+
+        elapsed_time += std::chrono::steady_clock::now() - start_time;
+        return false;
+    }
+
+    // For per iteration setup that should not be measured.
+    void pause_timing()
+    {
+        elapsed_time += std::chrono::steady_clock::now() - start_time;
+    }
+
+    void resume_timing()
+    {
+        start_time = std::chrono::steady_clock::now();
+    }
+
+    // Work done by a single iteration, reported as throughput.
+    void set_items_per_iteration(const u64 items)
+    {
+        items_per_iteration = items;
+    }
+
+    void set_bytes_per_iteration(const u64 bytes)
+    {
+        bytes_per_iteration = bytes;
+    }
+
+    f64 get_elapsed_time_in_ns() const
+    {
+        return std::chrono::duration<f64, std::nano>(elapsed_time).count();
+    }
+
+    u64 get_items_per_iteration() const
+    {
+        return items_per_iteration;
+    }
+
+    u64 get_bytes_per_iteration() const
+    {
+        return bytes_per_iteration;
+    }
+
+    // Non zero if the benchmark stopped calling keep_running before the last iteration.
+    u64 get_num_remaining_iterations() const
+    {
+        return num_remaining_iterations;
+    }
+
+  private:
+    u64 num_remaining_iterations{};
+    bool started{};
+
+    std::chrono::steady_clock::time_point start_time{};
+    std::chrono::steady_clock::duration elapsed_time{};
+
+    u64 items_per_iteration{};
+    u64 bytes_per_iteration{};
+};
+
+using benchmark_function_t = void (*)(benchmark_state_t &state);
+
+struct benchmark_t
+{
+    std::string name{};
+    benchmark_function_t function{};
+};
+
+// Every benchmark registered with NETHER_BENCHMARK, in registration order.
+std::vector<benchmark_t> &get_benchmarks();
+
+struct benchmark_registrar_t
+{
+    benchmark_registrar_t(const std::string_view name, const benchmark_function_t function)
+    {
+        get_benchmarks().push_back({.name = std::string(name), .function = function});
+    }
+};
+
+// A job system shared by the benchmarks. It is created before the runner pins itself to a CPU, so its workers can run
+// on every CPU.
+job_system_t &get_job_system();
+
+// Prevents the compiler from optimizing away a value, and the computations it depends on.
+template <typename T> inline void do_not_optimize(const T &value)
+{
+#if defined(_MSC_VER)
+    const volatile u8 *volatile sink = reinterpret_cast<const volatile u8 *>(&value);
+    (void)sink;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+// Forces writes to memory to be considered observable (e.g. the contents of a buffer that is never read).
+inline void clobber_memory()
+{
+#if defined(_MSC_VER)
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : : "memory");
+#endif
+}
+
+struct benchmark_result_t
+{
+    std::string name{};
+
+    u64 num_iterations_per_sample{};
+    u32 num_samples{};
+
+    // Time per iteration.
+    f64 median_time_in_ns{};
+    f64 mean_time_in_ns{};
+    f64 min_time_in_ns{};
+    f64 max_time_in_ns{};
+    f64 standard_deviation_in_ns{};
+
+    // 0 if the benchmark does not report them.
+    f64 items_per_second{};
+    f64 bytes_per_second{};
+};
+
+struct benchmark_options_t
+{
+    // Only benchmarks whose name contains the filter are run.
+    std::string filter{};
+
+    // Print the names of the benchmarks instead of running them.
+    bool list_only{};
+
+    u32 num_samples{10u};
+    f32 min_sample_time_in_ms{10.0f};
+    f32 warmup_time_in_ms{100.0f};
+
+    // The CPU the runner pins itself to, to reduce the noise from thread migrations. Negative to not pin.
+    i32 cpu_index{0};
+
+    std::filesystem::path json_path{};
+
+    // Results of a previous run (written with json_path). A benchmark whose median time increased by more than
+    // regression_threshold_percent is a regression.
+    std::filesystem::path baseline_path{};
+    f32 regression_threshold_percent{10.0f};
+};
+
+// Throws on invalid arguments. Prints the usage (and returns std::nullopt) for --help.
+std::optional<benchmark_options_t> parse_benchmark_options(const std::span<const std::string_view> arguments);
+
+benchmark_result_t run_benchmark(const benchmark_t &benchmark, const benchmark_options_t &options);
+
+// Pins the calling thread to a CPU. Returns false if the platform does not support it or the CPU does not exist.
+bool pin_current_thread_to_cpu(const u32 cpu_index);
+
+// One benchmark per line, so that files can be compared with a text diff, and parsed back by load_benchmark_results.
+void write_benchmark_results(const std::filesystem::path &path, const std::span<const benchmark_result_t> results);
+std::vector<benchmark_result_t> load_benchmark_results(const std::filesystem::path &path);
+
+struct benchmark_comparison_t
+{
+    std::string name{};
+    f64 baseline_median_time_in_ns{};
+    f64 median_time_in_ns{};
+
+    // Positive if the benchmark got slower.
+    f64 change_percent{};
+    bool regression{};
+};
+
+// Benchmarks that are not in the baseline are not compared.
+std::vector<benchmark_comparison_t> compare_benchmark_results(const std::span<const benchmark_result_t> baseline,
+                                                              const std::span<const benchmark_result_t> results,
+                                                              const f32 regression_threshold_percent);
+} // namespace nether::bench
+
+#define NETHER_BENCHMARK_CONCATENATE_IMPL(a, b) a##b
+#define NETHER_BENCHMARK_CONCATENATE(a, b) NETHER_BENCHMARK_CONCATENATE_IMPL(a, b)
+
+// Registers a benchmark function with a name (which may contain '/' to group benchmarks).
+#define NETHER_BENCHMARK(name, function)                                                                              \
+    static const nether::bench::benchmark_registrar_t NETHER_BENCHMARK_CONCATENATE(benchmark_registrar_, __LINE__)(   \
+        name, function)
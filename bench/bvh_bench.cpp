@@ -0,0 +1,122 @@
+#include "benchmark.hpp"
+
+#include "bvh.hpp"
+
+namespace
+{
+using namespace nether;
+
+constexpr u32 NUM_PRIMITIVES = 100000u;
+
+std::vector<aabb_t> create_random_boxes(const u32 count)
+{
+    std::mt19937 random_engine(1u);
+    std::uniform_real_distribution<f32> position_distribution(-100.0f, 100.0f);
+    std::uniform_real_distribution<f32> extent_distribution(0.01f, 2.0f);
+
+    std::vector<aabb_t> boxes(count);
+    for (aabb_t &box : boxes)
+    {
+        const float3_t center = {position_distribution(random_engine), position_distribution(random_engine),
+                                 position_distribution(random_engine)};
+        const float3_t extent = {extent_distribution(random_engine), extent_distribution(random_engine),
+                                 extent_distribution(random_engine)};
+        box = {center - extent, center + extent};
+    }
+
+    return boxes;
+}
+
+void build_benchmark(bench::benchmark_state_t &state)
+{
+    const std::vector<aabb_t> boxes = create_random_boxes(NUM_PRIMITIVES);
+    bvh_t bvh{};
+
+    while (state.keep_running())
+    {
+        bvh.build(boxes);
+    }
+
+    state.set_items_per_iteration(NUM_PRIMITIVES);
+}
+
+void parallel_build_benchmark(bench::benchmark_state_t &state)
+{
+    const std::vector<aabb_t> boxes = create_random_boxes(NUM_PRIMITIVES);
+    bvh_t bvh{};
+
+    while (state.keep_running())
+    {
+        bvh.build(boxes, &bench::get_job_system());
+    }
+
+    state.set_items_per_iteration(NUM_PRIMITIVES);
+}
+
+void refit_benchmark(bench::benchmark_state_t &state)
+{
+    const std::vector<aabb_t> boxes = create_random_boxes(NUM_PRIMITIVES);
+    bvh_t bvh{};
+    bvh.build(boxes);
+
+    while (state.keep_running())
+    {
+        bvh.refit(boxes);
+    }
+
+    state.set_items_per_iteration(NUM_PRIMITIVES);
+}
+
+void query_aabb_benchmark(bench::benchmark_state_t &state)
+{
+    const std::vector<aabb_t> boxes = create_random_boxes(NUM_PRIMITIVES);
+    bvh_t bvh{};
+    bvh.build(boxes);
+
+    const std::vector<aabb_t> queries = create_random_boxes(256u);
+    std::vector<u32> results{};
+
+    u32 query_index = 0u;
+    while (state.keep_running())
+    {
+        const aabb_t &query = queries[query_index++ % queries.size()];
+
+        results.clear();
+        bvh.query_aabb({query.min - float3_t{10.0f, 10.0f, 10.0f}, query.max + float3_t{10.0f, 10.0f, 10.0f}},
+                       results);
+        bench::do_not_optimize(results.data());
+    }
+}
+
+void intersect_ray_benchmark(bench::benchmark_state_t &state)
+{
+    const std::vector<aabb_t> boxes = create_random_boxes(NUM_PRIMITIVES);
+    bvh_t bvh{};
+    bvh.build(boxes);
+
+    std::mt19937 random_engine(2u);
+    std::uniform_real_distribution<f32> distribution(-1.0f, 1.0f);
+
+    std::vector<ray_t> rays(1024u);
+    for (ray_t &ray : rays)
+    {
+        ray.origin = float3_t{distribution(random_engine), distribution(random_engine), distribution(random_engine)} *
+                     100.0f;
+        ray.direction =
+            normalize(float3_t{distribution(random_engine), distribution(random_engine), distribution(random_engine)});
+    }
+
+    u32 ray_index = 0u;
+    while (state.keep_running())
+    {
+        const ray_hit_t hit = bvh.intersect_ray(rays[ray_index++ % rays.size()]);
+        bench::do_not_optimize(hit);
+    }
+}
+
+NETHER_BENCHMARK("bvh/build", build_benchmark);
+NETHER_BENCHMARK("bvh/parallel_build", parallel_build_benchmark);
+NETHER_BENCHMARK("bvh/refit", refit_benchmark);
+NETHER_BENCHMARK("bvh/query_aabb", query_aabb_benchmark);
+NETHER_BENCHMARK("bvh/intersect_ray", intersect_ray_benchmark);
+} // namespace
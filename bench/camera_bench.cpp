@@ -0,0 +1,94 @@
+#include "benchmark.hpp"
+
+#include "scene.hpp"
+
+// The camera and projection math of the frame loop (see update_camera in scene.hpp and the frame loop in main.cpp).
+namespace
+{
+using namespace nether;
+
+scene::camera_component_t create_moving_camera()
+{
+    return scene::camera_component_t{
+        .position = {0.0f, 0.0f, -5.0f},
+        .velocity = {0.1f, 0.0f, 0.2f},
+        .target_pitch = 0.2f,
+        .target_yaw = 0.7f,
+    };
+}
+
+void update_camera_benchmark(bench::benchmark_state_t &state)
+{
+    scene::camera_component_t camera = create_moving_camera();
+
+    while (state.keep_running())
+    {
+        scene::update_camera(camera, camera.front + camera.right, 0.3f);
+        bench::do_not_optimize(camera);
+    }
+}
+
+void view_matrix_benchmark(bench::benchmark_state_t &state)
+{
+    scene::camera_component_t camera = create_moving_camera();
+    scene::update_camera(camera, camera.front, 0.3f);
+
+    while (state.keep_running())
+    {
+        bench::do_not_optimize(camera);
+        const float4x4_t view_matrix = scene::get_view_matrix(camera);
+        bench::do_not_optimize(view_matrix);
+    }
+}
+
+void projection_matrix_benchmark(bench::benchmark_state_t &state)
+{
+    f32 aspect_ratio = 16.0f / 9.0f;
+
+    while (state.keep_running())
+    {
+        bench::do_not_optimize(aspect_ratio);
+        const float4x4_t projection_matrix = perspective_reverse_z_matrix(to_radians(45.0f), aspect_ratio, 0.1f);
+        bench::do_not_optimize(projection_matrix);
+    }
+}
+
+void matrix_multiply_benchmark(bench::benchmark_state_t &state)
+{
+    float4x4_t a = rotation_roll_pitch_yaw_matrix(0.1f, 0.2f, 0.3f) * translation_matrix({1.0f, 2.0f, 3.0f});
+    float4x4_t b = perspective_reverse_z_matrix(to_radians(45.0f), 16.0f / 9.0f, 0.1f);
+
+    while (state.keep_running())
+    {
+        bench::do_not_optimize(a);
+        bench::do_not_optimize(b);
+        const float4x4_t result = a * b;
+        bench::do_not_optimize(result);
+    }
+}
+
+// Everything the frame loop does with the camera : the update, the view and projection matrices, the view projection
+// matrix and its frustum (used for culling).
+void camera_frame_benchmark(bench::benchmark_state_t &state)
+{
+    scene::camera_component_t camera = create_moving_camera();
+
+    while (state.keep_running())
+    {
+        scene::update_camera(camera, camera.front, 0.3f);
+
+        const float4x4_t projection_matrix = perspective_reverse_z_matrix(to_radians(45.0f), 16.0f / 9.0f, 0.1f);
+        const float4x4_t view_projection_matrix = scene::get_view_matrix(camera) * projection_matrix;
+        const frustum_t frustum = get_frustum(view_projection_matrix);
+
+        bench::do_not_optimize(view_projection_matrix);
+        bench::do_not_optimize(frustum);
+    }
+}
+
+NETHER_BENCHMARK("camera/update", update_camera_benchmark);
+NETHER_BENCHMARK("camera/view_matrix", view_matrix_benchmark);
+NETHER_BENCHMARK("camera/projection_matrix", projection_matrix_benchmark);
+NETHER_BENCHMARK("camera/matrix_multiply", matrix_multiply_benchmark);
+NETHER_BENCHMARK("camera/frame", camera_frame_benchmark);
+} // namespace
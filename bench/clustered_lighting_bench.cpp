@@ -0,0 +1,56 @@
+#include "benchmark.hpp"
+
+#include "clustered_lighting.hpp"
+
+namespace
+{
+using namespace nether;
+
+std::vector<light_t> create_random_lights(const u32 count)
+{
+    std::mt19937 random_engine(2u);
+    std::uniform_real_distribution<f32> distribution(-1.0f, 1.0f);
+    std::uniform_real_distribution<f32> unit_distribution(0.0f, 1.0f);
+
+    std::vector<light_t> lights(count);
+    for (light_t &light : lights)
+    {
+        light.position = {distribution(random_engine) * 100.0f, distribution(random_engine) * 30.0f,
+                          distribution(random_engine) * 150.0f + 60.0f};
+        light.range = 1.0f + unit_distribution(random_engine) * 10.0f;
+        light.color = {1.0f, 1.0f, 1.0f};
+
+        if (unit_distribution(random_engine) < 0.3f)
+        {
+            light.type = light_type_t::spot;
+            light.direction = normalize(
+                float3_t{distribution(random_engine), distribution(random_engine), distribution(random_engine)});
+            light.spot_cos_outer_angle = std::cos(0.2f + unit_distribution(random_engine));
+        }
+    }
+
+    return lights;
+}
+
+template <u32 NumLights, bool Parallel> void build_benchmark(bench::benchmark_state_t &state)
+{
+    const std::vector<light_t> lights = create_random_lights(NumLights);
+    const float4x4_t view_matrix = rotation_y_matrix(0.3f) * translation_matrix({1.0f, 2.0f, 3.0f});
+    const float4x4_t projection_matrix = perspective_reverse_z_matrix(to_radians(45.0f), 16.0f / 9.0f, 0.1f);
+
+    light_cluster_builder_t light_cluster_builder{};
+    light_cluster_builder.set_projection(projection_matrix.m[0][0], projection_matrix.m[1][1], 0.1f, 500.0f);
+
+    while (state.keep_running())
+    {
+        light_cluster_builder.build(lights, view_matrix, Parallel ? &bench::get_job_system() : nullptr);
+        bench::do_not_optimize(light_cluster_builder.light_indices.data());
+    }
+
+    state.set_items_per_iteration(NumLights);
+}
+
+NETHER_BENCHMARK("clustered_lighting/build/1024", (build_benchmark<1024u, false>));
+NETHER_BENCHMARK("clustered_lighting/build/4096", (build_benchmark<4096u, false>));
+NETHER_BENCHMARK("clustered_lighting/parallel_build/4096", (build_benchmark<4096u, true>));
+} // namespace
@@ -0,0 +1,76 @@
+#include "benchmark.hpp"
+
+#include "command_stream.hpp"
+
+namespace
+{
+using namespace nether;
+
+constexpr u32 NUM_DRAWS = 10000u;
+constexpr std::array<u32, 5> ROOT_CONSTANTS = {1u, 2u, 3u, 4u, 5u};
+
+// The commands of a typical draw : pipeline, index buffer, root constants and the draw itself.
+void record_draws(command_stream_t &command_stream)
+{
+    for (u32 i = 0u; i < NUM_DRAWS; i++)
+    {
+        command_stream.set_pipeline(i & 3u);
+        command_stream.set_index_buffer(256u, 72u, index_format_t::u16);
+        command_stream.set_root_constants(0u, ROOT_CONSTANTS);
+        command_stream.draw_indexed_instanced(36u, 1u);
+    }
+}
+
+void record_benchmark(bench::benchmark_state_t &state)
+{
+    memory::linear_arena_t arena(16u * 1024u * 1024u);
+
+    while (state.keep_running())
+    {
+        command_stream_t command_stream(arena);
+        record_draws(command_stream);
+        bench::do_not_optimize(command_stream);
+
+        arena.reset();
+    }
+
+    state.set_items_per_iteration(4u * NUM_DRAWS);
+}
+
+void iterate_benchmark(bench::benchmark_state_t &state)
+{
+    memory::linear_arena_t arena(16u * 1024u * 1024u);
+
+    command_stream_t command_stream(arena);
+    record_draws(command_stream);
+
+    while (state.keep_running())
+    {
+        u64 total_size = 0u;
+        command_stream.for_each_command([&](const command_header_t &header) { total_size += header.size; });
+        bench::do_not_optimize(total_size);
+    }
+
+    state.set_items_per_iteration(4u * NUM_DRAWS);
+}
+
+void validate_benchmark(bench::benchmark_state_t &state)
+{
+    memory::linear_arena_t arena(16u * 1024u * 1024u);
+
+    command_stream_t command_stream(arena);
+    record_draws(command_stream);
+
+    while (state.keep_running())
+    {
+        const std::vector<std::string> errors = validate(command_stream, {.num_pipelines = 4u, .num_resources = 1u});
+        bench::do_not_optimize(errors.data());
+    }
+
+    state.set_items_per_iteration(4u * NUM_DRAWS);
+}
+
+NETHER_BENCHMARK("command_stream/record", record_benchmark);
+NETHER_BENCHMARK("command_stream/iterate", iterate_benchmark);
+NETHER_BENCHMARK("command_stream/validate", validate_benchmark);
+} // namespace
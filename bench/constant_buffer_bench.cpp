@@ -0,0 +1,175 @@
+#include "benchmark.hpp"
+
+#include "instancing.hpp"
+
+// Patterns for writing per frame data into upload buffers. On the GPU the destination is write combined memory, where
+// partial and out of order writes are the expensive part, here it is regular memory, so these measure the CPU side
+// cost of each pattern (and the bytes moved), not the PCIe transfer.
+namespace
+{
+using namespace nether;
+
+// Same layout as scene_buffer_t in main.cpp (which uses an XMMATRIX, so can not be used on every platform).
+struct alignas(256) scene_constants_t
+{
+    float4x4_t view_projection_matrix{};
+
+    u32 light_buffer_index{};
+    u32 light_cluster_buffer_index{};
+    u32 light_index_buffer_index{};
+    u32 num_lights{};
+
+    u32 num_clusters[3]{};
+    f32 near_plane{};
+
+    f32 cluster_size_in_pixels[2]{};
+    f32 depth_slice_scale{};
+    f32 depth_slice_bias{};
+};
+
+constexpr u32 NUM_OBJECTS = 4096u;
+
+// D3D12 requires constant buffer views to be 256 byte aligned, so a constant buffer per object pads every object.
+struct alignas(256) object_constants_t
+{
+    instance_data_t instance_data{};
+};
+
+scene_constants_t create_scene_constants(const u32 frame_index)
+{
+    return scene_constants_t{
+        .view_projection_matrix = translation_matrix({static_cast<f32>(frame_index), 0.0f, 0.0f}),
+        .light_buffer_index = 1u,
+        .light_cluster_buffer_index = 2u,
+        .light_index_buffer_index = 3u,
+        .num_lights = frame_index,
+        .num_clusters = {16u, 9u, 24u},
+        .near_plane = 0.1f,
+        .cluster_size_in_pixels = {80.0f, 80.0f},
+        .depth_slice_scale = 1.5f,
+        .depth_slice_bias = -2.0f,
+    };
+}
+
+// What the frame loop does : fill a CPU side copy, then copy the whole struct into the upload buffer.
+void scene_constants_memcpy_benchmark(bench::benchmark_state_t &state)
+{
+    std::vector<scene_constants_t> upload_buffer(1u);
+    scene_constants_t *const destination = upload_buffer.data();
+
+    u32 frame_index = 0u;
+    while (state.keep_running())
+    {
+        const scene_constants_t scene_constants = create_scene_constants(frame_index++);
+        std::memcpy(destination, &scene_constants, sizeof(scene_constants_t));
+        bench::clobber_memory();
+    }
+
+    state.set_bytes_per_iteration(sizeof(scene_constants_t));
+}
+
+// Each field written directly into the upload buffer.
+void scene_constants_fields_benchmark(bench::benchmark_state_t &state)
+{
+    std::vector<scene_constants_t> upload_buffer(1u);
+    scene_constants_t *const destination = upload_buffer.data();
+
+    u32 frame_index = 0u;
+    while (state.keep_running())
+    {
+        destination->view_projection_matrix = translation_matrix({static_cast<f32>(frame_index), 0.0f, 0.0f});
+        destination->light_buffer_index = 1u;
+        destination->light_cluster_buffer_index = 2u;
+        destination->light_index_buffer_index = 3u;
+        destination->num_lights = frame_index++;
+        destination->num_clusters[0] = 16u;
+        destination->num_clusters[1] = 9u;
+        destination->num_clusters[2] = 24u;
+        destination->near_plane = 0.1f;
+        destination->cluster_size_in_pixels[0] = 80.0f;
+        destination->cluster_size_in_pixels[1] = 80.0f;
+        destination->depth_slice_scale = 1.5f;
+        destination->depth_slice_bias = -2.0f;
+        bench::clobber_memory();
+    }
+
+    state.set_bytes_per_iteration(sizeof(scene_constants_t));
+}
+
+std::vector<instance_data_t> create_instance_data()
+{
+    std::vector<instance_data_t> instance_data(NUM_OBJECTS);
+    for (u32 i = 0u; i < NUM_OBJECTS; i++)
+    {
+        instance_data[i] = {
+            .model_matrix = translation_matrix({static_cast<f32>(i), 0.0f, 0.0f}),
+            .color = {1.0f, 0.5f, 0.25f, 1.0f},
+        };
+    }
+
+    return instance_data;
+}
+
+// Packed per instance data, copied with a single memcpy (what the instance batcher's output allows).
+void instance_data_bulk_memcpy_benchmark(bench::benchmark_state_t &state)
+{
+    const std::vector<instance_data_t> instance_data = create_instance_data();
+
+    std::vector<instance_data_t> upload_buffer(NUM_OBJECTS);
+
+    while (state.keep_running())
+    {
+        std::memcpy(upload_buffer.data(), instance_data.data(), NUM_OBJECTS * sizeof(instance_data_t));
+        bench::clobber_memory();
+    }
+
+    state.set_items_per_iteration(NUM_OBJECTS);
+    state.set_bytes_per_iteration(NUM_OBJECTS * sizeof(instance_data_t));
+}
+
+// Packed per instance data, one memcpy per instance.
+void instance_data_per_instance_memcpy_benchmark(bench::benchmark_state_t &state)
+{
+    const std::vector<instance_data_t> instance_data = create_instance_data();
+
+    std::vector<instance_data_t> upload_buffer(NUM_OBJECTS);
+
+    while (state.keep_running())
+    {
+        for (u32 i = 0u; i < NUM_OBJECTS; i++)
+        {
+            std::memcpy(&upload_buffer[i], &instance_data[i], sizeof(instance_data_t));
+        }
+        bench::clobber_memory();
+    }
+
+    state.set_items_per_iteration(NUM_OBJECTS);
+    state.set_bytes_per_iteration(NUM_OBJECTS * sizeof(instance_data_t));
+}
+
+// One constant buffer per object : 3.2x the memory of the packed layout for instance_data_t.
+void per_object_constant_buffers_benchmark(bench::benchmark_state_t &state)
+{
+    const std::vector<instance_data_t> instance_data = create_instance_data();
+
+    std::vector<object_constants_t> upload_buffer(NUM_OBJECTS);
+
+    while (state.keep_running())
+    {
+        for (u32 i = 0u; i < NUM_OBJECTS; i++)
+        {
+            std::memcpy(&upload_buffer[i].instance_data, &instance_data[i], sizeof(instance_data_t));
+        }
+        bench::clobber_memory();
+    }
+
+    state.set_items_per_iteration(NUM_OBJECTS);
+    state.set_bytes_per_iteration(NUM_OBJECTS * sizeof(instance_data_t));
+}
+
+NETHER_BENCHMARK("constant_buffer/scene/memcpy", scene_constants_memcpy_benchmark);
+NETHER_BENCHMARK("constant_buffer/scene/fields", scene_constants_fields_benchmark);
+NETHER_BENCHMARK("constant_buffer/instances/bulk_memcpy", instance_data_bulk_memcpy_benchmark);
+NETHER_BENCHMARK("constant_buffer/instances/per_instance_memcpy", instance_data_per_instance_memcpy_benchmark);
+NETHER_BENCHMARK("constant_buffer/instances/per_object_256_aligned", per_object_constant_buffers_benchmark);
+} // namespace
@@ -0,0 +1,108 @@
+#include "benchmark.hpp"
+
+#include "debug_draw.hpp"
+
+// CPU cost of a frame of debug drawing : 1M line segments drawn one by one (from a single thread, and spread over the
+// job system's threads as when every system draws its own debug lines), and then merged into the upload buffer, as
+// written by the frame loop. The buffers have grown to the frame's size in the warm-up frame, so drawing does not
+// allocate.
+namespace
+{
+using namespace nether;
+
+constexpr u32 NUM_LINES = 1u << 20u;
+
+void draw_lines(debug_draw_t &debug_draw, const u32 begin, const u32 end)
+{
+    for (u32 i = begin; i < end; i++)
+    {
+        const f32 x = static_cast<f32>(i);
+        debug_draw.draw_line({x, 0.0f, 0.0f}, {x, 1.0f, 0.0f}, make_debug_color(0u, 255u, 0u),
+                             i % 8u == 0u ? debug_draw_mode_t::on_top : debug_draw_mode_t::depth_tested);
+    }
+}
+
+void draw_single_thread_benchmark(bench::benchmark_state_t &state)
+{
+    debug_draw_t debug_draw{};
+    std::vector<debug_line_t> lines(NUM_LINES);
+
+    draw_lines(debug_draw, 0u, NUM_LINES);
+    debug_draw.write_lines(lines);
+
+    while (state.keep_running())
+    {
+        draw_lines(debug_draw, 0u, NUM_LINES);
+
+        state.pause_timing();
+        debug_draw.clear();
+        state.resume_timing();
+    }
+
+    state.set_items_per_iteration(NUM_LINES);
+}
+
+void draw_parallel_benchmark(bench::benchmark_state_t &state)
+{
+    job_system_t &job_system = bench::get_job_system();
+
+    debug_draw_t debug_draw{};
+    std::vector<debug_line_t> lines(NUM_LINES);
+
+    const auto draw = [&]() {
+        job_system.parallel_for(NUM_LINES, 4096u, [&](const u32 begin, const u32 end, const u32) {
+            draw_lines(debug_draw, begin, end);
+        });
+    };
+
+    // Lines are not spread evenly over the threads, so the warm-up frames grow every thread's buffers.
+    for (u32 i = 0u; i < 4u; i++)
+    {
+        draw();
+        debug_draw.write_lines(lines);
+    }
+
+    while (state.keep_running())
+    {
+        draw();
+
+        state.pause_timing();
+        debug_draw.clear();
+        state.resume_timing();
+    }
+
+    state.set_items_per_iteration(NUM_LINES);
+}
+
+template <bool Parallel> void write_lines_benchmark(bench::benchmark_state_t &state)
+{
+    job_system_t &job_system = bench::get_job_system();
+
+    debug_draw_t debug_draw{};
+    std::vector<debug_line_t> lines(NUM_LINES);
+
+    const auto draw = [&]() {
+        job_system.parallel_for(NUM_LINES, 4096u, [&](const u32 begin, const u32 end, const u32) {
+            draw_lines(debug_draw, begin, end);
+        });
+    };
+
+    while (state.keep_running())
+    {
+        state.pause_timing();
+        draw();
+        state.resume_timing();
+
+        bench::do_not_optimize(debug_draw.write_lines(lines, Parallel ? &job_system : nullptr));
+        bench::clobber_memory();
+    }
+
+    state.set_items_per_iteration(NUM_LINES);
+    state.set_bytes_per_iteration(NUM_LINES * sizeof(debug_line_t));
+}
+
+NETHER_BENCHMARK("debug_draw/draw_1m_lines/single_thread", draw_single_thread_benchmark);
+NETHER_BENCHMARK("debug_draw/draw_1m_lines/parallel", draw_parallel_benchmark);
+NETHER_BENCHMARK("debug_draw/write_1m_lines/single_thread", (write_lines_benchmark<false>));
+NETHER_BENCHMARK("debug_draw/write_1m_lines/parallel", (write_lines_benchmark<true>));
+} // namespace
@@ -0,0 +1,91 @@
+#include "benchmark.hpp"
+
+// Descriptor allocation needs a D3D12 device, so is only measured on Windows.
+#ifdef _WIN32
+#include "descriptor_heap.hpp"
+
+namespace
+{
+using namespace nether;
+
+constexpr u32 NUM_DESCRIPTORS = 1u << 16u;
+
+// The device of the default adapter, shared by the benchmarks.
+ID3D12Device *get_device()
+{
+    static ComPtr<ID3D12Device> device = []() {
+        ComPtr<ID3D12Device> device{};
+        throw_if_failed(D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_12_0, IID_PPV_ARGS(&device)));
+
+        return device;
+    }();
+
+    return device.Get();
+}
+
+void allocate_descriptor_benchmark(bench::benchmark_state_t &state)
+{
+    descriptor_heap_t descriptor_heap(get_device(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, NUM_DESCRIPTORS,
+                                      L"Benchmark descriptor heap");
+    const descriptor_handle_t heap_start = descriptor_heap.current_descriptor_handle;
+
+    while (state.keep_running())
+    {
+        // The heap has no free, so it is rewound once full.
+        if (descriptor_heap.current_descriptor_handle.index == NUM_DESCRIPTORS)
+        {
+            descriptor_heap.current_descriptor_handle = heap_start;
+        }
+
+        const descriptor_handle_t descriptor_handle = descriptor_heap.get_then_offset_current_descriptor_handle();
+        bench::do_not_optimize(descriptor_handle);
+    }
+}
+
+void get_descriptor_at_index_benchmark(bench::benchmark_state_t &state)
+{
+    const descriptor_heap_t descriptor_heap(get_device(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, NUM_DESCRIPTORS,
+                                            L"Benchmark descriptor heap");
+
+    u32 index = 0u;
+    while (state.keep_running())
+    {
+        const descriptor_handle_t descriptor_handle = descriptor_heap.get_descriptor_at_index(index);
+        bench::do_not_optimize(descriptor_handle);
+
+        index = (index + 1u) % NUM_DESCRIPTORS;
+    }
+}
+
+// Allocation followed by the creation of a (null) shader resource view, which is what creating a bindless resource
+// costs on the CPU.
+void allocate_and_create_view_benchmark(bench::benchmark_state_t &state)
+{
+    descriptor_heap_t descriptor_heap(get_device(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, NUM_DESCRIPTORS,
+                                      L"Benchmark descriptor heap");
+    const descriptor_handle_t heap_start = descriptor_heap.current_descriptor_handle;
+
+    const D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {
+        .Format = DXGI_FORMAT_R8G8B8A8_UNORM,
+        .ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D,
+        .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
+        .Texture2D = {.MipLevels = 1u},
+    };
+
+    while (state.keep_running())
+    {
+        if (descriptor_heap.current_descriptor_handle.index == NUM_DESCRIPTORS)
+        {
+            descriptor_heap.current_descriptor_handle = heap_start;
+        }
+
+        const descriptor_handle_t descriptor_handle = descriptor_heap.get_then_offset_current_descriptor_handle();
+        get_device()->CreateShaderResourceView(nullptr, &srv_desc, descriptor_handle.cpu_handle);
+    }
+}
+
+NETHER_BENCHMARK("descriptor_heap/allocate", allocate_descriptor_benchmark);
+NETHER_BENCHMARK("descriptor_heap/get_descriptor_at_index", get_descriptor_at_index_benchmark);
+NETHER_BENCHMARK("descriptor_heap/allocate_and_create_view", allocate_and_create_view_benchmark);
+} // namespace
+#endif
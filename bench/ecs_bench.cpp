@@ -0,0 +1,136 @@
+#include "benchmark.hpp"
+
+#include "ecs.hpp"
+
+namespace
+{
+using namespace nether;
+
+struct position_t
+{
+    f32 x{};
+    f32 y{};
+    f32 z{};
+};
+
+struct velocity_t
+{
+    f32 x{};
+    f32 y{};
+    f32 z{};
+};
+
+struct tag_t
+{
+};
+
+constexpr u32 NUM_ENTITIES = 100000u;
+
+// Half of the entities have a tag, so the query spans two archetypes.
+void create_entities(ecs::world_t &world)
+{
+    for (u32 i = 0u; i < NUM_ENTITIES; i++)
+    {
+        const ecs::entity_t entity =
+            world.create_entity(position_t{static_cast<f32>(i), 0.0f, 0.0f}, velocity_t{1.0f, 2.0f, 3.0f});
+        if (i % 2u == 0u)
+        {
+            world.add_component(entity, tag_t{});
+        }
+    }
+}
+
+void create_entities_benchmark(bench::benchmark_state_t &state)
+{
+    while (state.keep_running())
+    {
+        ecs::world_t world{};
+        for (u32 i = 0u; i < NUM_ENTITIES; i++)
+        {
+            world.create_entity(position_t{static_cast<f32>(i), 0.0f, 0.0f}, velocity_t{1.0f, 2.0f, 3.0f});
+        }
+        bench::do_not_optimize(world);
+    }
+
+    state.set_items_per_iteration(NUM_ENTITIES);
+}
+
+void for_each_benchmark(bench::benchmark_state_t &state)
+{
+    ecs::world_t world{};
+    create_entities(world);
+
+    ecs::query_t query = world.create_query<position_t, velocity_t>();
+
+    while (state.keep_running())
+    {
+        world.for_each<position_t, velocity_t>(
+            query, [](const ecs::entity_t, position_t &position, const velocity_t &velocity) {
+                position.x += velocity.x;
+                position.y += velocity.y;
+                position.z += velocity.z;
+            });
+        bench::clobber_memory();
+    }
+
+    state.set_items_per_iteration(NUM_ENTITIES);
+}
+
+void parallel_for_each_chunk_benchmark(bench::benchmark_state_t &state)
+{
+    ecs::world_t world{};
+    create_entities(world);
+
+    ecs::query_t query = world.create_query<position_t, velocity_t>();
+
+    while (state.keep_running())
+    {
+        world.parallel_for_each_chunk<position_t, velocity_t>(
+            bench::get_job_system(), query,
+            [](const u32, const u32 count, const ecs::entity_t *const, position_t *const positions,
+               velocity_t *const velocities) {
+                for (u32 i = 0u; i < count; i++)
+                {
+                    positions[i].x += velocities[i].x;
+                    positions[i].y += velocities[i].y;
+                    positions[i].z += velocities[i].z;
+                }
+            });
+        bench::clobber_memory();
+    }
+
+    state.set_items_per_iteration(NUM_ENTITIES);
+}
+
+// Moves every entity to another archetype and back.
+void add_remove_component_benchmark(bench::benchmark_state_t &state)
+{
+    ecs::world_t world{};
+
+    std::vector<ecs::entity_t> entities(NUM_ENTITIES);
+    for (ecs::entity_t &entity : entities)
+    {
+        entity = world.create_entity(position_t{}, velocity_t{});
+    }
+
+    while (state.keep_running())
+    {
+        for (const ecs::entity_t entity : entities)
+        {
+            world.add_component(entity, tag_t{});
+        }
+
+        for (const ecs::entity_t entity : entities)
+        {
+            world.remove_component<tag_t>(entity);
+        }
+    }
+
+    state.set_items_per_iteration(2u * NUM_ENTITIES);
+}
+
+NETHER_BENCHMARK("ecs/create_entities", create_entities_benchmark);
+NETHER_BENCHMARK("ecs/for_each", for_each_benchmark);
+NETHER_BENCHMARK("ecs/parallel_for_each_chunk", parallel_for_each_chunk_benchmark);
+NETHER_BENCHMARK("ecs/add_remove_component", add_remove_component_benchmark);
+} // namespace
@@ -0,0 +1,63 @@
+#include "benchmark.hpp"
+
+#include "frame_statistics.hpp"
+
+namespace
+{
+using namespace nether;
+
+void record_benchmark(bench::benchmark_state_t &state)
+{
+    duration_histogram_t histogram{};
+
+    u32 value_in_us = 1u;
+    while (state.keep_running())
+    {
+        histogram.record(value_in_us);
+        value_in_us = value_in_us * 1664525u + 1013904223u;
+    }
+
+    bench::do_not_optimize(histogram);
+}
+
+void summarize_benchmark(bench::benchmark_state_t &state)
+{
+    std::mt19937 random_engine(1u);
+    std::lognormal_distribution<f64> distribution(9.5, 0.5);
+
+    duration_histogram_t histogram{};
+    for (u32 i = 0u; i < 100000u; i++)
+    {
+        histogram.record(static_cast<u32>(distribution(random_engine)));
+    }
+
+    while (state.keep_running())
+    {
+        const duration_summary_t summary = summarize(histogram);
+        bench::do_not_optimize(summary);
+    }
+}
+
+// The cost the frame loop pays per frame, with the same number of phases.
+void end_frame_benchmark(bench::benchmark_state_t &state)
+{
+    static constexpr std::array<std::string_view, 7> phase_names = {
+        "update", "lighting", "culling", "recording", "translation", "submission", "present",
+    };
+
+    frame_statistics_t frame_statistics(phase_names, {.window_time_in_s = 1.0e9f});
+
+    while (state.keep_running())
+    {
+        for (u32 i = 0u; i < static_cast<u32>(phase_names.size()); i++)
+        {
+            frame_statistics.end_phase(i);
+        }
+        frame_statistics.end_frame();
+    }
+}
+
+NETHER_BENCHMARK("frame_statistics/record", record_benchmark);
+NETHER_BENCHMARK("frame_statistics/summarize", summarize_benchmark);
+NETHER_BENCHMARK("frame_statistics/end_frame", end_frame_benchmark);
+} // namespace
@@ -0,0 +1,106 @@
+#include "benchmark.hpp"
+
+#include "image_based_lighting.hpp"
+
+// Throughput of the image based lighting precomputation on a synthetic sky : the conversion of a 1024x512 panorama to
+// 256x256 faces (reported in cubemap texels), the irradiance projection of those faces (in texels), the specular
+// prefilter of 128x128 faces into 6 mips of 128 samples (in samples), and a 128x128 BRDF LUT of 256 samples (in
+// samples). The prefilter is run single threaded and across the job system's threads.
+namespace
+{
+using namespace nether;
+
+constexpr u32 CUBEMAP_SIZE = 256u;
+
+const specular_prefilter_settings_t PREFILTER_SETTINGS = {.size = 128u, .num_mips = 6u, .num_samples = 128u};
+
+constexpr u32 BRDF_LUT_SIZE = 128u;
+constexpr u32 BRDF_LUT_NUM_SAMPLES = 256u;
+
+// A bright sun in a sky over a dark ground.
+hdr_image_t create_panorama()
+{
+    hdr_image_t panorama{.width = 1024u, .height = 512u};
+    for (u32 y = 0u; y < panorama.height; y++)
+    {
+        for (u32 x = 0u; x < panorama.width; x++)
+        {
+            const f32 sky = std::max(1.0f - 2.0f * static_cast<f32>(y) / static_cast<f32>(panorama.height), 0.0f);
+            const bool is_sun = x / 16u == 20u && y / 16u == 8u;
+            panorama.texels.push_back(is_sun ? float3_t{5000.0f, 4500.0f, 4000.0f}
+                                             : float3_t{0.1f + 0.4f * sky, 0.1f + 0.6f * sky, 0.1f + sky});
+        }
+    }
+
+    return panorama;
+}
+
+const cubemap_t &get_environment()
+{
+    static const cubemap_t environment = [] {
+        cubemap_t cubemap = equirectangular_to_cubemap(create_panorama(), CUBEMAP_SIZE, &bench::get_job_system());
+        generate_cubemap_mips(cubemap, &bench::get_job_system());
+        return cubemap;
+    }();
+
+    return environment;
+}
+
+void equirectangular_to_cubemap_benchmark(bench::benchmark_state_t &state)
+{
+    const hdr_image_t panorama = create_panorama();
+    while (state.keep_running())
+    {
+        bench::do_not_optimize(equirectangular_to_cubemap(panorama, CUBEMAP_SIZE, &bench::get_job_system()));
+    }
+
+    state.set_items_per_iteration(static_cast<u64>(cubemap_t::NUM_FACES) * CUBEMAP_SIZE * CUBEMAP_SIZE);
+}
+
+void irradiance_sh9_benchmark(bench::benchmark_state_t &state)
+{
+    const cubemap_t &environment = get_environment();
+    while (state.keep_running())
+    {
+        bench::do_not_optimize(compute_irradiance_sh9(environment, &bench::get_job_system()));
+    }
+
+    state.set_items_per_iteration(static_cast<u64>(cubemap_t::NUM_FACES) * CUBEMAP_SIZE * CUBEMAP_SIZE);
+}
+
+template <bool Parallel> void prefilter_specular_benchmark(bench::benchmark_state_t &state)
+{
+    job_system_t *const job_system = Parallel ? &bench::get_job_system() : nullptr;
+    const cubemap_t &environment = get_environment();
+    while (state.keep_running())
+    {
+        bench::do_not_optimize(prefilter_specular(environment, PREFILTER_SETTINGS, job_system));
+    }
+
+    // Every texel of the mips past the first.
+    u64 num_texels = 0u;
+    for (u32 mip = 1u; mip < PREFILTER_SETTINGS.num_mips; mip++)
+    {
+        num_texels += static_cast<u64>(cubemap_t::NUM_FACES) * (PREFILTER_SETTINGS.size >> mip) *
+                      (PREFILTER_SETTINGS.size >> mip);
+    }
+
+    state.set_items_per_iteration(num_texels * PREFILTER_SETTINGS.num_samples);
+}
+
+void brdf_lut_benchmark(bench::benchmark_state_t &state)
+{
+    while (state.keep_running())
+    {
+        bench::do_not_optimize(compute_brdf_lut(BRDF_LUT_SIZE, BRDF_LUT_NUM_SAMPLES, &bench::get_job_system()));
+    }
+
+    state.set_items_per_iteration(static_cast<u64>(BRDF_LUT_SIZE) * BRDF_LUT_SIZE * BRDF_LUT_NUM_SAMPLES);
+}
+
+NETHER_BENCHMARK("image_based_lighting/equirectangular_to_cubemap", equirectangular_to_cubemap_benchmark);
+NETHER_BENCHMARK("image_based_lighting/irradiance_sh9", irradiance_sh9_benchmark);
+NETHER_BENCHMARK("image_based_lighting/prefilter_specular/single_thread", (prefilter_specular_benchmark<false>));
+NETHER_BENCHMARK("image_based_lighting/prefilter_specular/parallel", (prefilter_specular_benchmark<true>));
+NETHER_BENCHMARK("image_based_lighting/brdf_lut", brdf_lut_benchmark);
+} // namespace
@@ -0,0 +1,42 @@
+#include "benchmark.hpp"
+
+#include "instancing.hpp"
+
+namespace
+{
+using namespace nether;
+
+constexpr u32 NUM_DRAW_PACKETS = 100000u;
+
+// Draw packets over 50 meshes and 2 pipelines, in random order.
+void build_benchmark(bench::benchmark_state_t &state)
+{
+    std::mt19937 random_engine(1u);
+
+    std::vector<draw_packet_t> draw_packets(NUM_DRAW_PACKETS);
+    for (draw_packet_t &draw_packet : draw_packets)
+    {
+        draw_packet.mesh_index = random_engine() % 50u;
+        draw_packet.pipeline_index = random_engine() % 2u;
+    }
+
+    instance_batcher_t instance_batcher{};
+    std::vector<instance_data_t> instance_data(NUM_DRAW_PACKETS);
+
+    while (state.keep_running())
+    {
+        instance_batcher.reset();
+        for (const draw_packet_t &draw_packet : draw_packets)
+        {
+            instance_batcher.add_draw_packet(draw_packet);
+        }
+
+        const std::span<const instanced_draw_t> draws = instance_batcher.build(instance_data);
+        bench::do_not_optimize(draws.data());
+    }
+
+    state.set_items_per_iteration(NUM_DRAW_PACKETS);
+}
+
+NETHER_BENCHMARK("instancing/build", build_benchmark);
+} // namespace
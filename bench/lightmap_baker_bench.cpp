@@ -0,0 +1,84 @@
+#include "benchmark.hpp"
+
+#include "lightmap_baker.hpp"
+
+// Throughput of the lightmap baker on the demo scene's static geometry (the floor, with a cube above it and the main
+// light) : a render pass of 16 samples per texel with 2 bounces, single threaded and across the job system's threads
+// (reported in rays), and the resolve of the converged samples (reported in atlas texels).
+namespace
+{
+using namespace nether;
+
+constexpr std::array<float3_t, 8> CUBE_POSITIONS = {
+    float3_t{-1.0f, -1.0f, -1.0f}, float3_t{-1.0f, 1.0f, -1.0f}, float3_t{1.0f, 1.0f, -1.0f},
+    float3_t{1.0f, -1.0f, -1.0f},  float3_t{-1.0f, -1.0f, 1.0f}, float3_t{-1.0f, 1.0f, 1.0f},
+    float3_t{1.0f, 1.0f, 1.0f},    float3_t{1.0f, -1.0f, 1.0f},
+};
+
+constexpr std::array<u32, 36> CUBE_INDICES = {
+    0u, 1u, 2u, 0u, 2u, 3u, 4u, 6u, 5u, 4u, 7u, 6u, 4u, 5u, 1u, 4u, 1u, 0u,
+    3u, 2u, 6u, 3u, 6u, 7u, 1u, 5u, 6u, 1u, 6u, 2u, 4u, 0u, 3u, 4u, 3u, 7u,
+};
+
+const std::array<lightmap_mesh_t, 2> MESHES = {
+    lightmap_mesh_t{
+        .positions = CUBE_POSITIONS,
+        .indices = CUBE_INDICES,
+        .model_matrix = scaling_matrix({40.0f, 0.2f, 40.0f}) * translation_matrix({0.0f, -3.0f, 20.0f}),
+    },
+    lightmap_mesh_t{
+        .positions = CUBE_POSITIONS,
+        .indices = CUBE_INDICES,
+        .model_matrix = translation_matrix({0.0f, 0.0f, 5.0f}),
+    },
+};
+
+const std::array<light_t, 1> LIGHTS = {
+    light_t{.position = {0.0f, 7.0f, 10.0f}, .range = 30.0f, .color = {40.0f, 40.0f, 40.0f}},
+};
+
+// ~53k texels.
+const lightmap_bake_settings_t SETTINGS = {
+    .texels_per_unit = 2.0f,
+    .atlas_width = 512u,
+    .max_samples = ~0u,
+    .target_relative_error = 0.0f,
+};
+
+template <bool Parallel> void render_pass_benchmark(bench::benchmark_state_t &state)
+{
+    job_system_t *const job_system = Parallel ? &bench::get_job_system() : nullptr;
+    lightmap_baker_t baker(MESHES, LIGHTS, SETTINGS, job_system);
+
+    u64 num_rays = 0u;
+    u64 num_passes = 0u;
+    while (state.keep_running())
+    {
+        const u64 first_num_rays = baker.statistics.num_rays;
+        bench::do_not_optimize(baker.render_pass(job_system));
+
+        num_rays += baker.statistics.num_rays - first_num_rays;
+        num_passes++;
+    }
+
+    state.set_items_per_iteration(num_rays / std::max(num_passes, u64{1u}));
+}
+
+void resolve_benchmark(bench::benchmark_state_t &state)
+{
+    job_system_t &job_system = bench::get_job_system();
+    lightmap_baker_t baker(MESHES, LIGHTS, SETTINGS, &job_system);
+    baker.render_pass(&job_system);
+
+    while (state.keep_running())
+    {
+        bench::do_not_optimize(baker.resolve(&job_system));
+    }
+
+    state.set_items_per_iteration(static_cast<u64>(baker.get_atlas().width) * baker.get_atlas().height);
+}
+
+NETHER_BENCHMARK("lightmap_baker/render_pass/single_thread", (render_pass_benchmark<false>));
+NETHER_BENCHMARK("lightmap_baker/render_pass/parallel", (render_pass_benchmark<true>));
+NETHER_BENCHMARK("lightmap_baker/resolve", resolve_benchmark);
+} // namespace
@@ -0,0 +1,131 @@
+#include "benchmark.hpp"
+
+#include "memory.hpp"
+
+// The per frame allocation pattern the frame arenas replace : many small allocations of mixed sizes, all freed at the
+// end of the frame.
+namespace
+{
+using namespace nether;
+
+constexpr u32 NUM_ALLOCATIONS = 10000u;
+
+std::vector<size_t> create_allocation_sizes()
+{
+    std::mt19937 random_engine(1u);
+    std::uniform_int_distribution<size_t> size_distribution(16u, 256u);
+
+    std::vector<size_t> sizes(NUM_ALLOCATIONS);
+    for (size_t &size : sizes)
+    {
+        size = size_distribution(random_engine);
+    }
+
+    return sizes;
+}
+
+void malloc_benchmark(bench::benchmark_state_t &state)
+{
+    const std::vector<size_t> sizes = create_allocation_sizes();
+    std::vector<void *> allocations(NUM_ALLOCATIONS);
+
+    while (state.keep_running())
+    {
+        for (u32 i = 0u; i < NUM_ALLOCATIONS; i++)
+        {
+            allocations[i] = std::malloc(sizes[i]);
+            bench::do_not_optimize(allocations[i]);
+        }
+
+        for (void *const allocation : allocations)
+        {
+            std::free(allocation);
+        }
+    }
+
+    state.set_items_per_iteration(NUM_ALLOCATIONS);
+}
+
+void linear_arena_benchmark(bench::benchmark_state_t &state)
+{
+    const std::vector<size_t> sizes = create_allocation_sizes();
+    memory::linear_arena_t arena(8u * 1024u * 1024u);
+
+    while (state.keep_running())
+    {
+        for (u32 i = 0u; i < NUM_ALLOCATIONS; i++)
+        {
+            void *const allocation = arena.allocate(sizes[i]);
+            bench::do_not_optimize(allocation);
+        }
+
+        arena.reset();
+    }
+
+    state.set_items_per_iteration(NUM_ALLOCATIONS);
+}
+
+void pool_allocator_benchmark(bench::benchmark_state_t &state)
+{
+    memory::pool_allocator_t pool(256u, 16u, 1024u);
+    std::vector<void *> allocations(NUM_ALLOCATIONS);
+
+    while (state.keep_running())
+    {
+        for (void *&allocation : allocations)
+        {
+            allocation = pool.allocate();
+            bench::do_not_optimize(allocation);
+        }
+
+        for (void *const allocation : allocations)
+        {
+            pool.deallocate(allocation);
+        }
+    }
+
+    state.set_items_per_iteration(NUM_ALLOCATIONS);
+}
+
+void std_vector_growth_benchmark(bench::benchmark_state_t &state)
+{
+    while (state.keep_running())
+    {
+        std::vector<u32> values{};
+        for (u32 i = 0u; i < NUM_ALLOCATIONS; i++)
+        {
+            values.push_back(i);
+        }
+        bench::do_not_optimize(values.data());
+    }
+
+    state.set_items_per_iteration(NUM_ALLOCATIONS);
+}
+
+void pmr_vector_growth_benchmark(bench::benchmark_state_t &state)
+{
+    memory::linear_arena_t arena(8u * 1024u * 1024u);
+
+    while (state.keep_running())
+    {
+        {
+            std::pmr::vector<u32> values(&arena);
+            for (u32 i = 0u; i < NUM_ALLOCATIONS; i++)
+            {
+                values.push_back(i);
+            }
+            bench::do_not_optimize(values.data());
+        }
+
+        arena.reset();
+    }
+
+    state.set_items_per_iteration(NUM_ALLOCATIONS);
+}
+
+NETHER_BENCHMARK("memory/malloc_free", malloc_benchmark);
+NETHER_BENCHMARK("memory/linear_arena", linear_arena_benchmark);
+NETHER_BENCHMARK("memory/pool_allocator", pool_allocator_benchmark);
+NETHER_BENCHMARK("memory/std_vector_growth", std_vector_growth_benchmark);
+NETHER_BENCHMARK("memory/pmr_vector_growth_in_arena", pmr_vector_growth_benchmark);
+} // namespace
@@ -0,0 +1,131 @@
+#include "benchmark.hpp"
+
+#include "occlusion_culling.hpp"
+
+// A camera at the origin looking down +z, with 200 box occluders in front of 100k small boxes.
+namespace
+{
+using namespace nether;
+
+constexpr u32 NUM_OCCLUDERS = 200u;
+constexpr u32 NUM_OCCLUDEES = 100000u;
+
+constexpr std::array<float3_t, 8> BOX_POSITIONS = {
+    float3_t{-1.0f, -1.0f, -1.0f}, {-1.0f, 1.0f, -1.0f}, {1.0f, 1.0f, -1.0f}, {1.0f, -1.0f, -1.0f},
+    {-1.0f, -1.0f, 1.0f},          {-1.0f, 1.0f, 1.0f},  {1.0f, 1.0f, 1.0f},  {1.0f, -1.0f, 1.0f},
+};
+
+constexpr std::array<u16, 36> BOX_INDICES = {0u, 1u, 2u, 0u, 2u, 3u, 4u, 6u, 5u, 4u, 7u, 6u, 4u, 5u, 1u, 4u, 1u, 0u,
+                                             3u, 2u, 6u, 3u, 6u, 7u, 1u, 5u, 6u, 1u, 6u, 2u, 4u, 0u, 3u, 4u, 3u, 7u};
+
+struct occlusion_scene_t
+{
+    float4x4_t view_projection_matrix{};
+    std::vector<float4x4_t> occluder_model_matrices{};
+    std::vector<aabb_t> occludee_bounds{};
+};
+
+occlusion_scene_t create_occlusion_scene()
+{
+    std::mt19937 random_engine(1u);
+    std::uniform_real_distribution<f32> distribution(-50.0f, 50.0f);
+    std::uniform_real_distribution<f32> depth_distribution(5.0f, 200.0f);
+
+    occlusion_scene_t scene = {
+        .view_projection_matrix = perspective_reverse_z_matrix(to_radians(45.0f), 16.0f / 9.0f, 0.1f),
+    };
+
+    for (u32 i = 0u; i < NUM_OCCLUDERS; i++)
+    {
+        scene.occluder_model_matrices.push_back(
+            scaling_matrix({3.0f, 3.0f, 3.0f}) *
+            translation_matrix({distribution(random_engine) * 0.5f, distribution(random_engine) * 0.2f,
+                                depth_distribution(random_engine) * 0.3f + 5.0f}));
+    }
+
+    for (u32 i = 0u; i < NUM_OCCLUDEES; i++)
+    {
+        const float3_t center = {distribution(random_engine), distribution(random_engine) * 0.5f,
+                                 depth_distribution(random_engine)};
+        scene.occludee_bounds.push_back({center - float3_t{0.5f, 0.5f, 0.5f}, center + float3_t{0.5f, 0.5f, 0.5f}});
+    }
+
+    return scene;
+}
+
+void rasterize_occluders(occlusion_culler_t &occlusion_culler, const occlusion_scene_t &scene,
+                         job_system_t *const job_system)
+{
+    occlusion_culler.begin_frame(scene.view_projection_matrix);
+    for (const float4x4_t &model_matrix : scene.occluder_model_matrices)
+    {
+        occlusion_culler.add_occluder(BOX_POSITIONS, BOX_INDICES, model_matrix);
+    }
+    occlusion_culler.rasterize(job_system);
+}
+
+void rasterize_benchmark(bench::benchmark_state_t &state)
+{
+    const occlusion_scene_t scene = create_occlusion_scene();
+    occlusion_culler_t occlusion_culler(384u, 216u);
+
+    while (state.keep_running())
+    {
+        rasterize_occluders(occlusion_culler, scene, nullptr);
+    }
+
+    state.set_items_per_iteration(NUM_OCCLUDERS);
+}
+
+void parallel_rasterize_benchmark(bench::benchmark_state_t &state)
+{
+    const occlusion_scene_t scene = create_occlusion_scene();
+    occlusion_culler_t occlusion_culler(384u, 216u);
+
+    while (state.keep_running())
+    {
+        rasterize_occluders(occlusion_culler, scene, &bench::get_job_system());
+    }
+
+    state.set_items_per_iteration(NUM_OCCLUDERS);
+}
+
+void test_occludees_benchmark(bench::benchmark_state_t &state)
+{
+    const occlusion_scene_t scene = create_occlusion_scene();
+    occlusion_culler_t occlusion_culler(384u, 216u);
+    rasterize_occluders(occlusion_culler, scene, nullptr);
+
+    std::vector<u8> visibility(NUM_OCCLUDEES);
+
+    while (state.keep_running())
+    {
+        occlusion_culler.test_occludees(scene.occludee_bounds, visibility);
+        bench::do_not_optimize(visibility.data());
+    }
+
+    state.set_items_per_iteration(NUM_OCCLUDEES);
+}
+
+void parallel_test_occludees_benchmark(bench::benchmark_state_t &state)
+{
+    const occlusion_scene_t scene = create_occlusion_scene();
+    occlusion_culler_t occlusion_culler(384u, 216u);
+    rasterize_occluders(occlusion_culler, scene, nullptr);
+
+    std::vector<u8> visibility(NUM_OCCLUDEES);
+
+    while (state.keep_running())
+    {
+        occlusion_culler.test_occludees(scene.occludee_bounds, visibility, &bench::get_job_system());
+        bench::do_not_optimize(visibility.data());
+    }
+
+    state.set_items_per_iteration(NUM_OCCLUDEES);
+}
+
+NETHER_BENCHMARK("occlusion_culling/rasterize", rasterize_benchmark);
+NETHER_BENCHMARK("occlusion_culling/parallel_rasterize", parallel_rasterize_benchmark);
+NETHER_BENCHMARK("occlusion_culling/test_occludees", test_occludees_benchmark);
+NETHER_BENCHMARK("occlusion_culling/parallel_test_occludees", parallel_test_occludees_benchmark);
+} // namespace
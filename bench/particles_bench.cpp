@@ -0,0 +1,223 @@
+#include "benchmark.hpp"
+
+#include "particles.hpp"
+
+// A frame of a steady state particle system (as many particles die as are emitted), compared with a scalar AoS
+// baseline that does the same work one particle at a time. Particles are reported as items, so 1 M items/s is 1000
+// particles updated per millisecond.
+namespace
+{
+using namespace nether;
+
+constexpr u32 NUM_EMITTERS = 8u;
+constexpr f32 DELTA_TIME = 1.0f / 60.0f;
+
+const std::array<force_field_t, 4> FORCE_FIELDS = {
+    force_field_t{.type = force_field_type_t::directional, .vector = {0.0f, -1.0f, 0.0f}, .strength = 9.81f},
+    force_field_t{.type = force_field_type_t::point, .vector = {0.0f, 4.0f, 0.0f}, .strength = 30.0f, .radius = 6.0f},
+    force_field_t{.type = force_field_type_t::point, .vector = {3.0f, 2.0f, 3.0f}, .strength = -10.0f, .radius = 2.0f},
+    force_field_t{.type = force_field_type_t::drag, .strength = 0.2f},
+};
+
+// Lifetimes average 2 seconds, so each emitter settles at about 2 * emission_rate particles.
+particle_emitter_desc_t create_emitter_desc(const u32 num_particles, const u32 emitter_index)
+{
+    const u32 num_particles_per_emitter = num_particles / NUM_EMITTERS;
+
+    return particle_emitter_desc_t{
+        .position = {static_cast<f32>(emitter_index), 0.0f, 0.0f},
+        .spread_angle_in_radians = 0.5f,
+        .emission_radius = 0.2f,
+        .min_speed = 4.0f,
+        .max_speed = 8.0f,
+        .min_lifetime_in_s = 1.0f,
+        .max_lifetime_in_s = 3.0f,
+        .emission_rate = static_cast<f32>(num_particles_per_emitter) / 2.0f,
+        .max_particles = num_particles_per_emitter * 2u,
+        .seed = emitter_index,
+    };
+}
+
+particle_system_t create_particle_system(const u32 num_particles)
+{
+    particle_system_t particle_system{};
+    for (u32 i = 0u; i < NUM_EMITTERS; i++)
+    {
+        particle_system.add_emitter(create_emitter_desc(num_particles, i));
+    }
+    particle_system.force_fields.assign(FORCE_FIELDS.begin(), FORCE_FIELDS.end());
+
+    // Past the longest lifetime, to reach the steady state.
+    for (u32 frame = 0u; frame < 200u; frame++)
+    {
+        particle_system.update(DELTA_TIME);
+    }
+
+    return particle_system;
+}
+
+// The baseline : an array of particle structs per emitter, every force field evaluated for every particle, and dead
+// particles swap removed with the vector's back.
+struct aos_particle_t
+{
+    float3_t position{};
+    float3_t velocity{};
+    f32 age{};
+    f32 lifetime{};
+};
+
+struct aos_emitter_t
+{
+    particle_emitter_desc_t desc{};
+    std::vector<aos_particle_t> particles{};
+
+    std::mt19937 random_engine{};
+    f32 emission_accumulator{};
+};
+
+void update_aos_emitter(aos_emitter_t &emitter, const std::span<const force_field_t> force_fields,
+                        const f32 delta_time)
+{
+    std::vector<aos_particle_t> &particles = emitter.particles;
+    for (aos_particle_t &particle : particles)
+    {
+        float3_t acceleration{};
+        for (const force_field_t &field : force_fields)
+        {
+            switch (field.type)
+            {
+            case force_field_type_t::directional: {
+                acceleration = acceleration + field.vector * field.strength;
+            }
+            break;
+
+            case force_field_type_t::point: {
+                const float3_t offset = field.vector - particle.position;
+                const f32 distance = length(offset);
+                const f32 falloff = std::max(1.0f - distance / field.radius, 0.0f);
+                acceleration = acceleration + offset * (field.strength * falloff / std::max(distance, 1e-6f));
+            }
+            break;
+
+            case force_field_type_t::drag: {
+                acceleration = acceleration - particle.velocity * field.strength;
+            }
+            break;
+            }
+        }
+
+        particle.velocity = particle.velocity + acceleration * delta_time;
+        particle.position = particle.position + particle.velocity * delta_time;
+        particle.age += delta_time;
+    }
+
+    for (size_t i = 0u; i < particles.size();)
+    {
+        if (particles[i].age >= particles[i].lifetime)
+        {
+            particles[i] = particles.back();
+            particles.pop_back();
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    const particle_emitter_desc_t &desc = emitter.desc;
+
+    emitter.emission_accumulator += desc.emission_rate * delta_time;
+    const u32 num_requested_particles = static_cast<u32>(emitter.emission_accumulator);
+    emitter.emission_accumulator -= static_cast<f32>(num_requested_particles);
+
+    std::uniform_real_distribution<f32> unit_distribution(0.0f, 1.0f);
+    std::uniform_real_distribution<f32> speed_distribution(desc.min_speed, desc.max_speed);
+    std::uniform_real_distribution<f32> lifetime_distribution(desc.min_lifetime_in_s, desc.max_lifetime_in_s);
+
+    const u32 num_emitted_particles =
+        std::min(num_requested_particles, desc.max_particles - static_cast<u32>(particles.size()));
+    for (u32 i = 0u; i < num_emitted_particles; i++)
+    {
+        const f32 spread = desc.spread_angle_in_radians;
+        const f32 offset_x = spread * (2.0f * unit_distribution(emitter.random_engine) - 1.0f);
+        const f32 offset_z = spread * (2.0f * unit_distribution(emitter.random_engine) - 1.0f);
+        const float3_t direction = normalize(float3_t{offset_x, 1.0f, offset_z});
+
+        particles.push_back(aos_particle_t{
+            .position = desc.position,
+            .velocity = direction * speed_distribution(emitter.random_engine),
+            .lifetime = lifetime_distribution(emitter.random_engine),
+        });
+    }
+}
+
+template <u32 NumParticles> void update_scalar_aos_benchmark(bench::benchmark_state_t &state)
+{
+    std::vector<aos_emitter_t> emitters(NUM_EMITTERS);
+    for (u32 i = 0u; i < NUM_EMITTERS; i++)
+    {
+        emitters[i].desc = create_emitter_desc(NumParticles, i);
+        emitters[i].particles.reserve(emitters[i].desc.max_particles);
+        emitters[i].random_engine.seed(i);
+    }
+
+    for (u32 frame = 0u; frame < 200u; frame++)
+    {
+        for (aos_emitter_t &emitter : emitters)
+        {
+            update_aos_emitter(emitter, FORCE_FIELDS, DELTA_TIME);
+        }
+    }
+
+    size_t num_particles = 0u;
+    while (state.keep_running())
+    {
+        num_particles = 0u;
+        for (aos_emitter_t &emitter : emitters)
+        {
+            num_particles += emitter.particles.size();
+            update_aos_emitter(emitter, FORCE_FIELDS, DELTA_TIME);
+            bench::do_not_optimize(emitter.particles.data());
+        }
+    }
+
+    state.set_items_per_iteration(num_particles);
+}
+
+template <u32 NumParticles, bool Parallel> void update_benchmark(bench::benchmark_state_t &state)
+{
+    particle_system_t particle_system = create_particle_system(NumParticles);
+
+    u32 num_particles = 0u;
+    while (state.keep_running())
+    {
+        num_particles = particle_system.get_num_particles();
+        particle_system.update(DELTA_TIME, Parallel ? &bench::get_job_system() : nullptr);
+        bench::do_not_optimize(particle_system.emitters.data());
+    }
+
+    state.set_items_per_iteration(num_particles);
+}
+
+template <u32 NumParticles, bool Parallel> void write_vertices_benchmark(bench::benchmark_state_t &state)
+{
+    particle_system_t particle_system = create_particle_system(NumParticles);
+    std::vector<particle_vertex_t> vertices(particle_system.get_max_particles());
+
+    u32 num_particles = 0u;
+    while (state.keep_running())
+    {
+        num_particles = particle_system.write_vertices(vertices, Parallel ? &bench::get_job_system() : nullptr);
+        bench::do_not_optimize(vertices.data());
+    }
+
+    state.set_items_per_iteration(num_particles);
+    state.set_bytes_per_iteration(num_particles * sizeof(particle_vertex_t));
+}
+
+NETHER_BENCHMARK("particles/update_scalar_aos/262144", (update_scalar_aos_benchmark<262144u>));
+NETHER_BENCHMARK("particles/update/262144", (update_benchmark<262144u, false>));
+NETHER_BENCHMARK("particles/parallel_update/262144", (update_benchmark<262144u, true>));
+NETHER_BENCHMARK("particles/write_vertices/262144", (write_vertices_benchmark<262144u, false>));
+NETHER_BENCHMARK("particles/parallel_write_vertices/262144", (write_vertices_benchmark<262144u, true>));
+} // namespace
@@ -0,0 +1,44 @@
+#include "benchmark.hpp"
+
+#include "residency_policy.hpp"
+
+namespace
+{
+using namespace nether;
+
+constexpr u32 NUM_RESOURCES = 4000u;
+constexpr u32 NUM_USES_PER_FRAME = 400u;
+constexpr u64 RESOURCE_SIZE = 1024u * 1024u;
+
+// A streaming camera : a window of resources slides over the resources, with a budget of 600 of the 4000 resources,
+// so every frame uses a few resources that are not resident, and evicts the oldest ones.
+void sliding_window_benchmark(bench::benchmark_state_t &state)
+{
+    residency_policy_t residency_policy{};
+
+    std::vector<u32> handles(NUM_RESOURCES);
+    for (u32 &handle : handles)
+    {
+        handle = residency_policy.register_resource(RESOURCE_SIZE, 0u);
+    }
+
+    u64 frame_index = 1u;
+    while (state.keep_running())
+    {
+        const u32 window_start = static_cast<u32>(frame_index % (NUM_RESOURCES - NUM_USES_PER_FRAME));
+        for (u32 i = 0u; i < NUM_USES_PER_FRAME; i++)
+        {
+            residency_policy.mark_used(handles[window_start + i], frame_index);
+        }
+
+        const residency_changes_t &changes = residency_policy.update(frame_index, 600u * RESOURCE_SIZE);
+        bench::do_not_optimize(changes.evicted_resources.data());
+
+        frame_index++;
+    }
+
+    state.set_items_per_iteration(NUM_USES_PER_FRAME);
+}
+
+NETHER_BENCHMARK("residency_policy/sliding_window", sliding_window_benchmark);
+} // namespace
@@ -0,0 +1,107 @@
+#include "benchmark.hpp"
+
+#include "shader_archive.hpp"
+
+// Loading every shader from loose files (one read per shader) against mapping a single shader archive.
+namespace
+{
+using namespace nether;
+
+constexpr u32 NUM_SHADERS = 2000u;
+
+struct shader_files_t
+{
+    std::filesystem::path directory{};
+    std::vector<u64> keys{};
+};
+
+// Written once (to the temporary directory), and shared by the benchmarks.
+const shader_files_t &get_shader_files()
+{
+    static const shader_files_t shader_files = []() {
+        shader_files_t shader_files = {
+            .directory = std::filesystem::temp_directory_path() / "nether-bench" / "shaders",
+        };
+        std::filesystem::create_directories(shader_files.directory);
+
+        std::mt19937 random_engine(1u);
+        shader_archive_writer_t shader_archive_writer{};
+
+        for (u32 i = 0u; i < NUM_SHADERS; i++)
+        {
+            std::vector<u8> bytecode(2000u + random_engine() % 6000u);
+            for (u8 &byte : bytecode)
+            {
+                byte = static_cast<u8>(random_engine());
+            }
+
+            const u64 key = get_shader_archive_key(L"shaders/shader.hlsl", L"ps_6_6", L"ps_main", i);
+            shader_files.keys.push_back(key);
+            shader_archive_writer.add(key, bytecode, {.permutation_mask = i});
+
+            std::ofstream file(shader_files.directory / std::format("{}.dxil", i), std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(bytecode.data()), bytecode.size());
+        }
+
+        shader_archive_writer.write(shader_files.directory / "shaders.nsa");
+
+        return shader_files;
+    }();
+
+    return shader_files;
+}
+
+void load_loose_files_benchmark(bench::benchmark_state_t &state)
+{
+    const shader_files_t &shader_files = get_shader_files();
+
+    while (state.keep_running())
+    {
+        for (u32 i = 0u; i < NUM_SHADERS; i++)
+        {
+            std::ifstream file(shader_files.directory / std::format("{}.dxil", i), std::ios::binary | std::ios::ate);
+
+            std::vector<u8> bytecode(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char *>(bytecode.data()), bytecode.size());
+            bench::do_not_optimize(bytecode.data());
+        }
+    }
+
+    state.set_items_per_iteration(NUM_SHADERS);
+}
+
+void load_archive_benchmark(bench::benchmark_state_t &state)
+{
+    const shader_files_t &shader_files = get_shader_files();
+
+    while (state.keep_running())
+    {
+        const shader_archive_t shader_archive(shader_files.directory / "shaders.nsa");
+        for (const u64 key : shader_files.keys)
+        {
+            const std::span<const u8> bytecode = shader_archive.get_bytecode(shader_archive.find(key));
+            bench::do_not_optimize(bytecode[0]);
+        }
+    }
+
+    state.set_items_per_iteration(NUM_SHADERS);
+}
+
+void find_benchmark(bench::benchmark_state_t &state)
+{
+    const shader_files_t &shader_files = get_shader_files();
+    const shader_archive_t shader_archive(shader_files.directory / "shaders.nsa");
+
+    u32 key_index = 0u;
+    while (state.keep_running())
+    {
+        const u32 entry_index = shader_archive.find(shader_files.keys[key_index++ % NUM_SHADERS]);
+        bench::do_not_optimize(entry_index);
+    }
+}
+
+NETHER_BENCHMARK("shader_archive/load_loose_files", load_loose_files_benchmark);
+NETHER_BENCHMARK("shader_archive/load_archive", load_archive_benchmark);
+NETHER_BENCHMARK("shader_archive/find", find_benchmark);
+} // namespace
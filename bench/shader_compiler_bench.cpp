@@ -0,0 +1,54 @@
+#include "benchmark.hpp"
+
+// DXC is only available on Windows.
+#ifdef _WIN32
+#include "shader_compiler.hpp"
+
+// Latency of a full shader compile and of a preprocess (which the shader permutation compiler uses to detect
+// permutations that expand to the same source). Must run from the repository root, as the shaders are loaded from
+// shaders/.
+namespace
+{
+using namespace nether;
+
+void compile_vertex_shader_benchmark(bench::benchmark_state_t &state)
+{
+    while (state.keep_running())
+    {
+        const ComPtr<IDxcBlob> blob =
+            shader_compiler::compile_shader(L"shaders/mesh_shader.hlsl", L"vs_6_6", L"vs_main");
+        if (!blob)
+        {
+            throw std::runtime_error("Failed to compile shaders/mesh_shader.hlsl");
+        }
+    }
+}
+
+void compile_pixel_shader_benchmark(bench::benchmark_state_t &state)
+{
+    while (state.keep_running())
+    {
+        const ComPtr<IDxcBlob> blob =
+            shader_compiler::compile_shader(L"shaders/mesh_shader.hlsl", L"ps_6_6", L"ps_main");
+        if (!blob)
+        {
+            throw std::runtime_error("Failed to compile shaders/mesh_shader.hlsl");
+        }
+    }
+}
+
+void preprocess_pixel_shader_benchmark(bench::benchmark_state_t &state)
+{
+    while (state.keep_running())
+    {
+        const ComPtr<IDxcBlobUtf8> blob =
+            shader_compiler::preprocess_shader(L"shaders/mesh_shader.hlsl", L"ps_6_6", L"ps_main");
+        bench::do_not_optimize(blob.Get());
+    }
+}
+
+NETHER_BENCHMARK("shader_compiler/compile_vertex_shader", compile_vertex_shader_benchmark);
+NETHER_BENCHMARK("shader_compiler/compile_pixel_shader", compile_pixel_shader_benchmark);
+NETHER_BENCHMARK("shader_compiler/preprocess_pixel_shader", preprocess_pixel_shader_benchmark);
+} // namespace
+#endif
@@ -0,0 +1,42 @@
+#include "benchmark.hpp"
+
+#include "task_graph.hpp"
+
+// The overhead of the task graph itself : the tasks do no work.
+namespace
+{
+using namespace nether;
+
+constexpr u32 NUM_TASKS = 64u;
+
+// A chain of layers of 8 tasks, where each task depends on two tasks of the previous layer.
+template <bool Parallel> void execute_benchmark(bench::benchmark_state_t &state)
+{
+    while (state.keep_running())
+    {
+        state.pause_timing();
+
+        task_graph_t task_graph{};
+        for (u32 i = 0u; i < NUM_TASKS; i++)
+        {
+            if (i < 8u)
+            {
+                task_graph.add_task("task", {}, []() {});
+            }
+            else
+            {
+                task_graph.add_task("task", {i - 8u, (i - 8u) ^ 1u}, []() {});
+            }
+        }
+
+        state.resume_timing();
+
+        task_graph.execute(Parallel ? &bench::get_job_system() : nullptr);
+    }
+
+    state.set_items_per_iteration(NUM_TASKS);
+}
+
+NETHER_BENCHMARK("task_graph/execute", execute_benchmark<false>);
+NETHER_BENCHMARK("task_graph/parallel_execute", execute_benchmark<true>);
+} // namespace
@@ -0,0 +1,137 @@
+#include "benchmark.hpp"
+
+#include "terrain.hpp"
+
+// Quadtree selection and tile streaming over a 16k^2 heightmap (tiles of 64 quads, 9 depths, 87381 nodes). The archive
+// is generated the first time a benchmark needs it (about 700 MB in the temporary directory), and deleted at exit.
+// Streaming reads the archive through the OS file cache once it has been read, so stream/16k measures the read path
+// (system calls, copies and cache bookkeeping) rather than the disk.
+namespace
+{
+using namespace nether;
+
+constexpr u32 HEIGHTMAP_SIZE = 16385u;
+
+class test_archive_t
+{
+  public:
+    test_archive_t()
+    {
+        path = std::filesystem::temp_directory_path() / "nether-bench" / "terrain_16k.bin";
+        std::filesystem::create_directories(path.parent_path());
+
+        // A few octaves of ridges, cheap enough to generate a quarter of a billion samples.
+        std::vector<u16> heights(static_cast<size_t>(HEIGHTMAP_SIZE) * HEIGHTMAP_SIZE);
+        bench::get_job_system().parallel_for(HEIGHTMAP_SIZE, 64u, [&](const u32 begin, const u32 end, const u32) {
+            for (u32 z = begin; z < end; z++)
+            {
+                for (u32 x = 0u; x < HEIGHTMAP_SIZE; x++)
+                {
+                    f32 height = 0.5f;
+                    f32 amplitude = 0.25f;
+                    f32 frequency = 0.002f;
+                    for (u32 octave = 0u; octave < 5u; octave++)
+                    {
+                        height += amplitude * std::sin(frequency * x + octave) * std::cos(frequency * 1.3f * z);
+                        amplitude *= 0.5f;
+                        frequency *= 2.1f;
+                    }
+
+                    heights[static_cast<size_t>(z) * HEIGHTMAP_SIZE + x] =
+                        static_cast<u16>(std::clamp(height, 0.0f, 1.0f) * 65535.0f);
+                }
+            }
+        });
+
+        write_terrain_archive(path, heights, HEIGHTMAP_SIZE,
+                              terrain_archive_desc_t{.tile_resolution = 64u, .height_scale = 1024.0f},
+                              &bench::get_job_system());
+    }
+
+    ~test_archive_t()
+    {
+        std::error_code error_code{};
+        std::filesystem::remove(path, error_code);
+    }
+
+    std::filesystem::path path{};
+};
+
+const std::filesystem::path &get_archive_path()
+{
+    static const test_archive_t test_archive{};
+    return test_archive.path;
+}
+
+// A 1080p camera flying low over the middle of the terrain, looking towards the horizon.
+terrain_view_t get_view()
+{
+    const float3_t camera_position = {8192.0f, 700.0f, 4096.0f};
+    const float4x4_t projection_matrix = perspective_reverse_z_matrix(to_radians(60.0f), 16.0f / 9.0f, 0.1f);
+    const float4x4_t view_matrix = look_to_matrix(camera_position, {0.2f, -0.3f, 1.0f}, {0.0f, 1.0f, 0.0f});
+
+    return terrain_view_t{
+        .camera_position = camera_position,
+        .frustum = get_frustum(view_matrix * projection_matrix),
+        .screen_space_error_scale = get_screen_space_error_scale(projection_matrix, 1080.0f),
+    };
+}
+
+// Selection with every tile the view needs already resident.
+void select_benchmark(bench::benchmark_state_t &state)
+{
+    terrain_t terrain(get_archive_path(), terrain_settings_t{.cache_capacity_in_tiles = 4096u});
+
+    const terrain_view_t view = get_view();
+    for (u32 update = 0u; update < 100u; update++)
+    {
+        terrain.select_patches(view);
+        terrain.stream_tiles(&bench::get_job_system());
+    }
+
+    while (state.keep_running())
+    {
+        terrain.select_patches(view);
+        bench::do_not_optimize(terrain.patches.data());
+    }
+
+    state.set_items_per_iteration(terrain.statistics.num_visited_nodes);
+}
+
+// Streams every tile the view needs into an empty cache, with the selection itself not timed.
+template <bool Parallel> void stream_benchmark(bench::benchmark_state_t &state)
+{
+    const terrain_view_t view = get_view();
+
+    u64 num_loaded_bytes = 0u;
+    while (state.keep_running())
+    {
+        state.pause_timing();
+        terrain_t terrain(get_archive_path(), terrain_settings_t{.cache_capacity_in_tiles = 4096u});
+        num_loaded_bytes = 0u;
+
+        for (u32 update = 0u; update < 100u; update++)
+        {
+            terrain.select_patches(view);
+            if (terrain.statistics.num_requested_tiles == 0u)
+            {
+                break;
+            }
+
+            state.resume_timing();
+            terrain.stream_tiles(Parallel ? &bench::get_job_system() : nullptr);
+            state.pause_timing();
+
+            num_loaded_bytes += terrain.statistics.num_loaded_bytes;
+        }
+
+        state.resume_timing();
+    }
+
+    state.set_bytes_per_iteration(num_loaded_bytes);
+}
+
+NETHER_BENCHMARK("terrain/select/16k", select_benchmark);
+NETHER_BENCHMARK("terrain/stream/16k", (stream_benchmark<false>));
+NETHER_BENCHMARK("terrain/parallel_stream/16k", (stream_benchmark<true>));
+} // namespace
@@ -0,0 +1,40 @@
+#include "benchmark.hpp"
+
+#include "upload_planner.hpp"
+
+namespace
+{
+using namespace nether;
+
+// Thousands of small meshes, each with a position buffer, a color buffer and a 16 bit index buffer.
+template <u32 NumMeshes> void plan_uploads_benchmark(bench::benchmark_state_t &state)
+{
+    std::mt19937 random_engine(7u);
+
+    std::vector<upload_request_t> requests{};
+    u64 num_bytes = 0u;
+    for (u32 i = 0u; i < NumMeshes; i++)
+    {
+        const u64 num_vertices = 24u + random_engine() % 1000u;
+        const u64 num_indices = num_vertices * 3u / 2u * 3u;
+
+        requests.push_back({.size = num_vertices * 12u, .alignment = 12u});
+        requests.push_back({.size = num_vertices * 12u, .alignment = 12u});
+        requests.push_back({.size = num_indices * 2u, .alignment = 2u});
+
+        num_bytes += num_vertices * 24u + num_indices * 2u;
+    }
+
+    while (state.keep_running())
+    {
+        const upload_plan_t upload_plan = plan_uploads(requests, {});
+        bench::do_not_optimize(upload_plan.copies.data());
+    }
+
+    state.set_items_per_iteration(requests.size());
+    state.set_bytes_per_iteration(num_bytes);
+}
+
+NETHER_BENCHMARK("upload_planner/plan_uploads/1000_meshes", plan_uploads_benchmark<1000u>);
+NETHER_BENCHMARK("upload_planner/plan_uploads/10000_meshes", plan_uploads_benchmark<10000u>);
+} // namespace
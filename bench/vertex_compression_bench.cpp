@@ -0,0 +1,124 @@
+#include "benchmark.hpp"
+
+#include "vertex_compression.hpp"
+
+#include <random>
+
+// CPU encoding throughput of a mesh with every attribute (positions, normals, tangents, UVs and colors), and of the
+// index compression. Vertex benchmarks report vertices as items and the uncompressed attribute bytes as bytes.
+namespace
+{
+using namespace nether;
+
+constexpr u32 NUM_VERTICES = 1u << 20u;
+
+struct test_mesh_t
+{
+    std::vector<float3_t> positions{};
+    std::vector<float3_t> normals{};
+    std::vector<float4_t> tangents{};
+    std::vector<float2_t> uvs{};
+    std::vector<float3_t> colors{};
+
+    // A regular grid of triangles, so that neighbouring triangles share vertices like a real mesh's.
+    std::vector<u32> indices{};
+};
+
+const test_mesh_t &get_test_mesh()
+{
+    static const test_mesh_t test_mesh = []() {
+        test_mesh_t mesh{};
+
+        std::mt19937 generator(1u);
+        std::uniform_real_distribution<f32> distribution(-1.0f, 1.0f);
+        for (u32 i = 0u; i < NUM_VERTICES; i++)
+        {
+            const float3_t normal =
+                normalize({distribution(generator), distribution(generator), distribution(generator) + 0.01f});
+
+            mesh.positions.push_back(
+                {distribution(generator) * 100.0f, distribution(generator) * 20.0f, distribution(generator) * 100.0f});
+            mesh.normals.push_back(normal);
+            mesh.tangents.push_back({normal.y, -normal.x, 0.0f, distribution(generator)});
+            mesh.uvs.push_back({distribution(generator) * 0.5f + 0.5f, distribution(generator) * 0.5f + 0.5f});
+            mesh.colors.push_back(
+                {distribution(generator) * 0.5f + 0.5f, distribution(generator) * 0.5f + 0.5f, 1.0f});
+        }
+
+        constexpr u32 GRID_SIZE = 1024u;
+        for (u32 z = 0u; z + 1u < GRID_SIZE; z++)
+        {
+            for (u32 x = 0u; x + 1u < GRID_SIZE; x++)
+            {
+                const u32 index = z * GRID_SIZE + x;
+                mesh.indices.insert(mesh.indices.end(), {index, index + GRID_SIZE, index + 1u, index + 1u,
+                                                         index + GRID_SIZE, index + GRID_SIZE + 1u});
+            }
+        }
+
+        return mesh;
+    }();
+
+    return test_mesh;
+}
+
+template <bool Parallel> void compress_vertices_benchmark(bench::benchmark_state_t &state)
+{
+    const test_mesh_t &mesh = get_test_mesh();
+    const mesh_vertices_t vertices = {
+        .positions = mesh.positions,
+        .normals = mesh.normals,
+        .tangents = mesh.tangents,
+        .uvs = mesh.uvs,
+        .colors = mesh.colors,
+    };
+
+    u64 uncompressed_size_in_bytes = 0u;
+    while (state.keep_running())
+    {
+        const compressed_mesh_vertices_t compressed_vertices =
+            compress_mesh_vertices(vertices, Parallel ? &bench::get_job_system() : nullptr);
+        bench::do_not_optimize(compressed_vertices.positions.data());
+
+        uncompressed_size_in_bytes = compressed_vertices.statistics.get_uncompressed_size_in_bytes();
+    }
+
+    state.set_items_per_iteration(NUM_VERTICES);
+    state.set_bytes_per_iteration(uncompressed_size_in_bytes);
+}
+
+void compress_indices_benchmark(bench::benchmark_state_t &state)
+{
+    const test_mesh_t &mesh = get_test_mesh();
+
+    while (state.keep_running())
+    {
+        const std::vector<u8> data = compress_indices(mesh.indices);
+        bench::do_not_optimize(data.data());
+    }
+
+    state.set_items_per_iteration(mesh.indices.size());
+    state.set_bytes_per_iteration(mesh.indices.size() * sizeof(u32));
+}
+
+void decompress_indices_benchmark(bench::benchmark_state_t &state)
+{
+    const test_mesh_t &mesh = get_test_mesh();
+    const std::vector<u8> data = compress_indices(mesh.indices);
+
+    std::vector<u32> indices(mesh.indices.size());
+    while (state.keep_running())
+    {
+        decompress_indices(data, indices);
+        bench::do_not_optimize(indices.data());
+    }
+
+    state.set_items_per_iteration(indices.size());
+    state.set_bytes_per_iteration(indices.size() * sizeof(u32));
+}
+
+NETHER_BENCHMARK("vertex_compression/compress_vertices/1m", (compress_vertices_benchmark<false>));
+NETHER_BENCHMARK("vertex_compression/parallel_compress_vertices/1m", (compress_vertices_benchmark<true>));
+NETHER_BENCHMARK("vertex_compression/compress_indices/6m", compress_indices_benchmark);
+NETHER_BENCHMARK("vertex_compression/decompress_indices/6m", decompress_indices_benchmark);
+} // namespace
@@ -0,0 +1,261 @@
+#include "benchmark.hpp"
+
+#include "virtual_texture.hpp"
+
+#include <random>
+
+// Virtual texturing driven by synthetic feedback : the feedback of a 1080p frame rendered at 1/8 resolution (240 x 135
+// samples), looking at a ground plane covered by the virtual texture, so that close pixels request fine tiles and the
+// horizon requests coarse ones. Feedback processing, the page table and the page cache are measured on a 64k^2 texture
+// (tiles of 128 texels, 10 mips), and streaming on a 4k^2 archive (6 mips, about 100 MB in the temporary directory,
+// deleted at exit).
+namespace
+{
+using namespace nether;
+
+constexpr u32 FEEDBACK_WIDTH = 240u;
+constexpr u32 FEEDBACK_HEIGHT = 135u;
+
+// The feedback of a camera at (camera_x, camera_y) in tiles of the first mip, looking along y.
+std::vector<u32> create_feedback(const u32 num_mips, const f32 camera_x, const f32 camera_y)
+{
+    const f32 num_tiles_per_side = static_cast<f32>(1u << (num_mips - 1u));
+
+    std::vector<u32> feedback(FEEDBACK_WIDTH * FEEDBACK_HEIGHT, INVALID_VIRTUAL_TILE_ID);
+    for (u32 y = 0u; y < FEEDBACK_HEIGHT; y++)
+    {
+        // The top rows are the sky, and the distance grows towards the horizon.
+        const f32 screen_y = 1.0f - static_cast<f32>(y) / FEEDBACK_HEIGHT;
+        if (screen_y > 0.9f)
+        {
+            continue;
+        }
+
+        const f32 distance = 1.0f / (1.0f - screen_y);
+        const u32 mip = std::min(static_cast<u32>(std::max(std::log2(distance * 2.0f), 0.0f)), num_mips - 1u);
+
+        for (u32 x = 0u; x < FEEDBACK_WIDTH; x++)
+        {
+            const f32 screen_x = static_cast<f32>(x) / FEEDBACK_WIDTH - 0.5f;
+            const f32 tile_x = std::clamp(camera_x + screen_x * distance * 8.0f, 0.0f, num_tiles_per_side - 1.0f);
+            const f32 tile_y = std::clamp(camera_y + distance * 4.0f, 0.0f, num_tiles_per_side - 1.0f);
+
+            feedback[y * FEEDBACK_WIDTH + x] = pack_virtual_tile_id(
+                {.mip = mip, .x = static_cast<u32>(tile_x) >> mip, .y = static_cast<u32>(tile_y) >> mip});
+        }
+    }
+
+    return feedback;
+}
+
+class test_archive_t
+{
+  public:
+    test_archive_t()
+    {
+        path = std::filesystem::temp_directory_path() / "nether-bench" / "virtual_texture_4k.bin";
+        std::filesystem::create_directories(path.parent_path());
+
+        constexpr u32 SIZE = 4096u;
+        std::vector<u32> texels(SIZE * SIZE);
+        for (u32 y = 0u; y < SIZE; y++)
+        {
+            for (u32 x = 0u; x < SIZE; x++)
+            {
+                texels[y * SIZE + x] = (x & 0xffu) | ((y & 0xffu) << 8u) | (((x ^ y) & 0xffu) << 16u) | 0xff000000u;
+            }
+        }
+
+        write_virtual_texture_archive(path, texels, SIZE, {.tile_size = 128u, .tile_border = 4u},
+                                      &bench::get_job_system());
+    }
+
+    ~test_archive_t()
+    {
+        std::error_code error_code{};
+        std::filesystem::remove(path, error_code);
+    }
+
+    std::filesystem::path path{};
+};
+
+const std::filesystem::path &get_archive_path()
+{
+    static const test_archive_t test_archive{};
+    return test_archive.path;
+}
+
+void process_feedback_benchmark(bench::benchmark_state_t &state)
+{
+    constexpr u32 NUM_MIPS = 10u;
+    const std::vector<u32> feedback = create_feedback(NUM_MIPS, 256.0f, 100.0f);
+
+    virtual_texture_feedback_processor_t feedback_processor(NUM_MIPS);
+    while (state.keep_running())
+    {
+        feedback_processor.process(feedback);
+        bench::do_not_optimize(feedback_processor.requests.data());
+    }
+
+    state.set_items_per_iteration(feedback.size());
+}
+
+// Maps and unmaps random tiles of the first 3 mips, most of the work being the descendants' entries.
+void page_table_benchmark(bench::benchmark_state_t &state)
+{
+    constexpr u32 NUM_MIPS = 10u;
+    constexpr u32 NUM_OPERATIONS = 4096u;
+
+    std::mt19937 random_engine(1u);
+    std::vector<virtual_tile_t> tiles(NUM_OPERATIONS);
+    for (virtual_tile_t &tile : tiles)
+    {
+        tile.mip = random_engine() % 3u;
+        tile.x = random_engine() % (512u >> tile.mip);
+        tile.y = random_engine() % (512u >> tile.mip);
+    }
+
+    virtual_page_table_t page_table(NUM_MIPS, 0u);
+    while (state.keep_running())
+    {
+        for (u32 i = 0u; i < NUM_OPERATIONS; i++)
+        {
+            page_table.map(tiles[i], 1u + i);
+        }
+
+        for (u32 i = NUM_OPERATIONS; i-- > 0u;)
+        {
+            page_table.unmap(tiles[i]);
+        }
+
+        page_table.clear_dirty_regions();
+        bench::do_not_optimize(page_table.get_mip_entries(0u).data());
+    }
+
+    state.set_items_per_iteration(2u * NUM_OPERATIONS);
+}
+
+// The page cache of a camera moving over the texture : the pages of the requested tiles are touched, and missing tiles
+// recycle the least recently used pages.
+void page_cache_benchmark(bench::benchmark_state_t &state)
+{
+    constexpr u32 NUM_MIPS = 10u;
+    constexpr u32 NUM_PAGES = 4096u;
+
+    std::vector<std::vector<u32>> feedbacks{};
+    for (u32 frame = 0u; frame < 64u; frame++)
+    {
+        feedbacks.push_back(create_feedback(NUM_MIPS, 256.0f + frame * 2.0f, 100.0f + frame * 4.0f));
+    }
+
+    virtual_texture_feedback_processor_t feedback_processor(NUM_MIPS);
+    virtual_page_cache_t page_cache(NUM_PAGES);
+    std::vector<u32> tile_pages(get_num_virtual_tiles(NUM_MIPS), virtual_page_cache_t::INVALID_PAGE);
+
+    u64 update_index = 0u;
+    u64 num_requests = 0u;
+    while (state.keep_running())
+    {
+        num_requests = 0u;
+        for (const std::vector<u32> &feedback : feedbacks)
+        {
+            state.pause_timing();
+            const std::vector<virtual_tile_request_t> &requests = feedback_processor.process(feedback);
+            state.resume_timing();
+
+            update_index++;
+            for (const virtual_tile_request_t &request : requests)
+            {
+                u32 &page = tile_pages[request.tile_index];
+                if (page != virtual_page_cache_t::INVALID_PAGE)
+                {
+                    page_cache.touch(page, update_index);
+                    continue;
+                }
+
+                page = page_cache.acquire(update_index, 3u);
+                if (page == virtual_page_cache_t::INVALID_PAGE)
+                {
+                    continue;
+                }
+
+                const u32 evicted_tile_index = page_cache.get_page_tile(page);
+                if (evicted_tile_index != virtual_page_cache_t::INVALID_TILE_INDEX)
+                {
+                    tile_pages[evicted_tile_index] = virtual_page_cache_t::INVALID_PAGE;
+                }
+
+                page_cache.release(page, request.tile_index, update_index);
+            }
+
+            num_requests += requests.size();
+        }
+    }
+
+    state.set_items_per_iteration(num_requests);
+}
+
+// A full update with every requested tile already resident : feedback processing, and touching the pages.
+void update_benchmark(bench::benchmark_state_t &state)
+{
+    virtual_texture_t virtual_texture(get_archive_path(), {.num_pages = 1024u, .max_tile_loads_per_update = 1024u});
+    const std::vector<u32> feedback = create_feedback(virtual_texture.get_header().num_mips, 16.0f, 2.0f);
+
+    for (u32 update = 0u; update < 10u; update++)
+    {
+        virtual_texture.update(feedback);
+    }
+
+    while (state.keep_running())
+    {
+        virtual_texture.update(feedback);
+    }
+
+    state.set_items_per_iteration(feedback.size());
+}
+
+// Streams every tile of a sequence of views into an empty cache, with the loads on the job system when Parallel.
+template <bool Parallel> void stream_benchmark(bench::benchmark_state_t &state)
+{
+    const u32 num_mips = read_virtual_texture_archive_header(get_archive_path()).num_mips;
+
+    std::vector<std::vector<u32>> feedbacks{};
+    for (u32 frame = 0u; frame < 8u; frame++)
+    {
+        feedbacks.push_back(create_feedback(num_mips, 4.0f + frame * 3.0f, 1.0f + frame));
+    }
+
+    u64 num_loaded_bytes = 0u;
+    while (state.keep_running())
+    {
+        state.pause_timing();
+        virtual_texture_t virtual_texture(get_archive_path(),
+                                          {.num_pages = 256u, .max_tile_loads_per_update = 64u});
+        num_loaded_bytes = 0u;
+        state.resume_timing();
+
+        for (const std::vector<u32> &feedback : feedbacks)
+        {
+            do
+            {
+                virtual_texture.update(feedback, Parallel ? &bench::get_job_system() : nullptr);
+                if (Parallel)
+                {
+                    bench::get_job_system().wait_for_idle();
+                }
+
+                num_loaded_bytes += virtual_texture.statistics.num_loaded_bytes;
+            } while (virtual_texture.statistics.num_missing_tiles > 0u);
+        }
+    }
+
+    state.set_bytes_per_iteration(num_loaded_bytes);
+}
+
+NETHER_BENCHMARK("virtual_texture/process_feedback/1080p", process_feedback_benchmark);
+NETHER_BENCHMARK("virtual_texture/page_table/64k", page_table_benchmark);
+NETHER_BENCHMARK("virtual_texture/page_cache/64k", page_cache_benchmark);
+NETHER_BENCHMARK("virtual_texture/update/4k", update_benchmark);
+NETHER_BENCHMARK("virtual_texture/stream/4k", (stream_benchmark<false>));
+NETHER_BENCHMARK("virtual_texture/parallel_stream/4k", (stream_benchmark<true>));
+} // namespace
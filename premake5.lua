@@ -14,6 +14,9 @@ workspace("nether-engine")
 configurations({ "Debug", "Release" })
 architecture("x86_64")
 
+-- The engine and the shader packer need D3D12 and DXC, so are only generated on Windows. The benchmarks and tests build
+-- on every platform.
+if os.istarget("windows") then
 include("imgui-premake/premake5.lua")
 
 project("nether-engine")
@@ -22,6 +25,9 @@ language("C++")
 cppdialect("C++20")
 targetdir("bin/%{cfg.buildcfg}")
 
+-- The occlusion culler's depth rasterizer requires AVX2.
+vectorextensions("AVX2")
+
 includedirs({ "imgui-premake" })
 
 files({ "src/**.hpp", "src/**.cpp" })
@@ -33,3 +39,269 @@ symbols("On")
 
 filter("configurations:Release")
 optimize("On")
+
+filter({})
+
+-- Offline tool that compiles every shader permutation listed in shaders/shader_manifest.txt into a single shader
+-- archive, which the engine memory maps at startup instead of compiling the shaders.
+project("nether-shader-packer")
+kind("ConsoleApp")
+language("C++")
+cppdialect("C++20")
+targetdir("bin/%{cfg.buildcfg}")
+
+includedirs({ "src" })
+
+files({
+	"tools/shader_packer.cpp",
+	"src/common.hpp",
+	"src/memory.hpp",
+	"src/memory.cpp",
+	"src/shader_archive.hpp",
+	"src/shader_archive.cpp",
+	"src/shader_compiler.hpp",
+	"src/shader_compiler.cpp",
+	"src/shader_permutations.hpp",
+	"src/shader_permutations.cpp",
+})
+links({ "dxcompiler.lib" })
+
+filter("configurations:Debug")
+defines({ "DEF_NETHER_DEBUG" })
+symbols("On")
+
+filter("configurations:Release")
+optimize("On")
+
+filter({})
+end
+
+-- Sources that build on every platform, shared by the benchmarks and the tests.
+local portable_engine_files = {
+	"src/common.hpp",
+	"src/math.hpp",
+	"src/scene.hpp",
+	"src/allocation_tracker.hpp",
+	"src/allocation_tracker.cpp",
+	"src/animation.hpp",
+	"src/animation.cpp",
+	"src/bvh.hpp",
+	"src/bvh.cpp",
+	"src/clustered_lighting.hpp",
+	"src/clustered_lighting.cpp",
+	"src/command_stream.hpp",
+	"src/command_stream.cpp",
+	"src/debug_draw.hpp",
+	"src/debug_draw.cpp",
+	"src/dds.hpp",
+	"src/dds.cpp",
+	"src/ecs.hpp",
+	"src/ecs.cpp",
+	"src/file_reader.hpp",
+	"src/file_reader.cpp",
+	"src/frame_statistics.hpp",
+	"src/frame_statistics.cpp",
+	"src/gpu_scene.hpp",
+	"src/gpu_scene.cpp",
+	"src/image_based_lighting.hpp",
+	"src/image_based_lighting.cpp",
+	"src/instancing.hpp",
+	"src/instancing.cpp",
+	"src/job_system.hpp",
+	"src/job_system.cpp",
+	"src/lightmap_baker.hpp",
+	"src/lightmap_baker.cpp",
+	"src/memory.hpp",
+	"src/memory.cpp",
+	"src/occlusion_culling.hpp",
+	"src/occlusion_culling.cpp",
+	"src/particles.hpp",
+	"src/particles.cpp",
+	"src/residency_policy.hpp",
+	"src/residency_policy.cpp",
+	"src/shader_archive.hpp",
+	"src/shader_archive.cpp",
+	"src/task_graph.hpp",
+	"src/task_graph.cpp",
+	"src/terrain.hpp",
+	"src/terrain.cpp",
+	"src/upload_planner.hpp",
+	"src/upload_planner.cpp",
+	"src/vertex_compression.hpp",
+	"src/vertex_compression.cpp",
+	"src/virtual_texture.hpp",
+	"src/virtual_texture.cpp",
+}
+
+-- Offline tool that splits a raw heightmap into a terrain archive (see src/terrain.hpp).
+project("nether-terrain-packer")
+kind("ConsoleApp")
+language("C++")
+cppdialect("C++20")
+targetdir("bin/%{cfg.buildcfg}")
+
+includedirs({ "src" })
+
+files({
+	"tools/terrain_packer.cpp",
+	"src/common.hpp",
+	"src/file_reader.hpp",
+	"src/file_reader.cpp",
+	"src/math.hpp",
+	"src/job_system.hpp",
+	"src/job_system.cpp",
+	"src/memory.hpp",
+	"src/memory.cpp",
+	"src/terrain.hpp",
+	"src/terrain.cpp",
+})
+
+filter("system:linux")
+links({ "pthread" })
+
+filter("configurations:Debug")
+defines({ "DEF_NETHER_DEBUG" })
+symbols("On")
+
+filter("configurations:Release")
+optimize("On")
+
+filter({})
+
+-- Offline tool that bakes the lightmap of the demo scene (see src/lightmap_baker.hpp).
+project("nether-lightmap-baker")
+kind("ConsoleApp")
+language("C++")
+cppdialect("C++20")
+targetdir("bin/%{cfg.buildcfg}")
+
+includedirs({ "src" })
+
+files({
+	"tools/lightmap_baker.cpp",
+	"src/common.hpp",
+	"src/math.hpp",
+	"src/bvh.hpp",
+	"src/bvh.cpp",
+	"src/clustered_lighting.hpp",
+	"src/dds.hpp",
+	"src/dds.cpp",
+	"src/file_reader.hpp",
+	"src/file_reader.cpp",
+	"src/job_system.hpp",
+	"src/job_system.cpp",
+	"src/lightmap_baker.hpp",
+	"src/lightmap_baker.cpp",
+	"src/memory.hpp",
+	"src/memory.cpp",
+	"src/vertex_compression.hpp",
+	"src/vertex_compression.cpp",
+})
+
+filter("system:linux")
+links({ "pthread" })
+
+filter("configurations:Debug")
+defines({ "DEF_NETHER_DEBUG" })
+symbols("On")
+
+filter("configurations:Release")
+optimize("On")
+
+filter({})
+
+-- Offline tool that precomputes the image based lighting of an HDR environment (see src/image_based_lighting.hpp).
+project("nether-ibl-baker")
+kind("ConsoleApp")
+language("C++")
+cppdialect("C++20")
+targetdir("bin/%{cfg.buildcfg}")
+
+includedirs({ "src" })
+
+files({
+	"tools/ibl_baker.cpp",
+	"src/common.hpp",
+	"src/math.hpp",
+	"src/dds.hpp",
+	"src/dds.cpp",
+	"src/file_reader.hpp",
+	"src/file_reader.cpp",
+	"src/image_based_lighting.hpp",
+	"src/image_based_lighting.cpp",
+	"src/job_system.hpp",
+	"src/job_system.cpp",
+	"src/vertex_compression.hpp",
+	"src/vertex_compression.cpp",
+})
+
+filter("system:linux")
+links({ "pthread" })
+
+filter("configurations:Debug")
+defines({ "DEF_NETHER_DEBUG" })
+symbols("On")
+
+filter("configurations:Release")
+optimize("On")
+
+filter({})
+
+-- Benchmarks of the engine's subsystems (see bench/benchmark.hpp, and nether-bench --help for the options). Must run
+-- from the repository root. The descriptor heap and shader compiler benchmarks are only built on Windows.
+project("nether-bench")
+kind("ConsoleApp")
+language("C++")
+cppdialect("C++20")
+targetdir("bin/%{cfg.buildcfg}")
+vectorextensions("AVX2")
+
+includedirs({ "src", "bench" })
+
+files(portable_engine_files)
+files({ "bench/**.hpp", "bench/**.cpp" })
+
+filter("system:windows")
+files({
+	"src/descriptor_heap.hpp",
+	"src/descriptor_heap.cpp",
+	"src/shader_compiler.hpp",
+	"src/shader_compiler.cpp",
+})
+links({ "d3d12.lib", "dxgi.lib", "dxcompiler.lib" })
+
+filter("system:linux")
+links({ "pthread" })
+
+filter("configurations:Debug")
+defines({ "DEF_NETHER_DEBUG" })
+symbols("On")
+
+filter("configurations:Release")
+optimize("On")
+
+filter({})
+
+-- Unit tests (see tests/test_framework.hpp). Takes an optional filter on the test names as its argument. The tests are
+-- linked with the allocation hooks, so that the tracking of operator new is tested.
+project("nether-tests")
+kind("ConsoleApp")
+language("C++")
+cppdialect("C++20")
+targetdir("bin/%{cfg.buildcfg}")
+vectorextensions("AVX2")
+
+includedirs({ "src", "bench", "tests" })
+
+files(portable_engine_files)
+files({ "tests/**.hpp", "tests/**.cpp", "bench/benchmark.hpp", "bench/benchmark.cpp", "src/allocation_hooks.cpp" })
+
+filter("system:linux")
+links({ "pthread" })
+
+filter("configurations:Debug")
+defines({ "DEF_NETHER_DEBUG" })
+symbols("On")
+
+filter("configurations:Release")
+optimize("On")
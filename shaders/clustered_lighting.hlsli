@@ -0,0 +1,59 @@
+#ifndef __CLUSTERED_LIGHTING_HLSLI__
+#define __CLUSTERED_LIGHTING_HLSLI__
+
+#include "common.hlsli"
+
+// Index of the cluster that contains the pixel. The depth is reverse z with an infinite far plane, so the view space
+// depth is near_plane / depth. Depth slices are exponentially distributed (see src/clustered_lighting.hpp).
+uint get_light_cluster_index(const float4 sv_position, const scene_buffer_t scene_buffer)
+{
+    const float view_depth = scene_buffer.near_plane / max(sv_position.z, 1e-7f);
+
+    const uint depth_slice = (uint)clamp(floor(log2(view_depth) * scene_buffer.depth_slice_scale +
+                                               scene_buffer.depth_slice_bias),
+                                         0.0f, (float)(scene_buffer.num_clusters.z - 1u));
+
+    const uint2 tile = min((uint2)(sv_position.xy / scene_buffer.cluster_size_in_pixels),
+                           scene_buffer.num_clusters.xy - 1u);
+
+    return (depth_slice * scene_buffer.num_clusters.y + tile.y) * scene_buffer.num_clusters.x + tile.x;
+}
+
+// Diffuse lighting from every light of the pixel's cluster.
+float3 compute_clustered_lighting(const float3 world_position, const float3 normal, const float4 sv_position,
+                                  const scene_buffer_t scene_buffer)
+{
+    StructuredBuffer<light_t> light_buffer = ResourceDescriptorHeap[scene_buffer.light_buffer_index];
+    StructuredBuffer<light_cluster_t> light_cluster_buffer =
+        ResourceDescriptorHeap[scene_buffer.light_cluster_buffer_index];
+    StructuredBuffer<uint> light_index_buffer = ResourceDescriptorHeap[scene_buffer.light_index_buffer_index];
+
+    const light_cluster_t cluster = light_cluster_buffer[get_light_cluster_index(sv_position, scene_buffer)];
+
+    float3 result = float3(0.0f, 0.0f, 0.0f);
+    for (uint i = 0u; i < cluster.count; i++)
+    {
+        const light_t light = light_buffer[light_index_buffer[cluster.offset + i]];
+
+        const float3 to_light = light.position - world_position;
+        const float distance = length(to_light);
+        const float3 light_direction = to_light / max(distance, 1e-5f);
+
+        // Smooth window falloff that reaches 0 at the light's range.
+        const float distance_ratio = distance / light.range;
+        const float window = saturate(1.0f - distance_ratio * distance_ratio);
+        float attenuation = window * window / max(distance * distance, 0.01f);
+
+        if (light.type == LIGHT_TYPE_SPOT)
+        {
+            attenuation *= smoothstep(light.spot_cos_outer_angle, light.spot_cos_inner_angle,
+                                      dot(-light_direction, light.direction));
+        }
+
+        result += light.color * attenuation * saturate(dot(normal, light_direction));
+    }
+
+    return result;
+}
+
+#endif
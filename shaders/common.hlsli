@@ -0,0 +1,113 @@
+#ifndef __COMMON_HLSLI__
+#define __COMMON_HLSLI__
+
+// Must match scene_buffer_t in src/main.cpp.
+struct scene_buffer_t
+{
+    float4x4 view_projection_matrix;
+
+    // Clustered lighting (see clustered_lighting.hlsli).
+    uint light_buffer_index;
+    uint light_cluster_buffer_index;
+    uint light_index_buffer_index;
+    uint num_lights;
+
+    uint3 num_clusters;
+    float near_plane;
+
+    float2 cluster_size_in_pixels;
+    float depth_slice_scale;
+    float depth_slice_bias;
+};
+
+// Per instance data written by the CPU instance batcher (see src/instancing.hpp).
+struct instance_data_t
+{
+    float4x4 model_matrix;
+    float4 color;
+};
+
+// Per object data of the GPU scene. Must match gpu_scene_object_t in src/gpu_scene.hpp.
+struct gpu_scene_object_t
+{
+    float4x4 model_matrix;
+    float4 color;
+};
+
+static const uint LIGHT_TYPE_POINT = 0u;
+static const uint LIGHT_TYPE_SPOT = 1u;
+
+// Must match light_t in src/clustered_lighting.hpp.
+struct light_t
+{
+    float3 position;
+    float range;
+
+    float3 color;
+    uint type;
+
+    float3 direction;
+    float spot_cos_outer_angle;
+    float spot_cos_inner_angle;
+
+    float3 padding;
+};
+
+// Must match light_cluster_t in src/clustered_lighting.hpp.
+struct light_cluster_t
+{
+    uint offset;
+    uint count;
+};
+
+// Decoding of the quantized vertex formats of src/vertex_compression.hpp.
+
+// A quantized_position_t (16 bit unorm x, y and z, relative to the mesh's bounds) read as a uint2.
+float3 decode_position(const uint2 encoded_position, const float3 position_offset, const float3 position_scale)
+{
+    const float3 quantized_position =
+        float3(encoded_position.x & 0xffffu, encoded_position.x >> 16u, encoded_position.y & 0xffffu);
+    return position_offset + quantized_position * position_scale;
+}
+
+float3 decode_octahedral(const float2 encoded_direction)
+{
+    float3 direction =
+        float3(encoded_direction.xy, 1.0f - abs(encoded_direction.x) - abs(encoded_direction.y));
+
+    const float fold = saturate(-direction.z);
+    direction.xy += select(direction.xy >= 0.0f, -fold, fold);
+
+    return normalize(direction);
+}
+
+// Octahedral encoding, 16 bit snorm x and y.
+float3 decode_normal(const uint encoded_normal)
+{
+    const float2 encoded_direction =
+        float2((int)(encoded_normal << 16u) >> 16, (int)encoded_normal >> 16) / 32767.0f;
+    return decode_octahedral(max(encoded_direction, -1.0f));
+}
+
+// Octahedral encoding with a 16 bit snorm x and a 15 bit snorm y, and the bitangent sign in the top bit (set if
+// negative).
+float4 decode_tangent(const uint encoded_tangent)
+{
+    const float2 encoded_direction =
+        float2((int)(encoded_tangent << 16u) >> 16, (int)(encoded_tangent << 1u) >> 17) / float2(32767.0f, 16383.0f);
+    return float4(decode_octahedral(max(encoded_direction, -1.0f)), (encoded_tangent >> 31u) ? -1.0f : 1.0f);
+}
+
+// Two 16 bit floats, u in the low bits.
+float2 decode_uv(const uint encoded_uv)
+{
+    return float2(f16tof32(encoded_uv & 0xffffu), f16tof32(encoded_uv >> 16u));
+}
+
+// 8 bit unorm RGBA, red in the lowest byte.
+float4 decode_color(const uint encoded_color)
+{
+    return float4((encoded_color >> uint4(0u, 8u, 16u, 24u)) & 0xffu) / 255.0f;
+}
+
+#endif
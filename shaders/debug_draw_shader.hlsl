@@ -0,0 +1,95 @@
+// Debug lines (see src/debug_draw.hpp), drawn as screen space quads of a constant width in pixels : one instance per
+// line, whose 4 corners are selected by SV_VertexID (through a 6 index quad index buffer). The line buffer is written
+// by the CPU every frame, and read directly from upload memory. The depth tested and the on top lines are two draws of
+// the same buffer (with and without depth testing), and as SV_InstanceID does not include the start instance, each
+// draw passes the index of its first line.
+
+#include "common.hlsli"
+
+struct render_resources_t
+{
+    uint line_buffer_index;
+    uint scene_buffer_index;
+    uint first_line_index;
+    float line_width_in_pixels;
+    float2 viewport_size;
+};
+
+// Must match debug_line_t in src/debug_draw.hpp.
+struct debug_line_t
+{
+    float3 start;
+    float3 end;
+
+    // RGBA8 unorm, red in the lowest byte.
+    uint color;
+};
+
+ConstantBuffer<render_resources_t> render_resources : register(b0);
+
+struct vs_out_t
+{
+    float4 position : SV_Position;
+    float4 color : COLOR;
+};
+
+// x selects the side of the line, and y its end.
+static const float2 QUAD_CORNERS[4] = {
+    float2(-1.0f, -1.0f),
+    float2(-1.0f, 1.0f),
+    float2(1.0f, 1.0f),
+    float2(1.0f, -1.0f),
+};
+
+vs_out_t vs_main(uint vertex_id : SV_VertexID, uint instance_id : SV_InstanceID)
+{
+    StructuredBuffer<debug_line_t> line_buffer = ResourceDescriptorHeap[render_resources.line_buffer_index];
+    ConstantBuffer<scene_buffer_t> scene_buffer = ResourceDescriptorHeap[render_resources.scene_buffer_index];
+
+    const debug_line_t debug_line = line_buffer[render_resources.first_line_index + instance_id];
+    const float2 corner = QUAD_CORNERS[vertex_id];
+
+    float4 start = mul(float4(debug_line.start, 1.0f), scene_buffer.view_projection_matrix);
+    float4 end = mul(float4(debug_line.end, 1.0f), scene_buffer.view_projection_matrix);
+
+    vs_out_t result;
+    result.color = decode_color(debug_line.color);
+
+    // The projection's w is the view space depth, so the line is cut where it crosses the near plane (the screen space
+    // expansion divides by w). Lines entirely behind it collapse to a point, which rasterizes nothing.
+    const float near_plane = scene_buffer.near_plane;
+    if (start.w < near_plane && end.w < near_plane)
+    {
+        result.position = float4(0.0f, 0.0f, 0.0f, 1.0f);
+        return result;
+    }
+
+    if (start.w < near_plane)
+    {
+        start = lerp(start, end, (near_plane - start.w) / (end.w - start.w));
+    }
+    else if (end.w < near_plane)
+    {
+        end = lerp(end, start, (near_plane - end.w) / (start.w - end.w));
+    }
+
+    // Offset both ends perpendicularly to the line in pixels, by half the line width on each side.
+    const float2 start_ndc = start.xy / start.w;
+    const float2 end_ndc = end.xy / end.w;
+
+    const float2 direction_in_pixels = (end_ndc - start_ndc) * render_resources.viewport_size;
+    const float2 normal_in_pixels = dot(direction_in_pixels, direction_in_pixels) > 0.0f
+                                        ? normalize(float2(-direction_in_pixels.y, direction_in_pixels.x))
+                                        : float2(1.0f, 0.0f);
+    const float2 offset_ndc = normal_in_pixels * render_resources.line_width_in_pixels / render_resources.viewport_size;
+
+    const float4 position = corner.y < 0.0f ? start : end;
+    result.position = float4((position.xy / position.w + corner.x * offset_ndc) * position.w, position.zw);
+
+    return result;
+}
+
+float4 ps_main(vs_out_t ps_input) : SV_Target
+{
+    return float4(ps_input.color.rgb, 1.0f);
+}
@@ -0,0 +1,82 @@
+// permutation_axes: VERTEX_COLOR LIT
+
+// VERTEX_COLOR : The color is fetched from the per vertex color buffer. If not defined, the object's color is used
+// instead (which is how the light sources themselves are rendered).
+// LIT : The color is lit by the clustered lights. Meshes have no normals, so the (flat) normal is reconstructed from
+// the derivatives of the world space position.
+
+#include "clustered_lighting.hlsli"
+#include "common.hlsli"
+
+// Positions and colors are quantized (see decode_position and decode_color of common.hlsli). A float3 can not straddle
+// a 16 byte boundary of a constant buffer, so each is followed by a uint.
+struct render_resources_t
+{
+    float3 position_offset;
+    uint position_buffer_index;
+    float3 position_scale;
+    uint color_buffer_index;
+    uint instance_buffer_index;
+    uint instance_offset;
+    uint scene_buffer_index;
+    uint gpu_scene_buffer_index;
+};
+
+ConstantBuffer<render_resources_t> render_resources : register(b0);
+
+struct vs_out_t
+{
+    float4 position : SV_Position;
+    float4 color : COLOR;
+    float3 world_position : WORLD_POSITION;
+};
+
+vs_out_t vs_main(uint vertex_id : SV_VertexID, uint instance_id : SV_InstanceID)
+{
+    StructuredBuffer<uint2> position_buffer = ResourceDescriptorHeap[render_resources.position_buffer_index];
+
+    // SV_InstanceID does not include the start instance location, so the offset of this draw's instances is passed
+    // explicitly. Each instance is the index of the object's record in the GPU scene buffer.
+    StructuredBuffer<uint> instance_buffer = ResourceDescriptorHeap[render_resources.instance_buffer_index];
+    StructuredBuffer<gpu_scene_object_t> gpu_scene_buffer =
+        ResourceDescriptorHeap[render_resources.gpu_scene_buffer_index];
+    const uint object_index = instance_buffer[render_resources.instance_offset + instance_id];
+    const gpu_scene_object_t scene_object = gpu_scene_buffer[object_index];
+
+    ConstantBuffer<scene_buffer_t> scene_buffer = ResourceDescriptorHeap[render_resources.scene_buffer_index];
+
+    vs_out_t result;
+
+    const float3 position =
+        decode_position(position_buffer[vertex_id], render_resources.position_offset, render_resources.position_scale);
+
+    const float4 world_position = mul(float4(position, 1.0f), scene_object.model_matrix);
+    result.position = mul(world_position, scene_buffer.view_projection_matrix);
+    result.world_position = world_position.xyz;
+
+#ifdef VERTEX_COLOR
+    StructuredBuffer<uint> color_buffer = ResourceDescriptorHeap[render_resources.color_buffer_index];
+    result.color = decode_color(color_buffer[vertex_id]);
+#else
+    result.color = scene_object.color;
+#endif
+
+    return result;
+}
+
+float4 ps_main(vs_out_t ps_input) : SV_Target
+{
+#ifdef LIT
+    ConstantBuffer<scene_buffer_t> scene_buffer = ResourceDescriptorHeap[render_resources.scene_buffer_index];
+
+    const float3 normal = normalize(cross(ddx(ps_input.world_position), ddy(ps_input.world_position)));
+
+    // A small ambient term, so that unlit surfaces are not completely black.
+    const float3 lighting = 0.05f + compute_clustered_lighting(ps_input.world_position, normal, ps_input.position,
+                                                               scene_buffer);
+
+    return float4(ps_input.color.rgb * lighting, ps_input.color.a);
+#else
+    return ps_input.color;
+#endif
+}
@@ -0,0 +1,73 @@
+// CPU simulated particles (see src/particles.hpp), drawn as camera facing quads : one instance per particle, whose 4
+// corners are selected by SV_VertexID (through a 6 index quad index buffer). The particle buffer is written by the CPU
+// every frame, and read directly from upload memory. Particles are unlit, and round (the pipeline is opaque, so the
+// corners of the quad are discarded rather than blended).
+
+#include "common.hlsli"
+
+// A float3 can not straddle a 16 byte boundary of a constant buffer, so each is followed by a uint.
+struct render_resources_t
+{
+    // World space axes of the camera, that the quads are aligned with.
+    float3 camera_right;
+    uint particle_buffer_index;
+    float3 camera_up;
+    uint scene_buffer_index;
+};
+
+// Must match particle_vertex_t in src/particles.hpp.
+struct particle_vertex_t
+{
+    float3 position;
+    float size;
+
+    // RGBA8 unorm, red in the lowest byte.
+    uint color;
+};
+
+ConstantBuffer<render_resources_t> render_resources : register(b0);
+
+struct vs_out_t
+{
+    float4 position : SV_Position;
+    float4 color : COLOR;
+    float2 quad_position : QUAD_POSITION;
+};
+
+static const float2 QUAD_CORNERS[4] = {
+    float2(-1.0f, -1.0f),
+    float2(-1.0f, 1.0f),
+    float2(1.0f, 1.0f),
+    float2(1.0f, -1.0f),
+};
+
+vs_out_t vs_main(uint vertex_id : SV_VertexID, uint instance_id : SV_InstanceID)
+{
+    StructuredBuffer<particle_vertex_t> particle_buffer =
+        ResourceDescriptorHeap[render_resources.particle_buffer_index];
+    ConstantBuffer<scene_buffer_t> scene_buffer = ResourceDescriptorHeap[render_resources.scene_buffer_index];
+
+    const particle_vertex_t particle = particle_buffer[instance_id];
+    const float2 corner = QUAD_CORNERS[vertex_id];
+
+    const float3 world_position = particle.position + (corner.x * render_resources.camera_right +
+                                                       corner.y * render_resources.camera_up) * particle.size;
+
+    vs_out_t result;
+    result.position = mul(float4(world_position, 1.0f), scene_buffer.view_projection_matrix);
+    result.color = float4((particle.color >> uint4(0u, 8u, 16u, 24u)) & 0xffu) / 255.0f;
+    result.quad_position = corner;
+
+    return result;
+}
+
+float4 ps_main(vs_out_t ps_input) : SV_Target
+{
+    // Particles fade out through their size, as alpha is not blended.
+    if (dot(ps_input.quad_position, ps_input.quad_position) > 1.0f || ps_input.color.a <= 0.0f)
+    {
+        discard;
+    }
+
+    return float4(ps_input.color.rgb, 1.0f);
+}
@@ -0,0 +1,87 @@
+// Skinned meshes, animated on the CPU (see src/animation.hpp). Every instance of a draw uses the same skeleton, and the
+// skinning matrices of instance i are [i * num_joints, (i + 1) * num_joints) of the skinning matrix buffer. Skinning
+// matrices take bind pose (object space) positions straight to world space. Lit the same way as the LIT permutation of
+// mesh_shader.hlsl.
+
+#include "clustered_lighting.hlsli"
+#include "common.hlsli"
+
+// Positions and colors are quantized (see decode_position and decode_color of common.hlsli). A float3 can not straddle
+// a 16 byte boundary of a constant buffer, so each is followed by a uint.
+struct render_resources_t
+{
+    float3 position_offset;
+    uint position_buffer_index;
+    float3 position_scale;
+    uint color_buffer_index;
+    uint joint_influence_buffer_index;
+    uint skinning_matrix_buffer_index;
+    uint scene_buffer_index;
+    uint num_joints;
+};
+
+// Must match joint_influence_t in src/animation.hpp : 4 joint indices and 4 unorm weights, 8 bits each.
+struct joint_influence_t
+{
+    uint joint_indices;
+    uint joint_weights;
+};
+
+ConstantBuffer<render_resources_t> render_resources : register(b0);
+
+struct vs_out_t
+{
+    float4 position : SV_Position;
+    float4 color : COLOR;
+    float3 world_position : WORLD_POSITION;
+};
+
+vs_out_t vs_main(uint vertex_id : SV_VertexID, uint instance_id : SV_InstanceID)
+{
+    StructuredBuffer<uint2> position_buffer = ResourceDescriptorHeap[render_resources.position_buffer_index];
+    StructuredBuffer<uint> color_buffer = ResourceDescriptorHeap[render_resources.color_buffer_index];
+    StructuredBuffer<joint_influence_t> joint_influence_buffer =
+        ResourceDescriptorHeap[render_resources.joint_influence_buffer_index];
+    StructuredBuffer<float4x4> skinning_matrix_buffer =
+        ResourceDescriptorHeap[render_resources.skinning_matrix_buffer_index];
+
+    ConstantBuffer<scene_buffer_t> scene_buffer = ResourceDescriptorHeap[render_resources.scene_buffer_index];
+
+    const joint_influence_t joint_influence = joint_influence_buffer[vertex_id];
+    const uint first_skinning_matrix = instance_id * render_resources.num_joints;
+
+    const float4 position = float4(
+        decode_position(position_buffer[vertex_id], render_resources.position_offset, render_resources.position_scale),
+        1.0f);
+
+    float3 world_position = float3(0.0f, 0.0f, 0.0f);
+    for (uint i = 0u; i < 4u; i++)
+    {
+        const float weight = ((joint_influence.joint_weights >> (i * 8u)) & 0xffu) / 255.0f;
+        if (weight > 0.0f)
+        {
+            const uint joint_index = (joint_influence.joint_indices >> (i * 8u)) & 0xffu;
+            world_position += weight * mul(position, skinning_matrix_buffer[first_skinning_matrix + joint_index]).xyz;
+        }
+    }
+
+    vs_out_t result;
+    result.position = mul(float4(world_position, 1.0f), scene_buffer.view_projection_matrix);
+    result.color = decode_color(color_buffer[vertex_id]);
+    result.world_position = world_position;
+
+    return result;
+}
+
+float4 ps_main(vs_out_t ps_input) : SV_Target
+{
+    ConstantBuffer<scene_buffer_t> scene_buffer = ResourceDescriptorHeap[render_resources.scene_buffer_index];
+
+    const float3 normal = normalize(cross(ddx(ps_input.world_position), ddy(ps_input.world_position)));
+
+    // A small ambient term, so that unlit surfaces are not completely black.
+    const float3 lighting = 0.05f + compute_clustered_lighting(ps_input.world_position, normal, ps_input.position,
+                                                               scene_buffer);
+
+    return float4(ps_input.color.rgb * lighting, ps_input.color.a);
+}
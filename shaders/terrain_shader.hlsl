@@ -0,0 +1,105 @@
+// Quadtree terrain patches (see src/terrain.hpp), one instance per patch. Each patch is a grid of
+// (tile_resolution + 3)^2 vertices : the (tile_resolution + 1)^2 samples of its tile, surrounded by a ring of skirt
+// vertices that repeat the border samples skirt_depth lower, hiding the cracks between patches of different depths.
+// Heights are read from the tile slots the CPU streams the tiles into, and the normals are computed from the
+// neighbouring samples. Lit by a constant sun and by the clustered lights.
+
+#include "clustered_lighting.hlsli"
+#include "common.hlsli"
+
+struct render_resources_t
+{
+    uint patch_buffer_index;
+    uint tile_buffer_index;
+    uint scene_buffer_index;
+    uint tile_resolution;
+
+    // World space height of a unorm16 height of 1, and of 0.
+    float height_scale;
+    float base_height;
+};
+
+// Must match terrain_patch_t in src/terrain.hpp.
+struct terrain_patch_t
+{
+    float2 origin;
+    float sample_spacing;
+    float skirt_depth;
+
+    uint first_sample;
+    uint depth;
+};
+
+ConstantBuffer<render_resources_t> render_resources : register(b0);
+
+struct vs_out_t
+{
+    float4 position : SV_Position;
+    float3 normal : NORMAL;
+    float3 world_position : WORLD_POSITION;
+};
+
+// Two unorm16 heights per element of the tile buffer, the first in the low bits.
+float get_height(const terrain_patch_t patch, const int2 sample)
+{
+    StructuredBuffer<uint> tile_buffer = ResourceDescriptorHeap[render_resources.tile_buffer_index];
+
+    const int last_sample = (int)render_resources.tile_resolution;
+    const int2 clamped_sample = clamp(sample, int2(0, 0), int2(last_sample, last_sample));
+
+    const uint sample_index =
+        patch.first_sample + (uint)clamped_sample.y * (render_resources.tile_resolution + 1u) + (uint)clamped_sample.x;
+    const uint packed_heights = tile_buffer[sample_index >> 1u];
+    const uint height = (sample_index & 1u) ? packed_heights >> 16u : packed_heights & 0xffffu;
+
+    return height / 65535.0f * render_resources.height_scale;
+}
+
+vs_out_t vs_main(uint vertex_id : SV_VertexID, uint instance_id : SV_InstanceID)
+{
+    StructuredBuffer<terrain_patch_t> patch_buffer = ResourceDescriptorHeap[render_resources.patch_buffer_index];
+    ConstantBuffer<scene_buffer_t> scene_buffer = ResourceDescriptorHeap[render_resources.scene_buffer_index];
+
+    const terrain_patch_t patch = patch_buffer[instance_id];
+
+    const uint num_vertices_per_side = render_resources.tile_resolution + 3u;
+    const int2 grid_position = int2(vertex_id % num_vertices_per_side, vertex_id / num_vertices_per_side);
+    const int2 sample = clamp(grid_position - 1, int2(0, 0),
+                              int2(render_resources.tile_resolution, render_resources.tile_resolution));
+
+    const bool is_skirt = any(grid_position == 0) || any(grid_position == (int)num_vertices_per_side - 1);
+
+    const float height = get_height(patch, sample) - (is_skirt ? patch.skirt_depth : 0.0f);
+    const float3 world_position =
+        float3(patch.origin.x + sample.x * patch.sample_spacing, render_resources.base_height + height,
+               patch.origin.y + sample.y * patch.sample_spacing);
+
+    // Central differences (one sided along the tile's border).
+    const float height_dx = get_height(patch, sample + int2(1, 0)) - get_height(patch, sample - int2(1, 0));
+    const float height_dz = get_height(patch, sample + int2(0, 1)) - get_height(patch, sample - int2(0, 1));
+
+    vs_out_t result;
+    result.position = mul(float4(world_position, 1.0f), scene_buffer.view_projection_matrix);
+    result.normal = normalize(float3(-height_dx, 2.0f * patch.sample_spacing, -height_dz));
+    result.world_position = world_position;
+
+    return result;
+}
+
+float4 ps_main(vs_out_t ps_input) : SV_Target
+{
+    ConstantBuffer<scene_buffer_t> scene_buffer = ResourceDescriptorHeap[render_resources.scene_buffer_index];
+
+    const float3 normal = normalize(ps_input.normal);
+
+    // Grass on flat ground, rock on slopes.
+    const float3 albedo =
+        lerp(float3(0.45f, 0.4f, 0.35f), float3(0.25f, 0.45f, 0.15f), smoothstep(0.7f, 0.9f, normal.y));
+
+    const float3 sun_direction = normalize(float3(0.3f, 1.0f, 0.2f));
+    const float3 lighting =
+        0.1f + 0.8f * saturate(dot(normal, sun_direction)) +
+        compute_clustered_lighting(ps_input.world_position, normal, ps_input.position, scene_buffer);
+
+    return float4(albedo * lighting, 1.0f);
+}
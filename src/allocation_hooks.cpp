@@ -0,0 +1,123 @@
+#include "allocation_tracker.hpp"
+
+#include <new>
+
+// Replaces the global operator new / delete of the executable this file is linked into with the tracked allocator (see
+// allocation_tracker.hpp), so that every C++ heap allocation is counted under the current memory tag of its thread.
+// Linked into the engine and the tests, but not into the benchmarks, which measure the tracker on its own.
+
+namespace
+{
+void *allocate_or_throw(const size_t size, const size_t alignment)
+{
+    // operator new must return a unique pointer for size 0.
+    void *const ptr = nether::memory::tracked_allocate(std::max(size, size_t{1u}), alignment);
+    if (!ptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+} // namespace
+
+void *operator new(const size_t size)
+{
+    return allocate_or_throw(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new[](const size_t size)
+{
+    return allocate_or_throw(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new(const size_t size, const std::align_val_t alignment)
+{
+    return allocate_or_throw(size, static_cast<size_t>(alignment));
+}
+
+void *operator new[](const size_t size, const std::align_val_t alignment)
+{
+    return allocate_or_throw(size, static_cast<size_t>(alignment));
+}
+
+void *operator new(const size_t size, const std::nothrow_t &) noexcept
+{
+    return nether::memory::tracked_allocate(std::max(size, size_t{1u}), __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new[](const size_t size, const std::nothrow_t &) noexcept
+{
+    return nether::memory::tracked_allocate(std::max(size, size_t{1u}), __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new(const size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return nether::memory::tracked_allocate(std::max(size, size_t{1u}), static_cast<size_t>(alignment));
+}
+
+void *operator new[](const size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return nether::memory::tracked_allocate(std::max(size, size_t{1u}), static_cast<size_t>(alignment));
+}
+
+// The tracked allocations know their size and alignment, so every form of delete is the same.
+void operator delete(void *const ptr) noexcept
+{
+    nether::memory::tracked_free(ptr);
+}
+
+void operator delete[](void *const ptr) noexcept
+{
+    nether::memory::tracked_free(ptr);
+}
+
+void operator delete(void *const ptr, const size_t) noexcept
+{
+    nether::memory::tracked_free(ptr);
+}
+
+void operator delete[](void *const ptr, const size_t) noexcept
+{
+    nether::memory::tracked_free(ptr);
+}
+
+void operator delete(void *const ptr, const std::align_val_t) noexcept
+{
+    nether::memory::tracked_free(ptr);
+}
+
+void operator delete[](void *const ptr, const std::align_val_t) noexcept
+{
+    nether::memory::tracked_free(ptr);
+}
+
+void operator delete(void *const ptr, const size_t, const std::align_val_t) noexcept
+{
+    nether::memory::tracked_free(ptr);
+}
+
+void operator delete[](void *const ptr, const size_t, const std::align_val_t) noexcept
+{
+    nether::memory::tracked_free(ptr);
+}
+
+void operator delete(void *const ptr, const std::nothrow_t &) noexcept
+{
+    nether::memory::tracked_free(ptr);
+}
+
+void operator delete[](void *const ptr, const std::nothrow_t &) noexcept
+{
+    nether::memory::tracked_free(ptr);
+}
+
+void operator delete(void *const ptr, const std::align_val_t, const std::nothrow_t &) noexcept
+{
+    nether::memory::tracked_free(ptr);
+}
+
+void operator delete[](void *const ptr, const std::align_val_t, const std::nothrow_t &) noexcept
+{
+    nether::memory::tracked_free(ptr);
+}
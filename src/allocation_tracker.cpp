@@ -0,0 +1,677 @@
+#include "allocation_tracker.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+#if !defined(_WIN32) && __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define NETHER_HAS_EXECINFO 1
+#endif
+
+namespace nether::memory
+{
+namespace
+{
+// In front of every tracked allocation. offset is the distance from the start of the C heap block to the allocation.
+struct allocation_header_t
+{
+    u64 size{};
+    u32 offset{};
+    memory_tag_t tag{};
+};
+
+static_assert(sizeof(allocation_header_t) == 16u);
+
+struct tag_counters_t
+{
+    std::atomic<u64> num_allocations{};
+    std::atomic<u64> allocated_bytes{};
+    std::atomic<u64> num_frees{};
+    std::atomic<u64> freed_bytes{};
+};
+
+// The counters of a thread, which is their only writer. Blocks are never freed : the block of a thread that exits is
+// reused by the next thread that starts, and keeps its counts.
+struct alignas(64) thread_counters_t
+{
+    std::array<tag_counters_t, NUM_MEMORY_TAGS> tags{};
+    u32 num_allocations_since_sample{};
+
+    std::atomic<bool> in_use{};
+    thread_counters_t *next{};
+};
+
+// Releases the block of the thread when it exits. Allocations made after (by the destructors of other thread locals)
+// go to the shared counters.
+struct thread_counters_owner_t
+{
+    ~thread_counters_owner_t();
+
+    thread_counters_t *counters{};
+};
+
+struct gpu_counters_t
+{
+    std::atomic<u64> live_bytes{};
+    std::atomic<u64> num_resources{};
+};
+
+struct callstack_entry_t
+{
+    u64 hash{};
+    callstack_sample_t sample{};
+};
+
+static constexpr u32 MAX_UNIQUE_CALLSTACKS = 1024u;
+
+// Lock of the callstack table. Sampling is rare, so contention is not a concern, and unlike std::mutex it is usable
+// from allocations made during static initialization.
+class spin_lock_t
+{
+  public:
+    void lock()
+    {
+        while (flag.test_and_set(std::memory_order_acquire))
+        {
+            flag.wait(true, std::memory_order_relaxed);
+        }
+    }
+
+    void unlock()
+    {
+        flag.clear(std::memory_order_release);
+        flag.notify_one();
+    }
+
+  private:
+    std::atomic_flag flag{};
+};
+
+constinit thread_local memory_tag_t g_current_memory_tag = memory_tag_t::untagged;
+constinit thread_local thread_counters_t *g_thread_counters = nullptr;
+constinit thread_local bool g_thread_exited = false;
+constinit thread_local bool g_capturing_callstack = false;
+constinit thread_local thread_counters_owner_t g_thread_counters_owner{};
+
+// Every block ever created, most recent first.
+constinit std::atomic<thread_counters_t *> g_thread_counters_list{};
+
+// Allocations and frees of threads without a block.
+constinit std::array<tag_counters_t, NUM_MEMORY_TAGS> g_shared_counters{};
+
+constinit std::array<std::array<gpu_counters_t, NUM_GPU_HEAP_TYPES>, NUM_MEMORY_TAGS> g_gpu_counters{};
+
+constinit std::atomic<u32> g_callstack_sampling_interval{};
+constinit spin_lock_t g_callstack_lock{};
+constinit std::array<callstack_entry_t, MAX_UNIQUE_CALLSTACKS> g_callstacks{};
+constinit u64 g_num_dropped_callstack_samples{};
+
+thread_counters_owner_t::~thread_counters_owner_t()
+{
+    if (counters)
+    {
+        counters->in_use.store(false, std::memory_order_release);
+    }
+
+    g_thread_counters = nullptr;
+    g_thread_exited = true;
+}
+
+// Only called by the owner of the counter, so it does not need an atomic read-modify-write.
+void add_to_counter(std::atomic<u64> &counter, const u64 value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+thread_counters_t *acquire_thread_counters()
+{
+    for (thread_counters_t *counters = g_thread_counters_list.load(std::memory_order_acquire); counters;
+         counters = counters->next)
+    {
+        bool in_use = false;
+        if (counters->in_use.compare_exchange_strong(in_use, true, std::memory_order_acquire))
+        {
+            return counters;
+        }
+    }
+
+    // Not allocated with new, which may be the tracked operator new.
+    void *const memory = std::malloc(sizeof(thread_counters_t));
+    if (!memory)
+    {
+        return nullptr;
+    }
+
+    thread_counters_t *const counters = new (memory) thread_counters_t{};
+    counters->in_use.store(true, std::memory_order_relaxed);
+
+    counters->next = g_thread_counters_list.load(std::memory_order_relaxed);
+    while (!g_thread_counters_list.compare_exchange_weak(counters->next, counters, std::memory_order_release,
+                                                         std::memory_order_relaxed))
+    {
+    }
+
+    return counters;
+}
+
+thread_counters_t *get_thread_counters()
+{
+    if (g_thread_counters || g_thread_exited)
+    {
+        return g_thread_counters;
+    }
+
+    g_thread_counters = acquire_thread_counters();
+    g_thread_counters_owner.counters = g_thread_counters;
+
+    return g_thread_counters;
+}
+
+u32 capture_callstack(const std::span<u64, MAX_CALLSTACK_FRAMES> frames)
+{
+    std::array<void *, MAX_CALLSTACK_FRAMES> addresses{};
+    u32 num_frames = 0u;
+
+#if defined(_WIN32)
+    num_frames = RtlCaptureStackBackTrace(0u, MAX_CALLSTACK_FRAMES, addresses.data(), nullptr);
+#elif defined(NETHER_HAS_EXECINFO)
+    num_frames = static_cast<u32>(std::max(backtrace(addresses.data(), MAX_CALLSTACK_FRAMES), 0));
+#endif
+
+    for (u32 i = 0u; i < num_frames; i++)
+    {
+        frames[i] = reinterpret_cast<u64>(addresses[i]);
+    }
+
+    return num_frames;
+}
+
+void sample_callstack(const memory_tag_t tag, const u64 size)
+{
+    // The stack walker may allocate.
+    if (g_capturing_callstack)
+    {
+        return;
+    }
+
+    g_capturing_callstack = true;
+
+    std::array<u64, MAX_CALLSTACK_FRAMES> frames{};
+    const u32 num_frames = capture_callstack(frames);
+
+    // FNV-1a of the tag and of the frames.
+    u64 hash = 14695981039346656037ull ^ static_cast<u64>(tag);
+    for (u32 i = 0u; i < num_frames; i++)
+    {
+        hash = (hash ^ frames[i]) * 1099511628211ull;
+    }
+
+    hash = std::max(hash, u64{1u});
+
+    {
+        std::scoped_lock lock(g_callstack_lock);
+
+        // Linear probing, where a hash of 0 is an empty entry.
+        bool found = false;
+        for (u32 probe = 0u; probe < MAX_UNIQUE_CALLSTACKS && !found; probe++)
+        {
+            callstack_entry_t &entry = g_callstacks[(hash + probe) % MAX_UNIQUE_CALLSTACKS];
+            if (entry.hash == 0u)
+            {
+                entry = {
+                    .hash = hash,
+                    .sample =
+                        {
+                            .tag = tag,
+                            .num_frames = num_frames,
+                            .frames = frames,
+                        },
+                };
+            }
+
+            if (entry.hash == hash)
+            {
+                entry.sample.num_samples++;
+                entry.sample.sampled_bytes += size;
+                found = true;
+            }
+        }
+
+        if (!found)
+        {
+            g_num_dropped_callstack_samples++;
+        }
+    }
+
+    g_capturing_callstack = false;
+}
+
+void record_allocation(const memory_tag_t tag, const u64 size)
+{
+    thread_counters_t *const counters = get_thread_counters();
+    if (!counters)
+    {
+        g_shared_counters[static_cast<u32>(tag)].num_allocations.fetch_add(1u, std::memory_order_relaxed);
+        g_shared_counters[static_cast<u32>(tag)].allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+        return;
+    }
+
+    tag_counters_t &tag_counters = counters->tags[static_cast<u32>(tag)];
+    add_to_counter(tag_counters.num_allocations, 1u);
+    add_to_counter(tag_counters.allocated_bytes, size);
+
+    const u32 sampling_interval = g_callstack_sampling_interval.load(std::memory_order_relaxed);
+    if (sampling_interval != 0u && ++counters->num_allocations_since_sample >= sampling_interval)
+    {
+        counters->num_allocations_since_sample = 0u;
+        sample_callstack(tag, size);
+    }
+}
+
+void record_free(const memory_tag_t tag, const u64 size)
+{
+    thread_counters_t *const counters = get_thread_counters();
+    if (!counters)
+    {
+        g_shared_counters[static_cast<u32>(tag)].num_frees.fetch_add(1u, std::memory_order_relaxed);
+        g_shared_counters[static_cast<u32>(tag)].freed_bytes.fetch_add(size, std::memory_order_relaxed);
+        return;
+    }
+
+    tag_counters_t &tag_counters = counters->tags[static_cast<u32>(tag)];
+    add_to_counter(tag_counters.num_frees, 1u);
+    add_to_counter(tag_counters.freed_bytes, size);
+}
+
+// A free may be counted by a thread before the matching allocation is seen in another thread's counters.
+u64 subtract_or_zero(const u64 value, const u64 subtrahend)
+{
+    return value > subtrahend ? value - subtrahend : 0u;
+}
+
+void append_cpu_counters_json(std::string &json, const memory_snapshot_t &snapshot,
+                              const memory_snapshot_t &previous_snapshot)
+{
+    json += "\"cpu\": {";
+    for (u32 tag_index = 0u; tag_index < NUM_MEMORY_TAGS; tag_index++)
+    {
+        const cpu_memory_counters_t &counters = snapshot.cpu[tag_index];
+        const cpu_memory_counters_t &previous_counters = previous_snapshot.cpu[tag_index];
+
+        std::format_to(std::back_inserter(json),
+                       "{}\"{}\": {{\"live_bytes\": {}, \"live_allocations\": {}, \"allocations\": {}, "
+                       "\"allocated_bytes\": {}}}",
+                       tag_index == 0u ? "" : ", ", get_memory_tag_name(static_cast<memory_tag_t>(tag_index)),
+                       counters.live_bytes, counters.live_allocations,
+                       counters.num_allocations - previous_counters.num_allocations,
+                       counters.allocated_bytes - previous_counters.allocated_bytes);
+    }
+    json += "}";
+}
+
+void append_gpu_counters_json(std::string &json, const memory_snapshot_t &snapshot)
+{
+    json += "\"gpu\": {";
+    for (u32 tag_index = 0u; tag_index < NUM_MEMORY_TAGS; tag_index++)
+    {
+        std::format_to(std::back_inserter(json), "{}\"{}\": {{", tag_index == 0u ? "" : ", ",
+                       get_memory_tag_name(static_cast<memory_tag_t>(tag_index)));
+
+        for (u32 heap_index = 0u; heap_index < NUM_GPU_HEAP_TYPES; heap_index++)
+        {
+            const gpu_memory_counters_t &counters = snapshot.gpu[tag_index][heap_index];
+            std::format_to(std::back_inserter(json), "{}\"{}\": {{\"live_bytes\": {}, \"resources\": {}}}",
+                           heap_index == 0u ? "" : ", ",
+                           get_gpu_heap_type_name(static_cast<gpu_heap_type_t>(heap_index)), counters.live_bytes,
+                           counters.num_resources);
+        }
+        json += "}";
+    }
+    json += "}";
+}
+} // namespace
+
+std::string_view get_memory_tag_name(const memory_tag_t tag)
+{
+    static constexpr std::array<std::string_view, NUM_MEMORY_TAGS> names = {
+        "untagged", "render", "shaders", "assets", "ui",
+    };
+
+    return names[static_cast<u32>(tag)];
+}
+
+std::string_view get_gpu_heap_type_name(const gpu_heap_type_t heap_type)
+{
+    static constexpr std::array<std::string_view, NUM_GPU_HEAP_TYPES> names = {
+        "default",
+        "upload",
+        "readback",
+    };
+
+    return names[static_cast<u32>(heap_type)];
+}
+
+memory_tag_t get_current_memory_tag()
+{
+    return g_current_memory_tag;
+}
+
+memory_tag_t set_current_memory_tag(const memory_tag_t tag)
+{
+    const memory_tag_t previous_tag = g_current_memory_tag;
+    g_current_memory_tag = tag;
+
+    return previous_tag;
+}
+
+void *tracked_allocate(const size_t size, const size_t alignment) noexcept
+{
+    // The C heap returns blocks aligned to 16 bytes, so the allocation (after the header) is at most padding bytes past
+    // the start of the block.
+    const size_t padding = std::max(alignment, sizeof(allocation_header_t));
+
+    u8 *const block = static_cast<u8 *>(std::malloc(size + padding));
+    if (!block)
+    {
+        return nullptr;
+    }
+
+    u8 *const ptr = block + (align_up(reinterpret_cast<size_t>(block) + sizeof(allocation_header_t), padding) -
+                             reinterpret_cast<size_t>(block));
+    const memory_tag_t tag = g_current_memory_tag;
+
+    new (ptr - sizeof(allocation_header_t)) allocation_header_t{
+        .size = size,
+        .offset = static_cast<u32>(ptr - block),
+        .tag = tag,
+    };
+
+    record_allocation(tag, size);
+
+    return ptr;
+}
+
+void tracked_free(void *const ptr) noexcept
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    const allocation_header_t &header =
+        *reinterpret_cast<const allocation_header_t *>(static_cast<u8 *>(ptr) - sizeof(allocation_header_t));
+    record_free(header.tag, header.size);
+
+    std::free(static_cast<u8 *>(ptr) - header.offset);
+}
+
+void set_callstack_sampling_interval(const u32 interval)
+{
+    g_callstack_sampling_interval.store(interval, std::memory_order_relaxed);
+}
+
+u32 get_callstack_sampling_interval()
+{
+    return g_callstack_sampling_interval.load(std::memory_order_relaxed);
+}
+
+std::vector<callstack_sample_t> get_callstack_samples()
+{
+    // Reserved before taking the lock, as the allocation may be sampled.
+    std::vector<callstack_sample_t> samples{};
+    samples.reserve(MAX_UNIQUE_CALLSTACKS);
+
+    {
+        std::scoped_lock lock(g_callstack_lock);
+        for (const callstack_entry_t &entry : g_callstacks)
+        {
+            if (entry.hash != 0u)
+            {
+                samples.push_back(entry.sample);
+            }
+        }
+    }
+
+    std::sort(samples.begin(), samples.end(), [](const callstack_sample_t &a, const callstack_sample_t &b) {
+        return a.num_samples > b.num_samples;
+    });
+
+    return samples;
+}
+
+void reset_callstack_samples()
+{
+    std::scoped_lock lock(g_callstack_lock);
+
+    g_callstacks = {};
+    g_num_dropped_callstack_samples = 0u;
+}
+
+u64 get_num_dropped_callstack_samples()
+{
+    std::scoped_lock lock(g_callstack_lock);
+    return g_num_dropped_callstack_samples;
+}
+
+gpu_allocation_t register_gpu_allocation(const gpu_heap_type_t heap_type, const u64 size, const memory_tag_t tag)
+{
+    gpu_counters_t &counters = g_gpu_counters[static_cast<u32>(tag)][static_cast<u32>(heap_type)];
+    counters.live_bytes.fetch_add(size, std::memory_order_relaxed);
+    counters.num_resources.fetch_add(1u, std::memory_order_relaxed);
+
+    return {
+        .tag = tag,
+        .heap_type = heap_type,
+        .size = size,
+    };
+}
+
+void unregister_gpu_allocation(const gpu_allocation_t &allocation)
+{
+    gpu_counters_t &counters = g_gpu_counters[static_cast<u32>(allocation.tag)][static_cast<u32>(allocation.heap_type)];
+    counters.live_bytes.fetch_sub(allocation.size, std::memory_order_relaxed);
+    counters.num_resources.fetch_sub(1u, std::memory_order_relaxed);
+}
+
+memory_snapshot_t take_memory_snapshot(const u64 frame_index)
+{
+    std::array<std::array<u64, 4>, NUM_MEMORY_TAGS> sums{};
+
+    const auto accumulate = [&](const std::array<tag_counters_t, NUM_MEMORY_TAGS> &tags) {
+        for (u32 tag_index = 0u; tag_index < NUM_MEMORY_TAGS; tag_index++)
+        {
+            sums[tag_index][0] += tags[tag_index].num_allocations.load(std::memory_order_relaxed);
+            sums[tag_index][1] += tags[tag_index].allocated_bytes.load(std::memory_order_relaxed);
+            sums[tag_index][2] += tags[tag_index].num_frees.load(std::memory_order_relaxed);
+            sums[tag_index][3] += tags[tag_index].freed_bytes.load(std::memory_order_relaxed);
+        }
+    };
+
+    for (const thread_counters_t *counters = g_thread_counters_list.load(std::memory_order_acquire); counters;
+         counters = counters->next)
+    {
+        accumulate(counters->tags);
+    }
+
+    accumulate(g_shared_counters);
+
+    memory_snapshot_t snapshot = {
+        .frame_index = frame_index,
+    };
+
+    for (u32 tag_index = 0u; tag_index < NUM_MEMORY_TAGS; tag_index++)
+    {
+        snapshot.cpu[tag_index] = {
+            .live_bytes = subtract_or_zero(sums[tag_index][1], sums[tag_index][3]),
+            .live_allocations = subtract_or_zero(sums[tag_index][0], sums[tag_index][2]),
+            .num_allocations = sums[tag_index][0],
+            .allocated_bytes = sums[tag_index][1],
+        };
+
+        for (u32 heap_index = 0u; heap_index < NUM_GPU_HEAP_TYPES; heap_index++)
+        {
+            snapshot.gpu[tag_index][heap_index] = {
+                .live_bytes = g_gpu_counters[tag_index][heap_index].live_bytes.load(std::memory_order_relaxed),
+                .num_resources = g_gpu_counters[tag_index][heap_index].num_resources.load(std::memory_order_relaxed),
+            };
+        }
+    }
+
+    return snapshot;
+}
+
+std::string memory_snapshots_to_json(const std::span<const memory_snapshot_t> snapshots,
+                                     const std::span<const callstack_sample_t> callstack_samples)
+{
+    std::string json = "{\n  \"frames\": [\n";
+    for (u32 i = 1u; i < snapshots.size(); i++)
+    {
+        std::format_to(std::back_inserter(json), "    {{\"frame\": {}, ", snapshots[i].frame_index);
+        append_cpu_counters_json(json, snapshots[i], snapshots[i - 1u]);
+        json += ", ";
+        append_gpu_counters_json(json, snapshots[i]);
+        json += i + 1u == snapshots.size() ? "}\n" : "},\n";
+    }
+
+    json += "  ],\n  \"callstacks\": [\n";
+    for (u32 i = 0u; i < callstack_samples.size(); i++)
+    {
+        const callstack_sample_t &sample = callstack_samples[i];
+        std::format_to(std::back_inserter(json), "    {{\"tag\": \"{}\", \"samples\": {}, \"sampled_bytes\": {}, "
+                                                 "\"frames\": [",
+                       get_memory_tag_name(sample.tag), sample.num_samples, sample.sampled_bytes);
+
+        for (u32 frame_index = 0u; frame_index < sample.num_frames; frame_index++)
+        {
+            std::format_to(std::back_inserter(json), "{}\"0x{:x}\"", frame_index == 0u ? "" : ", ",
+                           sample.frames[frame_index]);
+        }
+
+        json += i + 1u == callstack_samples.size() ? "]}\n" : "]},\n";
+    }
+    json += "  ]\n}\n";
+
+    return json;
+}
+
+memory_telemetry_t::memory_telemetry_t(const memory_telemetry_config_t &config, job_system_t *const job_system)
+    : config(config), job_system(job_system), snapshots(config.history_size + 1u)
+{
+    if (config.history_size == 0u || config.export_interval_in_frames == 0u)
+    {
+        throw std::runtime_error("Memory telemetry history size and export interval must not be 0");
+    }
+
+    if (!config.export_directory.empty())
+    {
+        std::filesystem::create_directories(config.export_directory);
+    }
+
+    snapshots[0] = take_memory_snapshot(0u);
+}
+
+memory_telemetry_t::~memory_telemetry_t()
+{
+    {
+        std::unique_lock lock(export_mutex);
+        export_condition_variable.wait(lock, [&]() { return !export_in_flight.load(std::memory_order_acquire); });
+    }
+
+    if (!config.export_directory.empty() && num_frames > 0u)
+    {
+        export_in_flight.store(true, std::memory_order_release);
+        export_snapshots(get_ordered_snapshots());
+    }
+}
+
+void memory_telemetry_t::end_frame()
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const memory_snapshot_t &previous_snapshot = get_last_snapshot();
+    num_frames++;
+
+    memory_snapshot_t &snapshot = snapshots[num_frames % snapshots.size()];
+    snapshot = take_memory_snapshot(num_frames);
+
+    for (u32 tag_index = 0u; tag_index < NUM_MEMORY_TAGS; tag_index++)
+    {
+        const cpu_memory_counters_t &counters = snapshot.cpu[tag_index];
+        const cpu_memory_counters_t &previous_counters = previous_snapshot.cpu[tag_index];
+
+        statistics.frame_churn[tag_index] = {
+            .num_allocations = counters.num_allocations - previous_counters.num_allocations,
+            .allocated_bytes = counters.allocated_bytes - previous_counters.allocated_bytes,
+        };
+    }
+
+    statistics.snapshot_time_in_ms =
+        std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+    // If the previous export is still running, the next interval exports instead.
+    if (config.export_directory.empty() || num_frames % config.export_interval_in_frames != 0u ||
+        export_in_flight.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    export_in_flight.store(true, std::memory_order_release);
+
+    if (job_system)
+    {
+        job_system->submit(
+            [this, ordered_snapshots = get_ordered_snapshots()]() { export_snapshots(ordered_snapshots); });
+    }
+    else
+    {
+        export_snapshots(get_ordered_snapshots());
+    }
+}
+
+std::vector<memory_snapshot_t> memory_telemetry_t::get_ordered_snapshots() const
+{
+    const u64 num_snapshots = std::min<u64>(num_frames + 1u, snapshots.size());
+
+    std::vector<memory_snapshot_t> ordered_snapshots{};
+    ordered_snapshots.reserve(num_snapshots);
+    for (u64 i = num_frames + 1u - num_snapshots; i <= num_frames; i++)
+    {
+        ordered_snapshots.push_back(snapshots[i % snapshots.size()]);
+    }
+
+    return ordered_snapshots;
+}
+
+void memory_telemetry_t::export_snapshots(const std::vector<memory_snapshot_t> &ordered_snapshots)
+{
+    // The job can not propagate exceptions, so failures are reported, and the next export tries again.
+    try
+    {
+        const std::vector<callstack_sample_t> callstack_samples = get_callstack_samples();
+        const std::string json = memory_snapshots_to_json(ordered_snapshots, callstack_samples);
+
+        // Written to a temporary file first, so readers never see a partially written file.
+        const std::filesystem::path json_path = config.export_directory / "memory_telemetry.json";
+        const std::filesystem::path temporary_json_path = config.export_directory / "memory_telemetry.json.tmp";
+        {
+            std::ofstream json_file(temporary_json_path, std::ios::trunc);
+            if (!json_file.is_open())
+            {
+                throw std::runtime_error(std::format("Failed to open {}", temporary_json_path.string()));
+            }
+            json_file << json;
+        }
+        std::filesystem::rename(temporary_json_path, json_path);
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << std::format("Memory telemetry export failed :: {}", e.what()) << std::endl;
+    }
+
+    // Notified under the lock, as the destructor may run as soon as the lock is released.
+    std::scoped_lock lock(export_mutex);
+    export_in_flight.store(false, std::memory_order_release);
+    export_condition_variable.notify_all();
+}
+} // namespace nether::memory
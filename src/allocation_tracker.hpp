@@ -0,0 +1,257 @@
+#pragma once
+
+#include "common.hpp"
+#include "job_system.hpp"
+#include "memory.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+// Tagged tracking of the CPU heap and of the GPU resources, to see where memory goes and which subsystems allocate in
+// the frame loop.
+//  - Every thread has a current memory tag (set with memory_tag_scope_t), and CPU allocations are attributed to the
+//    tag of the thread that makes them. The tag is per thread : jobs run with the tag of their worker (untagged unless
+//    the job sets one).
+//  - tracked_allocate / tracked_free keep the size and tag of the allocation in a 16 byte header in front of it, and
+//    count the allocations and bytes of each tag. allocation_hooks.cpp replaces the global operator new / delete with
+//    them, so that linking it into an executable tracks every C++ allocation of that executable.
+//  - The counters are per thread (a single writer, so updating them is a plain load and store, without atomic
+//    read-modify-writes or contention), and take_memory_snapshot sums them. Frees are counted by the thread that frees,
+//    so the live bytes of a tag are its allocated bytes minus its freed bytes over all threads.
+//  - Optionally, one allocation in every N records its callstack, and the sampled callstacks are aggregated per unique
+//    callstack, which points at the sites that allocate the most.
+//  - GPU resources are registered with their size and heap type (the D3D12 side is in main.cpp, which passes the
+//    allocation size of the resource).
+// memory_telemetry_t takes a snapshot every frame, so that the allocations made during a frame (the churn) can be
+// displayed and exported to JSON.
+namespace nether::memory
+{
+enum class memory_tag_t : u8
+{
+    untagged,
+    render,
+    shaders,
+    assets,
+    ui,
+};
+
+static constexpr u32 NUM_MEMORY_TAGS = 5u;
+
+enum class gpu_heap_type_t : u8
+{
+    // D3D12_HEAP_TYPE_DEFAULT.
+    device_local,
+    upload,
+    readback,
+};
+
+static constexpr u32 NUM_GPU_HEAP_TYPES = 3u;
+
+std::string_view get_memory_tag_name(const memory_tag_t tag);
+std::string_view get_gpu_heap_type_name(const gpu_heap_type_t heap_type);
+
+memory_tag_t get_current_memory_tag();
+
+// Returns the previous tag of the thread.
+memory_tag_t set_current_memory_tag(const memory_tag_t tag);
+
+// Sets the tag of the calling thread for the lifetime of the scope.
+class memory_tag_scope_t
+{
+  public:
+    explicit memory_tag_scope_t(const memory_tag_t tag) : previous_tag(set_current_memory_tag(tag))
+    {
+    }
+
+    ~memory_tag_scope_t()
+    {
+        set_current_memory_tag(previous_tag);
+    }
+
+    memory_tag_scope_t(const memory_tag_scope_t &) = delete;
+    memory_tag_scope_t &operator=(const memory_tag_scope_t &) = delete;
+
+  private:
+    memory_tag_t previous_tag{};
+};
+
+// Allocates from the C heap, attributed to the current tag of the thread. Returns nullptr if out of memory. Alignment
+// must be a power of two.
+void *tracked_allocate(const size_t size, const size_t alignment = DEFAULT_ALIGNMENT) noexcept;
+
+// Memory must come from tracked_allocate (from any thread). Does nothing for nullptr.
+void tracked_free(void *const ptr) noexcept;
+
+static constexpr u32 MAX_CALLSTACK_FRAMES = 16u;
+
+// Allocations sampled at the same callstack (and tag). The frames are return addresses of this run, including the
+// frames of the tracker itself. Frames are not captured on platforms without a stack walker.
+struct callstack_sample_t
+{
+    memory_tag_t tag{};
+    u32 num_frames{};
+    std::array<u64, MAX_CALLSTACK_FRAMES> frames{};
+
+    u64 num_samples{};
+    u64 sampled_bytes{};
+};
+
+// One allocation in every interval (per thread) is sampled. 0 (the default) disables sampling.
+void set_callstack_sampling_interval(const u32 interval);
+u32 get_callstack_sampling_interval();
+
+// Sorted by number of samples, most sampled first.
+std::vector<callstack_sample_t> get_callstack_samples();
+void reset_callstack_samples();
+
+// Samples of callstacks that did not fit in the table of unique callstacks.
+u64 get_num_dropped_callstack_samples();
+
+struct gpu_allocation_t
+{
+    memory_tag_t tag{};
+    gpu_heap_type_t heap_type{};
+    u64 size{};
+};
+
+// The size is the allocation size of the resource (which includes its alignment), not the size of its data.
+gpu_allocation_t register_gpu_allocation(const gpu_heap_type_t heap_type, const u64 size,
+                                         const memory_tag_t tag = get_current_memory_tag());
+void unregister_gpu_allocation(const gpu_allocation_t &allocation);
+
+#ifdef _WIN32
+// Registers a committed resource with its allocation size and the type of its heap. Custom heaps are counted as
+// device local.
+inline gpu_allocation_t register_gpu_resource(ID3D12Device *const device, ID3D12Resource *const resource,
+                                              const memory_tag_t tag = get_current_memory_tag())
+{
+    D3D12_HEAP_PROPERTIES heap_properties{};
+    throw_if_failed(resource->GetHeapProperties(&heap_properties, nullptr));
+
+    gpu_heap_type_t heap_type = gpu_heap_type_t::device_local;
+    if (heap_properties.Type == D3D12_HEAP_TYPE_UPLOAD)
+    {
+        heap_type = gpu_heap_type_t::upload;
+    }
+    else if (heap_properties.Type == D3D12_HEAP_TYPE_READBACK)
+    {
+        heap_type = gpu_heap_type_t::readback;
+    }
+
+    const D3D12_RESOURCE_DESC resource_desc = resource->GetDesc();
+    const u64 size = device->GetResourceAllocationInfo(0u, 1u, &resource_desc).SizeInBytes;
+
+    return register_gpu_allocation(heap_type, size, tag);
+}
+#endif
+
+struct cpu_memory_counters_t
+{
+    u64 live_bytes{};
+    u64 live_allocations{};
+
+    // Since the start of the program.
+    u64 num_allocations{};
+    u64 allocated_bytes{};
+};
+
+struct gpu_memory_counters_t
+{
+    u64 live_bytes{};
+    u64 num_resources{};
+};
+
+struct memory_snapshot_t
+{
+    u64 frame_index{};
+
+    std::array<cpu_memory_counters_t, NUM_MEMORY_TAGS> cpu{};
+    std::array<std::array<gpu_memory_counters_t, NUM_GPU_HEAP_TYPES>, NUM_MEMORY_TAGS> gpu{};
+};
+
+// The counters of the threads are read while they may be updated, so a snapshot is not an atomic view of the heap
+// (an allocation made while the snapshot is taken may or may not be in it).
+memory_snapshot_t take_memory_snapshot(const u64 frame_index = 0u);
+
+// The first snapshot is the baseline of the second : the allocations of every other snapshot are the ones made since
+// the snapshot before it.
+std::string memory_snapshots_to_json(const std::span<const memory_snapshot_t> snapshots,
+                                     const std::span<const callstack_sample_t> callstack_samples);
+
+struct memory_telemetry_config_t
+{
+    // Number of frames in the exported file.
+    u32 history_size{120u};
+
+    // Frames between exports.
+    u32 export_interval_in_frames{60u};
+
+    // Directory of the JSON file (memory_telemetry.json). Export is disabled if empty.
+    std::filesystem::path export_directory{};
+};
+
+// The allocations of a tag during the last frame.
+struct memory_churn_t
+{
+    u64 num_allocations{};
+    u64 allocated_bytes{};
+};
+
+struct memory_telemetry_statistics_t
+{
+    std::array<memory_churn_t, NUM_MEMORY_TAGS> frame_churn{};
+
+    f32 snapshot_time_in_ms{};
+};
+
+// Per frame memory snapshots. end_frame takes a snapshot (the end of a frame is the start of the next), and every
+// export_interval_in_frames frames, the last history_size frames and the callstack samples are written to the JSON
+// file by a job on the job system, so the frame loop never waits on file IO.
+// Must only be used from the thread that runs the frame loop.
+class memory_telemetry_t
+{
+  public:
+    explicit memory_telemetry_t(const memory_telemetry_config_t &config, job_system_t *const job_system = nullptr);
+
+    // Waits for the export job, and exports the last frames.
+    ~memory_telemetry_t();
+
+    memory_telemetry_t(const memory_telemetry_t &) = delete;
+    memory_telemetry_t &operator=(const memory_telemetry_t &) = delete;
+
+    void end_frame();
+
+    const memory_snapshot_t &get_last_snapshot() const
+    {
+        return snapshots[num_frames % snapshots.size()];
+    }
+
+    u64 get_num_frames() const
+    {
+        return num_frames;
+    }
+
+  public:
+    memory_telemetry_statistics_t statistics{};
+
+  private:
+    // The snapshots in order, oldest first.
+    std::vector<memory_snapshot_t> get_ordered_snapshots() const;
+
+    void export_snapshots(const std::vector<memory_snapshot_t> &ordered_snapshots);
+
+  private:
+    memory_telemetry_config_t config{};
+    job_system_t *job_system{};
+
+    // Ring buffer of history_size + 1 snapshots (the oldest is the baseline of the next). Snapshot 0 is taken when the
+    // telemetry is created.
+    std::vector<memory_snapshot_t> snapshots{};
+    u64 num_frames{};
+
+    std::atomic<bool> export_in_flight{};
+    std::mutex export_mutex{};
+    std::condition_variable export_condition_variable{};
+};
+} // namespace nether::memory
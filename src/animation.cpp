@@ -0,0 +1,1016 @@
+#include "animation.hpp"
+
+#include "memory.hpp"
+
+#include <chrono>
+#include <immintrin.h>
+
+namespace nether
+{
+namespace
+{
+constexpr f32 INVERSE_SQRT_2 = 0.70710678f;
+
+// Rotation components are in [-1 / sqrt(2), 1 / sqrt(2)], stored with 15 bits.
+constexpr u32 MAX_ROTATION_COMPONENT_VALUE = 0x7fffu;
+constexpr f32 ROTATION_COMPONENT_SCALE = 2.0f * INVERSE_SQRT_2 / static_cast<f32>(MAX_ROTATION_COMPONENT_VALUE);
+
+constexpr u32 MAX_TRANSLATION_COMPONENT_VALUE = 0xffffu;
+
+f32 dot(const float4_t &a, const float4_t &b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+float4_t normalize(const float4_t &a)
+{
+    const f32 inverse_length = 1.0f / std::sqrt(dot(a, a));
+    return float4_t{a.x * inverse_length, a.y * inverse_length, a.z * inverse_length, a.w * inverse_length};
+}
+
+// Normalized linear interpolation, along the shortest arc.
+float4_t interpolate_rotations(const float4_t &a, float4_t b, const f32 alpha)
+{
+    if (dot(a, b) < 0.0f)
+    {
+        b = float4_t{-b.x, -b.y, -b.z, -b.w};
+    }
+
+    return normalize(float4_t{a.x + (b.x - a.x) * alpha, a.y + (b.y - a.y) * alpha, a.z + (b.z - a.z) * alpha,
+                              a.w + (b.w - a.w) * alpha});
+}
+
+float3_t interpolate_translations(const float3_t &a, const float3_t &b, const f32 alpha)
+{
+    return a + (b - a) * alpha;
+}
+
+// Angle of the rotation between two unit quaternions. The error bounds are small angles, for which acos of the dot
+// product is inaccurate, so this uses atan2 of the lengths of the difference and the sum instead.
+f64 get_rotation_angle(const float4_t &a, float4_t b)
+{
+    if (dot(a, b) < 0.0f)
+    {
+        b = float4_t{-b.x, -b.y, -b.z, -b.w};
+    }
+
+    const f64 difference[4] = {f64{a.x} - b.x, f64{a.y} - b.y, f64{a.z} - b.z, f64{a.w} - b.w};
+    const f64 sum[4] = {f64{a.x} + b.x, f64{a.y} + b.y, f64{a.z} + b.z, f64{a.w} + b.w};
+
+    f64 difference_length_squared = 0.0;
+    f64 sum_length_squared = 0.0;
+    for (u32 i = 0u; i < 4u; i++)
+    {
+        difference_length_squared += difference[i] * difference[i];
+        sum_length_squared += sum[i] * sum[i];
+    }
+
+    return 4.0 * std::atan2(std::sqrt(difference_length_squared), std::sqrt(sum_length_squared));
+}
+
+quantized_rotation_t quantize_rotation(const float4_t &rotation)
+{
+    float4_t normalized_rotation = normalize(rotation);
+    f32 components[4] = {normalized_rotation.x, normalized_rotation.y, normalized_rotation.z, normalized_rotation.w};
+
+    u32 largest_index = 0u;
+    for (u32 i = 1u; i < 4u; i++)
+    {
+        if (std::abs(components[i]) > std::abs(components[largest_index]))
+        {
+            largest_index = i;
+        }
+    }
+
+    const f32 sign = components[largest_index] < 0.0f ? -1.0f : 1.0f;
+
+    quantized_rotation_t result{};
+    u32 value_index = 0u;
+    for (u32 i = 0u; i < 4u; i++)
+    {
+        if (i == largest_index)
+        {
+            continue;
+        }
+
+        const f32 value = std::round((components[i] * sign + INVERSE_SQRT_2) / ROTATION_COMPONENT_SCALE);
+        result.values[value_index++] =
+            static_cast<u16>(std::clamp(value, 0.0f, static_cast<f32>(MAX_ROTATION_COMPONENT_VALUE)));
+    }
+
+    result.values[0] |= static_cast<u16>((largest_index & 1u) << 15u);
+    result.values[1] |= static_cast<u16>((largest_index >> 1u) << 15u);
+
+    return result;
+}
+
+float4_t dequantize_rotation(const quantized_rotation_t &rotation)
+{
+    const u32 largest_index = (rotation.values[0] >> 15u) | ((rotation.values[1] >> 15u) << 1u);
+
+    f32 values[3]{};
+    f32 largest_squared = 1.0f;
+    for (u32 i = 0u; i < 3u; i++)
+    {
+        values[i] = static_cast<f32>(rotation.values[i] & MAX_ROTATION_COMPONENT_VALUE) * ROTATION_COMPONENT_SCALE -
+                    INVERSE_SQRT_2;
+        largest_squared -= values[i] * values[i];
+    }
+
+    f32 components[4]{};
+    u32 value_index = 0u;
+    for (u32 i = 0u; i < 4u; i++)
+    {
+        components[i] = i == largest_index ? std::sqrt(std::max(largest_squared, 0.0f)) : values[value_index++];
+    }
+
+    return float4_t{components[0], components[1], components[2], components[3]};
+}
+
+quantized_translation_t quantize_translation(const float3_t &translation, const translation_range_t &range)
+{
+    const auto quantize = [](const f32 value, const f32 min, const f32 extent) {
+        if (extent <= 0.0f)
+        {
+            return u16{0u};
+        }
+
+        const f32 normalized_value = std::clamp((value - min) / extent, 0.0f, 1.0f);
+        return static_cast<u16>(std::round(normalized_value * static_cast<f32>(MAX_TRANSLATION_COMPONENT_VALUE)));
+    };
+
+    return quantized_translation_t{
+        .values =
+            {
+                quantize(translation.x, range.min.x, range.extent.x),
+                quantize(translation.y, range.min.y, range.extent.y),
+                quantize(translation.z, range.min.z, range.extent.z),
+            },
+    };
+}
+
+float3_t dequantize_translation(const quantized_translation_t &translation, const translation_range_t &range)
+{
+    constexpr f32 scale = 1.0f / static_cast<f32>(MAX_TRANSLATION_COMPONENT_VALUE);
+
+    return float3_t{
+        range.min.x + static_cast<f32>(translation.values[0]) * (range.extent.x * scale),
+        range.min.y + static_cast<f32>(translation.values[1]) * (range.extent.y * scale),
+        range.min.z + static_cast<f32>(translation.values[2]) * (range.extent.z * scale),
+    };
+}
+
+// Greedy key reduction of one track : from the last kept key, extends the segment while interpolating between its end
+// points reproduces every sample in between within max_error. Returns the frames of the kept keys.
+template <typename T, typename interpolate_t, typename error_t>
+std::vector<u32> reduce_keys(const std::span<const T> quantized_values, const std::span<const T> raw_values,
+                             const f64 max_error, const interpolate_t &interpolate, const error_t &get_error)
+{
+    const u32 num_frames = static_cast<u32>(raw_values.size());
+
+    std::vector<u32> key_frames{0u};
+
+    const auto is_segment_valid = [&](const u32 first_frame, const u32 last_frame) {
+        for (u32 frame = first_frame + 1u; frame < last_frame; frame++)
+        {
+            const f32 alpha = static_cast<f32>(frame - first_frame) / static_cast<f32>(last_frame - first_frame);
+            const T value = interpolate(quantized_values[first_frame], quantized_values[last_frame], alpha);
+            if (get_error(value, raw_values[frame]) > max_error)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    u32 first_frame = 0u;
+    while (first_frame + 1u < num_frames)
+    {
+        u32 last_frame = first_frame + 1u;
+        while (last_frame + 1u < num_frames && is_segment_valid(first_frame, last_frame + 1u))
+        {
+            last_frame++;
+        }
+
+        key_frames.push_back(last_frame);
+        first_frame = last_frame;
+    }
+
+    return key_frames;
+}
+
+// The pair of keys of a track that a frame position is between, and the position between them.
+struct key_pair_t
+{
+    u32 first{};
+    u32 second{};
+    f32 alpha{};
+};
+
+// cursor is the first key of the pair found by the previous search of the track, which the search starts from if the
+// frame position did not go backwards.
+key_pair_t find_key_pair(const std::span<const u16> key_frames, const u32 begin, const u32 end,
+                         const f32 frame_position, u32 &cursor)
+{
+    if (end - begin == 1u)
+    {
+        cursor = begin;
+        return key_pair_t{begin, begin, 0.0f};
+    }
+
+    const u32 last_pair = end - 2u;
+    if (cursor < begin || cursor > last_pair || static_cast<f32>(key_frames[cursor]) > frame_position)
+    {
+        const auto key = std::upper_bound(key_frames.begin() + begin, key_frames.begin() + end, frame_position,
+                                          [](const f32 position, const u16 frame) {
+                                              return position < static_cast<f32>(frame);
+                                          });
+        cursor = std::clamp(static_cast<u32>(key - key_frames.begin()), begin + 1u, last_pair + 1u) - 1u;
+    }
+
+    while (cursor < last_pair && static_cast<f32>(key_frames[cursor + 1u]) <= frame_position)
+    {
+        cursor++;
+    }
+
+    const f32 first_frame = static_cast<f32>(key_frames[cursor]);
+    const f32 second_frame = static_cast<f32>(key_frames[cursor + 1u]);
+
+    return key_pair_t{
+        .first = cursor,
+        .second = cursor + 1u,
+        .alpha = std::clamp((frame_position - first_frame) / (second_frame - first_frame), 0.0f, 1.0f),
+    };
+}
+
+f32 get_frame_position(const animation_clip_t &clip, const f32 time_in_s)
+{
+    return std::clamp(time_in_s * clip.sample_rate, 0.0f, static_cast<f32>(clip.num_frames - 1u));
+}
+
+struct quaternion_lanes_t
+{
+    __m256 x{};
+    __m256 y{};
+    __m256 z{};
+    __m256 w{};
+};
+
+struct vector_lanes_t
+{
+    __m256 x{};
+    __m256 y{};
+    __m256 z{};
+};
+
+// Key pairs of 8 joints, gathered by sample_animation_clip so that decoding and interpolation can run on all of them at
+// once. Unused lanes are zero.
+struct alignas(32) key_pair_lanes_t
+{
+    u32 rotation_values[2][3][joint_transform_soa_t::NUM_LANES]{};
+    f32 rotation_alpha[joint_transform_soa_t::NUM_LANES]{};
+
+    u32 translation_values[2][3][joint_transform_soa_t::NUM_LANES]{};
+    f32 translation_alpha[joint_transform_soa_t::NUM_LANES]{};
+    f32 translation_min[3][joint_transform_soa_t::NUM_LANES]{};
+    f32 translation_scale[3][joint_transform_soa_t::NUM_LANES]{};
+};
+
+// Smallest three decoding of 8 rotations (see quantized_rotation_t).
+quaternion_lanes_t decode_rotations(const u32 (&values)[3][joint_transform_soa_t::NUM_LANES])
+{
+    const __m256i value_0 = _mm256_load_si256(reinterpret_cast<const __m256i *>(values[0]));
+    const __m256i value_1 = _mm256_load_si256(reinterpret_cast<const __m256i *>(values[1]));
+    const __m256i value_2 = _mm256_load_si256(reinterpret_cast<const __m256i *>(values[2]));
+
+    const __m256i component_mask = _mm256_set1_epi32(static_cast<i32>(MAX_ROTATION_COMPONENT_VALUE));
+    const __m256 scale = _mm256_set1_ps(ROTATION_COMPONENT_SCALE);
+    const __m256 bias = _mm256_set1_ps(-INVERSE_SQRT_2);
+
+    const __m256 a = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(value_0, component_mask)), scale),
+                                   bias);
+    const __m256 b = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(value_1, component_mask)), scale),
+                                   bias);
+    const __m256 c = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(value_2, component_mask)), scale),
+                                   bias);
+
+    const __m256 largest_squared =
+        _mm256_sub_ps(_mm256_set1_ps(1.0f),
+                      _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b)), _mm256_mul_ps(c, c)));
+    const __m256 d = _mm256_sqrt_ps(_mm256_max_ps(largest_squared, _mm256_setzero_ps()));
+
+    const __m256i largest_index =
+        _mm256_or_si256(_mm256_srli_epi32(value_0, 15), _mm256_slli_epi32(_mm256_srli_epi32(value_1, 15), 1));
+    const __m256 is_x_largest = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest_index, _mm256_set1_epi32(0)));
+    const __m256 is_y_largest = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest_index, _mm256_set1_epi32(1)));
+    const __m256 is_z_largest = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest_index, _mm256_set1_epi32(2)));
+    const __m256 is_w_largest = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest_index, _mm256_set1_epi32(3)));
+
+    // The three stored components fill the other slots in order.
+    return quaternion_lanes_t{
+        .x = _mm256_blendv_ps(a, d, is_x_largest),
+        .y = _mm256_blendv_ps(_mm256_blendv_ps(b, d, is_y_largest), a, is_x_largest),
+        .z = _mm256_blendv_ps(_mm256_blendv_ps(c, d, is_z_largest), b, _mm256_or_ps(is_x_largest, is_y_largest)),
+        .w = _mm256_blendv_ps(c, d, is_w_largest),
+    };
+}
+
+vector_lanes_t decode_translations(const u32 (&values)[3][joint_transform_soa_t::NUM_LANES],
+                                   const key_pair_lanes_t &key_pairs)
+{
+    const auto decode = [&](const u32 component) {
+        const __m256 value =
+            _mm256_cvtepi32_ps(_mm256_load_si256(reinterpret_cast<const __m256i *>(values[component])));
+        return _mm256_add_ps(_mm256_load_ps(key_pairs.translation_min[component]),
+                             _mm256_mul_ps(value, _mm256_load_ps(key_pairs.translation_scale[component])));
+    };
+
+    return vector_lanes_t{decode(0u), decode(1u), decode(2u)};
+}
+
+__m256 dot(const quaternion_lanes_t &a, const quaternion_lanes_t &b)
+{
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a.x, b.x), _mm256_mul_ps(a.y, b.y)),
+                         _mm256_add_ps(_mm256_mul_ps(a.z, b.z), _mm256_mul_ps(a.w, b.w)));
+}
+
+quaternion_lanes_t normalize(const quaternion_lanes_t &a)
+{
+    const __m256 inverse_length = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(dot(a, a)));
+
+    return quaternion_lanes_t{_mm256_mul_ps(a.x, inverse_length), _mm256_mul_ps(a.y, inverse_length),
+                              _mm256_mul_ps(a.z, inverse_length), _mm256_mul_ps(a.w, inverse_length)};
+}
+
+// Flips b into the hemisphere of a (b and -b are the same rotation), by flipping its sign where the dot product is
+// negative.
+quaternion_lanes_t flip_to_hemisphere(const quaternion_lanes_t &a, const quaternion_lanes_t &b)
+{
+    const __m256 sign = _mm256_and_ps(dot(a, b), _mm256_set1_ps(-0.0f));
+
+    return quaternion_lanes_t{_mm256_xor_ps(b.x, sign), _mm256_xor_ps(b.y, sign), _mm256_xor_ps(b.z, sign),
+                              _mm256_xor_ps(b.w, sign)};
+}
+
+__m256 lerp(const __m256 a, const __m256 b, const __m256 alpha)
+{
+    return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), alpha));
+}
+
+quaternion_lanes_t load_rotations(const joint_transform_soa_t &transforms)
+{
+    return quaternion_lanes_t{_mm256_load_ps(transforms.rotation_x), _mm256_load_ps(transforms.rotation_y),
+                              _mm256_load_ps(transforms.rotation_z), _mm256_load_ps(transforms.rotation_w)};
+}
+
+vector_lanes_t load_translations(const joint_transform_soa_t &transforms)
+{
+    return vector_lanes_t{_mm256_load_ps(transforms.translation_x), _mm256_load_ps(transforms.translation_y),
+                          _mm256_load_ps(transforms.translation_z)};
+}
+
+void store_transforms(const quaternion_lanes_t &rotations, const vector_lanes_t &translations,
+                      joint_transform_soa_t &transforms)
+{
+    _mm256_store_ps(transforms.rotation_x, rotations.x);
+    _mm256_store_ps(transforms.rotation_y, rotations.y);
+    _mm256_store_ps(transforms.rotation_z, rotations.z);
+    _mm256_store_ps(transforms.rotation_w, rotations.w);
+
+    _mm256_store_ps(transforms.translation_x, translations.x);
+    _mm256_store_ps(transforms.translation_y, translations.y);
+    _mm256_store_ps(transforms.translation_z, translations.z);
+}
+
+// result = a * b. result may be a (but not b).
+void multiply_matrices(const float4x4_t &a, const float4x4_t &b, float4x4_t &result)
+{
+    const __m128 b_row_0 = _mm_loadu_ps(b.m[0]);
+    const __m128 b_row_1 = _mm_loadu_ps(b.m[1]);
+    const __m128 b_row_2 = _mm_loadu_ps(b.m[2]);
+    const __m128 b_row_3 = _mm_loadu_ps(b.m[3]);
+
+    for (u32 row = 0u; row < 4u; row++)
+    {
+        const __m128 result_row =
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a.m[row][0]), b_row_0),
+                                  _mm_mul_ps(_mm_set1_ps(a.m[row][1]), b_row_1)),
+                       _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a.m[row][2]), b_row_2),
+                                  _mm_mul_ps(_mm_set1_ps(a.m[row][3]), b_row_3)));
+        _mm_storeu_ps(result.m[row], result_row);
+    }
+}
+
+// Inverse of a matrix without scaling : the transpose of the rotation, and the translation rotated back.
+float4x4_t inverse_rigid_matrix(const float4x4_t &matrix)
+{
+    float4x4_t result = identity_matrix();
+    for (u32 row = 0u; row < 3u; row++)
+    {
+        for (u32 column = 0u; column < 3u; column++)
+        {
+            result.m[row][column] = matrix.m[column][row];
+        }
+    }
+
+    for (u32 column = 0u; column < 3u; column++)
+    {
+        result.m[3][column] = -(matrix.m[3][0] * result.m[0][column] + matrix.m[3][1] * result.m[1][column] +
+                                matrix.m[3][2] * result.m[2][column]);
+    }
+
+    return result;
+}
+} // namespace
+
+joint_transform_t get_joint_transform(const std::span<const joint_transform_soa_t> pose, const u32 joint_index)
+{
+    const joint_transform_soa_t &transforms = pose[joint_index / joint_transform_soa_t::NUM_LANES];
+    const u32 lane = joint_index % joint_transform_soa_t::NUM_LANES;
+
+    return joint_transform_t{
+        .rotation = {transforms.rotation_x[lane], transforms.rotation_y[lane], transforms.rotation_z[lane],
+                     transforms.rotation_w[lane]},
+        .translation = {transforms.translation_x[lane], transforms.translation_y[lane],
+                        transforms.translation_z[lane]},
+    };
+}
+
+void set_joint_transform(const std::span<joint_transform_soa_t> pose, const u32 joint_index,
+                         const joint_transform_t &transform)
+{
+    joint_transform_soa_t &transforms = pose[joint_index / joint_transform_soa_t::NUM_LANES];
+    const u32 lane = joint_index % joint_transform_soa_t::NUM_LANES;
+
+    transforms.rotation_x[lane] = transform.rotation.x;
+    transforms.rotation_y[lane] = transform.rotation.y;
+    transforms.rotation_z[lane] = transform.rotation.z;
+    transforms.rotation_w[lane] = transform.rotation.w;
+
+    transforms.translation_x[lane] = transform.translation.x;
+    transforms.translation_y[lane] = transform.translation.y;
+    transforms.translation_z[lane] = transform.translation.z;
+}
+
+float4x4_t get_joint_matrix(const joint_transform_t &transform)
+{
+    const auto [x, y, z, w] = transform.rotation;
+
+    float4x4_t result = identity_matrix();
+    result.m[0][0] = 1.0f - 2.0f * (y * y + z * z);
+    result.m[0][1] = 2.0f * (x * y + z * w);
+    result.m[0][2] = 2.0f * (x * z - y * w);
+    result.m[1][0] = 2.0f * (x * y - z * w);
+    result.m[1][1] = 1.0f - 2.0f * (x * x + z * z);
+    result.m[1][2] = 2.0f * (y * z + x * w);
+    result.m[2][0] = 2.0f * (x * z + y * w);
+    result.m[2][1] = 2.0f * (y * z - x * w);
+    result.m[2][2] = 1.0f - 2.0f * (x * x + y * y);
+    result.m[3][0] = transform.translation.x;
+    result.m[3][1] = transform.translation.y;
+    result.m[3][2] = transform.translation.z;
+
+    return result;
+}
+
+skeleton_t create_skeleton(const std::span<const u32> parent_indices,
+                           const std::span<const joint_transform_t> bind_pose)
+{
+    if (parent_indices.size() != bind_pose.size())
+    {
+        throw std::runtime_error(std::format("Skeleton has {} parent indices but {} bind pose transforms",
+                                             parent_indices.size(), bind_pose.size()));
+    }
+
+    const u32 num_joints = static_cast<u32>(parent_indices.size());
+
+    skeleton_t skeleton = {
+        .parent_indices = {parent_indices.begin(), parent_indices.end()},
+        .bind_pose = {bind_pose.begin(), bind_pose.end()},
+        .inverse_bind_matrices = std::vector<float4x4_t>(num_joints),
+    };
+
+    std::vector<float4x4_t> model_matrices(num_joints);
+    for (u32 i = 0u; i < num_joints; i++)
+    {
+        const u32 parent_index = parent_indices[i];
+        if (parent_index != skeleton_t::INVALID_JOINT_INDEX && parent_index >= i)
+        {
+            throw std::runtime_error(
+                std::format("Parent {} of joint {} does not come before it in the skeleton", parent_index, i));
+        }
+
+        model_matrices[i] = get_joint_matrix(bind_pose[i]);
+        if (parent_index != skeleton_t::INVALID_JOINT_INDEX)
+        {
+            model_matrices[i] = model_matrices[i] * model_matrices[parent_index];
+        }
+
+        skeleton.inverse_bind_matrices[i] = inverse_rigid_matrix(model_matrices[i]);
+    }
+
+    return skeleton;
+}
+
+size_t animation_clip_t::get_size_in_bytes() const
+{
+    return sizeof(u32) * (rotation_track_offsets.size() + translation_track_offsets.size()) +
+           sizeof(u16) * (rotation_key_frames.size() + translation_key_frames.size()) +
+           sizeof(quantized_rotation_t) * rotation_keys.size() +
+           sizeof(quantized_translation_t) * translation_keys.size() +
+           sizeof(translation_range_t) * translation_ranges.size();
+}
+
+animation_clip_t compress_animation_clip(const raw_animation_clip_t &raw_clip,
+                                         const animation_compression_settings_t &settings)
+{
+    if (raw_clip.num_frames == 0u || raw_clip.num_joints == 0u)
+    {
+        throw std::runtime_error("Can not compress an animation clip without frames or joints");
+    }
+
+    // Key frames are stored as u16.
+    if (raw_clip.num_frames > 65536u)
+    {
+        throw std::runtime_error(
+            std::format("Animation clip has {} frames, the maximum is 65536", raw_clip.num_frames));
+    }
+
+    if (raw_clip.samples.size() != static_cast<size_t>(raw_clip.num_frames) * raw_clip.num_joints)
+    {
+        throw std::runtime_error(std::format("Animation clip with {} frames and {} joints has {} samples",
+                                             raw_clip.num_frames, raw_clip.num_joints, raw_clip.samples.size()));
+    }
+
+    const u32 num_frames = raw_clip.num_frames;
+    const u32 num_joints = raw_clip.num_joints;
+
+    animation_clip_t clip = {
+        .sample_rate = raw_clip.sample_rate,
+        .num_frames = num_frames,
+        .num_joints = num_joints,
+    };
+    clip.rotation_track_offsets.reserve(num_joints + 1u);
+    clip.translation_track_offsets.reserve(num_joints + 1u);
+    clip.translation_ranges.reserve(num_joints);
+
+    std::vector<float4_t> raw_rotations(num_frames);
+    std::vector<float4_t> quantized_rotations(num_frames);
+    std::vector<quantized_rotation_t> rotation_keys(num_frames);
+
+    std::vector<float3_t> raw_translations(num_frames);
+    std::vector<float3_t> quantized_translations(num_frames);
+    std::vector<quantized_translation_t> translation_keys(num_frames);
+
+    for (u32 joint = 0u; joint < num_joints; joint++)
+    {
+        aabb_t bounds{};
+        for (u32 frame = 0u; frame < num_frames; frame++)
+        {
+            const joint_transform_t &sample = raw_clip.samples[frame * num_joints + joint];
+
+            raw_rotations[frame] = normalize(sample.rotation);
+            raw_translations[frame] = sample.translation;
+            bounds = merge(bounds, sample.translation);
+        }
+        const translation_range_t range = {bounds.min, bounds.max - bounds.min};
+
+        for (u32 frame = 0u; frame < num_frames; frame++)
+        {
+            rotation_keys[frame] = quantize_rotation(raw_rotations[frame]);
+            quantized_rotations[frame] = dequantize_rotation(rotation_keys[frame]);
+
+            translation_keys[frame] = quantize_translation(raw_translations[frame], range);
+            quantized_translations[frame] = dequantize_translation(translation_keys[frame], range);
+        }
+
+        // Keys are reduced after quantization, so that the error bounds hold for what sampling reconstructs.
+        const std::vector<u32> rotation_key_frames = reduce_keys<float4_t>(
+            quantized_rotations, raw_rotations, settings.max_rotation_error_in_radians, interpolate_rotations,
+            get_rotation_angle);
+        const std::vector<u32> translation_key_frames = reduce_keys<float3_t>(
+            quantized_translations, raw_translations, settings.max_translation_error, interpolate_translations,
+            [](const float3_t &a, const float3_t &b) { return static_cast<f64>(length(a - b)); });
+
+        clip.rotation_track_offsets.push_back(clip.get_num_rotation_keys());
+        for (const u32 frame : rotation_key_frames)
+        {
+            clip.rotation_key_frames.push_back(static_cast<u16>(frame));
+            clip.rotation_keys.push_back(rotation_keys[frame]);
+        }
+
+        clip.translation_track_offsets.push_back(clip.get_num_translation_keys());
+        for (const u32 frame : translation_key_frames)
+        {
+            clip.translation_key_frames.push_back(static_cast<u16>(frame));
+            clip.translation_keys.push_back(translation_keys[frame]);
+        }
+        clip.translation_ranges.push_back(range);
+    }
+
+    clip.rotation_track_offsets.push_back(clip.get_num_rotation_keys());
+    clip.translation_track_offsets.push_back(clip.get_num_translation_keys());
+
+    return clip;
+}
+
+joint_transform_t sample_animation_clip_joint(const animation_clip_t &clip, const f32 time_in_s,
+                                              const u32 joint_index)
+{
+    const f32 frame_position = get_frame_position(clip, time_in_s);
+
+    u32 rotation_cursor = ~0u;
+    const key_pair_t rotation_keys =
+        find_key_pair(clip.rotation_key_frames, clip.rotation_track_offsets[joint_index],
+                      clip.rotation_track_offsets[joint_index + 1u], frame_position, rotation_cursor);
+
+    u32 translation_cursor = ~0u;
+    const key_pair_t translation_keys =
+        find_key_pair(clip.translation_key_frames, clip.translation_track_offsets[joint_index],
+                      clip.translation_track_offsets[joint_index + 1u], frame_position, translation_cursor);
+
+    const translation_range_t &range = clip.translation_ranges[joint_index];
+
+    return joint_transform_t{
+        .rotation = interpolate_rotations(dequantize_rotation(clip.rotation_keys[rotation_keys.first]),
+                                          dequantize_rotation(clip.rotation_keys[rotation_keys.second]),
+                                          rotation_keys.alpha),
+        .translation =
+            interpolate_translations(dequantize_translation(clip.translation_keys[translation_keys.first], range),
+                                     dequantize_translation(clip.translation_keys[translation_keys.second], range),
+                                     translation_keys.alpha),
+    };
+}
+
+void animation_sampling_context_t::reset(const animation_clip_t &clip)
+{
+    this->clip = &clip;
+
+    rotation_cursors.assign(clip.rotation_track_offsets.begin(), clip.rotation_track_offsets.end() - 1);
+    translation_cursors.assign(clip.translation_track_offsets.begin(), clip.translation_track_offsets.end() - 1);
+}
+
+void sample_animation_clip(const animation_clip_t &clip, const f32 time_in_s, animation_sampling_context_t &context,
+                           const std::span<joint_transform_soa_t> pose)
+{
+    if (context.clip != &clip)
+    {
+        context.reset(clip);
+    }
+
+    const f32 frame_position = get_frame_position(clip, time_in_s);
+    const u32 num_joints = clip.num_joints;
+
+    const __m256i lane_indices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const quaternion_lanes_t identity_rotations = {
+        .x = _mm256_setzero_ps(),
+        .y = _mm256_setzero_ps(),
+        .z = _mm256_setzero_ps(),
+        .w = _mm256_set1_ps(1.0f),
+    };
+
+    for (u32 first_joint = 0u; first_joint < num_joints; first_joint += joint_transform_soa_t::NUM_LANES)
+    {
+        const u32 num_lanes = std::min(num_joints - first_joint, joint_transform_soa_t::NUM_LANES);
+
+        // Finding the keys is scalar, decoding and interpolating them is done for all lanes at once.
+        key_pair_lanes_t key_pairs{};
+        for (u32 lane = 0u; lane < num_lanes; lane++)
+        {
+            const u32 joint = first_joint + lane;
+
+            const key_pair_t rotation_keys =
+                find_key_pair(clip.rotation_key_frames, clip.rotation_track_offsets[joint],
+                              clip.rotation_track_offsets[joint + 1u], frame_position, context.rotation_cursors[joint]);
+            const key_pair_t translation_keys = find_key_pair(
+                clip.translation_key_frames, clip.translation_track_offsets[joint],
+                clip.translation_track_offsets[joint + 1u], frame_position, context.translation_cursors[joint]);
+
+            const quantized_rotation_t &first_rotation = clip.rotation_keys[rotation_keys.first];
+            const quantized_rotation_t &second_rotation = clip.rotation_keys[rotation_keys.second];
+            const quantized_translation_t &first_translation = clip.translation_keys[translation_keys.first];
+            const quantized_translation_t &second_translation = clip.translation_keys[translation_keys.second];
+
+            for (u32 component = 0u; component < 3u; component++)
+            {
+                key_pairs.rotation_values[0][component][lane] = first_rotation.values[component];
+                key_pairs.rotation_values[1][component][lane] = second_rotation.values[component];
+
+                key_pairs.translation_values[0][component][lane] = first_translation.values[component];
+                key_pairs.translation_values[1][component][lane] = second_translation.values[component];
+            }
+            key_pairs.rotation_alpha[lane] = rotation_keys.alpha;
+            key_pairs.translation_alpha[lane] = translation_keys.alpha;
+
+            const translation_range_t &range = clip.translation_ranges[joint];
+            constexpr f32 scale = 1.0f / static_cast<f32>(MAX_TRANSLATION_COMPONENT_VALUE);
+
+            key_pairs.translation_min[0][lane] = range.min.x;
+            key_pairs.translation_min[1][lane] = range.min.y;
+            key_pairs.translation_min[2][lane] = range.min.z;
+            key_pairs.translation_scale[0][lane] = range.extent.x * scale;
+            key_pairs.translation_scale[1][lane] = range.extent.y * scale;
+            key_pairs.translation_scale[2][lane] = range.extent.z * scale;
+        }
+
+        const quaternion_lanes_t first_rotations = decode_rotations(key_pairs.rotation_values[0]);
+        const quaternion_lanes_t second_rotations =
+            flip_to_hemisphere(first_rotations, decode_rotations(key_pairs.rotation_values[1]));
+
+        const __m256 rotation_alpha = _mm256_load_ps(key_pairs.rotation_alpha);
+        quaternion_lanes_t rotations = normalize(quaternion_lanes_t{
+            .x = lerp(first_rotations.x, second_rotations.x, rotation_alpha),
+            .y = lerp(first_rotations.y, second_rotations.y, rotation_alpha),
+            .z = lerp(first_rotations.z, second_rotations.z, rotation_alpha),
+            .w = lerp(first_rotations.w, second_rotations.w, rotation_alpha),
+        });
+
+        const vector_lanes_t first_translations = decode_translations(key_pairs.translation_values[0], key_pairs);
+        const vector_lanes_t second_translations = decode_translations(key_pairs.translation_values[1], key_pairs);
+
+        const __m256 translation_alpha = _mm256_load_ps(key_pairs.translation_alpha);
+        const vector_lanes_t translations = {
+            .x = lerp(first_translations.x, second_translations.x, translation_alpha),
+            .y = lerp(first_translations.y, second_translations.y, translation_alpha),
+            .z = lerp(first_translations.z, second_translations.z, translation_alpha),
+        };
+
+        // Lanes past the last joint get identity transforms (their translations are already 0).
+        const __m256 lane_mask =
+            _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<i32>(num_lanes)), lane_indices));
+        rotations = quaternion_lanes_t{
+            .x = _mm256_blendv_ps(identity_rotations.x, rotations.x, lane_mask),
+            .y = _mm256_blendv_ps(identity_rotations.y, rotations.y, lane_mask),
+            .z = _mm256_blendv_ps(identity_rotations.z, rotations.z, lane_mask),
+            .w = _mm256_blendv_ps(identity_rotations.w, rotations.w, lane_mask),
+        };
+
+        store_transforms(rotations, translations, pose[first_joint / joint_transform_soa_t::NUM_LANES]);
+    }
+}
+
+void blend_poses(const std::span<const pose_blend_layer_t> layers, const std::span<joint_transform_soa_t> result)
+{
+    f32 total_weight = 0.0f;
+    for (const pose_blend_layer_t &layer : layers)
+    {
+        total_weight += layer.weight;
+    }
+
+    if (total_weight <= 0.0f)
+    {
+        throw std::runtime_error(std::format("Can not blend poses with a total weight of {}", total_weight));
+    }
+
+    const f32 inverse_total_weight = 1.0f / total_weight;
+
+    for (size_t i = 0u; i < result.size(); i++)
+    {
+        const quaternion_lanes_t reference_rotations = load_rotations(layers[0].pose[i]);
+
+        quaternion_lanes_t rotations{};
+        vector_lanes_t translations{};
+        for (const pose_blend_layer_t &layer : layers)
+        {
+            const __m256 weight = _mm256_set1_ps(layer.weight * inverse_total_weight);
+            const quaternion_lanes_t layer_rotations =
+                flip_to_hemisphere(reference_rotations, load_rotations(layer.pose[i]));
+            const vector_lanes_t layer_translations = load_translations(layer.pose[i]);
+
+            rotations.x = _mm256_add_ps(rotations.x, _mm256_mul_ps(layer_rotations.x, weight));
+            rotations.y = _mm256_add_ps(rotations.y, _mm256_mul_ps(layer_rotations.y, weight));
+            rotations.z = _mm256_add_ps(rotations.z, _mm256_mul_ps(layer_rotations.z, weight));
+            rotations.w = _mm256_add_ps(rotations.w, _mm256_mul_ps(layer_rotations.w, weight));
+
+            translations.x = _mm256_add_ps(translations.x, _mm256_mul_ps(layer_translations.x, weight));
+            translations.y = _mm256_add_ps(translations.y, _mm256_mul_ps(layer_translations.y, weight));
+            translations.z = _mm256_add_ps(translations.z, _mm256_mul_ps(layer_translations.z, weight));
+        }
+
+        store_transforms(normalize(rotations), translations, result[i]);
+    }
+}
+
+void compute_model_matrices(const skeleton_t &skeleton, const std::span<const joint_transform_soa_t> local_pose,
+                            const std::span<float4x4_t> model_matrices)
+{
+    const u32 num_joints = skeleton.get_num_joints();
+
+    // Local matrices of 8 joints at once, written to model_matrices, which are then turned into model matrices in
+    // place (parents come before their children, so a parent's model matrix is ready when its children need it).
+    for (u32 first_joint = 0u; first_joint < num_joints; first_joint += joint_transform_soa_t::NUM_LANES)
+    {
+        const joint_transform_soa_t &transforms = local_pose[first_joint / joint_transform_soa_t::NUM_LANES];
+        const quaternion_lanes_t q = load_rotations(transforms);
+
+        const __m256 two = _mm256_set1_ps(2.0f);
+        const __m256 one = _mm256_set1_ps(1.0f);
+
+        const __m256 xx = _mm256_mul_ps(q.x, q.x);
+        const __m256 yy = _mm256_mul_ps(q.y, q.y);
+        const __m256 zz = _mm256_mul_ps(q.z, q.z);
+        const __m256 xy = _mm256_mul_ps(q.x, q.y);
+        const __m256 xz = _mm256_mul_ps(q.x, q.z);
+        const __m256 yz = _mm256_mul_ps(q.y, q.z);
+        const __m256 xw = _mm256_mul_ps(q.x, q.w);
+        const __m256 yw = _mm256_mul_ps(q.y, q.w);
+        const __m256 zw = _mm256_mul_ps(q.z, q.w);
+
+        alignas(32) f32 rotation_matrices[9][joint_transform_soa_t::NUM_LANES]{};
+        _mm256_store_ps(rotation_matrices[0], _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))));
+        _mm256_store_ps(rotation_matrices[1], _mm256_mul_ps(two, _mm256_add_ps(xy, zw)));
+        _mm256_store_ps(rotation_matrices[2], _mm256_mul_ps(two, _mm256_sub_ps(xz, yw)));
+        _mm256_store_ps(rotation_matrices[3], _mm256_mul_ps(two, _mm256_sub_ps(xy, zw)));
+        _mm256_store_ps(rotation_matrices[4], _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))));
+        _mm256_store_ps(rotation_matrices[5], _mm256_mul_ps(two, _mm256_add_ps(yz, xw)));
+        _mm256_store_ps(rotation_matrices[6], _mm256_mul_ps(two, _mm256_add_ps(xz, yw)));
+        _mm256_store_ps(rotation_matrices[7], _mm256_mul_ps(two, _mm256_sub_ps(yz, xw)));
+        _mm256_store_ps(rotation_matrices[8], _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))));
+
+        const u32 num_lanes = std::min(num_joints - first_joint, joint_transform_soa_t::NUM_LANES);
+        for (u32 lane = 0u; lane < num_lanes; lane++)
+        {
+            float4x4_t &matrix = model_matrices[first_joint + lane];
+            for (u32 row = 0u; row < 3u; row++)
+            {
+                matrix.m[row][0] = rotation_matrices[row * 3u + 0u][lane];
+                matrix.m[row][1] = rotation_matrices[row * 3u + 1u][lane];
+                matrix.m[row][2] = rotation_matrices[row * 3u + 2u][lane];
+                matrix.m[row][3] = 0.0f;
+            }
+            matrix.m[3][0] = transforms.translation_x[lane];
+            matrix.m[3][1] = transforms.translation_y[lane];
+            matrix.m[3][2] = transforms.translation_z[lane];
+            matrix.m[3][3] = 1.0f;
+        }
+    }
+
+    for (u32 i = 0u; i < num_joints; i++)
+    {
+        const u32 parent_index = skeleton.parent_indices[i];
+        if (parent_index != skeleton_t::INVALID_JOINT_INDEX)
+        {
+            multiply_matrices(model_matrices[i], model_matrices[parent_index], model_matrices[i]);
+        }
+    }
+}
+
+void compute_skinning_matrices(const skeleton_t &skeleton, const std::span<const float4x4_t> model_matrices,
+                               const float4x4_t &world_matrix, const std::span<float4x4_t> skinning_matrices)
+{
+    const u32 num_joints = skeleton.get_num_joints();
+    for (u32 i = 0u; i < num_joints; i++)
+    {
+        float4x4_t model_to_world_matrix{};
+        multiply_matrices(model_matrices[i], world_matrix, model_to_world_matrix);
+        multiply_matrices(skeleton.inverse_bind_matrices[i], model_to_world_matrix, skinning_matrices[i]);
+    }
+}
+
+joint_influence_t pack_joint_influence(const std::array<u32, 4> &joint_indices, const float4_t &joint_weights)
+{
+    const f32 weights[4] = {joint_weights.x, joint_weights.y, joint_weights.z, joint_weights.w};
+
+    f32 total_weight = 0.0f;
+    for (const f32 weight : weights)
+    {
+        total_weight += std::max(weight, 0.0f);
+    }
+
+    if (total_weight <= 0.0f)
+    {
+        throw std::runtime_error("Joint influence weights must have a positive sum");
+    }
+
+    // Quantize, then give the rounding error to the largest weight, so that the weights still sum to 1.
+    u32 quantized_weights[4]{};
+    u32 total_quantized_weight = 0u;
+    u32 largest_index = 0u;
+    for (u32 i = 0u; i < 4u; i++)
+    {
+        quantized_weights[i] = static_cast<u32>(std::round(std::max(weights[i], 0.0f) / total_weight * 255.0f));
+        total_quantized_weight += quantized_weights[i];
+        largest_index = weights[i] > weights[largest_index] ? i : largest_index;
+    }
+    quantized_weights[largest_index] += 255u - total_quantized_weight;
+
+    joint_influence_t result{};
+    for (u32 i = 0u; i < 4u; i++)
+    {
+        if (joint_indices[i] > 0xffu)
+        {
+            throw std::runtime_error(std::format("Joint index {} does not fit in 8 bits", joint_indices[i]));
+        }
+
+        result.joint_indices |= joint_indices[i] << (i * 8u);
+        result.joint_weights |= quantized_weights[i] << (i * 8u);
+    }
+
+    return result;
+}
+
+animation_statistics_t animate_characters(const skeleton_t &skeleton, const std::span<animated_character_t> characters,
+                                          const std::span<float4x4_t> skinning_matrices,
+                                          job_system_t *const job_system)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const u32 num_characters = static_cast<u32>(characters.size());
+    const u32 num_joints = skeleton.get_num_joints();
+    const u32 num_soa_transforms = get_num_soa_transforms(num_joints);
+
+    if (skinning_matrices.size() < static_cast<size_t>(num_characters) * num_joints)
+    {
+        throw std::runtime_error(std::format("{} skinning matrices can not hold {} characters with {} joints",
+                                             skinning_matrices.size(), num_characters, num_joints));
+    }
+
+    // Validated up front, so that a mismatched clip is reported before any character is animated.
+    for (const animated_character_t &character : characters)
+    {
+        for (u32 i = 0u; i < character.num_layers; i++)
+        {
+            const animation_clip_t *const clip = character.layers[i].clip;
+            if (clip && clip->num_joints != num_joints)
+            {
+                throw std::runtime_error(std::format("Animation clip with {} joints is played on a skeleton with {}",
+                                                     clip->num_joints, num_joints));
+            }
+        }
+    }
+
+    // The calling thread's scope outlives the jobs, which only read the bind pose.
+    memory::scratch_scope_t bind_pose_scope{};
+    joint_transform_soa_t *const bind_pose =
+        bind_pose_scope.get_arena().allocate_array<joint_transform_soa_t>(num_soa_transforms);
+    std::uninitialized_default_construct_n(bind_pose, num_soa_transforms);
+    for (u32 i = 0u; i < num_joints; i++)
+    {
+        set_joint_transform({bind_pose, num_soa_transforms}, i, skeleton.bind_pose[i]);
+    }
+
+    const auto animate = [&](const u32 begin, const u32 end, const u32) {
+        for (u32 i = begin; i < end; i++)
+        {
+            animated_character_t &character = characters[i];
+
+            memory::scratch_scope_t scope{};
+            memory::linear_arena_t &arena = scope.get_arena();
+
+            std::array<pose_blend_layer_t, MAX_ANIMATION_LAYERS> blend_layers{};
+            u32 num_blend_layers = 0u;
+            std::span<const joint_transform_soa_t> pose{bind_pose, num_soa_transforms};
+
+            for (u32 layer_index = 0u; layer_index < character.num_layers; layer_index++)
+            {
+                animation_layer_t &layer = character.layers[layer_index];
+                if (!layer.clip || layer.weight <= 0.0f)
+                {
+                    continue;
+                }
+
+                const std::span<joint_transform_soa_t> layer_pose = {
+                    arena.allocate_array<joint_transform_soa_t>(num_soa_transforms), num_soa_transforms};
+                sample_animation_clip(*layer.clip, layer.time_in_s, layer.sampling_context, layer_pose);
+
+                blend_layers[num_blend_layers++] = pose_blend_layer_t{layer_pose, layer.weight};
+            }
+
+            // A single layer is used as is, without blending.
+            if (num_blend_layers == 1u)
+            {
+                pose = blend_layers[0].pose;
+            }
+            else if (num_blend_layers > 1u)
+            {
+                const std::span<joint_transform_soa_t> blended_pose = {
+                    arena.allocate_array<joint_transform_soa_t>(num_soa_transforms), num_soa_transforms};
+                blend_poses({blend_layers.data(), num_blend_layers}, blended_pose);
+                pose = blended_pose;
+            }
+
+            const std::span<float4x4_t> model_matrices = {arena.allocate_array<float4x4_t>(num_joints), num_joints};
+            compute_model_matrices(skeleton, pose, model_matrices);
+            compute_skinning_matrices(skeleton, model_matrices, character.world_matrix,
+                                      skinning_matrices.subspan(static_cast<size_t>(i) * num_joints, num_joints));
+        }
+    };
+
+    if (job_system)
+    {
+        job_system->parallel_for(num_characters, 16u, animate);
+    }
+    else
+    {
+        animate(0u, num_characters, 0u);
+    }
+
+    return animation_statistics_t{
+        .num_characters = num_characters,
+        .num_skinning_matrices = num_characters * num_joints,
+        .animation_time_in_ms =
+            std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count(),
+    };
+}
+} // namespace nether
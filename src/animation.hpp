@@ -0,0 +1,243 @@
+#pragma once
+
+#include "common.hpp"
+#include "job_system.hpp"
+#include "math.hpp"
+
+// Skeletal animation : compressed clips, SoA pose sampling and blending, and skinning matrices.
+//  - Clips are compressed offline (or at load time) by compress_animation_clip : rotations are quantized with the
+//    smallest three encoding, translations relative to the range of their track, and keys that linear interpolation of
+//    their neighbours reproduces within the settings' error bounds are removed.
+//  - Poses are arrays of joint_transform_soa_t (8 joints each), so that sampling, blending and the conversion to
+//    matrices process 8 joints at once with AVX2.
+//  - compute_model_matrices walks the hierarchy from the roots, and compute_skinning_matrices writes the matrices the
+//    vertex shader reads (see shaders/skinned_mesh_shader.hlsl).
+// animate_characters runs the whole pipeline for many characters in parallel on the job system.
+// Matrices follow the row vector convention of math.hpp : a child's model matrix is local_matrix * parent_model_matrix.
+namespace nether
+{
+// A joint's transform relative to its parent. The rotation is a unit quaternion (x, y, z, w).
+struct joint_transform_t
+{
+    float4_t rotation{0.0f, 0.0f, 0.0f, 1.0f};
+    float3_t translation{};
+};
+
+// The transforms of 8 consecutive joints. The lanes past the last joint of a skeleton hold identity transforms.
+struct alignas(32) joint_transform_soa_t
+{
+    static constexpr u32 NUM_LANES = 8u;
+
+    f32 rotation_x[NUM_LANES]{};
+    f32 rotation_y[NUM_LANES]{};
+    f32 rotation_z[NUM_LANES]{};
+    f32 rotation_w[NUM_LANES]{1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+
+    f32 translation_x[NUM_LANES]{};
+    f32 translation_y[NUM_LANES]{};
+    f32 translation_z[NUM_LANES]{};
+};
+
+// Number of joint_transform_soa_t in the pose of a skeleton with num_joints joints.
+inline u32 get_num_soa_transforms(const u32 num_joints)
+{
+    return (num_joints + joint_transform_soa_t::NUM_LANES - 1u) / joint_transform_soa_t::NUM_LANES;
+}
+
+joint_transform_t get_joint_transform(const std::span<const joint_transform_soa_t> pose, const u32 joint_index);
+void set_joint_transform(const std::span<joint_transform_soa_t> pose, const u32 joint_index,
+                         const joint_transform_t &transform);
+
+// Same as XMMatrixAffineTransformation without scaling.
+float4x4_t get_joint_matrix(const joint_transform_t &transform);
+
+struct skeleton_t
+{
+    static constexpr u32 INVALID_JOINT_INDEX = ~0u;
+
+    u32 get_num_joints() const
+    {
+        return static_cast<u32>(parent_indices.size());
+    }
+
+    // A joint's parent always comes before it, so the hierarchy can be processed in a single pass.
+    std::vector<u32> parent_indices{};
+
+    // The pose the mesh was modelled in.
+    std::vector<joint_transform_t> bind_pose{};
+
+    // Inverse of the model space bind pose matrix of each joint : takes a (bind pose) vertex to the joint's space.
+    std::vector<float4x4_t> inverse_bind_matrices{};
+};
+
+// Throws if a joint's parent does not come before it.
+skeleton_t create_skeleton(const std::span<const u32> parent_indices,
+                           const std::span<const joint_transform_t> bind_pose);
+
+// Uncompressed clip, sampled at a fixed rate. The transform of joint j at frame f is samples[f * num_joints + j].
+struct raw_animation_clip_t
+{
+    f32 sample_rate{30.0f};
+    u32 num_frames{};
+    u32 num_joints{};
+
+    std::vector<joint_transform_t> samples{};
+};
+
+// Keys are removed as long as interpolating the remaining (quantized) keys stays within these errors of every
+// original sample. The bounds are per track : the error at the end of a chain of joints is bounded by the sum of the
+// rotation errors of its ancestors times their distance to the end.
+struct animation_compression_settings_t
+{
+    f32 max_rotation_error_in_radians{0.001f};
+    f32 max_translation_error{0.0001f};
+};
+
+// Smallest three encoding : the component with the largest magnitude is dropped (and made positive, since q and -q are
+// the same rotation), and the other three, which are in [-1 / sqrt(2), 1 / sqrt(2)], are stored with 15 bits each.
+// The index of the dropped component is stored in the top bits of the first two values.
+struct quantized_rotation_t
+{
+    u16 values[3]{};
+};
+
+// Each component relative to the range of its track, with 16 bits.
+struct quantized_translation_t
+{
+    u16 values[3]{};
+};
+
+struct translation_range_t
+{
+    float3_t min{};
+    float3_t extent{};
+};
+
+class animation_clip_t
+{
+  public:
+    f32 get_duration_in_s() const
+    {
+        return num_frames > 1u ? static_cast<f32>(num_frames - 1u) / sample_rate : 0.0f;
+    }
+
+    u32 get_num_rotation_keys() const
+    {
+        return static_cast<u32>(rotation_keys.size());
+    }
+
+    u32 get_num_translation_keys() const
+    {
+        return static_cast<u32>(translation_keys.size());
+    }
+
+    size_t get_size_in_bytes() const;
+
+  public:
+    f32 sample_rate{};
+    u32 num_frames{};
+    u32 num_joints{};
+
+    // The keys of joint j are [track_offsets[j], track_offsets[j + 1]), sorted by frame. Every track has a key on the
+    // first and the last frame.
+    std::vector<u32> rotation_track_offsets{};
+    std::vector<u16> rotation_key_frames{};
+    std::vector<quantized_rotation_t> rotation_keys{};
+
+    std::vector<u32> translation_track_offsets{};
+    std::vector<u16> translation_key_frames{};
+    std::vector<quantized_translation_t> translation_keys{};
+    std::vector<translation_range_t> translation_ranges{};
+};
+
+// Throws if the clip is empty, has more than 65536 frames, or does not have num_frames * num_joints samples.
+animation_clip_t compress_animation_clip(const raw_animation_clip_t &raw_clip,
+                                         const animation_compression_settings_t &settings = {});
+
+joint_transform_t sample_animation_clip_joint(const animation_clip_t &clip, const f32 time_in_s,
+                                              const u32 joint_index);
+
+// The keys each track was last sampled between. Playing a clip forward only moves the cursors by a few keys per
+// sample, instead of searching the keys of every track.
+class animation_sampling_context_t
+{
+  public:
+    void reset(const animation_clip_t &clip);
+
+  public:
+    const animation_clip_t *clip{};
+
+    std::vector<u32> rotation_cursors{};
+    std::vector<u32> translation_cursors{};
+};
+
+// Samples the clip at time_in_s (clamped to the clip's duration). The pose must have
+// get_num_soa_transforms(clip.num_joints) elements.
+void sample_animation_clip(const animation_clip_t &clip, const f32 time_in_s, animation_sampling_context_t &context,
+                           const std::span<joint_transform_soa_t> pose);
+
+struct pose_blend_layer_t
+{
+    std::span<const joint_transform_soa_t> pose{};
+    f32 weight{};
+};
+
+// Weighted average of the poses. Rotations are normalized linear interpolations, with each rotation flipped into the
+// hemisphere of the first layer's. The total weight must be positive (weights are normalized by their sum).
+void blend_poses(const std::span<const pose_blend_layer_t> layers, const std::span<joint_transform_soa_t> result);
+
+// Converts a local pose to model space matrices (joint to skeleton space).
+void compute_model_matrices(const skeleton_t &skeleton, const std::span<const joint_transform_soa_t> local_pose,
+                            const std::span<float4x4_t> model_matrices);
+
+// skinning_matrices[j] = inverse_bind_matrices[j] * model_matrices[j] * world_matrix, which takes a bind pose vertex
+// to world space. skinning_matrices is only written to, so it can be write combined upload memory.
+void compute_skinning_matrices(const skeleton_t &skeleton, const std::span<const float4x4_t> model_matrices,
+                               const float4x4_t &world_matrix, const std::span<float4x4_t> skinning_matrices);
+
+// Per vertex joint influences of a skinned mesh : 4 joint indices and 4 weights, 8 bits each. Must match
+// joint_influence_t in shaders/skinned_mesh_shader.hlsl.
+struct joint_influence_t
+{
+    u32 joint_indices{};
+    u32 joint_weights{};
+};
+
+// The weights are normalized, then quantized.
+joint_influence_t pack_joint_influence(const std::array<u32, 4> &joint_indices, const float4_t &joint_weights);
+
+static constexpr u32 MAX_ANIMATION_LAYERS = 4u;
+
+struct animation_layer_t
+{
+    const animation_clip_t *clip{};
+    f32 time_in_s{};
+    f32 weight{1.0f};
+
+    animation_sampling_context_t sampling_context{};
+};
+
+// An instance of a skeleton, whose pose is a blend of up to MAX_ANIMATION_LAYERS clips.
+struct animated_character_t
+{
+    std::array<animation_layer_t, MAX_ANIMATION_LAYERS> layers{};
+    u32 num_layers{};
+
+    float4x4_t world_matrix{identity_matrix()};
+};
+
+struct animation_statistics_t
+{
+    u32 num_characters{};
+    u32 num_skinning_matrices{};
+
+    f32 animation_time_in_ms{};
+};
+
+// Samples, blends and skins every character (in parallel over characters if job_system is not null). The skinning
+// matrices of character i are written to [i * num_joints, (i + 1) * num_joints) of skinning_matrices. Characters whose
+// layers all have a weight of 0 use the bind pose. Intermediate poses are allocated from the threads' scratch arenas.
+animation_statistics_t animate_characters(const skeleton_t &skeleton, const std::span<animated_character_t> characters,
+                                          const std::span<float4x4_t> skinning_matrices,
+                                          job_system_t *const job_system = nullptr);
+} // namespace nether
@@ -0,0 +1,660 @@
+#include "bvh.hpp"
+
+#include <atomic>
+
+namespace nether
+{
+struct bvh_t::build_context_t
+{
+    // Primitives are partitioned in place while building, so keep everything the build reads in one contiguous array
+    // instead of going through primitive_indices.
+    struct build_primitive_t
+    {
+        aabb_t bounds{};
+        float3_t center{};
+        u32 index{};
+    };
+
+    std::vector<build_primitive_t> build_primitives{};
+
+    // Preallocated for the worst case (2N - 1 nodes), so that parallel subtree builds can allocate nodes with a single
+    // atomic increment.
+    std::vector<build_node_t> build_nodes{};
+    std::atomic<u32> num_build_nodes{};
+
+    job_system_t *job_system{};
+};
+
+namespace
+{
+struct sah_bin_t
+{
+    aabb_t bounds{};
+    u32 count{};
+};
+
+struct node_bounds_t
+{
+    aabb_t bounds{};
+    aabb_t center_bounds{};
+};
+
+using sah_bins_t = std::array<std::array<sah_bin_t, bvh_t::NUM_SAH_BINS>, 3>;
+
+u32 get_bin_index(const f32 center, const f32 center_min, const f32 bin_scale)
+{
+    return std::min(static_cast<u32>((center - center_min) * bin_scale), bvh_t::NUM_SAH_BINS - 1u);
+}
+
+f32 get_component(const float3_t &vector, const u32 axis)
+{
+    return axis == 0u ? vector.x : (axis == 1u ? vector.y : vector.z);
+}
+} // namespace
+
+void bvh_t::build(const std::span<const aabb_t> primitive_bounds, job_system_t *const job_system)
+{
+    nodes.clear();
+    primitive_indices.resize(primitive_bounds.size());
+    ordered_primitive_bounds.resize(primitive_bounds.size());
+
+    if (primitive_bounds.empty())
+    {
+        return;
+    }
+
+    const u32 num_primitives = static_cast<u32>(primitive_bounds.size());
+
+    build_context_t build_context{};
+    build_context.build_primitives.resize(num_primitives);
+    build_context.build_nodes.resize(2u * num_primitives - 1u);
+    build_context.num_build_nodes = 1u;
+    build_context.job_system = job_system;
+
+    const auto setup_primitives = [&](const u32 begin, const u32 end, const u32) {
+        for (u32 i = begin; i < end; i++)
+        {
+            build_context.build_primitives[i] = {
+                .bounds = primitive_bounds[i],
+                .center = get_center(primitive_bounds[i]),
+                .index = i,
+            };
+        }
+    };
+
+    if (job_system)
+    {
+        job_system->parallel_for(num_primitives, PARALLEL_BUILD_THRESHOLD, setup_primitives);
+    }
+    else
+    {
+        setup_primitives(0u, num_primitives, 0u);
+    }
+
+    build_recursive(build_context, 0u, 0u, num_primitives);
+
+    // Collapse the binary tree into the 4 wide tree.
+    nodes.reserve(build_context.num_build_nodes / 2u + 1u);
+    collapse(build_context.build_nodes, 0u);
+
+    for (u32 i = 0u; i < num_primitives; i++)
+    {
+        primitive_indices[i] = build_context.build_primitives[i].index;
+        ordered_primitive_bounds[i] = build_context.build_primitives[i].bounds;
+    }
+}
+
+void bvh_t::build_recursive(build_context_t &build_context, const u32 build_node_index, const u32 begin,
+                            const u32 end)
+{
+    const u32 count = end - begin;
+
+    // Compute the bounds of the primitives and of their centers (the SAH bins are placed along the center bounds).
+    const auto compute_node_bounds = [&](const u32 range_begin, const u32 range_end) {
+        node_bounds_t node_bounds{};
+        for (u32 i = range_begin; i < range_end; i++)
+        {
+            node_bounds.bounds = merge(node_bounds.bounds, build_context.build_primitives[i].bounds);
+            node_bounds.center_bounds = merge(node_bounds.center_bounds, build_context.build_primitives[i].center);
+        }
+
+        return node_bounds;
+    };
+
+    const bool is_parallel = build_context.job_system && count > PARALLEL_BUILD_THRESHOLD;
+    const u32 num_batches = (count + PARALLEL_BUILD_THRESHOLD - 1u) / PARALLEL_BUILD_THRESHOLD;
+
+    node_bounds_t node_bounds{};
+    if (is_parallel)
+    {
+        std::vector<node_bounds_t> batch_node_bounds(num_batches);
+        build_context.job_system->parallel_for(count, PARALLEL_BUILD_THRESHOLD,
+                                               [&](const u32 batch_begin, const u32 batch_end, const u32) {
+                                                   batch_node_bounds[batch_begin / PARALLEL_BUILD_THRESHOLD] =
+                                                       compute_node_bounds(begin + batch_begin, begin + batch_end);
+                                               });
+
+        for (const node_bounds_t &batch : batch_node_bounds)
+        {
+            node_bounds.bounds = merge(node_bounds.bounds, batch.bounds);
+            node_bounds.center_bounds = merge(node_bounds.center_bounds, batch.center_bounds);
+        }
+    }
+    else
+    {
+        node_bounds = compute_node_bounds(begin, end);
+    }
+
+    build_node_t &build_node = build_context.build_nodes[build_node_index];
+    build_node.bounds = node_bounds.bounds;
+
+    const auto make_leaf = [&]() {
+        build_node.first_child_or_primitive = begin;
+        build_node.primitive_count = count;
+    };
+
+    if (count <= 2u)
+    {
+        make_leaf();
+        return;
+    }
+
+    const float3_t center_extent = node_bounds.center_bounds.max - node_bounds.center_bounds.min;
+
+    // Bin the primitive centers along all three axes, in a single pass over the primitives. Axes without extent end up
+    // with every primitive in the first bin, and are skipped when evaluating the SAH.
+    const float3_t center_min = node_bounds.center_bounds.min;
+    const float3_t bin_scale = {
+        center_extent.x > 0.0f ? NUM_SAH_BINS / center_extent.x : 0.0f,
+        center_extent.y > 0.0f ? NUM_SAH_BINS / center_extent.y : 0.0f,
+        center_extent.z > 0.0f ? NUM_SAH_BINS / center_extent.z : 0.0f,
+    };
+
+    const auto bin_primitives = [&](const u32 range_begin, const u32 range_end) {
+        sah_bins_t bins{};
+        for (u32 i = range_begin; i < range_end; i++)
+        {
+            const float3_t &center = build_context.build_primitives[i].center;
+            const aabb_t &bounds = build_context.build_primitives[i].bounds;
+
+            sah_bin_t &bin_x = bins[0][get_bin_index(center.x, center_min.x, bin_scale.x)];
+            bin_x.bounds = merge(bin_x.bounds, bounds);
+            bin_x.count++;
+
+            sah_bin_t &bin_y = bins[1][get_bin_index(center.y, center_min.y, bin_scale.y)];
+            bin_y.bounds = merge(bin_y.bounds, bounds);
+            bin_y.count++;
+
+            sah_bin_t &bin_z = bins[2][get_bin_index(center.z, center_min.z, bin_scale.z)];
+            bin_z.bounds = merge(bin_z.bounds, bounds);
+            bin_z.count++;
+        }
+
+        return bins;
+    };
+
+    sah_bins_t bins{};
+    if (is_parallel)
+    {
+        std::vector<sah_bins_t> batch_bins(num_batches);
+        build_context.job_system->parallel_for(count, PARALLEL_BUILD_THRESHOLD,
+                                               [&](const u32 batch_begin, const u32 batch_end, const u32) {
+                                                   batch_bins[batch_begin / PARALLEL_BUILD_THRESHOLD] =
+                                                       bin_primitives(begin + batch_begin, begin + batch_end);
+                                               });
+
+        for (const sah_bins_t &batch : batch_bins)
+        {
+            for (u32 axis = 0u; axis < 3u; axis++)
+            {
+                for (u32 bin_index = 0u; bin_index < NUM_SAH_BINS; bin_index++)
+                {
+                    bins[axis][bin_index].bounds =
+                        merge(bins[axis][bin_index].bounds, batch[axis][bin_index].bounds);
+                    bins[axis][bin_index].count += batch[axis][bin_index].count;
+                }
+            }
+        }
+    }
+    else
+    {
+        bins = bin_primitives(begin, end);
+    }
+
+    // Evaluate the SAH cost of splitting after each bin, with a sweep from both sides.
+    f32 best_cost = INFINITY;
+    u32 best_axis = 0u;
+    u32 best_split = 0u;
+
+    for (u32 axis = 0u; axis < 3u; axis++)
+    {
+        if (get_component(center_extent, axis) <= 0.0f)
+        {
+            continue;
+        }
+
+        std::array<f32, NUM_SAH_BINS> right_costs{};
+
+        aabb_t right_bounds{};
+        u32 right_count = 0u;
+        for (u32 bin_index = NUM_SAH_BINS - 1u; bin_index > 0u; bin_index--)
+        {
+            right_bounds = merge(right_bounds, bins[axis][bin_index].bounds);
+            right_count += bins[axis][bin_index].count;
+            right_costs[bin_index] = get_surface_area(right_bounds) * right_count;
+        }
+
+        aabb_t left_bounds{};
+        u32 left_count = 0u;
+        for (u32 split = 1u; split < NUM_SAH_BINS; split++)
+        {
+            left_bounds = merge(left_bounds, bins[axis][split - 1u].bounds);
+            left_count += bins[axis][split - 1u].count;
+
+            const f32 cost = get_surface_area(left_bounds) * left_count + right_costs[split];
+            if (left_count > 0u && left_count < count && cost < best_cost)
+            {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = split;
+            }
+        }
+    }
+
+    // The relative cost of traversing a node compared to intersecting a primitive.
+    constexpr f32 TRAVERSAL_COST = 1.0f;
+
+    const f32 leaf_cost = get_surface_area(node_bounds.bounds) * count;
+    const f32 split_cost = TRAVERSAL_COST * get_surface_area(node_bounds.bounds) + best_cost;
+
+    u32 middle = begin;
+    if (best_cost == INFINITY)
+    {
+        // All centers are at the same position, so SAH binning is not possible.
+        if (count <= MAX_LEAF_SIZE)
+        {
+            make_leaf();
+            return;
+        }
+
+        middle = begin + count / 2u;
+    }
+    else
+    {
+        if (count <= MAX_LEAF_SIZE && leaf_cost <= split_cost)
+        {
+            make_leaf();
+            return;
+        }
+
+        const f32 axis_center_min = get_component(center_min, best_axis);
+        const f32 axis_bin_scale = get_component(bin_scale, best_axis);
+
+        std::vector<build_context_t::build_primitive_t> &build_primitives = build_context.build_primitives;
+        middle = static_cast<u32>(
+            std::partition(build_primitives.begin() + begin, build_primitives.begin() + end,
+                           [&](const build_context_t::build_primitive_t &build_primitive) {
+                               return get_bin_index(get_component(build_primitive.center, best_axis), axis_center_min,
+                                                    axis_bin_scale) < best_split;
+                           }) -
+            build_primitives.begin());
+    }
+
+    const u32 first_child = build_context.num_build_nodes.fetch_add(2u, std::memory_order_relaxed);
+    build_node.first_child_or_primitive = first_child;
+    build_node.primitive_count = 0u;
+
+    if (is_parallel)
+    {
+        build_context.job_system->parallel_for(2u, 1u, [&](const u32 child, const u32, const u32) {
+            if (child == 0u)
+            {
+                build_recursive(build_context, first_child, begin, middle);
+            }
+            else
+            {
+                build_recursive(build_context, first_child + 1u, middle, end);
+            }
+        });
+    }
+    else
+    {
+        build_recursive(build_context, first_child, begin, middle);
+        build_recursive(build_context, first_child + 1u, middle, end);
+    }
+}
+
+u32 bvh_t::collapse(const std::vector<build_node_t> &build_nodes, const u32 build_node_index)
+{
+    const u32 node_index = static_cast<u32>(nodes.size());
+    nodes.emplace_back();
+
+    // Gather up to 4 children by repeatedly opening the interior child with the largest surface area.
+    std::array<u32, WIDTH> children{};
+    u32 num_children = 0u;
+
+    const build_node_t &build_node = build_nodes[build_node_index];
+    if (build_node.primitive_count > 0u)
+    {
+        // Only happens when the root itself is a leaf.
+        children[num_children++] = build_node_index;
+    }
+    else
+    {
+        children[num_children++] = build_node.first_child_or_primitive;
+        children[num_children++] = build_node.first_child_or_primitive + 1u;
+
+        while (num_children < WIDTH)
+        {
+            u32 best_child = WIDTH;
+            f32 best_surface_area = -1.0f;
+            for (u32 i = 0u; i < num_children; i++)
+            {
+                const build_node_t &child = build_nodes[children[i]];
+                if (child.primitive_count == 0u && get_surface_area(child.bounds) > best_surface_area)
+                {
+                    best_child = i;
+                    best_surface_area = get_surface_area(child.bounds);
+                }
+            }
+
+            if (best_child == WIDTH)
+            {
+                break;
+            }
+
+            const u32 opened_child = children[best_child];
+            children[best_child] = build_nodes[opened_child].first_child_or_primitive;
+            children[num_children++] = build_nodes[opened_child].first_child_or_primitive + 1u;
+        }
+    }
+
+    for (u32 child_slot = 0u; child_slot < WIDTH; child_slot++)
+    {
+        if (child_slot >= num_children)
+        {
+            set_child_bounds(nodes[node_index], child_slot, aabb_t{});
+            nodes[node_index].children[child_slot] = EMPTY_CHILD;
+            nodes[node_index].primitive_counts[child_slot] = 0u;
+
+            continue;
+        }
+
+        const build_node_t &child = build_nodes[children[child_slot]];
+        set_child_bounds(nodes[node_index], child_slot, child.bounds);
+
+        if (child.primitive_count > 0u)
+        {
+            nodes[node_index].children[child_slot] = LEAF_FLAG | child.first_child_or_primitive;
+            nodes[node_index].primitive_counts[child_slot] = child.primitive_count;
+        }
+        else
+        {
+            // nodes can be reallocated by the recursive call, so index into it again afterwards.
+            const u32 child_node_index = collapse(build_nodes, children[child_slot]);
+            nodes[node_index].children[child_slot] = child_node_index;
+            nodes[node_index].primitive_counts[child_slot] = 0u;
+        }
+    }
+
+    return node_index;
+}
+
+void bvh_t::refit(const std::span<const aabb_t> primitive_bounds, job_system_t *const job_system)
+{
+    if (primitive_bounds.size() != primitive_indices.size())
+    {
+        throw std::runtime_error("BVH refit requires the same number of primitives as the last build");
+    }
+
+    const u32 num_primitives = static_cast<u32>(primitive_indices.size());
+    const u32 num_nodes = static_cast<u32>(nodes.size());
+
+    // Leaves only depend on primitive bounds, so they can be refit in parallel.
+    const auto refit_leaves = [&](const u32 begin, const u32 end, const u32) {
+        for (u32 i = begin; i < end; i++)
+        {
+            ordered_primitive_bounds[i] = primitive_bounds[primitive_indices[i]];
+        }
+    };
+
+    const auto refit_leaf_nodes = [&](const u32 begin, const u32 end, const u32) {
+        for (u32 node_index = begin; node_index < end; node_index++)
+        {
+            node_t &node = nodes[node_index];
+            for (u32 child_slot = 0u; child_slot < WIDTH; child_slot++)
+            {
+                if (node.children[child_slot] == EMPTY_CHILD || !(node.children[child_slot] & LEAF_FLAG))
+                {
+                    continue;
+                }
+
+                const u32 first_primitive = node.children[child_slot] & ~LEAF_FLAG;
+
+                aabb_t bounds{};
+                for (u32 i = first_primitive; i < first_primitive + node.primitive_counts[child_slot]; i++)
+                {
+                    bounds = merge(bounds, ordered_primitive_bounds[i]);
+                }
+
+                set_child_bounds(node, child_slot, bounds);
+            }
+        }
+    };
+
+    if (job_system)
+    {
+        job_system->parallel_for(num_primitives, PARALLEL_BUILD_THRESHOLD, refit_leaves);
+        job_system->parallel_for(num_nodes, 1024u, refit_leaf_nodes);
+    }
+    else
+    {
+        refit_leaves(0u, num_primitives, 0u);
+        refit_leaf_nodes(0u, num_nodes, 0u);
+    }
+
+    // Children are always after their parents, so a reverse pass visits children before parents.
+    for (u32 node_index = num_nodes; node_index-- > 0u;)
+    {
+        node_t &node = nodes[node_index];
+        for (u32 child_slot = 0u; child_slot < WIDTH; child_slot++)
+        {
+            if (node.children[child_slot] == EMPTY_CHILD || (node.children[child_slot] & LEAF_FLAG))
+            {
+                continue;
+            }
+
+            const node_t &child = nodes[node.children[child_slot]];
+
+            aabb_t bounds{};
+            for (u32 i = 0u; i < WIDTH; i++)
+            {
+                bounds = merge(bounds, aabb_t{{child.min_x[i], child.min_y[i], child.min_z[i]},
+                                              {child.max_x[i], child.max_y[i], child.max_z[i]}});
+            }
+
+            set_child_bounds(node, child_slot, bounds);
+        }
+    }
+}
+
+void bvh_t::query_aabb(const aabb_t &aabb, std::vector<u32> &primitive_indices_result) const
+{
+    if (nodes.empty())
+    {
+        return;
+    }
+
+    const __m128 query_min_x = _mm_set1_ps(aabb.min.x);
+    const __m128 query_min_y = _mm_set1_ps(aabb.min.y);
+    const __m128 query_min_z = _mm_set1_ps(aabb.min.z);
+    const __m128 query_max_x = _mm_set1_ps(aabb.max.x);
+    const __m128 query_max_y = _mm_set1_ps(aabb.max.y);
+    const __m128 query_max_z = _mm_set1_ps(aabb.max.z);
+
+    std::array<u32, 256> stack{};
+    u32 stack_size = 0u;
+    stack[stack_size++] = 0u;
+
+    while (stack_size > 0u)
+    {
+        const node_t &node = nodes[stack[--stack_size]];
+
+        // Boxes overlap if they overlap on all three axes.
+        const __m128 overlap_x = _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node.min_x), query_max_x),
+                                            _mm_cmpge_ps(_mm_load_ps(node.max_x), query_min_x));
+        const __m128 overlap_y = _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node.min_y), query_max_y),
+                                            _mm_cmpge_ps(_mm_load_ps(node.max_y), query_min_y));
+        const __m128 overlap_z = _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node.min_z), query_max_z),
+                                            _mm_cmpge_ps(_mm_load_ps(node.max_z), query_min_z));
+
+        u32 overlap_mask = static_cast<u32>(_mm_movemask_ps(_mm_and_ps(overlap_x, _mm_and_ps(overlap_y, overlap_z))));
+
+        while (overlap_mask)
+        {
+            const u32 child_slot = static_cast<u32>(std::countr_zero(overlap_mask));
+            overlap_mask &= overlap_mask - 1u;
+
+            const u32 child = node.children[child_slot];
+            if (child & LEAF_FLAG)
+            {
+                const u32 first_primitive = child & ~LEAF_FLAG;
+                for (u32 i = first_primitive; i < first_primitive + node.primitive_counts[child_slot]; i++)
+                {
+                    if (overlaps(ordered_primitive_bounds[i], aabb))
+                    {
+                        primitive_indices_result.push_back(primitive_indices[i]);
+                    }
+                }
+            }
+            else
+            {
+                if (stack_size == stack.size())
+                {
+                    throw std::runtime_error("BVH traversal stack overflow");
+                }
+
+                stack[stack_size++] = child;
+            }
+        }
+    }
+}
+
+void bvh_t::query_frustum(const frustum_t &frustum, std::vector<u32> &primitive_indices_result) const
+{
+    if (nodes.empty())
+    {
+        return;
+    }
+
+    std::array<u32, 256> stack{};
+    u32 stack_size = 0u;
+    stack[stack_size++] = 0u;
+
+    while (stack_size > 0u)
+    {
+        const node_t &node = nodes[stack[--stack_size]];
+
+        // For each plane, test the corner of each box that is furthest along the plane normal. If it is behind the
+        // plane, the whole box is outside.
+        __m128 outside = _mm_setzero_ps();
+        for (const float4_t &plane : frustum.planes)
+        {
+            const __m128 x = _mm_load_ps(plane.x > 0.0f ? node.max_x : node.min_x);
+            const __m128 y = _mm_load_ps(plane.y > 0.0f ? node.max_y : node.min_y);
+            const __m128 z = _mm_load_ps(plane.z > 0.0f ? node.max_z : node.min_z);
+
+            const __m128 distance =
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+                           _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+        }
+
+        // Empty slots have inverted bounds, which are not caught by the plane test.
+        const __m128 is_empty = _mm_cmpgt_ps(_mm_load_ps(node.min_x), _mm_load_ps(node.max_x));
+
+        u32 inside_mask = static_cast<u32>(_mm_movemask_ps(_mm_or_ps(outside, is_empty))) ^ 0xfu;
+
+        while (inside_mask)
+        {
+            const u32 child_slot = static_cast<u32>(std::countr_zero(inside_mask));
+            inside_mask &= inside_mask - 1u;
+
+            const u32 child = node.children[child_slot];
+            if (child & LEAF_FLAG)
+            {
+                const u32 first_primitive = child & ~LEAF_FLAG;
+                for (u32 i = first_primitive; i < first_primitive + node.primitive_counts[child_slot]; i++)
+                {
+                    if (intersects(frustum, ordered_primitive_bounds[i]))
+                    {
+                        primitive_indices_result.push_back(primitive_indices[i]);
+                    }
+                }
+            }
+            else
+            {
+                if (stack_size == stack.size())
+                {
+                    throw std::runtime_error("BVH traversal stack overflow");
+                }
+
+                stack[stack_size++] = child;
+            }
+        }
+    }
+}
+
+ray_hit_t bvh_t::intersect_ray(const ray_t &ray) const
+{
+    const float3_t inverse_direction = {
+        internal::safe_inverse(ray.direction.x),
+        internal::safe_inverse(ray.direction.y),
+        internal::safe_inverse(ray.direction.z),
+    };
+
+    return intersect_ray_ordered(ray, [&](const u32 ordered_index, const ray_t &current_ray) {
+        const aabb_t &bounds = ordered_primitive_bounds[ordered_index];
+
+        const f32 tx0 = (bounds.min.x - current_ray.origin.x) * inverse_direction.x;
+        const f32 tx1 = (bounds.max.x - current_ray.origin.x) * inverse_direction.x;
+        const f32 ty0 = (bounds.min.y - current_ray.origin.y) * inverse_direction.y;
+        const f32 ty1 = (bounds.max.y - current_ray.origin.y) * inverse_direction.y;
+        const f32 tz0 = (bounds.min.z - current_ray.origin.z) * inverse_direction.z;
+        const f32 tz1 = (bounds.max.z - current_ray.origin.z) * inverse_direction.z;
+
+        const f32 entry = std::max({std::min(tx0, tx1), std::min(ty0, ty1), std::min(tz0, tz1), current_ray.t_min});
+        const f32 exit = std::min({std::max(tx0, tx1), std::max(ty0, ty1), std::max(tz0, tz1), current_ray.t_max});
+
+        return entry <= exit ? entry : INFINITY;
+    });
+}
+
+aabb_t bvh_t::get_bounds() const
+{
+    aabb_t bounds{};
+    if (nodes.empty())
+    {
+        return bounds;
+    }
+
+    for (u32 i = 0u; i < WIDTH; i++)
+    {
+        bounds = merge(bounds, aabb_t{{nodes[0].min_x[i], nodes[0].min_y[i], nodes[0].min_z[i]},
+                                      {nodes[0].max_x[i], nodes[0].max_y[i], nodes[0].max_z[i]}});
+    }
+
+    return bounds;
+}
+
+void bvh_t::set_child_bounds(node_t &node, const u32 child_slot, const aabb_t &bounds)
+{
+    node.min_x[child_slot] = bounds.min.x;
+    node.min_y[child_slot] = bounds.min.y;
+    node.min_z[child_slot] = bounds.min.z;
+    node.max_x[child_slot] = bounds.max.x;
+    node.max_y[child_slot] = bounds.max.y;
+    node.max_z[child_slot] = bounds.max.z;
+}
+} // namespace nether
@@ -0,0 +1,256 @@
+#pragma once
+
+#include "common.hpp"
+#include "job_system.hpp"
+#include "math.hpp"
+
+#include <bit>
+#include <immintrin.h>
+
+namespace nether
+{
+struct ray_t
+{
+    float3_t origin{};
+    float3_t direction{};
+
+    f32 t_min{0.0f};
+    f32 t_max{INFINITY};
+};
+
+struct ray_hit_t
+{
+    static constexpr u32 INVALID_PRIMITIVE = ~0u;
+
+    u32 primitive_index{INVALID_PRIMITIVE};
+    f32 t{INFINITY};
+};
+
+// A 4 wide bounding volume hierarchy over primitive bounds (objects, or triangles via a custom ray intersector).
+// The hierarchy is built as a binary tree with a binned SAH, where large nodes are split in parallel on the job system,
+// and is then collapsed into nodes with 4 children whose bounds are stored SoA so that all children of a node are
+// tested at once with SSE.
+// Children always come after their parent in the node array, which is what allows refit to run as a single reverse
+// pass over the nodes.
+class bvh_t
+{
+  public:
+    static constexpr u32 WIDTH = 4u;
+
+    static constexpr u32 NUM_SAH_BINS = 16u;
+    static constexpr u32 MAX_LEAF_SIZE = 8u;
+
+    // Nodes with more primitives than this are split (and binned) in parallel.
+    static constexpr u32 PARALLEL_BUILD_THRESHOLD = 16u * 1024u;
+
+    static constexpr u32 LEAF_FLAG = 1u << 31u;
+    static constexpr u32 EMPTY_CHILD = ~0u;
+
+    struct node_t
+    {
+        alignas(16) f32 min_x[WIDTH];
+        f32 min_y[WIDTH];
+        f32 min_z[WIDTH];
+        f32 max_x[WIDTH];
+        f32 max_y[WIDTH];
+        f32 max_z[WIDTH];
+
+        // Interior children store the index of the child node. Leaves store LEAF_FLAG | first primitive, where the
+        // first primitive is an index into primitive_indices.
+        u32 children[WIDTH];
+        u32 primitive_counts[WIDTH];
+    };
+
+    // The job system is optional, if null the build is single threaded.
+    void build(const std::span<const aabb_t> primitive_bounds, job_system_t *const job_system = nullptr);
+
+    // Updates the bounds of every node after primitives have moved, without changing the tree topology. The number of
+    // primitives must be the same as in the last build. Quality degrades as primitives move far from their original
+    // location, so rebuild occasionally.
+    void refit(const std::span<const aabb_t> primitive_bounds, job_system_t *const job_system = nullptr);
+
+    // Appends the index of every primitive whose bounds overlap the box.
+    void query_aabb(const aabb_t &aabb, std::vector<u32> &primitive_indices_result) const;
+
+    // Appends the index of every primitive whose bounds are not completely outside the frustum.
+    void query_frustum(const frustum_t &frustum, std::vector<u32> &primitive_indices_result) const;
+
+    // Finds the closest primitive hit by the ray. intersect_primitive(primitive_index, ray) must return the hit
+    // distance along the ray, or INFINITY for a miss. The ray's t_max is shortened as closer hits are found.
+    template <typename Fn> ray_hit_t intersect_ray(const ray_t &ray, Fn &&intersect_primitive) const
+    {
+        return intersect_ray_ordered(ray, [&](const u32 ordered_index, const ray_t &current_ray) {
+            return intersect_primitive(primitive_indices[ordered_index], current_ray);
+        });
+    }
+
+    // Closest hit against the primitive bounds themselves.
+    ray_hit_t intersect_ray(const ray_t &ray) const;
+
+    aabb_t get_bounds() const;
+
+  private:
+    struct build_node_t
+    {
+        aabb_t bounds{};
+
+        // Interior nodes have primitive_count == 0, and their children at first_child and first_child + 1.
+        u32 first_child_or_primitive{};
+        u32 primitive_count{};
+    };
+
+    struct build_context_t;
+
+    void build_recursive(build_context_t &build_context, const u32 build_node_index, const u32 begin, const u32 end);
+
+    u32 collapse(const std::vector<build_node_t> &build_nodes, const u32 build_node_index);
+
+    static void set_child_bounds(node_t &node, const u32 child_slot, const aabb_t &bounds);
+
+    // Same as intersect_ray, but intersect_primitive receives the primitive's index into the leaf ordered arrays.
+    template <typename Fn> ray_hit_t intersect_ray_ordered(ray_t ray, Fn &&intersect_primitive) const;
+
+  public:
+    std::vector<node_t> nodes{};
+
+    // Primitive indices in leaf order, and a copy of the primitive bounds in the same order (so that leaf tests read
+    // contiguous memory).
+    std::vector<u32> primitive_indices{};
+    std::vector<aabb_t> ordered_primitive_bounds{};
+};
+
+namespace internal
+{
+// 4 wide ray vs box slab test. Returns a 4 bit mask of the children that are hit, and writes the entry distances.
+inline u32 intersect_ray_node(const bvh_t::node_t &node, const __m128 origin[3], const __m128 inverse_direction[3],
+                              const f32 t_min, const f32 t_max, f32 entry_distances[bvh_t::WIDTH])
+{
+    const __m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.min_x), origin[0]), inverse_direction[0]);
+    const __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.max_x), origin[0]), inverse_direction[0]);
+    const __m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.min_y), origin[1]), inverse_direction[1]);
+    const __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.max_y), origin[1]), inverse_direction[1]);
+    const __m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.min_z), origin[2]), inverse_direction[2]);
+    const __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.max_z), origin[2]), inverse_direction[2]);
+
+    const __m128 entry = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)),
+                                    _mm_max_ps(_mm_min_ps(tz0, tz1), _mm_set1_ps(t_min)));
+    const __m128 exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)),
+                                   _mm_min_ps(_mm_max_ps(tz0, tz1), _mm_set1_ps(t_max)));
+
+    _mm_storeu_ps(entry_distances, entry);
+
+    return static_cast<u32>(_mm_movemask_ps(_mm_cmple_ps(entry, exit)));
+}
+
+// Zero direction components are replaced by a tiny value, so that the slab test never computes 0 * infinity.
+inline f32 safe_inverse(const f32 value)
+{
+    return 1.0f / (std::abs(value) > 1e-20f ? value : std::copysign(1e-20f, value));
+}
+
+inline void setup_ray(const ray_t &ray, __m128 origin[3], __m128 inverse_direction[3])
+{
+    origin[0] = _mm_set1_ps(ray.origin.x);
+    origin[1] = _mm_set1_ps(ray.origin.y);
+    origin[2] = _mm_set1_ps(ray.origin.z);
+
+    inverse_direction[0] = _mm_set1_ps(safe_inverse(ray.direction.x));
+    inverse_direction[1] = _mm_set1_ps(safe_inverse(ray.direction.y));
+    inverse_direction[2] = _mm_set1_ps(safe_inverse(ray.direction.z));
+}
+} // namespace internal
+
+template <typename Fn> ray_hit_t bvh_t::intersect_ray_ordered(ray_t ray, Fn &&intersect_primitive) const
+{
+    ray_hit_t result{};
+
+    if (nodes.empty())
+    {
+        return result;
+    }
+
+    __m128 origin[3]{};
+    __m128 inverse_direction[3]{};
+    internal::setup_ray(ray, origin, inverse_direction);
+
+    // Each stack entry is a node index, along with the entry distance of the ray into it (so that nodes that are
+    // further away than the closest hit found after they were pushed can be skipped).
+    struct stack_entry_t
+    {
+        u32 node_index{};
+        f32 entry_distance{};
+    };
+
+    std::array<stack_entry_t, 256> stack{};
+    u32 stack_size = 0u;
+
+    stack[stack_size++] = {0u, ray.t_min};
+
+    while (stack_size > 0u)
+    {
+        const stack_entry_t stack_entry = stack[--stack_size];
+        if (stack_entry.entry_distance > ray.t_max)
+        {
+            continue;
+        }
+
+        const node_t &node = nodes[stack_entry.node_index];
+
+        f32 entry_distances[WIDTH]{};
+        u32 hit_mask = internal::intersect_ray_node(node, origin, inverse_direction, ray.t_min, ray.t_max,
+                                                    entry_distances);
+
+        // Children to push, sorted so that the closest child ends up at the top of the stack.
+        std::array<stack_entry_t, WIDTH> interior_children{};
+        u32 num_interior_children = 0u;
+
+        while (hit_mask)
+        {
+            const u32 child_slot = static_cast<u32>(std::countr_zero(hit_mask));
+            hit_mask &= hit_mask - 1u;
+
+            const u32 child = node.children[child_slot];
+            if (child & LEAF_FLAG)
+            {
+                const u32 first_primitive = child & ~LEAF_FLAG;
+                for (u32 i = first_primitive; i < first_primitive + node.primitive_counts[child_slot]; i++)
+                {
+                    const f32 t = intersect_primitive(i, ray);
+                    if (t >= ray.t_min && t < ray.t_max)
+                    {
+                        ray.t_max = t;
+                        result = {
+                            .primitive_index = primitive_indices[i],
+                            .t = t,
+                        };
+                    }
+                }
+            }
+            else
+            {
+                u32 insert_position = num_interior_children++;
+                while (insert_position > 0u &&
+                       interior_children[insert_position - 1u].entry_distance < entry_distances[child_slot])
+                {
+                    interior_children[insert_position] = interior_children[insert_position - 1u];
+                    insert_position--;
+                }
+
+                interior_children[insert_position] = {child, entry_distances[child_slot]};
+            }
+        }
+
+        if (stack_size + num_interior_children > stack.size())
+        {
+            throw std::runtime_error("BVH traversal stack overflow");
+        }
+
+        for (u32 i = 0u; i < num_interior_children; i++)
+        {
+            stack[stack_size++] = interior_children[i];
+        }
+    }
+
+    return result;
+}
+} // namespace nether
@@ -0,0 +1,408 @@
+#include "clustered_lighting.hpp"
+
+#include <bit>
+#include <chrono>
+#include <immintrin.h>
+
+namespace nether
+{
+namespace
+{
+u32 round_up_to_multiple_of_8(const u32 value)
+{
+    return (value + 7u) & ~7u;
+}
+
+// Sphere vs box for 8 spheres : compares the squared distance from each center to the closest point of the box with
+// the squared radius.
+__m256 test_spheres_against_box(const __m256 center_x, const __m256 center_y, const __m256 center_z,
+                                const __m256 radius, const aabb_t &bounds)
+{
+    const __m256 zero = _mm256_setzero_ps();
+
+    const __m256 distance_x = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_set1_ps(bounds.min.x), center_x),
+                                                          _mm256_sub_ps(center_x, _mm256_set1_ps(bounds.max.x))),
+                                            zero);
+    const __m256 distance_y = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_set1_ps(bounds.min.y), center_y),
+                                                          _mm256_sub_ps(center_y, _mm256_set1_ps(bounds.max.y))),
+                                            zero);
+    const __m256 distance_z = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_set1_ps(bounds.min.z), center_z),
+                                                          _mm256_sub_ps(center_z, _mm256_set1_ps(bounds.max.z))),
+                                            zero);
+
+    const __m256 squared_distance = _mm256_add_ps(
+        _mm256_add_ps(_mm256_mul_ps(distance_x, distance_x), _mm256_mul_ps(distance_y, distance_y)),
+        _mm256_mul_ps(distance_z, distance_z));
+
+    return _mm256_cmp_ps(squared_distance, _mm256_mul_ps(radius, radius), _CMP_LE_OQ);
+}
+} // namespace
+
+void light_cluster_builder_t::light_soa_t::resize(const u32 size)
+{
+    position_x.resize(size);
+    position_y.resize(size);
+    position_z.resize(size);
+    range.resize(size);
+
+    direction_x.resize(size);
+    direction_y.resize(size);
+    direction_z.resize(size);
+    cos_outer_angle.resize(size);
+    sin_outer_angle.resize(size);
+
+    is_spot.resize(size);
+
+    light_index.resize(size);
+}
+
+void light_cluster_builder_t::light_soa_t::set_empty(const u32 index)
+{
+    // The distance from an infinitely far away light to any box is infinite, so the sphere test always fails.
+    position_x[index] = INFINITY;
+    position_y[index] = INFINITY;
+    position_z[index] = INFINITY;
+    range[index] = 0.0f;
+
+    direction_x[index] = 0.0f;
+    direction_y[index] = 0.0f;
+    direction_z[index] = 1.0f;
+    cos_outer_angle[index] = 1.0f;
+    sin_outer_angle[index] = 0.0f;
+
+    is_spot[index] = 0.0f;
+
+    light_index[index] = ~0u;
+}
+
+void light_cluster_builder_t::light_soa_t::copy(const u32 index, const light_soa_t &source, const u32 source_index)
+{
+    position_x[index] = source.position_x[source_index];
+    position_y[index] = source.position_y[source_index];
+    position_z[index] = source.position_z[source_index];
+    range[index] = source.range[source_index];
+
+    direction_x[index] = source.direction_x[source_index];
+    direction_y[index] = source.direction_y[source_index];
+    direction_z[index] = source.direction_z[source_index];
+    cos_outer_angle[index] = source.cos_outer_angle[source_index];
+    sin_outer_angle[index] = source.sin_outer_angle[source_index];
+
+    is_spot[index] = source.is_spot[source_index];
+
+    light_index[index] = source.light_index[source_index];
+}
+
+light_cluster_builder_t::light_cluster_builder_t(const u32 num_clusters_x, const u32 num_clusters_y,
+                                                 const u32 num_clusters_z)
+    : num_clusters_x(num_clusters_x), num_clusters_y(num_clusters_y), num_clusters_z(num_clusters_z)
+{
+    if (num_clusters_x == 0u || num_clusters_y == 0u || num_clusters_z == 0u)
+    {
+        throw std::runtime_error("The cluster grid must have at least one cluster along each axis");
+    }
+
+    clusters.resize(get_num_clusters());
+    cluster_bounds.resize(get_num_clusters());
+    cluster_spheres.resize(get_num_clusters());
+    depth_slices.resize(num_clusters_z);
+}
+
+void light_cluster_builder_t::set_projection(const f32 x_scale, const f32 y_scale, const f32 near_plane,
+                                             const f32 max_depth)
+{
+    if (near_plane <= 0.0f || max_depth <= near_plane)
+    {
+        throw std::runtime_error("The cluster grid's max depth must be further than the near plane");
+    }
+
+    this->near_plane = near_plane;
+    this->max_depth = max_depth;
+
+    // Slice k starts at near_plane * (max_depth / near_plane) ^ (k / num_clusters_z), so that each cluster is roughly
+    // as deep as it is wide.
+    depth_slice_scale = num_clusters_z / std::log2(max_depth / near_plane);
+    depth_slice_bias = -depth_slice_scale * std::log2(near_plane);
+
+    const auto get_slice_depth = [&](const u32 slice) {
+        return near_plane * std::pow(max_depth / near_plane, static_cast<f32>(slice) / num_clusters_z);
+    };
+
+    for (u32 z = 0u; z < num_clusters_z; z++)
+    {
+        const f32 slice_near = get_slice_depth(z);
+        const f32 slice_far = get_slice_depth(z + 1u);
+
+        for (u32 y = 0u; y < num_clusters_y; y++)
+        {
+            // Tile rows go from the top of the screen to the bottom.
+            const f32 ndc_y_top = 1.0f - 2.0f * y / num_clusters_y;
+            const f32 ndc_y_bottom = 1.0f - 2.0f * (y + 1u) / num_clusters_y;
+
+            for (u32 x = 0u; x < num_clusters_x; x++)
+            {
+                const f32 ndc_x_left = 2.0f * x / num_clusters_x - 1.0f;
+                const f32 ndc_x_right = 2.0f * (x + 1u) / num_clusters_x - 1.0f;
+
+                aabb_t bounds{};
+                for (const f32 depth : {slice_near, slice_far})
+                {
+                    bounds = merge(bounds, float3_t{ndc_x_left * depth / x_scale, ndc_y_top * depth / y_scale, depth});
+                    bounds = merge(bounds,
+                                   float3_t{ndc_x_right * depth / x_scale, ndc_y_bottom * depth / y_scale, depth});
+                }
+
+                const u32 cluster_index = get_cluster_index(x, y, z);
+                const float3_t center = get_center(bounds);
+
+                cluster_bounds[cluster_index] = bounds;
+                cluster_spheres[cluster_index] = {center.x, center.y, center.z, length(bounds.max - center)};
+            }
+        }
+    }
+}
+
+void light_cluster_builder_t::build(const std::span<const light_t> lights, const float4x4_t &view_matrix,
+                                    job_system_t *const job_system)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    num_lights = static_cast<u32>(lights.size());
+
+    const u32 num_padded_lights = round_up_to_multiple_of_8(num_lights);
+    view_space_lights.resize(num_padded_lights);
+
+    const auto transform_lights = [&](const u32 begin, const u32 end, const u32) {
+        for (u32 i = begin; i < end; i++)
+        {
+            const light_t &light = lights[i];
+
+            const float4_t position = transform_point(light.position, view_matrix);
+            const float3_t direction = {
+                light.direction.x * view_matrix.m[0][0] + light.direction.y * view_matrix.m[1][0] +
+                    light.direction.z * view_matrix.m[2][0],
+                light.direction.x * view_matrix.m[0][1] + light.direction.y * view_matrix.m[1][1] +
+                    light.direction.z * view_matrix.m[2][1],
+                light.direction.x * view_matrix.m[0][2] + light.direction.y * view_matrix.m[1][2] +
+                    light.direction.z * view_matrix.m[2][2],
+            };
+
+            const bool is_spot = light.type == light_type_t::spot;
+            const f32 cos_outer_angle = is_spot ? std::clamp(light.spot_cos_outer_angle, -1.0f, 1.0f) : -1.0f;
+
+            view_space_lights.position_x[i] = position.x;
+            view_space_lights.position_y[i] = position.y;
+            view_space_lights.position_z[i] = position.z;
+            view_space_lights.range[i] = light.range;
+
+            view_space_lights.direction_x[i] = direction.x;
+            view_space_lights.direction_y[i] = direction.y;
+            view_space_lights.direction_z[i] = direction.z;
+            view_space_lights.cos_outer_angle[i] = cos_outer_angle;
+            view_space_lights.sin_outer_angle[i] = std::sqrt(1.0f - cos_outer_angle * cos_outer_angle);
+
+            view_space_lights.is_spot[i] = std::bit_cast<f32>(is_spot ? ~0u : 0u);
+
+            view_space_lights.light_index[i] = i;
+        }
+    };
+
+    for (u32 i = num_lights; i < num_padded_lights; i++)
+    {
+        view_space_lights.set_empty(i);
+    }
+
+    if (job_system)
+    {
+        job_system->parallel_for(num_lights, 1024u, transform_lights);
+        job_system->parallel_for(num_clusters_z, 1u, [&](const u32 begin, const u32 end, const u32) {
+            for (u32 i = begin; i < end; i++)
+            {
+                bin_depth_slice(i);
+            }
+        });
+    }
+    else
+    {
+        transform_lights(0u, num_lights, 0u);
+        for (u32 i = 0u; i < num_clusters_z; i++)
+        {
+            bin_depth_slice(i);
+        }
+    }
+
+    // Merge the light index lists of the slices. Cluster offsets are relative to their slice's list until now.
+    statistics = {};
+    light_indices.clear();
+
+    const u32 num_clusters_per_slice = num_clusters_x * num_clusters_y;
+    for (u32 z = 0u; z < num_clusters_z; z++)
+    {
+        const depth_slice_t &depth_slice = depth_slices[z];
+        const u32 slice_offset = static_cast<u32>(light_indices.size());
+
+        for (u32 i = 0u; i < num_clusters_per_slice; i++)
+        {
+            clusters[z * num_clusters_per_slice + i].offset += slice_offset;
+        }
+
+        light_indices.insert(light_indices.end(), depth_slice.light_indices.begin(), depth_slice.light_indices.end());
+
+        statistics.max_lights_per_cluster =
+            std::max(statistics.max_lights_per_cluster, depth_slice.max_lights_per_cluster);
+        statistics.num_dropped_light_indices += depth_slice.num_dropped_light_indices;
+    }
+
+    statistics.num_lights = num_lights;
+    statistics.num_light_indices = static_cast<u32>(light_indices.size());
+    statistics.binning_time_in_ms =
+        std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+u32 light_cluster_builder_t::gather_overlapping_lights(const light_soa_t &source, const aabb_t &bounds,
+                                                       light_soa_t &destination)
+{
+    const u32 num_source_lights = static_cast<u32>(source.position_x.size());
+    destination.resize(num_source_lights);
+
+    u32 num_lights = 0u;
+    for (u32 i = 0u; i < num_source_lights; i += 8u)
+    {
+        const __m256 overlaps = test_spheres_against_box(
+            _mm256_loadu_ps(&source.position_x[i]), _mm256_loadu_ps(&source.position_y[i]),
+            _mm256_loadu_ps(&source.position_z[i]), _mm256_loadu_ps(&source.range[i]), bounds);
+
+        u32 mask = static_cast<u32>(_mm256_movemask_ps(overlaps));
+        while (mask)
+        {
+            destination.copy(num_lights++, source, i + std::countr_zero(mask));
+            mask &= mask - 1u;
+        }
+    }
+
+    const u32 num_padded_lights = round_up_to_multiple_of_8(num_lights);
+    for (u32 i = num_lights; i < num_padded_lights; i++)
+    {
+        destination.set_empty(i);
+    }
+
+    // Shrinking never reallocates, and keeps the padded size visible to the next gather.
+    destination.resize(num_padded_lights);
+
+    return num_padded_lights;
+}
+
+void light_cluster_builder_t::bin_depth_slice(const u32 slice_index)
+{
+    depth_slice_t &depth_slice = depth_slices[slice_index];
+    depth_slice.light_indices.clear();
+    depth_slice.max_lights_per_cluster = 0u;
+    depth_slice.num_dropped_light_indices = 0u;
+
+    // Narrow down the lights to test against each cluster, first to the ones that overlap the slice, and then to the
+    // ones that overlap each row of clusters.
+    const u32 num_candidate_lights = gather_overlapping_lights(
+        view_space_lights,
+        merge(cluster_bounds[get_cluster_index(0u, 0u, slice_index)],
+              cluster_bounds[get_cluster_index(num_clusters_x - 1u, num_clusters_y - 1u, slice_index)]),
+        depth_slice.candidate_lights);
+
+    const light_soa_t &row_candidate_lights = depth_slice.row_candidate_lights;
+
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (u32 y = 0u; y < num_clusters_y; y++)
+    {
+        const u32 num_row_candidate_lights =
+            num_candidate_lights == 0u
+                ? 0u
+                : gather_overlapping_lights(
+                      depth_slice.candidate_lights,
+                      merge(cluster_bounds[get_cluster_index(0u, y, slice_index)],
+                            cluster_bounds[get_cluster_index(num_clusters_x - 1u, y, slice_index)]),
+                      depth_slice.row_candidate_lights);
+
+        for (u32 x = 0u; x < num_clusters_x; x++)
+        {
+            const u32 cluster_index = get_cluster_index(x, y, slice_index);
+            const aabb_t &bounds = cluster_bounds[cluster_index];
+            const float4_t &sphere = cluster_spheres[cluster_index];
+
+            const __m256 sphere_x = _mm256_set1_ps(sphere.x);
+            const __m256 sphere_y = _mm256_set1_ps(sphere.y);
+            const __m256 sphere_z = _mm256_set1_ps(sphere.z);
+            const __m256 sphere_radius = _mm256_set1_ps(sphere.w);
+
+            const u32 cluster_offset = static_cast<u32>(depth_slice.light_indices.size());
+            u32 cluster_light_count = 0u;
+
+            for (u32 i = 0u; i < num_row_candidate_lights; i += 8u)
+            {
+                const __m256 position_x = _mm256_loadu_ps(&row_candidate_lights.position_x[i]);
+                const __m256 position_y = _mm256_loadu_ps(&row_candidate_lights.position_y[i]);
+                const __m256 position_z = _mm256_loadu_ps(&row_candidate_lights.position_z[i]);
+                const __m256 range = _mm256_loadu_ps(&row_candidate_lights.range[i]);
+
+                const __m256 inside_range =
+                    test_spheres_against_box(position_x, position_y, position_z, range, bounds);
+
+                // Cone vs sphere (against the cluster's bounding sphere), from "Cull that cone" by Bart Wronski. v is
+                // the vector from the light to the sphere's center, v_length_along_axis its projection on the cone's
+                // axis.
+                const __m256 v_x = _mm256_sub_ps(sphere_x, position_x);
+                const __m256 v_y = _mm256_sub_ps(sphere_y, position_y);
+                const __m256 v_z = _mm256_sub_ps(sphere_z, position_z);
+
+                const __m256 v_squared_length =
+                    _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(v_x, v_x), _mm256_mul_ps(v_y, v_y)),
+                                  _mm256_mul_ps(v_z, v_z));
+                const __m256 v_length_along_axis = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(v_x, _mm256_loadu_ps(&row_candidate_lights.direction_x[i])),
+                                  _mm256_mul_ps(v_y, _mm256_loadu_ps(&row_candidate_lights.direction_y[i]))),
+                    _mm256_mul_ps(v_z, _mm256_loadu_ps(&row_candidate_lights.direction_z[i])));
+
+                // Distance from the sphere's center to the closest point of the cone's surface.
+                const __m256 v_length_from_axis = _mm256_sqrt_ps(_mm256_max_ps(
+                    _mm256_sub_ps(v_squared_length, _mm256_mul_ps(v_length_along_axis, v_length_along_axis)), zero));
+                const __m256 cos_outer_angle = _mm256_loadu_ps(&row_candidate_lights.cos_outer_angle[i]);
+                const __m256 sin_outer_angle = _mm256_loadu_ps(&row_candidate_lights.sin_outer_angle[i]);
+                const __m256 distance_to_cone = _mm256_sub_ps(_mm256_mul_ps(cos_outer_angle, v_length_from_axis),
+                                                              _mm256_mul_ps(v_length_along_axis, sin_outer_angle));
+
+                const __m256 inside_cone = _mm256_and_ps(
+                    _mm256_and_ps(_mm256_cmp_ps(distance_to_cone, sphere_radius, _CMP_LE_OQ),
+                                  _mm256_cmp_ps(v_length_along_axis, _mm256_add_ps(sphere_radius, range), _CMP_LE_OQ)),
+                    _mm256_cmp_ps(v_length_along_axis, _mm256_sub_ps(zero, sphere_radius), _CMP_GE_OQ));
+
+                // Spot lights must pass both tests, point lights only the sphere test.
+                const __m256 culled_spot_light =
+                    _mm256_andnot_ps(inside_cone, _mm256_loadu_ps(&row_candidate_lights.is_spot[i]));
+                const __m256 visible = _mm256_andnot_ps(culled_spot_light, inside_range);
+
+                u32 mask = static_cast<u32>(_mm256_movemask_ps(visible));
+                while (mask)
+                {
+                    const u32 light_index = row_candidate_lights.light_index[i + std::countr_zero(mask)];
+                    mask &= mask - 1u;
+
+                    if (cluster_light_count == MAX_LIGHTS_PER_CLUSTER)
+                    {
+                        depth_slice.num_dropped_light_indices++;
+                        continue;
+                    }
+
+                    depth_slice.light_indices.push_back(light_index);
+                    cluster_light_count++;
+                }
+            }
+
+            clusters[cluster_index] = {
+                .offset = cluster_offset,
+                .count = cluster_light_count,
+            };
+
+            depth_slice.max_lights_per_cluster = std::max(depth_slice.max_lights_per_cluster, cluster_light_count);
+        }
+    }
+}
+} // namespace nether
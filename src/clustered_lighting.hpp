@@ -0,0 +1,177 @@
+#pragma once
+
+#include "common.hpp"
+#include "job_system.hpp"
+#include "math.hpp"
+
+namespace nether
+{
+enum class light_type_t : u32
+{
+    point,
+    spot,
+};
+
+// A world space light, as read by the shaders. Must match light_t in shaders/common.hlsli.
+struct light_t
+{
+    float3_t position{};
+    f32 range{};
+
+    // Already multiplied by the light's intensity.
+    float3_t color{};
+    light_type_t type{light_type_t::point};
+
+    // Spot lights only. The direction must be normalized.
+    float3_t direction{0.0f, 0.0f, 1.0f};
+    f32 spot_cos_outer_angle{};
+    f32 spot_cos_inner_angle{};
+
+    f32 padding[3]{};
+};
+
+// The range of a cluster's lights in the light index list. Must match light_cluster_t in shaders/common.hlsli.
+struct light_cluster_t
+{
+    u32 offset{};
+    u32 count{};
+};
+
+struct clustered_lighting_statistics_t
+{
+    u32 num_lights{};
+    u32 num_light_indices{};
+    u32 max_lights_per_cluster{};
+
+    // Light indices that did not fit in a cluster (see light_cluster_builder_t::MAX_LIGHTS_PER_CLUSTER).
+    u32 num_dropped_light_indices{};
+
+    f32 binning_time_in_ms{};
+};
+
+// Bins lights into the clusters of the view frustum for clustered forward shading.
+// The frustum is split into a grid of screen space tiles, and exponentially distributed depth slices between the near
+// plane and max_depth (the projection has an infinite far plane, so the grid has to stop somewhere : geometry beyond
+// max_depth uses the last slice, and lights entirely beyond it are not binned).
+// Binning runs in parallel over depth slices. Each slice first gathers the lights that overlap its depth range, and
+// then tests them 8 at a time (AVX2) against every cluster of the slice : a sphere vs box test for all lights, and an
+// additional cone vs sphere test for spot lights.
+// The result is a light_cluster_t per cluster, and a compact light index list that the clusters point into.
+class light_cluster_builder_t
+{
+  public:
+    static constexpr u32 DEFAULT_NUM_CLUSTERS_X = 16u;
+    static constexpr u32 DEFAULT_NUM_CLUSTERS_Y = 9u;
+    static constexpr u32 DEFAULT_NUM_CLUSTERS_Z = 24u;
+
+    static constexpr u32 MAX_LIGHTS_PER_CLUSTER = 128u;
+
+    light_cluster_builder_t(const u32 num_clusters_x = DEFAULT_NUM_CLUSTERS_X,
+                            const u32 num_clusters_y = DEFAULT_NUM_CLUSTERS_Y,
+                            const u32 num_clusters_z = DEFAULT_NUM_CLUSTERS_Z);
+
+    // Recomputes the view space bounds of the clusters. x_scale and y_scale are the projection matrix's [0][0] and
+    // [1][1] entries (i.e x_ndc = x_view * x_scale / z_view).
+    void set_projection(const f32 x_scale, const f32 y_scale, const f32 near_plane, const f32 max_depth);
+
+    // Bins the (world space) lights. The view matrix transforms world space to the left handed view space used by the
+    // projection (+z forward).
+    void build(const std::span<const light_t> lights, const float4x4_t &view_matrix,
+               job_system_t *const job_system = nullptr);
+
+    u32 get_num_clusters() const
+    {
+        return num_clusters_x * num_clusters_y * num_clusters_z;
+    }
+
+    u32 get_cluster_index(const u32 x, const u32 y, const u32 z) const
+    {
+        return (z * num_clusters_y + y) * num_clusters_x + x;
+    }
+
+    // depth_slice = floor(log2(view_depth) * depth_slice_scale + depth_slice_bias), as computed by the shaders.
+    f32 get_depth_slice_scale() const
+    {
+        return depth_slice_scale;
+    }
+
+    f32 get_depth_slice_bias() const
+    {
+        return depth_slice_bias;
+    }
+
+  public:
+    u32 num_clusters_x{};
+    u32 num_clusters_y{};
+    u32 num_clusters_z{};
+
+    std::vector<light_cluster_t> clusters{};
+    std::vector<u32> light_indices{};
+
+    clustered_lighting_statistics_t statistics{};
+
+  private:
+    // View space data of the lights, SoA so that 8 lights can be loaded at once. Padded to a multiple of 8 with lights
+    // that never intersect anything.
+    struct light_soa_t
+    {
+        void resize(const u32 size);
+
+        // Makes the element a light that never intersects anything.
+        void set_empty(const u32 index);
+
+        void copy(const u32 index, const light_soa_t &source, const u32 source_index);
+
+        std::vector<f32> position_x{};
+        std::vector<f32> position_y{};
+        std::vector<f32> position_z{};
+        std::vector<f32> range{};
+
+        std::vector<f32> direction_x{};
+        std::vector<f32> direction_y{};
+        std::vector<f32> direction_z{};
+        std::vector<f32> cos_outer_angle{};
+        std::vector<f32> sin_outer_angle{};
+
+        // All bits set for spot lights, 0 otherwise.
+        std::vector<f32> is_spot{};
+
+        std::vector<u32> light_index{};
+    };
+
+    // Scratch data and results of a depth slice, which are merged into clusters / light_indices once all slices are
+    // binned.
+    struct depth_slice_t
+    {
+        // Lights that overlap the slice, and the subset of those that overlap the current row of clusters.
+        light_soa_t candidate_lights{};
+        light_soa_t row_candidate_lights{};
+
+        std::vector<u32> light_indices{};
+
+        u32 max_lights_per_cluster{};
+        u32 num_dropped_light_indices{};
+    };
+
+    // Copies the lights of source whose sphere overlaps the box into destination, and pads destination to a multiple
+    // of 8. Returns the padded number of lights.
+    static u32 gather_overlapping_lights(const light_soa_t &source, const aabb_t &bounds, light_soa_t &destination);
+
+    void bin_depth_slice(const u32 slice_index);
+
+  private:
+    f32 near_plane{};
+    f32 max_depth{};
+    f32 depth_slice_scale{};
+    f32 depth_slice_bias{};
+
+    // View space bounds of each cluster (and their bounding spheres, for the spot light cone test).
+    std::vector<aabb_t> cluster_bounds{};
+    std::vector<float4_t> cluster_spheres{};
+
+    light_soa_t view_space_lights{};
+    u32 num_lights{};
+
+    std::vector<depth_slice_t> depth_slices{};
+};
+} // namespace nether
@@ -0,0 +1,384 @@
+#include "command_stream.hpp"
+
+namespace nether
+{
+void command_stream_t::set_pipeline(const u32 pipeline_index)
+{
+    allocate_command<set_pipeline_command_t>().pipeline_index = pipeline_index;
+}
+
+void command_stream_t::set_index_buffer(const u64 gpu_address, const u32 size_in_bytes, const index_format_t format)
+{
+    set_index_buffer_command_t &command = allocate_command<set_index_buffer_command_t>();
+    command.size_in_bytes = size_in_bytes;
+    command.gpu_address = gpu_address;
+    command.format = format;
+}
+
+void command_stream_t::set_root_constants(const u32 root_parameter_index, const std::span<const u32> values,
+                                          const u32 first_value_offset)
+{
+    set_root_constants_command_t &command =
+        allocate_command<set_root_constants_command_t>(static_cast<u32>(values.size_bytes()));
+    command.root_parameter_index = root_parameter_index;
+    command.first_value_offset = first_value_offset;
+    command.num_values = static_cast<u32>(values.size());
+
+    std::memcpy(reinterpret_cast<u8 *>(&command) + sizeof(set_root_constants_command_t), values.data(),
+                values.size_bytes());
+}
+
+void command_stream_t::draw_indexed_instanced(const u32 index_count, const u32 instance_count, const u32 first_index,
+                                              const i32 base_vertex, const u32 first_instance)
+{
+    draw_indexed_instanced_command_t &command = allocate_command<draw_indexed_instanced_command_t>();
+    command.index_count = index_count;
+    command.instance_count = instance_count;
+    command.first_index = first_index;
+    command.base_vertex = base_vertex;
+    command.first_instance = first_instance;
+}
+
+void command_stream_t::resource_barrier(const u32 resource_index, const resource_state_t state_before,
+                                        const resource_state_t state_after)
+{
+    resource_barrier_command_t &command = allocate_command<resource_barrier_command_t>();
+    command.resource_index = resource_index;
+    command.state_before = state_before;
+    command.state_after = state_after;
+}
+
+void command_stream_t::clear_render_target(const std::array<f32, 4> &color)
+{
+    clear_render_target_command_t &command = allocate_command<clear_render_target_command_t>();
+    std::copy(color.begin(), color.end(), command.color);
+}
+
+void command_stream_t::clear_depth(const f32 depth)
+{
+    allocate_command<clear_depth_command_t>().depth = depth;
+}
+
+void command_stream_t::copy_buffer_region(const u32 destination_resource_index, const u64 destination_offset,
+                                          const u32 source_resource_index, const u64 source_offset, const u64 size)
+{
+    copy_buffer_region_command_t &command = allocate_command<copy_buffer_region_command_t>();
+    command.destination_resource_index = destination_resource_index;
+    command.source_resource_index = source_resource_index;
+    command.destination_offset = destination_offset;
+    command.source_offset = source_offset;
+    command.size = size;
+}
+
+void *command_stream_t::allocate(const u32 size)
+{
+    if (size > std::numeric_limits<u16>::max())
+    {
+        throw std::runtime_error(std::format("Command of {} bytes is too large for a command stream", size));
+    }
+
+    if (!last_chunk || last_chunk->size + size > last_chunk->capacity)
+    {
+        const u32 capacity = std::max(CHUNK_SIZE, size);
+
+        chunk_t *const chunk = new (arena->allocate(sizeof(chunk_t) + capacity, alignof(chunk_t))) chunk_t{
+            .next = nullptr,
+            .size = 0u,
+            .capacity = capacity,
+        };
+
+        if (last_chunk)
+        {
+            last_chunk->next = chunk;
+        }
+        else
+        {
+            first_chunk = chunk;
+        }
+
+        last_chunk = chunk;
+    }
+
+    void *const result = reinterpret_cast<u8 *>(last_chunk + 1) + last_chunk->size;
+    last_chunk->size += size;
+
+    num_commands++;
+    size_in_bytes += size;
+
+    return result;
+}
+
+std::string_view to_string(const command_type_t type)
+{
+    switch (type)
+    {
+    case command_type_t::set_pipeline:
+        return "set_pipeline";
+    case command_type_t::set_index_buffer:
+        return "set_index_buffer";
+    case command_type_t::set_root_constants:
+        return "set_root_constants";
+    case command_type_t::draw_indexed_instanced:
+        return "draw_indexed_instanced";
+    case command_type_t::resource_barrier:
+        return "resource_barrier";
+    case command_type_t::clear_render_target:
+        return "clear_render_target";
+    case command_type_t::clear_depth:
+        return "clear_depth";
+    case command_type_t::copy_buffer_region:
+        return "copy_buffer_region";
+    }
+
+    return "unknown";
+}
+
+std::string_view to_string(const resource_state_t state)
+{
+    switch (state)
+    {
+    case resource_state_t::common:
+        return "common";
+    case resource_state_t::present:
+        return "present";
+    case resource_state_t::render_target:
+        return "render_target";
+    case resource_state_t::depth_write:
+        return "depth_write";
+    case resource_state_t::shader_resource:
+        return "shader_resource";
+    case resource_state_t::copy_source:
+        return "copy_source";
+    case resource_state_t::copy_destination:
+        return "copy_destination";
+    }
+
+    return "unknown";
+}
+
+std::string to_string(const command_stream_t &stream)
+{
+    std::string result{};
+    u32 command_index = 0u;
+
+    stream.for_each_command([&](const command_header_t &header) {
+        std::format_to(std::back_inserter(result), "{}: {}", command_index++, to_string(header.type));
+
+        switch (header.type)
+        {
+        case command_type_t::set_pipeline: {
+            const auto &command = reinterpret_cast<const set_pipeline_command_t &>(header);
+            std::format_to(std::back_inserter(result), " pipeline={}", command.pipeline_index);
+        }
+        break;
+
+        case command_type_t::set_index_buffer: {
+            const auto &command = reinterpret_cast<const set_index_buffer_command_t &>(header);
+            std::format_to(std::back_inserter(result), " address=0x{:x} size={} format={}", command.gpu_address,
+                           command.size_in_bytes, command.format == index_format_t::u16 ? "u16" : "u32");
+        }
+        break;
+
+        case command_type_t::set_root_constants: {
+            const auto &command = reinterpret_cast<const set_root_constants_command_t &>(header);
+            std::format_to(std::back_inserter(result), " parameter={} offset={} values=[",
+                           command.root_parameter_index, command.first_value_offset);
+            for (u32 i = 0u; i < command.num_values; i++)
+            {
+                std::format_to(std::back_inserter(result), "{}{}", i ? " " : "", command.get_values()[i]);
+            }
+            result += "]";
+        }
+        break;
+
+        case command_type_t::draw_indexed_instanced: {
+            const auto &command = reinterpret_cast<const draw_indexed_instanced_command_t &>(header);
+            std::format_to(std::back_inserter(result),
+                           " index_count={} instance_count={} first_index={} base_vertex={} first_instance={}",
+                           command.index_count, command.instance_count, command.first_index, command.base_vertex,
+                           command.first_instance);
+        }
+        break;
+
+        case command_type_t::resource_barrier: {
+            const auto &command = reinterpret_cast<const resource_barrier_command_t &>(header);
+            std::format_to(std::back_inserter(result), " resource={} {} -> {}", command.resource_index,
+                           to_string(command.state_before), to_string(command.state_after));
+        }
+        break;
+
+        case command_type_t::clear_render_target: {
+            const auto &command = reinterpret_cast<const clear_render_target_command_t &>(header);
+            std::format_to(std::back_inserter(result), " color=({}, {}, {}, {})", command.color[0], command.color[1],
+                           command.color[2], command.color[3]);
+        }
+        break;
+
+        case command_type_t::clear_depth: {
+            const auto &command = reinterpret_cast<const clear_depth_command_t &>(header);
+            std::format_to(std::back_inserter(result), " depth={}", command.depth);
+        }
+        break;
+
+        case command_type_t::copy_buffer_region: {
+            const auto &command = reinterpret_cast<const copy_buffer_region_command_t &>(header);
+            std::format_to(std::back_inserter(result), " destination={} offset={} source={} offset={} size={}",
+                           command.destination_resource_index, command.destination_offset,
+                           command.source_resource_index, command.source_offset, command.size);
+        }
+        break;
+        }
+
+        result += '\n';
+    });
+
+    return result;
+}
+
+std::vector<std::string> validate(const command_stream_t &stream, const command_stream_limits_t &limits)
+{
+    std::vector<std::string> errors{};
+
+    bool pipeline_set = false;
+    bool index_buffer_set = false;
+
+    // State of each resource as set by the barriers seen so far (the state before the stream is unknown).
+    constexpr u32 UNKNOWN_STATE = ~0u;
+    std::vector<u32> resource_states(limits.num_resources, UNKNOWN_STATE);
+
+    u32 command_index = 0u;
+
+    stream.for_each_command([&](const command_header_t &header) {
+        const auto add_error = [&](const std::string_view message) {
+            errors.push_back(std::format("{} ({}): {}", command_index, to_string(header.type), message));
+        };
+
+        switch (header.type)
+        {
+        case command_type_t::set_pipeline: {
+            const auto &command = reinterpret_cast<const set_pipeline_command_t &>(header);
+            if (command.pipeline_index >= limits.num_pipelines)
+            {
+                add_error(std::format("pipeline index {} out of range ({} pipelines)", command.pipeline_index,
+                                      limits.num_pipelines));
+            }
+
+            pipeline_set = true;
+        }
+        break;
+
+        case command_type_t::set_index_buffer: {
+            const auto &command = reinterpret_cast<const set_index_buffer_command_t &>(header);
+            const u32 index_size = command.format == index_format_t::u16 ? 2u : 4u;
+            if (command.gpu_address == 0u || command.gpu_address % index_size != 0u)
+            {
+                add_error("index buffer address is null or not aligned to the index size");
+            }
+
+            index_buffer_set = true;
+        }
+        break;
+
+        case command_type_t::set_root_constants: {
+            const auto &command = reinterpret_cast<const set_root_constants_command_t &>(header);
+            if (command.first_value_offset + command.num_values > command_stream_t::MAX_ROOT_CONSTANTS)
+            {
+                add_error(std::format("root constants [{}, {}) out of range", command.first_value_offset,
+                                      command.first_value_offset + command.num_values));
+            }
+        }
+        break;
+
+        case command_type_t::draw_indexed_instanced: {
+            const auto &command = reinterpret_cast<const draw_indexed_instanced_command_t &>(header);
+            if (!pipeline_set)
+            {
+                add_error("draw without a pipeline");
+            }
+
+            if (!index_buffer_set)
+            {
+                add_error("indexed draw without an index buffer");
+            }
+
+            if (command.index_count == 0u || command.instance_count == 0u)
+            {
+                add_error("empty draw");
+            }
+        }
+        break;
+
+        case command_type_t::resource_barrier: {
+            const auto &command = reinterpret_cast<const resource_barrier_command_t &>(header);
+            if (command.resource_index >= limits.num_resources)
+            {
+                add_error(std::format("resource index {} out of range ({} resources)", command.resource_index,
+                                      limits.num_resources));
+                break;
+            }
+
+            if (command.state_before == command.state_after)
+            {
+                add_error("barrier state before and after are the same");
+            }
+
+            u32 &resource_state = resource_states[command.resource_index];
+            if (resource_state != UNKNOWN_STATE && resource_state != static_cast<u32>(command.state_before))
+            {
+                add_error(std::format("resource {} is in state {}, not {}", command.resource_index,
+                                      to_string(static_cast<resource_state_t>(resource_state)),
+                                      to_string(command.state_before)));
+            }
+
+            resource_state = static_cast<u32>(command.state_after);
+        }
+        break;
+
+        case command_type_t::copy_buffer_region: {
+            const auto &command = reinterpret_cast<const copy_buffer_region_command_t &>(header);
+            if (command.destination_resource_index >= limits.num_resources ||
+                command.source_resource_index >= limits.num_resources)
+            {
+                add_error(std::format("resource indices {} and {} out of range ({} resources)",
+                                      command.destination_resource_index, command.source_resource_index,
+                                      limits.num_resources));
+                break;
+            }
+
+            if (command.destination_resource_index == command.source_resource_index)
+            {
+                add_error("copy within a single resource");
+            }
+
+            if (command.size == 0u)
+            {
+                add_error("empty copy");
+            }
+
+            // Buffers in the common state are implicitly promoted to copy_destination.
+            const u32 destination_state = resource_states[command.destination_resource_index];
+            if (destination_state != UNKNOWN_STATE &&
+                destination_state != static_cast<u32>(resource_state_t::copy_destination) &&
+                destination_state != static_cast<u32>(resource_state_t::common))
+            {
+                add_error(std::format("copy destination {} is in state {}", command.destination_resource_index,
+                                      to_string(static_cast<resource_state_t>(destination_state))));
+            }
+        }
+        break;
+
+        case command_type_t::clear_render_target:
+        case command_type_t::clear_depth:
+            break;
+
+        default:
+            add_error("unknown command type");
+            break;
+        }
+
+        command_index++;
+    });
+
+    return errors;
+}
+} // namespace nether
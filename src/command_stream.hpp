@@ -0,0 +1,254 @@
+#pragma once
+
+#include "common.hpp"
+#include "memory.hpp"
+
+// An engine level command buffer format. Commands are compact POD structs that refer to pipelines and resources by
+// index (into tables provided at translation time) rather than by API object, so streams can be recorded on any
+// thread, validated and printed without a GPU, and translated into native command lists later (see
+// command_translator.hpp).
+namespace nether
+{
+enum class command_type_t : u16
+{
+    set_pipeline,
+    set_index_buffer,
+    set_root_constants,
+    draw_indexed_instanced,
+    resource_barrier,
+    clear_render_target,
+    clear_depth,
+    copy_buffer_region,
+};
+
+enum class index_format_t : u32
+{
+    u16,
+    u32,
+};
+
+enum class resource_state_t : u32
+{
+    common,
+    present,
+    render_target,
+    depth_write,
+    shader_resource,
+    copy_source,
+    copy_destination,
+};
+
+// Every command starts with a header. size includes the header and any data following the command struct, and is a
+// multiple of COMMAND_ALIGNMENT.
+struct command_header_t
+{
+    command_type_t type{};
+    u16 size{};
+};
+
+static constexpr u32 COMMAND_ALIGNMENT = 8u;
+
+// Commands that refer to a pipeline or resource use their index in the pipeline / resource tables.
+struct set_pipeline_command_t
+{
+    static constexpr command_type_t TYPE = command_type_t::set_pipeline;
+
+    command_header_t header{};
+    u32 pipeline_index{};
+};
+
+struct set_index_buffer_command_t
+{
+    static constexpr command_type_t TYPE = command_type_t::set_index_buffer;
+
+    command_header_t header{};
+    u32 size_in_bytes{};
+    u64 gpu_address{};
+    index_format_t format{};
+};
+
+// Followed by num_values u32's.
+struct set_root_constants_command_t
+{
+    static constexpr command_type_t TYPE = command_type_t::set_root_constants;
+
+    command_header_t header{};
+    u32 root_parameter_index{};
+    u32 first_value_offset{};
+    u32 num_values{};
+
+    const u32 *get_values() const
+    {
+        return reinterpret_cast<const u32 *>(this + 1);
+    }
+};
+
+struct draw_indexed_instanced_command_t
+{
+    static constexpr command_type_t TYPE = command_type_t::draw_indexed_instanced;
+
+    command_header_t header{};
+    u32 index_count{};
+    u32 instance_count{};
+    u32 first_index{};
+    i32 base_vertex{};
+    u32 first_instance{};
+};
+
+struct resource_barrier_command_t
+{
+    static constexpr command_type_t TYPE = command_type_t::resource_barrier;
+
+    command_header_t header{};
+    u32 resource_index{};
+    resource_state_t state_before{};
+    resource_state_t state_after{};
+};
+
+// Clears the bound render target / depth buffer.
+struct clear_render_target_command_t
+{
+    static constexpr command_type_t TYPE = command_type_t::clear_render_target;
+
+    command_header_t header{};
+    f32 color[4]{};
+};
+
+struct clear_depth_command_t
+{
+    static constexpr command_type_t TYPE = command_type_t::clear_depth;
+
+    command_header_t header{};
+    f32 depth{};
+};
+
+// Offsets and size are in bytes.
+struct copy_buffer_region_command_t
+{
+    static constexpr command_type_t TYPE = command_type_t::copy_buffer_region;
+
+    command_header_t header{};
+    u32 destination_resource_index{};
+    u32 source_resource_index{};
+    u64 destination_offset{};
+    u64 source_offset{};
+    u64 size{};
+};
+
+// A sequence of commands, stored in chunks allocated from a linear arena. A stream must only be recorded by one thread
+// at a time, and the arena must not be used by other threads while recording (use an arena per recording thread). The
+// stream is valid until the arena is reset.
+class command_stream_t
+{
+  public:
+    static constexpr u32 CHUNK_SIZE = 16u * 1024u;
+
+    // The root signature has room for 64 root constants at most.
+    static constexpr u32 MAX_ROOT_CONSTANTS = 64u;
+
+    explicit command_stream_t(memory::linear_arena_t &arena) : arena(&arena)
+    {
+    }
+
+    void set_pipeline(const u32 pipeline_index);
+    void set_index_buffer(const u64 gpu_address, const u32 size_in_bytes, const index_format_t format);
+    void set_root_constants(const u32 root_parameter_index, const std::span<const u32> values,
+                            const u32 first_value_offset = 0u);
+    void draw_indexed_instanced(const u32 index_count, const u32 instance_count, const u32 first_index = 0u,
+                                const i32 base_vertex = 0, const u32 first_instance = 0u);
+    void resource_barrier(const u32 resource_index, const resource_state_t state_before,
+                          const resource_state_t state_after);
+    void clear_render_target(const std::array<f32, 4> &color);
+    void clear_depth(const f32 depth);
+    void copy_buffer_region(const u32 destination_resource_index, const u64 destination_offset,
+                            const u32 source_resource_index, const u64 source_offset, const u64 size);
+
+    // Calls function(const command_header_t &) for every command, in recording order.
+    template <typename Fn> void for_each_command(Fn &&function) const
+    {
+        for (const chunk_t *chunk = first_chunk; chunk; chunk = chunk->next)
+        {
+            const u8 *const data = reinterpret_cast<const u8 *>(chunk + 1);
+            for (u32 offset = 0u; offset < chunk->size;)
+            {
+                const command_header_t &header = *reinterpret_cast<const command_header_t *>(data + offset);
+                function(header);
+                offset += header.size;
+            }
+        }
+    }
+
+    // Forgets the recorded commands. Does not reset the arena, which must be reset (or rewound) separately.
+    void reset()
+    {
+        first_chunk = nullptr;
+        last_chunk = nullptr;
+        num_commands = 0u;
+        size_in_bytes = 0u;
+    }
+
+    u32 get_num_commands() const
+    {
+        return num_commands;
+    }
+
+    size_t get_size_in_bytes() const
+    {
+        return size_in_bytes;
+    }
+
+  private:
+    struct alignas(COMMAND_ALIGNMENT) chunk_t
+    {
+        chunk_t *next{};
+        u32 size{};
+        u32 capacity{};
+    };
+
+    template <typename T> T &allocate_command(const u32 extra_size = 0u)
+    {
+        static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= COMMAND_ALIGNMENT);
+
+        const u32 size = static_cast<u32>(memory::align_up(sizeof(T) + extra_size, COMMAND_ALIGNMENT));
+        T *const command = new (allocate(size)) T{};
+        command->header = {
+            .type = T::TYPE,
+            .size = static_cast<u16>(size),
+        };
+
+        return *command;
+    }
+
+    void *allocate(const u32 size);
+
+  private:
+    memory::linear_arena_t *arena{};
+
+    chunk_t *first_chunk{};
+    chunk_t *last_chunk{};
+
+    u32 num_commands{};
+    size_t size_in_bytes{};
+};
+
+std::string_view to_string(const command_type_t type);
+std::string_view to_string(const resource_state_t state);
+
+// One command per line, with the command's index and arguments. The output is deterministic, so streams can be
+// compared with a text diff (e.g. between two frames, or against a reference).
+std::string to_string(const command_stream_t &stream);
+
+// Sizes of the tables the stream will be translated with.
+struct command_stream_limits_t
+{
+    u32 num_pipelines{};
+    u32 num_resources{};
+};
+
+// Checks the stream for errors that would otherwise only be caught by the D3D12 debug layer (if at all) : draws without
+// a pipeline or index buffer, out of range pipeline / resource indices, root constants out of the root signature's
+// range, barriers whose before state does not match the state set by a previous barrier in the stream, and copies into
+// a buffer that a previous barrier left in a state other than copy_destination.
+// Returns one message per error (empty if the stream is valid).
+std::vector<std::string> validate(const command_stream_t &stream, const command_stream_limits_t &limits);
+} // namespace nether
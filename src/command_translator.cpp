@@ -0,0 +1,215 @@
+#include "command_translator.hpp"
+
+#include <chrono>
+
+namespace nether
+{
+static D3D12_RESOURCE_STATES to_d3d12_resource_states(const resource_state_t state)
+{
+    switch (state)
+    {
+    case resource_state_t::common:
+        return D3D12_RESOURCE_STATE_COMMON;
+    case resource_state_t::present:
+        return D3D12_RESOURCE_STATE_PRESENT;
+    case resource_state_t::render_target:
+        return D3D12_RESOURCE_STATE_RENDER_TARGET;
+    case resource_state_t::depth_write:
+        return D3D12_RESOURCE_STATE_DEPTH_WRITE;
+    case resource_state_t::shader_resource:
+        return D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE;
+    case resource_state_t::copy_source:
+        return D3D12_RESOURCE_STATE_COPY_SOURCE;
+    case resource_state_t::copy_destination:
+        return D3D12_RESOURCE_STATE_COPY_DEST;
+    }
+
+    return D3D12_RESOURCE_STATE_COMMON;
+}
+
+command_translator_t::command_translator_t(ID3D12Device *const device, const u32 num_frames_in_flight,
+                                           const u32 max_command_lists)
+    : num_frames_in_flight(num_frames_in_flight), max_command_lists(max_command_lists)
+{
+    command_allocators.resize(num_frames_in_flight * max_command_lists);
+    for (ComPtr<ID3D12CommandAllocator> &command_allocator : command_allocators)
+    {
+        throw_if_failed(
+            device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&command_allocator)));
+        set_name_d3d12_object(command_allocator.Get(), L"D3D12 command translator command allocator");
+    }
+
+    command_lists.resize(max_command_lists);
+    for (u32 i = 0u; i < max_command_lists; i++)
+    {
+        throw_if_failed(device->CreateCommandList(0u, D3D12_COMMAND_LIST_TYPE_DIRECT, command_allocators[i].Get(),
+                                                  nullptr, IID_PPV_ARGS(&command_lists[i])));
+        throw_if_failed(command_lists[i]->Close());
+        set_name_d3d12_object(command_lists[i].Get(), L"D3D12 command translator command list");
+    }
+}
+
+std::span<ID3D12CommandList *const> command_translator_t::translate(
+    const u32 frame_slot, const std::span<const command_stream_t *const> streams,
+    const command_translation_context_t &context, job_system_t *const job_system)
+{
+    if (frame_slot >= num_frames_in_flight || streams.size() > max_command_lists)
+    {
+        throw std::runtime_error(std::format("Cannot translate {} command streams in frame slot {} (the translator has "
+                                             "{} frame slots of {} command lists)",
+                                             streams.size(), frame_slot, num_frames_in_flight, max_command_lists));
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const u32 num_streams = static_cast<u32>(streams.size());
+    if (job_system)
+    {
+        job_system->parallel_for(num_streams, 1u, [&](const u32 begin, const u32 end, const u32) {
+            for (u32 i = begin; i < end; i++)
+            {
+                translate_stream(frame_slot, i, *streams[i], context);
+            }
+        });
+    }
+    else
+    {
+        for (u32 i = 0u; i < num_streams; i++)
+        {
+            translate_stream(frame_slot, i, *streams[i], context);
+        }
+    }
+
+    translated_command_lists.clear();
+    statistics.num_commands = 0u;
+    for (u32 i = 0u; i < num_streams; i++)
+    {
+        translated_command_lists.push_back(command_lists[i].Get());
+        statistics.num_commands += streams[i]->get_num_commands();
+    }
+
+    statistics.num_command_lists = num_streams;
+    statistics.translation_time_in_ms =
+        std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+    return translated_command_lists;
+}
+
+void command_translator_t::translate_stream(const u32 frame_slot, const u32 stream_index,
+                                            const command_stream_t &stream,
+                                            const command_translation_context_t &context)
+{
+    ID3D12CommandAllocator *const command_allocator =
+        command_allocators[frame_slot * max_command_lists + stream_index].Get();
+    ID3D12GraphicsCommandList *const command_list = command_lists[stream_index].Get();
+
+    throw_if_failed(command_allocator->Reset());
+    throw_if_failed(command_list->Reset(command_allocator, nullptr));
+
+    // Command lists do not inherit any state, so each one starts by setting up the state shared by all streams.
+    command_list->SetDescriptorHeaps(1u, &context.cbv_srv_uav_descriptor_heap);
+    command_list->SetGraphicsRootSignature(context.root_signature);
+    command_list->OMSetRenderTargets(1u, &context.rtv_handle, false, &context.dsv_handle);
+    command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    command_list->RSSetViewports(1u, &context.viewport);
+    command_list->RSSetScissorRects(1u, &context.scissor_rect);
+
+    constexpr u32 MAX_BATCHED_BARRIERS = 16u;
+    std::array<D3D12_RESOURCE_BARRIER, MAX_BATCHED_BARRIERS> barriers{};
+    u32 num_barriers = 0u;
+
+    const auto flush_barriers = [&]() {
+        if (num_barriers > 0u)
+        {
+            command_list->ResourceBarrier(num_barriers, barriers.data());
+            num_barriers = 0u;
+        }
+    };
+
+    stream.for_each_command([&](const command_header_t &header) {
+        if (header.type != command_type_t::resource_barrier)
+        {
+            flush_barriers();
+        }
+
+        switch (header.type)
+        {
+        case command_type_t::set_pipeline: {
+            const auto &command = reinterpret_cast<const set_pipeline_command_t &>(header);
+            command_list->SetPipelineState(context.pipelines[command.pipeline_index]);
+        }
+        break;
+
+        case command_type_t::set_index_buffer: {
+            const auto &command = reinterpret_cast<const set_index_buffer_command_t &>(header);
+            const D3D12_INDEX_BUFFER_VIEW index_buffer_view = {
+                .BufferLocation = command.gpu_address,
+                .SizeInBytes = command.size_in_bytes,
+                .Format = command.format == index_format_t::u16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT,
+            };
+            command_list->IASetIndexBuffer(&index_buffer_view);
+        }
+        break;
+
+        case command_type_t::set_root_constants: {
+            const auto &command = reinterpret_cast<const set_root_constants_command_t &>(header);
+            command_list->SetGraphicsRoot32BitConstants(command.root_parameter_index, command.num_values,
+                                                        command.get_values(), command.first_value_offset);
+        }
+        break;
+
+        case command_type_t::draw_indexed_instanced: {
+            const auto &command = reinterpret_cast<const draw_indexed_instanced_command_t &>(header);
+            command_list->DrawIndexedInstanced(command.index_count, command.instance_count, command.first_index,
+                                               command.base_vertex, command.first_instance);
+        }
+        break;
+
+        case command_type_t::resource_barrier: {
+            const auto &command = reinterpret_cast<const resource_barrier_command_t &>(header);
+            if (num_barriers == MAX_BATCHED_BARRIERS)
+            {
+                flush_barriers();
+            }
+
+            barriers[num_barriers++] = {
+                .Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION,
+                .Transition =
+                    {
+                        .pResource = context.resources[command.resource_index],
+                        .Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+                        .StateBefore = to_d3d12_resource_states(command.state_before),
+                        .StateAfter = to_d3d12_resource_states(command.state_after),
+                    },
+            };
+        }
+        break;
+
+        case command_type_t::clear_render_target: {
+            const auto &command = reinterpret_cast<const clear_render_target_command_t &>(header);
+            command_list->ClearRenderTargetView(context.rtv_handle, command.color, 0u, nullptr);
+        }
+        break;
+
+        case command_type_t::clear_depth: {
+            const auto &command = reinterpret_cast<const clear_depth_command_t &>(header);
+            command_list->ClearDepthStencilView(context.dsv_handle, D3D12_CLEAR_FLAG_DEPTH, command.depth, 0u, 0u,
+                                                nullptr);
+        }
+        break;
+
+        case command_type_t::copy_buffer_region: {
+            const auto &command = reinterpret_cast<const copy_buffer_region_command_t &>(header);
+            command_list->CopyBufferRegion(context.resources[command.destination_resource_index],
+                                           command.destination_offset, context.resources[command.source_resource_index],
+                                           command.source_offset, command.size);
+        }
+        break;
+        }
+    });
+
+    flush_barriers();
+
+    throw_if_failed(command_list->Close());
+}
+} // namespace nether
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "command_stream.hpp"
+#include "common.hpp"
+#include "job_system.hpp"
+
+namespace nether
+{
+// The tables that commands index into, and the state every translated command list starts with.
+struct command_translation_context_t
+{
+    ID3D12RootSignature *root_signature{};
+    ID3D12DescriptorHeap *cbv_srv_uav_descriptor_heap{};
+
+    std::span<ID3D12PipelineState *const> pipelines{};
+    std::span<ID3D12Resource *const> resources{};
+
+    D3D12_CPU_DESCRIPTOR_HANDLE rtv_handle{};
+    D3D12_CPU_DESCRIPTOR_HANDLE dsv_handle{};
+
+    D3D12_VIEWPORT viewport{};
+    D3D12_RECT scissor_rect{};
+};
+
+struct command_translation_statistics_t
+{
+    u32 num_command_lists{};
+    u32 num_commands{};
+
+    f32 translation_time_in_ms{};
+};
+
+// Translates command streams into D3D12 graphics command lists, one command list per stream. The streams are
+// translated in parallel on the job system, each into its own command list and command allocator, and the command
+// lists are returned in stream order so that they can be submitted with a single ExecuteCommandLists call.
+// Consecutive barrier commands are batched into a single ResourceBarrier call.
+class command_translator_t
+{
+  public:
+    explicit command_translator_t(ID3D12Device *const device, const u32 num_frames_in_flight,
+                                  const u32 max_command_lists);
+
+    command_translator_t(const command_translator_t &) = delete;
+    command_translator_t &operator=(const command_translator_t &) = delete;
+
+    // frame_slot selects the command allocators, which are reset : the GPU must have finished executing the command
+    // lists last translated with the same slot. The returned command lists are closed, and stay valid until the next
+    // call to translate.
+    std::span<ID3D12CommandList *const> translate(const u32 frame_slot,
+                                                  const std::span<const command_stream_t *const> streams,
+                                                  const command_translation_context_t &context,
+                                                  job_system_t *const job_system = nullptr);
+
+  public:
+    command_translation_statistics_t statistics{};
+
+  private:
+    void translate_stream(const u32 frame_slot, const u32 stream_index, const command_stream_t &stream,
+                          const command_translation_context_t &context);
+
+  private:
+    u32 num_frames_in_flight{};
+    u32 max_command_lists{};
+
+    // Indexed by frame_slot * max_command_lists + stream index.
+    std::vector<ComPtr<ID3D12CommandAllocator>> command_allocators{};
+    std::vector<ComPtr<ID3D12GraphicsCommandList>> command_lists{};
+
+    std::vector<ID3D12CommandList *> translated_command_lists{};
+};
+} // namespace nether
@@ -1,34 +1,50 @@
 #pragma once
 
 // Dump of all the stuff that is common to all files throughout this project.
+// Everything platform / GPU API specific is guarded by _WIN32, so that the CPU side subsystems can be built and
+// tested on other platforms.
+#ifdef _WIN32
 #ifndef UNICODE
 #define UNICODE
 #endif
 
 // Windows includes.
 #define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
 #include <comdef.h>
 #include <windows.h>
 #include <wrl/client.h>
+#endif
 
 // Standard library includes.
+#include <algorithm>
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <exception>
+#include <filesystem>
 #include <format>
+#include <fstream>
 #include <iostream>
+#include <optional>
+#include <random>
 #include <source_location>
 #include <span>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#ifdef _WIN32
 // DXGI / D3D12 includes.
 #include <d3d12.h>
 #include <dxgi1_6.h>
 
 // DXMath include.
 #include <DirectXMath.h>
+#endif
 
 // Typedefs for commonly used datatypes.
 typedef uint8_t u8;
@@ -50,6 +66,7 @@ static constexpr bool NETHER_DEBUG = true;
 static constexpr bool NETHER_DEBUG = false;
 #endif
 
+#ifdef _WIN32
 using namespace Microsoft::WRL;
 
 static inline void throw_if_failed(const HRESULT hr,
@@ -73,3 +90,17 @@ static inline void set_name_d3d12_object(ComPtr<ID3D12Object> object, const std:
         throw_if_failed(object->SetName(name.data()));
     }
 }
+#endif
+
+// FNV-1a hash of a byte range. Pass the result of a previous call as hash to combine multiple ranges.
+static inline u64 hash_bytes(const void *const data, const size_t size, u64 hash = 0xcbf29ce484222325ull)
+{
+    const u8 *const bytes = static_cast<const u8 *>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
@@ -0,0 +1,202 @@
+#include "dds.hpp"
+
+#include "file_reader.hpp"
+
+namespace nether
+{
+namespace
+{
+// See https://learn.microsoft.com/windows/win32/direct3ddds/dds-header.
+struct dds_pixel_format_t
+{
+    u32 size{};
+    u32 flags{};
+    u32 four_cc{};
+    u32 rgb_bit_count{};
+    u32 r_bit_mask{};
+    u32 g_bit_mask{};
+    u32 b_bit_mask{};
+    u32 a_bit_mask{};
+};
+
+struct dds_header_t
+{
+    u32 size{};
+    u32 flags{};
+    u32 height{};
+    u32 width{};
+    u32 pitch_or_linear_size{};
+    u32 depth{};
+    u32 mip_map_count{};
+    u32 reserved_1[11]{};
+    dds_pixel_format_t pixel_format{};
+    u32 caps{};
+    u32 caps_2{};
+    u32 caps_3{};
+    u32 caps_4{};
+    u32 reserved_2{};
+};
+
+struct dds_header_dxt10_t
+{
+    u32 dxgi_format{};
+    u32 resource_dimension{};
+    u32 misc_flag{};
+    u32 array_size{};
+    u32 misc_flags_2{};
+};
+
+static_assert(sizeof(dds_header_t) == 124u);
+static_assert(sizeof(dds_header_dxt10_t) == 20u);
+
+constexpr u32 DDS_MAGIC = 0x20534444u; // "DDS "
+constexpr u32 DDS_FOURCC_DX10 = 0x30315844u; // "DX10"
+
+// Caps, height, width, pitch, pixel format, and mip map count.
+constexpr u32 DDS_FLAGS = 0x1u | 0x2u | 0x4u | 0x8u | 0x1000u | 0x20000u;
+constexpr u32 DDS_PIXEL_FORMAT_FOURCC = 0x4u;
+
+constexpr u32 DDS_CAPS_COMPLEX = 0x8u;
+constexpr u32 DDS_CAPS_TEXTURE = 0x1000u;
+constexpr u32 DDS_CAPS_MIPMAP = 0x400000u;
+constexpr u32 DDS_CAPS_2_CUBEMAP_ALL_FACES = 0xfe00u;
+
+constexpr u32 D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3u;
+constexpr u32 D3D10_RESOURCE_MISC_TEXTURECUBE = 0x4u;
+
+constexpr u64 DDS_DATA_OFFSET = sizeof(u32) + sizeof(dds_header_t) + sizeof(dds_header_dxt10_t);
+
+bool is_valid_format(const u32 format)
+{
+    return format == static_cast<u32>(dds_format_t::r32g32b32a32_float) ||
+           format == static_cast<u32>(dds_format_t::r16g16b16a16_float) ||
+           format == static_cast<u32>(dds_format_t::r16g16_float);
+}
+} // namespace
+
+u32 get_dds_texel_size(const dds_format_t format)
+{
+    switch (format)
+    {
+    case dds_format_t::r32g32b32a32_float:
+        return 16u;
+    case dds_format_t::r16g16b16a16_float:
+        return 8u;
+    case dds_format_t::r16g16_float:
+        return 4u;
+    }
+
+    throw std::runtime_error(std::format("Unknown DDS format {}", static_cast<u32>(format)));
+}
+
+u64 get_dds_data_size(const dds_image_t &image)
+{
+    u64 num_texels = 0u;
+    for (u32 mip = 0u; mip < image.num_mips; mip++)
+    {
+        num_texels += static_cast<u64>(std::max(image.width >> mip, 1u)) * std::max(image.height >> mip, 1u);
+    }
+
+    return num_texels * get_dds_texel_size(image.format) * (image.is_cubemap ? 6u : 1u);
+}
+
+void write_dds(const std::filesystem::path &path, const dds_image_t &image)
+{
+    if (image.num_mips == 0u || image.data.size() != get_dds_data_size(image))
+    {
+        throw std::runtime_error(std::format("DDS image of {}x{} texels and {} mips has {} bytes of data, instead of "
+                                             "{}",
+                                             image.width, image.height, image.num_mips, image.data.size(),
+                                             get_dds_data_size(image)));
+    }
+
+    const bool has_mips = image.num_mips > 1u;
+
+    const dds_header_t header{
+        .size = sizeof(dds_header_t),
+        .flags = DDS_FLAGS,
+        .height = image.height,
+        .width = image.width,
+        .pitch_or_linear_size = image.width * get_dds_texel_size(image.format),
+        .mip_map_count = image.num_mips,
+        .pixel_format =
+            dds_pixel_format_t{
+                .size = sizeof(dds_pixel_format_t),
+                .flags = DDS_PIXEL_FORMAT_FOURCC,
+                .four_cc = DDS_FOURCC_DX10,
+            },
+        .caps = DDS_CAPS_TEXTURE | (has_mips || image.is_cubemap ? DDS_CAPS_COMPLEX : 0u) |
+                (has_mips ? DDS_CAPS_MIPMAP : 0u),
+        .caps_2 = image.is_cubemap ? DDS_CAPS_2_CUBEMAP_ALL_FACES : 0u,
+    };
+
+    const dds_header_dxt10_t header_dxt10{
+        .dxgi_format = static_cast<u32>(image.format),
+        .resource_dimension = D3D10_RESOURCE_DIMENSION_TEXTURE2D,
+        .misc_flag = image.is_cubemap ? D3D10_RESOURCE_MISC_TEXTURECUBE : 0u,
+        .array_size = 1u,
+    };
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error(std::format("Failed to open {} for writing", path.string()));
+    }
+
+    file.write(reinterpret_cast<const char *>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(&header_dxt10), sizeof(header_dxt10));
+    file.write(reinterpret_cast<const char *>(image.data.data()), static_cast<std::streamsize>(image.data.size()));
+
+    if (!file)
+    {
+        throw std::runtime_error(std::format("Failed to write DDS file {}", path.string()));
+    }
+}
+
+dds_image_t read_dds(const std::filesystem::path &path)
+{
+    const file_reader_t file_reader(path);
+    const u64 file_size = std::filesystem::file_size(path);
+    if (file_size < DDS_DATA_OFFSET)
+    {
+        throw std::runtime_error(std::format("{} is too small to be a DDS file", path.string()));
+    }
+
+    u32 magic{};
+    dds_header_t header{};
+    dds_header_dxt10_t header_dxt10{};
+    file_reader.read(0u, &magic, sizeof(magic));
+    file_reader.read(sizeof(magic), &header, sizeof(header));
+    file_reader.read(sizeof(magic) + sizeof(header), &header_dxt10, sizeof(header_dxt10));
+
+    if (magic != DDS_MAGIC || header.size != sizeof(dds_header_t) || header.pixel_format.four_cc != DDS_FOURCC_DX10 ||
+        header_dxt10.resource_dimension != D3D10_RESOURCE_DIMENSION_TEXTURE2D || header_dxt10.array_size != 1u ||
+        !is_valid_format(header_dxt10.dxgi_format))
+    {
+        throw std::runtime_error(std::format("{} is not a DDS file of a single 2D texture or cubemap, in a float "
+                                             "format",
+                                             path.string()));
+    }
+
+    dds_image_t image{
+        .format = static_cast<dds_format_t>(header_dxt10.dxgi_format),
+        .width = header.width,
+        .height = header.height,
+        .num_mips = std::max(header.mip_map_count, 1u),
+        .is_cubemap = (header_dxt10.misc_flag & D3D10_RESOURCE_MISC_TEXTURECUBE) != 0u,
+    };
+
+    const u64 data_size = get_dds_data_size(image);
+    if (file_size < DDS_DATA_OFFSET + data_size)
+    {
+        throw std::runtime_error(std::format("DDS file {} of {}x{} texels and {} mips is truncated", path.string(),
+                                             image.width, image.height, image.num_mips));
+    }
+
+    image.data.resize(data_size);
+    file_reader.read(DDS_DATA_OFFSET, image.data.data(), data_size);
+
+    return image;
+}
+} // namespace nether
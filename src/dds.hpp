@@ -0,0 +1,42 @@
+#pragma once
+
+#include "common.hpp"
+
+// DDS files with the DX10 header extension, which the offline tools write GPU-ready texture data to (the data is laid
+// out as D3D12 expects the subresources of a texture, so it can be copied as is into an upload buffer).
+namespace nether
+{
+// The values are the matching DXGI_FORMATs.
+enum class dds_format_t : u32
+{
+    r32g32b32a32_float = 2u,
+    r16g16b16a16_float = 10u,
+    r16g16_float = 34u,
+};
+
+u32 get_dds_texel_size(const dds_format_t format);
+
+struct dds_image_t
+{
+    dds_format_t format{dds_format_t::r16g16b16a16_float};
+
+    u32 width{};
+    u32 height{};
+    u32 num_mips{1u};
+
+    // Cubemaps have 6 square faces (+x, -x, +y, -y, +z, -z).
+    bool is_cubemap{};
+
+    // Face by face for cubemaps, then mip by mip (largest first), in rows of texels.
+    std::vector<u8> data{};
+};
+
+// Size in bytes of the data of the image's faces and mips.
+u64 get_dds_data_size(const dds_image_t &image);
+
+// Throws if the image's data does not have the size of its faces and mips.
+void write_dds(const std::filesystem::path &path, const dds_image_t &image);
+
+// Throws if the file is not a DDS file with the DX10 header extension, in one of the formats above.
+dds_image_t read_dds(const std::filesystem::path &path);
+} // namespace nether
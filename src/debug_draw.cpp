@@ -0,0 +1,278 @@
+#include "debug_draw.hpp"
+
+#include <chrono>
+
+namespace nether
+{
+namespace
+{
+using internal::debug_draw_thread_buffer_t;
+
+std::atomic<u64> next_debug_draw_id{1u};
+
+float3_t to_float3(const float4_t &vector)
+{
+    return float3_t{vector.x, vector.y, vector.z};
+}
+
+std::array<float3_t, 8> get_box_corners(const aabb_t &aabb)
+{
+    return {
+        float3_t{aabb.min.x, aabb.min.y, aabb.min.z}, float3_t{aabb.max.x, aabb.min.y, aabb.min.z},
+        float3_t{aabb.max.x, aabb.max.y, aabb.min.z}, float3_t{aabb.min.x, aabb.max.y, aabb.min.z},
+        float3_t{aabb.min.x, aabb.min.y, aabb.max.z}, float3_t{aabb.max.x, aabb.min.y, aabb.max.z},
+        float3_t{aabb.max.x, aabb.max.y, aabb.max.z}, float3_t{aabb.min.x, aabb.max.y, aabb.max.z},
+    };
+}
+} // namespace
+
+debug_draw_t::debug_draw_t() : id(next_debug_draw_id.fetch_add(1u, std::memory_order_relaxed))
+{
+}
+
+debug_draw_t::~debug_draw_t()
+{
+    debug_draw_thread_buffer_t *thread_buffer = thread_buffers.load(std::memory_order_acquire);
+    while (thread_buffer)
+    {
+        debug_draw_thread_buffer_t *const next = thread_buffer->next;
+        delete thread_buffer;
+        thread_buffer = next;
+    }
+}
+
+void debug_draw_t::draw_lines(const std::span<const debug_line_t> lines, const debug_draw_mode_t mode)
+{
+    std::vector<debug_line_t> &thread_lines = get_thread_lines(mode);
+    thread_lines.insert(thread_lines.end(), lines.begin(), lines.end());
+}
+
+void debug_draw_t::draw_box(const aabb_t &aabb, const u32 color, const debug_draw_mode_t mode)
+{
+    draw_hexahedron(get_box_corners(aabb), color, mode);
+}
+
+void debug_draw_t::draw_box(const aabb_t &aabb, const float4x4_t &matrix, const u32 color,
+                            const debug_draw_mode_t mode)
+{
+    std::array<float3_t, 8> corners = get_box_corners(aabb);
+    for (float3_t &corner : corners)
+    {
+        corner = to_float3(transform_point(corner, matrix));
+    }
+
+    draw_hexahedron(corners, color, mode);
+}
+
+void debug_draw_t::draw_sphere(const float3_t &center, const f32 radius, const u32 color, const u32 num_segments,
+                               const debug_draw_mode_t mode)
+{
+    if (num_segments < 3u)
+    {
+        throw std::runtime_error(std::format("A debug sphere needs at least 3 segments per circle, not {}",
+                                             num_segments));
+    }
+
+    std::vector<debug_line_t> &lines = get_thread_lines(mode);
+    lines.reserve(lines.size() + 3u * num_segments);
+
+    const f32 angle_step = 2.0f * std::numbers::pi_v<f32> / static_cast<f32>(num_segments);
+
+    float2_t previous_point{radius, 0.0f};
+    for (u32 i = 1u; i <= num_segments; i++)
+    {
+        // The last point is exactly the first, so that the circles are closed.
+        const f32 angle = i == num_segments ? 0.0f : angle_step * static_cast<f32>(i);
+        const float2_t point{std::cos(angle) * radius, std::sin(angle) * radius};
+
+        // Around the z, y and x axes.
+        lines.push_back(debug_line_t{
+            .start = center + float3_t{previous_point.x, previous_point.y, 0.0f},
+            .end = center + float3_t{point.x, point.y, 0.0f},
+            .color = color,
+        });
+        lines.push_back(debug_line_t{
+            .start = center + float3_t{previous_point.x, 0.0f, previous_point.y},
+            .end = center + float3_t{point.x, 0.0f, point.y},
+            .color = color,
+        });
+        lines.push_back(debug_line_t{
+            .start = center + float3_t{0.0f, previous_point.x, previous_point.y},
+            .end = center + float3_t{0.0f, point.x, point.y},
+            .color = color,
+        });
+
+        previous_point = point;
+    }
+}
+
+void debug_draw_t::draw_hexahedron(const std::array<float3_t, 8> &corners, const u32 color,
+                                   const debug_draw_mode_t mode)
+{
+    std::array<debug_line_t, 12> lines{};
+    for (u32 i = 0u; i < 4u; i++)
+    {
+        const u32 next = (i + 1u) % 4u;
+
+        // Near face, far face, and the edge between them.
+        lines[i * 3u + 0u] = debug_line_t{.start = corners[i], .end = corners[next], .color = color};
+        lines[i * 3u + 1u] = debug_line_t{.start = corners[i + 4u], .end = corners[next + 4u], .color = color};
+        lines[i * 3u + 2u] = debug_line_t{.start = corners[i], .end = corners[i + 4u], .color = color};
+    }
+
+    draw_lines(lines, mode);
+}
+
+void debug_draw_t::draw_frustum(const float3_t &eye, const float3_t &direction, const float3_t &up, const f32 fov_y,
+                                const f32 aspect_ratio, const f32 near_plane, const f32 far_plane, const u32 color,
+                                const debug_draw_mode_t mode)
+{
+    // Same basis as look_to_matrix.
+    const float3_t z_axis = normalize(direction);
+    const float3_t x_axis = normalize(cross(up, z_axis));
+    const float3_t y_axis = cross(z_axis, x_axis);
+
+    const f32 tan_half_fov_y = std::tan(0.5f * fov_y);
+
+    std::array<float3_t, 8> corners{};
+    for (u32 face = 0u; face < 2u; face++)
+    {
+        const f32 distance = face == 0u ? near_plane : far_plane;
+        const float3_t center = eye + z_axis * distance;
+        const float3_t half_height = y_axis * (distance * tan_half_fov_y);
+        const float3_t half_width = x_axis * (distance * tan_half_fov_y * aspect_ratio);
+
+        corners[face * 4u + 0u] = center - half_width - half_height;
+        corners[face * 4u + 1u] = center + half_width - half_height;
+        corners[face * 4u + 2u] = center + half_width + half_height;
+        corners[face * 4u + 3u] = center - half_width + half_height;
+    }
+
+    draw_hexahedron(corners, color, mode);
+}
+
+std::array<debug_line_range_t, NUM_DEBUG_DRAW_MODES> debug_draw_t::write_lines(const std::span<debug_line_t> lines,
+                                                                                 job_system_t *const job_system)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    // Split the lines of every thread into chunks, mode by mode, dropping the ones past the end of lines.
+    copies.clear();
+    statistics = debug_draw_statistics_t{};
+
+    std::array<debug_line_range_t, NUM_DEBUG_DRAW_MODES> ranges{};
+    u32 num_lines = 0u;
+
+    for (u32 mode = 0u; mode < NUM_DEBUG_DRAW_MODES; mode++)
+    {
+        ranges[mode].first_line = num_lines;
+
+        for (debug_draw_thread_buffer_t *thread_buffer = thread_buffers.load(std::memory_order_acquire); thread_buffer;
+             thread_buffer = thread_buffer->next)
+        {
+            const std::vector<debug_line_t> &thread_lines = thread_buffer->lines[mode];
+            const u32 num_thread_lines = static_cast<u32>(thread_lines.size());
+            const u32 num_written_lines = std::min(num_thread_lines, static_cast<u32>(lines.size()) - num_lines);
+
+            for (u32 begin = 0u; begin < num_written_lines; begin += CHUNK_SIZE)
+            {
+                copies.push_back(copy_t{
+                    .source = thread_lines.data() + begin,
+                    .first_line = num_lines + begin,
+                    .num_lines = std::min(CHUNK_SIZE, num_written_lines - begin),
+                });
+            }
+
+            num_lines += num_written_lines;
+            statistics.num_dropped_lines += num_thread_lines - num_written_lines;
+
+            if (mode == 0u)
+            {
+                statistics.num_threads++;
+            }
+        }
+
+        ranges[mode].num_lines = num_lines - ranges[mode].first_line;
+        statistics.num_lines[mode] = ranges[mode].num_lines;
+    }
+
+    const auto copy = [&](const u32 begin, const u32 end, const u32) {
+        for (u32 i = begin; i < end; i++)
+        {
+            const copy_t &chunk = copies[i];
+            std::memcpy(lines.data() + chunk.first_line, chunk.source, chunk.num_lines * sizeof(debug_line_t));
+        }
+    };
+
+    if (job_system && copies.size() > 1u)
+    {
+        job_system->parallel_for(static_cast<u32>(copies.size()), 1u, copy);
+    }
+    else
+    {
+        copy(0u, static_cast<u32>(copies.size()), 0u);
+    }
+
+    clear();
+
+    statistics.write_time_in_ms =
+        std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+    return ranges;
+}
+
+void debug_draw_t::clear()
+{
+    for (debug_draw_thread_buffer_t *thread_buffer = thread_buffers.load(std::memory_order_acquire); thread_buffer;
+         thread_buffer = thread_buffer->next)
+    {
+        for (std::vector<debug_line_t> &thread_lines : thread_buffer->lines)
+        {
+            thread_lines.clear();
+        }
+    }
+}
+
+u32 debug_draw_t::get_num_lines(const debug_draw_mode_t mode) const
+{
+    u32 num_lines = 0u;
+    for (const debug_draw_thread_buffer_t *thread_buffer = thread_buffers.load(std::memory_order_acquire);
+         thread_buffer; thread_buffer = thread_buffer->next)
+    {
+        num_lines += static_cast<u32>(thread_buffer->lines[static_cast<u32>(mode)].size());
+    }
+
+    return num_lines;
+}
+
+void debug_draw_t::cache_thread_buffer()
+{
+    // A thread pushes its buffer at most once, and only reads the buffers of the other threads (their ids, which are
+    // set before the buffers are published), so the list only needs a compare and swap to push.
+    const std::thread::id thread_id = std::this_thread::get_id();
+
+    debug_draw_thread_buffer_t *thread_buffer = thread_buffers.load(std::memory_order_acquire);
+    while (thread_buffer && thread_buffer->thread_id != thread_id)
+    {
+        thread_buffer = thread_buffer->next;
+    }
+
+    if (!thread_buffer)
+    {
+        thread_buffer = new debug_draw_thread_buffer_t{
+            .thread_id = thread_id,
+            .next = thread_buffers.load(std::memory_order_relaxed),
+        };
+
+        while (!thread_buffers.compare_exchange_weak(thread_buffer->next, thread_buffer, std::memory_order_release,
+                                                     std::memory_order_relaxed))
+        {
+        }
+    }
+
+    internal::g_debug_draw_thread_cache = internal::debug_draw_thread_cache_t{
+        .debug_draw_id = id,
+        .thread_buffer = thread_buffer,
+    };
+}
+} // namespace nether
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "common.hpp"
+#include "job_system.hpp"
+#include "math.hpp"
+
+#include <atomic>
+#include <thread>
+
+// Immediate mode debug drawing of lines and of shapes made of lines (boxes, spheres, frusta), for visualizing culling,
+// BVHs and lights without creating buffers and draws for each shape.
+//  - The draw functions can be called from any thread. Each thread appends to its own line buffers (one per mode),
+//    found through a thread local cache, so drawing takes no lock and no atomic read-modify-write.
+//  - At the end of the frame, write_lines merges the buffers of every thread into one (usually mapped upload) buffer,
+//    the depth tested lines first and then the on top lines, so that each mode is a single draw of
+//    shaders/debug_draw_shader.hlsl, which expands every line into a screen space quad.
+//  - The buffers keep their capacity across frames, so once the number of lines is stable, drawing does not allocate.
+namespace nether
+{
+enum class debug_draw_mode_t : u8
+{
+    // Hidden by the geometry in front of the lines.
+    depth_tested,
+
+    // Drawn over everything.
+    on_top,
+};
+
+static constexpr u32 NUM_DEBUG_DRAW_MODES = 2u;
+
+// RGBA8 unorm, red in the lowest byte.
+constexpr u32 make_debug_color(const u8 r, const u8 g, const u8 b, const u8 a = 255u)
+{
+    return static_cast<u32>(r) | (static_cast<u32>(g) << 8u) | (static_cast<u32>(b) << 16u) |
+           (static_cast<u32>(a) << 24u);
+}
+
+// Must match debug_line_t in shaders/debug_draw_shader.hlsl.
+struct debug_line_t
+{
+    float3_t start{};
+    float3_t end{};
+
+    // RGBA8 unorm, red in the lowest byte.
+    u32 color{};
+};
+
+// Lines [first_line, first_line + num_lines) of the buffer written by write_lines.
+struct debug_line_range_t
+{
+    u32 first_line{};
+    u32 num_lines{};
+};
+
+struct debug_draw_statistics_t
+{
+    // Written by the last write_lines.
+    std::array<u32, NUM_DEBUG_DRAW_MODES> num_lines{};
+
+    // Lines that did not fit in the buffer of the last write_lines.
+    u32 num_dropped_lines{};
+
+    // Threads that have drawn since the debug draw was created.
+    u32 num_threads{};
+
+    f32 write_time_in_ms{};
+};
+
+namespace internal
+{
+struct debug_draw_thread_buffer_t
+{
+    std::thread::id thread_id{};
+    std::array<std::vector<debug_line_t>, NUM_DEBUG_DRAW_MODES> lines{};
+
+    debug_draw_thread_buffer_t *next{};
+};
+
+// The buffer of the calling thread in the debug draw it was last used with. Most programs have a single debug draw, so
+// the buffer is only looked up on the first draw of each thread.
+struct debug_draw_thread_cache_t
+{
+    u64 debug_draw_id{};
+    debug_draw_thread_buffer_t *thread_buffer{};
+};
+
+inline constinit thread_local debug_draw_thread_cache_t g_debug_draw_thread_cache{};
+} // namespace internal
+
+class debug_draw_t
+{
+  public:
+    // Lines are copied by write_lines in chunks of this size, so that the lines of a single thread still copy in
+    // parallel.
+    static constexpr u32 CHUNK_SIZE = 16384u;
+
+    debug_draw_t();
+    ~debug_draw_t();
+
+    debug_draw_t(const debug_draw_t &) = delete;
+    debug_draw_t &operator=(const debug_draw_t &) = delete;
+
+    // Inline, as this is called for every line.
+    void draw_line(const float3_t &start, const float3_t &end, const u32 color,
+                   const debug_draw_mode_t mode = debug_draw_mode_t::depth_tested)
+    {
+        get_thread_lines(mode).push_back(debug_line_t{
+            .start = start,
+            .end = end,
+            .color = color,
+        });
+    }
+
+    // Appends the lines with a single lookup of the thread's buffer, which is cheaper than drawing them one by one.
+    void draw_lines(const std::span<const debug_line_t> lines,
+                    const debug_draw_mode_t mode = debug_draw_mode_t::depth_tested);
+
+    void draw_box(const aabb_t &aabb, const u32 color, const debug_draw_mode_t mode = debug_draw_mode_t::depth_tested);
+
+    // The box is transformed by the matrix (e.g the bounds of a mesh under its model matrix).
+    void draw_box(const aabb_t &aabb, const float4x4_t &matrix, const u32 color,
+                  const debug_draw_mode_t mode = debug_draw_mode_t::depth_tested);
+
+    // Three circles of num_segments lines each, around the x, y and z axes. Throws if num_segments is less than 3.
+    void draw_sphere(const float3_t &center, const f32 radius, const u32 color, const u32 num_segments = 32u,
+                     const debug_draw_mode_t mode = debug_draw_mode_t::depth_tested);
+
+    // The 12 edges of a hexahedron given by its near face and then its far face, each face in the order (-x, -y),
+    // (+x, -y), (+x, +y), (-x, +y) (in the space the corners are computed in).
+    void draw_hexahedron(const std::array<float3_t, 8> &corners, const u32 color,
+                         const debug_draw_mode_t mode = debug_draw_mode_t::depth_tested);
+
+    // The frustum of a perspective camera (see look_to_matrix and perspective_reverse_z_matrix), cut at far_plane as
+    // the projection has an infinite far plane.
+    void draw_frustum(const float3_t &eye, const float3_t &direction, const float3_t &up, const f32 fov_y,
+                      const f32 aspect_ratio, const f32 near_plane, const f32 far_plane, const u32 color,
+                      const debug_draw_mode_t mode = debug_draw_mode_t::depth_tested);
+
+    // Writes the lines drawn since the last write_lines (or clear) into lines, and clears them. Returns the range of
+    // lines of each mode. Lines that do not fit in lines are dropped (and counted in the statistics). lines is only
+    // written to, so it can be write combined upload memory.
+    // No thread may draw while the lines are written.
+    std::array<debug_line_range_t, NUM_DEBUG_DRAW_MODES> write_lines(const std::span<debug_line_t> lines,
+                                                                     job_system_t *const job_system = nullptr);
+
+    // Drops the lines drawn since the last write_lines. No thread may draw while the lines are cleared.
+    void clear();
+
+    // No thread may draw while the lines are counted.
+    u32 get_num_lines(const debug_draw_mode_t mode) const;
+
+  public:
+    debug_draw_statistics_t statistics{};
+
+  private:
+    // A chunk of the lines of a thread buffer, and where write_lines copies it.
+    struct copy_t
+    {
+        const debug_line_t *source{};
+        u32 first_line{};
+        u32 num_lines{};
+    };
+
+    std::vector<debug_line_t> &get_thread_lines(const debug_draw_mode_t mode)
+    {
+        if (internal::g_debug_draw_thread_cache.debug_draw_id != id) [[unlikely]]
+        {
+            cache_thread_buffer();
+        }
+
+        return internal::g_debug_draw_thread_cache.thread_buffer->lines[static_cast<u32>(mode)];
+    }
+
+    // Finds (or creates) the buffer of the calling thread, and caches it.
+    void cache_thread_buffer();
+
+  private:
+    // Distinguishes the debug draws in the thread local cache, as an address could be reused by a later debug draw.
+    u64 id{};
+
+    // Lock free list of the buffers of every thread that has drawn, newest first. A buffer is never removed (so a
+    // thread that exits leaves its buffer to a later thread with the same id), and is deleted with the debug draw.
+    std::atomic<internal::debug_draw_thread_buffer_t *> thread_buffers{};
+
+    // Reused by every write_lines.
+    std::vector<copy_t> copies{};
+};
+} // namespace nether
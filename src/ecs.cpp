@@ -0,0 +1,437 @@
+#include "ecs.hpp"
+
+namespace nether::ecs
+{
+// Component ids are assigned on first use, possibly from multiple threads.
+static std::mutex g_component_type_infos_mutex{};
+static std::array<component_type_info_t, MAX_COMPONENT_TYPES> g_component_type_infos{};
+static u32 g_num_component_types{};
+
+component_id_t register_component_type(const u32 size, const u32 alignment)
+{
+    std::scoped_lock lock(g_component_type_infos_mutex);
+
+    if (g_num_component_types == MAX_COMPONENT_TYPES)
+    {
+        throw std::runtime_error(std::string("Exceeded the maximum number of component types (") +
+                                 std::to_string(MAX_COMPONENT_TYPES) + ")");
+    }
+
+    if (alignment > CHUNK_ALIGNMENT)
+    {
+        throw std::runtime_error("Component alignment is larger than the chunk alignment");
+    }
+
+    g_component_type_infos[g_num_component_types] = {
+        .size = size,
+        .alignment = alignment,
+    };
+
+    return g_num_component_types++;
+}
+
+const component_type_info_t &get_component_type_info(const component_id_t component_id)
+{
+    return g_component_type_infos[component_id];
+}
+
+chunk_t::chunk_t()
+{
+    data = static_cast<u8 *>(::operator new(CHUNK_SIZE_IN_BYTES, std::align_val_t{CHUNK_ALIGNMENT}));
+}
+
+chunk_t::~chunk_t()
+{
+    ::operator delete(data, std::align_val_t{CHUNK_ALIGNMENT});
+}
+
+world_t::world_t()
+{
+    // Archetype 0 is the empty archetype.
+    get_or_create_archetype(0u);
+}
+
+entity_t world_t::create_entity(const component_mask_t component_mask)
+{
+    entity_t entity{};
+
+    if (!free_entity_indices.empty())
+    {
+        entity.index = free_entity_indices.back();
+        entity.generation = entity_records[entity.index].generation;
+
+        free_entity_indices.pop_back();
+    }
+    else
+    {
+        entity.index = static_cast<u32>(entity_records.size());
+        entity_records.emplace_back();
+    }
+
+    allocate_row(get_or_create_archetype(component_mask), entity);
+
+    return entity;
+}
+
+void world_t::destroy_entity(const entity_t entity)
+{
+    const entity_record_t entity_record = get_entity_record(entity);
+
+    remove_row(entity_record.archetype_index, entity_record.chunk_index, entity_record.row);
+
+    entity_records[entity.index] = {
+        .archetype_index = INVALID_INDEX,
+        .generation = entity.generation + 1u,
+    };
+    free_entity_indices.push_back(entity.index);
+}
+
+bool world_t::is_alive(const entity_t entity) const
+{
+    return entity.index < entity_records.size() && entity_records[entity.index].generation == entity.generation &&
+           entity_records[entity.index].archetype_index != INVALID_INDEX;
+}
+
+void *world_t::get_component(const entity_t entity, const component_id_t component_id)
+{
+    const entity_record_t &entity_record = get_entity_record(entity);
+    archetype_t &archetype = *archetypes[entity_record.archetype_index];
+
+    chunk_t &chunk = *archetype.chunks[entity_record.chunk_index];
+
+    u8 *const column = static_cast<u8 *>(archetype.get_column(chunk, component_id));
+    return column ? column + static_cast<size_t>(entity_record.row) * get_component_type_info(component_id).size
+                  : nullptr;
+}
+
+void world_t::add_component(const entity_t entity, const component_id_t component_id, const void *const data)
+{
+    const entity_record_t &entity_record = get_entity_record(entity);
+    archetype_t &archetype = *archetypes[entity_record.archetype_index];
+
+    if (!(archetype.mask & (component_mask_t{1u} << component_id)))
+    {
+        if (archetype.add_component_edges[component_id] == INVALID_INDEX)
+        {
+            // get_or_create_archetype can reallocate the archetypes vector, but archetypes are heap allocated so the
+            // reference above stays valid.
+            archetype.add_component_edges[component_id] =
+                get_or_create_archetype(archetype.mask | (component_mask_t{1u} << component_id));
+        }
+
+        move_entity(entity, archetype.add_component_edges[component_id]);
+    }
+
+    const u32 size = get_component_type_info(component_id).size;
+    if (size > 0u)
+    {
+        std::memcpy(get_component(entity, component_id), data, size);
+    }
+}
+
+void world_t::remove_component(const entity_t entity, const component_id_t component_id)
+{
+    const entity_record_t &entity_record = get_entity_record(entity);
+    archetype_t &archetype = *archetypes[entity_record.archetype_index];
+
+    if (!(archetype.mask & (component_mask_t{1u} << component_id)))
+    {
+        return;
+    }
+
+    if (archetype.remove_component_edges[component_id] == INVALID_INDEX)
+    {
+        archetype.remove_component_edges[component_id] =
+            get_or_create_archetype(archetype.mask & ~(component_mask_t{1u} << component_id));
+    }
+
+    move_entity(entity, archetype.remove_component_edges[component_id]);
+}
+
+bool world_t::has_component(const entity_t entity, const component_id_t component_id) const
+{
+    return archetypes[get_entity_record(entity).archetype_index]->mask & (component_mask_t{1u} << component_id);
+}
+
+void world_t::update_query(query_t &query) const
+{
+    for (; query.num_archetypes_checked < archetypes.size(); query.num_archetypes_checked++)
+    {
+        const component_mask_t archetype_mask = archetypes[query.num_archetypes_checked]->mask;
+
+        if ((archetype_mask & query.include_mask) == query.include_mask && !(archetype_mask & query.exclude_mask))
+        {
+            query.matching_archetype_indices.push_back(query.num_archetypes_checked);
+        }
+    }
+}
+
+u32 world_t::get_or_create_archetype(const component_mask_t component_mask)
+{
+    if (const auto archetype_iterator = component_mask_to_archetype_index.find(component_mask);
+        archetype_iterator != component_mask_to_archetype_index.end())
+    {
+        return archetype_iterator->second;
+    }
+
+    std::unique_ptr<archetype_t> archetype = std::make_unique<archetype_t>();
+    archetype->mask = component_mask;
+    archetype->column_offsets.fill(INVALID_INDEX);
+    archetype->add_component_edges.fill(INVALID_INDEX);
+    archetype->remove_component_edges.fill(INVALID_INDEX);
+
+    u32 bytes_per_entity = static_cast<u32>(sizeof(entity_t));
+    for (component_id_t component_id = 0u; component_id < MAX_COMPONENT_TYPES; component_id++)
+    {
+        if (component_mask & (component_mask_t{1u} << component_id))
+        {
+            archetype->component_ids.push_back(component_id);
+            bytes_per_entity += get_component_type_info(component_id).size;
+        }
+    }
+
+    // Start with the capacity ignoring alignment padding, and shrink it until all the (aligned) arrays fit.
+    for (archetype->chunk_capacity = CHUNK_SIZE_IN_BYTES / bytes_per_entity; archetype->chunk_capacity > 0u;
+         archetype->chunk_capacity--)
+    {
+        u32 offset = archetype->chunk_capacity * static_cast<u32>(sizeof(entity_t));
+
+        for (const component_id_t component_id : archetype->component_ids)
+        {
+            const component_type_info_t &component_type_info = get_component_type_info(component_id);
+            if (component_type_info.size == 0u)
+            {
+                continue;
+            }
+
+            offset = (offset + component_type_info.alignment - 1u) & ~(component_type_info.alignment - 1u);
+            archetype->column_offsets[component_id] = offset;
+
+            offset += component_type_info.size * archetype->chunk_capacity;
+        }
+
+        if (offset <= CHUNK_SIZE_IN_BYTES)
+        {
+            break;
+        }
+    }
+
+    if (archetype->chunk_capacity == 0u)
+    {
+        throw std::runtime_error("Components of archetype do not fit in a single chunk");
+    }
+
+    const u32 archetype_index = static_cast<u32>(archetypes.size());
+
+    archetypes.push_back(std::move(archetype));
+    component_mask_to_archetype_index[component_mask] = archetype_index;
+
+    return archetype_index;
+}
+
+void world_t::allocate_row(const u32 archetype_index, const entity_t entity)
+{
+    archetype_t &archetype = *archetypes[archetype_index];
+
+    if (archetype.chunks.empty() || archetype.chunks.back()->count == archetype.chunk_capacity)
+    {
+        archetype.chunks.push_back(std::make_unique<chunk_t>());
+    }
+
+    chunk_t &chunk = *archetype.chunks.back();
+    archetype.get_entities(chunk)[chunk.count] = entity;
+
+    entity_records[entity.index] = {
+        .archetype_index = archetype_index,
+        .chunk_index = static_cast<u32>(archetype.chunks.size() - 1u),
+        .row = chunk.count,
+        .generation = entity.generation,
+    };
+
+    chunk.count++;
+    archetype.num_entities++;
+}
+
+void world_t::remove_row(const u32 archetype_index, const u32 chunk_index, const u32 row)
+{
+    archetype_t &archetype = *archetypes[archetype_index];
+
+    chunk_t &chunk = *archetype.chunks[chunk_index];
+    chunk_t &last_chunk = *archetype.chunks.back();
+
+    const u32 last_row = last_chunk.count - 1u;
+
+    if (&chunk != &last_chunk || row != last_row)
+    {
+        const entity_t moved_entity = archetype.get_entities(last_chunk)[last_row];
+        archetype.get_entities(chunk)[row] = moved_entity;
+
+        for (const component_id_t component_id : archetype.component_ids)
+        {
+            const u32 size = get_component_type_info(component_id).size;
+            if (size == 0u)
+            {
+                continue;
+            }
+
+            u8 *const destination = static_cast<u8 *>(archetype.get_column(chunk, component_id)) + size * row;
+            const u8 *const source =
+                static_cast<u8 *>(archetype.get_column(last_chunk, component_id)) + size * last_row;
+
+            std::memcpy(destination, source, size);
+        }
+
+        entity_records[moved_entity.index].chunk_index = chunk_index;
+        entity_records[moved_entity.index].row = row;
+    }
+
+    last_chunk.count--;
+    archetype.num_entities--;
+
+    if (last_chunk.count == 0u)
+    {
+        archetype.chunks.pop_back();
+    }
+}
+
+void world_t::move_entity(const entity_t entity, const u32 new_archetype_index)
+{
+    const entity_record_t old_entity_record = get_entity_record(entity);
+
+    archetype_t &old_archetype = *archetypes[old_entity_record.archetype_index];
+    archetype_t &new_archetype = *archetypes[new_archetype_index];
+
+    allocate_row(new_archetype_index, entity);
+
+    const entity_record_t &new_entity_record = entity_records[entity.index];
+
+    chunk_t &old_chunk = *old_archetype.chunks[old_entity_record.chunk_index];
+    chunk_t &new_chunk = *new_archetype.chunks[new_entity_record.chunk_index];
+
+    // Copy all components that both archetypes share.
+    for (const component_id_t component_id : old_archetype.component_ids)
+    {
+        const u32 size = get_component_type_info(component_id).size;
+        if (size == 0u || !(new_archetype.mask & (component_mask_t{1u} << component_id)))
+        {
+            continue;
+        }
+
+        std::memcpy(static_cast<u8 *>(new_archetype.get_column(new_chunk, component_id)) + size * new_entity_record.row,
+                    static_cast<u8 *>(old_archetype.get_column(old_chunk, component_id)) + size * old_entity_record.row,
+                    size);
+    }
+
+    remove_row(old_entity_record.archetype_index, old_entity_record.chunk_index, old_entity_record.row);
+}
+
+const world_t::entity_record_t &world_t::get_entity_record(const entity_t entity) const
+{
+    if (!is_alive(entity))
+    {
+        throw std::runtime_error("Entity is not alive");
+    }
+
+    return entity_records[entity.index];
+}
+
+void command_buffer_t::destroy_entity(const entity_t entity)
+{
+    finish_command(record_header(command_type_t::destroy_entity, entity, 0u));
+}
+
+void command_buffer_t::playback(world_t &world, std::vector<entity_t> *const created_entities)
+{
+    size_t offset = 0u;
+    while (offset < command_data.size())
+    {
+        command_header_t header{};
+        std::memcpy(&header, command_data.data() + offset, sizeof(command_header_t));
+        offset += sizeof(command_header_t);
+
+        const u8 *const payload = command_data.data() + offset;
+
+        switch (header.type)
+        {
+        case command_type_t::create_entity: {
+            component_mask_t component_mask{};
+            std::memcpy(&component_mask, payload, sizeof(component_mask_t));
+
+            const entity_t entity = world.create_entity(component_mask);
+
+            // The payload is a sequence of (component id, component data) pairs.
+            for (size_t payload_offset = sizeof(component_mask_t); payload_offset < header.payload_size;)
+            {
+                component_id_t component_id{};
+                std::memcpy(&component_id, payload + payload_offset, sizeof(component_id_t));
+                payload_offset += sizeof(component_id_t);
+
+                const u32 size = get_component_type_info(component_id).size;
+                if (size > 0u)
+                {
+                    std::memcpy(world.get_component(entity, component_id), payload + payload_offset, size);
+                }
+
+                payload_offset += size;
+            }
+
+            if (created_entities)
+            {
+                created_entities->push_back(entity);
+            }
+        }
+        break;
+
+        case command_type_t::destroy_entity: {
+            world.destroy_entity(header.entity);
+        }
+        break;
+
+        case command_type_t::add_component: {
+            world.add_component(header.entity, header.component_id, payload);
+        }
+        break;
+
+        case command_type_t::remove_component: {
+            world.remove_component(header.entity, header.component_id);
+        }
+        break;
+        }
+
+        offset += header.payload_size;
+    }
+
+    command_data.clear();
+}
+
+size_t command_buffer_t::record_header(const command_type_t type, const entity_t entity,
+                                       const component_id_t component_id)
+{
+    const size_t header_offset = command_data.size();
+
+    const command_header_t header = {
+        .type = type,
+        .component_id = component_id,
+        .entity = entity,
+        .payload_size = 0u,
+    };
+    append(&header, sizeof(command_header_t));
+
+    return header_offset;
+}
+
+void command_buffer_t::append(const void *const data, const size_t size)
+{
+    const size_t offset = command_data.size();
+
+    command_data.resize(offset + size);
+    std::memcpy(command_data.data() + offset, data, size);
+}
+
+void command_buffer_t::finish_command(const size_t header_offset)
+{
+    const u32 payload_size = static_cast<u32>(command_data.size() - header_offset - sizeof(command_header_t));
+    std::memcpy(command_data.data() + header_offset + offsetof(command_header_t, payload_size), &payload_size,
+                sizeof(u32));
+}
+} // namespace nether::ecs
@@ -0,0 +1,378 @@
+#pragma once
+
+#include "common.hpp"
+#include "job_system.hpp"
+
+#include <type_traits>
+
+// An archetype based entity component store.
+// Entities with the exact same set of components belong to the same archetype. Each archetype stores its entities in
+// fixed size chunks, where every component has its own tightly packed array (SoA). Queries cache the list of matching
+// archetypes and iterate their chunks linearly.
+// Structural changes (creating / destroying entities, adding / removing components) move data between chunks, so they
+// must not happen while iterating. Record them into a command_buffer_t instead, and play it back afterwards.
+namespace nether::ecs
+{
+using component_id_t = u32;
+using component_mask_t = u64;
+
+static constexpr u32 MAX_COMPONENT_TYPES = 64u;
+
+static constexpr u32 CHUNK_SIZE_IN_BYTES = 16u * 1024u;
+static constexpr u32 CHUNK_ALIGNMENT = 64u;
+
+static constexpr u32 INVALID_INDEX = ~0u;
+
+struct entity_t
+{
+    u32 index{INVALID_INDEX};
+    u32 generation{};
+
+    bool operator==(const entity_t &other) const = default;
+};
+
+struct component_type_info_t
+{
+    // Tag components (empty structs) have a size of 0 and no storage.
+    u32 size{};
+    u32 alignment{};
+};
+
+// Registers a new component type, and returns its id. Prefer get_component_id<T>().
+component_id_t register_component_type(const u32 size, const u32 alignment);
+
+const component_type_info_t &get_component_type_info(const component_id_t component_id);
+
+template <typename T> component_id_t get_component_id()
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Components are moved between chunks with memcpy");
+
+    static const component_id_t component_id =
+        register_component_type(std::is_empty_v<T> ? 0u : static_cast<u32>(sizeof(T)), static_cast<u32>(alignof(T)));
+
+    return component_id;
+}
+
+template <typename... Ts> component_mask_t get_component_mask()
+{
+    return ((component_mask_t{1u} << get_component_id<Ts>()) | ... | component_mask_t{0u});
+}
+
+struct chunk_t
+{
+    chunk_t();
+    ~chunk_t();
+
+    chunk_t(const chunk_t &) = delete;
+    chunk_t &operator=(const chunk_t &) = delete;
+
+    u8 *data{};
+    u32 count{};
+};
+
+struct archetype_t
+{
+    entity_t *get_entities(chunk_t &chunk) const
+    {
+        return reinterpret_cast<entity_t *>(chunk.data);
+    }
+
+    void *get_column(chunk_t &chunk, const component_id_t component_id) const
+    {
+        return column_offsets[component_id] == INVALID_INDEX ? nullptr : chunk.data + column_offsets[component_id];
+    }
+
+    template <typename T> T *get_column(chunk_t &chunk) const
+    {
+        return static_cast<T *>(get_column(chunk, get_component_id<T>()));
+    }
+
+    component_mask_t mask{};
+    std::vector<component_id_t> component_ids{};
+
+    // Byte offset of each component's array within a chunk (INVALID_INDEX if the archetype does not have the component,
+    // or if it is a tag). The entity_t array is always at offset 0.
+    std::array<u32, MAX_COMPONENT_TYPES> column_offsets{};
+
+    u32 chunk_capacity{};
+
+    // All chunks except the last one are always full.
+    std::vector<std::unique_ptr<chunk_t>> chunks{};
+    u32 num_entities{};
+
+    // Cache of the archetype reached by adding / removing a component (INVALID_INDEX if not computed yet).
+    std::array<u32, MAX_COMPONENT_TYPES> add_component_edges{};
+    std::array<u32, MAX_COMPONENT_TYPES> remove_component_edges{};
+};
+
+// A query matches every archetype that has all components of include_mask and none of exclude_mask. Archetypes are
+// never destroyed, so the list of matching archetypes is updated incrementally when new archetypes are created.
+struct query_t
+{
+    component_mask_t include_mask{};
+    component_mask_t exclude_mask{};
+
+    std::vector<u32> matching_archetype_indices{};
+    u32 num_archetypes_checked{};
+};
+
+class world_t
+{
+  public:
+    world_t();
+
+    entity_t create_entity(const component_mask_t component_mask = 0u);
+
+    template <typename... Ts> entity_t create_entity(const Ts &...components)
+    {
+        const entity_t entity = create_entity(get_component_mask<Ts...>());
+        (set_component(entity, components), ...);
+
+        return entity;
+    }
+
+    void destroy_entity(const entity_t entity);
+
+    bool is_alive(const entity_t entity) const;
+
+    // Returns nullptr if the entity does not have the component (or if the component is a tag).
+    void *get_component(const entity_t entity, const component_id_t component_id);
+
+    void add_component(const entity_t entity, const component_id_t component_id, const void *const data);
+    void remove_component(const entity_t entity, const component_id_t component_id);
+
+    bool has_component(const entity_t entity, const component_id_t component_id) const;
+
+    template <typename T> T *get_component(const entity_t entity)
+    {
+        return static_cast<T *>(get_component(entity, get_component_id<T>()));
+    }
+
+    // Adds the component if the entity does not have it, else overwrites it.
+    template <typename T> void add_component(const entity_t entity, const T &component)
+    {
+        add_component(entity, get_component_id<T>(), &component);
+    }
+
+    template <typename T> void remove_component(const entity_t entity)
+    {
+        remove_component(entity, get_component_id<T>());
+    }
+
+    template <typename T> bool has_component(const entity_t entity) const
+    {
+        return has_component(entity, get_component_id<T>());
+    }
+
+    template <typename... Ts> query_t create_query(const component_mask_t exclude_mask = 0u) const
+    {
+        query_t query = {
+            .include_mask = get_component_mask<Ts...>(),
+            .exclude_mask = exclude_mask,
+        };
+        update_query(query);
+
+        return query;
+    }
+
+    void update_query(query_t &query) const;
+
+    // Calls function(count, entities, Ts *...columns) for every chunk that matches the query. Every type in Ts must be
+    // part of the query's include mask.
+    template <typename... Ts, typename Fn> void for_each_chunk(query_t &query, Fn &&function)
+    {
+        validate_query_types<Ts...>(query);
+        update_query(query);
+
+        for (const u32 archetype_index : query.matching_archetype_indices)
+        {
+            archetype_t &archetype = *archetypes[archetype_index];
+            for (std::unique_ptr<chunk_t> &chunk : archetype.chunks)
+            {
+                function(chunk->count, archetype.get_entities(*chunk), archetype.template get_column<Ts>(*chunk)...);
+            }
+        }
+    }
+
+    // Calls function(entity, Ts &...components) for every entity that matches the query.
+    template <typename... Ts, typename Fn> void for_each(query_t &query, Fn &&function)
+    {
+        for_each_chunk<Ts...>(query, [&](const u32 count, const entity_t *const entities, Ts *const... columns) {
+            for (u32 i = 0u; i < count; i++)
+            {
+                function(entities[i], columns[i]...);
+            }
+        });
+    }
+
+    // Same as for_each_chunk, but chunks are distributed across the job system's threads. The function additionally
+    // receives the index of the executing thread (for example, to select a per thread command buffer) :
+    //  function(thread_index, count, entities, Ts *...columns).
+    template <typename... Ts, typename Fn>
+    void parallel_for_each_chunk(job_system_t &job_system, query_t &query, Fn &&function)
+    {
+        validate_query_types<Ts...>(query);
+        update_query(query);
+
+        struct chunk_reference_t
+        {
+            archetype_t *archetype{};
+            chunk_t *chunk{};
+        };
+
+        std::vector<chunk_reference_t> chunk_references{};
+        for (const u32 archetype_index : query.matching_archetype_indices)
+        {
+            for (std::unique_ptr<chunk_t> &chunk : archetypes[archetype_index]->chunks)
+            {
+                chunk_references.push_back({archetypes[archetype_index].get(), chunk.get()});
+            }
+        }
+
+        job_system.parallel_for(static_cast<u32>(chunk_references.size()), 1u,
+                                [&](const u32 begin, const u32 end, const u32 thread_index) {
+                                    for (u32 i = begin; i < end; i++)
+                                    {
+                                        archetype_t &archetype = *chunk_references[i].archetype;
+                                        chunk_t &chunk = *chunk_references[i].chunk;
+
+                                        function(thread_index, chunk.count, archetype.get_entities(chunk),
+                                                 archetype.template get_column<Ts>(chunk)...);
+                                    }
+                                });
+    }
+
+    u32 get_num_entities() const
+    {
+        return static_cast<u32>(entity_records.size() - free_entity_indices.size());
+    }
+
+  private:
+    struct entity_record_t
+    {
+        u32 archetype_index{INVALID_INDEX};
+        u32 chunk_index{};
+        u32 row{};
+        u32 generation{};
+    };
+
+    template <typename... Ts> void validate_query_types(const query_t &query) const
+    {
+        if constexpr (NETHER_DEBUG)
+        {
+            if ((get_component_mask<Ts...>() & query.include_mask) != get_component_mask<Ts...>())
+            {
+                throw std::runtime_error("Iterated component types must be part of the query's include mask");
+            }
+        }
+    }
+
+    template <typename T> void set_component(const entity_t entity, const T &component)
+    {
+        if constexpr (!std::is_empty_v<T>)
+        {
+            std::memcpy(get_component<T>(entity), &component, sizeof(T));
+        }
+    }
+
+    u32 get_or_create_archetype(const component_mask_t component_mask);
+
+    // Appends a row for the entity to the archetype's last chunk (allocating a new chunk if required).
+    void allocate_row(const u32 archetype_index, const entity_t entity);
+
+    // Removes the row by moving the archetype's very last row into it, so that chunks stay tightly packed.
+    void remove_row(const u32 archetype_index, const u32 chunk_index, const u32 row);
+
+    void move_entity(const entity_t entity, const u32 new_archetype_index);
+
+    const entity_record_t &get_entity_record(const entity_t entity) const;
+
+  private:
+    std::vector<std::unique_ptr<archetype_t>> archetypes{};
+    std::unordered_map<component_mask_t, u32> component_mask_to_archetype_index{};
+
+    std::vector<entity_record_t> entity_records{};
+    std::vector<u32> free_entity_indices{};
+};
+
+// Records structural changes to be applied to a world later (for example, from within a parallel system, with one
+// command buffer per thread). Commands are applied in recording order by playback.
+class command_buffer_t
+{
+  public:
+    template <typename... Ts> void create_entity(const Ts &...components)
+    {
+        const component_mask_t component_mask = get_component_mask<Ts...>();
+
+        const size_t header_offset = record_header(command_type_t::create_entity, entity_t{}, 0u);
+        append(&component_mask, sizeof(component_mask_t));
+        (append_component(components), ...);
+
+        finish_command(header_offset);
+    }
+
+    void destroy_entity(const entity_t entity);
+
+    template <typename T> void add_component(const entity_t entity, const T &component)
+    {
+        const size_t header_offset = record_header(command_type_t::add_component, entity, get_component_id<T>());
+        if constexpr (!std::is_empty_v<T>)
+        {
+            append(&component, sizeof(T));
+        }
+
+        finish_command(header_offset);
+    }
+
+    template <typename T> void remove_component(const entity_t entity)
+    {
+        finish_command(record_header(command_type_t::remove_component, entity, get_component_id<T>()));
+    }
+
+    // Applies all recorded commands to the world and clears the buffer. If created_entities is not null, the entities
+    // created by create_entity commands are appended to it in recording order.
+    void playback(world_t &world, std::vector<entity_t> *const created_entities = nullptr);
+
+    bool is_empty() const
+    {
+        return command_data.empty();
+    }
+
+  private:
+    enum class command_type_t : u32
+    {
+        create_entity,
+        destroy_entity,
+        add_component,
+        remove_component,
+    };
+
+    struct command_header_t
+    {
+        command_type_t type{};
+        component_id_t component_id{};
+        entity_t entity{};
+
+        // Number of bytes that follow the header.
+        u32 payload_size{};
+    };
+
+    template <typename T> void append_component(const T &component)
+    {
+        const component_id_t component_id = get_component_id<T>();
+        append(&component_id, sizeof(component_id_t));
+
+        if constexpr (!std::is_empty_v<T>)
+        {
+            append(&component, sizeof(T));
+        }
+    }
+
+    size_t record_header(const command_type_t type, const entity_t entity, const component_id_t component_id);
+    void append(const void *const data, const size_t size);
+    void finish_command(const size_t header_offset);
+
+  private:
+    std::vector<u8> command_data{};
+};
+} // namespace nether::ecs
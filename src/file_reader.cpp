@@ -0,0 +1,81 @@
+#include "file_reader.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace nether
+{
+#ifdef _WIN32
+file_reader_t::file_reader_t(const std::filesystem::path &path)
+{
+    file_handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error(std::format("Failed to open file {}", path.string()));
+    }
+}
+
+file_reader_t::~file_reader_t()
+{
+    CloseHandle(file_handle);
+}
+
+void file_reader_t::read(const u64 offset, void *const data, const size_t size) const
+{
+    // The offset of a synchronous read is given by the OVERLAPPED structure, so reads from multiple threads do not
+    // race on the file pointer.
+    size_t num_read_bytes = 0u;
+    while (num_read_bytes < size)
+    {
+        const u64 read_offset = offset + num_read_bytes;
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(read_offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(read_offset >> 32u);
+
+        const DWORD num_requested_bytes = static_cast<DWORD>(std::min<size_t>(size - num_read_bytes, 1u << 30u));
+        DWORD num_bytes = 0u;
+        if (!ReadFile(file_handle, static_cast<u8 *>(data) + num_read_bytes, num_requested_bytes, &num_bytes,
+                      &overlapped) ||
+            num_bytes == 0u)
+        {
+            throw std::runtime_error(std::format("Failed to read {} bytes at offset {}", size, offset));
+        }
+
+        num_read_bytes += num_bytes;
+    }
+}
+#else
+file_reader_t::file_reader_t(const std::filesystem::path &path)
+{
+    file_descriptor = open(path.c_str(), O_RDONLY);
+    if (file_descriptor < 0)
+    {
+        throw std::runtime_error(std::format("Failed to open file {}", path.string()));
+    }
+}
+
+file_reader_t::~file_reader_t()
+{
+    close(file_descriptor);
+}
+
+void file_reader_t::read(const u64 offset, void *const data, const size_t size) const
+{
+    size_t num_read_bytes = 0u;
+    while (num_read_bytes < size)
+    {
+        const ssize_t num_bytes = pread(file_descriptor, static_cast<u8 *>(data) + num_read_bytes,
+                                        size - num_read_bytes, static_cast<off_t>(offset + num_read_bytes));
+        if (num_bytes <= 0)
+        {
+            throw std::runtime_error(std::format("Failed to read {} bytes at offset {}", size, offset));
+        }
+
+        num_read_bytes += static_cast<size_t>(num_bytes);
+    }
+}
+#endif
+} // namespace nether
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace nether
+{
+// Positional reads of a file, which can be issued from multiple threads at once.
+class file_reader_t
+{
+  public:
+    // Throws if the file can not be opened.
+    explicit file_reader_t(const std::filesystem::path &path);
+    ~file_reader_t();
+
+    file_reader_t(const file_reader_t &) = delete;
+    file_reader_t &operator=(const file_reader_t &) = delete;
+
+    // Throws if less than size bytes could be read.
+    void read(const u64 offset, void *const data, const size_t size) const;
+
+  private:
+#ifdef _WIN32
+    HANDLE file_handle{INVALID_HANDLE_VALUE};
+#else
+    int file_descriptor{-1};
+#endif
+};
+} // namespace nether
@@ -0,0 +1,347 @@
+#include "frame_statistics.hpp"
+
+#include <cmath>
+
+namespace nether
+{
+namespace
+{
+u32 to_microseconds(const f32 time_in_ms)
+{
+    return static_cast<u32>(std::clamp(time_in_ms * 1000.0f + 0.5f, 0.0f, 4.0e9f));
+}
+
+f32 to_milliseconds(const u32 time_in_us)
+{
+    return time_in_us / 1000.0f;
+}
+
+void append_summary_json(std::string &json, const std::string_view name, const duration_summary_t &summary,
+                         const bool last)
+{
+    std::format_to(std::back_inserter(json),
+                   "    \"{}\": {{\"count\": {}, \"mean_ms\": {:.3f}, \"min_ms\": {:.3f}, \"p50_ms\": {:.3f}, "
+                   "\"p95_ms\": {:.3f}, \"p99_ms\": {:.3f}, \"max_ms\": {:.3f}}}{}\n",
+                   name, summary.count, summary.mean_in_ms, summary.min_in_ms, summary.p50_in_ms, summary.p95_in_ms,
+                   summary.p99_in_ms, summary.max_in_ms, last ? "" : ",");
+}
+} // namespace
+
+void duration_histogram_t::merge(const duration_histogram_t &other)
+{
+    for (u32 i = 0u; i < NUM_BUCKETS; i++)
+    {
+        counts[i] += other.counts[i];
+    }
+
+    total_count += other.total_count;
+    sum_in_us += other.sum_in_us;
+    min_value_in_us = std::min(min_value_in_us, other.min_value_in_us);
+    max_value_in_us = std::max(max_value_in_us, other.max_value_in_us);
+}
+
+void duration_histogram_t::reset()
+{
+    *this = {};
+}
+
+u32 duration_histogram_t::get_percentile(const f32 percentile) const
+{
+    u32 value_in_us = 0u;
+    get_percentiles(std::span(&percentile, 1u), std::span(&value_in_us, 1u));
+
+    return value_in_us;
+}
+
+void duration_histogram_t::get_percentiles(const std::span<const f32> percentiles,
+                                           const std::span<u32> values_in_us) const
+{
+    std::fill(values_in_us.begin(), values_in_us.end(), 0u);
+    if (total_count == 0u)
+    {
+        return;
+    }
+
+    u32 percentile_index = 0u;
+    u64 cumulative_count = 0u;
+    for (u32 bucket_index = 0u; bucket_index < NUM_BUCKETS && percentile_index < percentiles.size(); bucket_index++)
+    {
+        cumulative_count += counts[bucket_index];
+
+        // The value at a percentile is the value of rank ceil(percentile * count) (at least 1) in sorted order.
+        while (percentile_index < percentiles.size())
+        {
+            const f64 fraction = std::clamp(percentiles[percentile_index] / 100.0, 0.0, 1.0);
+            const u64 rank = std::max(static_cast<u64>(std::ceil(fraction * total_count)), u64{1u});
+            if (cumulative_count < rank)
+            {
+                break;
+            }
+
+            // The exact max is known, and is a tighter bound for the last bucket.
+            values_in_us[percentile_index] = std::min(get_bucket_upper_bound(bucket_index), max_value_in_us);
+            percentile_index++;
+        }
+    }
+}
+
+u32 duration_histogram_t::get_bucket_upper_bound(const u32 bucket_index)
+{
+    if (bucket_index < SUB_BUCKET_COUNT)
+    {
+        return bucket_index;
+    }
+
+    const u32 shift = (bucket_index - SUB_BUCKET_COUNT) / SUB_BUCKET_HALF_COUNT + 1u;
+    const u32 sub_bucket = (bucket_index - SUB_BUCKET_COUNT) % SUB_BUCKET_HALF_COUNT + SUB_BUCKET_HALF_COUNT;
+
+    return (sub_bucket << shift) + ((1u << shift) - 1u);
+}
+
+duration_summary_t summarize(const duration_histogram_t &histogram)
+{
+    static constexpr std::array<f32, 3> percentiles = {50.0f, 95.0f, 99.0f};
+
+    std::array<u32, 3> percentile_values_in_us{};
+    histogram.get_percentiles(percentiles, percentile_values_in_us);
+
+    return {
+        .count = histogram.get_count(),
+        .mean_in_ms = static_cast<f32>(histogram.get_mean() / 1000.0),
+        .min_in_ms = to_milliseconds(histogram.get_min()),
+        .p50_in_ms = to_milliseconds(percentile_values_in_us[0]),
+        .p95_in_ms = to_milliseconds(percentile_values_in_us[1]),
+        .p99_in_ms = to_milliseconds(percentile_values_in_us[2]),
+        .max_in_ms = to_milliseconds(histogram.get_max()),
+    };
+}
+
+frame_statistics_t::frame_statistics_t(const std::span<const std::string_view> phase_names,
+                                       const frame_statistics_config_t &config, job_system_t *const job_system)
+    : config(config), job_system(job_system)
+{
+    if (phase_names.size() > MAX_PHASES)
+    {
+        throw std::runtime_error(
+            std::format("Frame statistics support at most {} phases (got {})", MAX_PHASES, phase_names.size()));
+    }
+
+    for (const std::string_view phase_name : phase_names)
+    {
+        this->phase_names.emplace_back(phase_name);
+    }
+
+    if (!config.export_directory.empty())
+    {
+        std::filesystem::create_directories(config.export_directory);
+
+        const std::filesystem::path csv_path = config.export_directory / "frame_statistics.csv";
+        std::ofstream csv_file(csv_path, std::ios::trunc);
+        if (!csv_file.is_open())
+        {
+            throw std::runtime_error(std::format("Failed to create frame statistics file {}", csv_path.string()));
+        }
+
+        csv_file << "frame,frame_time_ms";
+        for (const std::string &phase_name : this->phase_names)
+        {
+            csv_file << ',' << phase_name << "_ms";
+        }
+        csv_file << ",hitch\n";
+
+        export_queue = std::make_unique<spsc_ring_buffer_t<frame_record_t, EXPORT_QUEUE_CAPACITY>>();
+    }
+
+    frame_start_time = std::chrono::steady_clock::now();
+    phase_start_time = frame_start_time;
+    window_start_time = frame_start_time;
+}
+
+frame_statistics_t::~frame_statistics_t()
+{
+    {
+        std::unique_lock lock(export_mutex);
+        export_condition_variable.wait(lock, [&]() { return !export_in_flight.load(std::memory_order_acquire); });
+    }
+
+    if (export_queue && window_histograms[0].get_count() > 0u)
+    {
+        job_system = nullptr;
+        end_window();
+    }
+}
+
+void frame_statistics_t::end_phase(const u32 phase_index)
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    current_durations_in_ms[1u + phase_index] += std::chrono::duration<f32, std::milli>(now - phase_start_time).count();
+    phase_start_time = now;
+}
+
+void frame_statistics_t::end_frame()
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    const f32 frame_time_in_ms = std::chrono::duration<f32, std::milli>(now - frame_start_time).count();
+    current_durations_in_ms[0] = frame_time_in_ms;
+
+    frame_start_time = now;
+    phase_start_time = now;
+
+    const u32 num_durations = 1u + get_num_phases();
+    for (u32 i = 0u; i < num_durations; i++)
+    {
+        window_histograms[i].record(to_microseconds(current_durations_in_ms[i]));
+    }
+
+    const bool hitch =
+        hitch_reference_time_in_ms > 0.0f && frame_time_in_ms > config.hitch_ratio * hitch_reference_time_in_ms;
+    if (hitch)
+    {
+        num_hitches++;
+
+        std::shift_right(recent_hitches.begin(), recent_hitches.end(), 1);
+        recent_hitches[0] = {
+            .frame_index = num_frames,
+            .frame_time_in_ms = frame_time_in_ms,
+            .reference_time_in_ms = hitch_reference_time_in_ms,
+        };
+        num_recent_hitches = std::min(num_recent_hitches + 1u, MAX_RECENT_HITCHES);
+    }
+
+    if (export_queue)
+    {
+        const frame_record_t frame_record = {
+            .frame_index = num_frames,
+            .durations_in_ms = current_durations_in_ms,
+            .hitch = hitch,
+        };
+
+        if (!export_queue->push(frame_record))
+        {
+            num_dropped_exported_frames++;
+        }
+    }
+
+    frame_time_history[num_frames % FRAME_TIME_HISTORY_SIZE] = frame_time_in_ms;
+    last_frame_time_in_ms = frame_time_in_ms;
+    num_frames++;
+
+    current_durations_in_ms = {};
+
+    if (std::chrono::duration<f32>(now - window_start_time).count() >= config.window_time_in_s)
+    {
+        end_window();
+        window_start_time = now;
+    }
+}
+
+void frame_statistics_t::end_window()
+{
+    const u32 num_durations = 1u + get_num_phases();
+    for (u32 i = 0u; i < num_durations; i++)
+    {
+        run_histograms[i].merge(window_histograms[i]);
+
+        window_summaries[i] = summarize(window_histograms[i]);
+        run_summaries[i] = summarize(run_histograms[i]);
+
+        window_histograms[i].reset();
+    }
+
+    hitch_reference_time_in_ms = window_summaries[0].p50_in_ms;
+
+    // If the previous export is still running, the frames stay queued until the next window.
+    if (!export_queue || export_in_flight.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    const export_snapshot_t snapshot = {
+        .num_frames = num_frames,
+        .num_hitches = num_hitches,
+        .window_summaries = window_summaries,
+        .run_summaries = run_summaries,
+    };
+
+    export_in_flight.store(true, std::memory_order_release);
+
+    if (job_system)
+    {
+        job_system->submit([this, snapshot]() { export_frames(snapshot); });
+    }
+    else
+    {
+        export_frames(snapshot);
+    }
+}
+
+void frame_statistics_t::export_frames(const export_snapshot_t &snapshot)
+{
+    // The job can not propagate exceptions, so failures are reported, and the next window tries again.
+    try
+    {
+        const u32 num_durations = 1u + get_num_phases();
+
+        std::string csv{};
+        frame_record_t frame_record{};
+        while (export_queue->pop(frame_record))
+        {
+            std::format_to(std::back_inserter(csv), "{}", frame_record.frame_index);
+            for (u32 i = 0u; i < num_durations; i++)
+            {
+                std::format_to(std::back_inserter(csv), ",{:.3f}", frame_record.durations_in_ms[i]);
+            }
+            std::format_to(std::back_inserter(csv), ",{}\n", frame_record.hitch ? 1 : 0);
+        }
+
+        const std::filesystem::path csv_path = config.export_directory / "frame_statistics.csv";
+        std::ofstream csv_file(csv_path, std::ios::app);
+        if (!csv_file.is_open())
+        {
+            throw std::runtime_error(std::format("Failed to open {}", csv_path.string()));
+        }
+        csv_file << csv;
+
+        std::string json{};
+        std::format_to(std::back_inserter(json), "{{\n  \"frames\": {},\n  \"hitches\": {},\n", snapshot.num_frames,
+                       snapshot.num_hitches);
+
+        for (const auto &[section, summaries] :
+             {std::pair{"window", &snapshot.window_summaries}, std::pair{"run", &snapshot.run_summaries}})
+        {
+            std::format_to(std::back_inserter(json), "  \"{}\": {{\n", section);
+            append_summary_json(json, "frame_time", (*summaries)[0], num_durations == 1u);
+            for (u32 i = 1u; i < num_durations; i++)
+            {
+                append_summary_json(json, phase_names[i - 1u], (*summaries)[i], i + 1u == num_durations);
+            }
+            json += section == std::string_view("window") ? "  },\n" : "  }\n";
+        }
+        json += "}\n";
+
+        // Written to a temporary file first, so readers never see a partially written file.
+        const std::filesystem::path json_path = config.export_directory / "frame_statistics.json";
+        const std::filesystem::path temporary_json_path = config.export_directory / "frame_statistics.json.tmp";
+        {
+            std::ofstream json_file(temporary_json_path, std::ios::trunc);
+            if (!json_file.is_open())
+            {
+                throw std::runtime_error(std::format("Failed to open {}", temporary_json_path.string()));
+            }
+            json_file << json;
+        }
+        std::filesystem::rename(temporary_json_path, json_path);
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << std::format("Frame statistics export failed :: {}", e.what()) << std::endl;
+    }
+
+    // Notified under the lock, as the destructor may run as soon as the lock is released.
+    std::scoped_lock lock(export_mutex);
+    export_in_flight.store(false, std::memory_order_release);
+    export_condition_variable.notify_all();
+}
+} // namespace nether
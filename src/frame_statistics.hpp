@@ -0,0 +1,323 @@
+#pragma once
+
+#include "common.hpp"
+#include "job_system.hpp"
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace nether
+{
+// Histogram of durations in microseconds with bounded memory and bounded relative error (an HDR histogram).
+// Values below SUB_BUCKET_COUNT have their own bucket. Above, each power of two range is split into
+// SUB_BUCKET_COUNT / 2 linear buckets, so the width of a bucket is at most 2 / SUB_BUCKET_COUNT of its values (about
+// 1.6%). Recording is a few instructions, and the memory does not depend on the number of values.
+class duration_histogram_t
+{
+  public:
+    static constexpr u32 SUB_BUCKET_BITS = 7u;
+    static constexpr u32 SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+    static constexpr u32 SUB_BUCKET_HALF_COUNT = SUB_BUCKET_COUNT / 2u;
+
+    // Enough buckets for every u32 value.
+    static constexpr u32 NUM_BUCKETS = SUB_BUCKET_COUNT + (32u - SUB_BUCKET_BITS) * SUB_BUCKET_HALF_COUNT;
+
+    void record(const u32 value_in_us)
+    {
+        counts[get_bucket_index(value_in_us)]++;
+
+        total_count++;
+        sum_in_us += value_in_us;
+        min_value_in_us = std::min(min_value_in_us, value_in_us);
+        max_value_in_us = std::max(max_value_in_us, value_in_us);
+    }
+
+    void merge(const duration_histogram_t &other);
+    void reset();
+
+    // Highest value that is in the same bucket as the value at the given percentile (in [0, 100]), so the result is
+    // never lower than the exact percentile. Returns 0 if the histogram is empty.
+    u32 get_percentile(const f32 percentile) const;
+
+    // Percentiles of several values at once, in a single pass over the buckets. The percentiles must be sorted.
+    void get_percentiles(const std::span<const f32> percentiles, const std::span<u32> values_in_us) const;
+
+    u64 get_count() const
+    {
+        return total_count;
+    }
+
+    u32 get_min() const
+    {
+        return total_count ? min_value_in_us : 0u;
+    }
+
+    u32 get_max() const
+    {
+        return max_value_in_us;
+    }
+
+    f64 get_mean() const
+    {
+        return total_count ? static_cast<f64>(sum_in_us) / total_count : 0.0;
+    }
+
+    static u32 get_bucket_index(const u32 value_in_us)
+    {
+        if (value_in_us < SUB_BUCKET_COUNT)
+        {
+            return value_in_us;
+        }
+
+        // The shift brings the value in [SUB_BUCKET_HALF_COUNT, SUB_BUCKET_COUNT).
+        const u32 shift = static_cast<u32>(std::bit_width(value_in_us)) - SUB_BUCKET_BITS;
+        return SUB_BUCKET_COUNT + (shift - 1u) * SUB_BUCKET_HALF_COUNT + (value_in_us >> shift) -
+               SUB_BUCKET_HALF_COUNT;
+    }
+
+    // Highest value that maps to the bucket.
+    static u32 get_bucket_upper_bound(const u32 bucket_index);
+
+  private:
+    std::array<u64, NUM_BUCKETS> counts{};
+
+    u64 total_count{};
+    u64 sum_in_us{};
+    u32 min_value_in_us{~0u};
+    u32 max_value_in_us{};
+};
+
+// Lock free queue between one producer thread and one consumer thread. Capacity must be a power of two.
+template <typename T, u32 Capacity> class spsc_ring_buffer_t
+{
+  public:
+    static_assert(std::has_single_bit(Capacity));
+
+    // Producer only. Returns false (and drops the value) if the buffer is full.
+    bool push(const T &value)
+    {
+        const u32 write = write_index.load(std::memory_order_relaxed);
+        if (write - read_index.load(std::memory_order_acquire) == Capacity)
+        {
+            return false;
+        }
+
+        values[write & (Capacity - 1u)] = value;
+        write_index.store(write + 1u, std::memory_order_release);
+
+        return true;
+    }
+
+    // Consumer only. Returns false if the buffer is empty.
+    bool pop(T &value)
+    {
+        const u32 read = read_index.load(std::memory_order_relaxed);
+        if (read == write_index.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        value = values[read & (Capacity - 1u)];
+        read_index.store(read + 1u, std::memory_order_release);
+
+        return true;
+    }
+
+  private:
+    std::array<T, Capacity> values{};
+
+    // The indices only wrap around at 2^32, and are masked when indexing values. They are on their own cache lines, so
+    // the producer and consumer do not write to the same line.
+    alignas(64) std::atomic<u32> write_index{};
+    alignas(64) std::atomic<u32> read_index{};
+};
+
+struct duration_summary_t
+{
+    u64 count{};
+    f32 mean_in_ms{};
+    f32 min_in_ms{};
+    f32 p50_in_ms{};
+    f32 p95_in_ms{};
+    f32 p99_in_ms{};
+    f32 max_in_ms{};
+};
+
+duration_summary_t summarize(const duration_histogram_t &histogram);
+
+struct frame_statistics_config_t
+{
+    // Time over which the window summaries are computed, which is also the export interval.
+    f32 window_time_in_s{1.0f};
+
+    // A frame is a hitch if it takes longer than hitch_ratio times the median frame time of the previous window.
+    f32 hitch_ratio{2.0f};
+
+    // Directory of the CSV (one row per frame) and JSON (summaries) files. Export is disabled if empty.
+    std::filesystem::path export_directory{};
+};
+
+struct frame_hitch_t
+{
+    u64 frame_index{};
+    f32 frame_time_in_ms{};
+
+    // Median frame time the frame was compared to.
+    f32 reference_time_in_ms{};
+};
+
+// Statistics of the frame time and of the CPU phases of a frame.
+// The frame loop marks the end of each phase (end_phase) and of the frame (end_frame). The durations are recorded in
+// duration histograms (for the current window, and for the whole run), which give percentiles with bounded memory.
+// Every window_time_in_s, the window summaries are computed, and if export is enabled, the frames of the window are
+// appended to the CSV file and the summaries written to the JSON file by a job on the job system. The frames are
+// handed to the export job through a lock free ring buffer, so the frame loop never waits on file IO.
+// Must only be used from the thread that runs the frame loop.
+class frame_statistics_t
+{
+  public:
+    static constexpr u32 MAX_PHASES = 8u;
+    static constexpr u32 FRAME_TIME_HISTORY_SIZE = 256u;
+    static constexpr u32 MAX_RECENT_HITCHES = 8u;
+
+    // Frames produced faster than they are exported are dropped from the CSV file (the histograms still have them).
+    static constexpr u32 EXPORT_QUEUE_CAPACITY = 8192u;
+
+    // The names of the phases are used for display and as CSV columns / JSON keys.
+    frame_statistics_t(const std::span<const std::string_view> phase_names, const frame_statistics_config_t &config,
+                       job_system_t *const job_system = nullptr);
+
+    // Waits for the export job, and exports the last (partial) window.
+    ~frame_statistics_t();
+
+    frame_statistics_t(const frame_statistics_t &) = delete;
+    frame_statistics_t &operator=(const frame_statistics_t &) = delete;
+
+    // The time since the previous end_phase (or end_frame) is attributed to the phase. Phases that are not ended in a
+    // frame have a duration of 0 for the frame.
+    void end_phase(const u32 phase_index);
+
+    // The frame time is the time since the previous end_frame (the first frame starts when the statistics are
+    // created).
+    void end_frame();
+
+    u32 get_num_phases() const
+    {
+        return static_cast<u32>(phase_names.size());
+    }
+
+    std::string_view get_phase_name(const u32 phase_index) const
+    {
+        return phase_names[phase_index];
+    }
+
+    // Summaries of the last complete window. Index 0 is the frame time, and index 1 + i is phase i.
+    const duration_summary_t &get_window_summary(const u32 index) const
+    {
+        return window_summaries[index];
+    }
+
+    // Summaries of every frame since the statistics were created (updated at the end of each window).
+    const duration_summary_t &get_run_summary(const u32 index) const
+    {
+        return run_summaries[index];
+    }
+
+    f32 get_last_frame_time_in_ms() const
+    {
+        return last_frame_time_in_ms;
+    }
+
+    // Ring buffer of the last frame times. The oldest frame is at get_frame_time_history_offset.
+    std::span<const f32> get_frame_time_history() const
+    {
+        return frame_time_history;
+    }
+
+    u32 get_frame_time_history_offset() const
+    {
+        return static_cast<u32>(num_frames % FRAME_TIME_HISTORY_SIZE);
+    }
+
+    u64 get_num_frames() const
+    {
+        return num_frames;
+    }
+
+    u64 get_num_hitches() const
+    {
+        return num_hitches;
+    }
+
+    // Most recent first.
+    std::span<const frame_hitch_t> get_recent_hitches() const
+    {
+        return std::span(recent_hitches).first(num_recent_hitches);
+    }
+
+    u64 get_num_dropped_exported_frames() const
+    {
+        return num_dropped_exported_frames;
+    }
+
+  private:
+    // Index 0 is the frame time, and index 1 + i is phase i.
+    static constexpr u32 MAX_DURATIONS = MAX_PHASES + 1u;
+
+    struct frame_record_t
+    {
+        u64 frame_index{};
+        std::array<f32, MAX_DURATIONS> durations_in_ms{};
+        bool hitch{};
+    };
+
+    struct export_snapshot_t
+    {
+        u64 num_frames{};
+        u64 num_hitches{};
+        std::array<duration_summary_t, MAX_DURATIONS> window_summaries{};
+        std::array<duration_summary_t, MAX_DURATIONS> run_summaries{};
+    };
+
+    void end_window();
+    void export_frames(const export_snapshot_t &snapshot);
+
+  private:
+    std::vector<std::string> phase_names{};
+    frame_statistics_config_t config{};
+    job_system_t *job_system{};
+
+    std::chrono::steady_clock::time_point frame_start_time{};
+    std::chrono::steady_clock::time_point phase_start_time{};
+    std::chrono::steady_clock::time_point window_start_time{};
+
+    std::array<f32, MAX_DURATIONS> current_durations_in_ms{};
+
+    std::array<duration_histogram_t, MAX_DURATIONS> window_histograms{};
+    std::array<duration_histogram_t, MAX_DURATIONS> run_histograms{};
+    std::array<duration_summary_t, MAX_DURATIONS> window_summaries{};
+    std::array<duration_summary_t, MAX_DURATIONS> run_summaries{};
+
+    u64 num_frames{};
+    f32 last_frame_time_in_ms{};
+    std::array<f32, FRAME_TIME_HISTORY_SIZE> frame_time_history{};
+
+    u64 num_hitches{};
+    std::array<frame_hitch_t, MAX_RECENT_HITCHES> recent_hitches{};
+    u32 num_recent_hitches{};
+
+    // Median frame time of the previous window, 0 until the first window ends (no hitches are detected until then).
+    f32 hitch_reference_time_in_ms{};
+
+    // Export state. The ring buffer's consumer is the export job, of which at most one is in flight.
+    std::unique_ptr<spsc_ring_buffer_t<frame_record_t, EXPORT_QUEUE_CAPACITY>> export_queue{};
+    std::atomic<bool> export_in_flight{};
+    std::mutex export_mutex{};
+    std::condition_variable export_condition_variable{};
+    u64 num_dropped_exported_frames{};
+};
+} // namespace nether
@@ -0,0 +1,189 @@
+#include "gpu_scene.hpp"
+
+#include <bit>
+#include <chrono>
+
+namespace nether
+{
+static constexpr u64 RECORD_SIZE = sizeof(gpu_scene_object_t);
+
+// Staging memory is written in blocks of this size when the copy is spread over the job system.
+static constexpr u64 STAGING_BLOCK_SIZE = 256u * 1024u;
+
+static void clear_bits(const std::span<u64> bits, const u32 begin, const u32 end)
+{
+    for (u32 i = begin; i < end;)
+    {
+        const u32 bit = i % 64u;
+        const u32 count = std::min(64u - bit, end - i);
+        bits[i / 64u] &= count == 64u ? 0u : ~(((1ull << count) - 1u) << bit);
+        i += count;
+    }
+}
+
+gpu_scene_t::gpu_scene_t(const gpu_scene_settings_t &settings)
+    : settings(settings), objects(settings.capacity), dirty_bits((settings.capacity + 63u) / 64u)
+{
+}
+
+u32 gpu_scene_t::add_object(const gpu_scene_object_t &object)
+{
+    u32 object_index = INVALID_OBJECT_INDEX;
+    if (!free_object_indices.empty())
+    {
+        object_index = free_object_indices.back();
+        free_object_indices.pop_back();
+    }
+    else if (num_used_records < settings.capacity)
+    {
+        object_index = num_used_records++;
+    }
+    else
+    {
+        throw std::runtime_error(std::format("GPU scene is full ({} objects)", settings.capacity));
+    }
+
+    set_object(object_index, object);
+    num_objects++;
+
+    return object_index;
+}
+
+void gpu_scene_t::remove_object(const u32 object_index)
+{
+    if (object_index >= num_used_records)
+    {
+        throw std::runtime_error(std::format("GPU scene object index {} out of range", object_index));
+    }
+
+    dirty_bits[object_index / 64u] &= ~(1ull << (object_index % 64u));
+    free_object_indices.push_back(object_index);
+    num_objects--;
+}
+
+std::span<const gpu_scene_upload_t> gpu_scene_t::write_uploads(const std::span<u8> staging,
+                                                               job_system_t *const job_system)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    uploads.clear();
+    statistics = {
+        .num_objects = num_objects,
+    };
+
+    const u32 staging_capacity = static_cast<u32>(std::min<u64>(staging.size() / RECORD_SIZE, settings.capacity));
+    u32 num_staged_records = 0u;
+
+    // The range being extended, [range_begin, range_end).
+    bool has_range = false;
+    u32 range_begin = 0u;
+    u32 range_end = 0u;
+
+    // Ranges are truncated to the staging memory left, and the rest of the range stays dirty.
+    const auto close_range = [&]() {
+        const u32 num_records = std::min(range_end - range_begin, staging_capacity - num_staged_records);
+        if (num_records == 0u)
+        {
+            return;
+        }
+
+        uploads.push_back({
+            .staging_offset = num_staged_records * RECORD_SIZE,
+            .destination_offset = range_begin * RECORD_SIZE,
+            .size = num_records * RECORD_SIZE,
+        });
+
+        clear_bits(dirty_bits, range_begin, range_begin + num_records);
+        num_staged_records += num_records;
+    };
+
+    // Walk the runs of set bits of each word, so that a fully dirty word costs the same as a single dirty object.
+    const u32 num_words = (num_used_records + 63u) / 64u;
+    for (u32 word_index = 0u; word_index < num_words; word_index++)
+    {
+        u64 word = dirty_bits[word_index];
+        statistics.num_dirty_objects += static_cast<u32>(std::popcount(word));
+
+        while (word)
+        {
+            const u32 run_offset = static_cast<u32>(std::countr_zero(word));
+            const u32 run_length = static_cast<u32>(std::countr_one(word >> run_offset));
+            word = run_offset + run_length == 64u ? 0u : word & ~((1ull << (run_offset + run_length)) - 1u);
+
+            const u32 run_begin = word_index * 64u + run_offset;
+            if (has_range && run_begin - range_end <= settings.max_range_gap)
+            {
+                range_end = run_begin + run_length;
+                continue;
+            }
+
+            if (has_range)
+            {
+                close_range();
+            }
+
+            has_range = true;
+            range_begin = run_begin;
+            range_end = run_begin + run_length;
+        }
+    }
+
+    if (has_range)
+    {
+        close_range();
+    }
+
+    // Copy the ranges into the staging memory, where they are back to back.
+    const u64 staged_size = num_staged_records * RECORD_SIZE;
+    const u8 *const object_data = reinterpret_cast<const u8 *>(objects.data());
+
+    if (job_system && staged_size > STAGING_BLOCK_SIZE)
+    {
+        const u32 num_blocks = static_cast<u32>((staged_size + STAGING_BLOCK_SIZE - 1u) / STAGING_BLOCK_SIZE);
+        job_system->parallel_for(num_blocks, 1u, [&](const u32 begin, const u32 end, const u32) {
+            const u64 block_begin = begin * STAGING_BLOCK_SIZE;
+            const u64 block_end = std::min(end * STAGING_BLOCK_SIZE, staged_size);
+
+            // The first upload that overlaps the blocks.
+            auto upload = std::upper_bound(uploads.begin(), uploads.end(), block_begin,
+                                           [](const u64 offset, const gpu_scene_upload_t &upload) {
+                                               return offset < upload.staging_offset;
+                                           }) -
+                          1;
+
+            for (; upload != uploads.end() && upload->staging_offset < block_end; ++upload)
+            {
+                const u64 copy_begin = std::max(block_begin, upload->staging_offset);
+                const u64 copy_end = std::min(block_end, upload->staging_offset + upload->size);
+                std::memcpy(staging.data() + copy_begin,
+                            object_data + upload->destination_offset + (copy_begin - upload->staging_offset),
+                            copy_end - copy_begin);
+            }
+        });
+    }
+    else
+    {
+        for (const gpu_scene_upload_t &upload : uploads)
+        {
+            std::memcpy(staging.data() + upload.staging_offset, object_data + upload.destination_offset, upload.size);
+        }
+    }
+
+    statistics.num_uploaded_objects = num_staged_records;
+    statistics.num_uploads = static_cast<u32>(uploads.size());
+    statistics.num_uploaded_bytes = staged_size;
+
+    if (num_staged_records == staging_capacity)
+    {
+        for (u32 word_index = 0u; word_index < num_words; word_index++)
+        {
+            statistics.num_deferred_objects += static_cast<u32>(std::popcount(dirty_bits[word_index]));
+        }
+    }
+
+    statistics.upload_time_in_ms =
+        std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+    return uploads;
+}
+} // namespace nether
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "common.hpp"
+#include "job_system.hpp"
+#include "math.hpp"
+
+// A persistent GPU copy of the per object data of the scene. Objects keep the same index (and so the same record of
+// the GPU buffer) for their whole lifetime, and only the records that changed since the last upload are copied :
+//  - Every object has a dirty bit, set when its data is written. update_object compares the new data with the current
+//    data first, so the scene can hand over every object every frame and only the ones that moved are uploaded.
+//  - write_uploads coalesces the dirty objects into ranges of consecutive records (merging ranges separated by a few
+//    clean objects, as copying a few records is cheaper than another copy), writes the ranges into staging memory
+//    back to back and returns one copy per range.
+// The renderer owns the GPU side : a device local structured buffer of get_capacity() records, and a staging ring
+// (an upload buffer with one part per frame in flight) that write_uploads fills and the copies read from.
+namespace nether
+{
+// Must match gpu_scene_object_t in shaders/common.hlsli.
+struct gpu_scene_object_t
+{
+    float4x4_t model_matrix{};
+    float4_t color{};
+};
+
+struct gpu_scene_settings_t
+{
+    // Number of records of the GPU buffer.
+    u32 capacity{65536u};
+
+    // Dirty ranges separated by at most this many clean objects are uploaded as a single range.
+    u32 max_range_gap{4u};
+};
+
+// A CopyBufferRegion from the staging memory to the GPU scene buffer (offsets and size in bytes).
+struct gpu_scene_upload_t
+{
+    u64 staging_offset{};
+    u64 destination_offset{};
+    u64 size{};
+};
+
+struct gpu_scene_statistics_t
+{
+    u32 num_objects{};
+
+    // During the last write_uploads. Uploaded objects include the clean objects between merged ranges.
+    u32 num_dirty_objects{};
+    u32 num_uploaded_objects{};
+    u32 num_uploads{};
+    u64 num_uploaded_bytes{};
+
+    // Dirty objects that did not fit in the staging memory, which are uploaded by the next calls.
+    u32 num_deferred_objects{};
+
+    f32 upload_time_in_ms{};
+};
+
+// Not thread safe : objects must be added, removed and written from a single thread at a time.
+class gpu_scene_t
+{
+  public:
+    static constexpr u32 INVALID_OBJECT_INDEX = ~0u;
+
+    explicit gpu_scene_t(const gpu_scene_settings_t &settings = {});
+
+    // Returns the index of the object's record. Indices of removed objects are reused. Throws if the scene is full.
+    u32 add_object(const gpu_scene_object_t &object);
+
+    // The record is not cleared on the GPU, it is simply no longer referenced.
+    void remove_object(const u32 object_index);
+
+    void set_object(const u32 object_index, const gpu_scene_object_t &object)
+    {
+        objects[object_index] = object;
+        dirty_bits[object_index / 64u] |= 1ull << (object_index % 64u);
+    }
+
+    // Only marks the object dirty if its data changed. Returns whether it did.
+    bool update_object(const u32 object_index, const gpu_scene_object_t &object)
+    {
+        if (std::memcmp(&objects[object_index], &object, sizeof(gpu_scene_object_t)) == 0)
+        {
+            return false;
+        }
+
+        set_object(object_index, object);
+        return true;
+    }
+
+    const gpu_scene_object_t &get_object(const u32 object_index) const
+    {
+        return objects[object_index];
+    }
+
+    bool is_dirty(const u32 object_index) const
+    {
+        return (dirty_bits[object_index / 64u] >> (object_index % 64u)) & 1u;
+    }
+
+    // Coalesces the dirty objects into ranges, writes them into staging (usually this frame's part of the staging ring)
+    // and returns the copies to issue. Objects that do not fit stay dirty, and are uploaded by the next calls. The
+    // returned span is valid until the next call.
+    std::span<const gpu_scene_upload_t> write_uploads(const std::span<u8> staging,
+                                                      job_system_t *const job_system = nullptr);
+
+    u32 get_capacity() const
+    {
+        return settings.capacity;
+    }
+
+    u32 get_num_objects() const
+    {
+        return num_objects;
+    }
+
+  public:
+    std::vector<gpu_scene_upload_t> uploads{};
+
+    gpu_scene_statistics_t statistics{};
+
+  private:
+    gpu_scene_settings_t settings{};
+
+    std::vector<gpu_scene_object_t> objects{};
+    std::vector<u64> dirty_bits{};
+
+    // Objects are allocated from the free list first, then from the end of the used records.
+    std::vector<u32> free_object_indices{};
+    u32 num_used_records{};
+    u32 num_objects{};
+};
+} // namespace nether
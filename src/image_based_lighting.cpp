@@ -0,0 +1,1039 @@
+#include "image_based_lighting.hpp"
+
+#include "vertex_compression.hpp"
+
+#include <bit>
+#include <immintrin.h>
+
+namespace nether
+{
+namespace
+{
+constexpr f32 PI = std::numbers::pi_v<f32>;
+
+// Constants of the real spherical harmonics basis, and the clamped cosine lobe's coefficient of each band.
+constexpr f32 SH_BAND_0 = 0.282095f;
+constexpr f32 SH_BAND_1 = 0.488603f;
+constexpr f32 SH_BAND_2 = 1.092548f;
+constexpr f32 SH_BAND_2_ZZ = 0.315392f;
+constexpr f32 SH_BAND_2_XX_YY = 0.546274f;
+
+constexpr std::array<f32, 9> COSINE_LOBE = {
+    PI, 2.0f * PI / 3.0f, 2.0f * PI / 3.0f, 2.0f * PI / 3.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f,
+};
+
+// Orthonormal basis around a unit vector (Duff et al., Building an Orthonormal Basis, Revisited).
+void get_basis(const float3_t &normal, float3_t &tangent, float3_t &bitangent)
+{
+    const f32 sign = std::copysign(1.0f, normal.z);
+    const f32 a = -1.0f / (sign + normal.z);
+    const f32 b = normal.x * normal.y * a;
+
+    tangent = float3_t{1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x};
+    bitangent = float3_t{b, sign + normal.y * normal.y * a, -normal.y};
+}
+
+// Van der Corput sequence, the second coordinate of the Hammersley points (i / n, radical_inverse(i)).
+f32 radical_inverse(u32 bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xaaaaaaaau) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xccccccccu) >> 2u);
+    bits = ((bits & 0x0f0f0f0fu) << 4u) | ((bits & 0xf0f0f0f0u) >> 4u);
+    bits = ((bits & 0x00ff00ffu) << 8u) | ((bits & 0xff00ff00u) >> 8u);
+    return static_cast<f32>(bits) * 2.3283064365386963e-10f;
+}
+
+// Cosine of the angle between the GGX distributed half vector and the normal.
+f32 sample_ggx_cos_theta(const f32 xi, const f32 alpha)
+{
+    return std::sqrt((1.0f - xi) / (1.0f + (alpha * alpha - 1.0f) * xi));
+}
+
+f32 get_ggx_distribution(const f32 n_dot_h, const f32 alpha)
+{
+    const f32 alpha_squared = alpha * alpha;
+    const f32 denominator = n_dot_h * n_dot_h * (alpha_squared - 1.0f) + 1.0f;
+    return alpha_squared / (PI * denominator * denominator);
+}
+
+f32 horizontal_sum(const __m256 value)
+{
+    const __m128 sum_4 = _mm_add_ps(_mm256_castps256_ps128(value), _mm256_extractf128_ps(value, 1));
+    const __m128 sum_2 = _mm_add_ps(sum_4, _mm_movehl_ps(sum_4, sum_4));
+    return _mm_cvtss_f32(_mm_add_ss(sum_2, _mm_shuffle_ps(sum_2, sum_2, 1)));
+}
+
+// Gathers 8 float3_t texels.
+void gather_texels(const f32 *const texels, const __m256i indices, __m256 &r, __m256 &g, __m256 &b)
+{
+    const __m256i offsets = _mm256_add_epi32(_mm256_slli_epi32(indices, 1), indices);
+    r = _mm256_i32gather_ps(texels, offsets, 4);
+    g = _mm256_i32gather_ps(texels + 1, offsets, 4);
+    b = _mm256_i32gather_ps(texels + 2, offsets, 4);
+}
+
+// Reads 8 directions from a cubemap's mip chain, with bilinear filtering within each face and linear filtering between
+// mips. Directions need not be normalized, and texels past the edges of a face are clamped to the face.
+class cubemap_sampler_t
+{
+  public:
+    explicit cubemap_sampler_t(const cubemap_t &cubemap)
+        : texels(&cubemap.texels[0].x), size(cubemap.size), num_mips(cubemap.num_mips)
+    {
+        for (u32 mip = 0u; mip < num_mips; mip++)
+        {
+            mip_offsets.push_back(static_cast<i32>(cubemap.get_texel_index(mip, 0u, 0u, 0u)));
+        }
+    }
+
+    void sample(const __m256 x, const __m256 y, const __m256 z, const __m256 mip, __m256 &r, __m256 &g,
+                __m256 &b) const
+    {
+        const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 half = _mm256_set1_ps(0.5f);
+
+        const __m256 abs_x = _mm256_andnot_ps(sign_mask, x);
+        const __m256 abs_y = _mm256_andnot_ps(sign_mask, y);
+        const __m256 abs_z = _mm256_andnot_ps(sign_mask, z);
+
+        // The major axis selects the face, and the other two are projected onto it (the inverse of
+        // get_cubemap_direction).
+        const __m256 is_x =
+            _mm256_and_ps(_mm256_cmp_ps(abs_x, abs_y, _CMP_GE_OQ), _mm256_cmp_ps(abs_x, abs_z, _CMP_GE_OQ));
+        const __m256 is_y = _mm256_andnot_ps(is_x, _mm256_cmp_ps(abs_y, abs_z, _CMP_GE_OQ));
+
+        const __m256 sign_x = _mm256_and_ps(x, sign_mask);
+        const __m256 sign_y = _mm256_and_ps(y, sign_mask);
+        const __m256 sign_z = _mm256_and_ps(z, sign_mask);
+        const __m256 negative_y = _mm256_xor_ps(y, sign_mask);
+
+        const __m256 major = _mm256_blendv_ps(_mm256_blendv_ps(abs_z, abs_y, is_y), abs_x, is_x);
+        const __m256 u_numerator = _mm256_blendv_ps(_mm256_blendv_ps(_mm256_xor_ps(x, sign_z), x, is_y),
+                                                    _mm256_xor_ps(_mm256_xor_ps(z, sign_mask), sign_x), is_x);
+        const __m256 v_numerator = _mm256_blendv_ps(negative_y, _mm256_xor_ps(z, sign_y), is_y);
+
+        const __m256 inverse_major = _mm256_div_ps(half, major);
+        const __m256 u = _mm256_fmadd_ps(u_numerator, inverse_major, half);
+        const __m256 v = _mm256_fmadd_ps(v_numerator, inverse_major, half);
+
+        const __m256 is_negative_x = _mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_LT_OQ), one);
+        const __m256 is_negative_y = _mm256_and_ps(_mm256_cmp_ps(y, zero, _CMP_LT_OQ), one);
+        const __m256 is_negative_z = _mm256_and_ps(_mm256_cmp_ps(z, zero, _CMP_LT_OQ), one);
+        const __m256i face = _mm256_cvttps_epi32(
+            _mm256_blendv_ps(_mm256_blendv_ps(_mm256_add_ps(_mm256_set1_ps(4.0f), is_negative_z),
+                                              _mm256_add_ps(_mm256_set1_ps(2.0f), is_negative_y), is_y),
+                             is_negative_x, is_x));
+
+        const __m256 mip_floor = _mm256_floor_ps(mip);
+        const __m256 mip_fraction = _mm256_sub_ps(mip, mip_floor);
+        const __m256i mip_0 = _mm256_cvttps_epi32(mip_floor);
+        const __m256i mip_1 = _mm256_min_epi32(_mm256_add_epi32(mip_0, _mm256_set1_epi32(1)),
+                                               _mm256_set1_epi32(static_cast<i32>(num_mips) - 1));
+
+        __m256 r_0{}, g_0{}, b_0{};
+        __m256 r_1{}, g_1{}, b_1{};
+        sample_bilinear(face, u, v, mip_0, r_0, g_0, b_0);
+        sample_bilinear(face, u, v, mip_1, r_1, g_1, b_1);
+
+        r = _mm256_fmadd_ps(_mm256_sub_ps(r_1, r_0), mip_fraction, r_0);
+        g = _mm256_fmadd_ps(_mm256_sub_ps(g_1, g_0), mip_fraction, g_0);
+        b = _mm256_fmadd_ps(_mm256_sub_ps(b_1, b_0), mip_fraction, b_0);
+    }
+
+  private:
+    void sample_bilinear(const __m256i face, const __m256 u, const __m256 v, const __m256i mip, __m256 &r, __m256 &g,
+                         __m256 &b) const
+    {
+        const __m256i mip_size = _mm256_srlv_epi32(_mm256_set1_epi32(static_cast<i32>(size)), mip);
+        const __m256i max_coordinate = _mm256_sub_epi32(mip_size, _mm256_set1_epi32(1));
+        const __m256 mip_size_f = _mm256_cvtepi32_ps(mip_size);
+        const __m256 max_coordinate_f = _mm256_cvtepi32_ps(max_coordinate);
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 zero = _mm256_setzero_ps();
+
+        const __m256 x = _mm256_min_ps(_mm256_max_ps(_mm256_fmsub_ps(u, mip_size_f, half), zero), max_coordinate_f);
+        const __m256 y = _mm256_min_ps(_mm256_max_ps(_mm256_fmsub_ps(v, mip_size_f, half), zero), max_coordinate_f);
+        const __m256 x_floor = _mm256_floor_ps(x);
+        const __m256 y_floor = _mm256_floor_ps(y);
+        const __m256 fraction_x = _mm256_sub_ps(x, x_floor);
+        const __m256 fraction_y = _mm256_sub_ps(y, y_floor);
+
+        const __m256i x_0 = _mm256_cvttps_epi32(x_floor);
+        const __m256i y_0 = _mm256_cvttps_epi32(y_floor);
+        const __m256i x_1 = _mm256_min_epi32(_mm256_add_epi32(x_0, _mm256_set1_epi32(1)), max_coordinate);
+        const __m256i y_1 = _mm256_min_epi32(_mm256_add_epi32(y_0, _mm256_set1_epi32(1)), max_coordinate);
+
+        const __m256i face_offset = _mm256_add_epi32(_mm256_i32gather_epi32(mip_offsets.data(), mip, 4),
+                                                     _mm256_mullo_epi32(face, _mm256_mullo_epi32(mip_size, mip_size)));
+        const __m256i row_0 = _mm256_add_epi32(face_offset, _mm256_mullo_epi32(y_0, mip_size));
+        const __m256i row_1 = _mm256_add_epi32(face_offset, _mm256_mullo_epi32(y_1, mip_size));
+
+        __m256 r_00{}, g_00{}, b_00{}, r_10{}, g_10{}, b_10{}, r_01{}, g_01{}, b_01{}, r_11{}, g_11{}, b_11{};
+        gather_texels(texels, _mm256_add_epi32(row_0, x_0), r_00, g_00, b_00);
+        gather_texels(texels, _mm256_add_epi32(row_0, x_1), r_10, g_10, b_10);
+        gather_texels(texels, _mm256_add_epi32(row_1, x_0), r_01, g_01, b_01);
+        gather_texels(texels, _mm256_add_epi32(row_1, x_1), r_11, g_11, b_11);
+
+        const auto bilinear = [&](const __m256 c_00, const __m256 c_10, const __m256 c_01, const __m256 c_11) {
+            const __m256 c_0 = _mm256_fmadd_ps(_mm256_sub_ps(c_10, c_00), fraction_x, c_00);
+            const __m256 c_1 = _mm256_fmadd_ps(_mm256_sub_ps(c_11, c_01), fraction_x, c_01);
+            return _mm256_fmadd_ps(_mm256_sub_ps(c_1, c_0), fraction_y, c_0);
+        };
+
+        r = bilinear(r_00, r_10, r_01, r_11);
+        g = bilinear(g_00, g_10, g_01, g_11);
+        b = bilinear(b_00, b_10, b_01, b_11);
+    }
+
+  private:
+    const f32 *texels{};
+    u32 size{};
+    u32 num_mips{};
+    std::vector<i32> mip_offsets{};
+};
+
+void run_rows(job_system_t *const job_system, const u32 num_rows, const std::function<void(u32, u32, u32)> &function)
+{
+    if (job_system)
+    {
+        job_system->parallel_for(num_rows, 1u, function);
+    }
+    else
+    {
+        function(0u, num_rows, 0u);
+    }
+}
+
+// RGBE with a shared exponent (Ward, Real Pixels).
+float3_t decode_rgbe(const u8 *const rgbe)
+{
+    if (rgbe[3] == 0u)
+    {
+        return float3_t{};
+    }
+
+    const f32 scale = std::ldexp(1.0f, static_cast<i32>(rgbe[3]) - (128 + 8));
+    return float3_t{static_cast<f32>(rgbe[0]) * scale, static_cast<f32>(rgbe[1]) * scale,
+                    static_cast<f32>(rgbe[2]) * scale};
+}
+
+std::array<u8, 4> encode_rgbe(const float3_t &color)
+{
+    const f32 max_component = std::max({color.x, color.y, color.z});
+    if (max_component < 1e-32f)
+    {
+        return {};
+    }
+
+    i32 exponent = 0;
+    const f32 scale = std::frexp(max_component, &exponent) * 256.0f / max_component;
+    return {static_cast<u8>(std::max(color.x, 0.0f) * scale), static_cast<u8>(std::max(color.y, 0.0f) * scale),
+            static_cast<u8>(std::max(color.z, 0.0f) * scale), static_cast<u8>(exponent + 128)};
+}
+
+// Scanlines of this width can be run length encoded.
+bool is_rle_width(const u32 width)
+{
+    return width >= 8u && width < 32768u;
+}
+} // namespace
+
+hdr_image_t read_hdr_image(const std::filesystem::path &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error(std::format("Failed to open HDR image {}", path.string()));
+    }
+
+    std::string line{};
+    std::getline(file, line);
+    if (line != "#?RADIANCE" && line != "#?RGBE")
+    {
+        throw std::runtime_error(std::format("{} is not a Radiance HDR image", path.string()));
+    }
+
+    // The header ends with an empty line, and the format is RGBE unless stated otherwise.
+    while (std::getline(file, line) && !line.empty())
+    {
+        if (line.starts_with("FORMAT=") && line != "FORMAT=32-bit_rle_rgbe")
+        {
+            throw std::runtime_error(std::format("HDR image {} has the unsupported {}", path.string(), line));
+        }
+    }
+
+    std::getline(file, line);
+    std::istringstream resolution(line);
+    std::string y_axis{};
+    std::string x_axis{};
+    hdr_image_t image{};
+    if (!(resolution >> y_axis >> image.height >> x_axis >> image.width) || y_axis != "-Y" || x_axis != "+X")
+    {
+        throw std::runtime_error(std::format("HDR image {} has the unsupported resolution line \"{}\"", path.string(),
+                                             line));
+    }
+
+    const std::vector<u8> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t position = 0u;
+    const auto read_byte = [&]() {
+        if (position >= data.size())
+        {
+            throw std::runtime_error(std::format("HDR image {} is truncated", path.string()));
+        }
+
+        return data[position++];
+    };
+
+    image.texels.resize(static_cast<size_t>(image.width) * image.height);
+    std::vector<u8> scanline(image.width * 4u);
+
+    for (u32 y = 0u; y < image.height; y++)
+    {
+        const bool is_rle = is_rle_width(image.width) && position + 4u <= data.size() && data[position] == 2u &&
+                            data[position + 1u] == 2u &&
+                            static_cast<u32>((data[position + 2u] << 8u) | data[position + 3u]) == image.width;
+
+        if (is_rle)
+        {
+            // Every channel of the scanline in turn, as runs (count - 128 copies of a byte) and literals (count
+            // bytes).
+            position += 4u;
+            for (u32 channel = 0u; channel < 4u; channel++)
+            {
+                u32 x = 0u;
+                while (x < image.width)
+                {
+                    u32 count = read_byte();
+                    const bool is_run = count > 128u;
+                    count = is_run ? count - 128u : count;
+                    if (count == 0u || x + count > image.width)
+                    {
+                        throw std::runtime_error(std::format("HDR image {} has a corrupted scanline {}",
+                                                             path.string(), y));
+                    }
+
+                    const u8 run_value = is_run ? read_byte() : 0u;
+                    for (u32 i = 0u; i < count; i++, x++)
+                    {
+                        scanline[x * 4u + channel] = is_run ? run_value : read_byte();
+                    }
+                }
+            }
+        }
+        else
+        {
+            for (u8 &byte : scanline)
+            {
+                byte = read_byte();
+            }
+        }
+
+        for (u32 x = 0u; x < image.width; x++)
+        {
+            image.texels[y * image.width + x] = decode_rgbe(&scanline[x * 4u]);
+        }
+    }
+
+    return image;
+}
+
+void write_hdr_image(const std::filesystem::path &path, const hdr_image_t &image)
+{
+    if (image.texels.size() != static_cast<size_t>(image.width) * image.height)
+    {
+        throw std::runtime_error(std::format("HDR image of {}x{} texels has {} texels", image.width, image.height,
+                                             image.texels.size()));
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error(std::format("Failed to open {} for writing", path.string()));
+    }
+
+    file << "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n" << std::format("-Y {} +X {}\n", image.height, image.width);
+
+    std::vector<u8> scanline(image.width * 4u);
+    for (u32 y = 0u; y < image.height; y++)
+    {
+        for (u32 x = 0u; x < image.width; x++)
+        {
+            const std::array<u8, 4> rgbe = encode_rgbe(image.texels[y * image.width + x]);
+            std::memcpy(&scanline[x * 4u], rgbe.data(), rgbe.size());
+        }
+
+        if (is_rle_width(image.width))
+        {
+            file.put(2).put(2).put(static_cast<char>(image.width >> 8u)).put(static_cast<char>(image.width & 0xffu));
+            for (u32 channel = 0u; channel < 4u; channel++)
+            {
+                for (u32 x = 0u; x < image.width; x += 128u)
+                {
+                    const u32 count = std::min(image.width - x, 128u);
+                    file.put(static_cast<char>(count));
+                    for (u32 i = x; i < x + count; i++)
+                    {
+                        file.put(static_cast<char>(scanline[i * 4u + channel]));
+                    }
+                }
+            }
+        }
+        else
+        {
+            file.write(reinterpret_cast<const char *>(scanline.data()), static_cast<std::streamsize>(scanline.size()));
+        }
+    }
+
+    if (!file)
+    {
+        throw std::runtime_error(std::format("Failed to write HDR image {}", path.string()));
+    }
+}
+
+u64 cubemap_t::get_texel_index(const u32 mip, const u32 face, const u32 x, const u32 y) const
+{
+    u64 index = 0u;
+    for (u32 i = 0u; i < mip; i++)
+    {
+        index += static_cast<u64>(NUM_FACES) * (size >> i) * (size >> i);
+    }
+
+    const u64 mip_size = size >> mip;
+    return index + (face * mip_size + y) * mip_size + x;
+}
+
+float3_t get_cubemap_direction(const u32 face, const f32 u, const f32 v)
+{
+    const f32 a = 2.0f * u - 1.0f;
+    const f32 b = 2.0f * v - 1.0f;
+
+    float3_t direction{};
+    switch (face)
+    {
+    case 0u:
+        direction = {1.0f, -b, -a};
+        break;
+    case 1u:
+        direction = {-1.0f, -b, a};
+        break;
+    case 2u:
+        direction = {a, 1.0f, b};
+        break;
+    case 3u:
+        direction = {a, -1.0f, -b};
+        break;
+    case 4u:
+        direction = {a, -b, 1.0f};
+        break;
+    default:
+        direction = {-a, -b, -1.0f};
+        break;
+    }
+
+    return normalize(direction);
+}
+
+cubemap_t equirectangular_to_cubemap(const hdr_image_t &image, const u32 size, job_system_t *const job_system)
+{
+    if (image.width == 0u || image.height == 0u || size == 0u)
+    {
+        throw std::runtime_error(std::format("Can not convert a {}x{} panorama into a cubemap of {}x{} faces",
+                                             image.width, image.height, size, size));
+    }
+
+    cubemap_t cubemap{
+        .size = size,
+        .texels = std::vector<float3_t>(static_cast<size_t>(cubemap_t::NUM_FACES) * size * size),
+    };
+
+    const f32 width = static_cast<f32>(image.width);
+    const f32 height = static_cast<f32>(image.height);
+
+    // Bilinear filtering, which wraps around horizontally and clamps at the poles.
+    run_rows(job_system, cubemap_t::NUM_FACES * size, [&](const u32 begin, const u32 end, const u32) {
+        for (u32 row = begin; row < end; row++)
+        {
+            const u32 face = row / size;
+            const u32 y = row % size;
+
+            for (u32 x = 0u; x < size; x++)
+            {
+                const float3_t direction =
+                    get_cubemap_direction(face, (static_cast<f32>(x) + 0.5f) / static_cast<f32>(size),
+                                          (static_cast<f32>(y) + 0.5f) / static_cast<f32>(size));
+
+                const f32 u = std::atan2(direction.z, direction.x) / (2.0f * PI);
+                const f32 v = std::acos(std::clamp(direction.y, -1.0f, 1.0f)) / PI;
+
+                const f32 pixel_x = (u - std::floor(u)) * width - 0.5f;
+                const f32 pixel_y = std::clamp(v * height - 0.5f, 0.0f, height - 1.0f);
+
+                const f32 x_floor = std::floor(pixel_x);
+                const f32 y_floor = std::floor(pixel_y);
+                const f32 fraction_x = pixel_x - x_floor;
+                const f32 fraction_y = pixel_y - y_floor;
+
+                const u32 x_0 =
+                    static_cast<u32>(static_cast<i32>(x_floor) + static_cast<i32>(image.width)) % image.width;
+                const u32 x_1 = (x_0 + 1u) % image.width;
+                const u32 y_0 = static_cast<u32>(y_floor);
+                const u32 y_1 = std::min(y_0 + 1u, image.height - 1u);
+
+                const auto texel = [&](const u32 texel_x, const u32 texel_y) {
+                    return image.texels[texel_y * image.width + texel_x];
+                };
+
+                const float3_t top = texel(x_0, y_0) * (1.0f - fraction_x) + texel(x_1, y_0) * fraction_x;
+                const float3_t bottom = texel(x_0, y_1) * (1.0f - fraction_x) + texel(x_1, y_1) * fraction_x;
+                cubemap.texels[cubemap.get_texel_index(0u, face, x, y)] =
+                    top * (1.0f - fraction_y) + bottom * fraction_y;
+            }
+        }
+    });
+
+    return cubemap;
+}
+
+cubemap_t cubemap_from_faces(const std::span<const hdr_image_t> faces)
+{
+    if (faces.size() != cubemap_t::NUM_FACES)
+    {
+        throw std::runtime_error(std::format("A cubemap has 6 faces, not {}", faces.size()));
+    }
+
+    cubemap_t cubemap{.size = faces[0].width};
+    for (u32 face = 0u; face < cubemap_t::NUM_FACES; face++)
+    {
+        if (faces[face].width != cubemap.size || faces[face].height != cubemap.size || cubemap.size == 0u)
+        {
+            throw std::runtime_error(std::format("Cubemap face {} is {}x{} texels, instead of {}x{}", face,
+                                                 faces[face].width, faces[face].height, cubemap.size, cubemap.size));
+        }
+
+        cubemap.texels.insert(cubemap.texels.end(), faces[face].texels.begin(), faces[face].texels.end());
+    }
+
+    return cubemap;
+}
+
+void generate_cubemap_mips(cubemap_t &cubemap, job_system_t *const job_system)
+{
+    if (!std::has_single_bit(cubemap.size))
+    {
+        throw std::runtime_error(std::format("Cubemap faces of {}x{} texels do not have a full mip chain",
+                                             cubemap.size, cubemap.size));
+    }
+
+    const u32 num_mips = static_cast<u32>(std::countr_zero(cubemap.size)) + 1u;
+    cubemap.num_mips = num_mips;
+    cubemap.texels.resize(cubemap.get_texel_index(num_mips - 1u, cubemap_t::NUM_FACES, 0u, 0u));
+
+    for (u32 mip = 1u; mip < num_mips; mip++)
+    {
+        const u32 mip_size = cubemap.size >> mip;
+
+        run_rows(job_system, cubemap_t::NUM_FACES * mip_size, [&](const u32 begin, const u32 end, const u32) {
+            for (u32 row = begin; row < end; row++)
+            {
+                const u32 face = row / mip_size;
+                const u32 y = row % mip_size;
+
+                for (u32 x = 0u; x < mip_size; x++)
+                {
+                    const u64 top = cubemap.get_texel_index(mip - 1u, face, x * 2u, y * 2u);
+                    const u64 bottom = top + mip_size * 2u;
+
+                    cubemap.texels[cubemap.get_texel_index(mip, face, x, y)] =
+                        (cubemap.texels[top] + cubemap.texels[top + 1u] + cubemap.texels[bottom] +
+                         cubemap.texels[bottom + 1u]) *
+                        0.25f;
+                }
+            }
+        });
+    }
+}
+
+sh9_t compute_irradiance_sh9(const cubemap_t &environment, job_system_t *const job_system)
+{
+    const u32 size = environment.size;
+    if (size == 0u)
+    {
+        throw std::runtime_error("Can not project an empty cubemap onto spherical harmonics");
+    }
+
+    // The 27 sums of every row of texels (9 coefficients of 3 channels), and the sum of their solid angles.
+    constexpr u32 NUM_SUMS = 28u;
+    std::vector<std::array<f32, NUM_SUMS>> row_sums(cubemap_t::NUM_FACES * size);
+
+    const f32 texel_size = 2.0f / static_cast<f32>(size);
+    const f32 *const texels = &environment.texels[0].x;
+
+    run_rows(job_system, cubemap_t::NUM_FACES * size, [&](const u32 begin, const u32 end, const u32) {
+        for (u32 row = begin; row < end; row++)
+        {
+            const u32 face = row / size;
+            const u32 y = row % size;
+
+            __m256 sums[NUM_SUMS]{};
+
+            // 8 texels of the row at once, at (a, b) of the face's plane at distance 1 (see get_cubemap_direction).
+            const __m256 b = _mm256_set1_ps((static_cast<f32>(y) + 0.5f) * texel_size - 1.0f);
+            const __m256 lanes = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+
+            for (u32 x = 0u; x < size; x += 8u)
+            {
+                const __m256 texel_x = _mm256_add_ps(_mm256_set1_ps(static_cast<f32>(x)), lanes);
+                const __m256 a = _mm256_fmsub_ps(_mm256_add_ps(texel_x, _mm256_set1_ps(0.5f)),
+                                                 _mm256_set1_ps(texel_size), one);
+
+                const __m256 negative_a = _mm256_xor_ps(a, sign_mask);
+                const __m256 negative_b = _mm256_xor_ps(b, sign_mask);
+
+                __m256 direction_x{}, direction_y{}, direction_z{};
+                switch (face)
+                {
+                case 0u:
+                    direction_x = one, direction_y = negative_b, direction_z = negative_a;
+                    break;
+                case 1u:
+                    direction_x = _mm256_xor_ps(one, sign_mask), direction_y = negative_b, direction_z = a;
+                    break;
+                case 2u:
+                    direction_x = a, direction_y = one, direction_z = b;
+                    break;
+                case 3u:
+                    direction_x = a, direction_y = _mm256_xor_ps(one, sign_mask), direction_z = negative_b;
+                    break;
+                case 4u:
+                    direction_x = a, direction_y = negative_b, direction_z = one;
+                    break;
+                default:
+                    direction_x = negative_a, direction_y = negative_b, direction_z = _mm256_xor_ps(one, sign_mask);
+                    break;
+                }
+
+                // The solid angle of a texel is texel_size^2 / (1 + a^2 + b^2)^(3/2), and the texels past the end of
+                // the row have none.
+                const __m256 squared_length = _mm256_fmadd_ps(a, a, _mm256_fmadd_ps(b, b, one));
+                const __m256 inverse_length = _mm256_div_ps(one, _mm256_sqrt_ps(squared_length));
+                const __m256 is_in_row = _mm256_cmp_ps(texel_x, _mm256_set1_ps(static_cast<f32>(size)), _CMP_LT_OQ);
+                const __m256 solid_angle = _mm256_and_ps(
+                    _mm256_mul_ps(_mm256_set1_ps(texel_size * texel_size),
+                                  _mm256_mul_ps(inverse_length, _mm256_mul_ps(inverse_length, inverse_length))),
+                    is_in_row);
+
+                direction_x = _mm256_mul_ps(direction_x, inverse_length);
+                direction_y = _mm256_mul_ps(direction_y, inverse_length);
+                direction_z = _mm256_mul_ps(direction_z, inverse_length);
+
+                const __m256i texel_indices = _mm256_min_epi32(
+                    _mm256_add_epi32(_mm256_set1_epi32(static_cast<i32>(environment.get_texel_index(0u, face, x, y))),
+                                     _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)),
+                    _mm256_set1_epi32(static_cast<i32>(environment.get_texel_index(0u, face, size - 1u, y))));
+
+                __m256 r{}, g{}, b_channel{};
+                gather_texels(texels, texel_indices, r, g, b_channel);
+
+                const __m256 basis[9] = {
+                    _mm256_set1_ps(SH_BAND_0),
+                    _mm256_mul_ps(_mm256_set1_ps(SH_BAND_1), direction_y),
+                    _mm256_mul_ps(_mm256_set1_ps(SH_BAND_1), direction_z),
+                    _mm256_mul_ps(_mm256_set1_ps(SH_BAND_1), direction_x),
+                    _mm256_mul_ps(_mm256_set1_ps(SH_BAND_2), _mm256_mul_ps(direction_x, direction_y)),
+                    _mm256_mul_ps(_mm256_set1_ps(SH_BAND_2), _mm256_mul_ps(direction_y, direction_z)),
+                    _mm256_mul_ps(_mm256_set1_ps(SH_BAND_2_ZZ),
+                                  _mm256_fmsub_ps(_mm256_set1_ps(3.0f), _mm256_mul_ps(direction_z, direction_z), one)),
+                    _mm256_mul_ps(_mm256_set1_ps(SH_BAND_2), _mm256_mul_ps(direction_x, direction_z)),
+                    _mm256_mul_ps(_mm256_set1_ps(SH_BAND_2_XX_YY),
+                                  _mm256_fmsub_ps(direction_x, direction_x, _mm256_mul_ps(direction_y, direction_y))),
+                };
+
+                for (u32 i = 0u; i < 9u; i++)
+                {
+                    const __m256 weight = _mm256_mul_ps(basis[i], solid_angle);
+                    sums[i * 3u + 0u] = _mm256_fmadd_ps(weight, r, sums[i * 3u + 0u]);
+                    sums[i * 3u + 1u] = _mm256_fmadd_ps(weight, g, sums[i * 3u + 1u]);
+                    sums[i * 3u + 2u] = _mm256_fmadd_ps(weight, b_channel, sums[i * 3u + 2u]);
+                }
+
+                sums[27] = _mm256_add_ps(sums[27], solid_angle);
+            }
+
+            for (u32 i = 0u; i < NUM_SUMS; i++)
+            {
+                row_sums[row][i] = horizontal_sum(sums[i]);
+            }
+        }
+    });
+
+    // Rows are summed in order, so that the result does not depend on the threads. The solid angles of the texels are
+    // approximations whose sum is rescaled to the sphere's.
+    std::array<f64, NUM_SUMS> sums{};
+    for (const std::array<f32, NUM_SUMS> &row_sum : row_sums)
+    {
+        for (u32 i = 0u; i < NUM_SUMS; i++)
+        {
+            sums[i] += row_sum[i];
+        }
+    }
+
+    const f64 scale = 4.0 * std::numbers::pi / sums[27];
+
+    sh9_t sh{};
+    for (u32 i = 0u; i < 9u; i++)
+    {
+        const f64 coefficient_scale = scale * COSINE_LOBE[i];
+        sh.coefficients[i] = float3_t{static_cast<f32>(sums[i * 3u + 0u] * coefficient_scale),
+                                      static_cast<f32>(sums[i * 3u + 1u] * coefficient_scale),
+                                      static_cast<f32>(sums[i * 3u + 2u] * coefficient_scale)};
+    }
+
+    return sh;
+}
+
+float3_t evaluate_sh9(const sh9_t &sh, const float3_t &direction)
+{
+    const f32 x = direction.x;
+    const f32 y = direction.y;
+    const f32 z = direction.z;
+
+    const std::array<f32, 9> basis = {
+        SH_BAND_0,
+        SH_BAND_1 * y,
+        SH_BAND_1 * z,
+        SH_BAND_1 * x,
+        SH_BAND_2 * x * y,
+        SH_BAND_2 * y * z,
+        SH_BAND_2_ZZ * (3.0f * z * z - 1.0f),
+        SH_BAND_2 * x * z,
+        SH_BAND_2_XX_YY * (x * x - y * y),
+    };
+
+    float3_t result{};
+    for (u32 i = 0u; i < 9u; i++)
+    {
+        result = result + sh.coefficients[i] * basis[i];
+    }
+
+    return result;
+}
+
+cubemap_t prefilter_specular(const cubemap_t &environment, const specular_prefilter_settings_t &settings,
+                             job_system_t *const job_system)
+{
+    if (!std::has_single_bit(environment.size) ||
+        environment.num_mips != static_cast<u32>(std::countr_zero(environment.size)) + 1u)
+    {
+        throw std::runtime_error("The environment of the specular prefilter must have its full mip chain");
+    }
+
+    if (!std::has_single_bit(settings.size) || settings.size > environment.size || settings.num_mips == 0u ||
+        settings.num_mips > static_cast<u32>(std::countr_zero(settings.size)) + 1u || settings.num_samples == 0u)
+    {
+        throw std::runtime_error(std::format("Invalid specular prefilter settings (size {}, {} mips, {} samples) for "
+                                             "an environment of {}x{} faces",
+                                             settings.size, settings.num_mips, settings.num_samples, environment.size,
+                                             environment.size));
+    }
+
+    cubemap_t result{
+        .size = settings.size,
+        .num_mips = settings.num_mips,
+    };
+    result.texels.resize(result.get_texel_index(settings.num_mips - 1u, cubemap_t::NUM_FACES, 0u, 0u));
+
+    // Roughness 0 reflects the environment as is.
+    const u32 first_source_mip =
+        static_cast<u32>(std::countr_zero(environment.size)) - static_cast<u32>(std::countr_zero(settings.size));
+    const u64 first_source_texel = environment.get_texel_index(first_source_mip, 0u, 0u, 0u);
+    const u64 end_source_texel = environment.get_texel_index(first_source_mip, cubemap_t::NUM_FACES, 0u, 0u);
+    std::copy(environment.texels.begin() + static_cast<std::ptrdiff_t>(first_source_texel),
+              environment.texels.begin() + static_cast<std::ptrdiff_t>(end_source_texel), result.texels.begin());
+
+    const cubemap_sampler_t sampler(environment);
+    const f32 texel_solid_angle =
+        4.0f * PI / (static_cast<f32>(cubemap_t::NUM_FACES) * static_cast<f32>(environment.size * environment.size));
+
+    // The samples of a mip, in the tangent space of n (which is also v and r), padded with samples of no weight to a
+    // multiple of 8.
+    struct samples_t
+    {
+        std::vector<f32> x{};
+        std::vector<f32> y{};
+        std::vector<f32> z{};
+        std::vector<f32> weight{};
+        std::vector<f32> mip{};
+    };
+
+    for (u32 mip = 1u; mip < settings.num_mips; mip++)
+    {
+        const f32 roughness = static_cast<f32>(mip) / static_cast<f32>(settings.num_mips - 1u);
+        const f32 alpha = roughness * roughness;
+
+        samples_t samples{};
+        f32 weight_sum = 0.0f;
+
+        for (u32 i = 0u; i < settings.num_samples; i++)
+        {
+            const f32 cos_theta = sample_ggx_cos_theta(radical_inverse(i), alpha);
+            const f32 sin_theta = std::sqrt(std::max(1.0f - cos_theta * cos_theta, 0.0f));
+            const f32 phi = 2.0f * PI * static_cast<f32>(i) / static_cast<f32>(settings.num_samples);
+
+            // l is h's reflection of v = n = +z.
+            const f32 n_dot_l = 2.0f * cos_theta * cos_theta - 1.0f;
+            if (n_dot_l <= 0.0f)
+            {
+                continue;
+            }
+
+            // The pdf of l is D * n.h / (4 v.h), which is D / 4 when v = n.
+            const f32 pdf = get_ggx_distribution(cos_theta, alpha) * 0.25f;
+            const f32 sample_solid_angle = 1.0f / (static_cast<f32>(settings.num_samples) * pdf);
+            const f32 source_mip = std::clamp(0.5f * std::log2(sample_solid_angle / texel_solid_angle) + 1.0f, 0.0f,
+                                              static_cast<f32>(environment.num_mips - 1u));
+
+            samples.x.push_back(2.0f * cos_theta * sin_theta * std::cos(phi));
+            samples.y.push_back(2.0f * cos_theta * sin_theta * std::sin(phi));
+            samples.z.push_back(n_dot_l);
+            samples.weight.push_back(n_dot_l);
+            samples.mip.push_back(source_mip);
+            weight_sum += n_dot_l;
+        }
+
+        while (samples.weight.size() % 8u != 0u)
+        {
+            samples.x.push_back(0.0f);
+            samples.y.push_back(0.0f);
+            samples.z.push_back(1.0f);
+            samples.weight.push_back(0.0f);
+            samples.mip.push_back(0.0f);
+        }
+
+        const u32 num_samples = static_cast<u32>(samples.weight.size());
+        const f32 inverse_weight_sum = 1.0f / weight_sum;
+        const u32 mip_size = settings.size >> mip;
+
+        run_rows(job_system, cubemap_t::NUM_FACES * mip_size, [&](const u32 begin, const u32 end, const u32) {
+            for (u32 row = begin; row < end; row++)
+            {
+                const u32 face = row / mip_size;
+                const u32 y = row % mip_size;
+
+                for (u32 x = 0u; x < mip_size; x++)
+                {
+                    const float3_t normal =
+                        get_cubemap_direction(face, (static_cast<f32>(x) + 0.5f) / static_cast<f32>(mip_size),
+                                              (static_cast<f32>(y) + 0.5f) / static_cast<f32>(mip_size));
+
+                    float3_t tangent{};
+                    float3_t bitangent{};
+                    get_basis(normal, tangent, bitangent);
+
+                    __m256 r_sum = _mm256_setzero_ps();
+                    __m256 g_sum = _mm256_setzero_ps();
+                    __m256 b_sum = _mm256_setzero_ps();
+
+                    for (u32 i = 0u; i < num_samples; i += 8u)
+                    {
+                        const __m256 sample_x = _mm256_loadu_ps(&samples.x[i]);
+                        const __m256 sample_y = _mm256_loadu_ps(&samples.y[i]);
+                        const __m256 sample_z = _mm256_loadu_ps(&samples.z[i]);
+
+                        const auto to_world = [&](const f32 t, const f32 b, const f32 n) {
+                            return _mm256_fmadd_ps(sample_x, _mm256_set1_ps(t),
+                                                   _mm256_fmadd_ps(sample_y, _mm256_set1_ps(b),
+                                                                   _mm256_mul_ps(sample_z, _mm256_set1_ps(n))));
+                        };
+
+                        __m256 r{}, g{}, b{};
+                        sampler.sample(to_world(tangent.x, bitangent.x, normal.x),
+                                       to_world(tangent.y, bitangent.y, normal.y),
+                                       to_world(tangent.z, bitangent.z, normal.z), _mm256_loadu_ps(&samples.mip[i]), r,
+                                       g, b);
+
+                        const __m256 weight = _mm256_loadu_ps(&samples.weight[i]);
+                        r_sum = _mm256_fmadd_ps(r, weight, r_sum);
+                        g_sum = _mm256_fmadd_ps(g, weight, g_sum);
+                        b_sum = _mm256_fmadd_ps(b, weight, b_sum);
+                    }
+
+                    result.texels[result.get_texel_index(mip, face, x, y)] =
+                        float3_t{horizontal_sum(r_sum), horizontal_sum(g_sum), horizontal_sum(b_sum)} *
+                        inverse_weight_sum;
+                }
+            }
+        });
+    }
+
+    return result;
+}
+
+brdf_lut_t compute_brdf_lut(const u32 size, const u32 num_samples, job_system_t *const job_system)
+{
+    if (size == 0u || num_samples == 0u)
+    {
+        throw std::runtime_error(std::format("Invalid BRDF LUT of {}x{} texels and {} samples", size, size,
+                                             num_samples));
+    }
+
+    // The Hammersley points that do not depend on the roughness, padded with samples of no weight to a multiple of 8.
+    const u32 num_padded_samples = (num_samples + 7u) & ~7u;
+    std::vector<f32> cos_phis(num_padded_samples);
+    std::vector<f32> xis(num_padded_samples);
+    std::vector<f32> masks(num_padded_samples);
+    for (u32 i = 0u; i < num_samples; i++)
+    {
+        cos_phis[i] = std::cos(2.0f * PI * static_cast<f32>(i) / static_cast<f32>(num_samples));
+        xis[i] = radical_inverse(i);
+        masks[i] = 1.0f;
+    }
+
+    brdf_lut_t brdf_lut{
+        .size = size,
+        .texels = std::vector<float2_t>(static_cast<size_t>(size) * size),
+    };
+
+    const f32 inverse_num_samples = 1.0f / static_cast<f32>(num_samples);
+
+    run_rows(job_system, size, [&](const u32 begin, const u32 end, const u32) {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+
+        for (u32 y = begin; y < end; y++)
+        {
+            const f32 roughness = (static_cast<f32>(y) + 0.5f) / static_cast<f32>(size);
+            const f32 alpha = roughness * roughness;
+
+            // Schlick-GGX's k for image based lighting.
+            const __m256 k = _mm256_set1_ps(alpha * 0.5f);
+            const __m256 one_minus_k = _mm256_sub_ps(one, k);
+            const __m256 alpha_squared_minus_one = _mm256_set1_ps(alpha * alpha - 1.0f);
+
+            for (u32 x = 0u; x < size; x++)
+            {
+                // v in the xz plane, at n.v from n = +z.
+                const f32 n_dot_v_scalar = (static_cast<f32>(x) + 0.5f) / static_cast<f32>(size);
+                const __m256 n_dot_v = _mm256_set1_ps(n_dot_v_scalar);
+                const __m256 v_x = _mm256_set1_ps(std::sqrt(1.0f - n_dot_v_scalar * n_dot_v_scalar));
+                const __m256 g_v = _mm256_div_ps(n_dot_v, _mm256_fmadd_ps(n_dot_v, one_minus_k, k));
+
+                __m256 scale_sum = zero;
+                __m256 bias_sum = zero;
+
+                for (u32 i = 0u; i < num_padded_samples; i += 8u)
+                {
+                    const __m256 xi = _mm256_loadu_ps(&xis[i]);
+                    const __m256 n_dot_h = _mm256_sqrt_ps(
+                        _mm256_div_ps(_mm256_sub_ps(one, xi), _mm256_fmadd_ps(alpha_squared_minus_one, xi, one)));
+                    const __m256 sin_theta =
+                        _mm256_sqrt_ps(_mm256_max_ps(_mm256_fnmadd_ps(n_dot_h, n_dot_h, one), zero));
+                    const __m256 h_x = _mm256_mul_ps(sin_theta, _mm256_loadu_ps(&cos_phis[i]));
+
+                    const __m256 v_dot_h =
+                        _mm256_max_ps(_mm256_fmadd_ps(v_x, h_x, _mm256_mul_ps(n_dot_v, n_dot_h)), zero);
+                    const __m256 n_dot_l = _mm256_fmsub_ps(_mm256_add_ps(v_dot_h, v_dot_h), n_dot_h, n_dot_v);
+
+                    const __m256 is_valid = _mm256_and_ps(_mm256_cmp_ps(n_dot_l, zero, _CMP_GT_OQ),
+                                                          _mm256_cmp_ps(_mm256_loadu_ps(&masks[i]), zero, _CMP_GT_OQ));
+
+                    // G * v.h / (n.h * n.v), and Schlick's Fresnel term.
+                    const __m256 g_l = _mm256_div_ps(n_dot_l, _mm256_fmadd_ps(n_dot_l, one_minus_k, k));
+                    const __m256 g_visibility = _mm256_and_ps(
+                        _mm256_div_ps(_mm256_mul_ps(_mm256_mul_ps(g_v, g_l), v_dot_h), _mm256_mul_ps(n_dot_h, n_dot_v)),
+                        is_valid);
+
+                    const __m256 one_minus_v_dot_h = _mm256_sub_ps(one, v_dot_h);
+                    const __m256 squared = _mm256_mul_ps(one_minus_v_dot_h, one_minus_v_dot_h);
+                    const __m256 fresnel = _mm256_mul_ps(_mm256_mul_ps(squared, squared), one_minus_v_dot_h);
+
+                    scale_sum = _mm256_fmadd_ps(_mm256_sub_ps(one, fresnel), g_visibility, scale_sum);
+                    bias_sum = _mm256_fmadd_ps(fresnel, g_visibility, bias_sum);
+                }
+
+                brdf_lut.texels[y * size + x] = float2_t{horizontal_sum(scale_sum) * inverse_num_samples,
+                                                         horizontal_sum(bias_sum) * inverse_num_samples};
+            }
+        }
+    });
+
+    return brdf_lut;
+}
+
+dds_image_t to_dds_image(const cubemap_t &cubemap)
+{
+    dds_image_t image{
+        .format = dds_format_t::r16g16b16a16_float,
+        .width = cubemap.size,
+        .height = cubemap.size,
+        .num_mips = cubemap.num_mips,
+        .is_cubemap = true,
+    };
+
+    image.data.resize(get_dds_data_size(image));
+    u16 *data = reinterpret_cast<u16 *>(image.data.data());
+
+    // DDS files store the mips of every face together.
+    for (u32 face = 0u; face < cubemap_t::NUM_FACES; face++)
+    {
+        for (u32 mip = 0u; mip < cubemap.num_mips; mip++)
+        {
+            const u64 first_texel = cubemap.get_texel_index(mip, face, 0u, 0u);
+            const u64 num_texels = static_cast<u64>(cubemap.size >> mip) * (cubemap.size >> mip);
+
+            for (u64 i = first_texel; i < first_texel + num_texels; i++)
+            {
+                *data++ = f32_to_f16(cubemap.texels[i].x);
+                *data++ = f32_to_f16(cubemap.texels[i].y);
+                *data++ = f32_to_f16(cubemap.texels[i].z);
+                *data++ = f32_to_f16(1.0f);
+            }
+        }
+    }
+
+    return image;
+}
+
+dds_image_t to_dds_image(const sh9_t &sh)
+{
+    dds_image_t image{
+        .format = dds_format_t::r32g32b32a32_float,
+        .width = 9u,
+        .height = 1u,
+    };
+
+    std::array<float4_t, 9> texels{};
+    for (u32 i = 0u; i < 9u; i++)
+    {
+        texels[i] = float4_t{sh.coefficients[i].x, sh.coefficients[i].y, sh.coefficients[i].z, 0.0f};
+    }
+
+    image.data.resize(sizeof(texels));
+    std::memcpy(image.data.data(), texels.data(), sizeof(texels));
+
+    return image;
+}
+
+dds_image_t to_dds_image(const brdf_lut_t &brdf_lut)
+{
+    dds_image_t image{
+        .format = dds_format_t::r16g16_float,
+        .width = brdf_lut.size,
+        .height = brdf_lut.size,
+    };
+
+    image.data.resize(get_dds_data_size(image));
+    u16 *const data = reinterpret_cast<u16 *>(image.data.data());
+    for (size_t i = 0u; i < brdf_lut.texels.size(); i++)
+    {
+        data[i * 2u + 0u] = f32_to_f16(brdf_lut.texels[i].x);
+        data[i * 2u + 1u] = f32_to_f16(brdf_lut.texels[i].y);
+    }
+
+    return image;
+}
+} // namespace nether
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "common.hpp"
+#include "dds.hpp"
+#include "job_system.hpp"
+#include "math.hpp"
+
+// Offline precomputation of image based lighting from an HDR environment, so that the engine pays no GPU cost for it
+// at startup.
+//  - Environments are loaded from Radiance .hdr files, either as an equirectangular panorama or as 6 cube faces.
+//  - Diffuse : the environment's radiance is projected onto the 9 spherical harmonics of bands 0 to 2, and convolved
+//    with the clamped cosine lobe, which gives the irradiance of any normal within a few percent (Ramamoorthi and
+//    Hanrahan, An Efficient Representation for Irradiance Environment Maps).
+//  - Specular : a cubemap mip chain prefiltered with the GGX distribution (the first sum of Karis' split sum, with
+//    n = v = r), mip m for roughness m / (num_mips - 1). Every texel importance samples the distribution, and reads
+//    each sample from the environment mip whose texels cover the sample's solid angle (Krivanek and Colbert's
+//    filtered importance sampling), so few samples are needed without aliasing.
+//  - BRDF : the second sum, as the scale and bias of F0 for every (n.v, roughness).
+// The loops over texels run in parallel on the job system, and process 8 samples (or 8 texels) at once with AVX2.
+// Roughness is perceptual (alpha = roughness^2), and the cubemaps' faces are in D3D order and orientation.
+namespace nether
+{
+// Row major RGB texels, the first row at the top.
+struct hdr_image_t
+{
+    u32 width{};
+    u32 height{};
+    std::vector<float3_t> texels{};
+};
+
+// Radiance RGBE files, with flat or run length encoded scanlines, in the standard -Y +X orientation. Throws
+// otherwise.
+hdr_image_t read_hdr_image(const std::filesystem::path &path);
+
+// Scanlines of 8 to 32767 texels are run length encoded (as literals only), so that readers never mistake them for
+// flat ones.
+void write_hdr_image(const std::filesystem::path &path, const hdr_image_t &image);
+
+struct cubemap_t
+{
+    static constexpr u32 NUM_FACES = 6u;
+
+    u32 size{};
+    u32 num_mips{1u};
+
+    // Mip by mip (largest first), and face by face in a mip (+x, -x, +y, -y, +z, -z), in rows of texels.
+    std::vector<float3_t> texels{};
+
+    u64 get_texel_index(const u32 mip, const u32 face, const u32 x, const u32 y) const;
+};
+
+// Unit direction through the texel coordinates (in [0, 1], the first row at the top) of a face.
+float3_t get_cubemap_direction(const u32 face, const f32 u, const f32 v);
+
+// The panorama's u is the angle around y (from +x towards +z), and its v the angle from +y.
+cubemap_t equirectangular_to_cubemap(const hdr_image_t &image, const u32 size,
+                                     job_system_t *const job_system = nullptr);
+
+// Throws unless the 6 faces are square images of the same size.
+cubemap_t cubemap_from_faces(const std::span<const hdr_image_t> faces);
+
+// Replaces the mips of the cubemap by the full chain down to 1x1 texel faces, each the 2x2 box filter of the previous.
+// Throws unless the size is a power of 2.
+void generate_cubemap_mips(cubemap_t &cubemap, job_system_t *const job_system = nullptr);
+
+// Irradiance as spherical harmonics of bands 0 to 2 (the radiance's coefficients, already convolved with the clamped
+// cosine) : E(n) = sum of coefficients[i] * Y_i(n), with the real basis of evaluate_sh9.
+struct sh9_t
+{
+    std::array<float3_t, 9> coefficients{};
+};
+
+// The cubemap's first mip is projected, every texel weighted by its solid angle.
+sh9_t compute_irradiance_sh9(const cubemap_t &environment, job_system_t *const job_system = nullptr);
+
+float3_t evaluate_sh9(const sh9_t &sh, const float3_t &direction);
+
+struct specular_prefilter_settings_t
+{
+    // Of the first mip (roughness 0), which is the environment's mip of this size. Must be a power of 2.
+    u32 size{128u};
+    u32 num_mips{6u};
+
+    // GGX samples per texel, for every mip past the first.
+    u32 num_samples{128u};
+};
+
+// The environment must have its full mip chain (see generate_cubemap_mips). Throws if the settings do not fit it.
+cubemap_t prefilter_specular(const cubemap_t &environment, const specular_prefilter_settings_t &settings,
+                             job_system_t *const job_system = nullptr);
+
+// The specular light of a surface is prefiltered(r, roughness) * (F0 * x + y) of the texel at (n.v, roughness).
+struct brdf_lut_t
+{
+    u32 size{};
+
+    // Rows of roughness, columns of n.v, both sampled at the texel centers.
+    std::vector<float2_t> texels{};
+};
+
+brdf_lut_t compute_brdf_lut(const u32 size, const u32 num_samples, job_system_t *const job_system = nullptr);
+
+// GPU-ready DDS files : cubemaps (with all their mips) in R16G16B16A16_FLOAT, the spherical harmonics as a 9x1
+// R32G32B32A32_FLOAT texture, and the BRDF as R16G16_FLOAT.
+dds_image_t to_dds_image(const cubemap_t &cubemap);
+dds_image_t to_dds_image(const sh9_t &sh);
+dds_image_t to_dds_image(const brdf_lut_t &brdf_lut);
+} // namespace nether
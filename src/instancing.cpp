@@ -0,0 +1,150 @@
+#include "instancing.hpp"
+
+namespace nether
+{
+static u64 get_sort_key(const draw_packet_t &draw_packet)
+{
+    return (static_cast<u64>(draw_packet.pipeline_index) << 48u) |
+           (static_cast<u64>(draw_packet.material_index) << 24u) | static_cast<u64>(draw_packet.mesh_index);
+}
+
+void instance_batcher_t::reset()
+{
+    draw_packets.clear();
+    instanced_draws.clear();
+
+    statistics = {};
+}
+
+void instance_batcher_t::add_draw_packet(const draw_packet_t &draw_packet)
+{
+    if (draw_packet.pipeline_index >= MAX_PIPELINES || draw_packet.material_index >= MAX_MATERIALS ||
+        draw_packet.mesh_index >= MAX_MESHES)
+    {
+        throw std::runtime_error("Draw packet index out of range of the instance batcher's sort key");
+    }
+
+    draw_packets.push_back(draw_packet);
+}
+
+std::span<const instanced_draw_t> instance_batcher_t::build(const std::span<instance_data_t> instance_data)
+{
+    if (instance_data.size() < draw_packets.size())
+    {
+        throw std::runtime_error("Instance data buffer is too small for the number of draw packets");
+    }
+
+    sort_draw_packets();
+
+    for (size_t i = 0u; i < sort_entries.size(); i++)
+    {
+        const draw_packet_t &draw_packet = draw_packets[sort_entries[i].draw_packet_index];
+        instance_data[i] = {
+            .model_matrix = draw_packet.model_matrix,
+            .color = draw_packet.color,
+        };
+    }
+
+    return instanced_draws;
+}
+
+std::span<const instanced_draw_t> instance_batcher_t::build(const std::span<u32> object_indices)
+{
+    if (object_indices.size() < draw_packets.size())
+    {
+        throw std::runtime_error("Object index buffer is too small for the number of draw packets");
+    }
+
+    sort_draw_packets();
+
+    for (size_t i = 0u; i < sort_entries.size(); i++)
+    {
+        object_indices[i] = draw_packets[sort_entries[i].draw_packet_index].object_index;
+    }
+
+    return instanced_draws;
+}
+
+void instance_batcher_t::sort_draw_packets()
+{
+    const u32 num_draw_packets = static_cast<u32>(draw_packets.size());
+
+    sort_entries.resize(num_draw_packets);
+    sort_scratch.resize(num_draw_packets);
+
+    // LSD radix sort over 8 bit digits. In practice most digits of the key are the same for every packet (there are
+    // few pipelines and materials), and passes over those digits are skipped entirely.
+    // Build the sort keys and the histograms of all 8 digits in a single pass.
+    static constexpr u32 NUM_DIGITS = 8u;
+    static constexpr u32 NUM_BUCKETS = 256u;
+
+    std::array<std::array<u32, NUM_BUCKETS>, NUM_DIGITS> histograms{};
+
+    for (u32 i = 0u; i < num_draw_packets; i++)
+    {
+        const u64 key = get_sort_key(draw_packets[i]);
+        sort_entries[i] = {
+            .key = key,
+            .draw_packet_index = i,
+        };
+
+        for (u32 digit = 0u; digit < NUM_DIGITS; digit++)
+        {
+            histograms[digit][(key >> (digit * 8u)) & 0xffu]++;
+        }
+    }
+
+    for (u32 digit = 0u; digit < NUM_DIGITS; digit++)
+    {
+        std::array<u32, NUM_BUCKETS> &histogram = histograms[digit];
+
+        // If every key falls in the same bucket this pass would not change the order.
+        if (num_draw_packets == 0u || histogram[(sort_entries[0].key >> (digit * 8u)) & 0xffu] == num_draw_packets)
+        {
+            continue;
+        }
+
+        u32 offset = 0u;
+        for (u32 &bucket : histogram)
+        {
+            const u32 count = bucket;
+            bucket = offset;
+            offset += count;
+        }
+
+        for (const sort_entry_t &sort_entry : sort_entries)
+        {
+            sort_scratch[histogram[(sort_entry.key >> (digit * 8u)) & 0xffu]++] = sort_entry;
+        }
+
+        std::swap(sort_entries, sort_scratch);
+    }
+
+    // Sorted entries with equal keys form one instanced draw. Instances are written in sorted order, so each draw's
+    // instances are contiguous.
+    instanced_draws.clear();
+
+    for (u32 i = 0u; i < num_draw_packets; i++)
+    {
+        const draw_packet_t &draw_packet = draw_packets[sort_entries[i].draw_packet_index];
+
+        if (i == 0u || sort_entries[i].key != sort_entries[i - 1u].key)
+        {
+            instanced_draws.push_back({
+                .mesh_index = draw_packet.mesh_index,
+                .pipeline_index = draw_packet.pipeline_index,
+                .material_index = draw_packet.material_index,
+                .first_instance = i,
+                .instance_count = 0u,
+            });
+        }
+
+        instanced_draws.back().instance_count++;
+    }
+
+    statistics = {
+        .num_draw_packets = num_draw_packets,
+        .num_instanced_draws = static_cast<u32>(instanced_draws.size()),
+    };
+}
+} // namespace nether
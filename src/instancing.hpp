@@ -0,0 +1,94 @@
+#pragma once
+
+#include "common.hpp"
+#include "math.hpp"
+
+namespace nether
+{
+// A request to draw a single mesh, submitted every frame by the scene.
+struct draw_packet_t
+{
+    u32 mesh_index{};
+    u32 pipeline_index{};
+    u32 material_index{};
+
+    float4x4_t model_matrix{};
+    float4_t color{};
+
+    // Index of the object's record in the GPU scene (see gpu_scene.hpp), when the instances refer to it instead of
+    // carrying their data.
+    u32 object_index{};
+};
+
+// Per instance data written by the instance batcher. Must match instance_data_t in shaders/common.hlsli.
+struct instance_data_t
+{
+    float4x4_t model_matrix{};
+    float4_t color{};
+};
+
+// A group of draw packets that share (pipeline, material, mesh), issued as a single DrawIndexedInstanced call.
+// The shader fetches per instance data at index first_instance + SV_InstanceID (SV_InstanceID does not include the
+// StartInstanceLocation in d3d12, so first_instance is passed through the root constants).
+struct instanced_draw_t
+{
+    u32 mesh_index{};
+    u32 pipeline_index{};
+    u32 material_index{};
+
+    u32 first_instance{};
+    u32 instance_count{};
+};
+
+struct instancing_statistics_t
+{
+    u32 num_draw_packets{};
+    u32 num_instanced_draws{};
+};
+
+// Groups draw packets by (pipeline, material, mesh) so that identical meshes are drawn with one instanced draw.
+// Draws are ordered by pipeline first, then material, to minimize state changes. The order of packets within a group
+// is preserved.
+class instance_batcher_t
+{
+  public:
+    // The sort key packs the indices into 64 bits, which limits how large each of them can be.
+    static constexpr u32 MAX_PIPELINES = 1u << 16u;
+    static constexpr u32 MAX_MATERIALS = 1u << 24u;
+    static constexpr u32 MAX_MESHES = 1u << 24u;
+
+    void reset();
+
+    void add_draw_packet(const draw_packet_t &draw_packet);
+
+    // Writes the per instance data of all packets into instance_data (which is usually mapped upload memory, and must
+    // have space for all packets), and returns the instanced draws to issue. The returned span is valid until the next
+    // call to reset.
+    std::span<const instanced_draw_t> build(const std::span<instance_data_t> instance_data);
+
+    // Same as above, but writes the object index of each packet instead of its data (4 bytes per instance instead of
+    // 80), for shaders that fetch the object's data from the GPU scene.
+    std::span<const instanced_draw_t> build(const std::span<u32> object_indices);
+
+  public:
+    std::vector<draw_packet_t> draw_packets{};
+    std::vector<instanced_draw_t> instanced_draws{};
+
+    instancing_statistics_t statistics{};
+
+  private:
+    // Sorts the packets and groups them into instanced draws. Instance i of the sorted order is the packet
+    // sort_entries[i].draw_packet_index.
+    void sort_draw_packets();
+
+  private:
+    struct sort_entry_t
+    {
+        u64 key{};
+        u32 draw_packet_index{};
+    };
+
+    std::vector<sort_entry_t> sort_entries{};
+    std::vector<sort_entry_t> sort_scratch{};
+};
+} // namespace nether
@@ -0,0 +1,140 @@
+#include "job_system.hpp"
+
+namespace nether
+{
+static thread_local u32 g_thread_index = 0u;
+
+job_system_t::job_system_t(const u32 num_worker_threads)
+{
+    worker_threads.reserve(num_worker_threads);
+    for (u32 i = 0u; i < num_worker_threads; i++)
+    {
+        worker_threads.emplace_back(&job_system_t::worker_thread_main, this, i + 1u);
+    }
+}
+
+job_system_t::~job_system_t()
+{
+    {
+        std::scoped_lock lock(queue_mutex);
+        quit = true;
+    }
+
+    queue_condition_variable.notify_all();
+
+    for (std::thread &worker_thread : worker_threads)
+    {
+        worker_thread.join();
+    }
+}
+
+u32 job_system_t::get_thread_index()
+{
+    return g_thread_index;
+}
+
+void job_system_t::submit(std::function<void()> job)
+{
+    {
+        std::scoped_lock lock(queue_mutex);
+        job_queue.push_back(std::move(job));
+    }
+
+    queue_condition_variable.notify_one();
+}
+
+void job_system_t::parallel_for(const u32 count, const u32 batch_size,
+                                const std::function<void(u32, u32, u32)> &function)
+{
+    if (count == 0u)
+    {
+        return;
+    }
+
+    const u32 num_batches = (count + batch_size - 1u) / batch_size;
+
+    // Small ranges are not worth the overhead of waking up workers.
+    if (num_batches == 1u || worker_threads.empty())
+    {
+        function(0u, count, get_thread_index());
+        return;
+    }
+
+    struct parallel_for_state_t
+    {
+        std::atomic<u32> next_batch{};
+        std::atomic<u32> num_completed_batches{};
+    };
+
+    // The state is shared with helper jobs that may only start after this function has returned (if the calling thread
+    // processed every batch itself), so it must outlive this stack frame.
+    const std::shared_ptr<parallel_for_state_t> state = std::make_shared<parallel_for_state_t>();
+
+    const auto process_batches = [state, count, batch_size, num_batches, &function]() {
+        u32 batch_index = 0u;
+        while ((batch_index = state->next_batch.fetch_add(1u, std::memory_order_relaxed)) < num_batches)
+        {
+            const u32 begin = batch_index * batch_size;
+            const u32 end = std::min(begin + batch_size, count);
+
+            function(begin, end, get_thread_index());
+
+            state->num_completed_batches.fetch_add(1u, std::memory_order_release);
+        }
+    };
+
+    // Helper jobs only reference function while batches remain, and no batch can be claimed after this function
+    // returns, so capturing it by reference is safe.
+    const u32 num_helper_jobs = std::min(static_cast<u32>(worker_threads.size()), num_batches - 1u);
+    for (u32 i = 0u; i < num_helper_jobs; i++)
+    {
+        submit(process_batches);
+    }
+
+    process_batches();
+
+    while (state->num_completed_batches.load(std::memory_order_acquire) < num_batches)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void job_system_t::wait_for_idle()
+{
+    std::unique_lock lock(queue_mutex);
+    idle_condition_variable.wait(lock, [&]() { return job_queue.empty() && num_executing_jobs == 0u; });
+}
+
+void job_system_t::worker_thread_main(const u32 thread_index)
+{
+    g_thread_index = thread_index;
+
+    while (true)
+    {
+        std::function<void()> job{};
+
+        {
+            std::unique_lock lock(queue_mutex);
+            queue_condition_variable.wait(lock, [&]() { return quit || !job_queue.empty(); });
+
+            if (quit && job_queue.empty())
+            {
+                return;
+            }
+
+            job = std::move(job_queue.front());
+            job_queue.pop_front();
+            num_executing_jobs++;
+        }
+
+        job();
+
+        {
+            std::scoped_lock lock(queue_mutex);
+            num_executing_jobs--;
+        }
+
+        idle_condition_variable.notify_all();
+    }
+}
+} // namespace nether
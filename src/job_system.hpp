@@ -0,0 +1,61 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace nether
+{
+// A fixed size pool of worker threads.
+// Jobs are pulled from a single shared queue. parallel_for splits a range into batches that the workers *and* the
+// calling thread pull from an atomic counter, so it can be safely called from within a job.
+class job_system_t
+{
+  public:
+    // By default, one worker per hardware thread (minus the calling thread).
+    explicit job_system_t(const u32 num_worker_threads = std::max(std::thread::hardware_concurrency(), 2u) - 1u);
+    ~job_system_t();
+
+    job_system_t(const job_system_t &) = delete;
+    job_system_t &operator=(const job_system_t &) = delete;
+
+    // Number of threads that can execute jobs (the workers and the calling thread).
+    u32 get_num_threads() const
+    {
+        return static_cast<u32>(worker_threads.size()) + 1u;
+    }
+
+    // Index of the current thread in [0, get_num_threads()). The thread that created the job system has index 0.
+    static u32 get_thread_index();
+
+    // Queue a job for execution on a worker thread. Returns immediately.
+    void submit(std::function<void()> job);
+
+    // Calls function(begin, end, thread_index) for consecutive batches of at most batch_size elements that together
+    // cover [0, count). Blocks until every batch has been processed.
+    void parallel_for(const u32 count, const u32 batch_size, const std::function<void(u32, u32, u32)> &function);
+
+    // Blocks until the queue is empty and no job is executing.
+    void wait_for_idle();
+
+  private:
+    void worker_thread_main(const u32 thread_index);
+
+  private:
+    std::vector<std::thread> worker_threads{};
+
+    std::mutex queue_mutex{};
+    std::condition_variable queue_condition_variable{};
+    std::condition_variable idle_condition_variable{};
+    std::deque<std::function<void()>> job_queue{};
+
+    u32 num_executing_jobs{};
+    bool quit{};
+};
+} // namespace nether
@@ -0,0 +1,1007 @@
+#include "lightmap_baker.hpp"
+
+#include "dds.hpp"
+#include "vertex_compression.hpp"
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+
+namespace nether
+{
+namespace
+{
+constexpr f32 PI = std::numbers::pi_v<f32>;
+
+// Triangles of the same chart have normals within ~2.5 degrees of each other.
+constexpr f32 CHART_NORMAL_THRESHOLD = 0.999f;
+
+float3_t to_float3(const float4_t &vector)
+{
+    return float3_t{vector.x, vector.y, vector.z};
+}
+
+float3_t multiply(const float3_t &a, const float3_t &b)
+{
+    return float3_t{a.x * b.x, a.y * b.y, a.z * b.z};
+}
+
+f32 get_luminance(const float3_t &color)
+{
+    return 0.2126f * color.x + 0.7152f * color.y + 0.0722f * color.z;
+}
+
+f32 cross_2d(const float2_t &a, const float2_t &b)
+{
+    return a.x * b.y - a.y * b.x;
+}
+
+f32 smoothstep(const f32 edge_0, const f32 edge_1, const f32 x)
+{
+    const f32 t = std::clamp((x - edge_0) / (edge_1 - edge_0), 0.0f, 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+// Orthonormal basis around a unit vector (Duff et al., Building an Orthonormal Basis, Revisited).
+void get_basis(const float3_t &normal, float3_t &tangent, float3_t &bitangent)
+{
+    const f32 sign = std::copysign(1.0f, normal.z);
+    const f32 a = -1.0f / (sign + normal.z);
+    const f32 b = normal.x * normal.y * a;
+
+    tangent = float3_t{1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x};
+    bitangent = float3_t{b, sign + normal.y * normal.y * a, -normal.y};
+}
+
+u64 hash(u64 value)
+{
+    // splitmix64's finalizer.
+    value = (value ^ (value >> 30u)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27u)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31u);
+}
+
+u64 get_edge_key(const u32 a, const u32 b)
+{
+    return (static_cast<u64>(std::min(a, b)) << 32u) | std::max(a, b);
+}
+
+std::vector<float3_t> get_world_positions(const lightmap_mesh_t &mesh)
+{
+    std::vector<float3_t> positions(mesh.positions.size());
+    for (size_t i = 0u; i < positions.size(); i++)
+    {
+        positions[i] = to_float3(transform_point(mesh.positions[i], mesh.model_matrix));
+    }
+
+    return positions;
+}
+
+// Zero for degenerate triangles.
+float3_t get_triangle_normal(const std::span<const float3_t> positions, const std::span<const u32> indices,
+                             const u32 triangle)
+{
+    const float3_t &a = positions[indices[triangle * 3u + 0u]];
+    const float3_t &b = positions[indices[triangle * 3u + 1u]];
+    const float3_t &c = positions[indices[triangle * 3u + 2u]];
+    const float3_t normal = cross(b - a, c - a);
+
+    const f32 normal_length = length(normal);
+    return normal_length > 1e-12f ? normal * (1.0f / normal_length) : float3_t{};
+}
+} // namespace
+
+lightmap_atlas_t unwrap_lightmap(const std::span<const lightmap_mesh_t> meshes,
+                                 const lightmap_bake_settings_t &settings)
+{
+    if (settings.texels_per_unit <= 0.0f || settings.atlas_width == 0u)
+    {
+        throw std::runtime_error(std::format("Invalid lightmap resolution ({} texels per unit, atlas width {})",
+                                             settings.texels_per_unit, settings.atlas_width));
+    }
+
+    lightmap_atlas_t atlas{};
+    atlas.width = settings.atlas_width;
+    atlas.mesh_uvs.resize(meshes.size());
+
+    // The projection of every chart onto its plane, in texels.
+    struct chart_projection_t
+    {
+        float3_t tangent{};
+        float3_t bitangent{};
+        float2_t min{};
+    };
+
+    std::vector<chart_projection_t> projections{};
+
+    for (u32 mesh_index = 0u; mesh_index < static_cast<u32>(meshes.size()); mesh_index++)
+    {
+        const lightmap_mesh_t &mesh = meshes[mesh_index];
+        if (mesh.indices.size() % 3u != 0u)
+        {
+            throw std::runtime_error(std::format("Lightmap mesh {} has {} indices, which is not a multiple of 3",
+                                                 mesh_index, mesh.indices.size()));
+        }
+
+        const std::vector<float3_t> positions = get_world_positions(mesh);
+        const u32 num_triangles = static_cast<u32>(mesh.indices.size() / 3u);
+
+        std::vector<float3_t> normals(num_triangles);
+        for (u32 triangle = 0u; triangle < num_triangles; triangle++)
+        {
+            normals[triangle] = get_triangle_normal(positions, mesh.indices, triangle);
+        }
+
+        // Triangles sharing an edge are adjacent, found by binary search of the sorted edges.
+        std::vector<std::pair<u64, u32>> edges{};
+        edges.reserve(mesh.indices.size());
+        for (u32 triangle = 0u; triangle < num_triangles; triangle++)
+        {
+            for (u32 corner = 0u; corner < 3u; corner++)
+            {
+                edges.emplace_back(get_edge_key(mesh.indices[triangle * 3u + corner],
+                                                mesh.indices[triangle * 3u + (corner + 1u) % 3u]),
+                                   triangle);
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+
+        // Degenerate triangles belong to no chart, and keep UVs of 0.
+        std::vector<u8> is_assigned(num_triangles);
+        std::vector<u32> stack{};
+
+        atlas.mesh_uvs[mesh_index].resize(mesh.indices.size());
+
+        for (u32 seed_triangle = 0u; seed_triangle < num_triangles; seed_triangle++)
+        {
+            if (is_assigned[seed_triangle] || dot(normals[seed_triangle], normals[seed_triangle]) == 0.0f)
+            {
+                continue;
+            }
+
+            const float3_t chart_normal = normals[seed_triangle];
+
+            lightmap_chart_t chart{
+                .mesh_index = mesh_index,
+                .first_triangle = static_cast<u32>(atlas.chart_triangles.size()),
+            };
+
+            // Flood fill over the edges, to the adjacent triangles with the same normal.
+            is_assigned[seed_triangle] = 1u;
+            stack.push_back(seed_triangle);
+            while (!stack.empty())
+            {
+                const u32 triangle = stack.back();
+                stack.pop_back();
+                atlas.chart_triangles.push_back(triangle);
+
+                for (u32 corner = 0u; corner < 3u; corner++)
+                {
+                    const u64 key = get_edge_key(mesh.indices[triangle * 3u + corner],
+                                                 mesh.indices[triangle * 3u + (corner + 1u) % 3u]);
+
+                    for (auto edge = std::lower_bound(edges.begin(), edges.end(), std::pair<u64, u32>{key, 0u});
+                         edge != edges.end() && edge->first == key; ++edge)
+                    {
+                        const u32 neighbour = edge->second;
+                        if (!is_assigned[neighbour] && dot(normals[neighbour], chart_normal) > CHART_NORMAL_THRESHOLD)
+                        {
+                            is_assigned[neighbour] = 1u;
+                            stack.push_back(neighbour);
+                        }
+                    }
+                }
+            }
+
+            chart.num_triangles = static_cast<u32>(atlas.chart_triangles.size()) - chart.first_triangle;
+
+            // Project onto the chart's plane, with the tangent horizontal when possible.
+            chart_projection_t projection{};
+            const float3_t reference =
+                std::abs(chart_normal.y) < 0.99f ? float3_t{0.0f, 1.0f, 0.0f} : float3_t{1.0f, 0.0f, 0.0f};
+            projection.tangent = normalize(cross(reference, chart_normal));
+            projection.bitangent = cross(chart_normal, projection.tangent);
+
+            float2_t min{INFINITY, INFINITY};
+            float2_t max{-INFINITY, -INFINITY};
+            for (u32 i = chart.first_triangle; i < chart.first_triangle + chart.num_triangles; i++)
+            {
+                for (u32 corner = 0u; corner < 3u; corner++)
+                {
+                    const float3_t &position = positions[mesh.indices[atlas.chart_triangles[i] * 3u + corner]];
+                    const float2_t projected{dot(position, projection.tangent), dot(position, projection.bitangent)};
+
+                    min = float2_t{std::min(min.x, projected.x), std::min(min.y, projected.y)};
+                    max = float2_t{std::max(max.x, projected.x), std::max(max.y, projected.y)};
+                }
+            }
+
+            projection.min = min;
+            projection.tangent = projection.tangent * settings.texels_per_unit;
+            projection.bitangent = projection.bitangent * settings.texels_per_unit;
+
+            // Corners map to texel centers and the edges in between, so the chart has one more texel than its extent.
+            chart.width = static_cast<u32>(std::ceil((max.x - min.x) * settings.texels_per_unit)) + 1u;
+            chart.height = static_cast<u32>(std::ceil((max.y - min.y) * settings.texels_per_unit)) + 1u;
+
+            if (chart.width + 2u * settings.chart_padding > settings.atlas_width)
+            {
+                throw std::runtime_error(std::format("Lightmap chart of mesh {} is {} texels wide, which does not fit "
+                                                     "in an atlas {} texels wide",
+                                                     mesh_index, chart.width, settings.atlas_width));
+            }
+
+            atlas.charts.push_back(chart);
+            projections.push_back(projection);
+        }
+    }
+
+    // Shelf packing, tallest charts first. Every chart has padding texels on its left and top, and the last chart of
+    // a shelf (and the last shelf) on its right (and bottom).
+    std::vector<u32> order(atlas.charts.size());
+    for (u32 i = 0u; i < static_cast<u32>(order.size()); i++)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&](const u32 a, const u32 b) { return atlas.charts[a].height > atlas.charts[b].height; });
+
+    const u32 padding = settings.chart_padding;
+    u32 shelf_x = 0u;
+    u32 shelf_y = 0u;
+    u32 shelf_height = 0u;
+
+    for (const u32 chart_index : order)
+    {
+        lightmap_chart_t &chart = atlas.charts[chart_index];
+        if (shelf_x + chart.width + 2u * padding > settings.atlas_width)
+        {
+            shelf_x = 0u;
+            shelf_y += shelf_height;
+            shelf_height = 0u;
+        }
+
+        chart.x = shelf_x + padding;
+        chart.y = shelf_y + padding;
+
+        shelf_x += chart.width + padding;
+        shelf_height = std::max(shelf_height, chart.height + padding);
+    }
+
+    atlas.height = atlas.charts.empty() ? 0u : shelf_y + shelf_height + padding;
+    if (atlas.height > settings.max_atlas_height)
+    {
+        throw std::runtime_error(std::format("Lightmap charts need an atlas of {}x{} texels, past the maximum height "
+                                             "of {} (lower the texels per unit, or widen the atlas)",
+                                             atlas.width, atlas.height, settings.max_atlas_height));
+    }
+
+    // UV2 of the corners, at the texel space position of their projection.
+    const f32 inverse_width = atlas.width > 0u ? 1.0f / static_cast<f32>(atlas.width) : 0.0f;
+    const f32 inverse_height = atlas.height > 0u ? 1.0f / static_cast<f32>(atlas.height) : 0.0f;
+
+    for (u32 chart_index = 0u; chart_index < static_cast<u32>(atlas.charts.size()); chart_index++)
+    {
+        const lightmap_chart_t &chart = atlas.charts[chart_index];
+        const chart_projection_t &projection = projections[chart_index];
+        const lightmap_mesh_t &mesh = meshes[chart.mesh_index];
+
+        const float2_t offset{
+            static_cast<f32>(chart.x) + 0.5f - projection.min.x * settings.texels_per_unit,
+            static_cast<f32>(chart.y) + 0.5f - projection.min.y * settings.texels_per_unit,
+        };
+
+        for (u32 i = chart.first_triangle; i < chart.first_triangle + chart.num_triangles; i++)
+        {
+            for (u32 corner = 0u; corner < 3u; corner++)
+            {
+                const u32 index = atlas.chart_triangles[i] * 3u + corner;
+                const float3_t position = to_float3(transform_point(mesh.positions[mesh.indices[index]],
+                                                                    mesh.model_matrix));
+
+                atlas.mesh_uvs[chart.mesh_index][index] = float2_t{
+                    (dot(position, projection.tangent) + offset.x) * inverse_width,
+                    (dot(position, projection.bitangent) + offset.y) * inverse_height,
+                };
+            }
+        }
+    }
+
+    return atlas;
+}
+
+void write_lightmap(const std::filesystem::path &path, const lightmap_t &lightmap)
+{
+    if (lightmap.texels.size() != static_cast<size_t>(lightmap.width) * lightmap.height)
+    {
+        throw std::runtime_error(std::format("Lightmap of {}x{} texels has {} texels", lightmap.width,
+                                             lightmap.height, lightmap.texels.size()));
+    }
+
+    dds_image_t image{
+        .format = dds_format_t::r16g16b16a16_float,
+        .width = lightmap.width,
+        .height = lightmap.height,
+        .data = std::vector<u8>(lightmap.texels.size() * 4u * sizeof(u16)),
+    };
+
+    u16 *const data = reinterpret_cast<u16 *>(image.data.data());
+    for (size_t i = 0u; i < lightmap.texels.size(); i++)
+    {
+        const float4_t &texel = lightmap.texels[i];
+        data[i * 4u + 0u] = f32_to_f16(texel.x);
+        data[i * 4u + 1u] = f32_to_f16(texel.y);
+        data[i * 4u + 2u] = f32_to_f16(texel.z);
+        data[i * 4u + 3u] = f32_to_f16(texel.w);
+    }
+
+    write_dds(path, image);
+}
+
+lightmap_t read_lightmap(const std::filesystem::path &path)
+{
+    const dds_image_t image = read_dds(path);
+    if (image.format != dds_format_t::r16g16b16a16_float || image.is_cubemap || image.num_mips != 1u)
+    {
+        throw std::runtime_error(std::format("Lightmap {} is not a R16G16B16A16_FLOAT DDS file", path.string()));
+    }
+
+    lightmap_t lightmap{
+        .width = image.width,
+        .height = image.height,
+        .texels = std::vector<float4_t>(static_cast<size_t>(image.width) * image.height),
+    };
+
+    const u16 *const data = reinterpret_cast<const u16 *>(image.data.data());
+    for (size_t i = 0u; i < lightmap.texels.size(); i++)
+    {
+        lightmap.texels[i] = float4_t{f16_to_f32(data[i * 4u + 0u]), f16_to_f32(data[i * 4u + 1u]),
+                                      f16_to_f32(data[i * 4u + 2u]), f16_to_f32(data[i * 4u + 3u])};
+    }
+
+    return lightmap;
+}
+
+// PCG32 (O'Neill, https://www.pcg-random.org), seeded per texel and pass so that bakes are deterministic whatever
+// the thread that traces each tile.
+struct lightmap_baker_t::random_t
+{
+    static constexpr u64 MULTIPLIER = 6364136223846793005ull;
+    static constexpr u64 INCREMENT = 1442695040888963407ull;
+
+    explicit random_t(const u64 seed) : state(seed + INCREMENT)
+    {
+        next_u32();
+    }
+
+    u32 next_u32()
+    {
+        const u64 previous_state = state;
+        state = previous_state * MULTIPLIER + INCREMENT;
+
+        const u32 xor_shifted = static_cast<u32>(((previous_state >> 18u) ^ previous_state) >> 27u);
+        const u32 rotation = static_cast<u32>(previous_state >> 59u);
+        return std::rotr(xor_shifted, static_cast<int>(rotation));
+    }
+
+    // In [0, 1).
+    f32 next_f32()
+    {
+        return static_cast<f32>(next_u32() >> 8u) * (1.0f / 16777216.0f);
+    }
+
+    // Cosine weighted direction of the hemisphere around the normal.
+    float3_t next_cosine_direction(const float3_t &normal)
+    {
+        const f32 radius = std::sqrt(next_f32());
+        const f32 angle = 2.0f * PI * next_f32();
+
+        float3_t tangent{};
+        float3_t bitangent{};
+        get_basis(normal, tangent, bitangent);
+
+        const f32 x = radius * std::cos(angle);
+        const f32 y = radius * std::sin(angle);
+        const f32 z = std::sqrt(std::max(1.0f - x * x - y * y, 0.0f));
+        return tangent * x + bitangent * y + normal * z;
+    }
+
+    u64 state{};
+};
+
+lightmap_baker_t::lightmap_baker_t(const std::span<const lightmap_mesh_t> meshes, const std::span<const light_t> lights,
+                                   const lightmap_bake_settings_t &settings, job_system_t *const job_system)
+    : settings(settings), meshes(meshes.begin(), meshes.end()), lights(lights.begin(), lights.end())
+{
+    if (settings.tile_size == 0u || settings.samples_per_pass == 0u || settings.max_samples == 0u)
+    {
+        throw std::runtime_error(std::format("Invalid lightmap bake settings (tile size {}, {} samples per pass, {} "
+                                             "max samples)",
+                                             settings.tile_size, settings.samples_per_pass, settings.max_samples));
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    atlas = unwrap_lightmap(meshes, settings);
+
+    // The triangles of the scene, without the degenerate ones (which rays can not hit).
+    std::vector<std::vector<float3_t>> world_positions(meshes.size());
+    std::vector<aabb_t> triangle_bounds{};
+
+    for (u32 mesh_index = 0u; mesh_index < static_cast<u32>(meshes.size()); mesh_index++)
+    {
+        const lightmap_mesh_t &mesh = meshes[mesh_index];
+        world_positions[mesh_index] = get_world_positions(mesh);
+        const std::vector<float3_t> &positions = world_positions[mesh_index];
+
+        for (u32 triangle = 0u; triangle < static_cast<u32>(mesh.indices.size() / 3u); triangle++)
+        {
+            const float3_t normal = get_triangle_normal(positions, mesh.indices, triangle);
+            if (dot(normal, normal) == 0.0f)
+            {
+                continue;
+            }
+
+            const float3_t &a = positions[mesh.indices[triangle * 3u + 0u]];
+            const float3_t &b = positions[mesh.indices[triangle * 3u + 1u]];
+            const float3_t &c = positions[mesh.indices[triangle * 3u + 2u]];
+
+            triangles.push_back(triangle_t{
+                .a = a,
+                .edge_1 = b - a,
+                .edge_2 = c - a,
+                .normal = normal,
+                .mesh_index = mesh_index,
+            });
+            triangle_bounds.push_back(aabb_t{.min = min(min(a, b), c), .max = max(max(a, b), c)});
+        }
+    }
+
+    bvh.build(triangle_bounds, job_system);
+
+    // Rasterize the charts' triangles at the texel centers, chart by chart (charts do not overlap, so the charts can
+    // mark the texels they cover in parallel).
+    atlas_texel_indices.assign(static_cast<size_t>(atlas.width) * atlas.height, INVALID_TEXEL);
+
+    const u32 num_charts = static_cast<u32>(atlas.charts.size());
+    std::vector<std::vector<texel_t>> chart_texels(num_charts);
+
+    const auto rasterize = [&](const u32 begin, const u32 end, const u32) {
+        for (u32 chart_index = begin; chart_index < end; chart_index++)
+        {
+            const lightmap_chart_t &chart = atlas.charts[chart_index];
+            const lightmap_mesh_t &mesh = meshes[chart.mesh_index];
+            const std::vector<float3_t> &positions = world_positions[chart.mesh_index];
+            const std::vector<float2_t> &uvs = atlas.mesh_uvs[chart.mesh_index];
+
+            for (u32 i = chart.first_triangle; i < chart.first_triangle + chart.num_triangles; i++)
+            {
+                const u32 first_index = atlas.chart_triangles[i] * 3u;
+
+                std::array<float2_t, 3> corners{};
+                for (u32 corner = 0u; corner < 3u; corner++)
+                {
+                    const float2_t &uv = uvs[first_index + corner];
+                    corners[corner] = float2_t{uv.x * static_cast<f32>(atlas.width),
+                                               uv.y * static_cast<f32>(atlas.height)};
+                }
+
+                const f32 area = cross_2d(float2_t{corners[1].x - corners[0].x, corners[1].y - corners[0].y},
+                                          float2_t{corners[2].x - corners[0].x, corners[2].y - corners[0].y});
+                if (std::abs(area) < 1e-12f)
+                {
+                    continue;
+                }
+
+                // Texels whose center may be in the triangle, clamped to the chart.
+                const f32 min_corner_x = std::min({corners[0].x, corners[1].x, corners[2].x});
+                const f32 min_corner_y = std::min({corners[0].y, corners[1].y, corners[2].y});
+                const f32 max_corner_x = std::max({corners[0].x, corners[1].x, corners[2].x});
+                const f32 max_corner_y = std::max({corners[0].y, corners[1].y, corners[2].y});
+
+                const u32 min_x = std::max(static_cast<u32>(std::max(min_corner_x - 0.5f, 0.0f)), chart.x);
+                const u32 min_y = std::max(static_cast<u32>(std::max(min_corner_y - 0.5f, 0.0f)), chart.y);
+                const u32 max_x = std::min(static_cast<u32>(max_corner_x), chart.x + chart.width - 1u);
+                const u32 max_y = std::min(static_cast<u32>(max_corner_y), chart.y + chart.height - 1u);
+
+                const float3_t normal = get_triangle_normal(positions, mesh.indices, atlas.chart_triangles[i]);
+
+                for (u32 y = min_y; y <= max_y; y++)
+                {
+                    for (u32 x = min_x; x <= max_x; x++)
+                    {
+                        const u32 atlas_index = y * atlas.width + x;
+                        if (atlas_texel_indices[atlas_index] != INVALID_TEXEL)
+                        {
+                            continue;
+                        }
+
+                        // Barycentrics of the texel center, which covers the triangle with a small tolerance so that
+                        // the texels on the edges shared by two triangles are not missed.
+                        const float2_t center{static_cast<f32>(x) + 0.5f, static_cast<f32>(y) + 0.5f};
+                        std::array<f32, 3> weights{};
+                        for (u32 corner = 0u; corner < 3u; corner++)
+                        {
+                            const float2_t &b = corners[(corner + 1u) % 3u];
+                            const float2_t &c = corners[(corner + 2u) % 3u];
+                            weights[corner] =
+                                cross_2d(float2_t{c.x - b.x, c.y - b.y}, float2_t{center.x - b.x, center.y - b.y}) /
+                                area;
+                        }
+
+                        if (weights[0] < -1e-4f || weights[1] < -1e-4f || weights[2] < -1e-4f)
+                        {
+                            continue;
+                        }
+
+                        atlas_texel_indices[atlas_index] = 0u;
+                        chart_texels[chart_index].push_back(texel_t{
+                            .position = positions[mesh.indices[first_index + 0u]] * weights[0] +
+                                        positions[mesh.indices[first_index + 1u]] * weights[1] +
+                                        positions[mesh.indices[first_index + 2u]] * weights[2],
+                            .normal = normal,
+                            .atlas_index = atlas_index,
+                            .chart_index = chart_index,
+                        });
+                    }
+                }
+            }
+        }
+    };
+
+    if (job_system)
+    {
+        job_system->parallel_for(num_charts, 16u, rasterize);
+    }
+    else
+    {
+        rasterize(0u, num_charts, 0u);
+    }
+
+    // Counting sort of the texels by tile.
+    const u32 num_tiles_x = (atlas.width + settings.tile_size - 1u) / settings.tile_size;
+    const u32 num_tiles_y = (atlas.height + settings.tile_size - 1u) / settings.tile_size;
+    const auto get_tile = [&](const texel_t &texel) {
+        return (texel.atlas_index / atlas.width / settings.tile_size) * num_tiles_x +
+               texel.atlas_index % atlas.width / settings.tile_size;
+    };
+
+    tile_offsets.assign(num_tiles_x * num_tiles_y + 1u, 0u);
+    for (const std::vector<texel_t> &texels_of_chart : chart_texels)
+    {
+        for (const texel_t &texel : texels_of_chart)
+        {
+            tile_offsets[get_tile(texel) + 1u]++;
+        }
+    }
+
+    for (u32 tile = 1u; tile < static_cast<u32>(tile_offsets.size()); tile++)
+    {
+        tile_offsets[tile] += tile_offsets[tile - 1u];
+    }
+
+    texels.resize(tile_offsets.back());
+    std::vector<u32> tile_cursors(tile_offsets.begin(), tile_offsets.end() - 1);
+    for (const std::vector<texel_t> &texels_of_chart : chart_texels)
+    {
+        for (const texel_t &texel : texels_of_chart)
+        {
+            const u32 texel_index = tile_cursors[get_tile(texel)]++;
+            texels[texel_index] = texel;
+            atlas_texel_indices[texel.atlas_index] = texel_index;
+        }
+    }
+
+    irradiance_sums.assign(texels.size(), float3_t{});
+    squared_luminance_sums.assign(texels.size(), 0.0f);
+    ambient_occlusion_sums.assign(texels.size(), 0.0f);
+
+    statistics = lightmap_bake_statistics_t{
+        .num_triangles = static_cast<u32>(triangles.size()),
+        .num_charts = num_charts,
+        .num_texels = static_cast<u32>(texels.size()),
+        .setup_time_in_ms =
+            std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count(),
+    };
+}
+
+bool lightmap_baker_t::render_pass(job_system_t *const job_system)
+{
+    if (is_converged())
+    {
+        return true;
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const u32 first_sample = statistics.num_samples;
+    std::atomic<u64> num_rays{0u};
+
+    const auto render_tiles = [&](const u32 begin, const u32 end, const u32) {
+        u64 num_tile_rays = 0u;
+
+        for (u32 tile = begin; tile < end; tile++)
+        {
+            for (u32 texel_index = tile_offsets[tile]; texel_index < tile_offsets[tile + 1u]; texel_index++)
+            {
+                random_t random(hash((static_cast<u64>(settings.seed) << 32u) ^ hash(texel_index) ^ first_sample));
+
+                float3_t irradiance_sum{};
+                f32 squared_luminance_sum = 0.0f;
+                f32 ambient_occlusion_sum = 0.0f;
+
+                for (u32 sample = 0u; sample < settings.samples_per_pass; sample++)
+                {
+                    const path_sample_t path_sample = trace_path(texels[texel_index], random);
+
+                    const f32 luminance = get_luminance(path_sample.irradiance);
+                    irradiance_sum = irradiance_sum + path_sample.irradiance;
+                    squared_luminance_sum += luminance * luminance;
+                    ambient_occlusion_sum += path_sample.ambient_occlusion;
+                    num_tile_rays += path_sample.num_rays;
+                }
+
+                irradiance_sums[texel_index] = irradiance_sums[texel_index] + irradiance_sum;
+                squared_luminance_sums[texel_index] += squared_luminance_sum;
+                ambient_occlusion_sums[texel_index] += ambient_occlusion_sum;
+            }
+        }
+
+        num_rays.fetch_add(num_tile_rays, std::memory_order_relaxed);
+    };
+
+    const u32 num_tiles = static_cast<u32>(tile_offsets.size()) - 1u;
+    if (job_system)
+    {
+        job_system->parallel_for(num_tiles, 1u, render_tiles);
+    }
+    else
+    {
+        render_tiles(0u, num_tiles, 0u);
+    }
+
+    statistics.num_samples += settings.samples_per_pass;
+    statistics.num_rays += num_rays.load(std::memory_order_relaxed);
+
+    // Relative standard error of the mean luminance of every texel.
+    const f32 num_samples = static_cast<f32>(statistics.num_samples);
+    f64 relative_error_sum = 0.0;
+    for (u32 texel_index = 0u; texel_index < static_cast<u32>(texels.size()); texel_index++)
+    {
+        const f32 mean = get_luminance(irradiance_sums[texel_index]) / num_samples;
+        const f32 variance = std::max(squared_luminance_sums[texel_index] / num_samples - mean * mean, 0.0f);
+        if (mean > 1e-6f)
+        {
+            relative_error_sum += std::sqrt(variance / num_samples) / mean;
+        }
+    }
+
+    statistics.relative_error =
+        texels.empty() ? 0.0f : static_cast<f32>(relative_error_sum / static_cast<f64>(texels.size()));
+
+    const auto end_time = std::chrono::steady_clock::now();
+    statistics.pass_time_in_ms = std::chrono::duration<f32, std::milli>(end_time - start_time).count();
+    statistics.rays_per_second = static_cast<f32>(static_cast<f64>(num_rays.load(std::memory_order_relaxed)) /
+                                                  std::max(std::chrono::duration<f64>(end_time - start_time).count(),
+                                                           1e-9));
+
+    return is_converged();
+}
+
+bool lightmap_baker_t::is_converged() const
+{
+    return statistics.num_samples >= settings.max_samples ||
+           (statistics.num_samples > 0u && statistics.relative_error <= settings.target_relative_error);
+}
+
+lightmap_t lightmap_baker_t::resolve(job_system_t *const job_system)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const u32 width = atlas.width;
+    const u32 height = atlas.height;
+    const f32 num_samples = static_cast<f32>(std::max(statistics.num_samples, 1u));
+
+    // The estimate of every texel, and the standard error of its luminance.
+    std::vector<float4_t> means(texels.size());
+    std::vector<f32> standard_errors(texels.size());
+    for (u32 texel_index = 0u; texel_index < static_cast<u32>(texels.size()); texel_index++)
+    {
+        const float3_t irradiance = irradiance_sums[texel_index] * (1.0f / num_samples);
+        const f32 luminance = get_luminance(irradiance);
+
+        means[texel_index] = float4_t{irradiance.x, irradiance.y, irradiance.z,
+                                      ambient_occlusion_sums[texel_index] / num_samples};
+        standard_errors[texel_index] = std::sqrt(
+            std::max(squared_luminance_sums[texel_index] / num_samples - luminance * luminance, 0.0f) / num_samples);
+    }
+
+    lightmap_t lightmap{
+        .width = width,
+        .height = height,
+        .texels = std::vector<float4_t>(static_cast<size_t>(width) * height),
+    };
+
+    const auto run_rows = [&](const std::function<void(u32, u32, u32)> &function) {
+        if (job_system)
+        {
+            job_system->parallel_for(height, 8u, function);
+        }
+        else
+        {
+            function(0u, height, 0u);
+        }
+    };
+
+    // Denoise : a gaussian over the texels of the same chart, where texels whose luminance differs by more than the
+    // noise of the two texels get less weight, so that shadow edges are not blurred.
+    const i32 radius = static_cast<i32>(settings.denoise_radius);
+    const f32 spatial_sigma = std::max(static_cast<f32>(radius) * 0.5f, 0.5f);
+
+    run_rows([&](const u32 begin, const u32 end, const u32) {
+        for (u32 y = begin; y < end; y++)
+        {
+            for (u32 x = 0u; x < width; x++)
+            {
+                const u32 texel_index = atlas_texel_indices[y * width + x];
+                if (texel_index == INVALID_TEXEL)
+                {
+                    continue;
+                }
+
+                const u32 chart_index = texels[texel_index].chart_index;
+                const f32 luminance = get_luminance(float3_t{means[texel_index].x, means[texel_index].y,
+                                                             means[texel_index].z});
+
+                float4_t sum{};
+                f32 weight_sum = 0.0f;
+
+                for (i32 dy = -radius; dy <= radius; dy++)
+                {
+                    for (i32 dx = -radius; dx <= radius; dx++)
+                    {
+                        const i32 neighbour_x = static_cast<i32>(x) + dx;
+                        const i32 neighbour_y = static_cast<i32>(y) + dy;
+                        if (neighbour_x < 0 || neighbour_y < 0 || neighbour_x >= static_cast<i32>(width) ||
+                            neighbour_y >= static_cast<i32>(height))
+                        {
+                            continue;
+                        }
+
+                        const u32 neighbour_index = atlas_texel_indices[neighbour_y * width + neighbour_x];
+                        if (neighbour_index == INVALID_TEXEL || texels[neighbour_index].chart_index != chart_index)
+                        {
+                            continue;
+                        }
+
+                        const float4_t &neighbour = means[neighbour_index];
+                        const f32 luminance_difference =
+                            get_luminance(float3_t{neighbour.x, neighbour.y, neighbour.z}) - luminance;
+                        const f32 range_sigma =
+                            std::max(2.0f * (standard_errors[texel_index] + standard_errors[neighbour_index]), 1e-6f);
+
+                        const f32 weight = std::exp(
+                            -static_cast<f32>(dx * dx + dy * dy) / (2.0f * spatial_sigma * spatial_sigma) -
+                            luminance_difference * luminance_difference / (2.0f * range_sigma * range_sigma));
+
+                        sum = float4_t{sum.x + neighbour.x * weight, sum.y + neighbour.y * weight,
+                                       sum.z + neighbour.z * weight, sum.w + neighbour.w * weight};
+                        weight_sum += weight;
+                    }
+                }
+
+                // The texel itself has a weight of 1, so weight_sum is never 0.
+                lightmap.texels[y * width + x] = float4_t{sum.x / weight_sum, sum.y / weight_sum, sum.z / weight_sum,
+                                                          sum.w / weight_sum};
+            }
+        }
+    });
+
+    // Dilate : every empty texel next to filled texels gets their average, one ring of texels per iteration.
+    std::vector<u8> is_filled(lightmap.texels.size());
+    for (size_t i = 0u; i < is_filled.size(); i++)
+    {
+        is_filled[i] = atlas_texel_indices[i] != INVALID_TEXEL;
+    }
+
+    std::vector<float4_t> dilated_texels{};
+    std::vector<u8> is_dilated_filled{};
+
+    for (u32 iteration = 0u; iteration < settings.num_dilation_iterations; iteration++)
+    {
+        dilated_texels = lightmap.texels;
+        is_dilated_filled = is_filled;
+
+        run_rows([&](const u32 begin, const u32 end, const u32) {
+            for (u32 y = begin; y < end; y++)
+            {
+                for (u32 x = 0u; x < width; x++)
+                {
+                    if (is_filled[y * width + x])
+                    {
+                        continue;
+                    }
+
+                    float4_t sum{};
+                    u32 num_neighbours = 0u;
+
+                    for (u32 neighbour_y = y > 0u ? y - 1u : 0u; neighbour_y <= std::min(y + 1u, height - 1u);
+                         neighbour_y++)
+                    {
+                        for (u32 neighbour_x = x > 0u ? x - 1u : 0u; neighbour_x <= std::min(x + 1u, width - 1u);
+                             neighbour_x++)
+                        {
+                            const u32 neighbour_index = neighbour_y * width + neighbour_x;
+                            if (!is_filled[neighbour_index])
+                            {
+                                continue;
+                            }
+
+                            const float4_t &neighbour = lightmap.texels[neighbour_index];
+                            sum = float4_t{sum.x + neighbour.x, sum.y + neighbour.y, sum.z + neighbour.z,
+                                           sum.w + neighbour.w};
+                            num_neighbours++;
+                        }
+                    }
+
+                    if (num_neighbours > 0u)
+                    {
+                        const f32 scale = 1.0f / static_cast<f32>(num_neighbours);
+                        dilated_texels[y * width + x] = float4_t{sum.x * scale, sum.y * scale, sum.z * scale,
+                                                                 sum.w * scale};
+                        is_dilated_filled[y * width + x] = 1u;
+                    }
+                }
+            }
+        });
+
+        std::swap(lightmap.texels, dilated_texels);
+        std::swap(is_filled, is_dilated_filled);
+    }
+
+    statistics.resolve_time_in_ms =
+        std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+    return lightmap;
+}
+
+lightmap_baker_t::path_sample_t lightmap_baker_t::trace_path(const texel_t &texel, random_t &random) const
+{
+    path_sample_t sample{};
+    sample.irradiance = get_direct_irradiance(texel.position, texel.normal, sample.num_rays);
+
+    // The irradiance of a cosine weighted direction is pi * the radiance along it. weight is the factor of the radiance
+    // of the current ray in the texel's irradiance, which every bounce scales by its albedo.
+    float3_t weight{PI, PI, PI};
+
+    ray_t ray{
+        .origin = texel.position + texel.normal * settings.ray_offset,
+        .direction = random.next_cosine_direction(texel.normal),
+    };
+
+    for (u32 bounce = 0u;; bounce++)
+    {
+        const ray_hit_t hit = intersect(ray);
+        sample.num_rays++;
+
+        if (bounce == 0u)
+        {
+            sample.ambient_occlusion = hit.t > settings.ambient_occlusion_distance ? 1.0f : 0.0f;
+        }
+
+        if (hit.primitive_index == ray_hit_t::INVALID_PRIMITIVE)
+        {
+            sample.irradiance = sample.irradiance + multiply(weight, settings.sky_radiance);
+            break;
+        }
+
+        if (bounce == settings.max_bounces)
+        {
+            break;
+        }
+
+        // The surface reflects albedo / pi of its irradiance, lit from the side the ray came from.
+        const triangle_t &triangle = triangles[hit.primitive_index];
+        const float3_t normal = dot(triangle.normal, ray.direction) > 0.0f ? triangle.normal * -1.0f : triangle.normal;
+        const float3_t position = ray.origin + ray.direction * hit.t;
+
+        weight = multiply(weight, meshes[triangle.mesh_index].albedo);
+        sample.irradiance = sample.irradiance + multiply(weight * (1.0f / PI),
+                                                         get_direct_irradiance(position, normal, sample.num_rays));
+
+        ray = ray_t{
+            .origin = position + normal * settings.ray_offset,
+            .direction = random.next_cosine_direction(normal),
+        };
+    }
+
+    return sample;
+}
+
+float3_t lightmap_baker_t::get_direct_irradiance(const float3_t &position, const float3_t &normal,
+                                                 u32 &num_rays) const
+{
+    // Same attenuation as the shaders (see clustered_lighting.hlsli).
+    float3_t irradiance{};
+
+    for (const light_t &light : lights)
+    {
+        const float3_t to_light = light.position - position;
+        const f32 squared_distance = dot(to_light, to_light);
+        if (squared_distance >= light.range * light.range)
+        {
+            continue;
+        }
+
+        const f32 distance = std::sqrt(squared_distance);
+        const float3_t light_direction = to_light * (1.0f / std::max(distance, 1e-6f));
+        const f32 n_dot_l = dot(normal, light_direction);
+        if (n_dot_l <= 0.0f)
+        {
+            continue;
+        }
+
+        const f32 window = std::clamp(1.0f - squared_distance / (light.range * light.range), 0.0f, 1.0f);
+        f32 attenuation = window * window / std::max(squared_distance, 0.01f);
+
+        if (light.type == light_type_t::spot)
+        {
+            attenuation *= smoothstep(light.spot_cos_outer_angle, light.spot_cos_inner_angle,
+                                      dot(light_direction * -1.0f, light.direction));
+        }
+
+        if (attenuation <= 0.0f)
+        {
+            continue;
+        }
+
+        // Any hit before the light occludes it.
+        const ray_t shadow_ray{
+            .origin = position + normal * settings.ray_offset,
+            .direction = light_direction,
+            .t_max = distance - settings.ray_offset,
+        };
+
+        num_rays++;
+        if (intersect(shadow_ray).primitive_index == ray_hit_t::INVALID_PRIMITIVE)
+        {
+            irradiance = irradiance + light.color * (attenuation * n_dot_l);
+        }
+    }
+
+    return irradiance;
+}
+
+ray_hit_t lightmap_baker_t::intersect(const ray_t &ray) const
+{
+    // Möller-Trumbore, two sided.
+    return bvh.intersect_ray(ray, [&](const u32 primitive_index, const ray_t &current_ray) {
+        const triangle_t &triangle = triangles[primitive_index];
+
+        const float3_t p = cross(current_ray.direction, triangle.edge_2);
+        const f32 determinant = dot(triangle.edge_1, p);
+        if (std::abs(determinant) < 1e-12f)
+        {
+            return INFINITY;
+        }
+
+        const f32 inverse_determinant = 1.0f / determinant;
+        const float3_t s = current_ray.origin - triangle.a;
+        const f32 u = dot(s, p) * inverse_determinant;
+        if (u < 0.0f || u > 1.0f)
+        {
+            return INFINITY;
+        }
+
+        const float3_t q = cross(s, triangle.edge_1);
+        const f32 v = dot(current_ray.direction, q) * inverse_determinant;
+        if (v < 0.0f || u + v > 1.0f)
+        {
+            return INFINITY;
+        }
+
+        const f32 t = dot(triangle.edge_2, q) * inverse_determinant;
+        return t > current_ray.t_min ? t : INFINITY;
+    });
+}
+} // namespace nether
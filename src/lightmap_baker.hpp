@@ -0,0 +1,229 @@
+#pragma once
+
+#include "bvh.hpp"
+#include "clustered_lighting.hpp"
+#include "common.hpp"
+#include "job_system.hpp"
+#include "math.hpp"
+
+// Offline baking of static lighting (irradiance and ambient occlusion) into a lightmap atlas.
+//  - Unwrap : the triangles of every mesh are grouped into planar charts (connected triangles with the same normal),
+//    which are projected onto their plane at a fixed texel density and packed into the atlas with a shelf packer. This
+//    gives every triangle corner a second UV set (UV2). The unwrap only depends on the meshes and the settings, so the
+//    engine can recompute the UVs of a baked lightmap with unwrap_lightmap.
+//  - Every atlas texel whose center is covered by a chart triangle is a sample point. The texels are sorted by tile,
+//    and each pass traces samples_per_pass more paths per texel, tile by tile in parallel on the job system. The paths
+//    are traced against a bvh_t of the scene triangles, with next event estimation of the lights and a constant sky.
+//  - Passes are progressive : the estimate of every texel is the mean of all its samples so far, and the mean relative
+//    standard error of the irradiance over all texels measures convergence.
+//  - resolve denoises the estimate with a filter that only averages texels of the same chart whose irradiance is
+//    within their standard errors of each other (so that shadow edges are kept), and dilates the charts into their
+//    padding, so that bilinear filtering at chart borders does not read the empty texels between charts.
+// Irradiance is in the units of the shaders' lighting (light color * attenuation * n.l, see clustered_lighting.hlsli),
+// so a lightmap texel is shaded as albedo * irradiance like the dynamic lights. Surfaces reflect albedo / pi of their
+// irradiance for the bounces.
+namespace nether
+{
+// Triangles are front facing when clockwise (as in the engine), so their normal is cross(b - a, c - a).
+struct lightmap_mesh_t
+{
+    std::span<const float3_t> positions{};
+    std::span<const u32> indices{};
+
+    float4x4_t model_matrix{identity_matrix()};
+
+    float3_t albedo{0.8f, 0.8f, 0.8f};
+};
+
+struct lightmap_bake_settings_t
+{
+    // Resolution of the charts, in texels per world unit.
+    f32 texels_per_unit{4.0f};
+
+    // The atlas is atlas_width texels wide, and as high as the packed charts (throws past max_atlas_height).
+    u32 atlas_width{1024u};
+    u32 max_atlas_height{4096u};
+
+    // Empty texels around every chart, which dilation fills.
+    u32 chart_padding{2u};
+
+    // Square tiles of texels that the passes are split into.
+    u32 tile_size{32u};
+
+    u32 samples_per_pass{16u};
+    u32 max_samples{1024u};
+
+    // The bake has converged when the mean relative standard error of the texels' irradiance is below this.
+    f32 target_relative_error{0.01f};
+
+    // Bounces of indirect light (0 for direct lighting and sky only).
+    u32 max_bounces{2u};
+
+    // Occluders further than this from a texel do not occlude it.
+    f32 ambient_occlusion_distance{2.0f};
+
+    // Radiance of the sky, seen by the rays that leave the scene.
+    float3_t sky_radiance{0.3f, 0.35f, 0.4f};
+
+    // Rays start this far from the surface along its normal, so that they do not hit the surface they start from.
+    f32 ray_offset{1e-3f};
+
+    // Radius of the filter of resolve, in texels (0 disables denoising).
+    u32 denoise_radius{2u};
+    u32 num_dilation_iterations{4u};
+
+    u32 seed{};
+};
+
+// A chart's texels are [x, x + width) x [y, y + height) of the atlas (without the padding).
+struct lightmap_chart_t
+{
+    u32 mesh_index{};
+
+    // Into lightmap_atlas_t::chart_triangles.
+    u32 first_triangle{};
+    u32 num_triangles{};
+
+    u32 x{};
+    u32 y{};
+    u32 width{};
+    u32 height{};
+};
+
+struct lightmap_atlas_t
+{
+    u32 width{};
+    u32 height{};
+
+    std::vector<lightmap_chart_t> charts{};
+
+    // Triangle indices (in the index buffer of their mesh, divided by 3) of the charts, chart by chart.
+    std::vector<u32> chart_triangles{};
+
+    // The UV2 of every triangle corner of every mesh (one per index), in [0, 1].
+    std::vector<std::vector<float2_t>> mesh_uvs{};
+};
+
+// Throws if a chart is wider than the atlas, or if the charts do not fit in max_atlas_height.
+lightmap_atlas_t unwrap_lightmap(const std::span<const lightmap_mesh_t> meshes,
+                                 const lightmap_bake_settings_t &settings);
+
+// Row major texels : the irradiance in rgb, and the ambient occlusion in a (1 for unoccluded texels).
+struct lightmap_t
+{
+    u32 width{};
+    u32 height{};
+    std::vector<float4_t> texels{};
+};
+
+// DDS file of DXGI_FORMAT_R16G16B16A16_FLOAT, which the engine (or any DDS loader) can create a texture from.
+void write_lightmap(const std::filesystem::path &path, const lightmap_t &lightmap);
+
+// Throws if the file is not a DDS file written by write_lightmap.
+lightmap_t read_lightmap(const std::filesystem::path &path);
+
+struct lightmap_bake_statistics_t
+{
+    u32 num_triangles{};
+    u32 num_charts{};
+    u32 num_texels{};
+
+    // Samples per texel so far.
+    u32 num_samples{};
+    u64 num_rays{};
+
+    // Mean relative standard error of the irradiance of the texels (0 for texels in the dark).
+    f32 relative_error{};
+
+    f32 setup_time_in_ms{};
+    f32 pass_time_in_ms{};
+    f32 rays_per_second{};
+    f32 resolve_time_in_ms{};
+};
+
+class lightmap_baker_t
+{
+  public:
+    // Unwraps the meshes and builds the BVH of their triangles. Throws if the atlas does not fit (see
+    // unwrap_lightmap), or if the settings are invalid.
+    lightmap_baker_t(const std::span<const lightmap_mesh_t> meshes, const std::span<const light_t> lights,
+                     const lightmap_bake_settings_t &settings, job_system_t *const job_system = nullptr);
+
+    // Traces samples_per_pass more samples for every texel. Returns true once the bake has converged (or reached
+    // max_samples), after which passes do nothing.
+    bool render_pass(job_system_t *const job_system = nullptr);
+
+    bool is_converged() const;
+
+    // The filtered and dilated lightmap of the samples so far.
+    lightmap_t resolve(job_system_t *const job_system = nullptr);
+
+    const lightmap_atlas_t &get_atlas() const
+    {
+        return atlas;
+    }
+
+  public:
+    lightmap_bake_statistics_t statistics{};
+
+  private:
+    struct triangle_t
+    {
+        float3_t a{};
+        float3_t edge_1{};
+        float3_t edge_2{};
+        float3_t normal{};
+        u32 mesh_index{};
+    };
+
+    // A sample point. Texels are sorted by tile, so that every tile is a contiguous range of texels.
+    struct texel_t
+    {
+        float3_t position{};
+        float3_t normal{};
+        u32 atlas_index{};
+        u32 chart_index{};
+    };
+
+    // The irradiance and the ambient occlusion of one path.
+    struct path_sample_t
+    {
+        float3_t irradiance{};
+        f32 ambient_occlusion{};
+        u32 num_rays{};
+    };
+
+    struct random_t;
+
+    path_sample_t trace_path(const texel_t &texel, random_t &random) const;
+
+    // Irradiance at the point from the lights, with a shadow ray per light that reaches it.
+    float3_t get_direct_irradiance(const float3_t &position, const float3_t &normal, u32 &num_rays) const;
+
+    ray_hit_t intersect(const ray_t &ray) const;
+
+  private:
+    lightmap_bake_settings_t settings{};
+
+    std::vector<lightmap_mesh_t> meshes{};
+    std::vector<light_t> lights{};
+    lightmap_atlas_t atlas{};
+
+    std::vector<triangle_t> triangles{};
+    bvh_t bvh{};
+
+    std::vector<texel_t> texels{};
+
+    // The texels of tile i are [tile_offsets[i], tile_offsets[i + 1]).
+    std::vector<u32> tile_offsets{};
+
+    // Per texel sums over the samples : irradiance, squared luminance of the irradiance, and ambient occlusion.
+    std::vector<float3_t> irradiance_sums{};
+    std::vector<f32> squared_luminance_sums{};
+    std::vector<f32> ambient_occlusion_sums{};
+
+    // Per atlas texel : the index of its texel, or INVALID_TEXEL for the texels not covered by a chart.
+    static constexpr u32 INVALID_TEXEL = ~0u;
+    std::vector<u32> atlas_texel_indices{};
+};
+} // namespace nether
@@ -1,7 +1,26 @@
 #include "common.hpp"
 
+#include "allocation_tracker.hpp"
+#include "animation.hpp"
+#include "clustered_lighting.hpp"
+#include "command_stream.hpp"
+#include "command_translator.hpp"
+#include "debug_draw.hpp"
 #include "descriptor_heap.hpp"
-#include "shader_compiler.hpp"
+#include "frame_statistics.hpp"
+#include "gpu_scene.hpp"
+#include "instancing.hpp"
+#include "memory.hpp"
+#include "occlusion_culling.hpp"
+#include "particles.hpp"
+#include "residency_manager.hpp"
+#include "scene.hpp"
+#include "shader_archive.hpp"
+#include "shader_permutations.hpp"
+#include "static_geometry_uploader.hpp"
+#include "task_graph.hpp"
+#include "terrain.hpp"
+#include "vertex_compression.hpp"
 
 #include "imgui.h"
 
@@ -59,6 +78,7 @@ upload_buffer_creation_result_t create_upload_buffer(ID3D12Device *const device,
     throw_if_failed(device->CreateCommittedResource(&upload_heap_properties, D3D12_HEAP_FLAG_NONE,
                                                     &buffer_resource_desc, D3D12_RESOURCE_STATE_COMMON, nullptr,
                                                     IID_PPV_ARGS(&result.resource)));
+    nether::memory::register_gpu_resource(device, result.resource.Get());
 
     const D3D12_RANGE no_read_range = {
         .Begin = 0u,
@@ -132,6 +152,7 @@ constant_buffer_creation_result_t<T> create_constant_buffer(
     throw_if_failed(device->CreateCommittedResource(&upload_heap_properties, D3D12_HEAP_FLAG_NONE,
                                                     &buffer_resource_desc, D3D12_RESOURCE_STATE_COMMON, nullptr,
                                                     IID_PPV_ARGS(&result.resource)));
+    nether::memory::register_gpu_resource(device, result.resource.Get());
 
     const D3D12_RANGE no_read_range = {
         .Begin = 0u,
@@ -156,8 +177,238 @@ constant_buffer_creation_result_t<T> create_constant_buffer(
     return result;
 };
 
+struct default_buffer_creation_result_t
+{
+    ComPtr<ID3D12Resource> resource{};
+    u32 srv_index{};
+};
+
+// Create a device local (DEFAULT heap) structured buffer of num_elements elements, and a SRV. Its content is written
+// with copies from upload buffers.
+template <typename T>
+default_buffer_creation_result_t create_default_buffer(ID3D12Device *const device, const u32 num_elements,
+                                                       nether::descriptor_heap_t *const cbv_srv_uav_descriptor_heap)
+{
+    default_buffer_creation_result_t result{};
+
+    const D3D12_HEAP_PROPERTIES default_heap_properties = {
+        .Type = D3D12_HEAP_TYPE_DEFAULT,
+        .CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
+        .MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN,
+        .CreationNodeMask = 0u,
+        .VisibleNodeMask = 0u,
+    };
+
+    const D3D12_RESOURCE_DESC buffer_resource_desc = {
+        .Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
+        .Alignment = 0u,
+        .Width = static_cast<u64>(num_elements) * sizeof(T),
+        .Height = 1u,
+        .DepthOrArraySize = 1u,
+        .MipLevels = 1u,
+        .Format = DXGI_FORMAT_UNKNOWN,
+        .SampleDesc = {1u, 0u},
+        .Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR,
+        .Flags = D3D12_RESOURCE_FLAG_NONE,
+    };
+
+    throw_if_failed(device->CreateCommittedResource(&default_heap_properties, D3D12_HEAP_FLAG_NONE,
+                                                    &buffer_resource_desc, D3D12_RESOURCE_STATE_COMMON, nullptr,
+                                                    IID_PPV_ARGS(&result.resource)));
+    nether::memory::register_gpu_resource(device, result.resource.Get());
+
+    const D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {
+        .Format = DXGI_FORMAT_UNKNOWN,
+        .ViewDimension = D3D12_SRV_DIMENSION_BUFFER,
+        .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
+        .Buffer =
+            {
+                .FirstElement = 0u,
+                .NumElements = num_elements,
+                .StructureByteStride = sizeof(T),
+                .Flags = D3D12_BUFFER_SRV_FLAG_NONE,
+            },
+    };
+
+    nether::descriptor_handle_t descriptor_handle =
+        cbv_srv_uav_descriptor_heap->get_then_offset_current_descriptor_handle();
+    device->CreateShaderResourceView(result.resource.Get(), &srv_desc, descriptor_handle.cpu_handle);
+
+    result.srv_index = descriptor_handle.index;
+
+    return result;
+}
+
+// A square tentacle along y, skinned to a chain of TENTACLE_NUM_JOINTS joints spaced TENTACLE_JOINT_SPACING apart.
+// Every ring of vertices is weighted between the two joints it lies between.
+constexpr u32 TENTACLE_NUM_JOINTS = 8u;
+constexpr f32 TENTACLE_JOINT_SPACING = 0.5f;
+
+struct skinned_mesh_data_t
+{
+    std::vector<nether::float3_t> positions{};
+    std::vector<nether::float3_t> colors{};
+    std::vector<nether::joint_influence_t> joint_influences{};
+    std::vector<u16> indices{};
+};
+
+skinned_mesh_data_t create_tentacle_mesh()
+{
+    constexpr u32 NUM_RINGS_PER_JOINT = 4u;
+    constexpr u32 NUM_RINGS = (TENTACLE_NUM_JOINTS - 1u) * NUM_RINGS_PER_JOINT + 1u;
+
+    skinned_mesh_data_t mesh{};
+    for (u32 ring = 0u; ring < NUM_RINGS; ring++)
+    {
+        const f32 ring_position = static_cast<f32>(ring) / NUM_RINGS_PER_JOINT;
+        const u32 joint_index = std::min(ring / NUM_RINGS_PER_JOINT, TENTACLE_NUM_JOINTS - 2u);
+        const f32 joint_weight = 1.0f - (ring_position - static_cast<f32>(joint_index));
+
+        // Tapers towards the tip.
+        const f32 half_width = 0.2f * (1.0f - 0.7f * ring_position / (TENTACLE_NUM_JOINTS - 1u));
+        for (u32 i = 0u; i < 4u; i++)
+        {
+            const f32 angle = nether::to_radians(45.0f + 90.0f * i);
+            mesh.positions.push_back({std::cos(angle) * half_width, ring_position * TENTACLE_JOINT_SPACING,
+                                      std::sin(angle) * half_width});
+            mesh.colors.push_back({0.9f, 0.4f + 0.5f * ring_position / (TENTACLE_NUM_JOINTS - 1u), 0.3f});
+            mesh.joint_influences.push_back(nether::pack_joint_influence(
+                {joint_index, joint_index + 1u, 0u, 0u}, {joint_weight, 1.0f - joint_weight, 0.0f, 0.0f}));
+        }
+    }
+
+    // Sides (clockwise front faces), then the cap of the tip.
+    for (u32 ring = 0u; ring + 1u < NUM_RINGS; ring++)
+    {
+        for (u32 i = 0u; i < 4u; i++)
+        {
+            const u16 bottom = static_cast<u16>(ring * 4u + i);
+            const u16 bottom_next = static_cast<u16>(ring * 4u + (i + 1u) % 4u);
+            const u16 top = static_cast<u16>(bottom + 4u);
+            const u16 top_next = static_cast<u16>(bottom_next + 4u);
+
+            mesh.indices.insert(mesh.indices.end(), {bottom, top, top_next, bottom, top_next, bottom_next});
+        }
+    }
+
+    const u16 tip = static_cast<u16>((NUM_RINGS - 1u) * 4u);
+    mesh.indices.insert(mesh.indices.end(), {tip, static_cast<u16>(tip + 3u), static_cast<u16>(tip + 2u), tip,
+                                             static_cast<u16>(tip + 2u), static_cast<u16>(tip + 1u)});
+
+    return mesh;
+}
+
+nether::skeleton_t create_tentacle_skeleton()
+{
+    std::vector<u32> parent_indices(TENTACLE_NUM_JOINTS);
+    std::vector<nether::joint_transform_t> bind_pose(TENTACLE_NUM_JOINTS);
+    for (u32 i = 0u; i < TENTACLE_NUM_JOINTS; i++)
+    {
+        parent_indices[i] = i == 0u ? nether::skeleton_t::INVALID_JOINT_INDEX : i - 1u;
+        bind_pose[i].translation = {0.0f, i == 0u ? 0.0f : TENTACLE_JOINT_SPACING, 0.0f};
+    }
+
+    return nether::create_skeleton(parent_indices, bind_pose);
+}
+
+// A looping clip of the tentacle bending around axis, with a wave travelling up the chain.
+nether::raw_animation_clip_t create_tentacle_clip(const nether::float3_t &axis, const f32 period_in_s,
+                                                  const f32 amplitude)
+{
+    nether::raw_animation_clip_t clip = {
+        .sample_rate = 30.0f,
+        .num_frames = static_cast<u32>(period_in_s * 30.0f) + 1u,
+        .num_joints = TENTACLE_NUM_JOINTS,
+    };
+    clip.samples.resize(clip.num_frames * TENTACLE_NUM_JOINTS);
+
+    for (u32 frame = 0u; frame < clip.num_frames; frame++)
+    {
+        const f32 time = static_cast<f32>(frame) / clip.sample_rate;
+        for (u32 joint = 0u; joint < TENTACLE_NUM_JOINTS; joint++)
+        {
+            const f32 angle =
+                amplitude * std::sin(2.0f * std::numbers::pi_v<f32> * time / period_in_s - 0.6f * joint);
+
+            clip.samples[frame * TENTACLE_NUM_JOINTS + joint] = {
+                .rotation = {axis.x * std::sin(0.5f * angle), axis.y * std::sin(0.5f * angle),
+                             axis.z * std::sin(0.5f * angle), std::cos(0.5f * angle)},
+                .translation = {0.0f, joint == 0u ? 0.0f : TENTACLE_JOINT_SPACING, 0.0f},
+            };
+        }
+    }
+
+    return clip;
+}
+
+// The terrain archive is generated from a procedural heightmap on the first run (a real asset pipeline would pack a
+// heightmap offline). The heightmap is flattened around the center of the scene, which is below the terrain.
+constexpr std::string_view TERRAIN_ARCHIVE_PATH = "terrain.bin";
+constexpr u32 TERRAIN_HEIGHTMAP_SIZE = 4097u;
+constexpr u32 TERRAIN_TILE_RESOLUTION = 64u;
+
+std::vector<u16> create_terrain_heightmap(nether::job_system_t &job_system)
+{
+    std::vector<u16> heights(static_cast<size_t>(TERRAIN_HEIGHTMAP_SIZE) * TERRAIN_HEIGHTMAP_SIZE);
+    job_system.parallel_for(TERRAIN_HEIGHTMAP_SIZE, 64u, [&](const u32 begin, const u32 end, const u32) {
+        for (u32 z = begin; z < end; z++)
+        {
+            for (u32 x = 0u; x < TERRAIN_HEIGHTMAP_SIZE; x++)
+            {
+                f32 height = 0.5f;
+                f32 amplitude = 0.3f;
+                f32 frequency = 0.004f;
+                for (u32 octave = 0u; octave < 6u; octave++)
+                {
+                    height += amplitude * std::sin(frequency * x + 1.7f * octave) * std::cos(frequency * 1.3f * z);
+                    amplitude *= 0.45f;
+                    frequency *= 2.2f;
+                }
+
+                const f32 center_offset_x = static_cast<f32>(x) - TERRAIN_HEIGHTMAP_SIZE / 2u;
+                const f32 center_offset_z = static_cast<f32>(z) - TERRAIN_HEIGHTMAP_SIZE / 2u;
+                const f32 center_distance =
+                    std::sqrt(center_offset_x * center_offset_x + center_offset_z * center_offset_z);
+                const f32 falloff = std::clamp((center_distance - 150.0f) / 250.0f, 0.0f, 1.0f);
+
+                heights[static_cast<size_t>(z) * TERRAIN_HEIGHTMAP_SIZE + x] =
+                    static_cast<u16>(std::clamp(height * falloff * falloff, 0.0f, 1.0f) * 65535.0f);
+            }
+        }
+    });
+
+    return heights;
+}
+
+// Indices of a terrain patch's (tile_resolution + 3)^2 vertex grid (see shaders/terrain_shader.hlsl), with clockwise
+// front faces when seen from above. Quads are split along the diagonal from their first vertex, which the geometric
+// errors of the terrain archive assume.
+std::vector<u16> create_terrain_patch_indices(const u32 tile_resolution)
+{
+    const u32 num_vertices_per_side = tile_resolution + 3u;
+
+    std::vector<u16> indices{};
+    for (u32 z = 0u; z + 1u < num_vertices_per_side; z++)
+    {
+        for (u32 x = 0u; x + 1u < num_vertices_per_side; x++)
+        {
+            const u16 first = static_cast<u16>(z * num_vertices_per_side + x);
+            const u16 next_x = static_cast<u16>(first + 1u);
+            const u16 next_z = static_cast<u16>(first + num_vertices_per_side);
+            const u16 next_xz = static_cast<u16>(next_z + 1u);
+
+            indices.insert(indices.end(), {first, next_z, next_xz, first, next_xz, next_x});
+        }
+    }
+
+    return indices;
+}
+
 int main()
 {
+    // Time to first frame is measured from here to the first present.
+    const auto startup_start_time = std::chrono::steady_clock::now();
+
     HINSTANCE instance = GetModuleHandle(nullptr);
 
     constexpr u32 WINDOW_WIDTH = 1080u;
@@ -195,122 +446,116 @@ int main()
 
     try
     {
-        ComPtr<ID3D12Debug5> debug_layer = {};
+        // Engine initialization is a graph of tasks executed on the job system, so that independent work overlaps
+        // (e.g. shaders are loaded while the device and queues are created). The objects created by the tasks are
+        // declared up front, and a task only uses objects created by the tasks it depends on. Descriptor heaps and the
+        // residency manager are not thread safe, so the tasks that allocate from them are chained. The timing report
+        // of the graph (and its critical path) shows what bounds the time to first frame.
+        nether::job_system_t job_system{};
+        nether::task_graph_t startup_task_graph{};
 
-        // Enable the d3d12 debug layer in debug mode.
-        uint32_t dxgi_factory_creation_flags = 0u;
-
-        if constexpr (NETHER_DEBUG)
-        {
-            throw_if_failed(D3D12GetDebugInterface(IID_PPV_ARGS(&debug_layer)));
-
-            debug_layer->EnableDebugLayer();
-            debug_layer->SetEnableAutoName(true);
-            debug_layer->SetEnableGPUBasedValidation(true);
-            debug_layer->SetEnableSynchronizedCommandQueueValidation(true);
+        ComPtr<ID3D12Debug5> debug_layer = {};
+        ComPtr<IDXGIFactory6> dxgi_factory = {};
+        ComPtr<IDXGIAdapter3> dxgi_adapter = {};
+        ComPtr<ID3D12Device5> device = {};
+        ComPtr<ID3D12InfoQueue> info_queue = {};
+        ComPtr<ID3D12DebugDevice2> debug_device = {};
 
-            dxgi_factory_creation_flags |= DXGI_CREATE_FACTORY_DEBUG;
-        }
+        const auto device_task = startup_task_graph.add_task("device", {}, [&]() {
+            // Enable the d3d12 debug layer in debug mode.
+            uint32_t dxgi_factory_creation_flags = 0u;
 
-        // Create dxgi factory to get access to dxgi objects (like the swapchain and adapter).
-        ComPtr<IDXGIFactory6> dxgi_factory = {};
-        throw_if_failed(CreateDXGIFactory2(dxgi_factory_creation_flags, IID_PPV_ARGS(&dxgi_factory)));
+            if constexpr (NETHER_DEBUG)
+            {
+                throw_if_failed(D3D12GetDebugInterface(IID_PPV_ARGS(&debug_layer)));
 
-        // Query the adapter (interface to the actual GPU).
-        ComPtr<IDXGIAdapter3> dxgi_adapter = {};
-        throw_if_failed(dxgi_factory->EnumAdapterByGpuPreference(0u, DXGI_GPU_PREFERENCE_HIGH_PERFORMANCE,
-                                                                 IID_PPV_ARGS(&dxgi_adapter)));
+                debug_layer->EnableDebugLayer();
+                debug_layer->SetEnableAutoName(true);
+                debug_layer->SetEnableGPUBasedValidation(true);
+                debug_layer->SetEnableSynchronizedCommandQueueValidation(true);
 
-        // Display information about the chosen adapter.
-        DXGI_ADAPTER_DESC adapter_desc = {};
-        throw_if_failed(dxgi_adapter->GetDesc(&adapter_desc));
-        std::wcout << std::format(L"Chosen adapter description :: {}", adapter_desc.Description) << std::endl;
+                dxgi_factory_creation_flags |= DXGI_CREATE_FACTORY_DEBUG;
+            }
 
-        // Create the d3d12 device, which is required for creation of most objects in d3d12.
-        ComPtr<ID3D12Device5> device = {};
-        throw_if_failed(D3D12CreateDevice(dxgi_adapter.Get(), D3D_FEATURE_LEVEL_12_0, IID_PPV_ARGS(&device)));
-        set_name_d3d12_object(device.Get(), L"D3D12 device");
+            // Create dxgi factory to get access to dxgi objects (like the swapchain and adapter).
+            throw_if_failed(CreateDXGIFactory2(dxgi_factory_creation_flags, IID_PPV_ARGS(&dxgi_factory)));
 
-        // Setup a info queue, so that breakpoints can be set when a message severity of a specific type comes up.
-        ComPtr<ID3D12InfoQueue> info_queue = {};
-        if constexpr (NETHER_DEBUG)
-        {
-            throw_if_failed(device.As(&info_queue));
+            // Query the adapter (interface to the actual GPU).
+            throw_if_failed(dxgi_factory->EnumAdapterByGpuPreference(0u, DXGI_GPU_PREFERENCE_HIGH_PERFORMANCE,
+                                                                     IID_PPV_ARGS(&dxgi_adapter)));
 
-            throw_if_failed(info_queue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_CORRUPTION, true));
-            throw_if_failed(info_queue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_WARNING, true));
-            throw_if_failed(info_queue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_ERROR, true));
-        }
+            // Display information about the chosen adapter.
+            DXGI_ADAPTER_DESC adapter_desc = {};
+            throw_if_failed(dxgi_adapter->GetDesc(&adapter_desc));
+            std::wcout << std::format(L"Chosen adapter description :: {}", adapter_desc.Description) << std::endl;
 
-        // Query a d3d12 debug device to make sure all objects are properly cleared up and are not live at end of
-        // application.
-        ComPtr<ID3D12DebugDevice2> debug_device = {};
+            // Create the d3d12 device, which is required for creation of most objects in d3d12.
+            throw_if_failed(D3D12CreateDevice(dxgi_adapter.Get(), D3D_FEATURE_LEVEL_12_0, IID_PPV_ARGS(&device)));
+            set_name_d3d12_object(device.Get(), L"D3D12 device");
 
-        if constexpr (NETHER_DEBUG)
-        {
-            throw_if_failed(device->QueryInterface(IID_PPV_ARGS(&debug_device)));
-        }
+            // Setup a info queue, so that breakpoints can be set when a message severity of a specific type comes up.
+            if constexpr (NETHER_DEBUG)
+            {
+                throw_if_failed(device.As(&info_queue));
 
-        // Create the command queue, the execution port of GPU's.
-        const D3D12_COMMAND_QUEUE_DESC direct_command_queue_desc = {
+                throw_if_failed(info_queue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_CORRUPTION, true));
+                throw_if_failed(info_queue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_WARNING, true));
+                throw_if_failed(info_queue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_ERROR, true));
+            }
 
-            .Type = D3D12_COMMAND_LIST_TYPE_DIRECT,
-            .Priority = 0u,
-            .Flags = D3D12_COMMAND_QUEUE_FLAGS::D3D12_COMMAND_QUEUE_FLAG_NONE,
-            .NodeMask = 0u,
-        };
+            // Query a d3d12 debug device to make sure all objects are properly cleared up and are not live at end of
+            // application.
+            if constexpr (NETHER_DEBUG)
+            {
+                throw_if_failed(device->QueryInterface(IID_PPV_ARGS(&debug_device)));
+            }
+        });
 
         ComPtr<ID3D12CommandQueue> direct_command_queue = {};
-        throw_if_failed(device->CreateCommandQueue(&direct_command_queue_desc, IID_PPV_ARGS(&direct_command_queue)));
-        set_name_d3d12_object(direct_command_queue.Get(), L"D3D12 direct command queue");
-
-        // Create the command allocators (i.e backing store for commands recorded via command lists).
         std::array<ComPtr<ID3D12CommandAllocator>, NUM_BACK_BUFFERS> direct_command_allocators = {};
-        for (u32 i = 0; i < NUM_BACK_BUFFERS; i++)
-        {
-            throw_if_failed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
-                                                           IID_PPV_ARGS(&direct_command_allocators[i])));
-            set_name_d3d12_object(direct_command_allocators[i].Get(),
-                                  L"D3D12 direct command allocator" + std::to_wstring(i));
-        }
-
-        // Create command list.
         ComPtr<ID3D12GraphicsCommandList> graphics_command_list = {};
-        throw_if_failed(device->CreateCommandList(0u, D3D12_COMMAND_LIST_TYPE_DIRECT,
-                                                  direct_command_allocators[0].Get(), nullptr,
-                                                  IID_PPV_ARGS(&graphics_command_list)));
-        throw_if_failed(graphics_command_list->Close());
-        set_name_d3d12_object(graphics_command_list.Get(), L"D3D12 Graphics command list");
-
-        // Create sync primitives.
         ComPtr<ID3D12Fence> fence = {};
-        throw_if_failed(device->CreateFence(0u, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
-        set_name_d3d12_object(fence.Get(), L"D3D12 direct command queue fence");
 
         std::array<u64, NUM_BACK_BUFFERS> frame_fence_values = {};
         u64 current_fence_value = 0u;
 
-        // Create the swapchain.
-        ComPtr<IDXGISwapChain1> swapchain_1 = {};
-        const DXGI_SWAP_CHAIN_DESC1 swapchain_desc = {
-            .Width = CLIENT_WIDTH,
-            .Height = CLIENT_HEIGHT,
-            .Format = DXGI_FORMAT_R8G8B8A8_UNORM,
-            .Stereo = false,
-            .SampleDesc = {1u, 0u},
-            .BufferUsage = DXGI_USAGE_BACK_BUFFER,
-            .BufferCount = NUM_BACK_BUFFERS,
-            .Scaling = DXGI_SCALING_NONE,
-            .SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD,
-            .AlphaMode = DXGI_ALPHA_MODE::DXGI_ALPHA_MODE_IGNORE,
-            .Flags = 0u,
-        };
+        const auto command_queue_task = startup_task_graph.add_task("command queue", {device_task}, [&]() {
+            // Create the command queue, the execution port of GPU's.
+            const D3D12_COMMAND_QUEUE_DESC direct_command_queue_desc = {
+
+                .Type = D3D12_COMMAND_LIST_TYPE_DIRECT,
+                .Priority = 0u,
+                .Flags = D3D12_COMMAND_QUEUE_FLAGS::D3D12_COMMAND_QUEUE_FLAG_NONE,
+                .NodeMask = 0u,
+            };
 
-        throw_if_failed(dxgi_factory->CreateSwapChainForHwnd(direct_command_queue.Get(), window_handle, &swapchain_desc,
-                                                             nullptr, nullptr, &swapchain_1));
+            throw_if_failed(
+                device->CreateCommandQueue(&direct_command_queue_desc, IID_PPV_ARGS(&direct_command_queue)));
+            set_name_d3d12_object(direct_command_queue.Get(), L"D3D12 direct command queue");
 
-        ComPtr<IDXGISwapChain3> swapchain = {};
-        throw_if_failed(swapchain_1.As(&swapchain));
+            // Create the command allocators (i.e backing store for commands recorded via command lists).
+            for (u32 i = 0; i < NUM_BACK_BUFFERS; i++)
+            {
+                throw_if_failed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+                                                               IID_PPV_ARGS(&direct_command_allocators[i])));
+
+                nether::memory::scratch_scope_t scratch_scope{};
+                std::pmr::wstring name(&scratch_scope.get_arena());
+                std::format_to(std::back_inserter(name), L"D3D12 direct command allocator {}", i);
+                set_name_d3d12_object(direct_command_allocators[i].Get(), name);
+            }
+
+            // Create command list.
+            throw_if_failed(device->CreateCommandList(0u, D3D12_COMMAND_LIST_TYPE_DIRECT,
+                                                      direct_command_allocators[0].Get(), nullptr,
+                                                      IID_PPV_ARGS(&graphics_command_list)));
+            throw_if_failed(graphics_command_list->Close());
+            set_name_d3d12_object(graphics_command_list.Get(), L"D3D12 Graphics command list");
+
+            // Create sync primitives.
+            throw_if_failed(device->CreateFence(0u, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
+            set_name_d3d12_object(fence.Get(), L"D3D12 direct command queue fence");
+        });
 
         // Setup viewport and scissor rect.
         const D3D12_VIEWPORT viewport = {
@@ -329,16 +574,22 @@ int main()
             .bottom = (LONG)CLIENT_HEIGHT,
         };
 
-        // Create RTV descriptor heap, which is a contiguous memory allocation for render target views, which describe a
-        // particular resource.
-        nether::descriptor_heap_t rtv_descriptor_heap{device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, NUM_BACK_BUFFERS,
-                                                      L"RTV Descriptor Heap"};
+        std::unique_ptr<nether::descriptor_heap_t> rtv_descriptor_heap{};
+        std::unique_ptr<nether::descriptor_heap_t> cbv_srv_uav_descriptor_heap{};
+        std::unique_ptr<nether::descriptor_heap_t> dsv_descriptor_heap{};
+
+        const auto descriptor_heaps_task = startup_task_graph.add_task("descriptor heaps", {device_task}, [&]() {
+            // Create RTV descriptor heap, which is a contiguous memory allocation for render target views, which
+            // describe a particular resource.
+            rtv_descriptor_heap = std::make_unique<nether::descriptor_heap_t>(
+                device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, NUM_BACK_BUFFERS, L"RTV Descriptor Heap");
 
-        nether::descriptor_heap_t cbv_srv_uav_descriptor_heap{device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 10u,
-                                                              L"CBV SRV UAV Descriptor Heap"};
+            cbv_srv_uav_descriptor_heap = std::make_unique<nether::descriptor_heap_t>(
+                device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 64u, L"CBV SRV UAV Descriptor Heap");
 
-        nether::descriptor_heap_t dsv_descriptor_heap{device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 1u,
-                                                      L"DSV Descriptor Heap"};
+            dsv_descriptor_heap = std::make_unique<nether::descriptor_heap_t>(
+                device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 1u, L"DSV Descriptor Heap");
+        });
 
         // Create RTV for each of the swapchain backbuffer image.
         struct BackBuffer
@@ -348,17 +599,47 @@ int main()
         };
         std::array<BackBuffer, NUM_BACK_BUFFERS> back_buffers = {};
 
-        for (u32 i = 0; i < NUM_BACK_BUFFERS; i++)
-        {
-            throw_if_failed(swapchain->GetBuffer(i, IID_PPV_ARGS(&back_buffers[i].resource)));
+        ComPtr<IDXGISwapChain3> swapchain = {};
 
-            nether::descriptor_handle_t descriptor_handle =
-                rtv_descriptor_heap.get_then_offset_current_descriptor_handle();
+        // The swapchain is created on the window's thread.
+        startup_task_graph.add_task(
+            "swapchain", {command_queue_task, descriptor_heaps_task},
+            [&]() {
+                // Create the swapchain.
+                ComPtr<IDXGISwapChain1> swapchain_1 = {};
+                const DXGI_SWAP_CHAIN_DESC1 swapchain_desc = {
+                    .Width = CLIENT_WIDTH,
+                    .Height = CLIENT_HEIGHT,
+                    .Format = DXGI_FORMAT_R8G8B8A8_UNORM,
+                    .Stereo = false,
+                    .SampleDesc = {1u, 0u},
+                    .BufferUsage = DXGI_USAGE_BACK_BUFFER,
+                    .BufferCount = NUM_BACK_BUFFERS,
+                    .Scaling = DXGI_SCALING_NONE,
+                    .SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD,
+                    .AlphaMode = DXGI_ALPHA_MODE::DXGI_ALPHA_MODE_IGNORE,
+                    .Flags = 0u,
+                };
 
-            device->CreateRenderTargetView(back_buffers[i].resource.Get(), nullptr, descriptor_handle.cpu_handle);
+                throw_if_failed(dxgi_factory->CreateSwapChainForHwnd(direct_command_queue.Get(), window_handle,
+                                                                     &swapchain_desc, nullptr, nullptr, &swapchain_1));
 
-            back_buffers[i].cpu_rtv_handle = descriptor_handle.cpu_handle;
-        }
+                throw_if_failed(swapchain_1.As(&swapchain));
+
+                for (u32 i = 0; i < NUM_BACK_BUFFERS; i++)
+                {
+                    throw_if_failed(swapchain->GetBuffer(i, IID_PPV_ARGS(&back_buffers[i].resource)));
+
+                    nether::descriptor_handle_t descriptor_handle =
+                        rtv_descriptor_heap->get_then_offset_current_descriptor_handle();
+
+                    device->CreateRenderTargetView(back_buffers[i].resource.Get(), nullptr,
+                                                   descriptor_handle.cpu_handle);
+
+                    back_buffers[i].cpu_rtv_handle = descriptor_handle.cpu_handle;
+                }
+            },
+            nether::task_affinity_t::calling_thread);
 
         // Setup of the depth buffer.
         struct depth_buffer_t
@@ -369,7 +650,7 @@ int main()
 
         depth_buffer_t depth_buffer = {};
 
-        {
+        startup_task_graph.add_task("depth buffer", {descriptor_heaps_task}, [&]() {
             const D3D12_HEAP_PROPERTIES default_heap_properties = {
                 .Type = D3D12_HEAP_TYPE_DEFAULT,
                 .CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
@@ -402,79 +683,111 @@ int main()
             throw_if_failed(device->CreateCommittedResource(
                 &default_heap_properties, D3D12_HEAP_FLAG_NONE, &depth_buffer_resource_desc,
                 D3D12_RESOURCE_STATE_DEPTH_WRITE, &optimized_depth_clear_value, IID_PPV_ARGS(&depth_buffer.resource)));
-        }
+            nether::memory::register_gpu_resource(device.Get(), depth_buffer.resource.Get(),
+                                                  nether::memory::memory_tag_t::render);
 
-        depth_buffer.cpu_dsv_handle = dsv_descriptor_heap.get_then_offset_current_descriptor_handle().cpu_handle;
+            depth_buffer.cpu_dsv_handle = dsv_descriptor_heap->get_then_offset_current_descriptor_handle().cpu_handle;
 
-        const D3D12_DEPTH_STENCIL_VIEW_DESC dsv_desc = {
-            .Format = DXGI_FORMAT_D32_FLOAT,
-            .ViewDimension = D3D12_DSV_DIMENSION::D3D12_DSV_DIMENSION_TEXTURE2D,
-            .Flags = D3D12_DSV_FLAG_READ_ONLY_DEPTH,
-            .Texture2D =
-                {
-                    .MipSlice = 0u,
-                },
-        };
+            const D3D12_DEPTH_STENCIL_VIEW_DESC dsv_desc = {
+                .Format = DXGI_FORMAT_D32_FLOAT,
+                .ViewDimension = D3D12_DSV_DIMENSION::D3D12_DSV_DIMENSION_TEXTURE2D,
+                .Flags = D3D12_DSV_FLAG_READ_ONLY_DEPTH,
+                .Texture2D =
+                    {
+                        .MipSlice = 0u,
+                    },
+            };
 
-        device->CreateDepthStencilView(depth_buffer.resource.Get(), &dsv_desc, depth_buffer.cpu_dsv_handle);
+            device->CreateDepthStencilView(depth_buffer.resource.Get(), &dsv_desc, depth_buffer.cpu_dsv_handle);
+        });
 
         // Create the root signature, which is kind of a function signature for shaders that descripts the shader's
         // inputs.
         ComPtr<ID3D12RootSignature> root_signature{};
 
-        const D3D12_ROOT_PARAMETER1 root_parameter_desc = {
-            .ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS,
-            .Constants =
-                {
+        const auto root_signature_task = startup_task_graph.add_task("root signature", {device_task}, [&]() {
+            const D3D12_ROOT_PARAMETER1 root_parameter_desc = {
+                .ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS,
+                .Constants =
+                    {
 
-                    .ShaderRegister = 0u,
-                    .RegisterSpace = 0u,
-                    .Num32BitValues = 64,
-                },
-            .ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL,
-        };
+                        .ShaderRegister = 0u,
+                        .RegisterSpace = 0u,
+                        .Num32BitValues = 64,
+                    },
+                .ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL,
+            };
 
-        const D3D12_VERSIONED_ROOT_SIGNATURE_DESC root_signature_desc = {
+            const D3D12_VERSIONED_ROOT_SIGNATURE_DESC root_signature_desc = {
 
-            .Version = D3D_ROOT_SIGNATURE_VERSION_1_1,
-            .Desc_1_1 =
-                {
+                .Version = D3D_ROOT_SIGNATURE_VERSION_1_1,
+                .Desc_1_1 =
+                    {
 
-                    .NumParameters = 1u,
-                    .pParameters = &root_parameter_desc,
-                    .NumStaticSamplers = 0u,
-                    .Flags = D3D12_ROOT_SIGNATURE_FLAG_CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED,
-                },
-        };
+                        .NumParameters = 1u,
+                        .pParameters = &root_parameter_desc,
+                        .NumStaticSamplers = 0u,
+                        .Flags = D3D12_ROOT_SIGNATURE_FLAG_CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED,
+                    },
+            };
 
-        ComPtr<ID3DBlob> root_signature_blob{};
-        ComPtr<ID3DBlob> error_blob{};
+            ComPtr<ID3DBlob> root_signature_blob{};
+            ComPtr<ID3DBlob> error_blob{};
 
-        // Why do root signatures have this funky logic where you have to serialize a root signature first?
-        // Simple, root signatures can be specified as a shader, and the compiled shader blob can be used as a
-        // serialized root signature.
-        throw_if_failed(D3D12SerializeVersionedRootSignature(&root_signature_desc, &root_signature_blob, &error_blob));
-        throw_if_failed(device->CreateRootSignature(0u, root_signature_blob->GetBufferPointer(),
-                                                    root_signature_blob->GetBufferSize(),
-                                                    IID_PPV_ARGS(&root_signature)));
+            // Why do root signatures have this funky logic where you have to serialize a root signature first?
+            // Simple, root signatures can be specified as a shader, and the compiled shader blob can be used as a
+            // serialized root signature.
+            throw_if_failed(
+                D3D12SerializeVersionedRootSignature(&root_signature_desc, &root_signature_blob, &error_blob));
+            throw_if_failed(device->CreateRootSignature(0u, root_signature_blob->GetBufferPointer(),
+                                                        root_signature_blob->GetBufferSize(),
+                                                        IID_PPV_ARGS(&root_signature)));
+        });
 
         const auto allocate_descriptor_handle_imgui = [&]() {
-            return cbv_srv_uav_descriptor_heap.get_then_offset_current_descriptor_handle();
+            return cbv_srv_uav_descriptor_heap->get_then_offset_current_descriptor_handle();
         };
 
-        // ImGui setup.
-        nether::descriptor_handle_t imgui_descriptor_handle =
-            cbv_srv_uav_descriptor_heap.get_then_offset_current_descriptor_handle();
+        // ImGui setup. The win32 backend is tied to the window's thread.
+        const auto imgui_task = startup_task_graph.add_task(
+            "imgui", {descriptor_heaps_task},
+            [&]() {
+                nether::descriptor_handle_t imgui_descriptor_handle =
+                    cbv_srv_uav_descriptor_heap->get_then_offset_current_descriptor_handle();
+
+                // Every allocation of ImGui (and of its backends) is tracked under the UI tag.
+                ImGui::SetAllocatorFunctions(
+                    [](const size_t size, void *) {
+                        const nether::memory::memory_tag_scope_t tag_scope(nether::memory::memory_tag_t::ui);
+                        return nether::memory::tracked_allocate(size);
+                    },
+                    [](void *const ptr, void *) { nether::memory::tracked_free(ptr); });
+
+                IMGUI_CHECKVERSION();
+                ImGui::CreateContext();
+                ImGui::StyleColorsDark();
+                ImGui_ImplWin32_Init(window_handle);
+                ImGui_ImplDX12_Init(device.Get(), NUM_BACK_BUFFERS, DXGI_FORMAT_R8G8B8A8_UNORM,
+                                    cbv_srv_uav_descriptor_heap->descriptor_heap.Get(),
+                                    imgui_descriptor_handle.cpu_handle, imgui_descriptor_handle.gpu_handle);
+            },
+            nether::task_affinity_t::calling_thread);
 
-        IMGUI_CHECKVERSION();
-        ImGui::CreateContext();
-        ImGui::StyleColorsDark();
-        ImGui_ImplWin32_Init(window_handle);
-        ImGui_ImplDX12_Init(device.Get(), NUM_BACK_BUFFERS, DXGI_FORMAT_R8G8B8A8_UNORM,
-                            cbv_srv_uav_descriptor_heap.descriptor_heap.Get(), imgui_descriptor_handle.cpu_handle,
-                            imgui_descriptor_handle.gpu_handle);
+        // Every buffer is registered with the residency manager, which evicts the least recently used buffers when over
+        // the video memory budget.
+        std::unique_ptr<nether::residency_manager_t> residency_manager{};
 
-        // Create upload heaps for vertex data (position / color), index buffer and the constant buffer.
+        const auto residency_manager_task = startup_task_graph.add_task("residency manager", {device_task}, [&]() {
+            residency_manager = std::make_unique<nether::residency_manager_t>(device.Get(), dxgi_adapter.Get());
+        });
+
+        const auto register_buffer = [&](ID3D12Resource *const resource) {
+            return residency_manager->register_resource(resource, resource->GetDesc().Width);
+        };
+
+        // Static vertex data (position / color) and index buffers are uploaded to device local memory through a copy
+        // queue.
+        std::unique_ptr<nether::static_geometry_uploader_t> static_geometry_uploader{};
 
         static constexpr std::array<DirectX::XMFLOAT3, 8> position_data = {
             DirectX::XMFLOAT3(-1.0f, -1.0f, -1.0f), DirectX::XMFLOAT3(-1.0f, 1.0f, -1.0f),
@@ -483,10 +796,6 @@ int main()
             DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f),    DirectX::XMFLOAT3(1.0f, -1.0f, 1.0f),
         };
 
-        upload_buffer_creation_result_t vertex_position_buffer_creation_result =
-            create_upload_buffer<DirectX::XMFLOAT3>(device.Get(), position_data, &cbv_srv_uav_descriptor_heap);
-
-        ComPtr<ID3D12Resource> vertex_color_buffer_resource{};
         static constexpr std::array<DirectX::XMFLOAT3, 8> color_data = {
             DirectX::XMFLOAT3{0.0f, 1.0f, 1.0f}, DirectX::XMFLOAT3{1.0f, 0.0f, 1.0f},
             DirectX::XMFLOAT3{1.0f, 1.0f, 0.0f},
@@ -497,67 +806,551 @@ int main()
             DirectX::XMFLOAT3{0.0f, 0.0f, 0.0f}, DirectX::XMFLOAT3{1.0f, 1.0f, 1.0f},
         };
 
-        upload_buffer_creation_result_t vertex_color_buffer_creation_result =
-            create_upload_buffer<DirectX::XMFLOAT3>(device.Get(), color_data, &cbv_srv_uav_descriptor_heap);
-
         static constexpr std::array<u16, 36> index_buffer_data = {
             0, 1, 2, 0, 2, 3, 4, 6, 5, 4, 7, 6, 4, 5, 1, 4, 1, 0, 3, 2, 6, 3, 6, 7, 1, 5, 6, 1, 6, 2, 4, 0, 3, 4, 3, 7,
         };
-        upload_buffer_creation_result_t index_buffer_creation_result =
-            create_upload_buffer<u16>(device.Get(), index_buffer_data, &cbv_srv_uav_descriptor_heap);
 
-        const D3D12_INDEX_BUFFER_VIEW index_buffer_view = {
-            .BufferLocation = index_buffer_creation_result.resource->GetGPUVirtualAddress(),
-            .SizeInBytes = static_cast<UINT>(index_buffer_data.size() * sizeof(u16)),
-            .Format = DXGI_FORMAT_R16_UINT,
+        u32 vertex_position_buffer_index{};
+        u32 vertex_color_buffer_index{};
+        u32 index_buffer_index{};
+
+        // The skinned mesh of the animated characters. The uploader references the data until the upload.
+        const skinned_mesh_data_t tentacle_mesh_data = create_tentacle_mesh();
+
+        // Vertex positions and colors are uploaded in the quantized formats of vertex_compression.hpp, and decoded by
+        // the vertex shaders.
+        nether::compressed_mesh_vertices_t cube_vertices{};
+        nether::compressed_mesh_vertices_t tentacle_vertices{};
+
+        u32 tentacle_position_buffer_index{};
+        u32 tentacle_color_buffer_index{};
+        u32 tentacle_joint_influence_buffer_index{};
+        u32 tentacle_index_buffer_index{};
+
+        // Particles are drawn as one instance of a quad per particle (see shaders/particle_shader.hlsl).
+        static constexpr std::array<u16, 6> particle_quad_index_data = {0, 1, 2, 0, 2, 3};
+
+        u32 particle_quad_index_buffer_index{};
+
+        // Every terrain patch is drawn with the same index buffer, one instance per patch.
+        const std::vector<u16> terrain_patch_index_data = create_terrain_patch_indices(TERRAIN_TILE_RESOLUTION);
+
+        u32 terrain_patch_index_buffer_index{};
+
+        std::vector<u32> static_geometry_residency_handles{};
+
+        const auto static_geometry_upload_task = startup_task_graph.add_task(
+            "static geometry upload", {command_queue_task, imgui_task, residency_manager_task}, [&]() {
+                const nether::memory::memory_tag_scope_t tag_scope(nether::memory::memory_tag_t::assets);
+
+                static_geometry_uploader = std::make_unique<nether::static_geometry_uploader_t>(
+                    device.Get(), cbv_srv_uav_descriptor_heap.get());
+
+                cube_vertices = nether::compress_mesh_vertices(nether::mesh_vertices_t{
+                    .positions = std::span(reinterpret_cast<const nether::float3_t *>(position_data.data()),
+                                           position_data.size()),
+                    .colors =
+                        std::span(reinterpret_cast<const nether::float3_t *>(color_data.data()), color_data.size()),
+                });
+                tentacle_vertices = nether::compress_mesh_vertices(nether::mesh_vertices_t{
+                    .positions = tentacle_mesh_data.positions,
+                    .colors = tentacle_mesh_data.colors,
+                });
+
+                for (const auto &[name, vertices] :
+                     {std::pair{"cube", &cube_vertices}, std::pair{"tentacle", &tentacle_vertices}})
+                {
+                    const nether::vertex_compression_statistics_t &compression_statistics = vertices->statistics;
+                    std::cout << std::format("Vertex compression :: {} : {} vertices, {} -> {} bytes, max error : "
+                                             "positions {:.6f}, colors {:.4f}, in {:.3f} ms",
+                                             name, vertices->positions.size(),
+                                             compression_statistics.get_uncompressed_size_in_bytes(),
+                                             compression_statistics.get_compressed_size_in_bytes(),
+                                             compression_statistics.positions.max_error,
+                                             compression_statistics.colors.max_error,
+                                             compression_statistics.compression_time_in_ms)
+                              << std::endl;
+                }
+
+                vertex_position_buffer_index =
+                    static_geometry_uploader->add_structured_buffer<nether::quantized_position_t>(
+                        cube_vertices.positions);
+                vertex_color_buffer_index = static_geometry_uploader->add_structured_buffer<u32>(cube_vertices.colors);
+                index_buffer_index = static_geometry_uploader->add_index_buffer<u16>(index_buffer_data);
+
+                tentacle_position_buffer_index =
+                    static_geometry_uploader->add_structured_buffer<nether::quantized_position_t>(
+                        tentacle_vertices.positions);
+                tentacle_color_buffer_index =
+                    static_geometry_uploader->add_structured_buffer<u32>(tentacle_vertices.colors);
+                tentacle_joint_influence_buffer_index =
+                    static_geometry_uploader->add_structured_buffer<nether::joint_influence_t>(
+                        tentacle_mesh_data.joint_influences);
+                tentacle_index_buffer_index =
+                    static_geometry_uploader->add_index_buffer<u16>(tentacle_mesh_data.indices);
+
+                particle_quad_index_buffer_index =
+                    static_geometry_uploader->add_index_buffer<u16>(particle_quad_index_data);
+                terrain_patch_index_buffer_index =
+                    static_geometry_uploader->add_index_buffer<u16>(terrain_patch_index_data);
+
+                // The direct queue waits for the copies, so the buffers can be used by the first frame.
+                static_geometry_uploader->upload(direct_command_queue.Get());
+
+                const nether::static_geometry_upload_statistics_t &upload_statistics =
+                    static_geometry_uploader->statistics;
+                std::wcout << std::format(L"Static geometry upload :: {} buffers ({} bytes) in {} destination "
+                                          L"buffers, {} batches / {} copies, planning {:.3f} ms, submission {:.3f} ms",
+                                          upload_statistics.num_buffers, upload_statistics.num_bytes,
+                                          upload_statistics.num_destination_buffers, upload_statistics.num_batches,
+                                          upload_statistics.num_copies, upload_statistics.planning_time_in_ms,
+                                          upload_statistics.submission_time_in_ms)
+                           << std::endl;
+
+                for (const ComPtr<ID3D12Resource> &destination_buffer : static_geometry_uploader->destination_buffers)
+                {
+                    static_geometry_residency_handles.push_back(register_buffer(destination_buffer.Get()));
+                }
+            });
+
+        const auto get_static_buffer_residency_handle = [&](const u32 buffer_index) {
+            return static_geometry_residency_handles[static_geometry_uploader->get_buffer(buffer_index)
+                                                         .destination_buffer_index];
         };
 
-        struct alignas(256) transform_buffer_t
+        // Must match scene_buffer_t in shaders/common.hlsli.
+        struct alignas(256) scene_buffer_t
         {
-            DirectX::XMMATRIX model_matrix{};
+            DirectX::XMMATRIX view_projection_matrix{};
+
+            u32 light_buffer_index{};
+            u32 light_cluster_buffer_index{};
+            u32 light_index_buffer_index{};
+            u32 num_lights{};
+
+            u32 num_clusters[3]{};
+            f32 near_plane{};
+
+            f32 cluster_size_in_pixels[2]{};
+            f32 depth_slice_scale{};
+            f32 depth_slice_bias{};
         };
 
-        struct alignas(256) scene_buffer_t
-        {
-            DirectX::XMFLOAT4 light_position{};
-            DirectX::XMFLOAT4 light_color{};
-            DirectX::XMMATRIX view_projection_matrix{};
-        };
+        // Per instance object indices written by the instance batcher every frame. There is one buffer per back
+        // buffer so that the CPU never writes to a buffer the GPU may still be reading from.
+        constexpr u32 MAX_INSTANCES = 4096u;
+
+        // The transforms and colors of the scene objects live in the GPU scene : a device local buffer with a record
+        // per object, of which only the records that changed are copied every frame. The copies read from a staging
+        // ring (an upload buffer with a part per back buffer), and every part has room for all records, so that an
+        // upload is never deferred.
+        constexpr u32 MAX_SCENE_OBJECTS = 4096u;
+        constexpr u64 GPU_SCENE_STAGING_SIZE = MAX_SCENE_OBJECTS * sizeof(nether::gpu_scene_object_t);
+
+        nether::gpu_scene_t gpu_scene({.capacity = MAX_SCENE_OBJECTS});
+
+        // Lights, light clusters and light indices are rebuilt by the light cluster builder every frame, so (like the
+        // instance buffers) there is one set of buffers per back buffer.
+        constexpr u32 MAX_LIGHTS = 4096u;
+
+        nether::light_cluster_builder_t light_cluster_builder{};
+
+        // Skinning matrices of the animated characters, written by animate_characters every frame (one buffer per back
+        // buffer, like the instance buffers).
+        constexpr u32 NUM_ANIMATED_CHARACTERS_X = 16u;
+        constexpr u32 NUM_ANIMATED_CHARACTERS_Z = 16u;
+        constexpr u32 NUM_ANIMATED_CHARACTERS = NUM_ANIMATED_CHARACTERS_X * NUM_ANIMATED_CHARACTERS_Z;
+
+        // Particle fountains at the corners of the animated characters' grid, pulled towards its center by a point
+        // force field. The particle vertices are written every frame straight into a per back buffer upload buffer
+        // sized for the maximum number of particles.
+        nether::particle_system_t particle_system{};
+        {
+            constexpr std::array<nether::float3_t, 4> fountain_positions = {
+                nether::float3_t{-20.0f, -2.8f, 0.0f},
+                nether::float3_t{20.0f, -2.8f, 0.0f},
+                nether::float3_t{-20.0f, -2.8f, 40.0f},
+                nether::float3_t{20.0f, -2.8f, 40.0f},
+            };
+            constexpr std::array<nether::float4_t, 4> fountain_colors = {
+                nether::float4_t{1.0f, 0.6f, 0.1f, 1.0f},
+                nether::float4_t{0.2f, 0.6f, 1.0f, 1.0f},
+                nether::float4_t{0.4f, 1.0f, 0.3f, 1.0f},
+                nether::float4_t{1.0f, 0.3f, 0.8f, 1.0f},
+            };
+
+            for (u32 i = 0u; i < fountain_positions.size(); i++)
+            {
+                particle_system.add_emitter(nether::particle_emitter_desc_t{
+                    .position = fountain_positions[i],
+                    .direction = {0.0f, 1.0f, 0.0f},
+                    .spread_angle_in_radians = 0.3f,
+                    .emission_radius = 0.3f,
+                    .min_speed = 12.0f,
+                    .max_speed = 16.0f,
+                    .min_lifetime_in_s = 2.0f,
+                    .max_lifetime_in_s = 4.0f,
+                    .emission_rate = 20000.0f,
+                    .max_particles = 65536u,
+                    .start_color = fountain_colors[i],
+                    .end_color = {0.1f, 0.1f, 0.1f, 1.0f},
+                    .start_size = 0.06f,
+                    .end_size = 0.01f,
+                    .seed = i,
+                });
+            }
+
+            particle_system.force_fields = {
+                nether::force_field_t{
+                    .type = nether::force_field_type_t::directional, .vector = {0.0f, -1.0f, 0.0f}, .strength = 9.81f},
+                nether::force_field_t{.type = nether::force_field_type_t::point,
+                                      .vector = {0.0f, 6.0f, 20.0f},
+                                      .strength = 12.0f,
+                                      .radius = 40.0f},
+                nether::force_field_t{.type = nether::force_field_type_t::drag, .strength = 0.1f},
+            };
+        }
+
+        // Debug lines can be drawn from any thread during the frame, and are written at the end of the update into a
+        // per back buffer upload buffer (lines past MAX_DEBUG_LINES are dropped).
+        constexpr u32 MAX_DEBUG_LINES = 1u << 18u;
+
+        nether::debug_draw_t debug_draw{};
+
+        // The terrain's tiles are streamed straight into a single upload buffer (a slot is only reused once no frame in
+        // flight reads it), while the selected patches are written to a per back buffer upload buffer every frame.
+        const nether::terrain_settings_t terrain_settings = {
+            .origin = {-0.5f * (TERRAIN_HEIGHTMAP_SIZE - 1u), -60.0f, -0.5f * (TERRAIN_HEIGHTMAP_SIZE - 1u)},
+            .cache_capacity_in_tiles = 1024u,
+            .max_tile_loads_per_update = 32u,
+            .eviction_delay_in_updates = NUM_BACK_BUFFERS,
+        };
+
+        std::unique_ptr<nether::terrain_t> terrain{};
+
+        const auto terrain_archive_task = startup_task_graph.add_task("terrain archive", {}, [&]() {
+            const nether::memory::memory_tag_scope_t tag_scope(nether::memory::memory_tag_t::assets);
+
+            if (!std::filesystem::exists(TERRAIN_ARCHIVE_PATH))
+            {
+                nether::write_terrain_archive(TERRAIN_ARCHIVE_PATH, create_terrain_heightmap(job_system),
+                                              TERRAIN_HEIGHTMAP_SIZE,
+                                              nether::terrain_archive_desc_t{
+                                                  .tile_resolution = TERRAIN_TILE_RESOLUTION,
+                                                  .sample_spacing = 1.0f,
+                                                  .height_scale = 300.0f,
+                                              },
+                                              &job_system);
+            }
+        });
+
+        // Residency handles of the buffers that exist once per back buffer.
+        std::array<std::vector<u32>, NUM_BACK_BUFFERS> frame_residency_handles = {};
+
+        std::array<upload_buffer_creation_result_t, NUM_BACK_BUFFERS> instance_buffer_creation_results = {};
+
+        default_buffer_creation_result_t gpu_scene_buffer_creation_result{};
+        upload_buffer_creation_result_t gpu_scene_staging_buffer_creation_result{};
+        u32 gpu_scene_buffer_residency_handle{};
+        u32 gpu_scene_staging_buffer_residency_handle{};
+
+        std::array<upload_buffer_creation_result_t, NUM_BACK_BUFFERS> light_buffer_creation_results = {};
+        std::array<upload_buffer_creation_result_t, NUM_BACK_BUFFERS> light_cluster_buffer_creation_results = {};
+        std::array<upload_buffer_creation_result_t, NUM_BACK_BUFFERS> light_index_buffer_creation_results = {};
+        std::array<upload_buffer_creation_result_t, NUM_BACK_BUFFERS> skinning_matrix_buffer_creation_results = {};
+        std::array<upload_buffer_creation_result_t, NUM_BACK_BUFFERS> particle_buffer_creation_results = {};
+        std::array<upload_buffer_creation_result_t, NUM_BACK_BUFFERS> debug_line_buffer_creation_results = {};
+        std::array<upload_buffer_creation_result_t, NUM_BACK_BUFFERS> terrain_patch_buffer_creation_results = {};
+
+        upload_buffer_creation_result_t terrain_tile_buffer_creation_result{};
+        u32 terrain_tile_buffer_residency_handle{};
+
+        // The scene buffer references the per back buffer light buffers, so it is per back buffer as well.
+        std::array<constant_buffer_creation_result_t<scene_buffer_t>, NUM_BACK_BUFFERS>
+            scene_constant_buffer_creation_results = {};
+
+        startup_task_graph.add_task("frame buffers", {static_geometry_upload_task, terrain_archive_task}, [&]() {
+            const nether::memory::memory_tag_scope_t tag_scope(nether::memory::memory_tag_t::render);
+
+            const std::vector<u32> initial_instance_data(MAX_INSTANCES);
+
+            for (u32 i = 0; i < NUM_BACK_BUFFERS; i++)
+            {
+                instance_buffer_creation_results[i] =
+                    create_upload_buffer<u32>(device.Get(), initial_instance_data, cbv_srv_uav_descriptor_heap.get());
+                frame_residency_handles[i].push_back(
+                    register_buffer(instance_buffer_creation_results[i].resource.Get()));
+            }
+
+            gpu_scene_buffer_creation_result = create_default_buffer<nether::gpu_scene_object_t>(
+                device.Get(), MAX_SCENE_OBJECTS, cbv_srv_uav_descriptor_heap.get());
+            gpu_scene_buffer_residency_handle = register_buffer(gpu_scene_buffer_creation_result.resource.Get());
+
+            const std::vector<nether::gpu_scene_object_t> initial_gpu_scene_staging_data(MAX_SCENE_OBJECTS *
+                                                                                         NUM_BACK_BUFFERS);
+            gpu_scene_staging_buffer_creation_result = create_upload_buffer<nether::gpu_scene_object_t>(
+                device.Get(), initial_gpu_scene_staging_data, cbv_srv_uav_descriptor_heap.get());
+            gpu_scene_staging_buffer_residency_handle =
+                register_buffer(gpu_scene_staging_buffer_creation_result.resource.Get());
+
+            const std::vector<nether::light_t> initial_light_data(MAX_LIGHTS);
+            const std::vector<nether::light_cluster_t> initial_light_cluster_data(
+                light_cluster_builder.get_num_clusters());
+            const std::vector<u32> initial_light_index_data(light_cluster_builder.get_num_clusters() *
+                                                            nether::light_cluster_builder_t::MAX_LIGHTS_PER_CLUSTER);
+
+            for (u32 i = 0; i < NUM_BACK_BUFFERS; i++)
+            {
+                light_buffer_creation_results[i] = create_upload_buffer<nether::light_t>(
+                    device.Get(), initial_light_data, cbv_srv_uav_descriptor_heap.get());
+                light_cluster_buffer_creation_results[i] = create_upload_buffer<nether::light_cluster_t>(
+                    device.Get(), initial_light_cluster_data, cbv_srv_uav_descriptor_heap.get());
+                light_index_buffer_creation_results[i] = create_upload_buffer<u32>(
+                    device.Get(), initial_light_index_data, cbv_srv_uav_descriptor_heap.get());
+
+                frame_residency_handles[i].push_back(register_buffer(light_buffer_creation_results[i].resource.Get()));
+                frame_residency_handles[i].push_back(
+                    register_buffer(light_cluster_buffer_creation_results[i].resource.Get()));
+                frame_residency_handles[i].push_back(
+                    register_buffer(light_index_buffer_creation_results[i].resource.Get()));
+            }
+
+            const std::vector<nether::float4x4_t> initial_skinning_matrix_data(NUM_ANIMATED_CHARACTERS *
+                                                                               TENTACLE_NUM_JOINTS);
+
+            for (u32 i = 0; i < NUM_BACK_BUFFERS; i++)
+            {
+                skinning_matrix_buffer_creation_results[i] = create_upload_buffer<nether::float4x4_t>(
+                    device.Get(), initial_skinning_matrix_data, cbv_srv_uav_descriptor_heap.get());
+                frame_residency_handles[i].push_back(
+                    register_buffer(skinning_matrix_buffer_creation_results[i].resource.Get()));
+            }
+
+            const std::vector<nether::particle_vertex_t> initial_particle_data(particle_system.get_max_particles());
+
+            for (u32 i = 0; i < NUM_BACK_BUFFERS; i++)
+            {
+                particle_buffer_creation_results[i] = create_upload_buffer<nether::particle_vertex_t>(
+                    device.Get(), initial_particle_data, cbv_srv_uav_descriptor_heap.get());
+                frame_residency_handles[i].push_back(
+                    register_buffer(particle_buffer_creation_results[i].resource.Get()));
+            }
+
+            const std::vector<nether::debug_line_t> initial_debug_line_data(MAX_DEBUG_LINES);
+
+            for (u32 i = 0; i < NUM_BACK_BUFFERS; i++)
+            {
+                debug_line_buffer_creation_results[i] = create_upload_buffer<nether::debug_line_t>(
+                    device.Get(), initial_debug_line_data, cbv_srv_uav_descriptor_heap.get());
+                frame_residency_handles[i].push_back(
+                    register_buffer(debug_line_buffer_creation_results[i].resource.Get()));
+            }
+
+            const nether::terrain_archive_header_t terrain_header =
+                nether::read_terrain_archive_header(TERRAIN_ARCHIVE_PATH);
+            if (terrain_header.tile_resolution != TERRAIN_TILE_RESOLUTION)
+            {
+                throw std::runtime_error(std::format("Terrain archive {} has tiles of {} quads instead of {}",
+                                                     TERRAIN_ARCHIVE_PATH, terrain_header.tile_resolution,
+                                                     TERRAIN_TILE_RESOLUTION));
+            }
+
+            // Two heights per element of the tile buffer.
+            const u32 terrain_tile_storage_size =
+                nether::terrain_t::get_tile_storage_size(terrain_header, terrain_settings);
+            const std::vector<u32> initial_terrain_tile_data(terrain_tile_storage_size / 2u);
+
+            terrain_tile_buffer_creation_result =
+                create_upload_buffer<u32>(device.Get(), initial_terrain_tile_data, cbv_srv_uav_descriptor_heap.get());
+            terrain_tile_buffer_residency_handle =
+                register_buffer(terrain_tile_buffer_creation_result.resource.Get());
+
+            terrain = std::make_unique<nether::terrain_t>(
+                TERRAIN_ARCHIVE_PATH, terrain_settings,
+                std::span(reinterpret_cast<u16 *>(terrain_tile_buffer_creation_result.ptr), terrain_tile_storage_size));
 
-        constant_buffer_creation_result_t<transform_buffer_t> transform_constant_buffer_creation_result =
-            create_constant_buffer<transform_buffer_t>(device.Get(), &cbv_srv_uav_descriptor_heap);
+            // Every selected patch is a resident tile.
+            const std::vector<nether::terrain_patch_t> initial_terrain_patch_data(
+                terrain_settings.cache_capacity_in_tiles);
 
-        constant_buffer_creation_result_t<transform_buffer_t> light_transform_constant_buffer_creation_result =
-            create_constant_buffer<transform_buffer_t>(device.Get(), &cbv_srv_uav_descriptor_heap);
+            for (u32 i = 0; i < NUM_BACK_BUFFERS; i++)
+            {
+                terrain_patch_buffer_creation_results[i] = create_upload_buffer<nether::terrain_patch_t>(
+                    device.Get(), initial_terrain_patch_data, cbv_srv_uav_descriptor_heap.get());
+                frame_residency_handles[i].push_back(
+                    register_buffer(terrain_patch_buffer_creation_results[i].resource.Get()));
+            }
+
+            for (u32 i = 0; i < NUM_BACK_BUFFERS; i++)
+            {
+                scene_constant_buffer_creation_results[i] =
+                    create_constant_buffer<scene_buffer_t>(device.Get(), cbv_srv_uav_descriptor_heap.get());
+                frame_residency_handles[i].push_back(
+                    register_buffer(scene_constant_buffer_creation_results[i].resource.Get()));
+            }
+        });
+
+        // Permutation sets for the mesh shader. The cube uses the VERTEX_COLOR | LIT permutation, the floor the LIT
+        // permutation, while the lights use the default permutation (constant light color).
+        nether::shader_compiler::shader_permutation_set_t mesh_vertex_shader_permutations(L"shaders/mesh_shader.hlsl",
+                                                                                          L"vs_6_6", L"vs_main");
+        nether::shader_compiler::shader_permutation_set_t mesh_pixel_shader_permutations(L"shaders/mesh_shader.hlsl",
+                                                                                         L"ps_6_6", L"ps_main");
+
+        static constexpr std::array<std::wstring_view, 2> vertex_color_lit_axes = {L"VERTEX_COLOR", L"LIT"};
+        static constexpr std::array<std::wstring_view, 1> lit_axes = {L"LIT"};
+        const u32 vertex_color_lit_permutation_mask =
+            mesh_vertex_shader_permutations.get_permutation_mask(vertex_color_lit_axes);
+        const u32 lit_permutation_mask = mesh_vertex_shader_permutations.get_permutation_mask(lit_axes);
+        const u32 light_permutation_mask = 0u;
+
+        // The skinned mesh shader has no permutation axes.
+        nether::shader_compiler::shader_permutation_set_t skinned_mesh_vertex_shader_permutations(
+            L"shaders/skinned_mesh_shader.hlsl", L"vs_6_6", L"vs_main");
+        nether::shader_compiler::shader_permutation_set_t skinned_mesh_pixel_shader_permutations(
+            L"shaders/skinned_mesh_shader.hlsl", L"ps_6_6", L"ps_main");
+
+        // Neither have the particle, debug draw and terrain shaders.
+        nether::shader_compiler::shader_permutation_set_t particle_vertex_shader_permutations(
+            L"shaders/particle_shader.hlsl", L"vs_6_6", L"vs_main");
+        nether::shader_compiler::shader_permutation_set_t particle_pixel_shader_permutations(
+            L"shaders/particle_shader.hlsl", L"ps_6_6", L"ps_main");
+        nether::shader_compiler::shader_permutation_set_t debug_draw_vertex_shader_permutations(
+            L"shaders/debug_draw_shader.hlsl", L"vs_6_6", L"vs_main");
+        nether::shader_compiler::shader_permutation_set_t debug_draw_pixel_shader_permutations(
+            L"shaders/debug_draw_shader.hlsl", L"ps_6_6", L"ps_main");
+        nether::shader_compiler::shader_permutation_set_t terrain_vertex_shader_permutations(
+            L"shaders/terrain_shader.hlsl", L"vs_6_6", L"vs_main");
+        nether::shader_compiler::shader_permutation_set_t terrain_pixel_shader_permutations(
+            L"shaders/terrain_shader.hlsl", L"ps_6_6", L"ps_main");
+
+        // Shaders are loaded from the shader archive built by nether-shader-packer when it exists : the archive is
+        // memory mapped, and the pipelines are created from views of its bytecode. Otherwise, all permutations are
+        // compiled ahead of time, so that no compilation happens in the frame loop.
+        // Shader loading does not need the device, so it overlaps with the creation of every device object. It is a
+        // single task as the shader compiler is not thread safe.
+        std::optional<nether::shader_archive_t> shader_archive{};
+
+        // Permutations missing from the archive (e.g. a shader added since the archive was built) are compiled.
+        const auto get_shader_bytecode =
+            [&](nether::shader_compiler::shader_permutation_set_t &permutation_set,
+                const u32 permutation_mask) -> D3D12_SHADER_BYTECODE {
+            if (shader_archive)
+            {
+                const u32 entry_index = shader_archive->find(
+                    nether::get_shader_archive_key(permutation_set.shader_path, permutation_set.target_profile,
+                                                   permutation_set.entry_point, permutation_mask));
+                if (entry_index != nether::shader_archive_t::INVALID_ENTRY_INDEX)
+                {
+                    const std::span<const u8> bytecode = shader_archive->get_bytecode(entry_index);
+                    return {
+                        .pShaderBytecode = bytecode.data(),
+                        .BytecodeLength = bytecode.size(),
+                    };
+
+        D3D12_SHADER_BYTECODE test_vertex_shader_bytecode{};
+        D3D12_SHADER_BYTECODE test_pixel_shader_bytecode{};
+        D3D12_SHADER_BYTECODE light_vertex_shader_bytecode{};
+        D3D12_SHADER_BYTECODE light_pixel_shader_bytecode{};
+        D3D12_SHADER_BYTECODE lit_vertex_shader_bytecode{};
+        D3D12_SHADER_BYTECODE lit_pixel_shader_bytecode{};
+        D3D12_SHADER_BYTECODE skinned_vertex_shader_bytecode{};
+        D3D12_SHADER_BYTECODE skinned_pixel_shader_bytecode{};
+        D3D12_SHADER_BYTECODE particle_vertex_shader_bytecode{};
+        D3D12_SHADER_BYTECODE particle_pixel_shader_bytecode{};
+        D3D12_SHADER_BYTECODE debug_draw_vertex_shader_bytecode{};
+        D3D12_SHADER_BYTECODE debug_draw_pixel_shader_bytecode{};
+        D3D12_SHADER_BYTECODE terrain_vertex_shader_bytecode{};
+        D3D12_SHADER_BYTECODE terrain_pixel_shader_bytecode{};
+
+        const auto shaders_task = startup_task_graph.add_task("shaders", {}, [&]() {
+            const nether::memory::memory_tag_scope_t tag_scope(nether::memory::memory_tag_t::shaders);
+
+            if (std::filesystem::exists(nether::DEFAULT_SHADER_ARCHIVE_PATH))
+            {
+                shader_archive.emplace(nether::DEFAULT_SHADER_ARCHIVE_PATH);
+                if ((shader_archive->get_flags() & nether::SHADER_ARCHIVE_FLAG_DEBUG) !=
+                    (NETHER_DEBUG ? nether::SHADER_ARCHIVE_FLAG_DEBUG : 0u))
+                {
+                    throw std::runtime_error(std::format("Shader archive {} was built for a different configuration",
+                                                         nether::DEFAULT_SHADER_ARCHIVE_PATH));
+                }
 
-        constant_buffer_creation_result_t<scene_buffer_t> scene_constant_buffer_creation_result =
-            create_constant_buffer<scene_buffer_t>(device.Get(), &cbv_srv_uav_descriptor_heap);
+                std::cout << std::format("Shader archive {} :: {} entries", nether::DEFAULT_SHADER_ARCHIVE_PATH,
+                                         shader_archive->get_num_entries())
+                          << std::endl;
+            }
+            else
+            {
+                mesh_vertex_shader_permutations.compile_all();
+                mesh_pixel_shader_permutations.compile_all();
+                skinned_mesh_vertex_shader_permutations.compile_all();
+                skinned_mesh_pixel_shader_permutations.compile_all();
+                particle_vertex_shader_permutations.compile_all();
+                particle_pixel_shader_permutations.compile_all();
+                debug_draw_vertex_shader_permutations.compile_all();
+                debug_draw_pixel_shader_permutations.compile_all();
+                terrain_vertex_shader_permutations.compile_all();
+                terrain_pixel_shader_permutations.compile_all();
+
+                for (const nether::shader_compiler::shader_permutation_set_t *permutation_set :
+                     {&mesh_vertex_shader_permutations, &mesh_pixel_shader_permutations,
+                      &skinned_mesh_vertex_shader_permutations, &skinned_mesh_pixel_shader_permutations,
+                      &particle_vertex_shader_permutations, &particle_pixel_shader_permutations,
+                      &debug_draw_vertex_shader_permutations, &debug_draw_pixel_shader_permutations,
+                      &terrain_vertex_shader_permutations, &terrain_pixel_shader_permutations})
+                {
+                    const nether::shader_compiler::shader_permutation_statistics_t &statistics =
+                        permutation_set->statistics;
+
+                    std::wcout << std::format(L"Shader permutations ({}, {}) :: requested {} (unique {}), compiled {}, "
+                                              L"deduplicated by preprocessed source {}, deduplicated by bytecode {}",
+                                              permutation_set->shader_path, permutation_set->entry_point,
+                                              statistics.num_requests, statistics.num_unique_requests,
+                                              statistics.num_compiled, statistics.num_preprocessed_deduplicated,
+                                              statistics.num_bytecode_deduplicated)
+                               << std::endl;
+                }
+            }
 
-        scene_constant_buffer_creation_result.data.light_position = {0.0f, 7.0f, 10.0f, 1.0f};
-        scene_constant_buffer_creation_result.data.light_color = {1.0f, 1.0f, 1.0f, 1.0f};
+            test_vertex_shader_bytecode =
+                get_shader_bytecode(mesh_vertex_shader_permutations, vertex_color_lit_permutation_mask);
+            test_pixel_shader_bytecode =
+                get_shader_bytecode(mesh_pixel_shader_permutations, vertex_color_lit_permutation_mask);
+            light_vertex_shader_bytecode = get_shader_bytecode(mesh_vertex_shader_permutations, light_permutation_mask);
+            light_pixel_shader_bytecode = get_shader_bytecode(mesh_pixel_shader_permutations, light_permutation_mask);
+            lit_vertex_shader_bytecode = get_shader_bytecode(mesh_vertex_shader_permutations, lit_permutation_mask);
+            lit_pixel_shader_bytecode = get_shader_bytecode(mesh_pixel_shader_permutations, lit_permutation_mask);
+            skinned_vertex_shader_bytecode = get_shader_bytecode(skinned_mesh_vertex_shader_permutations, 0u);
+            skinned_pixel_shader_bytecode = get_shader_bytecode(skinned_mesh_pixel_shader_permutations, 0u);
+            particle_vertex_shader_bytecode = get_shader_bytecode(particle_vertex_shader_permutations, 0u);
+            particle_pixel_shader_bytecode = get_shader_bytecode(particle_pixel_shader_permutations, 0u);
+            debug_draw_vertex_shader_bytecode = get_shader_bytecode(debug_draw_vertex_shader_permutations, 0u);
+            debug_draw_pixel_shader_bytecode = get_shader_bytecode(debug_draw_pixel_shader_permutations, 0u);
+            terrain_vertex_shader_bytecode = get_shader_bytecode(terrain_vertex_shader_permutations, 0u);
+            terrain_pixel_shader_bytecode = get_shader_bytecode(terrain_pixel_shader_permutations, 0u);
+        });
+
+        // The fixed function state that differs between pipelines. By default, back faces are culled and depth is
+        // tested and written.
+        struct pipeline_state_options_t
+        {
+            D3D12_CULL_MODE cull_mode{D3D12_CULL_MODE_BACK};
+            bool depth_test{true};
+            bool depth_write{true};
+        };
 
-        // A simple lambda function that takes as input a combined vertex and pixel shader path, and create a graphics
+        // A simple lambda function that takes as input the compiled vertex and pixel shader, and create a graphics
         // pipeline state object.
-
-        const auto create_graphics_pipeline = [&](const std::wstring_view shader_path) -> ComPtr<ID3D12PipelineState> {
-            // Compile shaders.
-            ComPtr<IDxcBlob> vertex_shader_blob =
-                nether::shader_compiler::compile_shader(shader_path.data(), L"vs_6_6", L"vs_main");
-            ComPtr<IDxcBlob> pixel_shader_blob =
-                nether::shader_compiler::compile_shader(shader_path.data(), L"ps_6_6", L"ps_main");
+        const auto create_graphics_pipeline =
+            [&](const D3D12_SHADER_BYTECODE vertex_shader_bytecode, const D3D12_SHADER_BYTECODE pixel_shader_bytecode,
+                const pipeline_state_options_t &options = {}) -> ComPtr<ID3D12PipelineState> {
+            const nether::memory::memory_tag_scope_t tag_scope(nether::memory::memory_tag_t::shaders);
 
             const D3D12_GRAPHICS_PIPELINE_STATE_DESC graphics_pipeline_state_desc = {
                 .pRootSignature = root_signature.Get(),
-                .VS =
-                    {
-                        .pShaderBytecode = vertex_shader_blob->GetBufferPointer(),
-                        .BytecodeLength = vertex_shader_blob->GetBufferSize(),
-                    },
-                .PS =
-                    {
-                        .pShaderBytecode = pixel_shader_blob->GetBufferPointer(),
-                        .BytecodeLength = pixel_shader_blob->GetBufferSize(),
-                    },
+                .VS = vertex_shader_bytecode,
+                .PS = pixel_shader_bytecode,
                 .BlendState =
                     {
                         .AlphaToCoverageEnable = false,
@@ -579,7 +1372,7 @@ int main()
                 .RasterizerState =
                     {
                         .FillMode = D3D12_FILL_MODE_SOLID,
-                        .CullMode = D3D12_CULL_MODE_BACK,
+                        .CullMode = options.cull_mode,
                         .FrontCounterClockwise = FALSE,
                         .DepthClipEnable = FALSE,
                         .MultisampleEnable = FALSE,
@@ -587,8 +1380,9 @@ int main()
                     },
                 .DepthStencilState =
                     {
-                        .DepthEnable = TRUE,
-                        .DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL,
+                        .DepthEnable = options.depth_test,
+                        .DepthWriteMask =
+                            options.depth_write ? D3D12_DEPTH_WRITE_MASK_ALL : D3D12_DEPTH_WRITE_MASK_ZERO,
                         .DepthFunc = D3D12_COMPARISON_FUNC_GREATER_EQUAL,
                         .StencilEnable = FALSE,
                         .FrontFace =
@@ -631,8 +1425,245 @@ int main()
             return pso;
         };
 
-        ComPtr<ID3D12PipelineState> test_graphics_pipeline = create_graphics_pipeline(L"shaders/test_shader.hlsl");
-        ComPtr<ID3D12PipelineState> light_graphics_pipeline = create_graphics_pipeline(L"shaders/light_shader.hlsl");
+        // Pipelines are created in parallel (pipeline creation is thread safe, and is the most expensive part of
+        // startup once shaders come from the archive).
+        ComPtr<ID3D12PipelineState> test_graphics_pipeline{};
+        ComPtr<ID3D12PipelineState> light_graphics_pipeline{};
+        ComPtr<ID3D12PipelineState> lit_graphics_pipeline{};
+        ComPtr<ID3D12PipelineState> skinned_graphics_pipeline{};
+        ComPtr<ID3D12PipelineState> particle_graphics_pipeline{};
+        ComPtr<ID3D12PipelineState> debug_draw_depth_tested_graphics_pipeline{};
+        ComPtr<ID3D12PipelineState> debug_draw_on_top_graphics_pipeline{};
+        ComPtr<ID3D12PipelineState> terrain_graphics_pipeline{};
+
+        startup_task_graph.add_task("test pipeline", {shaders_task, root_signature_task}, [&]() {
+            test_graphics_pipeline = create_graphics_pipeline(test_vertex_shader_bytecode, test_pixel_shader_bytecode);
+        });
+        startup_task_graph.add_task("light pipeline", {shaders_task, root_signature_task}, [&]() {
+            light_graphics_pipeline =
+                create_graphics_pipeline(light_vertex_shader_bytecode, light_pixel_shader_bytecode);
+        });
+        startup_task_graph.add_task("lit pipeline", {shaders_task, root_signature_task}, [&]() {
+            lit_graphics_pipeline = create_graphics_pipeline(lit_vertex_shader_bytecode, lit_pixel_shader_bytecode);
+        });
+        startup_task_graph.add_task("skinned pipeline", {shaders_task, root_signature_task}, [&]() {
+            skinned_graphics_pipeline =
+                create_graphics_pipeline(skinned_vertex_shader_bytecode, skinned_pixel_shader_bytecode);
+        });
+        startup_task_graph.add_task("particle pipeline", {shaders_task, root_signature_task}, [&]() {
+            particle_graphics_pipeline =
+                create_graphics_pipeline(particle_vertex_shader_bytecode, particle_pixel_shader_bytecode);
+        });
+        // The quads of the debug lines face either way, and do not write depth (so that lines drawn later are not
+        // hidden by earlier ones).
+        startup_task_graph.add_task("debug draw pipelines", {shaders_task, root_signature_task}, [&]() {
+            debug_draw_depth_tested_graphics_pipeline =
+                create_graphics_pipeline(debug_draw_vertex_shader_bytecode, debug_draw_pixel_shader_bytecode,
+                                         {.cull_mode = D3D12_CULL_MODE_NONE, .depth_write = false});
+            debug_draw_on_top_graphics_pipeline = create_graphics_pipeline(
+                debug_draw_vertex_shader_bytecode, debug_draw_pixel_shader_bytecode,
+                {.cull_mode = D3D12_CULL_MODE_NONE, .depth_test = false, .depth_write = false});
+        });
+        startup_task_graph.add_task("terrain pipeline", {shaders_task, root_signature_task}, [&]() {
+            terrain_graphics_pipeline =
+                create_graphics_pipeline(terrain_vertex_shader_bytecode, terrain_pixel_shader_bytecode);
+        });
+
+        // The animation clips of the characters are compressed at load time (a real asset pipeline would do this
+        // offline).
+        const nether::skeleton_t tentacle_skeleton = create_tentacle_skeleton();
+
+        constexpr u32 SWAY_CLIP_INDEX = 0u;
+        constexpr u32 TWIST_CLIP_INDEX = 1u;
+
+        std::array<nether::animation_clip_t, 2> animation_clips{};
+
+        startup_task_graph.add_task("animation clips", {}, [&]() {
+            const nether::memory::memory_tag_scope_t tag_scope(nether::memory::memory_tag_t::assets);
+
+            const std::array<nether::raw_animation_clip_t, 2> raw_clips = {
+                create_tentacle_clip({0.0f, 0.0f, 1.0f}, 2.0f, 0.35f),
+                create_tentacle_clip({1.0f, 0.0f, 0.0f}, 1.5f, 0.25f),
+            };
+
+            for (u32 i = 0u; i < raw_clips.size(); i++)
+            {
+                animation_clips[i] = nether::compress_animation_clip(raw_clips[i]);
+
+                std::cout << std::format("Animation clip {} :: {} frames, {} rotation keys, {} translation keys, {} "
+                                         "bytes (uncompressed {} bytes)",
+                                         i, animation_clips[i].num_frames, animation_clips[i].get_num_rotation_keys(),
+                                         animation_clips[i].get_num_translation_keys(),
+                                         animation_clips[i].get_size_in_bytes(),
+                                         raw_clips[i].samples.size() * sizeof(nether::joint_transform_t))
+                          << std::endl;
+            }
+        });
+
+        // The frame is recorded into engine command streams : stream 0 prepares the back buffer, and the scene draws
+        // are split over the remaining streams, which are recorded in parallel on the job system. Each stream has its
+        // own arena, as arenas are not thread safe. The streams are then translated in parallel into D3D12 command
+        // lists and submitted in stream order.
+        constexpr u32 NUM_DRAW_COMMAND_STREAMS = 4u;
+        constexpr u32 NUM_COMMAND_STREAMS = NUM_DRAW_COMMAND_STREAMS + 1u;
+        constexpr size_t COMMAND_STREAM_ARENA_CAPACITY = 1024u * 1024u;
+
+        std::vector<std::unique_ptr<nether::memory::linear_arena_t>> command_stream_arenas{};
+        std::vector<nether::command_stream_t> command_streams{};
+        std::vector<const nether::command_stream_t *> command_stream_pointers{};
+        for (u32 i = 0u; i < NUM_COMMAND_STREAMS; i++)
+        {
+            command_stream_arenas.push_back(
+                std::make_unique<nether::memory::linear_arena_t>(COMMAND_STREAM_ARENA_CAPACITY));
+            command_streams.emplace_back(*command_stream_arenas.back());
+        }
+
+        for (const nether::command_stream_t &command_stream : command_streams)
+        {
+            command_stream_pointers.push_back(&command_stream);
+        }
+
+        // The resource table of the command streams : the current back buffer, and the buffers of the GPU scene's
+        // copies.
+        constexpr u32 BACK_BUFFER_RESOURCE_INDEX = 0u;
+        constexpr u32 GPU_SCENE_BUFFER_RESOURCE_INDEX = 1u;
+        constexpr u32 GPU_SCENE_STAGING_BUFFER_RESOURCE_INDEX = 2u;
+
+        std::unique_ptr<nether::command_translator_t> command_translator{};
+
+        startup_task_graph.add_task("command translator", {device_task}, [&]() {
+            command_translator =
+                std::make_unique<nether::command_translator_t>(device.Get(), NUM_BACK_BUFFERS, NUM_COMMAND_STREAMS);
+        });
+
+        startup_task_graph.execute(&job_system);
+        std::cout << nether::to_string(startup_task_graph.get_report()) << std::endl;
+
+        // All meshes that can be referenced by a draw packet's mesh_index.
+        struct mesh_t
+        {
+            u32 position_buffer_index{};
+            u32 color_buffer_index{};
+
+            // Dequantization of the positions (see compressed_mesh_vertices_t).
+            nether::float3_t position_offset{};
+            nether::float3_t position_scale{};
+
+            D3D12_INDEX_BUFFER_VIEW index_buffer_view{};
+            u32 index_count{};
+
+            // Object space bounds, and the CPU side geometry used when the mesh is an occluder.
+            nether::aabb_t bounds{};
+            std::span<const nether::float3_t> positions{};
+            std::span<const u16> indices{};
+
+            // Residency handles of the position, color and index buffers.
+            std::array<u32, 3> residency_handles{};
+        };
+
+        constexpr u32 CUBE_MESH_INDEX = 0u;
+
+        const std::array<mesh_t, 1> meshes = {
+            mesh_t{
+                .position_buffer_index = static_geometry_uploader->get_buffer(vertex_position_buffer_index).srv_index,
+                .color_buffer_index = static_geometry_uploader->get_buffer(vertex_color_buffer_index).srv_index,
+                .position_offset = cube_vertices.position_offset,
+                .position_scale = cube_vertices.position_scale,
+                .index_buffer_view =
+                    static_geometry_uploader->get_index_buffer_view(index_buffer_index, DXGI_FORMAT_R16_UINT),
+                .index_count = static_cast<u32>(index_buffer_data.size()),
+                .bounds = {{-1.0f, -1.0f, -1.0f}, {1.0f, 1.0f, 1.0f}},
+                .positions = std::span(reinterpret_cast<const nether::float3_t *>(position_data.data()),
+                                       position_data.size()),
+                .indices = index_buffer_data,
+                .residency_handles =
+                    {
+                        get_static_buffer_residency_handle(vertex_position_buffer_index),
+                        get_static_buffer_residency_handle(vertex_color_buffer_index),
+                        get_static_buffer_residency_handle(index_buffer_index),
+                    },
+            },
+        };
+
+        nether::instance_batcher_t instance_batcher{};
+
+        // The occlusion culler's depth buffer has the aspect ratio of the window, at a much lower resolution.
+        constexpr u32 OCCLUSION_BUFFER_WIDTH = 384u;
+        const u32 occlusion_buffer_height =
+            std::max((OCCLUSION_BUFFER_WIDTH * CLIENT_HEIGHT / CLIENT_WIDTH + 7u) & ~7u, 8u);
+
+        nether::occlusion_culler_t occlusion_culler(OCCLUSION_BUFFER_WIDTH, occlusion_buffer_height);
+
+        // Transient per frame data (gathered lights, draw packets before culling, ...) is allocated from the frame
+        // arena of the current back buffer, which is reset once the GPU is done with the back buffer's last frame.
+        constexpr size_t FRAME_ARENA_CAPACITY = 8u * 1024u * 1024u;
+
+        nether::memory::frame_arena_set_t frame_arenas(NUM_BACK_BUFFERS, FRAME_ARENA_CAPACITY);
+
+        // All pipelines that can be referenced by a draw packet's pipeline_index.
+        constexpr u32 TEST_PIPELINE_INDEX = 0u;
+        constexpr u32 LIGHT_PIPELINE_INDEX = 1u;
+        constexpr u32 LIT_PIPELINE_INDEX = 2u;
+        constexpr u32 SKINNED_PIPELINE_INDEX = 3u;
+        constexpr u32 PARTICLE_PIPELINE_INDEX = 4u;
+        constexpr u32 TERRAIN_PIPELINE_INDEX = 5u;
+        constexpr u32 DEBUG_DRAW_DEPTH_TESTED_PIPELINE_INDEX = 6u;
+        constexpr u32 DEBUG_DRAW_ON_TOP_PIPELINE_INDEX = 7u;
+
+        const std::array<ID3D12PipelineState *, 8> graphics_pipelines = {
+            test_graphics_pipeline.Get(),
+            light_graphics_pipeline.Get(),
+            lit_graphics_pipeline.Get(),
+            skinned_graphics_pipeline.Get(),
+            particle_graphics_pipeline.Get(),
+            terrain_graphics_pipeline.Get(),
+            debug_draw_depth_tested_graphics_pipeline.Get(),
+            debug_draw_on_top_graphics_pipeline.Get(),
+        };
+
+        // The skinned mesh is drawn separately from the meshes of the draw packets, with one instance per character.
+        struct skinned_mesh_t
+        {
+            u32 position_buffer_index{};
+            u32 color_buffer_index{};
+            u32 joint_influence_buffer_index{};
+            nether::float3_t position_offset{};
+            nether::float3_t position_scale{};
+            D3D12_INDEX_BUFFER_VIEW index_buffer_view{};
+            u32 index_count{};
+
+            // Residency handles of the position, color, joint influence and index buffers.
+            std::array<u32, 4> residency_handles{};
+        };
+
+        const skinned_mesh_t tentacle_mesh = {
+            .position_buffer_index = static_geometry_uploader->get_buffer(tentacle_position_buffer_index).srv_index,
+            .color_buffer_index = static_geometry_uploader->get_buffer(tentacle_color_buffer_index).srv_index,
+            .joint_influence_buffer_index =
+                static_geometry_uploader->get_buffer(tentacle_joint_influence_buffer_index).srv_index,
+            .position_offset = tentacle_vertices.position_offset,
+            .position_scale = tentacle_vertices.position_scale,
+            .index_buffer_view =
+                static_geometry_uploader->get_index_buffer_view(tentacle_index_buffer_index, DXGI_FORMAT_R16_UINT),
+            .index_count = static_cast<u32>(tentacle_mesh_data.indices.size()),
+            .residency_handles =
+                {
+                    get_static_buffer_residency_handle(tentacle_position_buffer_index),
+                    get_static_buffer_residency_handle(tentacle_color_buffer_index),
+                    get_static_buffer_residency_handle(tentacle_joint_influence_buffer_index),
+                    get_static_buffer_residency_handle(tentacle_index_buffer_index),
+                },
+        };
+
+        const D3D12_INDEX_BUFFER_VIEW particle_quad_index_buffer_view =
+            static_geometry_uploader->get_index_buffer_view(particle_quad_index_buffer_index, DXGI_FORMAT_R16_UINT);
+        const u32 particle_quad_index_buffer_residency_handle =
+            get_static_buffer_residency_handle(particle_quad_index_buffer_index);
+
+        const D3D12_INDEX_BUFFER_VIEW terrain_patch_index_buffer_view =
+            static_geometry_uploader->get_index_buffer_view(terrain_patch_index_buffer_index, DXGI_FORMAT_R16_UINT);
+        const u32 terrain_patch_index_buffer_residency_handle =
+            get_static_buffer_residency_handle(terrain_patch_index_buffer_index);
 
         ShowWindow(window_handle, SW_SHOW);
 
@@ -649,19 +1680,232 @@ int main()
         // NOTE: Delta time is in seconds.
         f32 delta_time = 0.0f;
 
-        // TODO: Move camera related code into its own cpp / header pair.
-        DirectX::XMVECTOR camera_position = DirectX::XMVectorSet(0.0f, 0.0f, -5.0f, 1.0f);
-        DirectX::XMVECTOR camera_front = DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
-        DirectX::XMVECTOR camera_right{0.0f, 0.0f, 1.0f, 0.0f};
+        // Scene setup. All scene state lives in entities of the ecs world, and is updated by the systems in
+        // scene.hpp.
+        using namespace nether::scene;
+
+        nether::ecs::world_t world{};
+
+        const nether::ecs::entity_t camera_entity = world.create_entity(camera_component_t{
+            .position = {0.0f, 0.0f, -5.0f},
+            .right = {0.0f, 0.0f, 1.0f},
+        });
 
-        f32 pitch = 0.0f;
-        f32 yaw = 0.0f;
-        f32 roll = 0.0f;
+        // The game object (cube).
+        world.create_entity(
+            transform_component_t{
+                .translation = {0.0f, 0.0f, 5.0f},
+            },
+            spin_component_t{
+                .angular_velocity = {1.0f / 120.0f, 1.0f / 70.0f, 0.0f},
+            },
+            mesh_renderer_component_t{
+                .mesh_index = CUBE_MESH_INDEX,
+                .pipeline_index = TEST_PIPELINE_INDEX,
+            },
+            occluder_component_t{});
+
+        // The floor, which is lit by the lights below.
+        world.create_entity(
+            transform_component_t{
+                .translation = {0.0f, -3.0f, 20.0f},
+                .scale = {40.0f, 0.2f, 40.0f},
+            },
+            mesh_renderer_component_t{
+                .mesh_index = CUBE_MESH_INDEX,
+                .pipeline_index = LIT_PIPELINE_INDEX,
+                .color = {0.8f, 0.8f, 0.8f, 1.0f},
+            },
+            occluder_component_t{});
+
+        // The main light, which (like all lights) is rendered as a small cube with the light's color.
+        constexpr nether::float4_t light_color = {1.0f, 1.0f, 1.0f, 1.0f};
+
+        world.create_entity(
+            transform_component_t{
+                .translation = {0.0f, 7.0f, 10.0f},
+                .scale = {0.1f, 0.1f, 0.1f},
+            },
+            point_light_component_t{
+                .color = light_color,
+                .range = 30.0f,
+                .intensity = 40.0f,
+            },
+            mesh_renderer_component_t{
+                .mesh_index = CUBE_MESH_INDEX,
+                .pipeline_index = LIGHT_PIPELINE_INDEX,
+                .color = light_color,
+            });
+
+        // Many small randomly colored point lights scattered just above the floor, to stress the clustered lighting.
+        // The seed is fixed so that the scene is the same on every run.
+        constexpr u32 NUM_RANDOM_POINT_LIGHTS = 1024u;
+
+        std::mt19937 random_engine(42u);
+        std::uniform_real_distribution<f32> position_distribution(-1.0f, 1.0f);
+        std::uniform_real_distribution<f32> color_distribution(0.2f, 1.0f);
+
+        for (u32 i = 0u; i < NUM_RANDOM_POINT_LIGHTS; i++)
+        {
+            const nether::float4_t random_light_color = {color_distribution(random_engine),
+                                                         color_distribution(random_engine),
+                                                         color_distribution(random_engine), 1.0f};
+
+            world.create_entity(
+                transform_component_t{
+                    .translation = {position_distribution(random_engine) * 40.0f,
+                                    -2.5f + (position_distribution(random_engine) + 1.0f) * 0.5f,
+                                    20.0f + position_distribution(random_engine) * 40.0f},
+                    .scale = {0.05f, 0.05f, 0.05f},
+                },
+                point_light_component_t{
+                    .color = random_light_color,
+                    .range = 2.0f,
+                    .intensity = 1.0f,
+                },
+                mesh_renderer_component_t{
+                    .mesh_index = CUBE_MESH_INDEX,
+                    .pipeline_index = LIGHT_PIPELINE_INDEX,
+                    .color = random_light_color,
+                });
+        }
+
+        // A few spot lights pointing down at the floor (the light points along the transform's +z axis, so a pitch
+        // of 90 degrees points it down).
+        constexpr std::array<nether::float4_t, 4> spot_light_colors = {
+            nether::float4_t{1.0f, 0.2f, 0.2f, 1.0f},
+            nether::float4_t{0.2f, 1.0f, 0.2f, 1.0f},
+            nether::float4_t{0.2f, 0.2f, 1.0f, 1.0f},
+            nether::float4_t{1.0f, 1.0f, 0.2f, 1.0f},
+        };
+
+        for (u32 i = 0u; i < spot_light_colors.size(); i++)
+        {
+            world.create_entity(
+                transform_component_t{
+                    .translation = {-12.0f + 8.0f * i, 4.0f, 15.0f},
+                    .rotation = {DirectX::XM_PIDIV2, 0.0f, 0.0f},
+                    .scale = {0.1f, 0.1f, 0.1f},
+                },
+                spot_light_component_t{
+                    .color = spot_light_colors[i],
+                    .range = 15.0f,
+                    .intensity = 60.0f,
+                    .inner_cone_angle = 0.25f,
+                    .outer_cone_angle = 0.4f,
+                },
+                mesh_renderer_component_t{
+                    .mesh_index = CUBE_MESH_INDEX,
+                    .pipeline_index = LIGHT_PIPELINE_INDEX,
+                    .color = spot_light_colors[i],
+                });
+        }
+
+        // A grid of animated characters on the floor, each blending the sway and twist clips (the blend weights vary
+        // across the grid, and the clips start at random times). Characters are not ecs entities, as their sampling
+        // contexts are not trivially copyable. They are not occlusion culled.
+        std::vector<nether::animated_character_t> animated_characters(NUM_ANIMATED_CHARACTERS);
+        {
+            std::mt19937 random_engine(40u);
+            std::uniform_real_distribution<f32> unit_distribution(0.0f, 1.0f);
+
+            for (u32 z = 0u; z < NUM_ANIMATED_CHARACTERS_Z; z++)
+            {
+                for (u32 x = 0u; x < NUM_ANIMATED_CHARACTERS_X; x++)
+                {
+                    const f32 sway_weight = (x + 0.5f) / NUM_ANIMATED_CHARACTERS_X;
+
+                    nether::animated_character_t &character = animated_characters[z * NUM_ANIMATED_CHARACTERS_X + x];
+                    character.num_layers = 2u;
+                    character.layers[0].clip = &animation_clips[SWAY_CLIP_INDEX];
+                    character.layers[0].time_in_s =
+                        unit_distribution(random_engine) * animation_clips[SWAY_CLIP_INDEX].get_duration_in_s();
+                    character.layers[0].weight = sway_weight;
+                    character.layers[1].clip = &animation_clips[TWIST_CLIP_INDEX];
+                    character.layers[1].time_in_s =
+                        unit_distribution(random_engine) * animation_clips[TWIST_CLIP_INDEX].get_duration_in_s();
+                    character.layers[1].weight = 1.0f - sway_weight;
+                    character.world_matrix = nether::translation_matrix({-15.0f + 2.0f * x, -2.8f, 5.0f + 2.0f * z});
+                }
+            }
+        }
+
+        nether::animation_statistics_t animation_statistics{};
+        u32 num_particle_vertices = 0u;
+
+        nether::ecs::query_t spin_query = world.create_query<transform_component_t, spin_component_t>();
+        nether::ecs::query_t transform_query = world.create_query<transform_component_t>();
+        nether::ecs::query_t mesh_renderer_query =
+            world.create_query<transform_component_t, mesh_renderer_component_t>();
+        nether::ecs::query_t point_light_query = world.create_query<transform_component_t, point_light_component_t>();
+        nether::ecs::query_t spot_light_query = world.create_query<transform_component_t, spot_light_component_t>();
+        nether::ecs::query_t occluder_query =
+            world.create_query<transform_component_t, mesh_renderer_component_t, occluder_component_t>();
+
+        // Every mesh renderer keeps its record of the GPU scene for its whole lifetime. The records are written every
+        // frame, once the transforms are up to date.
+        world.for_each<transform_component_t, mesh_renderer_component_t>(
+            mesh_renderer_query,
+            [&](const nether::ecs::entity_t, const transform_component_t &, mesh_renderer_component_t &mesh_renderer) {
+                mesh_renderer.gpu_scene_object_index = gpu_scene.add_object({});
+            });
+
+        // CPU phases of a frame (in frame order), timed by the frame statistics. The update phase includes the UI,
+        // input and the scene update, and the present phase includes waiting for the next back buffer to be free.
+        constexpr u32 UPDATE_PHASE = 0u;
+        constexpr u32 LIGHTING_PHASE = 1u;
+        constexpr u32 CULLING_PHASE = 2u;
+        constexpr u32 RECORDING_PHASE = 3u;
+        constexpr u32 TRANSLATION_PHASE = 4u;
+        constexpr u32 SUBMISSION_PHASE = 5u;
+        constexpr u32 PRESENT_PHASE = 6u;
+
+        static constexpr std::array<std::string_view, 7> frame_phase_names = {
+            "update", "lighting", "culling", "recording", "translation", "submission", "present",
+        };
+
+        // Frame and phase times are exported every second to the telemetry directory (frame_statistics.csv has a row
+        // per frame, and frame_statistics.json the percentiles of the last second and of the whole run).
+        nether::frame_statistics_t frame_statistics(frame_phase_names,
+                                                    {
+                                                        .window_time_in_s = 1.0f,
+                                                        .hitch_ratio = 2.0f,
+                                                        .export_directory = "telemetry",
+                                                    },
+                                                    &job_system);
+
+        // Memory snapshots are taken every frame, and the last 120 frames are exported every second to the telemetry
+        // directory (memory_telemetry.json), with the sampled allocation callstacks (debug builds only).
+        nether::memory::set_callstack_sampling_interval(NETHER_DEBUG ? 1024u : 0u);
+        nether::memory::memory_telemetry_t memory_telemetry(
+            {
+                .history_size = 120u,
+                .export_interval_in_frames = 60u,
+                .export_directory = "telemetry",
+            },
+            &job_system);
+
+        // What the debug draw visualizes (toggled in the debug draw window). The frozen frustum is the view frustum
+        // of the camera when it was frozen, to see what the culling does from another point of view.
+        bool debug_draw_object_bounds = false;
+        bool debug_draw_light_ranges = false;
+        bool debug_draw_frozen_frustum = false;
+        std::optional<camera_component_t> frozen_camera{};
 
         u64 frame_index = 0u;
         bool quit = false;
         while (!quit)
         {
+            // Allocations of the frame loop's thread are render allocations (ImGui's are UI allocations).
+            const nether::memory::memory_tag_scope_t frame_tag_scope(nether::memory::memory_tag_t::render);
+
+            frame_arenas.begin_frame(current_swapchain_backbuffer_index);
+            nether::memory::linear_arena_t &frame_arena = frame_arenas.get_current_arena();
+
+            // Per frame lists are reserved up front (every entity is at most one light / draw packet), as a vector
+            // that grows in an arena leaves its previous buffers behind until the arena is reset.
+            const u32 num_entities = world.get_num_entities();
+
             // Start the Dear ImGui frame
             ImGui_ImplDX12_NewFrame();
             ImGui_ImplWin32_NewFrame();
@@ -669,18 +1913,178 @@ int main()
 
             ImGui::ShowDemoWindow();
 
-            using namespace DirectX;
+            ImGui::Begin("Renderer statistics");
+            ImGui::Text("Instancing : %u draw packets -> %u draw calls", instance_batcher.statistics.num_draw_packets,
+                        instance_batcher.statistics.num_instanced_draws);
+            ImGui::Text("GPU scene : %u objects, %u changed -> %u copies (%.1f KiB), %.3f ms",
+                        gpu_scene.statistics.num_objects, gpu_scene.statistics.num_dirty_objects,
+                        gpu_scene.statistics.num_uploads, gpu_scene.statistics.num_uploaded_bytes / 1024.0f,
+                        gpu_scene.statistics.upload_time_in_ms);
+
+            const nether::occlusion_statistics_t &occlusion_statistics = occlusion_culler.statistics;
+            const u32 num_culled = occlusion_statistics.num_outside_frustum + occlusion_statistics.num_occluded;
+            ImGui::Text("Culling : %u / %u objects culled (%.1f%%), %u frustum, %u occluded", num_culled,
+                        occlusion_statistics.num_occludees_tested,
+                        occlusion_statistics.num_occludees_tested
+                            ? 100.0f * num_culled / occlusion_statistics.num_occludees_tested
+                            : 0.0f,
+                        occlusion_statistics.num_outside_frustum, occlusion_statistics.num_occluded);
+            ImGui::Text("Occlusion : %u occluders (%u triangles), rasterization %.3f ms, tests %.3f ms",
+                        occlusion_statistics.num_occluders, occlusion_statistics.num_rasterized_triangles,
+                        occlusion_statistics.rasterization_time_in_ms, occlusion_statistics.test_time_in_ms);
+
+            const nether::clustered_lighting_statistics_t &lighting_statistics = light_cluster_builder.statistics;
+            ImGui::Text("Clustered lighting : %u lights, %u light indices (max %u per cluster, %u dropped), binning "
+                        "%.3f ms",
+                        lighting_statistics.num_lights, lighting_statistics.num_light_indices,
+                        lighting_statistics.max_lights_per_cluster, lighting_statistics.num_dropped_light_indices,
+                        lighting_statistics.binning_time_in_ms);
+
+            const nether::residency_statistics_t &residency_statistics = residency_manager->get_statistics();
+            ImGui::Text("Residency : %u / %u resources resident (%.1f MiB), budget %.1f MiB, hit rate %.1f%%, %llu "
+                        "evictions",
+                        residency_statistics.num_resident_resources, residency_statistics.num_resources,
+                        residency_statistics.resident_bytes / (1024.0f * 1024.0f),
+                        residency_statistics.budget_bytes / (1024.0f * 1024.0f),
+                        100.0 * residency_statistics.get_hit_rate(),
+                        static_cast<unsigned long long>(residency_statistics.num_evictions));
+
+            // peak_used is kept across resets, so this is the highest usage of any frame that used this slot.
+            const nether::memory::arena_statistics_t frame_arena_statistics = frame_arena.get_statistics();
+            ImGui::Text("Frame arena : peak %.1f KiB of %.1f KiB", frame_arena_statistics.peak_used / 1024.0f,
+                        frame_arena_statistics.capacity / 1024.0f);
+
+            const nether::command_translation_statistics_t &translation_statistics = command_translator->statistics;
+            ImGui::Text("Command streams : %u commands -> %u command lists, translation %.3f ms",
+                        translation_statistics.num_commands, translation_statistics.num_command_lists,
+                        translation_statistics.translation_time_in_ms);
+            ImGui::Text("Animation : %u characters, %u skinning matrices, %.3f ms", animation_statistics.num_characters,
+                        animation_statistics.num_skinning_matrices, animation_statistics.animation_time_in_ms);
+            ImGui::Text("Particles : %u emitters, %u particles (%u emitted, %u killed), simulation %.3f ms, write %.3f "
+                        "ms",
+                        particle_system.statistics.num_emitters, particle_system.statistics.num_particles,
+                        particle_system.statistics.num_emitted_particles,
+                        particle_system.statistics.num_killed_particles,
+                        particle_system.statistics.simulation_time_in_ms, particle_system.statistics.write_time_in_ms);
+            ImGui::Text("Terrain : %u patches (%u nodes visited), %u / %u tiles resident, %u loaded (%.1f KiB), %u "
+                        "evicted, selection %.3f ms, streaming %.3f ms",
+                        terrain->statistics.num_patches, terrain->statistics.num_visited_nodes,
+                        terrain->statistics.num_resident_tiles, terrain_settings.cache_capacity_in_tiles,
+                        terrain->statistics.num_loaded_tiles, terrain->statistics.num_loaded_bytes / 1024.0f,
+                        terrain->statistics.num_evicted_tiles, terrain->statistics.selection_time_in_ms,
+                        terrain->statistics.streaming_time_in_ms);
+            ImGui::End();
+
+            ImGui::Begin("Frame statistics");
+            ImGui::Text("Frame time : %.3f ms (%.1f fps), %llu hitches", frame_statistics.get_last_frame_time_in_ms(),
+                        1000.0f / std::max(frame_statistics.get_last_frame_time_in_ms(), 0.001f),
+                        static_cast<unsigned long long>(frame_statistics.get_num_hitches()));
+
+            const std::span<const f32> frame_time_history = frame_statistics.get_frame_time_history();
+            ImGui::PlotLines("##frame_time_history", frame_time_history.data(),
+                             static_cast<int>(frame_time_history.size()),
+                             static_cast<int>(frame_statistics.get_frame_time_history_offset()), nullptr, 0.0f, FLT_MAX,
+                             ImVec2(0.0f, 80.0f));
+
+            // Percentiles of the last second.
+            if (ImGui::BeginTable("frame_statistics_table", 6, ImGuiTableFlags_Borders))
+            {
+                for (const char *const column_name : {"(ms)", "mean", "p50", "p95", "p99", "max"})
+                {
+                    ImGui::TableSetupColumn(column_name);
+                }
+                ImGui::TableHeadersRow();
 
-            const f32 camera_movement_speed = 20.0f * delta_time;
-            const f32 camera_rotation_speed = 1.5f * delta_time;
+                for (u32 i = 0u; i <= frame_statistics.get_num_phases(); i++)
+                {
+                    const nether::duration_summary_t &summary = frame_statistics.get_window_summary(i);
+                    const std::string_view name = i == 0u ? "frame" : frame_statistics.get_phase_name(i - 1u);
+
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.*s", static_cast<int>(name.size()), name.data());
+                    for (const f32 value : {summary.mean_in_ms, summary.p50_in_ms, summary.p95_in_ms,
+                                            summary.p99_in_ms, summary.max_in_ms})
+                    {
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.3f", value);
+                    }
+                }
+
+                ImGui::EndTable();
+            }
+
+            for (const nether::frame_hitch_t &hitch : frame_statistics.get_recent_hitches())
+            {
+                ImGui::Text("Hitch : frame %llu, %.3f ms (median %.3f ms)",
+                            static_cast<unsigned long long>(hitch.frame_index), hitch.frame_time_in_ms,
+                            hitch.reference_time_in_ms);
+            }
+            ImGui::End();
+
+            // Live CPU and GPU memory per tag, and the allocations of the last frame (which should be close to 0 for
+            // every tag once the scene is loaded).
+            ImGui::Begin("Memory");
+            if (ImGui::BeginTable("memory_table", 7, ImGuiTableFlags_Borders))
+            {
+                for (const char *const column_name : {"tag", "live (KiB)", "live allocations", "frame allocations",
+                                                      "frame (KiB)", "GPU default (MiB)", "GPU upload (MiB)"})
+                {
+                    ImGui::TableSetupColumn(column_name);
+                }
+                ImGui::TableHeadersRow();
+
+                const nether::memory::memory_snapshot_t &memory_snapshot = memory_telemetry.get_last_snapshot();
+                for (u32 i = 0u; i < nether::memory::NUM_MEMORY_TAGS; i++)
+                {
+                    const std::string_view name =
+                        nether::memory::get_memory_tag_name(static_cast<nether::memory::memory_tag_t>(i));
+                    const nether::memory::cpu_memory_counters_t &cpu_counters = memory_snapshot.cpu[i];
+                    const nether::memory::memory_churn_t &churn = memory_telemetry.statistics.frame_churn[i];
+
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.*s", static_cast<int>(name.size()), name.data());
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.1f", cpu_counters.live_bytes / 1024.0f);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", static_cast<unsigned long long>(cpu_counters.live_allocations));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", static_cast<unsigned long long>(churn.num_allocations));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.1f", churn.allocated_bytes / 1024.0f);
+
+                    for (const nether::memory::gpu_heap_type_t heap_type :
+                         {nether::memory::gpu_heap_type_t::device_local, nether::memory::gpu_heap_type_t::upload})
+                    {
+                        const u64 live_bytes = memory_snapshot.gpu[i][static_cast<u32>(heap_type)].live_bytes;
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.1f", live_bytes / (1024.0f * 1024.0f));
+                    }
+                }
 
-            static DirectX::XMVECTOR camera_move_to_position = {};
+                ImGui::EndTable();
+            }
+
+            ImGui::Text("Snapshot : %.3f ms", memory_telemetry.statistics.snapshot_time_in_ms);
+            ImGui::End();
+
+            ImGui::Begin("Debug draw");
+            ImGui::Checkbox("Object bounds (green visible, red culled)", &debug_draw_object_bounds);
+            ImGui::Checkbox("Light ranges", &debug_draw_light_ranges);
+            ImGui::Checkbox("Freeze view frustum", &debug_draw_frozen_frustum);
+            ImGui::Text("%u depth tested lines, %u on top lines (%u dropped), %u threads, write %.3f ms",
+                        debug_draw.statistics.num_lines[0], debug_draw.statistics.num_lines[1],
+                        debug_draw.statistics.num_dropped_lines, debug_draw.statistics.num_threads,
+                        debug_draw.statistics.write_time_in_ms);
+            ImGui::End();
+
+            camera_component_t &camera = *world.get_component<camera_component_t>(camera_entity);
 
-            DirectX::XMVECTOR move_to = {};
+            const f32 camera_movement_speed = 20.0f * delta_time;
+            const f32 camera_rotation_speed = 1.5f * delta_time;
 
-            static f32 pitch_to = 0.0f;
-            static f32 yaw_to = 0.0f;
-            static f32 roll_to = 0.0f;
+            nether::float3_t move_to = {};
 
             MSG message = {};
             while (PeekMessageW(&message, 0, 0, 0, PM_REMOVE))
@@ -696,39 +2100,39 @@ int main()
 
                     if (message.wParam == 'W')
                     {
-                        move_to += camera_front;
+                        move_to = move_to + camera.front;
                     }
 
                     if (message.wParam == 'S')
                     {
-                        move_to -= camera_front;
+                        move_to = move_to - camera.front;
                     }
 
                     if (message.wParam == 'A')
                     {
-                        move_to -= camera_right;
+                        move_to = move_to - camera.right;
                     }
 
                     if (message.wParam == 'D')
                     {
-                        move_to += camera_right;
+                        move_to = move_to + camera.right;
                     }
 
                     if (message.wParam == VK_UP)
                     {
-                        pitch_to -= camera_rotation_speed;
+                        camera.target_pitch -= camera_rotation_speed;
                     }
                     if (message.wParam == VK_DOWN)
                     {
-                        pitch_to += camera_rotation_speed;
+                        camera.target_pitch += camera_rotation_speed;
                     }
                     if (message.wParam == VK_LEFT)
                     {
-                        yaw_to -= camera_rotation_speed;
+                        camera.target_yaw -= camera_rotation_speed;
                     }
                     if (message.wParam == VK_RIGHT)
                     {
-                        yaw_to += camera_rotation_speed;
+                        camera.target_yaw += camera_rotation_speed;
                     }
                 }
                 };
@@ -736,161 +2140,565 @@ int main()
                 DispatchMessage(&message);
             }
 
-            camera_move_to_position = DirectX::XMVectorLerp(
-                camera_move_to_position, DirectX::XMVector3Normalize(move_to) * camera_movement_speed, 0.02f);
+            update_camera(camera, move_to, camera_movement_speed);
+
+            // Update the scene objects.
+            update_spin(world, spin_query);
+            update_transforms(job_system, world, transform_query);
+
+            // Animate the characters, writing their skinning matrices straight into this back buffer's upload buffer.
+            for (nether::animated_character_t &character : animated_characters)
+            {
+                for (u32 i = 0u; i < character.num_layers; i++)
+                {
+                    nether::animation_layer_t &layer = character.layers[i];
+                    layer.time_in_s = std::fmod(layer.time_in_s + delta_time, layer.clip->get_duration_in_s());
+                }
+            }
+
+            nether::float4x4_t *const skinning_matrices = reinterpret_cast<nether::float4x4_t *>(
+                skinning_matrix_buffer_creation_results[current_swapchain_backbuffer_index].ptr);
+            animation_statistics =
+                nether::animate_characters(tentacle_skeleton, animated_characters,
+                                           std::span(skinning_matrices, NUM_ANIMATED_CHARACTERS * TENTACLE_NUM_JOINTS),
+                                           &job_system);
+
+            // Simulate the particles, and write them straight into this back buffer's upload buffer.
+            particle_system.update(delta_time, &job_system);
+
+            nether::particle_vertex_t *const particle_vertices = reinterpret_cast<nether::particle_vertex_t *>(
+                particle_buffer_creation_results[current_swapchain_backbuffer_index].ptr);
+            num_particle_vertices = particle_system.write_vertices(
+                std::span(particle_vertices, particle_system.get_max_particles()), &job_system);
+
+            // Gather the world space lights of the scene.
+            std::pmr::vector<nether::light_t> lights(&frame_arena);
+            lights.reserve(num_entities);
+
+            world.for_each<transform_component_t, point_light_component_t>(
+                point_light_query, [&](const nether::ecs::entity_t, const transform_component_t &transform,
+                                       const point_light_component_t &point_light) {
+                    lights.push_back({
+                        .position = transform.translation,
+                        .range = point_light.range,
+                        .color = nether::float3_t{point_light.color.x, point_light.color.y, point_light.color.z} *
+                                 point_light.intensity,
+                        .type = nether::light_type_t::point,
+                    });
+                });
+
+            world.for_each<transform_component_t, spot_light_component_t>(
+                spot_light_query, [&](const nether::ecs::entity_t, const transform_component_t &transform,
+                                      const spot_light_component_t &spot_light) {
+                    const nether::float4x4_t &model_matrix = transform.model_matrix;
+
+                    lights.push_back({
+                        .position = transform.translation,
+                        .range = spot_light.range,
+                        .color = nether::float3_t{spot_light.color.x, spot_light.color.y, spot_light.color.z} *
+                                 spot_light.intensity,
+                        .type = nether::light_type_t::spot,
+                        .direction = nether::normalize(
+                            {model_matrix.m[2][0], model_matrix.m[2][1], model_matrix.m[2][2]}),
+                        .spot_cos_outer_angle = std::cos(spot_light.outer_cone_angle),
+                        .spot_cos_inner_angle = std::cos(spot_light.inner_cone_angle),
+                    });
+                });
+
+            if (lights.size() > MAX_LIGHTS)
+            {
+                lights.resize(MAX_LIGHTS);
+            }
 
-            pitch = std::lerp(pitch, pitch_to, 0.02f);
-            yaw = std::lerp(yaw, yaw_to, 0.02f);
-            roll = std::lerp(roll, roll_to, 0.02f);
+            const f32 window_aspect_ratio = (f32)CLIENT_WIDTH / (f32)CLIENT_HEIGHT;
+            const f32 near_plane = 0.1f;
 
-            camera_position += camera_move_to_position;
+            const nether::float4x4_t projection_matrix =
+                nether::perspective_reverse_z_matrix(nether::to_radians(45.0f), window_aspect_ratio, near_plane);
+            const nether::float4x4_t view_matrix = get_view_matrix(camera);
+
+            frame_statistics.end_phase(UPDATE_PHASE);
+
+            // Bin the lights into the clusters of the view frustum, and upload the lights and the clusters.
+            constexpr f32 MAX_LIGHT_CLUSTER_DEPTH = 500.0f;
+
+            light_cluster_builder.set_projection(projection_matrix.m[0][0], projection_matrix.m[1][1], near_plane,
+                                                 MAX_LIGHT_CLUSTER_DEPTH);
+            light_cluster_builder.build(lights, view_matrix, &job_system);
+
+            const upload_buffer_creation_result_t &light_buffer_creation_result =
+                light_buffer_creation_results[current_swapchain_backbuffer_index];
+            const upload_buffer_creation_result_t &light_cluster_buffer_creation_result =
+                light_cluster_buffer_creation_results[current_swapchain_backbuffer_index];
+            const upload_buffer_creation_result_t &light_index_buffer_creation_result =
+                light_index_buffer_creation_results[current_swapchain_backbuffer_index];
+
+            std::memcpy(light_buffer_creation_result.ptr, lights.data(), lights.size() * sizeof(nether::light_t));
+            std::memcpy(light_cluster_buffer_creation_result.ptr, light_cluster_builder.clusters.data(),
+                        light_cluster_builder.clusters.size() * sizeof(nether::light_cluster_t));
+            std::memcpy(light_index_buffer_creation_result.ptr, light_cluster_builder.light_indices.data(),
+                        light_cluster_builder.light_indices.size() * sizeof(u32));
+
+            constant_buffer_creation_result_t<scene_buffer_t> &scene_constant_buffer_creation_result =
+                scene_constant_buffer_creation_results[current_swapchain_backbuffer_index];
+
+            scene_constant_buffer_creation_result.data = {
+                .view_projection_matrix = nether::to_xmmatrix(view_matrix * projection_matrix),
+                .light_buffer_index = light_buffer_creation_result.srv_index,
+                .light_cluster_buffer_index = light_cluster_buffer_creation_result.srv_index,
+                .light_index_buffer_index = light_index_buffer_creation_result.srv_index,
+                .num_lights = static_cast<u32>(lights.size()),
+                .num_clusters = {light_cluster_builder.num_clusters_x, light_cluster_builder.num_clusters_y,
+                                 light_cluster_builder.num_clusters_z},
+                .near_plane = near_plane,
+                .cluster_size_in_pixels = {(f32)CLIENT_WIDTH / light_cluster_builder.num_clusters_x,
+                                           (f32)CLIENT_HEIGHT / light_cluster_builder.num_clusters_y},
+                .depth_slice_scale = light_cluster_builder.get_depth_slice_scale(),
+                .depth_slice_bias = light_cluster_builder.get_depth_slice_bias(),
+            };
 
-            // The front vector is modified by yaw pitch roll.
-            DirectX::XMMATRIX rotation_matrix = DirectX::XMMatrixRotationRollPitchYaw(pitch, yaw, roll);
+            memcpy(scene_constant_buffer_creation_result.ptr, &scene_constant_buffer_creation_result.data,
+                   sizeof(scene_buffer_t));
 
-            camera_front = DirectX::XMVector3Normalize(
-                DirectX::XMVector3TransformCoord(DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), rotation_matrix));
+            frame_statistics.end_phase(LIGHTING_PHASE);
+
+            // Select the terrain patches for the view, and stream the tiles the selection was missing (which are used
+            // from the next frame on).
+            terrain->select_patches(nether::terrain_view_t{
+                .camera_position = camera.position,
+                .frustum = nether::get_frustum(view_matrix * projection_matrix),
+                .screen_space_error_scale =
+                    nether::get_screen_space_error_scale(projection_matrix, static_cast<f32>(CLIENT_HEIGHT)),
+            });
+            terrain->stream_tiles(&job_system);
+
+            std::memcpy(terrain_patch_buffer_creation_results[current_swapchain_backbuffer_index].ptr,
+                        terrain->patches.data(), terrain->patches.size() * sizeof(nether::terrain_patch_t));
+
+            // Rasterize the occluders, then test the world space bounds of every scene object against the occluders
+            // and the frustum.
+            occlusion_culler.begin_frame(
+                nether::to_float4x4(scene_constant_buffer_creation_result.data.view_projection_matrix));
+
+            world.for_each<transform_component_t, mesh_renderer_component_t>(
+                occluder_query, [&](const nether::ecs::entity_t, const transform_component_t &transform,
+                                    const mesh_renderer_component_t &mesh_renderer) {
+                    const mesh_t &mesh = meshes[mesh_renderer.mesh_index];
+                    occlusion_culler.add_occluder(mesh.positions, mesh.indices, transform.model_matrix);
+                });
+
+            occlusion_culler.rasterize(&job_system);
+
+            // Draw packets of the scene objects, and their world space bounds, before occlusion culling. The GPU scene
+            // records of the objects that moved (or changed color) are marked for upload.
+            std::pmr::vector<nether::draw_packet_t> candidate_draw_packets(&frame_arena);
+            std::pmr::vector<nether::aabb_t> candidate_bounds(&frame_arena);
+            std::pmr::vector<u8> candidate_visibility(&frame_arena);
+
+            candidate_draw_packets.reserve(num_entities);
+            candidate_bounds.reserve(num_entities);
+
+            world.for_each<transform_component_t, mesh_renderer_component_t>(
+                mesh_renderer_query, [&](const nether::ecs::entity_t, const transform_component_t &transform,
+                                         const mesh_renderer_component_t &mesh_renderer) {
+                    gpu_scene.update_object(mesh_renderer.gpu_scene_object_index,
+                                            {.model_matrix = transform.model_matrix, .color = mesh_renderer.color});
+
+                    candidate_draw_packets.push_back({
+                        .mesh_index = mesh_renderer.mesh_index,
+                        .pipeline_index = mesh_renderer.pipeline_index,
+                        .material_index = mesh_renderer.material_index,
+                        .object_index = mesh_renderer.gpu_scene_object_index,
+                    });
+                    candidate_bounds.push_back(
+                        nether::transform_aabb(meshes[mesh_renderer.mesh_index].bounds, transform.model_matrix));
+                });
+
+            candidate_visibility.resize(candidate_bounds.size());
+            occlusion_culler.test_occludees(candidate_bounds, candidate_visibility, &job_system);
+
+            // Debug visualization of the culling and of the lights. The bounds are drawn in parallel, as debug lines
+            // can be drawn from any thread.
+            if (debug_draw_object_bounds)
+            {
+                job_system.parallel_for(
+                    static_cast<u32>(candidate_bounds.size()), 256u, [&](const u32 begin, const u32 end, const u32) {
+                        for (u32 i = begin; i < end; i++)
+                        {
+                            debug_draw.draw_box(candidate_bounds[i], candidate_visibility[i]
+                                                                         ? nether::make_debug_color(0u, 255u, 0u)
+                                                                         : nether::make_debug_color(255u, 0u, 0u));
+                        }
+                    });
+            }
 
-            camera_right = DirectX::XMVector3Normalize(
-                DirectX::XMVector3TransformCoord(DirectX::XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), rotation_matrix));
+            if (debug_draw_light_ranges)
+            {
+                for (const nether::light_t &light : lights)
+                {
+                    debug_draw.draw_sphere(light.position, light.range, nether::make_debug_color(255u, 255u, 0u));
+                }
+            }
 
-            DirectX::XMVECTOR camera_up =
-                DirectX::XMVector3Normalize(DirectX::XMVector3Cross(camera_front, camera_right));
+            if (debug_draw_frozen_frustum)
+            {
+                if (!frozen_camera)
+                {
+                    frozen_camera = camera;
+                }
 
-            // Update constant buffer's and other scene parameter.
-            transform_constant_buffer_creation_result.data.model_matrix =
-                DirectX::XMMatrixRotationX(frame_index / 120.0f) * DirectX::XMMatrixRotationY(frame_index / 70.0f) *
-                DirectX::XMMatrixTranslation(0.0f, 0.0f, 5.0f);
+                debug_draw.draw_frustum(frozen_camera->position, frozen_camera->front,
+                                        nether::cross(frozen_camera->front, frozen_camera->right),
+                                        nether::to_radians(45.0f), window_aspect_ratio, near_plane, 100.0f,
+                                        nether::make_debug_color(0u, 255u, 255u), nether::debug_draw_mode_t::on_top);
+            }
+            else
+            {
+                frozen_camera.reset();
+            }
 
-            const auto light_translation = scene_constant_buffer_creation_result.data.light_position;
+            nether::debug_line_t *const debug_lines = reinterpret_cast<nether::debug_line_t *>(
+                debug_line_buffer_creation_results[current_swapchain_backbuffer_index].ptr);
+            const std::array<nether::debug_line_range_t, nether::NUM_DEBUG_DRAW_MODES> debug_line_ranges =
+                debug_draw.write_lines(std::span(debug_lines, MAX_DEBUG_LINES), &job_system);
 
-            light_transform_constant_buffer_creation_result.data.model_matrix =
-                DirectX::XMMatrixScaling(0.1f, 0.1f, 0.1f) *
-                DirectX::XMMatrixTranslation(light_translation.x, light_translation.y, light_translation.z);
+            frame_statistics.end_phase(CULLING_PHASE);
 
-            const DirectX::XMVECTOR target_vector = camera_position + camera_front;
+            // Submit draw packets for the visible scene objects, which are grouped into instanced draws by the
+            // batcher.
+            instance_batcher.reset();
 
-            const float window_aspect_ratio = (f32)CLIENT_WIDTH / (f32)CLIENT_HEIGHT;
+            for (size_t i = 0u; i < candidate_draw_packets.size(); i++)
+            {
+                if (candidate_visibility[i])
+                {
+                    instance_batcher.add_draw_packet(candidate_draw_packets[i]);
+                }
+            }
 
-            // Article followed for reverse Z:
-            //  https://iolite-engine.com/blog_posts/reverse_z_cheatsheet
+            const upload_buffer_creation_result_t &instance_buffer_creation_result =
+                instance_buffer_creation_results[current_swapchain_backbuffer_index];
 
-            // https://github.com/microsoft/DirectXMath/issues/158 link that shows the projection matrix for infinite
-            // far plane. Note : This code is taken from the directxmath source code for perspective projection fov lh,
-            // but modified for infinite far plane.
+            u32 *const instance_object_indices = reinterpret_cast<u32 *>(instance_buffer_creation_result.ptr);
 
-            f32 sin_fov{};
-            f32 cos_fov{};
-            DirectX::XMScalarSinCos(&sin_fov, &cos_fov, 0.5f * DirectX::XMConvertToRadians(45.0f));
-            const f32 height = cos_fov / sin_fov;
-            const f32 width = height / window_aspect_ratio;
+            const std::span<const nether::instanced_draw_t> instanced_draws =
+                instance_batcher.build(std::span(instance_object_indices, MAX_INSTANCES));
 
-            const f32 near_plane = 0.1f;
-            const DirectX::XMMATRIX projection_matrix =
-                DirectX::XMMatrixSet(width, 0.0f, 0.0f, 0.0f, 0.0f, height, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f,
-                                     0.0f, near_plane, 0.0f);
+            // Write the GPU scene records that changed into this back buffer's part of the staging ring.
+            const u64 gpu_scene_staging_offset = current_swapchain_backbuffer_index * GPU_SCENE_STAGING_SIZE;
+            const std::span<const nether::gpu_scene_upload_t> gpu_scene_uploads = gpu_scene.write_uploads(
+                std::span(gpu_scene_staging_buffer_creation_result.ptr + gpu_scene_staging_offset,
+                          GPU_SCENE_STAGING_SIZE),
+                &job_system);
 
-            scene_constant_buffer_creation_result.data.view_projection_matrix =
-                DirectX::XMMatrixLookAtLH(camera_position, target_vector, camera_up) * projection_matrix;
+            // Record the command streams.
+            for (u32 i = 0u; i < NUM_COMMAND_STREAMS; i++)
+            {
+                command_stream_arenas[i]->reset();
+                command_streams[i].reset();
+            }
 
-            memcpy(transform_constant_buffer_creation_result.ptr, &transform_constant_buffer_creation_result.data,
-                   sizeof(transform_buffer_t));
+            // Transition the swapchain backbuffer from a presentable format to render target view, and clear it.
+            nether::command_stream_t &frame_setup_command_stream = command_streams[0];
+            frame_setup_command_stream.resource_barrier(BACK_BUFFER_RESOURCE_INDEX, nether::resource_state_t::present,
+                                                        nether::resource_state_t::render_target);
+            frame_setup_command_stream.clear_render_target({0.0f, 0.0f, 0.0f, 1.0f});
+            frame_setup_command_stream.clear_depth(0.0f);
 
-            memcpy(light_transform_constant_buffer_creation_result.ptr,
-                   &light_transform_constant_buffer_creation_result.data, sizeof(transform_buffer_t));
+            // Copy the changed records into the GPU scene buffer, before any draw reads it. Buffers decay to the
+            // common state at the end of every ExecuteCommandLists, so the buffer starts every frame in that state.
+            if (!gpu_scene_uploads.empty())
+            {
+                frame_setup_command_stream.resource_barrier(GPU_SCENE_BUFFER_RESOURCE_INDEX,
+                                                            nether::resource_state_t::common,
+                                                            nether::resource_state_t::copy_destination);
 
-            memcpy(scene_constant_buffer_creation_result.ptr, &scene_constant_buffer_creation_result.data,
-                   sizeof(scene_buffer_t));
+                for (const nether::gpu_scene_upload_t &upload : gpu_scene_uploads)
+                {
+                    frame_setup_command_stream.copy_buffer_region(
+                        GPU_SCENE_BUFFER_RESOURCE_INDEX, upload.destination_offset,
+                        GPU_SCENE_STAGING_BUFFER_RESOURCE_INDEX, gpu_scene_staging_offset + upload.staging_offset,
+                        upload.size);
+                }
 
-            // Reset command allocator and list for current frame.
-            throw_if_failed(direct_command_allocators[current_swapchain_backbuffer_index]->Reset());
-            throw_if_failed(graphics_command_list->Reset(
-                direct_command_allocators[current_swapchain_backbuffer_index].Get(), nullptr));
+                frame_setup_command_stream.resource_barrier(GPU_SCENE_BUFFER_RESOURCE_INDEX,
+                                                            nether::resource_state_t::copy_destination,
+                                                            nether::resource_state_t::shader_resource);
+            }
 
-            graphics_command_list->OMSetRenderTargets(1u,
-                                                      &back_buffers[current_swapchain_backbuffer_index].cpu_rtv_handle,
-                                                      false, &depth_buffer.cpu_dsv_handle);
+            // The animated characters, in a single instanced draw.
+            struct skinned_render_resources_t
+            {
+                nether::float3_t position_offset{};
+                u32 position_buffer_index{};
+                nether::float3_t position_scale{};
+                u32 color_buffer_index{};
+                u32 joint_influence_buffer_index{};
+                u32 skinning_matrix_buffer_index{};
+                u32 scene_constant_buffer_index{};
+                u32 num_joints{};
+            };
 
-            // Transition the swapchain backbuffer from a presentable format to render target view.
-            const D3D12_RESOURCE_BARRIER backbuffer_present_to_render_target = {
-                .Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION,
-                .Transition =
-                    {
-                        .pResource = back_buffers[current_swapchain_backbuffer_index].resource.Get(),
-                        .Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
-                        .StateBefore = D3D12_RESOURCE_STATE_PRESENT,
-                        .StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET,
-                    },
+            const skinned_render_resources_t skinned_render_resources = {
+                .position_offset = tentacle_mesh.position_offset,
+                .position_buffer_index = tentacle_mesh.position_buffer_index,
+                .position_scale = tentacle_mesh.position_scale,
+                .color_buffer_index = tentacle_mesh.color_buffer_index,
+                .joint_influence_buffer_index = tentacle_mesh.joint_influence_buffer_index,
+                .skinning_matrix_buffer_index =
+                    skinning_matrix_buffer_creation_results[current_swapchain_backbuffer_index].srv_index,
+                .scene_constant_buffer_index = scene_constant_buffer_creation_result.cbv_index,
+                .num_joints = TENTACLE_NUM_JOINTS,
             };
-            graphics_command_list->ResourceBarrier(1u, &backbuffer_present_to_render_target);
 
-            const std::array<f32, 4> clear_color{0.0f, 0.0f, 0.0f, 1.0f};
+            frame_setup_command_stream.set_pipeline(SKINNED_PIPELINE_INDEX);
+            frame_setup_command_stream.set_index_buffer(tentacle_mesh.index_buffer_view.BufferLocation,
+                                                        tentacle_mesh.index_buffer_view.SizeInBytes,
+                                                        nether::index_format_t::u16);
+            frame_setup_command_stream.set_root_constants(
+                0u, std::span(reinterpret_cast<const u32 *>(&skinned_render_resources),
+                              sizeof(skinned_render_resources_t) / sizeof(u32)));
+            frame_setup_command_stream.draw_indexed_instanced(tentacle_mesh.index_count, NUM_ANIMATED_CHARACTERS);
 
-            graphics_command_list->ClearRenderTargetView(
-                back_buffers[current_swapchain_backbuffer_index].cpu_rtv_handle, clear_color.data(), 0u, nullptr);
+            for (const u32 residency_handle : tentacle_mesh.residency_handles)
+            {
+                residency_manager->mark_used(residency_handle);
+            }
 
-            graphics_command_list->ClearDepthStencilView(depth_buffer.cpu_dsv_handle, D3D12_CLEAR_FLAG_DEPTH, 0.0f, 0u,
-                                                         0u, nullptr);
+            // The particles, with one instance of the quad per particle.
+            struct particle_render_resources_t
+            {
+                nether::float3_t camera_right{};
+                u32 particle_buffer_index{};
+                nether::float3_t camera_up{};
+                u32 scene_constant_buffer_index{};
+            };
 
-            ID3D12DescriptorHeap *const shader_visible_descriptor_heaps = {
-                cbv_srv_uav_descriptor_heap.descriptor_heap.Get(),
+            const particle_render_resources_t particle_render_resources = {
+                .camera_right = camera.right,
+                .particle_buffer_index = particle_buffer_creation_results[current_swapchain_backbuffer_index].srv_index,
+                .camera_up = nether::cross(camera.front, camera.right),
+                .scene_constant_buffer_index = scene_constant_buffer_creation_result.cbv_index,
             };
 
-            graphics_command_list->SetDescriptorHeaps(1u, &shader_visible_descriptor_heaps);
+            if (num_particle_vertices > 0u)
+            {
+                frame_setup_command_stream.set_pipeline(PARTICLE_PIPELINE_INDEX);
+                frame_setup_command_stream.set_index_buffer(particle_quad_index_buffer_view.BufferLocation,
+                                                            particle_quad_index_buffer_view.SizeInBytes,
+                                                            nether::index_format_t::u16);
+                frame_setup_command_stream.set_root_constants(
+                    0u, std::span(reinterpret_cast<const u32 *>(&particle_render_resources),
+                                  sizeof(particle_render_resources_t) / sizeof(u32)));
+                frame_setup_command_stream.draw_indexed_instanced(static_cast<u32>(particle_quad_index_data.size()),
+                                                                  num_particle_vertices);
+            }
 
-            // Set pipeline state.
-            graphics_command_list->SetGraphicsRootSignature(root_signature.Get());
-            graphics_command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-            graphics_command_list->IASetIndexBuffer(&index_buffer_view);
+            residency_manager->mark_used(particle_quad_index_buffer_residency_handle);
+
+            // The terrain, with one instance of the patch grid per selected patch.
+            struct terrain_render_resources_t
+            {
+                u32 patch_buffer_index{};
+                u32 tile_buffer_index{};
+                u32 scene_constant_buffer_index{};
+                u32 tile_resolution{};
+                f32 height_scale{};
+                f32 base_height{};
+            };
 
-            graphics_command_list->RSSetViewports(1u, &viewport);
-            graphics_command_list->RSSetScissorRects(1u, &scissor_rect);
+            const terrain_render_resources_t terrain_render_resources = {
+                .patch_buffer_index =
+                    terrain_patch_buffer_creation_results[current_swapchain_backbuffer_index].srv_index,
+                .tile_buffer_index = terrain_tile_buffer_creation_result.srv_index,
+                .scene_constant_buffer_index = scene_constant_buffer_creation_result.cbv_index,
+                .tile_resolution = TERRAIN_TILE_RESOLUTION,
+                .height_scale = terrain->get_header().height_scale,
+                .base_height = terrain_settings.origin.y,
+            };
 
-            // Render the game object (cube)
+            if (!terrain->patches.empty())
             {
-                graphics_command_list->SetPipelineState(test_graphics_pipeline.Get());
+                frame_setup_command_stream.set_pipeline(TERRAIN_PIPELINE_INDEX);
+                frame_setup_command_stream.set_index_buffer(terrain_patch_index_buffer_view.BufferLocation,
+                                                            terrain_patch_index_buffer_view.SizeInBytes,
+                                                            nether::index_format_t::u16);
+                frame_setup_command_stream.set_root_constants(
+                    0u, std::span(reinterpret_cast<const u32 *>(&terrain_render_resources),
+                                  sizeof(terrain_render_resources_t) / sizeof(u32)));
+                frame_setup_command_stream.draw_indexed_instanced(static_cast<u32>(terrain_patch_index_data.size()),
+                                                                  static_cast<u32>(terrain->patches.size()));
+            }
 
-                struct render_resources_t
-                {
-                    u32 position_buffer_index{};
-                    u32 color_buffer_index{};
-                    u32 transform_constant_buffer_index{};
-                    u32 scene_constant_buffer_index{};
-                };
+            residency_manager->mark_used(terrain_patch_index_buffer_residency_handle);
+            residency_manager->mark_used(terrain_tile_buffer_residency_handle);
+            residency_manager->mark_used(gpu_scene_buffer_residency_handle);
+            residency_manager->mark_used(gpu_scene_staging_buffer_residency_handle);
 
-                render_resources_t render_resources = {
-                    .position_buffer_index = vertex_position_buffer_creation_result.srv_index,
-                    .color_buffer_index = vertex_color_buffer_creation_result.srv_index,
-                    .transform_constant_buffer_index = transform_constant_buffer_creation_result.cbv_index,
-                    .scene_constant_buffer_index = scene_constant_buffer_creation_result.cbv_index,
-                };
-                graphics_command_list->SetGraphicsRoot32BitConstants(0u, 64u, &render_resources, 0u);
+            // All scene objects are rendered with permutations of the mesh shader, so they share the same render
+            // resources layout.
+            struct render_resources_t
+            {
+                nether::float3_t position_offset{};
+                u32 position_buffer_index{};
+                nether::float3_t position_scale{};
+                u32 color_buffer_index{};
+                u32 instance_buffer_index{};
+                u32 instance_offset{};
+                u32 scene_constant_buffer_index{};
+                u32 gpu_scene_buffer_index{};
+            };
+
+            for (const u32 residency_handle : frame_residency_handles[current_swapchain_backbuffer_index])
+            {
+                residency_manager->mark_used(residency_handle);
+            }
 
-                graphics_command_list->DrawIndexedInstanced(36u, 1u, 0u, 0u, 0u);
+            for (const nether::instanced_draw_t &instanced_draw : instanced_draws)
+            {
+                for (const u32 residency_handle : meshes[instanced_draw.mesh_index].residency_handles)
+                {
+                    residency_manager->mark_used(residency_handle);
+                }
             }
 
-            // Render the light object (cube)
+            // Render the scene objects, one instanced draw per (pipeline, material, mesh), splitting the draws evenly
+            // over the draw command streams.
+            const u32 num_instanced_draws = static_cast<u32>(instanced_draws.size());
+            job_system.parallel_for(NUM_DRAW_COMMAND_STREAMS, 1u, [&](const u32 begin, const u32 end, const u32) {
+                for (u32 stream_index = begin; stream_index < end; stream_index++)
+                {
+                    nether::command_stream_t &command_stream = command_streams[1u + stream_index];
+
+                    const u32 first_draw = num_instanced_draws * stream_index / NUM_DRAW_COMMAND_STREAMS;
+                    const u32 last_draw = num_instanced_draws * (stream_index + 1u) / NUM_DRAW_COMMAND_STREAMS;
+                    for (u32 i = first_draw; i < last_draw; i++)
+                    {
+                        const nether::instanced_draw_t &instanced_draw = instanced_draws[i];
+                        const mesh_t &mesh = meshes[instanced_draw.mesh_index];
+
+                        command_stream.set_pipeline(instanced_draw.pipeline_index);
+                        command_stream.set_index_buffer(mesh.index_buffer_view.BufferLocation,
+                                                        mesh.index_buffer_view.SizeInBytes,
+                                                        nether::index_format_t::u16);
+
+                        const render_resources_t render_resources = {
+                            .position_offset = mesh.position_offset,
+                            .position_buffer_index = mesh.position_buffer_index,
+                            .position_scale = mesh.position_scale,
+                            .color_buffer_index = mesh.color_buffer_index,
+                            .instance_buffer_index = instance_buffer_creation_result.srv_index,
+                            .instance_offset = instanced_draw.first_instance,
+                            .scene_constant_buffer_index = scene_constant_buffer_creation_result.cbv_index,
+                            .gpu_scene_buffer_index = gpu_scene_buffer_creation_result.srv_index,
+                        };
+
+                        command_stream.set_root_constants(
+                            0u, std::span(reinterpret_cast<const u32 *>(&render_resources),
+                                          sizeof(render_resources_t) / sizeof(u32)));
+                        command_stream.draw_indexed_instanced(mesh.index_count, instanced_draw.instance_count);
+                    }
+                }
+            });
+
+            // The debug lines are drawn last (at the end of the last draw command stream), so that the depth tested
+            // lines are tested against the whole scene. Each mode is one draw of the quad, with one instance per line.
+            struct debug_draw_render_resources_t
             {
-                graphics_command_list->SetGraphicsRootSignature(root_signature.Get());
-                graphics_command_list->SetPipelineState(light_graphics_pipeline.Get());
+                u32 line_buffer_index{};
+                u32 scene_constant_buffer_index{};
+                u32 first_line_index{};
+                f32 line_width_in_pixels{};
+                nether::float2_t viewport_size{};
+            };
 
-                struct render_resources_t
+            nether::command_stream_t &debug_draw_command_stream = command_streams[NUM_DRAW_COMMAND_STREAMS];
+            for (u32 mode = 0u; mode < nether::NUM_DEBUG_DRAW_MODES; mode++)
+            {
+                if (debug_line_ranges[mode].num_lines == 0u)
                 {
-                    u32 position_buffer_index;
-                    u32 transform_buffer_index;
-                    u32 scene_buffer_index;
+                    continue;
+                }
+
+                const debug_draw_render_resources_t debug_draw_render_resources = {
+                    .line_buffer_index =
+                        debug_line_buffer_creation_results[current_swapchain_backbuffer_index].srv_index,
+                    .scene_constant_buffer_index = scene_constant_buffer_creation_result.cbv_index,
+                    .first_line_index = debug_line_ranges[mode].first_line,
+                    .line_width_in_pixels = 2.0f,
+                    .viewport_size = {viewport.Width, viewport.Height},
                 };
 
-                render_resources_t render_resources = {
-                    .position_buffer_index = vertex_position_buffer_creation_result.srv_index,
-                    .transform_buffer_index = light_transform_constant_buffer_creation_result.cbv_index,
-                    .scene_buffer_index = scene_constant_buffer_creation_result.cbv_index,
+                debug_draw_command_stream.set_pipeline(mode == 0u ? DEBUG_DRAW_DEPTH_TESTED_PIPELINE_INDEX
+                                                                  : DEBUG_DRAW_ON_TOP_PIPELINE_INDEX);
+                debug_draw_command_stream.set_index_buffer(particle_quad_index_buffer_view.BufferLocation,
+                                                           particle_quad_index_buffer_view.SizeInBytes,
+                                                           nether::index_format_t::u16);
+                debug_draw_command_stream.set_root_constants(
+                    0u, std::span(reinterpret_cast<const u32 *>(&debug_draw_render_resources),
+                                  sizeof(debug_draw_render_resources_t) / sizeof(u32)));
+                debug_draw_command_stream.draw_indexed_instanced(static_cast<u32>(particle_quad_index_data.size()),
+                                                                 debug_line_ranges[mode].num_lines);
+            }
+
+            ID3D12Resource *const command_stream_resources[] = {
+                back_buffers[current_swapchain_backbuffer_index].resource.Get(),
+                gpu_scene_buffer_creation_result.resource.Get(),
+                gpu_scene_staging_buffer_creation_result.resource.Get(),
+            };
+
+            if constexpr (NETHER_DEBUG)
+            {
+                const nether::command_stream_limits_t command_stream_limits = {
+                    .num_pipelines = static_cast<u32>(graphics_pipelines.size()),
+                    .num_resources = static_cast<u32>(std::size(command_stream_resources)),
                 };
 
-                graphics_command_list->SetGraphicsRoot32BitConstants(0u, 64u, &render_resources, 0u);
-                graphics_command_list->DrawIndexedInstanced(36u, 1u, 0u, 0u, 0u);
+                for (u32 i = 0u; i < NUM_COMMAND_STREAMS; i++)
+                {
+                    const std::vector<std::string> errors = nether::validate(command_streams[i], command_stream_limits);
+                    if (!errors.empty())
+                    {
+                        throw std::runtime_error(std::format("Command stream {} is invalid : {} (and {} more errors)",
+                                                             i, errors.front(), errors.size() - 1u));
+                    }
+                }
             }
 
+            frame_statistics.end_phase(RECORDING_PHASE);
+
+            // Translate the command streams.
+            const nether::command_translation_context_t command_translation_context = {
+                .root_signature = root_signature.Get(),
+                .cbv_srv_uav_descriptor_heap = cbv_srv_uav_descriptor_heap->descriptor_heap.Get(),
+                .pipelines = graphics_pipelines,
+                .resources = command_stream_resources,
+                .rtv_handle = back_buffers[current_swapchain_backbuffer_index].cpu_rtv_handle,
+                .dsv_handle = depth_buffer.cpu_dsv_handle,
+                .viewport = viewport,
+                .scissor_rect = scissor_rect,
+            };
+
+            const std::span<ID3D12CommandList *const> translated_command_lists = command_translator->translate(
+                current_swapchain_backbuffer_index, command_stream_pointers, command_translation_context, &job_system);
+
+            frame_statistics.end_phase(TRANSLATION_PHASE);
+
+            // The rest of the frame (UI, and the transition back to present) is recorded directly.
+            throw_if_failed(direct_command_allocators[current_swapchain_backbuffer_index]->Reset());
+            throw_if_failed(graphics_command_list->Reset(
+                direct_command_allocators[current_swapchain_backbuffer_index].Get(), nullptr));
+
+            graphics_command_list->OMSetRenderTargets(1u,
+                                                      &back_buffers[current_swapchain_backbuffer_index].cpu_rtv_handle,
+                                                      false, &depth_buffer.cpu_dsv_handle);
+
+            ID3D12DescriptorHeap *const shader_visible_descriptor_heaps = {
+                cbv_srv_uav_descriptor_heap->descriptor_heap.Get(),
+            };
+
+            graphics_command_list->SetDescriptorHeaps(1u, &shader_visible_descriptor_heaps);
+
             ImGui::Render();
             ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), graphics_command_list.Get());
 
@@ -911,15 +2719,33 @@ int main()
             // Submit command list for execution.
             throw_if_failed(graphics_command_list->Close());
 
-            ID3D12CommandList *const command_lists_to_execute[] = {
-                graphics_command_list.Get(),
-            };
+            // Everything the frame uses has been marked, so the used resources can be made resident (and others
+            // evicted if over the budget) before the frame is submitted.
+            residency_manager->update();
+            residency_manager->end_frame();
+
+            std::array<ID3D12CommandList *, NUM_COMMAND_STREAMS + 1u> command_lists_to_execute{};
+            std::copy(translated_command_lists.begin(), translated_command_lists.end(),
+                      command_lists_to_execute.begin());
+            command_lists_to_execute[translated_command_lists.size()] = graphics_command_list.Get();
 
-            direct_command_queue->ExecuteCommandLists(1u, command_lists_to_execute);
+            direct_command_queue->ExecuteCommandLists(static_cast<UINT>(translated_command_lists.size() + 1u),
+                                                      command_lists_to_execute.data());
+
+            frame_statistics.end_phase(SUBMISSION_PHASE);
 
             // Present & signal.
             throw_if_failed(swapchain->Present(1u, 0u));
 
+            if (frame_index == 0u)
+            {
+                std::cout << std::format("Time to first frame :: {:.2f} ms",
+                                         std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() -
+                                                                                startup_start_time)
+                                             .count())
+                          << std::endl;
+            }
+
             current_fence_value++;
             throw_if_failed(direct_command_queue->Signal(fence.Get(), current_fence_value));
             frame_fence_values[current_swapchain_backbuffer_index] = current_fence_value;
@@ -930,6 +2756,10 @@ int main()
                 fence->SetEventOnCompletion(frame_fence_values[current_swapchain_backbuffer_index], nullptr);
             }
 
+            frame_statistics.end_phase(PRESENT_PHASE);
+            frame_statistics.end_frame();
+            memory_telemetry.end_frame();
+
             ++frame_index;
 
             LARGE_INTEGER counter_end_time = {};
@@ -939,8 +2769,6 @@ int main()
                 (f32)(counter_end_time.QuadPart - counter_start_time.QuadPart) / perf_counter_frequency.QuadPart;
 
             counter_start_time.QuadPart = counter_end_time.QuadPart;
-
-            std::cout << delta_time << '\n';
         }
 
         // throw_if_failed(debug_device->ReportLiveDeviceObjects(D3D12_RLDO_SUMMARY));
@@ -0,0 +1,394 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <cmath>
+#include <numbers>
+
+// Plain math types used by the CPU side subsystems. The layouts match DirectXMath's XMFLOAT3 / XMFLOAT4 /
+// XMFLOAT4X4 (and the HLSL float3 / float4 / row major float4x4), so they can be memcpy'd into GPU buffers directly.
+// Unlike DirectXMath these are available on every platform.
+namespace nether
+{
+struct float2_t
+{
+    f32 x{};
+    f32 y{};
+};
+
+struct float3_t
+{
+    f32 x{};
+    f32 y{};
+    f32 z{};
+};
+
+struct float4_t
+{
+    f32 x{};
+    f32 y{};
+    f32 z{};
+    f32 w{};
+};
+
+// Row major, vectors are treated as row vectors (i.e v' = v * M), same as DirectXMath.
+struct float4x4_t
+{
+    f32 m[4][4]{};
+};
+
+inline float3_t operator+(const float3_t &a, const float3_t &b)
+{
+    return float3_t{a.x + b.x, a.y + b.y, a.z + b.z};
+}
+
+inline float3_t operator-(const float3_t &a, const float3_t &b)
+{
+    return float3_t{a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+inline float3_t operator*(const float3_t &a, const f32 s)
+{
+    return float3_t{a.x * s, a.y * s, a.z * s};
+}
+
+inline f32 dot(const float3_t &a, const float3_t &b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline float3_t cross(const float3_t &a, const float3_t &b)
+{
+    return float3_t{a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+inline f32 length(const float3_t &a)
+{
+    return std::sqrt(dot(a, a));
+}
+
+inline float3_t normalize(const float3_t &a)
+{
+    const f32 inverse_length = 1.0f / length(a);
+    return a * inverse_length;
+}
+
+inline float3_t min(const float3_t &a, const float3_t &b)
+{
+    return float3_t{std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z)};
+}
+
+inline float3_t max(const float3_t &a, const float3_t &b)
+{
+    return float3_t{std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z)};
+}
+
+inline float4x4_t identity_matrix()
+{
+    float4x4_t result{};
+    result.m[0][0] = result.m[1][1] = result.m[2][2] = result.m[3][3] = 1.0f;
+
+    return result;
+}
+
+inline float4x4_t translation_matrix(const float3_t &translation)
+{
+    float4x4_t result = identity_matrix();
+    result.m[3][0] = translation.x;
+    result.m[3][1] = translation.y;
+    result.m[3][2] = translation.z;
+
+    return result;
+}
+
+inline float4x4_t scaling_matrix(const float3_t &scale)
+{
+    float4x4_t result{};
+    result.m[0][0] = scale.x;
+    result.m[1][1] = scale.y;
+    result.m[2][2] = scale.z;
+    result.m[3][3] = 1.0f;
+
+    return result;
+}
+
+// Rotation matrices follow the same conventions as DirectXMath's XMMatrixRotationX / Y / Z.
+inline float4x4_t rotation_x_matrix(const f32 angle)
+{
+    const f32 sin_angle = std::sin(angle);
+    const f32 cos_angle = std::cos(angle);
+
+    float4x4_t result = identity_matrix();
+    result.m[1][1] = cos_angle;
+    result.m[1][2] = sin_angle;
+    result.m[2][1] = -sin_angle;
+    result.m[2][2] = cos_angle;
+
+    return result;
+}
+
+inline float4x4_t rotation_y_matrix(const f32 angle)
+{
+    const f32 sin_angle = std::sin(angle);
+    const f32 cos_angle = std::cos(angle);
+
+    float4x4_t result = identity_matrix();
+    result.m[0][0] = cos_angle;
+    result.m[0][2] = -sin_angle;
+    result.m[2][0] = sin_angle;
+    result.m[2][2] = cos_angle;
+
+    return result;
+}
+
+inline float4x4_t rotation_z_matrix(const f32 angle)
+{
+    const f32 sin_angle = std::sin(angle);
+    const f32 cos_angle = std::cos(angle);
+
+    float4x4_t result = identity_matrix();
+    result.m[0][0] = cos_angle;
+    result.m[0][1] = sin_angle;
+    result.m[1][0] = -sin_angle;
+    result.m[1][1] = cos_angle;
+
+    return result;
+}
+
+inline float4x4_t operator*(const float4x4_t &a, const float4x4_t &b)
+{
+    float4x4_t result{};
+    for (u32 row = 0u; row < 4u; row++)
+    {
+        for (u32 column = 0u; column < 4u; column++)
+        {
+            result.m[row][column] = a.m[row][0] * b.m[0][column] + a.m[row][1] * b.m[1][column] +
+                                    a.m[row][2] * b.m[2][column] + a.m[row][3] * b.m[3][column];
+        }
+    }
+
+    return result;
+}
+
+// Same as XMMatrixRotationRollPitchYaw : roll (z) is applied first, then pitch (x), then yaw (y).
+inline float4x4_t rotation_roll_pitch_yaw_matrix(const f32 pitch, const f32 yaw, const f32 roll)
+{
+    return rotation_z_matrix(roll) * rotation_x_matrix(pitch) * rotation_y_matrix(yaw);
+}
+
+inline constexpr f32 to_radians(const f32 degrees)
+{
+    return degrees * (std::numbers::pi_v<f32> / 180.0f);
+}
+
+// Same as XMMatrixLookToLH : a left handed view matrix for a camera at eye, looking along direction.
+inline float4x4_t look_to_matrix(const float3_t &eye, const float3_t &direction, const float3_t &up)
+{
+    const float3_t z_axis = normalize(direction);
+    const float3_t x_axis = normalize(cross(up, z_axis));
+    const float3_t y_axis = cross(z_axis, x_axis);
+
+    float4x4_t result = identity_matrix();
+    result.m[0][0] = x_axis.x;
+    result.m[1][0] = x_axis.y;
+    result.m[2][0] = x_axis.z;
+    result.m[0][1] = y_axis.x;
+    result.m[1][1] = y_axis.y;
+    result.m[2][1] = y_axis.z;
+    result.m[0][2] = z_axis.x;
+    result.m[1][2] = z_axis.y;
+    result.m[2][2] = z_axis.z;
+    result.m[3][0] = -dot(x_axis, eye);
+    result.m[3][1] = -dot(y_axis, eye);
+    result.m[3][2] = -dot(z_axis, eye);
+
+    return result;
+}
+
+// Left handed perspective projection with reverse z and an infinite far plane : the near plane maps to depth 1, and
+// depth goes to 0 at infinity. This is XMMatrixPerspectiveFovLH modified for reverse z and an infinite far plane, see
+//  https://iolite-engine.com/blog_posts/reverse_z_cheatsheet and https://github.com/microsoft/DirectXMath/issues/158.
+// fov_y is the vertical field of view (in radians), and aspect_ratio is width / height.
+inline float4x4_t perspective_reverse_z_matrix(const f32 fov_y, const f32 aspect_ratio, const f32 near_plane)
+{
+    const f32 height = std::cos(0.5f * fov_y) / std::sin(0.5f * fov_y);
+    const f32 width = height / aspect_ratio;
+
+    float4x4_t result{};
+    result.m[0][0] = width;
+    result.m[1][1] = height;
+    result.m[2][3] = 1.0f;
+    result.m[3][2] = near_plane;
+
+    return result;
+}
+
+// Transforms (x, y, z, 1) by the matrix, returning the full homogeneous result.
+inline float4_t transform_point(const float3_t &point, const float4x4_t &matrix)
+{
+    return float4_t{
+        point.x * matrix.m[0][0] + point.y * matrix.m[1][0] + point.z * matrix.m[2][0] + matrix.m[3][0],
+        point.x * matrix.m[0][1] + point.y * matrix.m[1][1] + point.z * matrix.m[2][1] + matrix.m[3][1],
+        point.x * matrix.m[0][2] + point.y * matrix.m[1][2] + point.z * matrix.m[2][2] + matrix.m[3][2],
+        point.x * matrix.m[0][3] + point.y * matrix.m[1][3] + point.z * matrix.m[2][3] + matrix.m[3][3],
+    };
+}
+
+struct aabb_t
+{
+    float3_t min{INFINITY, INFINITY, INFINITY};
+    float3_t max{-INFINITY, -INFINITY, -INFINITY};
+};
+
+inline aabb_t merge(const aabb_t &a, const aabb_t &b)
+{
+    return aabb_t{min(a.min, b.min), max(a.max, b.max)};
+}
+
+inline aabb_t merge(const aabb_t &a, const float3_t &point)
+{
+    return aabb_t{min(a.min, point), max(a.max, point)};
+}
+
+inline float3_t get_center(const aabb_t &aabb)
+{
+    return (aabb.min + aabb.max) * 0.5f;
+}
+
+// Returns 0 for an empty (inverted) box.
+inline f32 get_surface_area(const aabb_t &aabb)
+{
+    const float3_t extent = aabb.max - aabb.min;
+    if (extent.x < 0.0f || extent.y < 0.0f || extent.z < 0.0f)
+    {
+        return 0.0f;
+    }
+
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+// Bounds of the transformed box (which are usually larger than the box itself, unless the matrix has no rotation).
+inline aabb_t transform_aabb(const aabb_t &aabb, const float4x4_t &matrix)
+{
+    aabb_t result{};
+    for (u32 i = 0u; i < 8u; i++)
+    {
+        const float3_t corner = {
+            (i & 1u) ? aabb.max.x : aabb.min.x,
+            (i & 2u) ? aabb.max.y : aabb.min.y,
+            (i & 4u) ? aabb.max.z : aabb.min.z,
+        };
+
+        const float4_t transformed_corner = transform_point(corner, matrix);
+        result = merge(result, float3_t{transformed_corner.x, transformed_corner.y, transformed_corner.z});
+    }
+
+    return result;
+}
+
+inline bool overlaps(const aabb_t &a, const aabb_t &b)
+{
+    return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+// A point p is inside a plane (a, b, c, d) if a * p.x + b * p.y + c * p.z + d >= 0.
+struct frustum_t
+{
+    std::array<float4_t, 6> planes{};
+};
+
+// Extracts the frustum planes from a view projection matrix (row vector convention, d3d clip space with z in [0, w]).
+// Works for both regular and reverse z projections, including infinite far plane projections (where one of the planes
+// degenerates to a plane that every point is inside of).
+inline frustum_t get_frustum(const float4x4_t &view_projection_matrix)
+{
+    const auto get_column = [&](const u32 column) {
+        return float4_t{view_projection_matrix.m[0][column], view_projection_matrix.m[1][column],
+                        view_projection_matrix.m[2][column], view_projection_matrix.m[3][column]};
+    };
+
+    const float4_t x = get_column(0u);
+    const float4_t y = get_column(1u);
+    const float4_t z = get_column(2u);
+    const float4_t w = get_column(3u);
+
+    const auto add = [](const float4_t &a, const float4_t &b) {
+        return float4_t{a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w};
+    };
+    const auto subtract = [](const float4_t &a, const float4_t &b) {
+        return float4_t{a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w};
+    };
+
+    frustum_t frustum = {
+        .planes =
+            {
+                add(w, x),      // -w <= x
+                subtract(w, x), // x <= w
+                add(w, y),      // -w <= y
+                subtract(w, y), // y <= w
+                z,              // 0 <= z
+                subtract(w, z), // z <= w
+            },
+    };
+
+    // Normalize the planes, so that plane distances are in world units.
+    for (float4_t &plane : frustum.planes)
+    {
+        const f32 normal_length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if (normal_length > 0.0f)
+        {
+            plane = float4_t{plane.x / normal_length, plane.y / normal_length, plane.z / normal_length,
+                             plane.w / normal_length};
+        }
+    }
+
+    return frustum;
+}
+
+// Returns false if the box is completely outside one of the frustum's planes.
+inline bool intersects(const frustum_t &frustum, const aabb_t &aabb)
+{
+    for (const float4_t &plane : frustum.planes)
+    {
+        // The corner of the box that is furthest along the plane's normal.
+        const f32 distance = plane.x * (plane.x > 0.0f ? aabb.max.x : aabb.min.x) +
+                             plane.y * (plane.y > 0.0f ? aabb.max.y : aabb.min.y) +
+                             plane.z * (plane.z > 0.0f ? aabb.max.z : aabb.min.z) + plane.w;
+        if (distance < 0.0f)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#ifdef _WIN32
+inline float4x4_t to_float4x4(const DirectX::FXMMATRIX matrix)
+{
+    float4x4_t result{};
+    DirectX::XMStoreFloat4x4(reinterpret_cast<DirectX::XMFLOAT4X4 *>(&result), matrix);
+
+    return result;
+}
+
+inline DirectX::XMMATRIX to_xmmatrix(const float4x4_t &matrix)
+{
+    return DirectX::XMLoadFloat4x4(reinterpret_cast<const DirectX::XMFLOAT4X4 *>(&matrix));
+}
+
+inline float3_t to_float3(const DirectX::FXMVECTOR vector)
+{
+    float3_t result{};
+    DirectX::XMStoreFloat3(reinterpret_cast<DirectX::XMFLOAT3 *>(&result), vector);
+
+    return result;
+}
+
+inline DirectX::XMVECTOR to_xmvector(const float3_t &vector, const f32 w = 0.0f)
+{
+    return DirectX::XMVectorSet(vector.x, vector.y, vector.z, w);
+}
+#endif
+} // namespace nether
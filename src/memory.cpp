@@ -0,0 +1,102 @@
+#include "memory.hpp"
+
+namespace nether::memory
+{
+linear_arena_t::linear_arena_t(const size_t capacity) : capacity(capacity)
+{
+    memory = static_cast<u8 *>(::operator new(capacity, std::align_val_t{64u}));
+}
+
+linear_arena_t::~linear_arena_t()
+{
+    ::operator delete(memory, std::align_val_t{64u});
+}
+
+void linear_arena_t::rewind(const marker_t marker)
+{
+    if (marker > offset)
+    {
+        throw std::runtime_error("Linear arena rewound to a marker past its current offset");
+    }
+
+    peak_used = std::max(peak_used, offset);
+
+    if constexpr (POISON_MEMORY)
+    {
+        std::memset(memory + marker, FREED_MEMORY_PATTERN, offset - marker);
+    }
+
+    offset = marker;
+}
+
+void linear_arena_t::throw_out_of_memory(const size_t size) const
+{
+    throw std::runtime_error(std::format("Linear arena out of memory : requested {} bytes, {} of {} bytes used", size,
+                                         offset, capacity));
+}
+
+frame_arena_set_t::frame_arena_set_t(const u32 num_frames_in_flight, const size_t capacity_per_frame)
+{
+    for (u32 i = 0u; i < num_frames_in_flight; i++)
+    {
+        arenas.push_back(std::make_unique<linear_arena_t>(capacity_per_frame));
+    }
+}
+
+void frame_arena_set_t::begin_frame(const u32 frame_slot)
+{
+    current_frame_slot = frame_slot;
+    arenas[current_frame_slot]->reset();
+}
+
+linear_arena_t &get_scratch_arena()
+{
+    thread_local linear_arena_t scratch_arena(SCRATCH_ARENA_CAPACITY);
+    return scratch_arena;
+}
+
+pool_allocator_t::pool_allocator_t(const size_t block_size, const size_t block_alignment, const u32 blocks_per_chunk)
+    : block_alignment(block_alignment), blocks_per_chunk(blocks_per_chunk)
+{
+    // Free blocks store the free list pointer in place.
+    this->block_size = align_up(std::max(block_size, sizeof(free_block_t)),
+                                std::max(block_alignment, alignof(free_block_t)));
+    this->block_alignment = std::max(block_alignment, alignof(free_block_t));
+}
+
+pool_allocator_t::~pool_allocator_t()
+{
+    for (void *const chunk : chunks)
+    {
+        ::operator delete(chunk, std::align_val_t{block_alignment});
+    }
+}
+
+void pool_allocator_t::allocate_chunk()
+{
+    u8 *const chunk =
+        static_cast<u8 *>(::operator new(block_size * blocks_per_chunk, std::align_val_t{block_alignment}));
+    chunks.push_back(chunk);
+    statistics.num_chunks++;
+
+    // Link the blocks in address order, so that consecutive allocations are contiguous.
+    for (u32 i = blocks_per_chunk; i > 0u; i--)
+    {
+        free_block_t *const block = reinterpret_cast<free_block_t *>(chunk + (i - 1u) * block_size);
+        block->next = free_list;
+        free_list = block;
+    }
+}
+
+void *pool_allocator_t::do_allocate(const size_t size, const size_t alignment)
+{
+    if (size > block_size || alignment > block_alignment)
+    {
+        throw std::runtime_error(std::format("Allocation of {} bytes (alignment {}) does not fit in the {} byte blocks "
+                                             "of the pool allocator",
+                                             size, alignment, block_size));
+    }
+
+    return allocate();
+}
+} // namespace nether::memory
@@ -0,0 +1,338 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <memory>
+#include <memory_resource>
+
+// Allocators for transient CPU data, so that per frame work does not go through the general purpose heap.
+//  - linear_arena_t : a bump allocator over a single block, freed all at once (reset) or back to a marker (rewind).
+//  - frame_arena_set_t : one linear arena per frame in flight, reset when its frame slot is reused.
+//  - Scratch arenas : a thread local linear arena used as a stack, rewound by scratch_scope_t.
+//  - pool_allocator_t : fixed size blocks with an intrusive free list, for objects that are created and destroyed
+//    individually.
+// Arenas and pools are std::pmr::memory_resource's, so they can back std::pmr containers directly. arena_allocator_t
+// is a (non polymorphic) std compatible allocator for the arenas, for containers such as std::vector<T, Allocator>.
+// With POISON_MEMORY enabled (debug builds), new allocations are filled with ALLOCATED_MEMORY_PATTERN and freed memory
+// with FREED_MEMORY_PATTERN, so that reads of uninitialized or stale memory stand out.
+// None of the allocators are thread safe (scratch arenas are safe because every thread has its own).
+namespace nether::memory
+{
+static constexpr bool POISON_MEMORY = NETHER_DEBUG;
+static constexpr u8 ALLOCATED_MEMORY_PATTERN = 0xcd;
+static constexpr u8 FREED_MEMORY_PATTERN = 0xdd;
+
+static constexpr size_t DEFAULT_ALIGNMENT = alignof(std::max_align_t);
+
+inline size_t align_up(const size_t value, const size_t alignment)
+{
+    return (value + alignment - 1u) & ~(alignment - 1u);
+}
+
+struct arena_statistics_t
+{
+    size_t capacity{};
+    size_t used{};
+
+    // Highest value of used since the arena was created.
+    size_t peak_used{};
+
+    // Allocations since the last reset.
+    u64 num_allocations{};
+};
+
+class linear_arena_t final : public std::pmr::memory_resource
+{
+  public:
+    // The position of the arena, which allocations can be rewound to.
+    using marker_t = size_t;
+
+    explicit linear_arena_t(const size_t capacity);
+    ~linear_arena_t() override;
+
+    linear_arena_t(const linear_arena_t &) = delete;
+    linear_arena_t &operator=(const linear_arena_t &) = delete;
+
+    // Throws if the arena is out of memory. Alignment must be a power of two.
+    void *allocate(const size_t size, const size_t alignment = DEFAULT_ALIGNMENT)
+    {
+        const size_t aligned_offset = align_up(offset, alignment);
+        if (aligned_offset + size > capacity)
+        {
+            throw_out_of_memory(size);
+        }
+
+        void *const result = memory + aligned_offset;
+        offset = aligned_offset + size;
+
+        num_allocations++;
+        if constexpr (POISON_MEMORY)
+        {
+            std::memset(result, ALLOCATED_MEMORY_PATTERN, size);
+        }
+
+        return result;
+    }
+
+    template <typename T> T *allocate_array(const size_t count)
+    {
+        return static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    marker_t get_marker() const
+    {
+        return offset;
+    }
+
+    // Frees all allocations made after the marker was taken.
+    void rewind(const marker_t marker);
+
+    // Frees all allocations.
+    void reset()
+    {
+        rewind(0u);
+        num_allocations = 0u;
+    }
+
+    arena_statistics_t get_statistics() const
+    {
+        return {
+            .capacity = capacity,
+            .used = offset,
+            .peak_used = std::max(peak_used, offset),
+            .num_allocations = num_allocations,
+        };
+    }
+
+  private:
+    [[noreturn]] void throw_out_of_memory(const size_t size) const;
+
+    // Memory is only freed by reset / rewind.
+    void *do_allocate(const size_t size, const size_t alignment) override
+    {
+        return allocate(size, alignment);
+    }
+
+    void do_deallocate(void *const, const size_t, const size_t) override
+    {
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+  private:
+    u8 *memory{};
+    size_t capacity{};
+    size_t offset{};
+
+    size_t peak_used{};
+    u64 num_allocations{};
+};
+
+// A linear arena per frame in flight. begin_frame resets the arena of the frame slot, which must only be done once the
+// GPU has finished the frame that last used the slot (i.e after waiting on its fence), as that frame's allocations may
+// have been handed to it.
+class frame_arena_set_t
+{
+  public:
+    frame_arena_set_t(const u32 num_frames_in_flight, const size_t capacity_per_frame);
+
+    void begin_frame(const u32 frame_slot);
+
+    linear_arena_t &get_current_arena()
+    {
+        return *arenas[current_frame_slot];
+    }
+
+  private:
+    std::vector<std::unique_ptr<linear_arena_t>> arenas{};
+    u32 current_frame_slot{};
+};
+
+// Scratch arenas are created on first use by each thread.
+static constexpr size_t SCRATCH_ARENA_CAPACITY = 4u * 1024u * 1024u;
+
+linear_arena_t &get_scratch_arena();
+
+// Rewinds the thread's scratch arena to where it was when the scope was created. Scopes must be destroyed in the
+// reverse order of their creation (which is automatic for scopes on the stack), and memory allocated in a scope must
+// not be used after it ends.
+class scratch_scope_t
+{
+  public:
+    scratch_scope_t() : arena(get_scratch_arena()), marker(arena.get_marker())
+    {
+    }
+
+    ~scratch_scope_t()
+    {
+        arena.rewind(marker);
+    }
+
+    scratch_scope_t(const scratch_scope_t &) = delete;
+    scratch_scope_t &operator=(const scratch_scope_t &) = delete;
+
+    linear_arena_t &get_arena()
+    {
+        return arena;
+    }
+
+  private:
+    linear_arena_t &arena;
+    linear_arena_t::marker_t marker{};
+};
+
+struct pool_statistics_t
+{
+    u32 num_chunks{};
+    u32 num_allocated_blocks{};
+    u32 peak_allocated_blocks{};
+};
+
+// Fixed size blocks, carved out of chunks of blocks_per_chunk blocks. A new chunk is allocated when all blocks are in
+// use, and chunks are only freed when the pool is destroyed.
+class pool_allocator_t final : public std::pmr::memory_resource
+{
+  public:
+    pool_allocator_t(const size_t block_size, const size_t block_alignment = DEFAULT_ALIGNMENT,
+                     const u32 blocks_per_chunk = 256u);
+    ~pool_allocator_t() override;
+
+    pool_allocator_t(const pool_allocator_t &) = delete;
+    pool_allocator_t &operator=(const pool_allocator_t &) = delete;
+
+    // The std::pmr::memory_resource overloads (which take a size and alignment) are also available.
+    using std::pmr::memory_resource::allocate;
+    using std::pmr::memory_resource::deallocate;
+
+    void *allocate()
+    {
+        if (!free_list)
+        {
+            allocate_chunk();
+        }
+
+        free_block_t *const block = free_list;
+        free_list = block->next;
+
+        statistics.num_allocated_blocks++;
+        statistics.peak_allocated_blocks =
+            std::max(statistics.peak_allocated_blocks, statistics.num_allocated_blocks);
+
+        if constexpr (POISON_MEMORY)
+        {
+            std::memset(static_cast<void *>(block), ALLOCATED_MEMORY_PATTERN, block_size);
+        }
+
+        return block;
+    }
+
+    void deallocate(void *const block)
+    {
+        if constexpr (POISON_MEMORY)
+        {
+            std::memset(block, FREED_MEMORY_PATTERN, block_size);
+        }
+
+        free_block_t *const free_block = static_cast<free_block_t *>(block);
+        free_block->next = free_list;
+        free_list = free_block;
+
+        statistics.num_allocated_blocks--;
+    }
+
+    // Constructs / destroys a T in a block.
+    template <typename T, typename... Args> T *create(Args &&...args)
+    {
+        if (sizeof(T) > block_size || alignof(T) > block_alignment)
+        {
+            throw std::runtime_error("Type does not fit in the blocks of the pool allocator");
+        }
+
+        return new (allocate()) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T> void destroy(T *const object)
+    {
+        object->~T();
+        deallocate(object);
+    }
+
+    size_t get_block_size() const
+    {
+        return block_size;
+    }
+
+  public:
+    pool_statistics_t statistics{};
+
+  private:
+    struct free_block_t
+    {
+        free_block_t *next{};
+    };
+
+    void allocate_chunk();
+
+    // Throws if the request does not fit in a block.
+    void *do_allocate(const size_t size, const size_t alignment) override;
+
+    void do_deallocate(void *const block, const size_t, const size_t) override
+    {
+        deallocate(block);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+  private:
+    size_t block_size{};
+    size_t block_alignment{};
+    u32 blocks_per_chunk{};
+
+    std::vector<void *> chunks{};
+    free_block_t *free_list{};
+};
+
+// A std compatible allocator that allocates from a linear arena, without the virtual calls of
+// std::pmr::polymorphic_allocator. deallocate is a no-op, memory is freed when the arena is reset / rewound.
+template <typename T> class arena_allocator_t
+{
+  public:
+    using value_type = T;
+
+    explicit arena_allocator_t(linear_arena_t &arena) : arena(&arena)
+    {
+    }
+
+    template <typename U> arena_allocator_t(const arena_allocator_t<U> &other) : arena(other.get_arena())
+    {
+    }
+
+    T *allocate(const size_t count)
+    {
+        return arena->allocate_array<T>(count);
+    }
+
+    void deallocate(T *const, const size_t)
+    {
+    }
+
+    linear_arena_t *get_arena() const
+    {
+        return arena;
+    }
+
+    template <typename U> bool operator==(const arena_allocator_t<U> &other) const
+    {
+        return arena == other.get_arena();
+    }
+
+  private:
+    linear_arena_t *arena{};
+};
+} // namespace nether::memory
@@ -0,0 +1,501 @@
+#include "occlusion_culling.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <immintrin.h>
+
+namespace nether
+{
+namespace
+{
+f32 get_horizontal_min(const __m256 value)
+{
+    __m128 result = _mm_min_ps(_mm256_castps256_ps128(value), _mm256_extractf128_ps(value, 1));
+    result = _mm_min_ps(result, _mm_movehl_ps(result, result));
+    result = _mm_min_ss(result, _mm_shuffle_ps(result, result, 1));
+
+    return _mm_cvtss_f32(result);
+}
+
+f32 get_elapsed_time_in_ms(const std::chrono::steady_clock::time_point start_time)
+{
+    return std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+// Offsets of the 8 pixel centers processed together, relative to the first pixel.
+const __m256 PIXEL_CENTER_OFFSETS = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+} // namespace
+
+occlusion_culler_t::occlusion_culler_t(const u32 width, const u32 height) : width(width), height(height)
+{
+    if (width == 0u || height == 0u || width % TILE_SIZE != 0u || height % TILE_SIZE != 0u)
+    {
+        throw std::runtime_error("Occlusion culler dimensions must be non zero multiples of the tile size");
+    }
+
+    num_tiles_x = width / TILE_SIZE;
+    num_bands = (height + BAND_HEIGHT - 1u) / BAND_HEIGHT;
+
+    depth_buffer.resize(width * height, 0.0f);
+    hierarchical_depth_buffer.resize(num_tiles_x * (height / TILE_SIZE), 0.0f);
+}
+
+void occlusion_culler_t::begin_frame(const float4x4_t &view_projection_matrix)
+{
+    this->view_projection_matrix = view_projection_matrix;
+    frustum = get_frustum(view_projection_matrix);
+
+    num_occluders = 0u;
+    statistics = {};
+}
+
+void occlusion_culler_t::add_occluder(const std::span<const float3_t> positions, const std::span<const u16> indices,
+                                      const float4x4_t &model_matrix)
+{
+    occluder_t &occluder = allocate_occluder(positions, model_matrix);
+    occluder.indices_16 = indices.data();
+    occluder.num_indices = static_cast<u32>(indices.size());
+}
+
+void occlusion_culler_t::add_occluder(const std::span<const float3_t> positions, const std::span<const u32> indices,
+                                      const float4x4_t &model_matrix)
+{
+    occluder_t &occluder = allocate_occluder(positions, model_matrix);
+    occluder.indices_32 = indices.data();
+    occluder.num_indices = static_cast<u32>(indices.size());
+}
+
+void occlusion_culler_t::rasterize(job_system_t *const job_system)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    // Triangle setup is done per occluder, and rasterization per band of the screen.
+    if (job_system)
+    {
+        job_system->parallel_for(num_occluders, 1u, [&](const u32 begin, const u32 end, const u32) {
+            for (u32 i = begin; i < end; i++)
+            {
+                setup_triangles(occluders[i]);
+            }
+        });
+
+        job_system->parallel_for(num_bands, 1u, [&](const u32 begin, const u32 end, const u32) {
+            for (u32 i = begin; i < end; i++)
+            {
+                rasterize_band(i);
+            }
+        });
+    }
+    else
+    {
+        for (u32 i = 0u; i < num_occluders; i++)
+        {
+            setup_triangles(occluders[i]);
+        }
+
+        for (u32 i = 0u; i < num_bands; i++)
+        {
+            rasterize_band(i);
+        }
+    }
+
+    statistics.num_occluders = num_occluders;
+    for (u32 i = 0u; i < num_occluders; i++)
+    {
+        statistics.num_rasterized_triangles += static_cast<u32>(occluders[i].triangles.size());
+    }
+
+    statistics.rasterization_time_in_ms = get_elapsed_time_in_ms(start_time);
+}
+
+bool occlusion_culler_t::is_visible(const aabb_t &bounds) const
+{
+    return get_visibility(bounds) == visibility_t::visible;
+}
+
+void occlusion_culler_t::test_occludees(const std::span<const aabb_t> bounds, const std::span<u8> visibility,
+                                        job_system_t *const job_system)
+{
+    if (visibility.size() < bounds.size())
+    {
+        throw std::runtime_error("Occludee visibility span is smaller than the number of occludees");
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    std::atomic<u32> num_outside_frustum{};
+    std::atomic<u32> num_occluded{};
+
+    const auto test_batch = [&](const u32 begin, const u32 end, const u32) {
+        u32 batch_num_outside_frustum = 0u;
+        u32 batch_num_occluded = 0u;
+
+        for (u32 i = begin; i < end; i++)
+        {
+            const visibility_t occludee_visibility = get_visibility(bounds[i]);
+
+            batch_num_outside_frustum += occludee_visibility == visibility_t::outside_frustum ? 1u : 0u;
+            batch_num_occluded += occludee_visibility == visibility_t::occluded ? 1u : 0u;
+
+            visibility[i] = occludee_visibility == visibility_t::visible ? 1u : 0u;
+        }
+
+        num_outside_frustum.fetch_add(batch_num_outside_frustum, std::memory_order_relaxed);
+        num_occluded.fetch_add(batch_num_occluded, std::memory_order_relaxed);
+    };
+
+    const u32 num_occludees = static_cast<u32>(bounds.size());
+    if (job_system)
+    {
+        job_system->parallel_for(num_occludees, 256u, test_batch);
+    }
+    else
+    {
+        test_batch(0u, num_occludees, 0u);
+    }
+
+    statistics.num_occludees_tested += num_occludees;
+    statistics.num_outside_frustum += num_outside_frustum;
+    statistics.num_occluded += num_occluded;
+    statistics.test_time_in_ms += get_elapsed_time_in_ms(start_time);
+}
+
+occlusion_culler_t::occluder_t &occlusion_culler_t::allocate_occluder(const std::span<const float3_t> positions,
+                                                                       const float4x4_t &model_matrix)
+{
+    if (num_occluders == occluders.size())
+    {
+        occluders.emplace_back();
+    }
+
+    occluder_t &occluder = occluders[num_occluders++];
+    occluder.positions = positions;
+    occluder.indices_16 = nullptr;
+    occluder.indices_32 = nullptr;
+    occluder.num_indices = 0u;
+    occluder.model_view_projection_matrix = model_matrix * view_projection_matrix;
+
+    return occluder;
+}
+
+void occlusion_culler_t::setup_triangles(occluder_t &occluder) const
+{
+    occluder.triangles.clear();
+
+    occluder.clip_space_positions.resize(occluder.positions.size());
+    for (size_t i = 0u; i < occluder.positions.size(); i++)
+    {
+        occluder.clip_space_positions[i] =
+            transform_point(occluder.positions[i], occluder.model_view_projection_matrix);
+    }
+
+    const auto get_index = [&](const u32 i) {
+        return occluder.indices_16 ? static_cast<u32>(occluder.indices_16[i]) : occluder.indices_32[i];
+    };
+
+    // A vertex is in front of the near plane if z <= w (the depth in reverse z is 1 at the near plane).
+    const auto get_near_plane_distance = [](const float4_t &v) { return v.w - v.z; };
+
+    const auto lerp = [](const float4_t &a, const float4_t &b, const f32 t) {
+        return float4_t{a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t};
+    };
+
+    for (u32 i = 0u; i + 2u < occluder.num_indices; i += 3u)
+    {
+        const std::array<float4_t, 3> vertices = {
+            occluder.clip_space_positions[get_index(i)],
+            occluder.clip_space_positions[get_index(i + 1u)],
+            occluder.clip_space_positions[get_index(i + 2u)],
+        };
+
+        // Clip the triangle against the near plane, which results in up to 4 vertices.
+        std::array<float4_t, 4> clipped_vertices{};
+        u32 num_clipped_vertices = 0u;
+
+        for (u32 j = 0u; j < 3u; j++)
+        {
+            const float4_t &current = vertices[j];
+            const float4_t &next = vertices[(j + 1u) % 3u];
+
+            const f32 current_distance = get_near_plane_distance(current);
+            const f32 next_distance = get_near_plane_distance(next);
+
+            if (current_distance >= 0.0f)
+            {
+                clipped_vertices[num_clipped_vertices++] = current;
+            }
+
+            if ((current_distance >= 0.0f) != (next_distance >= 0.0f))
+            {
+                clipped_vertices[num_clipped_vertices++] =
+                    lerp(current, next, current_distance / (current_distance - next_distance));
+            }
+        }
+
+        for (u32 j = 1u; j + 1u < num_clipped_vertices; j++)
+        {
+            add_triangle(occluder, clipped_vertices[0], clipped_vertices[j], clipped_vertices[j + 1u]);
+        }
+    }
+}
+
+void occlusion_culler_t::add_triangle(occluder_t &occluder, const float4_t &v0, const float4_t &v1,
+                                      const float4_t &v2) const
+{
+    const std::array<float4_t, 3> clip_space_vertices = {v0, v1, v2};
+
+    std::array<float3_t, 3> vertices{};
+    for (u32 i = 0u; i < 3u; i++)
+    {
+        const float4_t &v = clip_space_vertices[i];
+        if (v.w <= 0.0f)
+        {
+            return;
+        }
+
+        const f32 inverse_w = 1.0f / v.w;
+        vertices[i] = float3_t{
+            (v.x * inverse_w * 0.5f + 0.5f) * width,
+            (0.5f - v.y * inverse_w * 0.5f) * height,
+            v.z * inverse_w,
+        };
+    }
+
+    const float3_t d1 = vertices[1] - vertices[0];
+    const float3_t d2 = vertices[2] - vertices[0];
+
+    const f32 area = d1.x * d2.y - d1.y * d2.x;
+    if (std::abs(area) < 1e-8f)
+    {
+        return;
+    }
+
+    const f32 min_x = std::min({vertices[0].x, vertices[1].x, vertices[2].x});
+    const f32 max_x = std::max({vertices[0].x, vertices[1].x, vertices[2].x});
+    const f32 min_y = std::min({vertices[0].y, vertices[1].y, vertices[2].y});
+    const f32 max_y = std::max({vertices[0].y, vertices[1].y, vertices[2].y});
+
+    // Only pixels whose centers are inside the triangle are covered.
+    screen_triangle_t triangle = {
+        .min_x = std::max(static_cast<i32>(std::ceil(min_x - 0.5f)), 0),
+        .min_y = std::max(static_cast<i32>(std::ceil(min_y - 0.5f)), 0),
+        .max_x = std::min(static_cast<i32>(std::floor(max_x - 0.5f)), static_cast<i32>(width) - 1),
+        .max_y = std::min(static_cast<i32>(std::floor(max_y - 0.5f)), static_cast<i32>(height) - 1),
+    };
+
+    if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y)
+    {
+        return;
+    }
+
+    // Edge i goes from vertex i to vertex i + 1. Occluders are rasterized regardless of their winding, so the edge
+    // functions are flipped for triangles with a negative area to keep the inside positive.
+    const f32 orientation = area > 0.0f ? 1.0f : -1.0f;
+    for (u32 i = 0u; i < 3u; i++)
+    {
+        const float3_t &a = vertices[i];
+        const float3_t &b = vertices[(i + 1u) % 3u];
+
+        triangle.edge_a[i] = (a.y - b.y) * orientation;
+        triangle.edge_b[i] = (b.x - a.x) * orientation;
+        triangle.edge_c[i] = (a.x * b.y - b.x * a.y) * orientation;
+    }
+
+    triangle.depth_a = (d1.z * d2.y - d2.z * d1.y) / area;
+    triangle.depth_b = (d2.z * d1.x - d1.z * d2.x) / area;
+    triangle.depth_c = vertices[0].z - triangle.depth_a * vertices[0].x - triangle.depth_b * vertices[0].y;
+
+    occluder.triangles.push_back(triangle);
+}
+
+void occlusion_culler_t::rasterize_band(const u32 band_index)
+{
+    const i32 band_min_y = static_cast<i32>(band_index * BAND_HEIGHT);
+    const i32 band_max_y = std::min(static_cast<i32>((band_index + 1u) * BAND_HEIGHT), static_cast<i32>(height)) - 1;
+
+    std::fill(depth_buffer.begin() + band_min_y * width, depth_buffer.begin() + (band_max_y + 1) * width, 0.0f);
+
+    for (u32 occluder_index = 0u; occluder_index < num_occluders; occluder_index++)
+    {
+        for (const screen_triangle_t &triangle : occluders[occluder_index].triangles)
+        {
+            if (triangle.max_y < band_min_y || triangle.min_y > band_max_y)
+            {
+                continue;
+            }
+
+            const i32 min_y = std::max(triangle.min_y, band_min_y);
+            const i32 max_y = std::min(triangle.max_y, band_max_y);
+
+            // Pixels are processed in aligned groups of 8. The width is a multiple of 8, so groups never cross the
+            // right edge of the screen.
+            const i32 min_x = triangle.min_x & ~7;
+
+            const __m256 pixel_x = _mm256_add_ps(_mm256_set1_ps(static_cast<f32>(min_x)), PIXEL_CENTER_OFFSETS);
+
+            const __m256 edge_a[3] = {
+                _mm256_set1_ps(triangle.edge_a[0]),
+                _mm256_set1_ps(triangle.edge_a[1]),
+                _mm256_set1_ps(triangle.edge_a[2]),
+            };
+
+            const __m256 edge_step[3] = {
+                _mm256_set1_ps(triangle.edge_a[0] * 8.0f),
+                _mm256_set1_ps(triangle.edge_a[1] * 8.0f),
+                _mm256_set1_ps(triangle.edge_a[2] * 8.0f),
+            };
+
+            const __m256 depth_step = _mm256_set1_ps(triangle.depth_a * 8.0f);
+
+            for (i32 y = min_y; y <= max_y; y++)
+            {
+                const f32 pixel_y = static_cast<f32>(y) + 0.5f;
+
+                __m256 edges[3]{};
+                for (u32 i = 0u; i < 3u; i++)
+                {
+                    edges[i] = _mm256_add_ps(_mm256_mul_ps(edge_a[i], pixel_x),
+                                             _mm256_set1_ps(triangle.edge_b[i] * pixel_y + triangle.edge_c[i]));
+                }
+
+                __m256 depth = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.depth_a), pixel_x),
+                                             _mm256_set1_ps(triangle.depth_b * pixel_y + triangle.depth_c));
+
+                f32 *const depth_row = depth_buffer.data() + y * width;
+
+                for (i32 x = min_x; x <= triangle.max_x; x += 8)
+                {
+                    // A pixel is covered if all three edge functions are non negative, i.e if none of their sign bits
+                    // are set.
+                    const __m256 outside = _mm256_or_ps(_mm256_or_ps(edges[0], edges[1]), edges[2]);
+                    const u32 outside_mask = static_cast<u32>(_mm256_movemask_ps(outside));
+
+                    if (outside_mask != 0xffu)
+                    {
+                        const __m256 previous_depth = _mm256_loadu_ps(depth_row + x);
+                        const __m256 closest_depth = _mm256_max_ps(previous_depth, depth);
+
+                        _mm256_storeu_ps(depth_row + x, _mm256_blendv_ps(closest_depth, previous_depth, outside));
+                    }
+
+                    edges[0] = _mm256_add_ps(edges[0], edge_step[0]);
+                    edges[1] = _mm256_add_ps(edges[1], edge_step[1]);
+                    edges[2] = _mm256_add_ps(edges[2], edge_step[2]);
+                    depth = _mm256_add_ps(depth, depth_step);
+                }
+            }
+        }
+    }
+
+    // Build the hierarchical z tiles of the band.
+    for (i32 tile_y = band_min_y / static_cast<i32>(TILE_SIZE); tile_y <= band_max_y / static_cast<i32>(TILE_SIZE);
+         tile_y++)
+    {
+        for (u32 tile_x = 0u; tile_x < num_tiles_x; tile_x++)
+        {
+            const f32 *const tile_depth = depth_buffer.data() + tile_y * TILE_SIZE * width + tile_x * TILE_SIZE;
+
+            __m256 min_depth = _mm256_loadu_ps(tile_depth);
+            for (u32 row = 1u; row < TILE_SIZE; row++)
+            {
+                min_depth = _mm256_min_ps(min_depth, _mm256_loadu_ps(tile_depth + row * width));
+            }
+
+            hierarchical_depth_buffer[tile_y * num_tiles_x + tile_x] = get_horizontal_min(min_depth);
+        }
+    }
+}
+
+occlusion_culler_t::visibility_t occlusion_culler_t::get_visibility(const aabb_t &bounds) const
+{
+    if (!intersects(frustum, bounds))
+    {
+        return visibility_t::outside_frustum;
+    }
+
+    // Find the screen space rectangle of the box, and its closest depth. As depth is z / w, the closest point of the
+    // box is always one of its corners.
+    f32 min_x = INFINITY;
+    f32 min_y = INFINITY;
+    f32 max_x = -INFINITY;
+    f32 max_y = -INFINITY;
+    f32 max_depth = 0.0f;
+
+    for (u32 i = 0u; i < 8u; i++)
+    {
+        const float3_t corner = {
+            (i & 1u) ? bounds.max.x : bounds.min.x,
+            (i & 2u) ? bounds.max.y : bounds.min.y,
+            (i & 4u) ? bounds.max.z : bounds.min.z,
+        };
+
+        const float4_t v = transform_point(corner, view_projection_matrix);
+
+        // Boxes that cross the near plane are always considered visible.
+        if (v.w <= 0.0f || v.z > v.w)
+        {
+            return visibility_t::visible;
+        }
+
+        const f32 inverse_w = 1.0f / v.w;
+        const f32 x = (v.x * inverse_w * 0.5f + 0.5f) * width;
+        const f32 y = (0.5f - v.y * inverse_w * 0.5f) * height;
+
+        min_x = std::min(min_x, x);
+        min_y = std::min(min_y, y);
+        max_x = std::max(max_x, x);
+        max_y = std::max(max_y, y);
+        max_depth = std::max(max_depth, v.z * inverse_w);
+    }
+
+    // Every pixel that the rectangle touches.
+    const i32 rect_min_x = std::max(static_cast<i32>(std::floor(min_x)), 0);
+    const i32 rect_min_y = std::max(static_cast<i32>(std::floor(min_y)), 0);
+    const i32 rect_max_x = std::min(static_cast<i32>(std::floor(max_x)), static_cast<i32>(width) - 1);
+    const i32 rect_max_y = std::min(static_cast<i32>(std::floor(max_y)), static_cast<i32>(height) - 1);
+
+    if (rect_min_x > rect_max_x || rect_min_y > rect_max_y)
+    {
+        return visibility_t::outside_frustum;
+    }
+
+    const __m256 occludee_depth = _mm256_set1_ps(max_depth);
+
+    const i32 tile_size = static_cast<i32>(TILE_SIZE);
+    for (i32 tile_y = rect_min_y / tile_size; tile_y <= rect_max_y / tile_size; tile_y++)
+    {
+        for (i32 tile_x = rect_min_x / tile_size; tile_x <= rect_max_x / tile_size; tile_x++)
+        {
+            // The whole tile is covered by occluders that are closer than the occludee.
+            if (hierarchical_depth_buffer[tile_y * num_tiles_x + tile_x] > max_depth)
+            {
+                continue;
+            }
+
+            // Otherwise, test the pixels of the tile that are inside the rectangle.
+            const i32 tile_min_x = tile_x * tile_size;
+            const __m256 pixel_x = _mm256_add_ps(_mm256_set1_ps(static_cast<f32>(tile_min_x)), PIXEL_CENTER_OFFSETS);
+            const __m256 inside_rect = _mm256_and_ps(
+                _mm256_cmp_ps(pixel_x, _mm256_set1_ps(static_cast<f32>(rect_min_x)), _CMP_GE_OQ),
+                _mm256_cmp_ps(pixel_x, _mm256_set1_ps(static_cast<f32>(rect_max_x + 1)), _CMP_LT_OQ));
+
+            const i32 min_y = std::max(tile_y * tile_size, rect_min_y);
+            const i32 max_y = std::min(tile_y * tile_size + tile_size - 1, rect_max_y);
+
+            for (i32 y = min_y; y <= max_y; y++)
+            {
+                const __m256 depth = _mm256_loadu_ps(depth_buffer.data() + y * width + tile_min_x);
+                const __m256 not_occluded =
+                    _mm256_and_ps(_mm256_cmp_ps(depth, occludee_depth, _CMP_LE_OQ), inside_rect);
+
+                if (_mm256_movemask_ps(not_occluded) != 0)
+                {
+                    return visibility_t::visible;
+                }
+            }
+        }
+    }
+
+    return visibility_t::occluded;
+}
+} // namespace nether
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "common.hpp"
+#include "job_system.hpp"
+#include "math.hpp"
+
+namespace nether
+{
+struct occlusion_statistics_t
+{
+    u32 num_occluders{};
+    u32 num_rasterized_triangles{};
+
+    u32 num_occludees_tested{};
+    u32 num_outside_frustum{};
+    u32 num_occluded{};
+
+    f32 rasterization_time_in_ms{};
+    f32 test_time_in_ms{};
+};
+
+// CPU occlusion culling.
+// A small set of occluder meshes is rasterized into a low resolution depth buffer, 8 pixels at a time with AVX2
+// (the coverage of each triangle is a mask of the pixels whose centers pass all three edge functions). The depth
+// buffer is then reduced into a hierarchical z buffer of 8x8 pixel tiles, which stores the furthest occluder depth of
+// each tile. An occludee's screen space bounding rectangle is tested against the tiles first, and only tiles that are
+// not fully covered by closer occluder depth are refined at the pixel level.
+// Depth follows the engine's reverse z convention : 1 is at the near plane, 0 at the (infinite) far plane and is the
+// clear value, and a larger depth is closer to the camera.
+// The screen is split into horizontal bands, which are rasterized in parallel on the job system.
+class occlusion_culler_t
+{
+  public:
+    static constexpr u32 TILE_SIZE = 8u;
+    static constexpr u32 BAND_HEIGHT = 4u * TILE_SIZE;
+
+    // Width and height must be multiples of TILE_SIZE.
+    occlusion_culler_t(const u32 width, const u32 height);
+
+    // Removes the occluders of the last frame. rasterize must be called every frame (even without occluders), as it is
+    // also what clears the depth buffer.
+    void begin_frame(const float4x4_t &view_projection_matrix);
+
+    // The vertex and index data is not copied, and must stay alive until rasterize returns.
+    void add_occluder(const std::span<const float3_t> positions, const std::span<const u16> indices,
+                      const float4x4_t &model_matrix);
+    void add_occluder(const std::span<const float3_t> positions, const std::span<const u32> indices,
+                      const float4x4_t &model_matrix);
+
+    void rasterize(job_system_t *const job_system = nullptr);
+
+    // Returns false if the world space box is outside the frustum, or is hidden behind the occluders. Safe to call
+    // from multiple threads once rasterize has returned.
+    bool is_visible(const aabb_t &bounds) const;
+
+    // Tests all boxes (writing 1 to visibility for visible boxes and 0 otherwise) and updates the statistics.
+    void test_occludees(const std::span<const aabb_t> bounds, const std::span<u8> visibility,
+                        job_system_t *const job_system = nullptr);
+
+    u32 get_width() const
+    {
+        return width;
+    }
+
+    u32 get_height() const
+    {
+        return height;
+    }
+
+    // Reverse z depth of the pixel, mainly for debug visualization.
+    f32 get_depth(const u32 x, const u32 y) const
+    {
+        return depth_buffer[y * width + x];
+    }
+
+  private:
+    enum class visibility_t : u8
+    {
+        visible,
+        outside_frustum,
+        occluded,
+    };
+
+    // A triangle in screen space, with its edge functions and depth plane evaluated at pixel centers.
+    struct screen_triangle_t
+    {
+        // E(x, y) = a * x + b * y + c, which is >= 0 inside the triangle.
+        f32 edge_a[3]{};
+        f32 edge_b[3]{};
+        f32 edge_c[3]{};
+
+        // depth(x, y) = depth_a * x + depth_b * y + depth_c.
+        f32 depth_a{};
+        f32 depth_b{};
+        f32 depth_c{};
+
+        // Pixel bounds, inclusive and clamped to the screen.
+        i32 min_x{};
+        i32 min_y{};
+        i32 max_x{};
+        i32 max_y{};
+    };
+
+    struct occluder_t
+    {
+        std::span<const float3_t> positions{};
+        const u16 *indices_16{};
+        const u32 *indices_32{};
+        u32 num_indices{};
+
+        float4x4_t model_view_projection_matrix{};
+
+        // Scratch data that is reused across frames.
+        std::vector<float4_t> clip_space_positions{};
+        std::vector<screen_triangle_t> triangles{};
+    };
+
+    occluder_t &allocate_occluder(const std::span<const float3_t> positions, const float4x4_t &model_matrix);
+
+    // Transforms, clips (against the near plane) and sets up the triangles of an occluder.
+    void setup_triangles(occluder_t &occluder) const;
+
+    void add_triangle(occluder_t &occluder, const float4_t &v0, const float4_t &v1, const float4_t &v2) const;
+
+    void rasterize_band(const u32 band_index);
+
+    visibility_t get_visibility(const aabb_t &bounds) const;
+
+  private:
+    u32 width{};
+    u32 height{};
+    u32 num_tiles_x{};
+    u32 num_bands{};
+
+    float4x4_t view_projection_matrix{};
+    frustum_t frustum{};
+
+    std::vector<f32> depth_buffer{};
+
+    // Furthest (i.e smallest) depth of each TILE_SIZE x TILE_SIZE tile.
+    std::vector<f32> hierarchical_depth_buffer{};
+
+    // Occluders are never removed, only reset, so that their scratch memory can be reused.
+    std::vector<occluder_t> occluders{};
+    u32 num_occluders{};
+
+  public:
+    occlusion_statistics_t statistics{};
+};
+} // namespace nether
@@ -0,0 +1,502 @@
+#include "particles.hpp"
+
+#include "memory.hpp"
+
+#include <bit>
+#include <chrono>
+#include <immintrin.h>
+
+namespace nether
+{
+namespace
+{
+u32 round_up_to_multiple_of_8(const u32 value)
+{
+    return (value + 7u) & ~7u;
+}
+
+// Directional fields and drag do not depend on the particle's position, so all of them are folded into a single
+// constant acceleration and drag coefficient before integrating. Only point fields are evaluated per particle.
+struct point_force_field_t
+{
+    float3_t position{};
+    f32 strength{};
+    f32 inverse_radius{};
+};
+
+struct prepared_force_fields_t
+{
+    float3_t constant_acceleration{};
+    f32 drag{};
+
+    std::span<const point_force_field_t> point_fields{};
+};
+
+// Integrates the particles [begin, end) of the pool, 8 at a time. begin must be a multiple of 8 : the lanes past end
+// are padding (see particle_pool_t), and are integrated along with the others.
+void integrate_particles(particle_pool_t &pool, const u32 begin, const u32 end,
+                         const prepared_force_fields_t &force_fields, const f32 delta_time)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 min_distance = _mm256_set1_ps(1e-6f);
+
+    const __m256 dt = _mm256_set1_ps(delta_time);
+    const __m256 constant_acceleration_x = _mm256_set1_ps(force_fields.constant_acceleration.x);
+    const __m256 constant_acceleration_y = _mm256_set1_ps(force_fields.constant_acceleration.y);
+    const __m256 constant_acceleration_z = _mm256_set1_ps(force_fields.constant_acceleration.z);
+    const __m256 drag = _mm256_set1_ps(force_fields.drag);
+
+    for (u32 i = begin; i < end; i += 8u)
+    {
+        __m256 position_x = _mm256_loadu_ps(&pool.position_x[i]);
+        __m256 position_y = _mm256_loadu_ps(&pool.position_y[i]);
+        __m256 position_z = _mm256_loadu_ps(&pool.position_z[i]);
+
+        __m256 velocity_x = _mm256_loadu_ps(&pool.velocity_x[i]);
+        __m256 velocity_y = _mm256_loadu_ps(&pool.velocity_y[i]);
+        __m256 velocity_z = _mm256_loadu_ps(&pool.velocity_z[i]);
+
+        __m256 acceleration_x = _mm256_sub_ps(constant_acceleration_x, _mm256_mul_ps(velocity_x, drag));
+        __m256 acceleration_y = _mm256_sub_ps(constant_acceleration_y, _mm256_mul_ps(velocity_y, drag));
+        __m256 acceleration_z = _mm256_sub_ps(constant_acceleration_z, _mm256_mul_ps(velocity_z, drag));
+
+        for (const point_force_field_t &field : force_fields.point_fields)
+        {
+            const __m256 offset_x = _mm256_sub_ps(_mm256_set1_ps(field.position.x), position_x);
+            const __m256 offset_y = _mm256_sub_ps(_mm256_set1_ps(field.position.y), position_y);
+            const __m256 offset_z = _mm256_sub_ps(_mm256_set1_ps(field.position.z), position_z);
+
+            const __m256 distance = _mm256_sqrt_ps(_mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(offset_x, offset_x), _mm256_mul_ps(offset_y, offset_y)),
+                _mm256_mul_ps(offset_z, offset_z)));
+
+            // strength * max(1 - distance / radius, 0), divided by the distance to normalize the offset.
+            const __m256 falloff =
+                _mm256_max_ps(_mm256_sub_ps(one, _mm256_mul_ps(distance, _mm256_set1_ps(field.inverse_radius))), zero);
+            const __m256 scale = _mm256_div_ps(_mm256_mul_ps(_mm256_set1_ps(field.strength), falloff),
+                                               _mm256_max_ps(distance, min_distance));
+
+            acceleration_x = _mm256_add_ps(acceleration_x, _mm256_mul_ps(offset_x, scale));
+            acceleration_y = _mm256_add_ps(acceleration_y, _mm256_mul_ps(offset_y, scale));
+            acceleration_z = _mm256_add_ps(acceleration_z, _mm256_mul_ps(offset_z, scale));
+        }
+
+        // Semi implicit Euler : the new velocity moves the particle.
+        velocity_x = _mm256_add_ps(velocity_x, _mm256_mul_ps(acceleration_x, dt));
+        velocity_y = _mm256_add_ps(velocity_y, _mm256_mul_ps(acceleration_y, dt));
+        velocity_z = _mm256_add_ps(velocity_z, _mm256_mul_ps(acceleration_z, dt));
+
+        position_x = _mm256_add_ps(position_x, _mm256_mul_ps(velocity_x, dt));
+        position_y = _mm256_add_ps(position_y, _mm256_mul_ps(velocity_y, dt));
+        position_z = _mm256_add_ps(position_z, _mm256_mul_ps(velocity_z, dt));
+
+        _mm256_storeu_ps(&pool.position_x[i], position_x);
+        _mm256_storeu_ps(&pool.position_y[i], position_y);
+        _mm256_storeu_ps(&pool.position_z[i], position_z);
+
+        _mm256_storeu_ps(&pool.velocity_x[i], velocity_x);
+        _mm256_storeu_ps(&pool.velocity_y[i], velocity_y);
+        _mm256_storeu_ps(&pool.velocity_z[i], velocity_z);
+
+        _mm256_storeu_ps(&pool.age[i], _mm256_add_ps(_mm256_loadu_ps(&pool.age[i]), dt));
+    }
+}
+
+void move_particle(particle_pool_t &pool, const u32 destination, const u32 source)
+{
+    pool.position_x[destination] = pool.position_x[source];
+    pool.position_y[destination] = pool.position_y[source];
+    pool.position_z[destination] = pool.position_z[source];
+
+    pool.velocity_x[destination] = pool.velocity_x[source];
+    pool.velocity_y[destination] = pool.velocity_y[source];
+    pool.velocity_z[destination] = pool.velocity_z[source];
+
+    pool.age[destination] = pool.age[source];
+    pool.lifetime[destination] = pool.lifetime[source];
+}
+
+// Swap removes the particles whose age reached their lifetime. Returns the number of removed particles.
+u32 remove_dead_particles(particle_pool_t &pool)
+{
+    const u32 initial_count = pool.count;
+
+    u32 i = 0u;
+    while (i < pool.count)
+    {
+        // Most particles are alive : skip whole blocks of 8 live particles, and jump to the first dead one otherwise.
+        if ((i & 7u) == 0u && i + 8u <= pool.count)
+        {
+            const u32 dead_mask = static_cast<u32>(_mm256_movemask_ps(
+                _mm256_cmp_ps(_mm256_loadu_ps(&pool.age[i]), _mm256_loadu_ps(&pool.lifetime[i]), _CMP_GE_OQ)));
+            if (dead_mask == 0u)
+            {
+                i += 8u;
+                continue;
+            }
+
+            i += static_cast<u32>(std::countr_zero(dead_mask));
+        }
+
+        // The particle swapped in may be dead as well, so i is checked again.
+        if (pool.age[i] >= pool.lifetime[i])
+        {
+            move_particle(pool, i, --pool.count);
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    return initial_count - pool.count;
+}
+
+// A uniformly distributed direction in the cone of the given half angle around direction.
+float3_t get_random_cone_direction(const float3_t &direction, const f32 half_angle, std::mt19937 &random_engine)
+{
+    std::uniform_real_distribution<f32> unit_distribution(0.0f, 1.0f);
+
+    const f32 cos_theta = 1.0f - unit_distribution(random_engine) * (1.0f - std::cos(half_angle));
+    const f32 sin_theta = std::sqrt(std::max(1.0f - cos_theta * cos_theta, 0.0f));
+    const f32 phi = 2.0f * std::numbers::pi_v<f32> * unit_distribution(random_engine);
+
+    const float3_t up = std::abs(direction.y) < 0.99f ? float3_t{0.0f, 1.0f, 0.0f} : float3_t{1.0f, 0.0f, 0.0f};
+    const float3_t tangent = normalize(cross(up, direction));
+    const float3_t bitangent = cross(direction, tangent);
+
+    return tangent * (sin_theta * std::cos(phi)) + bitangent * (sin_theta * std::sin(phi)) + direction * cos_theta;
+}
+
+// A uniformly distributed point in the unit sphere (by rejection sampling).
+float3_t get_random_point_in_unit_sphere(std::mt19937 &random_engine)
+{
+    std::uniform_real_distribution<f32> distribution(-1.0f, 1.0f);
+
+    while (true)
+    {
+        const float3_t point = {distribution(random_engine), distribution(random_engine), distribution(random_engine)};
+        if (dot(point, point) <= 1.0f)
+        {
+            return point;
+        }
+    }
+}
+
+// Returns the number of emitted particles.
+u32 emit_particles(particle_emitter_t &emitter, const f32 delta_time)
+{
+    const particle_emitter_desc_t &desc = emitter.desc;
+    particle_pool_t &pool = emitter.pool;
+
+    emitter.emission_accumulator += desc.emission_rate * delta_time;
+    const u32 num_requested_particles = static_cast<u32>(emitter.emission_accumulator);
+    emitter.emission_accumulator -= static_cast<f32>(num_requested_particles);
+
+    // The particles that do not fit are dropped rather than delayed, so that a full emitter does not burst as soon as
+    // it has room again.
+    const u32 num_emitted_particles = std::min(num_requested_particles, desc.max_particles - pool.count);
+
+    std::uniform_real_distribution<f32> speed_distribution(desc.min_speed, desc.max_speed);
+    std::uniform_real_distribution<f32> lifetime_distribution(desc.min_lifetime_in_s, desc.max_lifetime_in_s);
+
+    for (u32 i = 0u; i < num_emitted_particles; i++)
+    {
+        const u32 index = pool.count++;
+
+        const float3_t position = desc.emission_radius > 0.0f
+                                      ? desc.position + get_random_point_in_unit_sphere(emitter.random_engine) *
+                                                            desc.emission_radius
+                                      : desc.position;
+        const float3_t velocity =
+            get_random_cone_direction(desc.direction, desc.spread_angle_in_radians, emitter.random_engine) *
+            speed_distribution(emitter.random_engine);
+
+        pool.position_x[index] = position.x;
+        pool.position_y[index] = position.y;
+        pool.position_z[index] = position.z;
+
+        pool.velocity_x[index] = velocity.x;
+        pool.velocity_y[index] = velocity.y;
+        pool.velocity_z[index] = velocity.z;
+
+        pool.age[index] = 0.0f;
+        pool.lifetime[index] = lifetime_distribution(emitter.random_engine);
+    }
+
+    return num_emitted_particles;
+}
+
+// Writes the particles [begin, end) of the emitter, computing 8 sizes and colors at once. begin must be a multiple of
+// 8.
+void write_particle_vertices(const particle_emitter_t &emitter, const u32 begin, const u32 end,
+                             particle_vertex_t *vertices)
+{
+    const particle_emitter_desc_t &desc = emitter.desc;
+    const particle_pool_t &pool = emitter.pool;
+
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    const __m256 start_size = _mm256_set1_ps(desc.start_size);
+    const __m256 size_range = _mm256_set1_ps(desc.end_size - desc.start_size);
+
+    // Colors are interpolated in [0, 255].
+    const __m256 start_color[4] = {
+        _mm256_set1_ps(desc.start_color.x * 255.0f),
+        _mm256_set1_ps(desc.start_color.y * 255.0f),
+        _mm256_set1_ps(desc.start_color.z * 255.0f),
+        _mm256_set1_ps(desc.start_color.w * 255.0f),
+    };
+    const __m256 color_range[4] = {
+        _mm256_set1_ps((desc.end_color.x - desc.start_color.x) * 255.0f),
+        _mm256_set1_ps((desc.end_color.y - desc.start_color.y) * 255.0f),
+        _mm256_set1_ps((desc.end_color.z - desc.start_color.z) * 255.0f),
+        _mm256_set1_ps((desc.end_color.w - desc.start_color.w) * 255.0f),
+    };
+
+    alignas(32) f32 sizes[8]{};
+    alignas(32) u32 colors[8]{};
+
+    for (u32 i = begin; i < end; i += 8u)
+    {
+        const __m256 t = _mm256_min_ps(
+            _mm256_max_ps(_mm256_div_ps(_mm256_loadu_ps(&pool.age[i]), _mm256_loadu_ps(&pool.lifetime[i])), zero),
+            one);
+
+        _mm256_store_ps(sizes, _mm256_add_ps(start_size, _mm256_mul_ps(size_range, t)));
+
+        __m256i color = _mm256_setzero_si256();
+        for (u32 channel = 0u; channel < 4u; channel++)
+        {
+            const __m256 value =
+                _mm256_add_ps(_mm256_add_ps(start_color[channel], _mm256_mul_ps(color_range[channel], t)), half);
+            const __m256i quantized_value = _mm256_min_epi32(
+                _mm256_max_epi32(_mm256_cvttps_epi32(value), _mm256_setzero_si256()), _mm256_set1_epi32(255));
+            color = _mm256_or_si256(color, _mm256_slli_epi32(quantized_value, static_cast<i32>(channel * 8u)));
+        }
+        _mm256_store_si256(reinterpret_cast<__m256i *>(colors), color);
+
+        const u32 num_lanes = std::min(end - i, 8u);
+        for (u32 lane = 0u; lane < num_lanes; lane++)
+        {
+            *vertices++ = particle_vertex_t{
+                .position = {pool.position_x[i + lane], pool.position_y[i + lane], pool.position_z[i + lane]},
+                .size = sizes[lane],
+                .color = colors[lane],
+            };
+        }
+    }
+}
+} // namespace
+
+u32 particle_system_t::add_emitter(const particle_emitter_desc_t &desc)
+{
+    if (desc.max_particles == 0u)
+    {
+        throw std::runtime_error("Particle emitters must have a max_particles greater than 0");
+    }
+
+    if (desc.min_lifetime_in_s <= 0.0f || desc.max_lifetime_in_s < desc.min_lifetime_in_s)
+    {
+        throw std::runtime_error(std::format("Invalid particle lifetime range [{}, {}]", desc.min_lifetime_in_s,
+                                             desc.max_lifetime_in_s));
+    }
+
+    particle_emitter_t &emitter = emitters.emplace_back();
+    emitter.desc = desc;
+    emitter.random_engine.seed(desc.seed);
+
+    particle_pool_t &pool = emitter.pool;
+    pool.capacity = round_up_to_multiple_of_8(desc.max_particles);
+
+    // The padding is zero initialized (with a non zero lifetime) so that integrating it never produces denormals or
+    // NaNs.
+    pool.position_x.resize(pool.capacity);
+    pool.position_y.resize(pool.capacity);
+    pool.position_z.resize(pool.capacity);
+    pool.velocity_x.resize(pool.capacity);
+    pool.velocity_y.resize(pool.capacity);
+    pool.velocity_z.resize(pool.capacity);
+    pool.age.resize(pool.capacity);
+    pool.lifetime.resize(pool.capacity, 1.0f);
+
+    return static_cast<u32>(emitters.size() - 1u);
+}
+
+void particle_system_t::gather_chunks()
+{
+    chunks.clear();
+
+    u32 first_vertex = 0u;
+    for (u32 emitter_index = 0u; emitter_index < static_cast<u32>(emitters.size()); emitter_index++)
+    {
+        const u32 count = emitters[emitter_index].pool.count;
+        for (u32 begin = 0u; begin < count; begin += CHUNK_SIZE)
+        {
+            const u32 end = std::min(begin + CHUNK_SIZE, count);
+            chunks.push_back(particle_chunk_t{
+                .emitter_index = emitter_index,
+                .begin = begin,
+                .end = end,
+                .first_vertex = first_vertex,
+            });
+
+            first_vertex += end - begin;
+        }
+    }
+}
+
+void particle_system_t::update(const f32 delta_time, job_system_t *const job_system)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    memory::scratch_scope_t scope{};
+    memory::linear_arena_t &arena = scope.get_arena();
+
+    prepared_force_fields_t prepared_force_fields{};
+
+    const u32 num_point_fields = static_cast<u32>(std::ranges::count_if(
+        force_fields, [](const force_field_t &field) { return field.type == force_field_type_t::point; }));
+    point_force_field_t *const point_fields = arena.allocate_array<point_force_field_t>(num_point_fields);
+    prepared_force_fields.point_fields = {point_fields, num_point_fields};
+
+    u32 point_field_index = 0u;
+    for (const force_field_t &field : force_fields)
+    {
+        switch (field.type)
+        {
+        case force_field_type_t::directional: {
+            prepared_force_fields.constant_acceleration =
+                prepared_force_fields.constant_acceleration + field.vector * field.strength;
+        }
+        break;
+
+        case force_field_type_t::point: {
+            point_fields[point_field_index++] = point_force_field_t{
+                .position = field.vector,
+                .strength = field.strength,
+                .inverse_radius = 1.0f / field.radius,
+            };
+        }
+        break;
+
+        case force_field_type_t::drag: {
+            prepared_force_fields.drag += field.strength;
+        }
+        break;
+        }
+    }
+
+    // Integration, in parallel over chunks. Chunks start at multiples of CHUNK_SIZE, so their padded ranges never
+    // overlap.
+    gather_chunks();
+
+    const auto integrate = [&](const u32 begin, const u32 end, const u32) {
+        for (u32 i = begin; i < end; i++)
+        {
+            const particle_chunk_t &chunk = chunks[i];
+            integrate_particles(emitters[chunk.emitter_index].pool, chunk.begin, round_up_to_multiple_of_8(chunk.end),
+                                prepared_force_fields, delta_time);
+        }
+    };
+
+    // Compaction and emission, in parallel over emitters.
+    const u32 num_emitters = static_cast<u32>(emitters.size());
+    u32 *const num_killed_particles = arena.allocate_array<u32>(num_emitters);
+    u32 *const num_emitted_particles = arena.allocate_array<u32>(num_emitters);
+
+    const auto compact_and_emit = [&](const u32 begin, const u32 end, const u32) {
+        for (u32 i = begin; i < end; i++)
+        {
+            num_killed_particles[i] = remove_dead_particles(emitters[i].pool);
+            num_emitted_particles[i] = emit_particles(emitters[i], delta_time);
+        }
+    };
+
+    if (job_system)
+    {
+        job_system->parallel_for(static_cast<u32>(chunks.size()), 1u, integrate);
+        job_system->parallel_for(num_emitters, 1u, compact_and_emit);
+    }
+    else
+    {
+        integrate(0u, static_cast<u32>(chunks.size()), 0u);
+        compact_and_emit(0u, num_emitters, 0u);
+    }
+
+    statistics.num_emitters = num_emitters;
+    statistics.num_particles = get_num_particles();
+    statistics.num_killed_particles = 0u;
+    statistics.num_emitted_particles = 0u;
+    for (u32 i = 0u; i < num_emitters; i++)
+    {
+        statistics.num_killed_particles += num_killed_particles[i];
+        statistics.num_emitted_particles += num_emitted_particles[i];
+    }
+
+    statistics.simulation_time_in_ms =
+        std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+u32 particle_system_t::write_vertices(const std::span<particle_vertex_t> vertices, job_system_t *const job_system)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const u32 num_particles = get_num_particles();
+    if (vertices.size() < num_particles)
+    {
+        throw std::runtime_error(
+            std::format("{} particle vertices can not hold {} particles", vertices.size(), num_particles));
+    }
+
+    gather_chunks();
+
+    const auto write = [&](const u32 begin, const u32 end, const u32) {
+        for (u32 i = begin; i < end; i++)
+        {
+            const particle_chunk_t &chunk = chunks[i];
+            write_particle_vertices(emitters[chunk.emitter_index], chunk.begin, chunk.end,
+                                    vertices.data() + chunk.first_vertex);
+        }
+    };
+
+    if (job_system)
+    {
+        job_system->parallel_for(static_cast<u32>(chunks.size()), 1u, write);
+    }
+    else
+    {
+        write(0u, static_cast<u32>(chunks.size()), 0u);
+    }
+
+    statistics.write_time_in_ms =
+        std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+    return num_particles;
+}
+
+u32 particle_system_t::get_num_particles() const
+{
+    u32 num_particles = 0u;
+    for (const particle_emitter_t &emitter : emitters)
+    {
+        num_particles += emitter.pool.count;
+    }
+
+    return num_particles;
+}
+
+u32 particle_system_t::get_max_particles() const
+{
+    u32 max_particles = 0u;
+    for (const particle_emitter_t &emitter : emitters)
+    {
+        max_particles += emitter.desc.max_particles;
+    }
+
+    return max_particles;
+}
+} // namespace nether
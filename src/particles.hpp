@@ -0,0 +1,168 @@
+#pragma once
+
+#include "common.hpp"
+#include "job_system.hpp"
+#include "math.hpp"
+
+// CPU particle simulation, laid out for SIMD.
+//  - Each emitter owns a fixed capacity SoA pool (one array per attribute), padded to a multiple of 8 so that the
+//    integration processes 8 particles at once with AVX2 without a scalar tail.
+//  - Dead particles are removed by swapping the last live particle into their slot, which keeps the live particles
+//    contiguous at the cost of their order.
+//  - update runs in parallel over chunks of every emitter (integration) and then over emitters (compaction and
+//    emission), and write_vertices writes the live particles of all emitters into one (usually mapped upload) buffer
+//    that shaders/particle_shader.hlsl expands into camera facing quads.
+namespace nether
+{
+struct particle_emitter_desc_t
+{
+    float3_t position{};
+
+    // Particles are emitted in a cone around direction (which must be normalized), at a uniformly distributed point
+    // of the sphere of radius emission_radius around position.
+    float3_t direction{0.0f, 1.0f, 0.0f};
+    f32 spread_angle_in_radians{0.25f};
+    f32 emission_radius{};
+
+    f32 min_speed{1.0f};
+    f32 max_speed{2.0f};
+
+    f32 min_lifetime_in_s{1.0f};
+    f32 max_lifetime_in_s{2.0f};
+
+    // Particles per second. Particles that do not fit in max_particles are not emitted.
+    f32 emission_rate{100.0f};
+    u32 max_particles{1024u};
+
+    // Interpolated over a particle's lifetime.
+    float4_t start_color{1.0f, 1.0f, 1.0f, 1.0f};
+    float4_t end_color{1.0f, 1.0f, 1.0f, 1.0f};
+    f32 start_size{0.1f};
+    f32 end_size{0.1f};
+
+    u32 seed{};
+};
+
+enum class force_field_type_t : u8
+{
+    // Constant acceleration along vector (e.g gravity or wind) : vector * strength.
+    directional,
+
+    // Attracts particles towards vector (a position) with an acceleration of strength, which falls off linearly to 0
+    // at radius. A negative strength repels.
+    point,
+
+    // Acceleration of -velocity * strength. vector is unused.
+    drag,
+};
+
+struct force_field_t
+{
+    force_field_type_t type{force_field_type_t::directional};
+    float3_t vector{};
+    f32 strength{};
+    f32 radius{1.0f};
+};
+
+// The live particles of an emitter are [0, count). Every array has capacity elements, capacity being max_particles
+// rounded up to a multiple of 8 : the elements past count are never read by anything but the integration.
+struct particle_pool_t
+{
+    u32 count{};
+    u32 capacity{};
+
+    std::vector<f32> position_x{};
+    std::vector<f32> position_y{};
+    std::vector<f32> position_z{};
+
+    std::vector<f32> velocity_x{};
+    std::vector<f32> velocity_y{};
+    std::vector<f32> velocity_z{};
+
+    std::vector<f32> age{};
+    std::vector<f32> lifetime{};
+};
+
+struct particle_emitter_t
+{
+    particle_emitter_desc_t desc{};
+    particle_pool_t pool{};
+
+    std::mt19937 random_engine{};
+
+    // Fractional particles left over from previous updates.
+    f32 emission_accumulator{};
+};
+
+// Per particle data read by the particle shader. Must match particle_vertex_t in shaders/particle_shader.hlsl.
+struct particle_vertex_t
+{
+    float3_t position{};
+    f32 size{};
+
+    // RGBA8 unorm, red in the lowest byte.
+    u32 color{};
+};
+
+struct particle_statistics_t
+{
+    u32 num_emitters{};
+    u32 num_particles{};
+
+    // During the last update.
+    u32 num_emitted_particles{};
+    u32 num_killed_particles{};
+
+    f32 simulation_time_in_ms{};
+    f32 write_time_in_ms{};
+};
+
+class particle_system_t
+{
+  public:
+    // Particles are split into chunks of this size so that a single large emitter still updates in parallel.
+    static constexpr u32 CHUNK_SIZE = 4096u;
+
+    // Returns the index of the emitter. Throws if max_particles is 0.
+    u32 add_emitter(const particle_emitter_desc_t &desc);
+
+    // Integrates every live particle over delta_time (in seconds) under the force fields, removes the particles that
+    // reached the end of their lifetime, and then emits new particles. Newly emitted particles are not integrated
+    // until the next update.
+    void update(const f32 delta_time, job_system_t *const job_system = nullptr);
+
+    // Writes the live particles of every emitter, in emitter order, and returns how many were written. Throws if
+    // vertices can not hold get_num_particles() particles. vertices is only written to, so it can be write combined
+    // upload memory.
+    u32 write_vertices(const std::span<particle_vertex_t> vertices, job_system_t *const job_system = nullptr);
+
+    u32 get_num_particles() const;
+
+    // Sum of the emitters' max_particles : the size write_vertices needs in the worst case.
+    u32 get_max_particles() const;
+
+  public:
+    std::vector<particle_emitter_t> emitters{};
+
+    // Applied to the particles of every emitter.
+    std::vector<force_field_t> force_fields{};
+
+    particle_statistics_t statistics{};
+
+  private:
+    // The particles [begin, end) of an emitter, which write_vertices writes starting at first_vertex.
+    struct particle_chunk_t
+    {
+        u32 emitter_index{};
+        u32 begin{};
+        u32 end{};
+        u32 first_vertex{};
+    };
+
+    // Splits the live particles of every emitter into chunks.
+    void gather_chunks();
+
+  private:
+    std::vector<particle_chunk_t> chunks{};
+};
+} // namespace nether
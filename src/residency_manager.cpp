@@ -0,0 +1,69 @@
+#include "residency_manager.hpp"
+
+namespace nether
+{
+residency_manager_t::residency_manager_t(ID3D12Device *const device, IDXGIAdapter3 *const adapter,
+                                         const residency_policy_config_t &config)
+    : device(device), adapter(adapter), policy(config)
+{
+}
+
+u32 residency_manager_t::register_resource(ID3D12Pageable *const resource, const u64 size_in_bytes)
+{
+    const u32 handle = policy.register_resource(size_in_bytes, frame_index);
+    if (handle >= resources.size())
+    {
+        resources.resize(handle + 1u);
+    }
+
+    resources[handle] = resource;
+
+    return handle;
+}
+
+void residency_manager_t::unregister_resource(const u32 handle)
+{
+    policy.unregister_resource(handle);
+    resources[handle] = nullptr;
+}
+
+void residency_manager_t::update()
+{
+    throw_if_failed(adapter->QueryVideoMemoryInfo(0u, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &video_memory_info));
+
+    // CurrentUsage includes the registered resources that are resident, which are accounted for by the policy itself.
+    const u64 registered_resident_bytes = policy.statistics.resident_bytes;
+    const u64 unregistered_bytes = video_memory_info.CurrentUsage > registered_resident_bytes
+                                       ? video_memory_info.CurrentUsage - registered_resident_bytes
+                                       : 0u;
+    const u64 budget =
+        video_memory_info.Budget > unregistered_bytes ? video_memory_info.Budget - unregistered_bytes : 0u;
+
+    const residency_changes_t &changes = policy.update(frame_index, budget);
+
+    // Evict first, so that the memory is available to the resources that are made resident.
+    if (!changes.evicted_resources.empty())
+    {
+        pageables.clear();
+        for (const u32 handle : changes.evicted_resources)
+        {
+            pageables.push_back(resources[handle]);
+        }
+
+        throw_if_failed(device->Evict(static_cast<UINT>(pageables.size()), pageables.data()));
+    }
+
+    // MakeResident blocks until the resources are resident, which is what the frame that is about to be submitted
+    // needs.
+    if (!changes.resident_resources.empty())
+    {
+        pageables.clear();
+        for (const u32 handle : changes.resident_resources)
+        {
+            pageables.push_back(resources[handle]);
+        }
+
+        throw_if_failed(device->MakeResident(static_cast<UINT>(pageables.size()), pageables.data()));
+    }
+}
+} // namespace nether
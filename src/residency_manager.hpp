@@ -0,0 +1,65 @@
+#pragma once
+
+#include "common.hpp"
+#include "residency_policy.hpp"
+
+namespace nether
+{
+// Keeps the renderer's resources under the video memory budget, by evicting the least recently used resources and
+// making them resident again when they are used (see residency_policy_t, which makes the decisions).
+// The budget is polled from DXGI every frame. Memory used by resources that are not registered (swapchain, driver
+// allocations, ...) is taken out of the budget before it is handed to the policy.
+class residency_manager_t
+{
+  public:
+    explicit residency_manager_t(ID3D12Device *const device, IDXGIAdapter3 *const adapter,
+                                 const residency_policy_config_t &config = {});
+
+    // The resource must be resident when registered (which is the case for newly created committed resources and
+    // heaps).
+    u32 register_resource(ID3D12Pageable *const resource, const u64 size_in_bytes);
+    void unregister_resource(const u32 handle);
+
+    // Marks a resource as used by the frame being recorded.
+    void mark_used(const u32 handle)
+    {
+        policy.mark_used(handle, frame_index);
+    }
+
+    // Makes the used resources resident and evicts resources if over the budget. Must be called after the frame's
+    // resources are marked as used, and before the frame's command lists are executed.
+    void update();
+
+    // Moves on to the next frame. Call once per frame, after update.
+    void end_frame()
+    {
+        frame_index++;
+    }
+
+    const residency_statistics_t &get_statistics() const
+    {
+        return policy.statistics;
+    }
+
+    // The local video memory info returned by the last update.
+    const DXGI_QUERY_VIDEO_MEMORY_INFO &get_video_memory_info() const
+    {
+        return video_memory_info;
+    }
+
+  private:
+    ComPtr<ID3D12Device> device{};
+    ComPtr<IDXGIAdapter3> adapter{};
+
+    residency_policy_t policy;
+
+    // Indexed by the policy's handles.
+    std::vector<ID3D12Pageable *> resources{};
+
+    // Scratch space for the Evict / MakeResident calls.
+    std::vector<ID3D12Pageable *> pageables{};
+
+    DXGI_QUERY_VIDEO_MEMORY_INFO video_memory_info{};
+    u64 frame_index{};
+};
+} // namespace nether
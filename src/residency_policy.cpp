@@ -0,0 +1,219 @@
+#include "residency_policy.hpp"
+
+namespace nether
+{
+residency_policy_t::residency_policy_t(const residency_policy_config_t &config) : config(config)
+{
+    if (config.low_watermark > config.high_watermark)
+    {
+        throw std::runtime_error("Residency policy low watermark must not be above the high watermark");
+    }
+
+    // Resources made resident by an update are used in the current frame, and must not be evicted by the same update.
+    if (config.min_frames_before_eviction == 0u)
+    {
+        throw std::runtime_error("Residency policy min_frames_before_eviction must be at least 1");
+    }
+}
+
+u32 residency_policy_t::register_resource(const u64 size_in_bytes, const u64 frame_index)
+{
+    u32 handle = INVALID_HANDLE;
+    if (!free_handles.empty())
+    {
+        handle = free_handles.back();
+        free_handles.pop_back();
+    }
+    else
+    {
+        handle = static_cast<u32>(resources.size());
+        resources.emplace_back();
+    }
+
+    resources[handle] = {
+        .size_in_bytes = size_in_bytes,
+        .last_used_frame = frame_index,
+        .resident = true,
+        .registered = true,
+    };
+
+    link_to_front(handle);
+
+    statistics.num_resources++;
+    statistics.num_resident_resources++;
+    statistics.resident_bytes += size_in_bytes;
+
+    return handle;
+}
+
+void residency_policy_t::unregister_resource(const u32 handle)
+{
+    resource_t &resource = resources[handle];
+    if (!resource.registered)
+    {
+        throw std::runtime_error("Unregistering a resource that is not registered with the residency policy");
+    }
+
+    if (resource.resident)
+    {
+        unlink(handle);
+
+        statistics.num_resident_resources--;
+        statistics.resident_bytes -= resource.size_in_bytes;
+    }
+
+    std::erase(pending_resident_resources, handle);
+
+    resource = {};
+    free_handles.push_back(handle);
+
+    statistics.num_resources--;
+}
+
+void residency_policy_t::mark_used(const u32 handle, const u64 frame_index)
+{
+    resource_t &resource = resources[handle];
+    if (resource.last_used_frame == frame_index)
+    {
+        return;
+    }
+
+    resource.last_used_frame = frame_index;
+
+    if (resource.resident)
+    {
+        statistics.num_hits++;
+
+        unlink(handle);
+        link_to_front(handle);
+    }
+    else
+    {
+        statistics.num_misses++;
+        pending_resident_resources.push_back(handle);
+    }
+}
+
+const residency_changes_t &residency_policy_t::update(const u64 frame_index, const u64 budget_in_bytes)
+{
+    changes.evicted_resources.clear();
+    changes.resident_resources.clear();
+
+    statistics.budget_bytes = budget_in_bytes;
+
+    // Used resources must be resident, whatever the budget.
+    for (const u32 handle : pending_resident_resources)
+    {
+        resource_t &resource = resources[handle];
+        if (resource.resident)
+        {
+            continue;
+        }
+
+        resource.resident = true;
+        link_to_front(handle);
+
+        statistics.num_resident_resources++;
+        statistics.resident_bytes += resource.size_in_bytes;
+        statistics.num_made_resident++;
+        statistics.made_resident_bytes += resource.size_in_bytes;
+
+        changes.resident_resources.push_back(handle);
+    }
+
+    pending_resident_resources.clear();
+
+    const u64 high_watermark_bytes = static_cast<u64>(static_cast<f64>(budget_in_bytes) * config.high_watermark);
+    const u64 low_watermark_bytes = static_cast<u64>(static_cast<f64>(budget_in_bytes) * config.low_watermark);
+
+    if (statistics.resident_bytes <= high_watermark_bytes)
+    {
+        return changes;
+    }
+
+    // Evict from the least recently used end, stopping at the first resource that is too recent (everything before it
+    // in the list is at least as recent).
+    while (statistics.resident_bytes > low_watermark_bytes && lru_tail != INVALID_HANDLE)
+    {
+        const u32 handle = lru_tail;
+        resource_t &resource = resources[handle];
+
+        if (resource.last_used_frame + config.min_frames_before_eviction > frame_index)
+        {
+            break;
+        }
+
+        unlink(handle);
+        resource.resident = false;
+
+        statistics.num_resident_resources--;
+        statistics.resident_bytes -= resource.size_in_bytes;
+        statistics.num_evictions++;
+        statistics.evicted_bytes += resource.size_in_bytes;
+
+        changes.evicted_resources.push_back(handle);
+    }
+
+    if (statistics.resident_bytes > budget_in_bytes)
+    {
+        statistics.num_over_budget_updates++;
+    }
+
+    return changes;
+}
+
+void residency_policy_t::reset_statistics()
+{
+    statistics.num_hits = 0u;
+    statistics.num_misses = 0u;
+    statistics.num_evictions = 0u;
+    statistics.evicted_bytes = 0u;
+    statistics.num_made_resident = 0u;
+    statistics.made_resident_bytes = 0u;
+    statistics.num_over_budget_updates = 0u;
+}
+
+void residency_policy_t::link_to_front(const u32 handle)
+{
+    resource_t &resource = resources[handle];
+    resource.previous = INVALID_HANDLE;
+    resource.next = lru_head;
+
+    if (lru_head != INVALID_HANDLE)
+    {
+        resources[lru_head].previous = handle;
+    }
+    else
+    {
+        lru_tail = handle;
+    }
+
+    lru_head = handle;
+}
+
+void residency_policy_t::unlink(const u32 handle)
+{
+    resource_t &resource = resources[handle];
+
+    if (resource.previous != INVALID_HANDLE)
+    {
+        resources[resource.previous].next = resource.next;
+    }
+    else
+    {
+        lru_head = resource.next;
+    }
+
+    if (resource.next != INVALID_HANDLE)
+    {
+        resources[resource.next].previous = resource.previous;
+    }
+    else
+    {
+        lru_tail = resource.previous;
+    }
+
+    resource.previous = INVALID_HANDLE;
+    resource.next = INVALID_HANDLE;
+}
+} // namespace nether
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace nether
+{
+struct residency_policy_config_t
+{
+    // Eviction starts once the resident resources use more than high_watermark * budget, and then evicts least
+    // recently used resources until they use at most low_watermark * budget. The gap between the two keeps the
+    // policy from evicting a little every frame when the working set hovers around the budget.
+    f32 high_watermark{0.95f};
+    f32 low_watermark{0.85f};
+
+    // Resources used in the last min_frames_before_eviction frames are never evicted, as the GPU may still be using
+    // them (this should be at least the number of frames in flight).
+    u32 min_frames_before_eviction{3u};
+};
+
+struct residency_statistics_t
+{
+    u32 num_resources{};
+    u32 num_resident_resources{};
+    u64 resident_bytes{};
+
+    // The budget passed to the last update.
+    u64 budget_bytes{};
+
+    // A use of a resident resource is a hit, and a use of an evicted resource (which has to be made resident again) is
+    // a miss. Resources count at most once per frame.
+    u64 num_hits{};
+    u64 num_misses{};
+
+    // Churn : resources (and bytes) evicted and made resident again.
+    u64 num_evictions{};
+    u64 evicted_bytes{};
+    u64 num_made_resident{};
+    u64 made_resident_bytes{};
+
+    // Updates where the resources that had to stay resident alone exceeded the budget.
+    u64 num_over_budget_updates{};
+
+    f64 get_hit_rate() const
+    {
+        const u64 num_uses = num_hits + num_misses;
+        return num_uses ? static_cast<f64>(num_hits) / static_cast<f64>(num_uses) : 1.0;
+    }
+};
+
+// The resources to evict / make resident, as decided by the last update.
+struct residency_changes_t
+{
+    std::vector<u32> evicted_resources{};
+    std::vector<u32> resident_resources{};
+};
+
+// Decides which resources should be resident in video memory, without knowing anything about the GPU API, so that it
+// can be driven by synthetic access traces as well as by the renderer (see residency_manager_t).
+// Resources are identified by the handle returned by register_resource. Every frame, the resources that are used are
+// marked with mark_used, and update then returns the resources that must be made resident (used, but evicted) and
+// the least recently used resources to evict to get back under the budget.
+class residency_policy_t
+{
+  public:
+    static constexpr u32 INVALID_HANDLE = ~0u;
+
+    explicit residency_policy_t(const residency_policy_config_t &config = {});
+
+    // Newly created resources are resident, and count as used in frame_index.
+    u32 register_resource(const u64 size_in_bytes, const u64 frame_index);
+    void unregister_resource(const u32 handle);
+
+    void mark_used(const u32 handle, const u64 frame_index);
+
+    // budget_in_bytes is the memory available to the registered resources.
+    const residency_changes_t &update(const u64 frame_index, const u64 budget_in_bytes);
+
+    bool is_resident(const u32 handle) const
+    {
+        return resources[handle].resident;
+    }
+
+    u64 get_size(const u32 handle) const
+    {
+        return resources[handle].size_in_bytes;
+    }
+
+    // Clears the hit / miss and churn counters.
+    void reset_statistics();
+
+  public:
+    residency_statistics_t statistics{};
+
+  private:
+    struct resource_t
+    {
+        u64 size_in_bytes{};
+        u64 last_used_frame{};
+
+        // Resident resources are linked in most recently used order. Evicted resources are not in the list.
+        u32 previous{INVALID_HANDLE};
+        u32 next{INVALID_HANDLE};
+
+        bool resident{};
+        bool registered{};
+    };
+
+    void link_to_front(const u32 handle);
+    void unlink(const u32 handle);
+
+  private:
+    residency_policy_config_t config{};
+
+    std::vector<resource_t> resources{};
+    std::vector<u32> free_handles{};
+
+    // Most / least recently used resident resources.
+    u32 lru_head{INVALID_HANDLE};
+    u32 lru_tail{INVALID_HANDLE};
+
+    // Evicted resources used since the last update.
+    std::vector<u32> pending_resident_resources{};
+
+    residency_changes_t changes{};
+};
+} // namespace nether
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "common.hpp"
+#include "ecs.hpp"
+#include "math.hpp"
+
+// Components that make up the scene. Scene objects are entities of the ecs world, with a combination of these
+// components.
+namespace nether::scene
+{
+struct transform_component_t
+{
+    float3_t translation{};
+
+    // Pitch, yaw and roll (in radians).
+    float3_t rotation{};
+
+    float3_t scale{1.0f, 1.0f, 1.0f};
+
+    // Computed from the translation, rotation and scale by update_transforms.
+    float4x4_t model_matrix{};
+};
+
+// Continuously rotates the entity.
+struct spin_component_t
+{
+    // Pitch, yaw and roll added to the rotation every frame (in radians).
+    float3_t angular_velocity{};
+};
+
+struct mesh_renderer_component_t
+{
+    u32 mesh_index{};
+    u32 pipeline_index{};
+    u32 material_index{};
+
+    float4_t color{1.0f, 1.0f, 1.0f, 1.0f};
+
+    // Index of the entity's record in the renderer's GPU scene (see gpu_scene.hpp).
+    u32 gpu_scene_object_index{};
+};
+
+// Tag for mesh renderers whose mesh is rasterized by the occlusion culler, to hide the objects behind it. Only large,
+// simple meshes make good occluders.
+struct occluder_component_t
+{
+};
+
+// Lights are positioned by the entity's transform, and are culled by the clustered lighting (see
+// clustered_lighting.hpp).
+struct point_light_component_t
+{
+    float4_t color{1.0f, 1.0f, 1.0f, 1.0f};
+
+    // The light has no effect beyond its range.
+    f32 range{10.0f};
+    f32 intensity{1.0f};
+};
+
+// Points along the +z axis of the entity's transform.
+struct spot_light_component_t
+{
+    float4_t color{1.0f, 1.0f, 1.0f, 1.0f};
+
+    f32 range{10.0f};
+    f32 intensity{1.0f};
+
+    // Half angles (in radians). The light fades out between the inner and outer angle.
+    f32 inner_cone_angle{0.3f};
+    f32 outer_cone_angle{0.5f};
+};
+
+// A first person fly camera.
+struct camera_component_t
+{
+    float3_t position{};
+    float3_t front{0.0f, 0.0f, 1.0f};
+    float3_t right{1.0f, 0.0f, 0.0f};
+
+    // The current velocity is lerped towards the velocity requested by the input each frame.
+    float3_t velocity{};
+
+    // The current orientation is lerped towards the target orientation each frame.
+    f32 pitch{};
+    f32 yaw{};
+    f32 roll{};
+
+    f32 target_pitch{};
+    f32 target_yaw{};
+    f32 target_roll{};
+};
+
+// Systems.
+
+// Adds the angular velocity of each spinning entity to its rotation.
+inline void update_spin(ecs::world_t &world, ecs::query_t &query)
+{
+    world.for_each<transform_component_t, spin_component_t>(
+        query, [](const ecs::entity_t, transform_component_t &transform, const spin_component_t &spin) {
+            transform.rotation = transform.rotation + spin.angular_velocity;
+        });
+}
+
+// Moves the camera towards move_direction (which does not need to be normalized, and is zero when the camera should
+// come to a stop) and rotates it towards its target orientation. The front and right vectors follow the orientation.
+inline void update_camera(camera_component_t &camera, const float3_t &move_direction, const f32 movement_speed)
+{
+    constexpr f32 SMOOTHING_FACTOR = 0.02f;
+
+    const f32 move_direction_length = length(move_direction);
+    const float3_t target_velocity =
+        move_direction_length > 0.0f ? move_direction * (movement_speed / move_direction_length) : float3_t{};
+
+    camera.velocity = camera.velocity + (target_velocity - camera.velocity) * SMOOTHING_FACTOR;
+
+    camera.pitch = std::lerp(camera.pitch, camera.target_pitch, SMOOTHING_FACTOR);
+    camera.yaw = std::lerp(camera.yaw, camera.target_yaw, SMOOTHING_FACTOR);
+    camera.roll = std::lerp(camera.roll, camera.target_roll, SMOOTHING_FACTOR);
+
+    camera.position = camera.position + camera.velocity;
+
+    // The front and right vectors are the rotated z and x axis.
+    const float4x4_t rotation_matrix = rotation_roll_pitch_yaw_matrix(camera.pitch, camera.yaw, camera.roll);
+
+    camera.front = normalize(float3_t{rotation_matrix.m[2][0], rotation_matrix.m[2][1], rotation_matrix.m[2][2]});
+    camera.right = normalize(float3_t{rotation_matrix.m[0][0], rotation_matrix.m[0][1], rotation_matrix.m[0][2]});
+}
+
+inline float4x4_t get_view_matrix(const camera_component_t &camera)
+{
+    const float3_t up = normalize(cross(camera.front, camera.right));
+    return look_to_matrix(camera.position, camera.front, up);
+}
+
+// Computes the model matrix of each transform, in parallel over chunks.
+inline void update_transforms(job_system_t &job_system, ecs::world_t &world, ecs::query_t &query)
+{
+    world.parallel_for_each_chunk<transform_component_t>(
+        job_system, query,
+        [](const u32, const u32 count, const ecs::entity_t *const, transform_component_t *const transforms) {
+            for (u32 i = 0u; i < count; i++)
+            {
+                transform_component_t &transform = transforms[i];
+
+                transform.model_matrix =
+                    scaling_matrix(transform.scale) *
+                    rotation_roll_pitch_yaw_matrix(transform.rotation.x, transform.rotation.y, transform.rotation.z) *
+                    translation_matrix(transform.translation);
+            }
+        });
+}
+} // namespace nether::scene
@@ -0,0 +1,347 @@
+#include "shader_archive.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nether
+{
+static u64 align_up(const u64 value, const u64 alignment)
+{
+    return (value + alignment - 1u) / alignment * alignment;
+}
+
+u64 get_shader_archive_key(const std::wstring_view shader_path, const std::wstring_view target_profile,
+                           const std::wstring_view entry_point, const u32 permutation_mask)
+{
+    // Characters are hashed as 16 bit values, so that keys are the same whatever the size of wchar_t.
+    const auto hash_string = [](const std::wstring_view string, u64 hash) {
+        for (const wchar_t character : string)
+        {
+            const u16 code_unit = static_cast<u16>(character == L'\\' ? L'/' : character);
+            hash = hash_bytes(&code_unit, sizeof(code_unit), hash);
+        }
+
+        // Separator, so that ("ab", "c") and ("a", "bc") have different keys.
+        const u16 separator = 0u;
+        return hash_bytes(&separator, sizeof(separator), hash);
+    };
+
+    u64 key = hash_string(shader_path, 0xcbf29ce484222325ull);
+    key = hash_string(target_profile, key);
+    key = hash_string(entry_point, key);
+
+    return hash_bytes(&permutation_mask, sizeof(permutation_mask), key);
+}
+
+void shader_archive_writer_t::add(const u64 key, const std::span<const u8> bytecode,
+                                  const shader_archive_metadata_t &metadata)
+{
+    if (bytecode.size() > std::numeric_limits<u32>::max())
+    {
+        throw std::runtime_error(std::format("Shader bytecode of {} bytes is too large for a shader archive",
+                                             bytecode.size()));
+    }
+
+    u32 blob_index = static_cast<u32>(blobs.size());
+
+    const u64 bytecode_hash = hash_bytes(bytecode.data(), bytecode.size());
+    if (const auto blob_iterator = bytecode_hash_to_blob_index.find(bytecode_hash);
+        blob_iterator != bytecode_hash_to_blob_index.end() &&
+        std::equal(bytecode.begin(), bytecode.end(), blobs[blob_iterator->second].begin(),
+                   blobs[blob_iterator->second].end()))
+    {
+        blob_index = blob_iterator->second;
+    }
+    else
+    {
+        blobs.emplace_back(bytecode.begin(), bytecode.end());
+        bytecode_hash_to_blob_index[bytecode_hash] = blob_index;
+    }
+
+    // The metadata is the permutation mask followed by the null terminated strings.
+    std::string serialized_metadata(sizeof(u32), '\0');
+    std::memcpy(serialized_metadata.data(), &metadata.permutation_mask, sizeof(u32));
+    for (const std::string_view string :
+         {metadata.shader_path, metadata.target_profile, metadata.entry_point, metadata.defines})
+    {
+        serialized_metadata += string;
+        serialized_metadata += '\0';
+    }
+
+    entries.push_back({
+        .key = key,
+        .blob_index = blob_index,
+        .metadata = std::move(serialized_metadata),
+    });
+}
+
+std::vector<u8> shader_archive_writer_t::build() const
+{
+    std::vector<const pending_entry_t *> sorted_entries{};
+    sorted_entries.reserve(entries.size());
+    for (const pending_entry_t &entry : entries)
+    {
+        sorted_entries.push_back(&entry);
+    }
+
+    std::sort(sorted_entries.begin(), sorted_entries.end(),
+              [](const pending_entry_t *a, const pending_entry_t *b) { return a->key < b->key; });
+
+    const auto duplicate_iterator =
+        std::adjacent_find(sorted_entries.begin(), sorted_entries.end(),
+                           [](const pending_entry_t *a, const pending_entry_t *b) { return a->key == b->key; });
+    if (duplicate_iterator != sorted_entries.end())
+    {
+        throw std::runtime_error(
+            std::format("Shader archive has more than one entry with key {:x}", (*duplicate_iterator)->key));
+    }
+
+    const u32 num_entries = static_cast<u32>(entries.size());
+
+    shader_archive_header_t header = {
+        .magic = SHADER_ARCHIVE_MAGIC,
+        .version = SHADER_ARCHIVE_VERSION,
+        .flags = flags,
+        .num_entries = num_entries,
+    };
+
+    header.keys_offset = align_up(sizeof(shader_archive_header_t), alignof(u64));
+    header.entries_offset = header.keys_offset + num_entries * sizeof(u64);
+    header.metadata_offset = header.entries_offset + num_entries * sizeof(shader_archive_entry_t);
+
+    u64 metadata_size = 0u;
+    for (const pending_entry_t &entry : entries)
+    {
+        metadata_size += entry.metadata.size();
+    }
+
+    header.blobs_offset = align_up(header.metadata_offset + metadata_size, BLOB_ALIGNMENT);
+
+    std::vector<u64> blob_offsets(blobs.size());
+    u64 offset = header.blobs_offset;
+    for (size_t i = 0u; i < blobs.size(); i++)
+    {
+        blob_offsets[i] = offset;
+        offset = align_up(offset + blobs[i].size(), BLOB_ALIGNMENT);
+    }
+
+    header.file_size = offset;
+
+    std::vector<u8> archive(header.file_size, 0u);
+    std::memcpy(archive.data(), &header, sizeof(header));
+
+    u64 metadata_offset = 0u;
+    for (u32 i = 0u; i < num_entries; i++)
+    {
+        const pending_entry_t &pending_entry = *sorted_entries[i];
+
+        const shader_archive_entry_t entry = {
+            .bytecode_offset = blob_offsets[pending_entry.blob_index],
+            .bytecode_size = static_cast<u32>(blobs[pending_entry.blob_index].size()),
+            .metadata_offset = static_cast<u32>(metadata_offset),
+            .metadata_size = static_cast<u32>(pending_entry.metadata.size()),
+        };
+
+        std::memcpy(archive.data() + header.keys_offset + i * sizeof(u64), &pending_entry.key, sizeof(u64));
+        std::memcpy(archive.data() + header.entries_offset + i * sizeof(shader_archive_entry_t), &entry,
+                    sizeof(entry));
+        std::memcpy(archive.data() + header.metadata_offset + metadata_offset, pending_entry.metadata.data(),
+                    pending_entry.metadata.size());
+
+        metadata_offset += pending_entry.metadata.size();
+    }
+
+    for (size_t i = 0u; i < blobs.size(); i++)
+    {
+        std::memcpy(archive.data() + blob_offsets[i], blobs[i].data(), blobs[i].size());
+    }
+
+    return archive;
+}
+
+void shader_archive_writer_t::write(const std::filesystem::path &path) const
+{
+    const std::vector<u8> archive = build();
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error(std::format("Failed to open shader archive {} for writing", path.string()));
+    }
+
+    file.write(reinterpret_cast<const char *>(archive.data()), static_cast<std::streamsize>(archive.size()));
+    if (!file)
+    {
+        throw std::runtime_error(std::format("Failed to write shader archive {}", path.string()));
+    }
+}
+
+#ifdef _WIN32
+memory_mapped_file_t::memory_mapped_file_t(const std::filesystem::path &path)
+{
+    file_handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error(std::format("Failed to open file {}", path.string()));
+    }
+
+    LARGE_INTEGER file_size = {};
+    if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0)
+    {
+        CloseHandle(file_handle);
+        throw std::runtime_error(std::format("Failed to map file {} (empty or unreadable)", path.string()));
+    }
+
+    file_mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0u, 0u, nullptr);
+    if (file_mapping_handle)
+    {
+        data = static_cast<const u8 *>(MapViewOfFile(file_mapping_handle, FILE_MAP_READ, 0u, 0u, 0u));
+    }
+
+    if (!data)
+    {
+        if (file_mapping_handle)
+        {
+            CloseHandle(file_mapping_handle);
+        }
+        CloseHandle(file_handle);
+        throw std::runtime_error(std::format("Failed to map file {}", path.string()));
+    }
+
+    size = static_cast<size_t>(file_size.QuadPart);
+}
+
+memory_mapped_file_t::~memory_mapped_file_t()
+{
+    UnmapViewOfFile(data);
+    CloseHandle(file_mapping_handle);
+    CloseHandle(file_handle);
+}
+#else
+memory_mapped_file_t::memory_mapped_file_t(const std::filesystem::path &path)
+{
+    const int file_descriptor = open(path.c_str(), O_RDONLY);
+    if (file_descriptor < 0)
+    {
+        throw std::runtime_error(std::format("Failed to open file {}", path.string()));
+    }
+
+    struct stat file_status = {};
+    if (fstat(file_descriptor, &file_status) != 0 || file_status.st_size == 0)
+    {
+        close(file_descriptor);
+        throw std::runtime_error(std::format("Failed to map file {} (empty or unreadable)", path.string()));
+    }
+
+    size = static_cast<size_t>(file_status.st_size);
+
+    // The mapping keeps its own reference to the file, so the descriptor can be closed right away.
+    void *const mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    close(file_descriptor);
+
+    if (mapping == MAP_FAILED)
+    {
+        throw std::runtime_error(std::format("Failed to map file {}", path.string()));
+    }
+
+    data = static_cast<const u8 *>(mapping);
+}
+
+memory_mapped_file_t::~memory_mapped_file_t()
+{
+    munmap(const_cast<u8 *>(data), size);
+}
+#endif
+
+shader_archive_t::shader_archive_t(const std::filesystem::path &path) : file(path)
+{
+    const std::span<const u8> data = file.get_data();
+
+    const auto throw_invalid = [&](const std::string_view reason) {
+        throw std::runtime_error(std::format("Invalid shader archive {} : {}", path.string(), reason));
+    };
+
+    if (data.size() < sizeof(shader_archive_header_t))
+    {
+        throw_invalid("file is smaller than the header");
+    }
+
+    header = reinterpret_cast<const shader_archive_header_t *>(data.data());
+    if (header->magic != SHADER_ARCHIVE_MAGIC)
+    {
+        throw_invalid("bad magic");
+    }
+
+    if (header->version != SHADER_ARCHIVE_VERSION)
+    {
+        throw_invalid(std::format("version {} (expected {})", header->version, SHADER_ARCHIVE_VERSION));
+    }
+
+    const u64 num_entries = header->num_entries;
+    if (header->file_size != data.size() || header->keys_offset % alignof(u64) != 0u ||
+        header->entries_offset != header->keys_offset + num_entries * sizeof(u64) ||
+        header->metadata_offset != header->entries_offset + num_entries * sizeof(shader_archive_entry_t) ||
+        header->metadata_offset > header->blobs_offset || header->blobs_offset > data.size())
+    {
+        throw_invalid("bad section offsets");
+    }
+
+    keys = std::span(reinterpret_cast<const u64 *>(data.data() + header->keys_offset), num_entries);
+    entries = std::span(reinterpret_cast<const shader_archive_entry_t *>(data.data() + header->entries_offset),
+                        num_entries);
+    metadata = data.subspan(header->metadata_offset, header->blobs_offset - header->metadata_offset);
+
+    if (!std::is_sorted(keys.begin(), keys.end()))
+    {
+        throw_invalid("keys are not sorted");
+    }
+
+    for (const shader_archive_entry_t &entry : entries)
+    {
+        if (entry.bytecode_offset < header->blobs_offset || entry.bytecode_offset + entry.bytecode_size > data.size() ||
+            static_cast<u64>(entry.metadata_offset) + entry.metadata_size > metadata.size() ||
+            entry.metadata_size < sizeof(u32))
+        {
+            throw_invalid("entry out of bounds");
+        }
+    }
+}
+
+u32 shader_archive_t::find(const u64 key) const
+{
+    const auto key_iterator = std::lower_bound(keys.begin(), keys.end(), key);
+    if (key_iterator == keys.end() || *key_iterator != key)
+    {
+        return INVALID_ENTRY_INDEX;
+    }
+
+    return static_cast<u32>(std::distance(keys.begin(), key_iterator));
+}
+
+shader_archive_metadata_t shader_archive_t::get_metadata(const u32 entry_index) const
+{
+    const shader_archive_entry_t &entry = entries[entry_index];
+    const std::span<const u8> entry_metadata = metadata.subspan(entry.metadata_offset, entry.metadata_size);
+
+    shader_archive_metadata_t result{};
+    std::memcpy(&result.permutation_mask, entry_metadata.data(), sizeof(u32));
+
+    // Splits the null terminated strings. A truncated string ends at the end of the metadata.
+    std::string_view strings(reinterpret_cast<const char *>(entry_metadata.data()) + sizeof(u32),
+                             entry_metadata.size() - sizeof(u32));
+    for (std::string_view *const field :
+         {&result.shader_path, &result.target_profile, &result.entry_point, &result.defines})
+    {
+        const size_t terminator = std::min(strings.find('\0'), strings.size());
+        *field = strings.substr(0u, terminator);
+        strings.remove_prefix(std::min(terminator + 1u, strings.size()));
+    }
+
+    return result;
+}
+} // namespace nether
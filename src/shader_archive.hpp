@@ -0,0 +1,177 @@
+#pragma once
+
+#include "common.hpp"
+
+// A single file that holds the compiled bytecode of many shader variants, so that startup does not compile shaders or
+// open a file per shader. Archives are built offline by nether-shader-packer (see tools/shader_packer.cpp).
+// Layout (all offsets are from the start of the file) :
+//  - shader_archive_header_t.
+//  - The keys of all entries, sorted, so that a lookup is a binary search over a compact array.
+//  - One shader_archive_entry_t per key, in the same order.
+//  - The metadata of every entry.
+//  - The bytecode blobs, each aligned to BLOB_ALIGNMENT. Variants with identical bytecode share a blob.
+// At runtime the file is memory mapped once, and bytecode is returned as views into the mapping (no copies).
+namespace nether
+{
+static constexpr u32 SHADER_ARCHIVE_MAGIC = 0x4153484e; // "NHSA"
+static constexpr u32 SHADER_ARCHIVE_VERSION = 1u;
+
+// Set when the shaders were compiled with debug information (and without optimizations).
+static constexpr u32 SHADER_ARCHIVE_FLAG_DEBUG = 1u << 0u;
+
+// Debug and release builds compile shaders with different options, so each has its own archive.
+static constexpr std::string_view DEFAULT_SHADER_ARCHIVE_PATH =
+    NETHER_DEBUG ? "shaders/shader_archive_debug.bin" : "shaders/shader_archive.bin";
+
+struct shader_archive_header_t
+{
+    u32 magic{};
+    u32 version{};
+    u32 flags{};
+    u32 num_entries{};
+
+    u64 keys_offset{};
+    u64 entries_offset{};
+    u64 metadata_offset{};
+    u64 blobs_offset{};
+    u64 file_size{};
+};
+
+struct shader_archive_entry_t
+{
+    u64 bytecode_offset{};
+    u32 bytecode_size{};
+
+    // Offset from the archive's metadata_offset.
+    u32 metadata_offset{};
+    u32 metadata_size{};
+    u32 padding{};
+};
+
+// Describes how a variant was compiled, for tools and error messages. The DXIL reflection data stays in the bytecode
+// container, and can be read from the bytecode view with IDxcUtils::CreateReflection.
+// The strings are UTF-8, and defines are separated by spaces.
+struct shader_archive_metadata_t
+{
+    std::string_view shader_path{};
+    std::string_view target_profile{};
+    std::string_view entry_point{};
+    std::string_view defines{};
+    u32 permutation_mask{};
+};
+
+// Identifies a shader variant. Path separators are normalized, so "shaders\\a.hlsl" and "shaders/a.hlsl" have the same
+// key.
+u64 get_shader_archive_key(const std::wstring_view shader_path, const std::wstring_view target_profile,
+                           const std::wstring_view entry_point, const u32 permutation_mask);
+
+// Builds an archive in memory. build throws if the same key was added twice.
+class shader_archive_writer_t
+{
+  public:
+    static constexpr u32 BLOB_ALIGNMENT = 64u;
+
+    explicit shader_archive_writer_t(const u32 flags = 0u) : flags(flags)
+    {
+    }
+
+    // The bytecode is copied.
+    void add(const u64 key, const std::span<const u8> bytecode, const shader_archive_metadata_t &metadata);
+
+    std::vector<u8> build() const;
+
+    void write(const std::filesystem::path &path) const;
+
+    u32 get_num_entries() const
+    {
+        return static_cast<u32>(entries.size());
+    }
+
+    u32 get_num_blobs() const
+    {
+        return static_cast<u32>(blobs.size());
+    }
+
+  private:
+    struct pending_entry_t
+    {
+        u64 key{};
+        u32 blob_index{};
+        std::string metadata{};
+    };
+
+    u32 flags{};
+
+    std::vector<pending_entry_t> entries{};
+    std::vector<std::vector<u8>> blobs{};
+
+    // Content hash -> index into blobs, to share the blob of variants with identical bytecode.
+    std::unordered_map<u64, u32> bytecode_hash_to_blob_index{};
+};
+
+// Read only view of a file, mapped into the address space of the process.
+class memory_mapped_file_t
+{
+  public:
+    // Throws if the file can not be opened or is empty.
+    explicit memory_mapped_file_t(const std::filesystem::path &path);
+    ~memory_mapped_file_t();
+
+    memory_mapped_file_t(const memory_mapped_file_t &) = delete;
+    memory_mapped_file_t &operator=(const memory_mapped_file_t &) = delete;
+
+    std::span<const u8> get_data() const
+    {
+        return std::span(data, size);
+    }
+
+  private:
+    const u8 *data{};
+    size_t size{};
+
+#ifdef _WIN32
+    HANDLE file_handle{INVALID_HANDLE_VALUE};
+    HANDLE file_mapping_handle{};
+#endif
+};
+
+// A memory mapped archive. The header and index are validated when the archive is opened (throws if the file is not a
+// valid archive), so lookups do no further checks.
+class shader_archive_t
+{
+  public:
+    static constexpr u32 INVALID_ENTRY_INDEX = ~0u;
+
+    explicit shader_archive_t(const std::filesystem::path &path);
+
+    // Binary search over the sorted keys. Returns INVALID_ENTRY_INDEX if the archive has no such variant.
+    u32 find(const u64 key) const;
+
+    // The view is valid as long as the archive is alive.
+    std::span<const u8> get_bytecode(const u32 entry_index) const
+    {
+        const shader_archive_entry_t &entry = entries[entry_index];
+        return file.get_data().subspan(entry.bytecode_offset, entry.bytecode_size);
+    }
+
+    shader_archive_metadata_t get_metadata(const u32 entry_index) const;
+
+    u32 get_num_entries() const
+    {
+        return header->num_entries;
+    }
+
+    u32 get_flags() const
+    {
+        return header->flags;
+    }
+
+  private:
+    memory_mapped_file_t file;
+
+    const shader_archive_header_t *header{};
+    std::span<const u64> keys{};
+    std::span<const shader_archive_entry_t> entries{};
+    std::span<const u8> metadata{};
+};
+} // namespace nether
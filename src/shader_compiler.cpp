@@ -1,5 +1,6 @@
 #include "common.hpp"
 
+#include "memory.hpp"
 #include "shader_compiler.hpp"
 
 namespace nether::shader_compiler
@@ -8,11 +9,23 @@ static ComPtr<IDxcUtils> g_utils{};
 static ComPtr<IDxcCompiler3> g_compiler{};
 static ComPtr<IDxcIncludeHandler> g_include_handler{};
 
-ComPtr<IDxcBlob> compile_shader(const std::wstring_view shader_path, const std::wstring_view target_profile,
-                                const std::wstring_view entry_point)
+// DXC takes null terminated arguments, while the inputs are string views.
+static const wchar_t *copy_to_null_terminated(memory::linear_arena_t &arena, const std::wstring_view string)
 {
-    ComPtr<IDxcBlob> result = {};
+    wchar_t *const result = arena.allocate_array<wchar_t>(string.size() + 1u);
+    std::copy(string.begin(), string.end(), result);
+    result[string.size()] = L'\0';
+
+    return result;
+}
 
+// Invokes DXC on the shader source file. When preprocess_only is true, only the preprocessor is run and the
+// result is read from DXC_OUT_HLSL rather than DXC_OUT_OBJECT.
+static ComPtr<IDxcResult> invoke_compiler(const std::wstring_view shader_path, const std::wstring_view target_profile,
+                                          const std::wstring_view entry_point,
+                                          const std::span<const std::wstring_view> defines,
+                                          const bool preprocess_only)
+{
     if (!g_utils)
     {
         throw_if_failed(::DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&g_utils)));
@@ -20,18 +33,45 @@ ComPtr<IDxcBlob> compile_shader(const std::wstring_view shader_path, const std::
         throw_if_failed(g_utils->CreateDefaultIncludeHandler(&g_include_handler));
     }
 
+    // The arguments only live until the compiler returns, so they are built in the thread's scratch arena rather than
+    // on the heap.
+    memory::scratch_scope_t scratch_scope{};
+    memory::linear_arena_t &scratch_arena = scratch_scope.get_arena();
+
+    // Includes (such as common.hlsli) are resolved relative to the directory of the shader.
+    const size_t last_separator = shader_path.find_last_of(L"/\\");
+    const std::wstring_view include_directory =
+        last_separator == std::wstring_view::npos ? std::wstring_view(L".") : shader_path.substr(0u, last_separator);
+
     // Setup compilation arguments.
-    std::vector<LPCWSTR> compilation_arguments = {
-        L"-HV",
-        L"2021",
-        L"-E",
-        entry_point.data(),
-        L"-T",
-        target_profile.data(),
-        DXC_ARG_PACK_MATRIX_ROW_MAJOR,
-        DXC_ARG_WARNINGS_ARE_ERRORS,
-        DXC_ARG_ALL_RESOURCES_BOUND,
-    };
+    std::pmr::vector<LPCWSTR> compilation_arguments(&scratch_arena);
+    compilation_arguments.reserve(16u + 2u * defines.size());
+
+    compilation_arguments.insert(compilation_arguments.end(),
+                                 {
+                                     L"-HV",
+                                     L"2021",
+                                     L"-E",
+                                     copy_to_null_terminated(scratch_arena, entry_point),
+                                     L"-T",
+                                     copy_to_null_terminated(scratch_arena, target_profile),
+                                     L"-I",
+                                     copy_to_null_terminated(scratch_arena, include_directory),
+                                     DXC_ARG_PACK_MATRIX_ROW_MAJOR,
+                                     DXC_ARG_WARNINGS_ARE_ERRORS,
+                                     DXC_ARG_ALL_RESOURCES_BOUND,
+                                 });
+
+    for (const std::wstring_view define : defines)
+    {
+        compilation_arguments.push_back(L"-D");
+        compilation_arguments.push_back(copy_to_null_terminated(scratch_arena, define));
+    }
+
+    if (preprocess_only)
+    {
+        compilation_arguments.push_back(L"-P");
+    }
 
     // Indicate that the shader should be in a debuggable state if in debug mode.
     // Else, set optimization level to 03.
@@ -46,7 +86,7 @@ ComPtr<IDxcBlob> compile_shader(const std::wstring_view shader_path, const std::
 
     // Load the shader source file to a blob.
     ComPtr<IDxcBlobEncoding> source_blob{nullptr};
-    throw_if_failed(g_utils->LoadFile(shader_path.data(), nullptr, &source_blob));
+    throw_if_failed(g_utils->LoadFile(copy_to_null_terminated(scratch_arena, shader_path), nullptr, &source_blob));
 
     const DxcBuffer source_buffer = {
         .Ptr = source_blob->GetBufferPointer(),
@@ -73,9 +113,31 @@ ComPtr<IDxcBlob> compile_shader(const std::wstring_view shader_path, const std::
         std::wcout << "Shader compiler error message : " << error_message;
     }
 
+    return compiled_shader_buffer;
+}
+
+ComPtr<IDxcBlob> compile_shader(const std::wstring_view shader_path, const std::wstring_view target_profile,
+                                const std::wstring_view entry_point, const std::span<const std::wstring_view> defines)
+{
+    ComPtr<IDxcResult> compiled_shader_buffer =
+        invoke_compiler(shader_path, target_profile, entry_point, defines, false);
+
     ComPtr<IDxcBlob> compiled_shader_blob{nullptr};
     compiled_shader_buffer->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&compiled_shader_blob), nullptr);
 
     return compiled_shader_blob;
 }
+
+ComPtr<IDxcBlobUtf8> preprocess_shader(const std::wstring_view shader_path, const std::wstring_view target_profile,
+                                       const std::wstring_view entry_point,
+                                       const std::span<const std::wstring_view> defines)
+{
+    ComPtr<IDxcResult> preprocessed_shader_buffer =
+        invoke_compiler(shader_path, target_profile, entry_point, defines, true);
+
+    ComPtr<IDxcBlobUtf8> preprocessed_shader_blob{nullptr};
+    preprocessed_shader_buffer->GetOutput(DXC_OUT_HLSL, IID_PPV_ARGS(&preprocessed_shader_blob), nullptr);
+
+    return preprocessed_shader_blob;
+}
 } // namespace nether::shader_compiler
@@ -5,6 +5,14 @@
 namespace nether::shader_compiler
 {
 // Helper function to compiler shaders using DXC's api.
+// Each define in defines is passed to the compiler as '-D <define>'.
 ComPtr<IDxcBlob> compile_shader(const std::wstring_view shader_path, const std::wstring_view target_profile,
-                                const std::wstring_view entry_point);
+                                const std::wstring_view entry_point,
+                                const std::span<const std::wstring_view> defines = {});
+
+// Run only the preprocessor on the shader. Used to detect permutations that expand to the exact same source text
+// without paying for a full compile.
+ComPtr<IDxcBlobUtf8> preprocess_shader(const std::wstring_view shader_path, const std::wstring_view target_profile,
+                                       const std::wstring_view entry_point,
+                                       const std::span<const std::wstring_view> defines = {});
 } // namespace nether::shader_compiler
@@ -0,0 +1,182 @@
+#include "shader_permutations.hpp"
+
+namespace nether::shader_compiler
+{
+// Parse the axes declared in the shader source file (see PERMUTATION_AXES_MARKER).
+static std::vector<std::wstring> parse_permutation_axes(const std::wstring_view shader_path)
+{
+    std::vector<std::wstring> axes{};
+
+    std::ifstream shader_file(std::filesystem::path(shader_path));
+    if (!shader_file.is_open())
+    {
+        throw std::runtime_error(
+            std::format("Failed to open shader file {}", std::filesystem::path(shader_path).string()));
+    }
+
+    std::string line{};
+    while (std::getline(shader_file, line))
+    {
+        const size_t marker_position = line.find(PERMUTATION_AXES_MARKER);
+        if (marker_position == std::string::npos)
+        {
+            continue;
+        }
+
+        std::istringstream axes_stream(line.substr(marker_position + PERMUTATION_AXES_MARKER.size()));
+
+        std::string axis{};
+        while (axes_stream >> axis)
+        {
+            axes.emplace_back(axis.begin(), axis.end());
+        }
+    }
+
+    return axes;
+}
+
+shader_permutation_set_t::shader_permutation_set_t(const std::wstring_view shader_path,
+                                                   const std::wstring_view target_profile,
+                                                   const std::wstring_view entry_point)
+    : shader_path(shader_path), target_profile(target_profile), entry_point(entry_point)
+{
+    axes = parse_permutation_axes(shader_path);
+    if (axes.size() > MAX_PERMUTATION_AXES)
+    {
+        throw std::runtime_error(std::format("Shader {} declares {} permutation axes, but at most {} are supported",
+                                             std::filesystem::path(shader_path).string(), axes.size(),
+                                             MAX_PERMUTATION_AXES));
+    }
+
+    permutation_to_blob_index.resize(get_num_permutations(), INVALID_BLOB_INDEX);
+}
+
+u32 shader_permutation_set_t::get_permutation_mask(const std::span<const std::wstring_view> enabled_axes) const
+{
+    u32 permutation_mask = 0u;
+
+    for (const std::wstring_view enabled_axis : enabled_axes)
+    {
+        const auto axis_iterator = std::find(axes.begin(), axes.end(), enabled_axis);
+        if (axis_iterator == axes.end())
+        {
+            throw std::runtime_error(std::format("Permutation axis is not declared by shader {}",
+                                                 std::filesystem::path(shader_path).string()));
+        }
+
+        permutation_mask |= 1u << static_cast<u32>(std::distance(axes.begin(), axis_iterator));
+    }
+
+    return permutation_mask;
+}
+
+IDxcBlob *shader_permutation_set_t::request(const u32 permutation_mask)
+{
+    if (permutation_mask >= get_num_permutations())
+    {
+        throw std::runtime_error(std::format("Permutation mask {} is out of range for shader {}", permutation_mask,
+                                             std::filesystem::path(shader_path).string()));
+    }
+
+    statistics.num_requests++;
+
+    if (permutation_to_blob_index[permutation_mask] != INVALID_BLOB_INDEX)
+    {
+        return blobs[permutation_to_blob_index[permutation_mask]].Get();
+    }
+
+    statistics.num_unique_requests++;
+
+    memory::scratch_scope_t scratch_scope{};
+    const std::pmr::vector<std::wstring_view> defines = get_defines(permutation_mask, scratch_scope.get_arena());
+
+    // Defines that are never tested by the shader (or only in code that is not reachable from this entry point's
+    // file) produce the same preprocessed text. Those permutations can share a blob without a full compile.
+    ComPtr<IDxcBlobUtf8> preprocessed_shader_blob =
+        preprocess_shader(shader_path, target_profile, entry_point, defines);
+    if (!preprocessed_shader_blob)
+    {
+        throw std::runtime_error(
+            std::format("Failed to preprocess shader {}", std::filesystem::path(shader_path).string()));
+    }
+
+    const u64 preprocessed_hash =
+        hash_bytes(preprocessed_shader_blob->GetStringPointer(), preprocessed_shader_blob->GetStringLength());
+
+    if (const auto preprocessed_iterator = preprocessed_hash_to_blob_index.find(preprocessed_hash);
+        preprocessed_iterator != preprocessed_hash_to_blob_index.end())
+    {
+        statistics.num_preprocessed_deduplicated++;
+
+        permutation_to_blob_index[permutation_mask] = preprocessed_iterator->second;
+        return blobs[preprocessed_iterator->second].Get();
+    }
+
+    ComPtr<IDxcBlob> compiled_shader_blob = compile_shader(shader_path, target_profile, entry_point, defines);
+    if (!compiled_shader_blob)
+    {
+        throw std::runtime_error(
+            std::format("Failed to compile shader {}", std::filesystem::path(shader_path).string()));
+    }
+
+    statistics.num_compiled++;
+
+    // Different source text can still produce identical DXIL (for example, when a define only changes code that is
+    // optimized out).
+    const u64 bytecode_hash =
+        hash_bytes(compiled_shader_blob->GetBufferPointer(), compiled_shader_blob->GetBufferSize());
+
+    u32 blob_index = INVALID_BLOB_INDEX;
+
+    if (const auto bytecode_iterator = bytecode_hash_to_blob_index.find(bytecode_hash);
+        bytecode_iterator != bytecode_hash_to_blob_index.end())
+    {
+        IDxcBlob *const existing_blob = blobs[bytecode_iterator->second].Get();
+
+        if (existing_blob->GetBufferSize() == compiled_shader_blob->GetBufferSize() &&
+            std::memcmp(existing_blob->GetBufferPointer(), compiled_shader_blob->GetBufferPointer(),
+                        compiled_shader_blob->GetBufferSize()) == 0)
+        {
+            statistics.num_bytecode_deduplicated++;
+            blob_index = bytecode_iterator->second;
+        }
+    }
+
+    if (blob_index == INVALID_BLOB_INDEX)
+    {
+        blob_index = static_cast<u32>(blobs.size());
+        blobs.push_back(compiled_shader_blob);
+        bytecode_hash_to_blob_index[bytecode_hash] = blob_index;
+    }
+
+    preprocessed_hash_to_blob_index[preprocessed_hash] = blob_index;
+    permutation_to_blob_index[permutation_mask] = blob_index;
+
+    return blobs[blob_index].Get();
+}
+
+void shader_permutation_set_t::compile_all()
+{
+    for (u32 permutation_mask = 0u; permutation_mask < get_num_permutations(); permutation_mask++)
+    {
+        request(permutation_mask);
+    }
+}
+
+std::pmr::vector<std::wstring_view> shader_permutation_set_t::get_defines(const u32 permutation_mask,
+                                                                         memory::linear_arena_t &arena) const
+{
+    std::pmr::vector<std::wstring_view> defines(&arena);
+    defines.reserve(axes.size());
+
+    for (u32 axis_index = 0u; axis_index < static_cast<u32>(axes.size()); axis_index++)
+    {
+        if (permutation_mask & (1u << axis_index))
+        {
+            defines.push_back(axes[axis_index]);
+        }
+    }
+
+    return defines;
+}
+} // namespace nether::shader_compiler
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "common.hpp"
+
+#include "memory.hpp"
+#include "shader_compiler.hpp"
+
+namespace nether::shader_compiler
+{
+// Shaders declare their permutation axes in a comment of the form :
+//  // permutation_axes: AXIS_A AXIS_B
+// Each axis is a boolean preprocessor define. A permutation is identified by a bitmask, where bit i set means that
+// the i-th declared axis is defined.
+static constexpr std::string_view PERMUTATION_AXES_MARKER = "// permutation_axes:";
+
+// The lookup table has an entry for every possible mask, so the number of axes per shader is capped.
+static constexpr u32 MAX_PERMUTATION_AXES = 12u;
+
+struct shader_permutation_statistics_t
+{
+    // Total number of calls to request, and number of distinct masks that were requested.
+    u32 num_requests{};
+    u32 num_unique_requests{};
+
+    // Number of permutations that required a full DXC compile.
+    u32 num_compiled{};
+
+    // Number of permutations that were collapsed into an existing blob, either because the preprocessed source text or
+    // the resulting DXIL were identical.
+    u32 num_preprocessed_deduplicated{};
+    u32 num_bytecode_deduplicated{};
+};
+
+// Manages all variants of a single (shader path, target profile, entry point) triple.
+// Variants can be compiled on demand (request) or ahead of time (compile_all). Once compiled, get is a O(1) table
+// lookup and is safe to call on the draw path.
+class shader_permutation_set_t
+{
+  public:
+    explicit shader_permutation_set_t(const std::wstring_view shader_path, const std::wstring_view target_profile,
+                                      const std::wstring_view entry_point);
+
+    // Returns the mask with the bits of the given axes set. Throws if an axis is not declared by the shader.
+    u32 get_permutation_mask(const std::span<const std::wstring_view> enabled_axes) const;
+
+    // Returns the compiled blob for the permutation, compiling it if required.
+    IDxcBlob *request(const u32 permutation_mask);
+
+    // Compiles every possible permutation of the shader.
+    void compile_all();
+
+    // Returns the compiled blob for the permutation, or nullptr if it has not been requested yet.
+    IDxcBlob *get(const u32 permutation_mask) const
+    {
+        const u32 blob_index = permutation_to_blob_index[permutation_mask];
+        return blob_index == INVALID_BLOB_INDEX ? nullptr : blobs[blob_index].Get();
+    }
+
+    u32 get_num_permutations() const
+    {
+        return 1u << static_cast<u32>(axes.size());
+    }
+
+  private:
+    // The defines are views of axes, allocated from the arena.
+    std::pmr::vector<std::wstring_view> get_defines(const u32 permutation_mask, memory::linear_arena_t &arena) const;
+
+  public:
+    static constexpr u32 INVALID_BLOB_INDEX = ~0u;
+
+    std::wstring shader_path{};
+    std::wstring target_profile{};
+    std::wstring entry_point{};
+
+    std::vector<std::wstring> axes{};
+
+    // Indexed by permutation mask. Multiple permutations can point to the same blob.
+    std::vector<u32> permutation_to_blob_index{};
+    std::vector<ComPtr<IDxcBlob>> blobs{};
+
+    // Content hash -> index into blobs, used for deduplication.
+    std::unordered_map<u64, u32> preprocessed_hash_to_blob_index{};
+    std::unordered_map<u64, u32> bytecode_hash_to_blob_index{};
+
+    shader_permutation_statistics_t statistics{};
+};
+} // namespace nether::shader_compiler
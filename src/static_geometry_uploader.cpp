@@ -0,0 +1,271 @@
+#include "static_geometry_uploader.hpp"
+
+#include <chrono>
+
+namespace nether
+{
+static ComPtr<ID3D12Resource> create_buffer(ID3D12Device *const device, const D3D12_HEAP_TYPE heap_type,
+                                            const u64 size)
+{
+    const D3D12_HEAP_PROPERTIES heap_properties = {
+        .Type = heap_type,
+        .CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
+        .MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN,
+        .CreationNodeMask = 0u,
+        .VisibleNodeMask = 0u,
+    };
+
+    const D3D12_RESOURCE_DESC buffer_resource_desc = {
+        .Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
+        .Alignment = 0u,
+        .Width = size,
+        .Height = 1u,
+        .DepthOrArraySize = 1u,
+        .MipLevels = 1u,
+        .Format = DXGI_FORMAT_UNKNOWN,
+        .SampleDesc = {1u, 0u},
+        .Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR,
+        .Flags = D3D12_RESOURCE_FLAG_NONE,
+    };
+
+    ComPtr<ID3D12Resource> buffer{};
+    throw_if_failed(device->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &buffer_resource_desc,
+                                                    D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&buffer)));
+
+    return buffer;
+}
+
+static_geometry_uploader_t::static_geometry_uploader_t(ID3D12Device *const device,
+                                                       descriptor_heap_t *const cbv_srv_uav_descriptor_heap,
+                                                       const upload_planner_config_t &config)
+    : device(device), cbv_srv_uav_descriptor_heap(cbv_srv_uav_descriptor_heap), config(config)
+{
+    const D3D12_COMMAND_QUEUE_DESC copy_command_queue_desc = {
+        .Type = D3D12_COMMAND_LIST_TYPE_COPY,
+        .Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL,
+        .Flags = D3D12_COMMAND_QUEUE_FLAG_NONE,
+        .NodeMask = 0u,
+    };
+
+    throw_if_failed(device->CreateCommandQueue(&copy_command_queue_desc, IID_PPV_ARGS(&copy_command_queue)));
+    set_name_d3d12_object(copy_command_queue.Get(), L"D3D12 static geometry copy command queue");
+
+    for (ComPtr<ID3D12CommandAllocator> &copy_command_allocator : copy_command_allocators)
+    {
+        throw_if_failed(
+            device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&copy_command_allocator)));
+    }
+
+    throw_if_failed(device->CreateCommandList(0u, D3D12_COMMAND_LIST_TYPE_COPY, copy_command_allocators[0].Get(),
+                                              nullptr, IID_PPV_ARGS(&copy_command_list)));
+    throw_if_failed(copy_command_list->Close());
+
+    throw_if_failed(device->CreateFence(0u, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
+}
+
+static_geometry_uploader_t::~static_geometry_uploader_t()
+{
+    // The staging buffers and command allocators must outlive the copies.
+    wait_for_fence_value(current_fence_value);
+
+    for (u32 i = 0u; i < NUM_STAGING_BUFFERS; i++)
+    {
+        if (staging_buffers[i])
+        {
+            memory::unregister_gpu_allocation(staging_buffer_allocations[i]);
+        }
+    }
+
+    for (const memory::gpu_allocation_t &allocation : destination_buffer_allocations)
+    {
+        memory::unregister_gpu_allocation(allocation);
+    }
+}
+
+u32 static_geometry_uploader_t::add_buffer(const std::span<const u8> data, const u32 alignment,
+                                           const u32 structure_byte_stride)
+{
+    const u32 buffer_index = static_cast<u32>(buffers.size());
+    buffers.push_back({});
+
+    pending_requests.push_back({
+        .size = data.size_bytes(),
+        .alignment = alignment,
+    });
+    pending_buffers.push_back({
+        .data = data,
+        .buffer_index = buffer_index,
+        .structure_byte_stride = structure_byte_stride,
+    });
+
+    return buffer_index;
+}
+
+void static_geometry_uploader_t::upload(ID3D12CommandQueue *const direct_command_queue)
+{
+    if (pending_requests.empty())
+    {
+        return;
+    }
+
+    const auto planning_start_time = std::chrono::steady_clock::now();
+
+    const upload_plan_t plan = plan_uploads(pending_requests, config);
+
+    const auto submission_start_time = std::chrono::steady_clock::now();
+
+    // Create the destination buffers, and place the buffers in them.
+    const u32 first_destination_buffer_index = static_cast<u32>(destination_buffers.size());
+    for (const u64 destination_buffer_size : plan.destination_buffer_sizes)
+    {
+        destination_buffers.push_back(create_buffer(device.Get(), D3D12_HEAP_TYPE_DEFAULT, destination_buffer_size));
+        set_name_d3d12_object(destination_buffers.back().Get(), L"Static geometry buffer");
+        destination_buffer_allocations.push_back(memory::register_gpu_resource(
+            device.Get(), destination_buffers.back().Get(), memory::memory_tag_t::assets));
+    }
+
+    for (size_t i = 0u; i < pending_buffers.size(); i++)
+    {
+        const pending_buffer_t &pending_buffer = pending_buffers[i];
+        const upload_placement_t &placement = plan.placements[i];
+
+        const u32 destination_buffer_index = first_destination_buffer_index + placement.destination_buffer_index;
+        ID3D12Resource *const destination_buffer = destination_buffers[destination_buffer_index].Get();
+
+        static_buffer_t &buffer = buffers[pending_buffer.buffer_index];
+        buffer = {
+            .destination_buffer_index = destination_buffer_index,
+            .offset = placement.destination_offset,
+            .size = pending_buffer.data.size_bytes(),
+            .gpu_address = destination_buffer->GetGPUVirtualAddress() + placement.destination_offset,
+        };
+
+        if (pending_buffer.structure_byte_stride == 0u)
+        {
+            continue;
+        }
+
+        // The planner aligns the offset to the stride, so the buffer starts at a whole element.
+        const D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {
+            .Format = DXGI_FORMAT_UNKNOWN,
+            .ViewDimension = D3D12_SRV_DIMENSION_BUFFER,
+            .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
+            .Buffer =
+                {
+                    .FirstElement = placement.destination_offset / pending_buffer.structure_byte_stride,
+                    .NumElements = static_cast<UINT>(buffer.size / pending_buffer.structure_byte_stride),
+                    .StructureByteStride = pending_buffer.structure_byte_stride,
+                    .Flags = D3D12_BUFFER_SRV_FLAG_NONE,
+                },
+        };
+
+        const descriptor_handle_t descriptor_handle =
+            cbv_srv_uav_descriptor_heap->get_then_offset_current_descriptor_handle();
+        device->CreateShaderResourceView(destination_buffer, &srv_desc, descriptor_handle.cpu_handle);
+
+        buffer.srv_index = descriptor_handle.index;
+    }
+
+    // The staging buffers only need to be as large as the largest batch. They are recreated if a later upload needs
+    // more space.
+    u64 staging_buffer_size = 0u;
+    for (const upload_batch_t &batch : plan.batches)
+    {
+        staging_buffer_size = std::max(staging_buffer_size, batch.staging_size);
+    }
+
+    if (!staging_buffers[0] || staging_buffers[0]->GetDesc().Width < staging_buffer_size)
+    {
+        wait_for_fence_value(current_fence_value);
+
+        for (u32 i = 0u; i < NUM_STAGING_BUFFERS; i++)
+        {
+            if (staging_buffers[i])
+            {
+                memory::unregister_gpu_allocation(staging_buffer_allocations[i]);
+            }
+
+            staging_buffers[i] = create_buffer(device.Get(), D3D12_HEAP_TYPE_UPLOAD, staging_buffer_size);
+            set_name_d3d12_object(staging_buffers[i].Get(), L"Static geometry staging buffer");
+            staging_buffer_allocations[i] =
+                memory::register_gpu_resource(device.Get(), staging_buffers[i].Get(), memory::memory_tag_t::assets);
+
+            const D3D12_RANGE no_read_range = {
+                .Begin = 0u,
+                .End = 0u,
+            };
+            throw_if_failed(staging_buffers[i]->Map(0u, &no_read_range, (void **)&staging_buffer_pointers[i]));
+        }
+    }
+
+    // Fill and submit the batches, cycling through the staging buffers.
+    for (u32 batch_index = 0u; batch_index < static_cast<u32>(plan.batches.size()); batch_index++)
+    {
+        const upload_batch_t &batch = plan.batches[batch_index];
+        const u32 staging_buffer_index = batch_index % NUM_STAGING_BUFFERS;
+
+        wait_for_fence_value(staging_buffer_fence_values[staging_buffer_index]);
+
+        u8 *const staging_buffer_pointer = staging_buffer_pointers[staging_buffer_index];
+        for (u32 i = batch.first_staging_write; i < batch.first_staging_write + batch.num_staging_writes; i++)
+        {
+            const staging_write_t &staging_write = plan.staging_writes[i];
+            std::memcpy(staging_buffer_pointer + staging_write.staging_offset,
+                        pending_buffers[staging_write.request_index].data.data() + staging_write.source_offset,
+                        staging_write.size);
+        }
+
+        ID3D12CommandAllocator *const copy_command_allocator = copy_command_allocators[staging_buffer_index].Get();
+        throw_if_failed(copy_command_allocator->Reset());
+        throw_if_failed(copy_command_list->Reset(copy_command_allocator, nullptr));
+
+        for (u32 i = batch.first_copy; i < batch.first_copy + batch.num_copies; i++)
+        {
+            const upload_copy_t &copy = plan.copies[i];
+            copy_command_list->CopyBufferRegion(
+                destination_buffers[first_destination_buffer_index + copy.destination_buffer_index].Get(),
+                copy.destination_offset, staging_buffers[staging_buffer_index].Get(), copy.staging_offset, copy.size);
+        }
+
+        throw_if_failed(copy_command_list->Close());
+
+        ID3D12CommandList *const command_lists_to_execute[] = {
+            copy_command_list.Get(),
+        };
+        copy_command_queue->ExecuteCommandLists(1u, command_lists_to_execute);
+
+        current_fence_value++;
+        throw_if_failed(copy_command_queue->Signal(fence.Get(), current_fence_value));
+        staging_buffer_fence_values[staging_buffer_index] = current_fence_value;
+    }
+
+    // Hand off the buffers : work submitted to the direct queue from now on waits for the copies to complete.
+    throw_if_failed(direct_command_queue->Wait(fence.Get(), current_fence_value));
+
+    const auto end_time = std::chrono::steady_clock::now();
+
+    statistics.num_buffers += static_cast<u32>(pending_buffers.size());
+    for (const upload_request_t &request : pending_requests)
+    {
+        statistics.num_bytes += request.size;
+    }
+    statistics.num_batches += static_cast<u32>(plan.batches.size());
+    statistics.num_copies += static_cast<u32>(plan.copies.size());
+    statistics.num_destination_buffers = static_cast<u32>(destination_buffers.size());
+    statistics.planning_time_in_ms +=
+        std::chrono::duration<f32, std::milli>(submission_start_time - planning_start_time).count();
+    statistics.submission_time_in_ms +=
+        std::chrono::duration<f32, std::milli>(end_time - submission_start_time).count();
+
+    pending_requests.clear();
+    pending_buffers.clear();
+}
+
+void static_geometry_uploader_t::wait_for_fence_value(const u64 fence_value)
+{
+    if (fence->GetCompletedValue() < fence_value)
+    {
+        throw_if_failed(fence->SetEventOnCompletion(fence_value, nullptr));
+    }
+}
+} // namespace nether
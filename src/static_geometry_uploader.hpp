@@ -0,0 +1,132 @@
+#pragma once
+
+#include "allocation_tracker.hpp"
+#include "common.hpp"
+#include "descriptor_heap.hpp"
+#include "upload_planner.hpp"
+
+namespace nether
+{
+// A buffer placed in one of the uploader's device local buffers.
+struct static_buffer_t
+{
+    u32 destination_buffer_index{};
+    u64 offset{};
+    u64 size{};
+
+    D3D12_GPU_VIRTUAL_ADDRESS gpu_address{};
+
+    // Only valid for structured buffers.
+    u32 srv_index{};
+};
+
+struct static_geometry_upload_statistics_t
+{
+    u32 num_buffers{};
+    u64 num_bytes{};
+
+    u32 num_batches{};
+    u32 num_copies{};
+    u32 num_destination_buffers{};
+
+    f32 planning_time_in_ms{};
+
+    // Time to write the staging buffers and submit the copies. With more batches than staging buffers, this includes
+    // waiting for the copy queue to release a staging buffer, so it is bound by the actual copy throughput.
+    f32 submission_time_in_ms{};
+};
+
+// Uploads static geometry (vertex and index data that never changes) to device local (DEFAULT heap) buffers, so that
+// the GPU does not read it across PCIe every frame.
+// Buffers are added up front, then upload places them in a few large destination buffers and copies them there on a
+// dedicated copy queue (see plan_uploads for the batching). Staging buffers are reused in a ring, so the CPU fills a
+// batch while the copy queue executes the previous one. The direct queue is made to wait on the copy queue's fence,
+// so the buffers can be used by any work submitted to it after upload returns. No barriers are needed, as buffers in
+// the COMMON state are implicitly promoted on both queues, and decay back to COMMON once the copies complete.
+class static_geometry_uploader_t
+{
+  public:
+    static constexpr u32 NUM_STAGING_BUFFERS = 2u;
+
+    explicit static_geometry_uploader_t(ID3D12Device *const device,
+                                        descriptor_heap_t *const cbv_srv_uav_descriptor_heap,
+                                        const upload_planner_config_t &config = {});
+    ~static_geometry_uploader_t();
+
+    static_geometry_uploader_t(const static_geometry_uploader_t &) = delete;
+    static_geometry_uploader_t &operator=(const static_geometry_uploader_t &) = delete;
+
+    // Returns the index of the buffer. The data is not copied, and must stay alive until upload returns.
+    template <typename T> u32 add_structured_buffer(const std::span<const T> data)
+    {
+        return add_buffer(std::span(reinterpret_cast<const u8 *>(data.data()), data.size_bytes()), sizeof(T),
+                          sizeof(T));
+    }
+
+    template <typename T> u32 add_index_buffer(const std::span<const T> data)
+    {
+        return add_buffer(std::span(reinterpret_cast<const u8 *>(data.data()), data.size_bytes()), sizeof(T), 0u);
+    }
+
+    // Uploads the buffers added since the last call.
+    void upload(ID3D12CommandQueue *const direct_command_queue);
+
+    const static_buffer_t &get_buffer(const u32 buffer_index) const
+    {
+        return buffers[buffer_index];
+    }
+
+    D3D12_INDEX_BUFFER_VIEW get_index_buffer_view(const u32 buffer_index, const DXGI_FORMAT format) const
+    {
+        return {
+            .BufferLocation = buffers[buffer_index].gpu_address,
+            .SizeInBytes = static_cast<UINT>(buffers[buffer_index].size),
+            .Format = format,
+        };
+    }
+
+  public:
+    std::vector<ComPtr<ID3D12Resource>> destination_buffers{};
+
+    static_geometry_upload_statistics_t statistics{};
+
+  private:
+    // A structure_byte_stride of 0 means that no SRV is created.
+    u32 add_buffer(const std::span<const u8> data, const u32 alignment, const u32 structure_byte_stride);
+
+    void wait_for_fence_value(const u64 fence_value);
+
+  private:
+    ComPtr<ID3D12Device> device{};
+    descriptor_heap_t *cbv_srv_uav_descriptor_heap{};
+    upload_planner_config_t config{};
+
+    ComPtr<ID3D12CommandQueue> copy_command_queue{};
+    std::array<ComPtr<ID3D12CommandAllocator>, NUM_STAGING_BUFFERS> copy_command_allocators{};
+    ComPtr<ID3D12GraphicsCommandList> copy_command_list{};
+
+    ComPtr<ID3D12Fence> fence{};
+    u64 current_fence_value{};
+
+    // Persistently mapped staging buffers, and the fence value of the last batch that used each of them.
+    std::array<ComPtr<ID3D12Resource>, NUM_STAGING_BUFFERS> staging_buffers{};
+    std::array<u8 *, NUM_STAGING_BUFFERS> staging_buffer_pointers{};
+    std::array<u64, NUM_STAGING_BUFFERS> staging_buffer_fence_values{};
+
+    // The buffers are registered with the allocation tracker (under the assets tag) while they exist.
+    std::array<memory::gpu_allocation_t, NUM_STAGING_BUFFERS> staging_buffer_allocations{};
+    std::vector<memory::gpu_allocation_t> destination_buffer_allocations{};
+
+    struct pending_buffer_t
+    {
+        std::span<const u8> data{};
+        u32 buffer_index{};
+        u32 structure_byte_stride{};
+    };
+
+    std::vector<upload_request_t> pending_requests{};
+    std::vector<pending_buffer_t> pending_buffers{};
+
+    std::vector<static_buffer_t> buffers{};
+};
+} // namespace nether
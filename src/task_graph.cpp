@@ -0,0 +1,261 @@
+#include "task_graph.hpp"
+
+namespace nether
+{
+task_graph_t::task_handle_t task_graph_t::add_task(const std::string_view name,
+                                                   const std::initializer_list<task_handle_t> dependencies,
+                                                   std::function<void()> function, const task_affinity_t affinity)
+{
+    const task_handle_t task_handle = static_cast<task_handle_t>(tasks.size());
+
+    for (const task_handle_t dependency : dependencies)
+    {
+        if (dependency >= task_handle)
+        {
+            throw std::runtime_error(
+                std::format("Task {} can only depend on tasks added before it (got task handle {})", name, dependency));
+        }
+    }
+
+    tasks.push_back({
+        .name = std::string(name),
+        .function = std::move(function),
+        .affinity = affinity,
+        .dependencies = dependencies,
+    });
+
+    for (const task_handle_t dependency : dependencies)
+    {
+        tasks[dependency].dependents.push_back(task_handle);
+    }
+
+    return task_handle;
+}
+
+void task_graph_t::execute(job_system_t *const job_system)
+{
+    this->job_system = job_system;
+
+    const u32 num_tasks = static_cast<u32>(tasks.size());
+
+    num_remaining_dependencies.resize(num_tasks);
+    skip.assign(num_tasks, false);
+    num_completed_tasks = 0u;
+    first_exception = nullptr;
+    calling_thread_queue.clear();
+
+    report = {};
+    report.tasks.resize(num_tasks);
+
+    for (u32 i = 0u; i < num_tasks; i++)
+    {
+        num_remaining_dependencies[i] = static_cast<u32>(tasks[i].dependencies.size());
+        report.tasks[i].name = tasks[i].name;
+    }
+
+    start_time = std::chrono::steady_clock::now();
+
+    for (u32 i = 0u; i < num_tasks; i++)
+    {
+        if (tasks[i].dependencies.empty())
+        {
+            dispatch_task(i);
+        }
+    }
+
+    // The calling thread runs its own tasks until every task has completed.
+    while (true)
+    {
+        task_handle_t task_handle{};
+
+        {
+            std::unique_lock lock(mutex);
+            condition_variable.wait(
+                lock, [&]() { return !calling_thread_queue.empty() || num_completed_tasks == num_tasks; });
+
+            if (calling_thread_queue.empty())
+            {
+                break;
+            }
+
+            task_handle = calling_thread_queue.front();
+            calling_thread_queue.pop_front();
+        }
+
+        run_task(task_handle);
+    }
+
+    report.wall_time_in_ms =
+        std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+    build_report();
+
+    if (first_exception)
+    {
+        std::rethrow_exception(first_exception);
+    }
+}
+
+void task_graph_t::run_task(const task_handle_t task_handle)
+{
+    task_timing_t &timing = report.tasks[task_handle];
+    timing.thread_index = job_system_t::get_thread_index();
+
+    bool skip_task = false;
+    {
+        std::scoped_lock lock(mutex);
+        skip_task = skip[task_handle];
+    }
+
+    const auto task_start_time = std::chrono::steady_clock::now();
+
+    bool failed = false;
+    if (!skip_task)
+    {
+        try
+        {
+            tasks[task_handle].function();
+        }
+        catch (...)
+        {
+            failed = true;
+
+            std::scoped_lock lock(mutex);
+            if (!first_exception)
+            {
+                first_exception = std::current_exception();
+            }
+        }
+    }
+
+    const auto task_end_time = std::chrono::steady_clock::now();
+
+    timing.start_time_in_ms = std::chrono::duration<f32, std::milli>(task_start_time - start_time).count();
+    timing.end_time_in_ms = std::chrono::duration<f32, std::milli>(task_end_time - start_time).count();
+    timing.skipped = skip_task;
+
+    // Release the dependents. They are dispatched outside of the lock, as the job system has its own.
+    std::vector<task_handle_t> ready_tasks{};
+    {
+        std::scoped_lock lock(mutex);
+
+        for (const task_handle_t dependent : tasks[task_handle].dependents)
+        {
+            if (failed || skip_task)
+            {
+                skip[dependent] = true;
+            }
+
+            if (--num_remaining_dependencies[dependent] == 0u)
+            {
+                ready_tasks.push_back(dependent);
+            }
+        }
+
+        // Notified under the lock : once the last task has completed, execute may return (and the graph be destroyed)
+        // as soon as the lock is released.
+        num_completed_tasks++;
+        condition_variable.notify_all();
+    }
+
+    for (const task_handle_t ready_task : ready_tasks)
+    {
+        dispatch_task(ready_task);
+    }
+}
+
+void task_graph_t::dispatch_task(const task_handle_t task_handle)
+{
+    if (job_system && tasks[task_handle].affinity == task_affinity_t::any_thread)
+    {
+        job_system->submit([this, task_handle]() { run_task(task_handle); });
+        return;
+    }
+
+    {
+        std::scoped_lock lock(mutex);
+        calling_thread_queue.push_back(task_handle);
+    }
+
+    condition_variable.notify_all();
+}
+
+void task_graph_t::build_report()
+{
+    const u32 num_tasks = static_cast<u32>(tasks.size());
+    if (num_tasks == 0u)
+    {
+        return;
+    }
+
+    // Tasks only depend on tasks added before them, so the tasks are already in topological order.
+    std::vector<f32> path_time_in_ms(num_tasks);
+    std::vector<u32> path_predecessor(num_tasks, ~0u);
+
+    u32 critical_path_end = 0u;
+    for (u32 i = 0u; i < num_tasks; i++)
+    {
+        f32 longest_dependency_path_in_ms = 0.0f;
+        for (const task_handle_t dependency : tasks[i].dependencies)
+        {
+            if (path_predecessor[i] == ~0u || path_time_in_ms[dependency] > longest_dependency_path_in_ms)
+            {
+                longest_dependency_path_in_ms = path_time_in_ms[dependency];
+                path_predecessor[i] = dependency;
+            }
+        }
+
+        const f32 duration_in_ms = report.tasks[i].get_duration_in_ms();
+        path_time_in_ms[i] = longest_dependency_path_in_ms + duration_in_ms;
+        report.serial_time_in_ms += duration_in_ms;
+
+        if (path_time_in_ms[i] > path_time_in_ms[critical_path_end])
+        {
+            critical_path_end = i;
+        }
+    }
+
+    for (u32 task_index = critical_path_end; task_index != ~0u; task_index = path_predecessor[task_index])
+    {
+        report.critical_path.push_back(task_index);
+    }
+
+    std::reverse(report.critical_path.begin(), report.critical_path.end());
+    report.critical_path_time_in_ms = path_time_in_ms[critical_path_end];
+}
+
+std::string to_string(const task_graph_report_t &report)
+{
+    std::string result{};
+
+    std::format_to(std::back_inserter(result),
+                   "{} tasks, wall time {:.2f} ms, serial time {:.2f} ms (parallelism {:.2f}x), critical path {:.2f} "
+                   "ms\n",
+                   report.tasks.size(), report.wall_time_in_ms, report.serial_time_in_ms,
+                   report.wall_time_in_ms > 0.0f ? report.serial_time_in_ms / report.wall_time_in_ms : 0.0f,
+                   report.critical_path_time_in_ms);
+
+    std::format_to(std::back_inserter(result), "  {:<32} {:>10} {:>10} {:>10} {:>7}\n", "task", "start (ms)",
+                   "end (ms)", "time (ms)", "thread");
+
+    for (u32 i = 0u; i < static_cast<u32>(report.tasks.size()); i++)
+    {
+        const task_timing_t &task = report.tasks[i];
+        const bool on_critical_path =
+            std::find(report.critical_path.begin(), report.critical_path.end(), i) != report.critical_path.end();
+
+        std::format_to(std::back_inserter(result), "{} {:<32} {:>10.2f} {:>10.2f} {:>10.2f} {:>7}{}\n",
+                       on_critical_path ? '*' : ' ', task.name, task.start_time_in_ms, task.end_time_in_ms,
+                       task.get_duration_in_ms(), task.thread_index, task.skipped ? " (skipped)" : "");
+    }
+
+    result += "Critical path :";
+    for (u32 i = 0u; i < static_cast<u32>(report.critical_path.size()); i++)
+    {
+        std::format_to(std::back_inserter(result), "{} {}", i == 0u ? "" : " ->",
+                       report.tasks[report.critical_path[i]].name);
+    }
+    result += '\n';
+
+    return result;
+}
+} // namespace nether
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "common.hpp"
+#include "job_system.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+namespace nether
+{
+enum class task_affinity_t : u8
+{
+    any_thread,
+
+    // For work that must stay on the thread that calls execute (e.g. anything tied to the window's thread).
+    calling_thread,
+};
+
+struct task_timing_t
+{
+    std::string name{};
+
+    // Relative to the start of execute.
+    f32 start_time_in_ms{};
+    f32 end_time_in_ms{};
+
+    // Index of the thread that ran the task (see job_system_t::get_thread_index).
+    u32 thread_index{};
+
+    // The task was not run, because a task it depends on failed.
+    bool skipped{};
+
+    f32 get_duration_in_ms() const
+    {
+        return end_time_in_ms - start_time_in_ms;
+    }
+};
+
+struct task_graph_report_t
+{
+    // In the order the tasks were added.
+    std::vector<task_timing_t> tasks{};
+
+    f32 wall_time_in_ms{};
+
+    // Sum of the task durations, i.e. the time a serial execution would take.
+    f32 serial_time_in_ms{};
+
+    // The chain of dependent tasks with the largest total duration (task indices, first to last). Its duration is the
+    // lower bound of the wall time with unlimited threads, so it is the chain to shorten to reduce the wall time.
+    std::vector<u32> critical_path{};
+    f32 critical_path_time_in_ms{};
+};
+
+// A table of the tasks (start, end, duration, thread, critical path tasks marked with '*'), followed by the critical
+// path.
+std::string to_string(const task_graph_report_t &report);
+
+// A graph of tasks with dependencies, executed once on the job system.
+// Tasks can only depend on tasks that were added before them, so the graph can not have cycles. A task is run once all
+// its dependencies have completed. Tasks are timed, and execute produces a report with the critical path.
+// The graph itself is not thread safe : tasks must not add tasks.
+class task_graph_t
+{
+  public:
+    using task_handle_t = u32;
+
+    // Throws if a dependency is not the handle of a task added before.
+    task_handle_t add_task(const std::string_view name, const std::initializer_list<task_handle_t> dependencies,
+                           std::function<void()> function,
+                           const task_affinity_t affinity = task_affinity_t::any_thread);
+
+    // Runs every task, and blocks until all have completed. Tasks run on the job system's workers (or all on the
+    // calling thread if job_system is null), and calling_thread tasks on the calling thread. If a task throws, the
+    // tasks that depend on it (directly or not) are skipped, and the first exception is rethrown once every other task
+    // has completed.
+    void execute(job_system_t *const job_system = nullptr);
+
+    // Valid after execute.
+    const task_graph_report_t &get_report() const
+    {
+        return report;
+    }
+
+    u32 get_num_tasks() const
+    {
+        return static_cast<u32>(tasks.size());
+    }
+
+  private:
+    void run_task(const task_handle_t task_handle);
+    void dispatch_task(const task_handle_t task_handle);
+    void build_report();
+
+  private:
+    struct task_t
+    {
+        std::string name{};
+        std::function<void()> function{};
+        task_affinity_t affinity{};
+
+        std::vector<task_handle_t> dependencies{};
+        std::vector<task_handle_t> dependents{};
+    };
+
+    std::vector<task_t> tasks{};
+
+    // Execution state, protected by mutex.
+    std::mutex mutex{};
+    std::condition_variable condition_variable{};
+    std::deque<task_handle_t> calling_thread_queue{};
+    std::vector<u32> num_remaining_dependencies{};
+    std::vector<bool> skip{};
+    u32 num_completed_tasks{};
+    std::exception_ptr first_exception{};
+
+    job_system_t *job_system{};
+    std::chrono::steady_clock::time_point start_time{};
+
+    task_graph_report_t report{};
+};
+} // namespace nether
@@ -0,0 +1,540 @@
+#include "terrain.hpp"
+
+#include "memory.hpp"
+
+#include <bit>
+#include <chrono>
+
+namespace nether
+{
+namespace
+{
+u32 get_num_nodes(const u32 num_depths)
+{
+    return terrain_t::get_node_index(num_depths, 0u, 0u);
+}
+
+void get_node_coordinates(const u32 node_index, u32 &depth, u32 &x, u32 &z)
+{
+    depth = 0u;
+    while (node_index >= terrain_t::get_node_index(depth + 1u, 0u, 0u))
+    {
+        depth++;
+    }
+
+    const u32 index_in_depth = node_index - terrain_t::get_node_index(depth, 0u, 0u);
+    x = index_in_depth % (1u << depth);
+    z = index_in_depth / (1u << depth);
+}
+
+f32 get_distance(const aabb_t &aabb, const float3_t &point)
+{
+    const float3_t closest_point = min(max(point, aabb.min), aabb.max);
+    return length(point - closest_point);
+}
+} // namespace
+
+void write_terrain_archive(const std::filesystem::path &path, const std::span<const u16> heights, const u32 size,
+                           const terrain_archive_desc_t &desc, job_system_t *const job_system)
+{
+    const u32 tile_resolution = desc.tile_resolution;
+    if (tile_resolution == 0u || size <= tile_resolution || (size - 1u) % tile_resolution != 0u ||
+        !std::has_single_bit((size - 1u) / tile_resolution))
+    {
+        throw std::runtime_error(std::format("A heightmap of {} samples per side can not be split into tiles of {} "
+                                             "quads (the size must be {} * 2^n + 1)",
+                                             size, tile_resolution, tile_resolution));
+    }
+
+    if (heights.size() != static_cast<size_t>(size) * size)
+    {
+        throw std::runtime_error(
+            std::format("Heightmap has {} samples instead of {} * {}", heights.size(), size, size));
+    }
+
+    const u32 num_depths = static_cast<u32>(std::countr_zero((size - 1u) / tile_resolution)) + 1u;
+    const u32 num_nodes = get_num_nodes(num_depths);
+    const f32 height_to_world = desc.height_scale / 65535.0f;
+
+    std::vector<terrain_node_t> nodes(num_nodes);
+
+    // Bottom up, as a node's error builds on its children's. The difference between a node's surface and its
+    // children's is largest at the children's vertices (the children's triangles subdivide the node's), so only those
+    // are compared : the midpoints of the node's edges and the centers of its quads, which are interpolated along the
+    // same diagonal as the index buffer's triangles.
+    for (u32 depth = num_depths; depth-- > 0u;)
+    {
+        const u32 num_nodes_per_side = 1u << depth;
+        const u32 stride = 1u << (num_depths - 1u - depth);
+
+        const auto process_nodes = [&](const u32 begin, const u32 end, const u32) {
+            for (u32 i = begin; i < end; i++)
+            {
+                const u32 x = i % num_nodes_per_side;
+                const u32 z = i / num_nodes_per_side;
+                const size_t first_x = static_cast<size_t>(x) * tile_resolution * stride;
+                const size_t first_z = static_cast<size_t>(z) * tile_resolution * stride;
+
+                terrain_node_t &node = nodes[terrain_t::get_node_index(depth, x, z)];
+
+                if (depth == num_depths - 1u)
+                {
+                    u16 min_height = 0xffffu;
+                    u16 max_height = 0u;
+                    for (size_t sample_z = first_z; sample_z <= first_z + tile_resolution; sample_z++)
+                    {
+                        for (size_t sample_x = first_x; sample_x <= first_x + tile_resolution; sample_x++)
+                        {
+                            min_height = std::min(min_height, heights[sample_z * size + sample_x]);
+                            max_height = std::max(max_height, heights[sample_z * size + sample_x]);
+                        }
+                    }
+
+                    node.min_height = min_height * height_to_world;
+                    node.max_height = max_height * height_to_world;
+                    node.geometric_error = 0.0f;
+                    continue;
+                }
+
+                node.min_height = std::numeric_limits<f32>::max();
+                node.max_height = std::numeric_limits<f32>::lowest();
+                f32 max_child_error = 0.0f;
+                for (u32 child = 0u; child < 4u; child++)
+                {
+                    const terrain_node_t &child_node =
+                        nodes[terrain_t::get_node_index(depth + 1u, 2u * x + (child & 1u), 2u * z + (child >> 1u))];
+                    node.min_height = std::min(node.min_height, child_node.min_height);
+                    node.max_height = std::max(node.max_height, child_node.max_height);
+                    max_child_error = std::max(max_child_error, child_node.geometric_error);
+                }
+
+                const size_t half_stride = stride / 2u;
+                const auto get_height = [&](const u32 child_x, const u32 child_z) {
+                    return static_cast<f32>(
+                        heights[(first_z + child_z * half_stride) * size + first_x + child_x * half_stride]);
+                };
+
+                f32 max_deviation = 0.0f;
+                for (u32 child_z = 0u; child_z <= 2u * tile_resolution; child_z++)
+                {
+                    for (u32 child_x = (child_z & 1u) ? 0u : 1u; child_x <= 2u * tile_resolution;
+                         child_x += (child_z & 1u) ? 1u : 2u)
+                    {
+                        f32 interpolated_height{};
+                        if ((child_x & 1u) && (child_z & 1u))
+                        {
+                            interpolated_height = 0.5f * (get_height(child_x - 1u, child_z - 1u) +
+                                                          get_height(child_x + 1u, child_z + 1u));
+                        }
+                        else if (child_x & 1u)
+                        {
+                            interpolated_height =
+                                0.5f * (get_height(child_x - 1u, child_z) + get_height(child_x + 1u, child_z));
+                        }
+                        else
+                        {
+                            interpolated_height =
+                                0.5f * (get_height(child_x, child_z - 1u) + get_height(child_x, child_z + 1u));
+                        }
+
+                        max_deviation =
+                            std::max(max_deviation, std::abs(get_height(child_x, child_z) - interpolated_height));
+                    }
+                }
+
+                node.geometric_error = max_child_error + max_deviation * height_to_world;
+            }
+        };
+
+        if (job_system)
+        {
+            job_system->parallel_for(num_nodes_per_side * num_nodes_per_side, 16u, process_nodes);
+        }
+        else
+        {
+            process_nodes(0u, num_nodes_per_side * num_nodes_per_side, 0u);
+        }
+    }
+
+    const u64 tile_size_in_bytes = static_cast<u64>(tile_resolution + 1u) * (tile_resolution + 1u) * sizeof(u16);
+
+    const terrain_archive_header_t header = {
+        .magic = TERRAIN_ARCHIVE_MAGIC,
+        .version = TERRAIN_ARCHIVE_VERSION,
+        .tile_resolution = tile_resolution,
+        .num_depths = num_depths,
+        .num_nodes = num_nodes,
+        .sample_spacing = desc.sample_spacing,
+        .height_scale = desc.height_scale,
+        .nodes_offset = sizeof(terrain_archive_header_t),
+        .tiles_offset = sizeof(terrain_archive_header_t) + num_nodes * sizeof(terrain_node_t),
+        .file_size = sizeof(terrain_archive_header_t) + num_nodes * sizeof(terrain_node_t) +
+                     num_nodes * tile_size_in_bytes,
+    };
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error(std::format("Failed to open {} for writing", path.string()));
+    }
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(nodes.data()), nodes.size() * sizeof(terrain_node_t));
+
+    std::vector<u16> tile((tile_resolution + 1u) * (tile_resolution + 1u));
+    for (u32 depth = 0u; depth < num_depths; depth++)
+    {
+        const u32 stride = 1u << (num_depths - 1u - depth);
+        for (u32 z = 0u; z < (1u << depth); z++)
+        {
+            for (u32 x = 0u; x < (1u << depth); x++)
+            {
+                const size_t first_x = static_cast<size_t>(x) * tile_resolution * stride;
+                const size_t first_z = static_cast<size_t>(z) * tile_resolution * stride;
+                for (u32 sample_z = 0u; sample_z <= tile_resolution; sample_z++)
+                {
+                    for (u32 sample_x = 0u; sample_x <= tile_resolution; sample_x++)
+                    {
+                        tile[sample_z * (tile_resolution + 1u) + sample_x] =
+                            heights[(first_z + sample_z * stride) * size + first_x + sample_x * stride];
+                    }
+                }
+
+                file.write(reinterpret_cast<const char *>(tile.data()), tile.size() * sizeof(u16));
+            }
+        }
+    }
+
+    if (!file)
+    {
+        throw std::runtime_error(std::format("Failed to write terrain archive {}", path.string()));
+    }
+}
+
+terrain_archive_header_t read_terrain_archive_header(const std::filesystem::path &path)
+{
+    terrain_archive_header_t header{};
+    file_reader_t(path).read(0u, &header, sizeof(header));
+    if (header.magic != TERRAIN_ARCHIVE_MAGIC || header.version != TERRAIN_ARCHIVE_VERSION)
+    {
+        throw std::runtime_error(std::format("{} is not a terrain archive (or has an unsupported version)",
+                                             path.string()));
+    }
+
+    const u64 tile_size_in_bytes = static_cast<u64>(header.tile_resolution + 1u) * (header.tile_resolution + 1u) * 2u;
+    if (header.tile_resolution == 0u || header.num_depths == 0u || header.num_depths > 15u ||
+        header.num_nodes != get_num_nodes(header.num_depths) ||
+        header.file_size != header.tiles_offset + header.num_nodes * tile_size_in_bytes ||
+        std::filesystem::file_size(path) < header.file_size)
+    {
+        throw std::runtime_error(std::format("Terrain archive {} has an invalid header", path.string()));
+    }
+
+    return header;
+}
+
+terrain_t::terrain_t(const std::filesystem::path &path, const terrain_settings_t &settings,
+                     const std::span<u16> tile_storage)
+    : settings(settings), file(path), header(read_terrain_archive_header(path))
+{
+    const u64 tile_size_in_bytes = static_cast<u64>(header.tile_resolution + 1u) * (header.tile_resolution + 1u) * 2u;
+
+    if (settings.cache_capacity_in_tiles < 5u)
+    {
+        throw std::runtime_error(std::format("A terrain cache of {} tiles can not hold the root and its children",
+                                             settings.cache_capacity_in_tiles));
+    }
+
+    nodes.resize(header.num_nodes);
+    file.read(header.nodes_offset, nodes.data(), nodes.size() * sizeof(terrain_node_t));
+
+    parent_indices.resize(header.num_nodes, INVALID_NODE_INDEX);
+    max_geometric_errors.resize(header.num_depths);
+    for (u32 depth = 0u; depth < header.num_depths; depth++)
+    {
+        for (u32 z = 0u; z < (1u << depth); z++)
+        {
+            for (u32 x = 0u; x < (1u << depth); x++)
+            {
+                const u32 node_index = get_node_index(depth, x, z);
+                if (depth > 0u)
+                {
+                    parent_indices[node_index] = get_node_index(depth - 1u, x / 2u, z / 2u);
+                }
+
+                max_geometric_errors[depth] = std::max(max_geometric_errors[depth], nodes[node_index].geometric_error);
+            }
+        }
+    }
+
+    num_resident_children.resize(header.num_nodes);
+    node_slots.resize(header.num_nodes, INVALID_SLOT);
+    last_used_updates.resize(header.num_nodes);
+
+    if (tile_storage.empty())
+    {
+        owned_tile_storage.resize(get_tile_storage_size());
+        this->tile_storage = owned_tile_storage;
+    }
+    else if (tile_storage.size() < get_tile_storage_size())
+    {
+        throw std::runtime_error(std::format("Terrain tile storage of {} samples is smaller than the {} samples of "
+                                             "{} tiles",
+                                             tile_storage.size(), get_tile_storage_size(),
+                                             settings.cache_capacity_in_tiles));
+    }
+    else
+    {
+        this->tile_storage = tile_storage;
+    }
+
+    slot_nodes.resize(settings.cache_capacity_in_tiles, INVALID_NODE_INDEX);
+    for (u32 slot = settings.cache_capacity_in_tiles; slot-- > 0u;)
+    {
+        free_slots.push_back(slot);
+    }
+
+    const u32 root_slot = free_slots.back();
+    free_slots.pop_back();
+
+    file.read(header.tiles_offset, this->tile_storage.data() + static_cast<size_t>(root_slot) * get_slot_stride(),
+              tile_size_in_bytes);
+    make_resident(0u, root_slot);
+}
+
+aabb_t terrain_t::get_node_bounds(const u32 depth, const u32 x, const u32 z) const
+{
+    const terrain_node_t &node = nodes[get_node_index(depth, x, z)];
+    const f32 node_size =
+        header.sample_spacing * static_cast<f32>(header.tile_resolution << (header.num_depths - 1u - depth));
+
+    const float3_t min = {
+        settings.origin.x + static_cast<f32>(x) * node_size,
+        settings.origin.y + node.min_height,
+        settings.origin.z + static_cast<f32>(z) * node_size,
+    };
+
+    return aabb_t{
+        .min = min,
+        .max = {min.x + node_size, settings.origin.y + node.max_height, min.z + node_size},
+    };
+}
+
+void terrain_t::select_patches(const terrain_view_t &view)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    update_index++;
+    camera_position = view.camera_position;
+
+    patches.clear();
+    tile_requests.clear();
+    statistics.num_visited_nodes = 0u;
+
+    select_node(view, 0u, 0u, 0u);
+
+    statistics.num_patches = static_cast<u32>(patches.size());
+    statistics.num_requested_tiles = static_cast<u32>(tile_requests.size());
+    statistics.selection_time_in_ms =
+        std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+void terrain_t::select_node(const terrain_view_t &view, const u32 depth, const u32 x, const u32 z)
+{
+    statistics.num_visited_nodes++;
+
+    const aabb_t bounds = get_node_bounds(depth, x, z);
+    if (!intersects(view.frustum, bounds))
+    {
+        return;
+    }
+
+    const u32 node_index = get_node_index(depth, x, z);
+    const f32 distance = std::max(get_distance(bounds, view.camera_position), 1e-3f);
+
+    const bool refine = depth + 1u < header.num_depths &&
+                        nodes[node_index].geometric_error * view.screen_space_error_scale >
+                            settings.max_screen_space_error_in_pixels * distance;
+    if (refine)
+    {
+        bool all_children_resident = true;
+        for (u32 child = 0u; child < 4u; child++)
+        {
+            const u32 child_x = 2u * x + (child & 1u);
+            const u32 child_z = 2u * z + (child >> 1u);
+            const u32 child_index = get_node_index(depth + 1u, child_x, child_z);
+            if (!is_resident(child_index))
+            {
+                all_children_resident = false;
+                tile_requests.push_back(tile_request_t{
+                    .node_index = child_index,
+                    .distance = get_distance(get_node_bounds(depth + 1u, child_x, child_z), view.camera_position),
+                });
+            }
+        }
+
+        if (all_children_resident)
+        {
+            for (u32 child = 0u; child < 4u; child++)
+            {
+                select_node(view, depth + 1u, 2u * x + (child & 1u), 2u * z + (child >> 1u));
+            }
+            return;
+        }
+    }
+
+    // The node is drawn itself, either because it is detailed enough or while its children stream in.
+    last_used_updates[node_index] = update_index;
+
+    const f32 sample_spacing = header.sample_spacing * static_cast<f32>(1u << (header.num_depths - 1u - depth));
+    patches.push_back(terrain_patch_t{
+        .origin = {bounds.min.x, bounds.min.z},
+        .sample_spacing = sample_spacing,
+        // A crack along an edge is at most as deep as the error of the coarser neighbour, which is (in practice) at
+        // most one depth coarser. The root has no neighbours.
+        .skirt_depth = depth > 0u ? max_geometric_errors[depth - 1u] : 0.0f,
+        .first_sample = node_slots[node_index] * get_slot_stride(),
+        .depth = depth,
+    });
+}
+
+void terrain_t::stream_tiles(job_system_t *const job_system)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    memory::scratch_scope_t scope{};
+    memory::linear_arena_t &arena = scope.get_arena();
+
+    std::ranges::sort(tile_requests, {}, &tile_request_t::distance);
+    const u32 num_requests = std::min(static_cast<u32>(tile_requests.size()), settings.max_tile_loads_per_update);
+
+    // Resident tiles that can be evicted, sorted by distance so that the furthest is at the back. They are gathered
+    // only once the cache is full : tiles without resident children, that no patch used for eviction_delay_in_updates
+    // (and never the root).
+    struct eviction_candidate_t
+    {
+        u32 node_index{};
+        f32 distance{};
+    };
+
+    eviction_candidate_t *const eviction_candidates =
+        arena.allocate_array<eviction_candidate_t>(settings.cache_capacity_in_tiles);
+    u32 num_eviction_candidates = 0u;
+    bool eviction_candidates_gathered = false;
+
+    const u64 eviction_delay = std::max(settings.eviction_delay_in_updates, 1u);
+
+    u32 *const load_node_indices = arena.allocate_array<u32>(num_requests);
+    u32 *const load_slots = arena.allocate_array<u32>(num_requests);
+    u32 num_loads = 0u;
+    u32 num_evicted_tiles = 0u;
+
+    for (u32 i = 0u; i < num_requests; i++)
+    {
+        if (free_slots.empty())
+        {
+            if (!eviction_candidates_gathered)
+            {
+                for (u32 slot = 0u; slot < settings.cache_capacity_in_tiles; slot++)
+                {
+                    const u32 node_index = slot_nodes[slot];
+                    if (node_index == INVALID_NODE_INDEX || node_index == 0u ||
+                        num_resident_children[node_index] > 0u ||
+                        last_used_updates[node_index] + eviction_delay > update_index)
+                    {
+                        continue;
+                    }
+
+                    u32 depth{};
+                    u32 x{};
+                    u32 z{};
+                    get_node_coordinates(node_index, depth, x, z);
+                    eviction_candidates[num_eviction_candidates++] = eviction_candidate_t{
+                        .node_index = node_index,
+                        .distance = get_distance(get_node_bounds(depth, x, z), camera_position),
+                    };
+                }
+
+                std::sort(eviction_candidates, eviction_candidates + num_eviction_candidates,
+                          [](const eviction_candidate_t &a, const eviction_candidate_t &b) {
+                              return a.distance < b.distance;
+                          });
+                eviction_candidates_gathered = true;
+            }
+
+            // Tiles closer than the request are more useful than it.
+            if (num_eviction_candidates == 0u ||
+                eviction_candidates[num_eviction_candidates - 1u].distance <= tile_requests[i].distance)
+            {
+                break;
+            }
+
+            evict(eviction_candidates[--num_eviction_candidates].node_index);
+            num_evicted_tiles++;
+        }
+
+        load_node_indices[num_loads] = tile_requests[i].node_index;
+        load_slots[num_loads] = free_slots.back();
+        free_slots.pop_back();
+        num_loads++;
+    }
+
+    const size_t num_tile_samples = (header.tile_resolution + 1u) * (header.tile_resolution + 1u);
+    const u64 tile_size_in_bytes = num_tile_samples * sizeof(u16);
+
+    const auto load_tiles = [&](const u32 begin, const u32 end, const u32) {
+        for (u32 i = begin; i < end; i++)
+        {
+            file.read(header.tiles_offset + load_node_indices[i] * tile_size_in_bytes,
+                      tile_storage.data() + static_cast<size_t>(load_slots[i]) * get_slot_stride(), tile_size_in_bytes);
+        }
+    };
+
+    if (job_system)
+    {
+        job_system->parallel_for(num_loads, 1u, load_tiles);
+    }
+    else
+    {
+        load_tiles(0u, num_loads, 0u);
+    }
+
+    // Newly loaded tiles count as used, so that they are not evicted before the next selection can use them.
+    for (u32 i = 0u; i < num_loads; i++)
+    {
+        make_resident(load_node_indices[i], load_slots[i]);
+        last_used_updates[load_node_indices[i]] = update_index;
+    }
+
+    statistics.num_loaded_tiles = num_loads;
+    statistics.num_evicted_tiles = num_evicted_tiles;
+    statistics.num_loaded_bytes = num_loads * tile_size_in_bytes;
+    statistics.num_resident_tiles = settings.cache_capacity_in_tiles - static_cast<u32>(free_slots.size());
+    statistics.streaming_time_in_ms =
+        std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+void terrain_t::make_resident(const u32 node_index, const u32 slot)
+{
+    node_slots[node_index] = slot;
+    slot_nodes[slot] = node_index;
+
+    if (parent_indices[node_index] != INVALID_NODE_INDEX)
+    {
+        num_resident_children[parent_indices[node_index]]++;
+    }
+}
+
+void terrain_t::evict(const u32 node_index)
+{
+    const u32 slot = node_slots[node_index];
+    node_slots[node_index] = INVALID_SLOT;
+    slot_nodes[slot] = INVALID_NODE_INDEX;
+    free_slots.push_back(slot);
+
+    if (parent_indices[node_index] != INVALID_NODE_INDEX)
+    {
+        num_resident_children[parent_indices[node_index]]--;
+    }
+}
+} // namespace nether
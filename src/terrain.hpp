@@ -0,0 +1,260 @@
+#pragma once
+
+#include "common.hpp"
+#include "file_reader.hpp"
+#include "job_system.hpp"
+#include "math.hpp"
+
+// Quadtree terrain, streamed from disk.
+//  - A square heightmap is split offline into a terrain archive (see write_terrain_archive / nether-terrain-packer) :
+//    a quadtree whose leaves are tiles of the full resolution heightmap, and whose inner nodes are tiles of the same
+//    resolution covering 4 times the area (every other sample of their children). Each node stores its height range
+//    and geometric error, the largest height difference between its tile and the full resolution heightmap.
+//  - select_patches walks the quadtree from the root, and refines a node when its geometric error, projected on the
+//    screen, is larger than max_screen_space_error_in_pixels. Nodes outside the view frustum are skipped.
+//  - Tiles are loaded into a bounded cache of slots by stream_tiles, closest to the camera first. A node is only
+//    refined once all of its children are resident, and a node is never evicted while one of its children is
+//    resident, so a resident ancestor can always stand in for missing detail. When the cache is full, the resident
+//    tiles furthest from the camera are evicted first.
+//  - Neighbouring patches of different depths do not share vertices along their edges, so every patch has skirts :
+//    a ring of vertices along its border that hangs below the surface and hides the cracks.
+// The selected patches and the tile slots are read by shaders/terrain_shader.hlsl.
+namespace nether
+{
+static constexpr u32 TERRAIN_ARCHIVE_MAGIC = 0x5254484e; // "NHTR"
+static constexpr u32 TERRAIN_ARCHIVE_VERSION = 1u;
+
+// Layout (all offsets are from the start of the file) :
+//  - terrain_archive_header_t.
+//  - One terrain_node_t per node, root first, then depth by depth. The nodes of a depth are in row major order.
+//  - The tiles, in the same order : (tile_resolution + 1)^2 u16 heights each, in row major order (x, then z).
+struct terrain_archive_header_t
+{
+    u32 magic{};
+    u32 version{};
+
+    // Quads along a tile's side. Tiles share their border samples with their neighbours.
+    u32 tile_resolution{};
+
+    // Depths of the quadtree (1 for a single tile). The heightmap has tile_resolution * 2^(num_depths - 1) + 1 samples
+    // along each side.
+    u32 num_depths{};
+    u32 num_nodes{};
+
+    // World units between two samples of the heightmap, and height of the largest sample (heights are unorm16).
+    f32 sample_spacing{};
+    f32 height_scale{};
+    u32 padding{};
+
+    u64 nodes_offset{};
+    u64 tiles_offset{};
+    u64 file_size{};
+};
+
+// Heights are in world units, relative to the terrain's origin.
+struct terrain_node_t
+{
+    f32 min_height{};
+    f32 max_height{};
+    f32 geometric_error{};
+    u32 padding{};
+};
+
+struct terrain_archive_desc_t
+{
+    u32 tile_resolution{64u};
+    f32 sample_spacing{1.0f};
+    f32 height_scale{256.0f};
+};
+
+// Throws if the heightmap's size is not tile_resolution * 2^n + 1, or if heights does not have size * size samples.
+// The geometric errors are computed in parallel over the nodes of each depth if job_system is not null.
+void write_terrain_archive(const std::filesystem::path &path, const std::span<const u16> heights, const u32 size,
+                           const terrain_archive_desc_t &desc, job_system_t *const job_system = nullptr);
+
+// Throws if the file is not a terrain archive (or a truncated one).
+terrain_archive_header_t read_terrain_archive_header(const std::filesystem::path &path);
+
+// A selected node, drawn as a grid of (tile_resolution + 1)^2 vertices plus its skirts. Must match terrain_patch_t in
+// shaders/terrain_shader.hlsl.
+struct terrain_patch_t
+{
+    // World space x and z of the patch's first sample.
+    float2_t origin{};
+    f32 sample_spacing{};
+    f32 skirt_depth{};
+
+    // Index of the patch's first height in the tile storage.
+    u32 first_sample{};
+    u32 depth{};
+};
+
+struct terrain_settings_t
+{
+    // World position of the heightmap's first sample, at a height of 0.
+    float3_t origin{};
+
+    f32 max_screen_space_error_in_pixels{2.0f};
+
+    u32 cache_capacity_in_tiles{1024u};
+    u32 max_tile_loads_per_update{64u};
+
+    // A slot used by a patch is not reused for this many updates, as the GPU may still be reading it (usually the
+    // number of frames in flight).
+    u32 eviction_delay_in_updates{3u};
+};
+
+struct terrain_view_t
+{
+    float3_t camera_position{};
+    frustum_t frustum{};
+
+    // Converts a world space error at a distance d from the camera to pixels : error * screen_space_error_scale / d.
+    f32 screen_space_error_scale{};
+};
+
+// For a perspective projection matrix (see perspective_reverse_z_matrix) and a viewport of the given height.
+inline f32 get_screen_space_error_scale(const float4x4_t &projection_matrix, const f32 viewport_height)
+{
+    return 0.5f * viewport_height * projection_matrix.m[1][1];
+}
+
+struct terrain_statistics_t
+{
+    u32 num_patches{};
+    u32 num_visited_nodes{};
+    u32 num_resident_tiles{};
+
+    // During the last select_patches : nodes that would have been refined if their children were resident.
+    u32 num_requested_tiles{};
+
+    // During the last stream_tiles.
+    u32 num_loaded_tiles{};
+    u32 num_evicted_tiles{};
+    u64 num_loaded_bytes{};
+
+    f32 selection_time_in_ms{};
+    f32 streaming_time_in_ms{};
+};
+
+class terrain_t
+{
+  public:
+    static constexpr u32 INVALID_SLOT = ~0u;
+    static constexpr u32 INVALID_NODE_INDEX = ~0u;
+
+    // Reads the archive's header and nodes, and loads the root tile (which always stays resident). tile_storage is
+    // where the tiles are loaded, get_tile_storage_size() samples (usually mapped upload memory, that the shader reads
+    // the heights from). If it is empty, the terrain allocates it. Throws if the archive is invalid, or if the cache
+    // can not hold at least the root and its children.
+    terrain_t(const std::filesystem::path &path, const terrain_settings_t &settings,
+              const std::span<u16> tile_storage = {});
+
+    // Selects the patches to draw from the resident tiles, and gathers the tiles that are missing for the view.
+    void select_patches(const terrain_view_t &view);
+
+    // Loads the tiles requested by the last select_patches (at most max_tile_loads_per_update, closest first), in
+    // parallel if job_system is not null. The loaded tiles are used by the next select_patches.
+    void stream_tiles(job_system_t *const job_system = nullptr);
+
+    u32 get_tile_storage_size() const
+    {
+        return get_tile_storage_size(header, settings);
+    }
+
+    u32 get_slot_stride() const
+    {
+        return get_slot_stride(header);
+    }
+
+    // For tile storage allocated before the terrain, from the header read by read_terrain_archive_header.
+    static u32 get_tile_storage_size(const terrain_archive_header_t &header, const terrain_settings_t &settings)
+    {
+        return settings.cache_capacity_in_tiles * get_slot_stride(header);
+    }
+
+    // Samples between the starts of two slots : the tile's samples, rounded up to a multiple of 2 so that slots are 4
+    // bytes aligned.
+    static u32 get_slot_stride(const terrain_archive_header_t &header)
+    {
+        const u32 num_tile_samples = (header.tile_resolution + 1u) * (header.tile_resolution + 1u);
+        return (num_tile_samples + 1u) & ~1u;
+    }
+
+    const terrain_archive_header_t &get_header() const
+    {
+        return header;
+    }
+
+    const terrain_node_t &get_node(const u32 node_index) const
+    {
+        return nodes[node_index];
+    }
+
+    bool is_resident(const u32 node_index) const
+    {
+        return node_slots[node_index] != INVALID_SLOT;
+    }
+
+    // The heights of a resident node's tile.
+    std::span<const u16> get_tile(const u32 node_index) const
+    {
+        return tile_storage.subspan(static_cast<size_t>(node_slots[node_index]) * get_slot_stride(),
+                                    (header.tile_resolution + 1u) * (header.tile_resolution + 1u));
+    }
+
+    static u32 get_node_index(const u32 depth, const u32 x, const u32 z)
+    {
+        // (4^depth - 1) / 3 nodes come before the first node of depth.
+        return ((1u << (2u * depth)) - 1u) / 3u + z * (1u << depth) + x;
+    }
+
+    aabb_t get_node_bounds(const u32 depth, const u32 x, const u32 z) const;
+
+  public:
+    std::vector<terrain_patch_t> patches{};
+
+    terrain_statistics_t statistics{};
+
+  private:
+    struct tile_request_t
+    {
+        u32 node_index{};
+        f32 distance{};
+    };
+
+    void select_node(const terrain_view_t &view, const u32 depth, const u32 x, const u32 z);
+
+    void make_resident(const u32 node_index, const u32 slot);
+    void evict(const u32 node_index);
+
+  private:
+    terrain_settings_t settings{};
+    file_reader_t file;
+
+    terrain_archive_header_t header{};
+    std::vector<terrain_node_t> nodes{};
+
+    // Parent of each node (INVALID_NODE_INDEX for the root), and the number of resident children of each node.
+    std::vector<u32> parent_indices{};
+    std::vector<u8> num_resident_children{};
+
+    std::vector<u16> owned_tile_storage{};
+    std::span<u16> tile_storage{};
+
+    std::vector<u32> node_slots{};
+    std::vector<u32> slot_nodes{};
+    std::vector<u32> free_slots{};
+
+    // The last update each node's tile was used by a patch (or loaded).
+    std::vector<u64> last_used_updates{};
+    u64 update_index{};
+
+    // Largest geometric error of the nodes of each depth, for the skirts.
+    std::vector<f32> max_geometric_errors{};
+
+    float3_t camera_position{};
+
+    std::vector<tile_request_t> tile_requests{};
+};
+} // namespace nether
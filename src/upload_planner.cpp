@@ -0,0 +1,192 @@
+#include "upload_planner.hpp"
+
+namespace nether
+{
+// Alignment of the start of each copy in the staging buffer.
+static constexpr u64 STAGING_ALIGNMENT = 16u;
+
+static u64 align_up_to_multiple(const u64 value, const u64 alignment)
+{
+    return (value + alignment - 1u) / alignment * alignment;
+}
+
+// Places the uploads back to back in destination buffers.
+static void place_uploads(const std::span<const upload_request_t> requests, const upload_planner_config_t &config,
+                          upload_plan_t &plan)
+{
+    constexpr u32 NO_SHARED_BUFFER = ~0u;
+    u32 shared_buffer_index = NO_SHARED_BUFFER;
+
+    plan.placements.resize(requests.size());
+
+    for (size_t i = 0u; i < requests.size(); i++)
+    {
+        const upload_request_t &request = requests[i];
+
+        if (request.size > config.destination_buffer_size)
+        {
+            plan.placements[i] = {
+                .destination_buffer_index = static_cast<u32>(plan.destination_buffer_sizes.size()),
+                .destination_offset = 0u,
+            };
+            plan.destination_buffer_sizes.push_back(request.size);
+
+            continue;
+        }
+
+        u64 offset = 0u;
+        if (shared_buffer_index != NO_SHARED_BUFFER)
+        {
+            offset = align_up_to_multiple(plan.destination_buffer_sizes[shared_buffer_index],
+                                          std::max<u64>(request.alignment, 1u));
+        }
+
+        if (shared_buffer_index == NO_SHARED_BUFFER || offset + request.size > config.destination_buffer_size)
+        {
+            shared_buffer_index = static_cast<u32>(plan.destination_buffer_sizes.size());
+            plan.destination_buffer_sizes.push_back(0u);
+            offset = 0u;
+        }
+
+        plan.placements[i] = {
+            .destination_buffer_index = shared_buffer_index,
+            .destination_offset = offset,
+        };
+        plan.destination_buffer_sizes[shared_buffer_index] = offset + request.size;
+    }
+}
+
+upload_plan_t plan_uploads(const std::span<const upload_request_t> requests, const upload_planner_config_t &config)
+{
+    if (config.staging_buffer_size == 0u || config.destination_buffer_size == 0u)
+    {
+        throw std::runtime_error("Upload planner staging and destination buffer sizes must not be 0");
+    }
+
+    upload_plan_t plan{};
+    place_uploads(requests, config, plan);
+
+    // The copy that the current run of uploads is coalesced into. The staging data of the run mirrors the layout of
+    // its destination range.
+    struct run_t
+    {
+        bool active{};
+        u32 copy_index{};
+        u32 destination_buffer_index{};
+        u64 destination_start{};
+        u64 staging_start{};
+    };
+
+    run_t run{};
+    upload_batch_t batch{};
+    u64 staging_used = 0u;
+
+    const auto finish_batch = [&]() {
+        batch.num_copies = static_cast<u32>(plan.copies.size()) - batch.first_copy;
+        batch.num_staging_writes = static_cast<u32>(plan.staging_writes.size()) - batch.first_staging_write;
+        batch.staging_size = staging_used;
+
+        if (batch.num_copies > 0u)
+        {
+            plan.batches.push_back(batch);
+        }
+
+        batch = {
+            .first_copy = static_cast<u32>(plan.copies.size()),
+            .first_staging_write = static_cast<u32>(plan.staging_writes.size()),
+        };
+        staging_used = 0u;
+        run.active = false;
+    };
+
+    const auto start_run = [&](const u32 request_index, const u64 source_offset, const u64 destination_offset,
+                               const u64 staging_offset, const u64 size) {
+        const u32 destination_buffer_index = plan.placements[request_index].destination_buffer_index;
+
+        run = {
+            .active = true,
+            .copy_index = static_cast<u32>(plan.copies.size()),
+            .destination_buffer_index = destination_buffer_index,
+            .destination_start = destination_offset,
+            .staging_start = staging_offset,
+        };
+
+        plan.copies.push_back({
+            .destination_buffer_index = destination_buffer_index,
+            .destination_offset = destination_offset,
+            .staging_offset = staging_offset,
+            .size = size,
+        });
+        plan.staging_writes.push_back({
+            .request_index = request_index,
+            .source_offset = source_offset,
+            .staging_offset = staging_offset,
+            .size = size,
+        });
+
+        staging_used = staging_offset + size;
+    };
+
+    for (u32 i = 0u; i < static_cast<u32>(requests.size()); i++)
+    {
+        const u64 size = requests[i].size;
+        if (size == 0u)
+        {
+            continue;
+        }
+
+        const upload_placement_t &placement = plan.placements[i];
+
+        // Extend the current run if the upload follows it in the same destination buffer, and its mirrored staging
+        // range still fits.
+        if (run.active && run.destination_buffer_index == placement.destination_buffer_index &&
+            placement.destination_offset >= run.destination_start)
+        {
+            const u64 staging_offset = run.staging_start + (placement.destination_offset - run.destination_start);
+            if (staging_offset + size <= config.staging_buffer_size)
+            {
+                plan.copies[run.copy_index].size = placement.destination_offset + size - run.destination_start;
+                plan.staging_writes.push_back({
+                    .request_index = i,
+                    .source_offset = 0u,
+                    .staging_offset = staging_offset,
+                    .size = size,
+                });
+
+                staging_used = staging_offset + size;
+                continue;
+            }
+        }
+
+        // Otherwise start a new copy, in the current batch if there is space left.
+        const u64 staging_offset = align_up_to_multiple(staging_used, STAGING_ALIGNMENT);
+        if (staging_offset + size <= config.staging_buffer_size)
+        {
+            start_run(i, 0u, placement.destination_offset, staging_offset, size);
+            continue;
+        }
+
+        if (staging_used > 0u)
+        {
+            finish_batch();
+        }
+
+        // Uploads larger than the staging buffer are split into staging buffer sized chunks, one batch each. The last
+        // chunk leaves its batch open for the following uploads.
+        for (u64 chunk_offset = 0u; chunk_offset < size; chunk_offset += config.staging_buffer_size)
+        {
+            if (chunk_offset > 0u)
+            {
+                finish_batch();
+            }
+
+            const u64 chunk_size = std::min(size - chunk_offset, config.staging_buffer_size);
+            start_run(i, chunk_offset, placement.destination_offset + chunk_offset, 0u, chunk_size);
+        }
+    }
+
+    finish_batch();
+
+    return plan;
+}
+} // namespace nether
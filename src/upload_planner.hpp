@@ -0,0 +1,81 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace nether
+{
+struct upload_planner_config_t
+{
+    // Size of a staging buffer. Each batch fits in one staging buffer, and data larger than it is split across batches.
+    u64 staging_buffer_size{16u * 1024u * 1024u};
+
+    // Size of the device local buffers the uploads are placed in. Uploads larger than this get a buffer of their own.
+    u64 destination_buffer_size{64u * 1024u * 1024u};
+};
+
+struct upload_request_t
+{
+    u64 size{};
+
+    // The destination offset is a multiple of the alignment (which does not need to be a power of two, so that it can
+    // be a structured buffer stride).
+    u64 alignment{1u};
+};
+
+// Where an upload ends up.
+struct upload_placement_t
+{
+    u32 destination_buffer_index{};
+    u64 destination_offset{};
+};
+
+// A single CopyBufferRegion, from the staging buffer of its batch to a destination buffer.
+struct upload_copy_t
+{
+    u32 destination_buffer_index{};
+    u64 destination_offset{};
+    u64 staging_offset{};
+    u64 size{};
+};
+
+// A range of an upload's source data that has to be written to the staging buffer before its batch is submitted.
+struct staging_write_t
+{
+    u32 request_index{};
+    u64 source_offset{};
+    u64 staging_offset{};
+    u64 size{};
+};
+
+// All copies of a batch share one staging buffer, and are submitted together.
+struct upload_batch_t
+{
+    u32 first_copy{};
+    u32 num_copies{};
+
+    u32 first_staging_write{};
+    u32 num_staging_writes{};
+
+    // Bytes of the staging buffer used by the batch.
+    u64 staging_size{};
+};
+
+struct upload_plan_t
+{
+    // Indexed by request.
+    std::vector<upload_placement_t> placements{};
+
+    std::vector<u64> destination_buffer_sizes{};
+
+    std::vector<upload_batch_t> batches{};
+    std::vector<upload_copy_t> copies{};
+    std::vector<staging_write_t> staging_writes{};
+};
+
+// Plans the upload of many (usually small) buffers into a few large device local buffers.
+// Uploads are placed back to back (respecting their alignment) in destination buffers, and the staging buffer of
+// each batch mirrors the layout of the destination, so that a run of consecutive uploads to the same destination buffer
+// is coalesced into a single copy (the alignment padding between them is copied too, which is cheaper than issuing a
+// copy per upload). A batch ends when its staging buffer is full.
+upload_plan_t plan_uploads(const std::span<const upload_request_t> requests, const upload_planner_config_t &config);
+} // namespace nether
@@ -0,0 +1,434 @@
+#include "vertex_compression.hpp"
+
+#include <chrono>
+
+namespace nether
+{
+namespace
+{
+constexpr u32 NUM_VERTICES_PER_BATCH = 4096u;
+
+f32 sign_not_zero(const f32 value)
+{
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+// Angle between two unit vectors, accurate for small angles (unlike acos of the dot product).
+f32 get_angle(const float3_t &a, const float3_t &b)
+{
+    return std::atan2(length(cross(a, b)), dot(a, b));
+}
+
+// Quantizing the octahedral coordinates independently can be off by up to a quantization step from the best encoding,
+// so the 4 encodings around the direction are decoded, and the one closest to the direction is kept.
+u32 encode_octahedral_snorm(const float3_t &direction, const u32 num_x_bits, const u32 num_y_bits)
+{
+    const float2_t encoded_direction = encode_octahedral(direction);
+    const f32 max_x = static_cast<f32>((1u << (num_x_bits - 1u)) - 1u);
+    const f32 max_y = static_cast<f32>((1u << (num_y_bits - 1u)) - 1u);
+
+    const f32 floor_x = std::floor(std::clamp(encoded_direction.x, -1.0f, 1.0f) * max_x);
+    const f32 floor_y = std::floor(std::clamp(encoded_direction.y, -1.0f, 1.0f) * max_y);
+
+    const float3_t unit_direction = normalize(direction);
+
+    // The closest encoding is the one with the shortest chord to the direction, which is cheaper to compare than the
+    // angle (and unlike the cosine, does not lose the small differences to rounding).
+    u32 best_bits = 0u;
+    f32 best_distance = std::numeric_limits<f32>::max();
+    for (u32 i = 0u; i < 4u; i++)
+    {
+        const f32 x = std::min(floor_x + static_cast<f32>(i & 1u), max_x);
+        const f32 y = std::min(floor_y + static_cast<f32>(i >> 1u), max_y);
+
+        const float3_t chord = unit_direction - decode_octahedral({x / max_x, y / max_y});
+        const f32 distance = dot(chord, chord);
+        if (distance < best_distance)
+        {
+            best_distance = distance;
+            best_bits = (static_cast<u32>(static_cast<i32>(x)) & ((1u << num_x_bits) - 1u)) |
+                        ((static_cast<u32>(static_cast<i32>(y)) & ((1u << num_y_bits) - 1u)) << num_x_bits);
+        }
+    }
+
+    return best_bits;
+}
+
+u32 zigzag_encode(const i32 value)
+{
+    return (static_cast<u32>(value) << 1u) ^ static_cast<u32>(value >> 31);
+}
+
+i32 zigzag_decode(const u32 value)
+{
+    return static_cast<i32>(value >> 1u) ^ -static_cast<i32>(value & 1u);
+}
+
+// value is in quantization steps.
+u16 quantize_position(const f32 value)
+{
+    return static_cast<u16>(std::round(std::clamp(value, 0.0f, 65535.0f)));
+}
+} // namespace
+
+u32 encode_snorm(const f32 value, const u32 num_bits)
+{
+    const f32 max_value = static_cast<f32>((1u << (num_bits - 1u)) - 1u);
+    const i32 quantized_value = static_cast<i32>(std::round(std::clamp(value, -1.0f, 1.0f) * max_value));
+
+    return static_cast<u32>(quantized_value) & ((1u << num_bits) - 1u);
+}
+
+f32 decode_snorm(const u32 bits, const u32 num_bits)
+{
+    // Sign extend the value's top bit.
+    const i32 quantized_value = static_cast<i32>(bits << (32u - num_bits)) >> (32u - num_bits);
+    const f32 max_value = static_cast<f32>((1u << (num_bits - 1u)) - 1u);
+
+    return std::max(static_cast<f32>(quantized_value) / max_value, -1.0f);
+}
+
+u16 f32_to_f16(const f32 value)
+{
+    u32 bits{};
+    std::memcpy(&bits, &value, sizeof(f32));
+
+    const u32 sign = (bits >> 16u) & 0x8000u;
+    const u32 magnitude = bits & 0x7fffffffu;
+
+    // NaN.
+    if (magnitude > 0x7f800000u)
+    {
+        return static_cast<u16>(sign | 0x7e00u);
+    }
+
+    // 65520 and above round to infinity, and are clamped to 65504 instead.
+    if (magnitude >= 0x477ff000u)
+    {
+        return static_cast<u16>(sign | 0x7bffu);
+    }
+
+    // Below the smallest normal half (2^-14) : a denormal, in units of 2^-24. Rounds up to the smallest normal.
+    if (magnitude < 0x38800000u)
+    {
+        f32 magnitude_value{};
+        std::memcpy(&magnitude_value, &magnitude, sizeof(f32));
+
+        return static_cast<u16>(sign | static_cast<u32>(std::nearbyint(magnitude_value * 16777216.0f)));
+    }
+
+    // Round the mantissa to nearest even, then rebias the exponent from 127 to 15.
+    const u32 rounded_magnitude = magnitude + 0xfffu + ((magnitude >> 13u) & 1u);
+    return static_cast<u16>(sign | ((rounded_magnitude - 0x38000000u) >> 13u));
+}
+
+f32 f16_to_f32(const u16 value)
+{
+    const u32 sign = static_cast<u32>(value & 0x8000u) << 16u;
+    const u32 exponent = (value >> 10u) & 0x1fu;
+    const u32 mantissa = value & 0x3ffu;
+
+    if (exponent == 0u)
+    {
+        const f32 magnitude = static_cast<f32>(mantissa) / 16777216.0f;
+        return sign ? -magnitude : magnitude;
+    }
+
+    const u32 bits = exponent == 0x1fu ? sign | 0x7f800000u | (mantissa << 13u)
+                                       : sign | ((exponent + 112u) << 23u) | (mantissa << 13u);
+
+    f32 result{};
+    std::memcpy(&result, &bits, sizeof(f32));
+
+    return result;
+}
+
+float2_t encode_octahedral(const float3_t &direction)
+{
+    const f32 l1_norm = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    if (l1_norm == 0.0f)
+    {
+        return float2_t{};
+    }
+
+    const f32 x = direction.x / l1_norm;
+    const f32 y = direction.y / l1_norm;
+
+    // The lower hemisphere is folded over the diagonals.
+    if (direction.z < 0.0f)
+    {
+        return float2_t{(1.0f - std::abs(y)) * sign_not_zero(x), (1.0f - std::abs(x)) * sign_not_zero(y)};
+    }
+
+    return float2_t{x, y};
+}
+
+float3_t decode_octahedral(const float2_t &encoded_direction)
+{
+    float3_t direction = {encoded_direction.x, encoded_direction.y,
+                          1.0f - std::abs(encoded_direction.x) - std::abs(encoded_direction.y)};
+
+    const f32 fold = std::max(-direction.z, 0.0f);
+    direction.x += direction.x >= 0.0f ? -fold : fold;
+    direction.y += direction.y >= 0.0f ? -fold : fold;
+
+    return normalize(direction);
+}
+
+u32 encode_normal(const float3_t &normal)
+{
+    return encode_octahedral_snorm(normal, 16u, 16u);
+}
+
+float3_t decode_normal(const u32 encoded_normal)
+{
+    return decode_octahedral({decode_snorm(encoded_normal, 16u), decode_snorm(encoded_normal >> 16u, 16u)});
+}
+
+u32 encode_tangent(const float4_t &tangent)
+{
+    return encode_octahedral_snorm({tangent.x, tangent.y, tangent.z}, 16u, 15u) | (tangent.w < 0.0f ? 1u << 31u : 0u);
+}
+
+float4_t decode_tangent(const u32 encoded_tangent)
+{
+    const float3_t tangent =
+        decode_octahedral({decode_snorm(encoded_tangent, 16u), decode_snorm(encoded_tangent >> 16u, 15u)});
+
+    return float4_t{tangent.x, tangent.y, tangent.z, (encoded_tangent >> 31u) ? -1.0f : 1.0f};
+}
+
+u32 encode_uv(const float2_t &uv)
+{
+    return static_cast<u32>(f32_to_f16(uv.x)) | (static_cast<u32>(f32_to_f16(uv.y)) << 16u);
+}
+
+float2_t decode_uv(const u32 encoded_uv)
+{
+    return float2_t{f16_to_f32(static_cast<u16>(encoded_uv)), f16_to_f32(static_cast<u16>(encoded_uv >> 16u))};
+}
+
+u32 encode_color(const float3_t &color)
+{
+    const auto encode_unorm8 = [](const f32 value) {
+        return static_cast<u32>(std::round(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+    };
+
+    return encode_unorm8(color.x) | (encode_unorm8(color.y) << 8u) | (encode_unorm8(color.z) << 16u) | (0xffu << 24u);
+}
+
+float4_t decode_color(const u32 encoded_color)
+{
+    return float4_t{
+        static_cast<f32>(encoded_color & 0xffu) / 255.0f,
+        static_cast<f32>((encoded_color >> 8u) & 0xffu) / 255.0f,
+        static_cast<f32>((encoded_color >> 16u) & 0xffu) / 255.0f,
+        static_cast<f32>(encoded_color >> 24u) / 255.0f,
+    };
+}
+
+compressed_mesh_vertices_t compress_mesh_vertices(const mesh_vertices_t &vertices, job_system_t *const job_system)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const size_t num_vertices = vertices.positions.size();
+    const auto check_attribute_size = [&](const size_t size, const std::string_view name) {
+        if (size != 0u && size != num_vertices)
+        {
+            throw std::runtime_error(std::format("Mesh has {} {} for {} positions", size, name, num_vertices));
+        }
+    };
+
+    check_attribute_size(vertices.normals.size(), "normals");
+    check_attribute_size(vertices.tangents.size(), "tangents");
+    check_attribute_size(vertices.uvs.size(), "uvs");
+    check_attribute_size(vertices.colors.size(), "colors");
+
+    compressed_mesh_vertices_t result{};
+
+    const float3_t first_position = vertices.positions.empty() ? float3_t{} : vertices.positions[0];
+    aabb_t bounds = {first_position, first_position};
+    for (const float3_t &position : vertices.positions)
+    {
+        bounds = merge(bounds, position);
+    }
+
+    // A flat axis has a scale of 0, and all of its positions quantize to 0.
+    result.position_offset = bounds.min;
+    result.position_scale = (bounds.max - bounds.min) * (1.0f / 65535.0f);
+
+    const float3_t inverse_position_scale = {
+        result.position_scale.x > 0.0f ? 1.0f / result.position_scale.x : 0.0f,
+        result.position_scale.y > 0.0f ? 1.0f / result.position_scale.y : 0.0f,
+        result.position_scale.z > 0.0f ? 1.0f / result.position_scale.z : 0.0f,
+    };
+
+    result.positions.resize(num_vertices);
+    result.normals.resize(vertices.normals.size());
+    result.tangents.resize(vertices.tangents.size());
+    result.uvs.resize(vertices.uvs.size());
+    result.colors.resize(vertices.colors.size());
+
+    // Errors are gathered per thread, and merged once every batch is done.
+    struct attribute_errors_t
+    {
+        f32 position{};
+        f32 normal{};
+        f32 tangent{};
+        f32 uv{};
+        f32 color{};
+    };
+
+    std::vector<attribute_errors_t> thread_errors(job_system ? job_system->get_num_threads() : 1u);
+
+    const auto compress_batches = [&](const u32 begin, const u32 end, const u32 thread_index) {
+        attribute_errors_t &errors = thread_errors[thread_index];
+
+        const size_t first_vertex = static_cast<size_t>(begin) * NUM_VERTICES_PER_BATCH;
+        const size_t last_vertex = std::min(static_cast<size_t>(end) * NUM_VERTICES_PER_BATCH, num_vertices);
+
+        for (size_t i = first_vertex; i < last_vertex; i++)
+        {
+            const float3_t &position = vertices.positions[i];
+            const float3_t relative_position = position - result.position_offset;
+
+            result.positions[i] = quantized_position_t{
+                .x = quantize_position(relative_position.x * inverse_position_scale.x),
+                .y = quantize_position(relative_position.y * inverse_position_scale.y),
+                .z = quantize_position(relative_position.z * inverse_position_scale.z),
+            };
+
+            const float3_t decoded_position = result.decode_position(result.positions[i]);
+            errors.position = std::max({errors.position, std::abs(decoded_position.x - position.x),
+                                        std::abs(decoded_position.y - position.y),
+                                        std::abs(decoded_position.z - position.z)});
+        }
+
+        for (size_t i = first_vertex; i < std::min(last_vertex, vertices.normals.size()); i++)
+        {
+            result.normals[i] = encode_normal(vertices.normals[i]);
+            errors.normal =
+                std::max(errors.normal, get_angle(normalize(vertices.normals[i]), decode_normal(result.normals[i])));
+        }
+
+        for (size_t i = first_vertex; i < std::min(last_vertex, vertices.tangents.size()); i++)
+        {
+            const float4_t &tangent = vertices.tangents[i];
+            result.tangents[i] = encode_tangent(tangent);
+
+            const float4_t decoded_tangent = decode_tangent(result.tangents[i]);
+            errors.tangent = std::max(errors.tangent, get_angle(normalize({tangent.x, tangent.y, tangent.z}),
+                                                                {decoded_tangent.x, decoded_tangent.y,
+                                                                 decoded_tangent.z}));
+        }
+
+        for (size_t i = first_vertex; i < std::min(last_vertex, vertices.uvs.size()); i++)
+        {
+            result.uvs[i] = encode_uv(vertices.uvs[i]);
+
+            const float2_t decoded_uv = decode_uv(result.uvs[i]);
+            errors.uv = std::max({errors.uv, std::abs(decoded_uv.x - vertices.uvs[i].x),
+                                  std::abs(decoded_uv.y - vertices.uvs[i].y)});
+        }
+
+        for (size_t i = first_vertex; i < std::min(last_vertex, vertices.colors.size()); i++)
+        {
+            const float3_t &color = vertices.colors[i];
+            result.colors[i] = encode_color(color);
+
+            const float4_t decoded_color = decode_color(result.colors[i]);
+            errors.color = std::max({errors.color, std::abs(decoded_color.x - std::clamp(color.x, 0.0f, 1.0f)),
+                                     std::abs(decoded_color.y - std::clamp(color.y, 0.0f, 1.0f)),
+                                     std::abs(decoded_color.z - std::clamp(color.z, 0.0f, 1.0f))});
+        }
+    };
+
+    const u32 num_batches = static_cast<u32>((num_vertices + NUM_VERTICES_PER_BATCH - 1u) / NUM_VERTICES_PER_BATCH);
+    if (job_system)
+    {
+        job_system->parallel_for(num_batches, 1u, compress_batches);
+    }
+    else
+    {
+        compress_batches(0u, num_batches, 0u);
+    }
+
+    vertex_compression_statistics_t &statistics = result.statistics;
+    statistics.positions = {num_vertices * sizeof(float3_t), num_vertices * sizeof(quantized_position_t)};
+    statistics.normals = {vertices.normals.size() * sizeof(float3_t), vertices.normals.size() * sizeof(u32)};
+    statistics.tangents = {vertices.tangents.size() * sizeof(float4_t), vertices.tangents.size() * sizeof(u32)};
+    statistics.uvs = {vertices.uvs.size() * sizeof(float2_t), vertices.uvs.size() * sizeof(u32)};
+    statistics.colors = {vertices.colors.size() * sizeof(float3_t), vertices.colors.size() * sizeof(u32)};
+
+    for (const attribute_errors_t &errors : thread_errors)
+    {
+        statistics.positions.max_error = std::max(statistics.positions.max_error, errors.position);
+        statistics.normals.max_error = std::max(statistics.normals.max_error, errors.normal);
+        statistics.tangents.max_error = std::max(statistics.tangents.max_error, errors.tangent);
+        statistics.uvs.max_error = std::max(statistics.uvs.max_error, errors.uv);
+        statistics.colors.max_error = std::max(statistics.colors.max_error, errors.color);
+    }
+
+    statistics.compression_time_in_ms =
+        std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+    return result;
+}
+
+std::vector<u8> compress_indices(const std::span<const u32> indices)
+{
+    std::vector<u8> data{};
+    data.reserve(indices.size() + indices.size() / 2u);
+
+    u32 previous_index = 0u;
+    for (const u32 index : indices)
+    {
+        u32 value = zigzag_encode(static_cast<i32>(index - previous_index));
+        previous_index = index;
+
+        while (value >= 0x80u)
+        {
+            data.push_back(static_cast<u8>(value | 0x80u));
+            value >>= 7u;
+        }
+        data.push_back(static_cast<u8>(value));
+    }
+
+    return data;
+}
+
+void decompress_indices(const std::span<const u8> data, const std::span<u32> indices)
+{
+    size_t offset = 0u;
+    u32 previous_index = 0u;
+    for (u32 &index : indices)
+    {
+        u32 value = 0u;
+        for (u32 shift = 0u;; shift += 7u)
+        {
+            if (offset == data.size() || shift > 28u)
+            {
+                throw std::runtime_error(
+                    std::format("Compressed indices are truncated or corrupted at byte {}", offset));
+            }
+
+            const u8 byte = data[offset++];
+            value |= static_cast<u32>(byte & 0x7fu) << shift;
+            if (!(byte & 0x80u))
+            {
+                break;
+            }
+        }
+
+        index = previous_index + static_cast<u32>(zigzag_decode(value));
+        previous_index = index;
+    }
+
+    if (offset != data.size())
+    {
+        throw std::runtime_error(
+            std::format("Compressed indices hold more than {} indices ({} bytes left)", indices.size(),
+                        data.size() - offset));
+    }
+}
+} // namespace nether
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "common.hpp"
+#include "job_system.hpp"
+#include "math.hpp"
+
+// Quantized vertex formats, decoded by the vertex shaders (see the decode_* functions of shaders/common.hlsli).
+//  - Positions : 16 bit unorm per component, relative to the mesh's bounds (8 bytes with the unused w, as structured
+//    buffer strides are multiples of 4).
+//  - Normals : octahedral encoding, 16 bit snorm per component (4 bytes).
+//  - Tangents : octahedral encoding with 16 and 15 bit snorm components, and the bitangent sign in the top bit (4
+//    bytes).
+//  - UVs : 16 bit floats (4 bytes).
+//  - Colors : 8 bit unorm RGBA, red in the lowest byte (4 bytes).
+// Index buffers can also be compressed for storage (not for the GPU) : each index is stored as the zigzag encoded
+// difference with the previous index, in a variable number of bytes (7 bits per byte). Neighbouring triangles share
+// vertices, so most differences fit in a byte.
+namespace nether
+{
+// Must match the decode functions of shaders/common.hlsli.
+struct quantized_position_t
+{
+    u16 x{};
+    u16 y{};
+    u16 z{};
+    u16 padding{};
+};
+
+u32 encode_snorm(const f32 value, const u32 num_bits);
+f32 decode_snorm(const u32 bits, const u32 num_bits);
+
+// Round to nearest even. Values outside of the half range are clamped to the largest finite half.
+u16 f32_to_f16(const f32 value);
+f32 f16_to_f32(const u16 value);
+
+float2_t encode_octahedral(const float3_t &direction);
+float3_t decode_octahedral(const float2_t &encoded_direction);
+
+u32 encode_normal(const float3_t &normal);
+float3_t decode_normal(const u32 encoded_normal);
+
+// The tangent's w is the sign of the bitangent (cross(normal, tangent) * w).
+u32 encode_tangent(const float4_t &tangent);
+float4_t decode_tangent(const u32 encoded_tangent);
+
+u32 encode_uv(const float2_t &uv);
+float2_t decode_uv(const u32 encoded_uv);
+
+// Alpha is 1.
+u32 encode_color(const float3_t &color);
+float4_t decode_color(const u32 encoded_color);
+
+// The attributes of a mesh's vertices. Every attribute except the positions is optional (empty), and the attributes
+// that are present have one element per position.
+struct mesh_vertices_t
+{
+    std::span<const float3_t> positions{};
+    std::span<const float3_t> normals{};
+    std::span<const float4_t> tangents{};
+    std::span<const float2_t> uvs{};
+    std::span<const float3_t> colors{};
+};
+
+struct vertex_attribute_statistics_t
+{
+    u64 uncompressed_size_in_bytes{};
+    u64 compressed_size_in_bytes{};
+
+    // Largest difference between a decoded attribute and the original : the largest absolute difference of any
+    // component for positions (in world units), UVs and colors, and the largest angle (in radians) for normals and
+    // tangents.
+    f32 max_error{};
+};
+
+struct vertex_compression_statistics_t
+{
+    vertex_attribute_statistics_t positions{};
+    vertex_attribute_statistics_t normals{};
+    vertex_attribute_statistics_t tangents{};
+    vertex_attribute_statistics_t uvs{};
+    vertex_attribute_statistics_t colors{};
+
+    u64 get_uncompressed_size_in_bytes() const
+    {
+        return positions.uncompressed_size_in_bytes + normals.uncompressed_size_in_bytes +
+               tangents.uncompressed_size_in_bytes + uvs.uncompressed_size_in_bytes + colors.uncompressed_size_in_bytes;
+    }
+
+    u64 get_compressed_size_in_bytes() const
+    {
+        return positions.compressed_size_in_bytes + normals.compressed_size_in_bytes +
+               tangents.compressed_size_in_bytes + uvs.compressed_size_in_bytes + colors.compressed_size_in_bytes;
+    }
+
+    f32 compression_time_in_ms{};
+};
+
+struct compressed_mesh_vertices_t
+{
+    // Decoded positions are position_offset + quantized position * position_scale.
+    float3_t position_offset{};
+    float3_t position_scale{};
+
+    std::vector<quantized_position_t> positions{};
+    std::vector<u32> normals{};
+    std::vector<u32> tangents{};
+    std::vector<u32> uvs{};
+    std::vector<u32> colors{};
+
+    vertex_compression_statistics_t statistics{};
+
+    float3_t decode_position(const quantized_position_t &position) const
+    {
+        return float3_t{
+            position_offset.x + position.x * position_scale.x,
+            position_offset.y + position.y * position_scale.y,
+            position_offset.z + position.z * position_scale.z,
+        };
+    }
+};
+
+// Throws if an optional attribute does not have one element per position. The vertices are compressed in parallel if
+// job_system is not null.
+compressed_mesh_vertices_t compress_mesh_vertices(const mesh_vertices_t &vertices,
+                                                  job_system_t *const job_system = nullptr);
+
+std::vector<u8> compress_indices(const std::span<const u32> indices);
+
+// Throws if the data does not hold exactly indices.size() indices.
+void decompress_indices(const std::span<const u8> data, const std::span<u32> indices);
+} // namespace nether
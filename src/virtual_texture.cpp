@@ -0,0 +1,604 @@
+#include "virtual_texture.hpp"
+
+#include <bit>
+#include <chrono>
+
+namespace nether
+{
+namespace
+{
+// A mip has at most 4096 tiles along each side, as the tile coordinates of the feedback are 12 bits.
+constexpr u32 MAX_NUM_VIRTUAL_TEXTURE_MIPS = 13u;
+
+u32 get_num_tiles_per_side(const u32 num_mips, const u32 mip)
+{
+    return 1u << (num_mips - 1u - mip);
+}
+
+// Average of 4 RGBA8 texels, per channel.
+u32 average_texels(const u32 a, const u32 b, const u32 c, const u32 d)
+{
+    u32 result = 0u;
+    for (u32 shift = 0u; shift < 32u; shift += 8u)
+    {
+        const u32 sum =
+            ((a >> shift) & 0xffu) + ((b >> shift) & 0xffu) + ((c >> shift) & 0xffu) + ((d >> shift) & 0xffu);
+        result |= ((sum + 2u) / 4u) << shift;
+    }
+
+    return result;
+}
+} // namespace
+
+void write_virtual_texture_archive(const std::filesystem::path &path, const std::span<const u32> texels,
+                                   const u32 size, const virtual_texture_archive_desc_t &desc,
+                                   job_system_t *const job_system)
+{
+    const u32 tile_size = desc.tile_size;
+    if (tile_size == 0u || size < tile_size || size % tile_size != 0u || !std::has_single_bit(size / tile_size) ||
+        std::countr_zero(size / tile_size) >= static_cast<int>(MAX_NUM_VIRTUAL_TEXTURE_MIPS))
+    {
+        throw std::runtime_error(std::format("A texture of {} texels per side can not be split into tiles of {} texels "
+                                             "(the size must be {} * 2^n, with n < {})",
+                                             size, tile_size, tile_size, MAX_NUM_VIRTUAL_TEXTURE_MIPS));
+    }
+
+    if (texels.size() != static_cast<size_t>(size) * size)
+    {
+        throw std::runtime_error(std::format("Texture has {} texels instead of {} * {}", texels.size(), size, size));
+    }
+
+    const u32 num_mips = static_cast<u32>(std::countr_zero(size / tile_size)) + 1u;
+
+    // mips[0] is empty, the first mip being texels itself.
+    std::vector<std::vector<u32>> mips(num_mips);
+    const auto get_mip_texels = [&](const u32 mip) {
+        return mip == 0u ? texels : std::span<const u32>(mips[mip]);
+    };
+
+    for (u32 mip = 1u; mip < num_mips; mip++)
+    {
+        const u32 mip_size = size >> mip;
+        const std::span<const u32> source = get_mip_texels(mip - 1u);
+
+        mips[mip].resize(static_cast<size_t>(mip_size) * mip_size);
+        const auto downsample_rows = [&](const u32 begin, const u32 end, const u32) {
+            for (u32 y = begin; y < end; y++)
+            {
+                const size_t first_source_texel = static_cast<size_t>(2u * y) * (2u * mip_size);
+                for (u32 x = 0u; x < mip_size; x++)
+                {
+                    const size_t source_texel = first_source_texel + 2u * x;
+                    mips[mip][static_cast<size_t>(y) * mip_size + x] =
+                        average_texels(source[source_texel], source[source_texel + 1u],
+                                       source[source_texel + 2u * mip_size], source[source_texel + 2u * mip_size + 1u]);
+                }
+            }
+        };
+
+        if (job_system)
+        {
+            job_system->parallel_for(mip_size, 16u, downsample_rows);
+        }
+        else
+        {
+            downsample_rows(0u, mip_size, 0u);
+        }
+    }
+
+    const u32 page_size = tile_size + 2u * desc.tile_border;
+    const u64 page_size_in_bytes = static_cast<u64>(page_size) * page_size * sizeof(u32);
+    const u32 num_tiles = get_num_virtual_tiles(num_mips);
+
+    const virtual_texture_archive_header_t header = {
+        .magic = VIRTUAL_TEXTURE_ARCHIVE_MAGIC,
+        .version = VIRTUAL_TEXTURE_ARCHIVE_VERSION,
+        .tile_size = tile_size,
+        .tile_border = desc.tile_border,
+        .num_mips = num_mips,
+        .num_tiles = num_tiles,
+        .tiles_offset = sizeof(virtual_texture_archive_header_t),
+        .file_size = sizeof(virtual_texture_archive_header_t) + num_tiles * page_size_in_bytes,
+    };
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error(std::format("Failed to open {} for writing", path.string()));
+    }
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    // The borders are clamped to the edges of the texture.
+    std::vector<u32> page(static_cast<size_t>(page_size) * page_size);
+    for (u32 mip = num_mips; mip-- > 0u;)
+    {
+        const i32 mip_size = static_cast<i32>(size >> mip);
+        const std::span<const u32> mip_texels = get_mip_texels(mip);
+
+        const u32 num_tiles_per_side = get_num_tiles_per_side(num_mips, mip);
+        for (u32 tile_y = 0u; tile_y < num_tiles_per_side; tile_y++)
+        {
+            for (u32 tile_x = 0u; tile_x < num_tiles_per_side; tile_x++)
+            {
+                const i32 first_x = static_cast<i32>(tile_x * tile_size) - static_cast<i32>(desc.tile_border);
+                const i32 first_y = static_cast<i32>(tile_y * tile_size) - static_cast<i32>(desc.tile_border);
+                for (u32 y = 0u; y < page_size; y++)
+                {
+                    const i32 texel_y = std::clamp(first_y + static_cast<i32>(y), 0, mip_size - 1);
+                    for (u32 x = 0u; x < page_size; x++)
+                    {
+                        const i32 texel_x = std::clamp(first_x + static_cast<i32>(x), 0, mip_size - 1);
+                        page[static_cast<size_t>(y) * page_size + x] =
+                            mip_texels[static_cast<size_t>(texel_y) * mip_size + texel_x];
+                    }
+                }
+
+                file.write(reinterpret_cast<const char *>(page.data()), page.size() * sizeof(u32));
+            }
+        }
+    }
+
+    if (!file)
+    {
+        throw std::runtime_error(std::format("Failed to write virtual texture archive {}", path.string()));
+    }
+}
+
+virtual_texture_archive_header_t read_virtual_texture_archive_header(const std::filesystem::path &path)
+{
+    virtual_texture_archive_header_t header{};
+    file_reader_t(path).read(0u, &header, sizeof(header));
+    if (header.magic != VIRTUAL_TEXTURE_ARCHIVE_MAGIC || header.version != VIRTUAL_TEXTURE_ARCHIVE_VERSION)
+    {
+        throw std::runtime_error(std::format("{} is not a virtual texture archive (or has an unsupported version)",
+                                             path.string()));
+    }
+
+    const u64 page_size = header.tile_size + 2u * static_cast<u64>(header.tile_border);
+    if (header.tile_size == 0u || header.num_mips == 0u || header.num_mips > MAX_NUM_VIRTUAL_TEXTURE_MIPS ||
+        header.num_tiles != get_num_virtual_tiles(header.num_mips) ||
+        header.file_size != header.tiles_offset + header.num_tiles * page_size * page_size * sizeof(u32) ||
+        std::filesystem::file_size(path) < header.file_size)
+    {
+        throw std::runtime_error(std::format("Virtual texture archive {} has an invalid header", path.string()));
+    }
+
+    return header;
+}
+
+virtual_tile_t get_virtual_tile(const u32 num_mips, const u32 tile_index)
+{
+    u32 depth = 0u;
+    while (tile_index >= get_num_virtual_tiles(depth + 1u))
+    {
+        depth++;
+    }
+
+    const u32 index_in_mip = tile_index - get_num_virtual_tiles(depth);
+    return virtual_tile_t{
+        .mip = num_mips - 1u - depth,
+        .x = index_in_mip % (1u << depth),
+        .y = index_in_mip / (1u << depth),
+    };
+}
+
+virtual_texture_feedback_processor_t::virtual_texture_feedback_processor_t(const u32 num_mips)
+    : num_mips(num_mips), sample_counts(get_num_virtual_tiles(num_mips))
+{
+}
+
+const std::vector<virtual_tile_request_t> &virtual_texture_feedback_processor_t::process(
+    const std::span<const u32> feedback)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    requests.clear();
+    statistics = {};
+
+    for (const u32 tile_id : feedback)
+    {
+        if (tile_id == INVALID_VIRTUAL_TILE_ID)
+        {
+            continue;
+        }
+
+        const virtual_tile_t tile = unpack_virtual_tile_id(tile_id);
+        if (tile.mip >= num_mips || std::max(tile.x, tile.y) >= get_num_tiles_per_side(num_mips, tile.mip))
+        {
+            statistics.num_invalid_samples++;
+            continue;
+        }
+
+        const u32 tile_index = get_virtual_tile_index(num_mips, tile);
+        if (sample_counts[tile_index]++ == 0u)
+        {
+            requests.push_back(virtual_tile_request_t{.tile_index = tile_index, .mip = tile.mip});
+        }
+
+        statistics.num_samples++;
+    }
+
+    for (virtual_tile_request_t &request : requests)
+    {
+        request.num_samples = sample_counts[request.tile_index];
+        sample_counts[request.tile_index] = 0u;
+    }
+
+    std::ranges::sort(requests, [](const virtual_tile_request_t &a, const virtual_tile_request_t &b) {
+        if (a.mip != b.mip)
+        {
+            return a.mip > b.mip;
+        }
+
+        return a.num_samples != b.num_samples ? a.num_samples > b.num_samples : a.tile_index < b.tile_index;
+    });
+
+    statistics.num_requested_tiles = static_cast<u32>(requests.size());
+    statistics.processing_time_in_ms =
+        std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+    return requests;
+}
+
+virtual_page_table_t::virtual_page_table_t(const u32 num_mips, const u32 root_page)
+    : num_mips(num_mips),
+      entries(get_num_virtual_tiles(num_mips), pack_virtual_page_table_entry(root_page, num_mips - 1u)),
+      dirty_regions(num_mips)
+{
+    num_written_entries = entries.size();
+    for (u32 mip = 0u; mip < num_mips; mip++)
+    {
+        const u32 num_tiles_per_side = get_num_tiles_per_side(num_mips, mip);
+        dirty_regions[mip] = {0u, 0u, num_tiles_per_side - 1u, num_tiles_per_side - 1u};
+    }
+}
+
+void virtual_page_table_t::map(const virtual_tile_t &tile, const u32 page)
+{
+    replace_entries(tile, tile.mip, pack_virtual_page_table_entry(page, tile.mip));
+}
+
+void virtual_page_table_t::unmap(const virtual_tile_t &tile)
+{
+    if (tile.mip == num_mips - 1u)
+    {
+        throw std::runtime_error("The tile of the last mip of a virtual texture can not be unmapped");
+    }
+
+    replace_entries(tile, tile.mip, get_entry({.mip = tile.mip + 1u, .x = tile.x / 2u, .y = tile.y / 2u}));
+}
+
+void virtual_page_table_t::clear_dirty_regions()
+{
+    std::ranges::fill(dirty_regions, virtual_page_table_region_t{});
+}
+
+void virtual_page_table_t::replace_entries(const virtual_tile_t &tile, const u32 min_mip, const u32 new_entry)
+{
+    u32 &entry = entries[get_virtual_tile_index(num_mips, tile)];
+    if (get_virtual_page_table_entry_mip(entry) < min_mip)
+    {
+        return;
+    }
+
+    entry = new_entry;
+    num_written_entries++;
+
+    virtual_page_table_region_t &dirty_region = dirty_regions[tile.mip];
+    dirty_region.min_x = std::min(dirty_region.min_x, tile.x);
+    dirty_region.min_y = std::min(dirty_region.min_y, tile.y);
+    dirty_region.max_x = std::max(dirty_region.max_x, tile.x);
+    dirty_region.max_y = std::max(dirty_region.max_y, tile.y);
+
+    if (tile.mip > 0u)
+    {
+        for (u32 child = 0u; child < 4u; child++)
+        {
+            replace_entries({.mip = tile.mip - 1u, .x = 2u * tile.x + (child & 1u), .y = 2u * tile.y + (child >> 1u)},
+                            min_mip, new_entry);
+        }
+    }
+}
+
+virtual_page_cache_t::virtual_page_cache_t(const u32 num_pages)
+    : page_tiles(num_pages, INVALID_TILE_INDEX), last_used_updates(num_pages), previous_pages(num_pages, INVALID_PAGE),
+      next_pages(num_pages, INVALID_PAGE), locked(num_pages, 0u)
+{
+    // Page 0 is the least recently used.
+    for (u32 page = 0u; page < num_pages; page++)
+    {
+        link_front(page);
+    }
+}
+
+void virtual_page_cache_t::touch(const u32 page, const u64 update_index)
+{
+    if (locked[page])
+    {
+        return;
+    }
+
+    last_used_updates[page] = update_index;
+    if (front_page != page)
+    {
+        unlink(page);
+        link_front(page);
+    }
+}
+
+u32 virtual_page_cache_t::acquire(const u64 update_index, const u64 eviction_delay)
+{
+    // The back of the list is the least recently used page, so if it can not be reused, no page can. Free pages can
+    // always be reused.
+    const u32 page = back_page;
+    if (page == INVALID_PAGE ||
+        (page_tiles[page] != INVALID_TILE_INDEX && last_used_updates[page] + eviction_delay > update_index))
+    {
+        return INVALID_PAGE;
+    }
+
+    unlink(page);
+    locked[page] = 1u;
+
+    return page;
+}
+
+void virtual_page_cache_t::release(const u32 page, const u32 tile_index, const u64 update_index)
+{
+    page_tiles[page] = tile_index;
+    last_used_updates[page] = update_index;
+    locked[page] = 0u;
+
+    if (tile_index == INVALID_TILE_INDEX)
+    {
+        link_back(page);
+    }
+    else
+    {
+        link_front(page);
+    }
+}
+
+void virtual_page_cache_t::unlink(const u32 page)
+{
+    const u32 previous_page = previous_pages[page];
+    const u32 next_page = next_pages[page];
+
+    (previous_page == INVALID_PAGE ? front_page : next_pages[previous_page]) = next_page;
+    (next_page == INVALID_PAGE ? back_page : previous_pages[next_page]) = previous_page;
+
+    previous_pages[page] = INVALID_PAGE;
+    next_pages[page] = INVALID_PAGE;
+}
+
+void virtual_page_cache_t::link_front(const u32 page)
+{
+    previous_pages[page] = INVALID_PAGE;
+    next_pages[page] = front_page;
+
+    (front_page == INVALID_PAGE ? back_page : previous_pages[front_page]) = page;
+    front_page = page;
+}
+
+void virtual_page_cache_t::link_back(const u32 page)
+{
+    previous_pages[page] = back_page;
+    next_pages[page] = INVALID_PAGE;
+
+    (back_page == INVALID_PAGE ? front_page : next_pages[back_page]) = page;
+    back_page = page;
+}
+
+virtual_texture_t::virtual_texture_t(const std::filesystem::path &path, const virtual_texture_settings_t &settings,
+                                     const std::span<u32> page_storage)
+    : settings(settings), file(path), header(read_virtual_texture_archive_header(path)),
+      feedback_processor(header.num_mips), page_cache(settings.num_pages), page_table(header.num_mips, 0u)
+{
+    if (settings.num_pages < 2u || settings.num_pages > 65536u)
+    {
+        throw std::runtime_error(
+            std::format("A virtual texture page cache of {} pages is not supported (2 to 65536 pages)",
+                        settings.num_pages));
+    }
+
+    if (page_storage.empty())
+    {
+        owned_page_storage.resize(get_page_storage_size());
+        this->page_storage = owned_page_storage;
+    }
+    else if (page_storage.size() < get_page_storage_size())
+    {
+        throw std::runtime_error(std::format("Virtual texture page storage has {} texels instead of {}",
+                                             page_storage.size(), get_page_storage_size()));
+    }
+    else
+    {
+        this->page_storage = page_storage;
+    }
+
+    tile_states.resize(header.num_tiles, tile_state_t::evicted);
+
+    // The last mip's tile is the fallback of every other tile, so its page (page 0, the least recently used) stays
+    // locked in the cache.
+    const u32 root_page = page_cache.acquire(0u, 0u);
+    file.read(header.tiles_offset, this->page_storage.data(), get_page(root_page).size_bytes());
+
+    tile_states[0] = tile_state_t::resident;
+    updated_pages.push_back(root_page);
+
+    statistics.num_resident_tiles = 1u;
+}
+
+virtual_texture_t::~virtual_texture_t()
+{
+    std::unique_lock lock(load_mutex);
+    load_condition_variable.wait(lock, [&]() { return num_pending_loads == 0u; });
+}
+
+void virtual_texture_t::update(const std::span<const u32> feedback, job_system_t *const job_system)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    update_index++;
+    updated_pages.clear();
+    page_table.clear_dirty_regions();
+
+    statistics.num_issued_loads = 0u;
+    statistics.num_completed_loads = 0u;
+    statistics.num_evicted_tiles = 0u;
+    statistics.num_loaded_bytes = 0u;
+    statistics.num_missing_tiles = 0u;
+    statistics.num_deferred_loads = 0u;
+
+    complete_loads();
+
+    const std::vector<virtual_tile_request_t> &requests = feedback_processor.process(feedback);
+    statistics.num_requested_tiles = static_cast<u32>(requests.size());
+    statistics.feedback_time_in_ms = feedback_processor.statistics.processing_time_in_ms;
+
+    // The page sampled for a tile is the tile's page, or its closest resident ancestor's.
+    for (const virtual_tile_request_t &request : requests)
+    {
+        page_cache.touch(get_virtual_page_table_entry_page(page_table.get_entry(
+                             get_virtual_tile(header.num_mips, request.tile_index))),
+                         update_index);
+    }
+
+    const u64 eviction_delay = std::max(settings.eviction_delay_in_updates, 1u);
+
+    u32 num_loads_in_flight{};
+    {
+        std::scoped_lock lock(load_mutex);
+        num_loads_in_flight = num_pending_loads;
+    }
+
+    std::vector<tile_load_t> loads{};
+    for (const virtual_tile_request_t &request : requests)
+    {
+        if (tile_states[request.tile_index] != tile_state_t::evicted)
+        {
+            continue;
+        }
+
+        statistics.num_missing_tiles++;
+        if (loads.size() >= settings.max_tile_loads_per_update ||
+            num_loads_in_flight + loads.size() >= settings.max_pending_loads)
+        {
+            statistics.num_deferred_loads++;
+            continue;
+        }
+
+        const u32 page = page_cache.acquire(update_index, eviction_delay);
+        if (page == virtual_page_cache_t::INVALID_PAGE)
+        {
+            statistics.num_deferred_loads++;
+            continue;
+        }
+
+        const u32 evicted_tile_index = page_cache.get_page_tile(page);
+        if (evicted_tile_index != virtual_page_cache_t::INVALID_TILE_INDEX)
+        {
+            page_table.unmap(get_virtual_tile(header.num_mips, evicted_tile_index));
+            tile_states[evicted_tile_index] = tile_state_t::evicted;
+
+            statistics.num_evicted_tiles++;
+            statistics.num_resident_tiles--;
+        }
+
+        tile_states[request.tile_index] = tile_state_t::loading;
+        loads.push_back({.tile_index = request.tile_index, .page = page});
+    }
+
+    {
+        std::scoped_lock lock(load_mutex);
+        num_pending_loads += static_cast<u32>(loads.size());
+    }
+
+    for (const tile_load_t &load : loads)
+    {
+        if (job_system)
+        {
+            job_system->submit([this, load]() { load_tile(load); });
+        }
+        else
+        {
+            load_tile(load);
+        }
+    }
+
+    statistics.num_issued_loads = static_cast<u32>(loads.size());
+
+    // Without a job system, the loads are already done.
+    if (!job_system)
+    {
+        complete_loads();
+    }
+
+    {
+        std::scoped_lock lock(load_mutex);
+        statistics.num_pending_loads = num_pending_loads;
+    }
+
+    statistics.update_time_in_ms =
+        std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+void virtual_texture_t::load_tile(const tile_load_t &load)
+{
+    const u64 page_size_in_bytes = static_cast<u64>(get_page_size()) * get_page_size() * sizeof(u32);
+
+    std::string error{};
+    try
+    {
+        file.read(header.tiles_offset + load.tile_index * page_size_in_bytes,
+                  page_storage.data() + static_cast<size_t>(load.page) * get_page_size() * get_page_size(),
+                  page_size_in_bytes);
+    }
+    catch (const std::exception &exception)
+    {
+        error = exception.what();
+    }
+
+    {
+        std::scoped_lock lock(load_mutex);
+        if (!error.empty() && load_error.empty())
+        {
+            load_error = std::move(error);
+        }
+
+        completed_loads.push_back(load);
+        num_pending_loads--;
+    }
+
+    load_condition_variable.notify_all();
+}
+
+void virtual_texture_t::complete_loads()
+{
+    std::vector<tile_load_t> loads{};
+    {
+        std::scoped_lock lock(load_mutex);
+        if (!load_error.empty())
+        {
+            throw std::runtime_error(std::format("Failed to load a virtual texture tile : {}", load_error));
+        }
+
+        loads.swap(completed_loads);
+    }
+
+    const u64 page_size_in_bytes = static_cast<u64>(get_page_size()) * get_page_size() * sizeof(u32);
+    for (const tile_load_t &load : loads)
+    {
+        page_table.map(get_virtual_tile(header.num_mips, load.tile_index), load.page);
+        page_cache.release(load.page, load.tile_index, update_index);
+
+        tile_states[load.tile_index] = tile_state_t::resident;
+        updated_pages.push_back(load.page);
+
+        statistics.num_completed_loads++;
+        statistics.num_resident_tiles++;
+        statistics.num_loaded_bytes += page_size_in_bytes;
+    }
+}
+} // namespace nether
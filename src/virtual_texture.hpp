@@ -0,0 +1,405 @@
+#pragma once
+
+#include "common.hpp"
+#include "file_reader.hpp"
+#include "job_system.hpp"
+
+#include <condition_variable>
+#include <mutex>
+
+// Virtual texturing : a large texture split into square tiles, of which only the tiles the view needs are resident.
+//  - The texture and its mips are split offline into a virtual texture archive (see write_virtual_texture_archive).
+//    Every tile has a border of texels from its neighbours, so that filtering a page never reads another page.
+//  - Resident tiles are held by the pages of a fixed size physical page cache (usually a texture atlas), recycled in
+//    least recently used order. The tile of the last mip covers the whole texture, and always stays resident.
+//  - The page table has one entry per tile (a mip chain of entries, with one entry per tile of each mip), pointing to
+//    the page of the tile if it is resident, and otherwise to the page of its closest resident ancestor. It is updated
+//    incrementally when tiles are loaded or evicted.
+//  - Every frame, the GPU writes the tiles it wanted to sample to a (low resolution) feedback buffer. The feedback is
+//    deduplicated into tile requests, and missing tiles are loaded coarsest mip first, then by screen coverage (the
+//    number of feedback samples that requested them), asynchronously if a job system is given.
+namespace nether
+{
+static constexpr u32 VIRTUAL_TEXTURE_ARCHIVE_MAGIC = 0x5456484e; // "NHVT"
+static constexpr u32 VIRTUAL_TEXTURE_ARCHIVE_VERSION = 1u;
+
+// Layout (all offsets are from the start of the file) :
+//  - virtual_texture_archive_header_t.
+//  - The tiles, last mip first, then mip by mip. The tiles of a mip are in row major order. A tile is (tile_size + 2 *
+//    tile_border)^2 RGBA8 texels, in row major order.
+struct virtual_texture_archive_header_t
+{
+    u32 magic{};
+    u32 version{};
+
+    // Texels along a tile's side, not counting the borders.
+    u32 tile_size{};
+    u32 tile_border{};
+
+    // The texture has tile_size * 2^(num_mips - 1) texels along each side, and the last mip is a single tile.
+    u32 num_mips{};
+    u32 num_tiles{};
+
+    u64 tiles_offset{};
+    u64 file_size{};
+};
+
+struct virtual_texture_archive_desc_t
+{
+    u32 tile_size{128u};
+    u32 tile_border{4u};
+};
+
+// Throws if the texture's size is not tile_size * 2^n, or if texels does not have size * size texels. The mips are
+// generated with a box filter, in parallel if job_system is not null.
+void write_virtual_texture_archive(const std::filesystem::path &path, const std::span<const u32> texels,
+                                   const u32 size, const virtual_texture_archive_desc_t &desc,
+                                   job_system_t *const job_system = nullptr);
+
+// Throws if the file is not a virtual texture archive (or a truncated one).
+virtual_texture_archive_header_t read_virtual_texture_archive_header(const std::filesystem::path &path);
+
+struct virtual_tile_t
+{
+    u32 mip{};
+    u32 x{};
+    u32 y{};
+};
+
+// Tiles are indexed last mip first, like the tiles of the archive.
+inline u32 get_virtual_tile_index(const u32 num_mips, const virtual_tile_t &tile)
+{
+    // (4^depth - 1) / 3 tiles come before the first tile of depth, and a mip has 2^depth tiles along each side.
+    const u32 depth = num_mips - 1u - tile.mip;
+    return ((1u << (2u * depth)) - 1u) / 3u + tile.y * (1u << depth) + tile.x;
+}
+
+inline u32 get_num_virtual_tiles(const u32 num_mips)
+{
+    return ((1u << (2u * num_mips)) - 1u) / 3u;
+}
+
+virtual_tile_t get_virtual_tile(const u32 num_mips, const u32 tile_index);
+
+// Feedback buffer entries, as written by the shaders : mip in the top 8 bits, then y and x in 12 bits each. Entries
+// that no pixel wrote are INVALID_VIRTUAL_TILE_ID.
+static constexpr u32 INVALID_VIRTUAL_TILE_ID = ~0u;
+
+inline u32 pack_virtual_tile_id(const virtual_tile_t &tile)
+{
+    return (tile.mip << 24u) | (tile.y << 12u) | tile.x;
+}
+
+inline virtual_tile_t unpack_virtual_tile_id(const u32 tile_id)
+{
+    return virtual_tile_t{.mip = tile_id >> 24u, .x = tile_id & 0xfffu, .y = (tile_id >> 12u) & 0xfffu};
+}
+
+struct virtual_tile_request_t
+{
+    u32 tile_index{};
+    u32 mip{};
+
+    // Feedback samples that requested the tile.
+    u32 num_samples{};
+};
+
+struct virtual_texture_feedback_statistics_t
+{
+    // Samples of a tile of the texture, and samples that are not (INVALID_VIRTUAL_TILE_ID entries are not samples).
+    u32 num_samples{};
+    u32 num_invalid_samples{};
+    u32 num_requested_tiles{};
+
+    f32 processing_time_in_ms{};
+};
+
+// Deduplicates feedback buffers into tile requests, with a sample counter per tile, so that the cost is linear in the
+// number of feedback samples.
+class virtual_texture_feedback_processor_t
+{
+  public:
+    explicit virtual_texture_feedback_processor_t(const u32 num_mips);
+
+    // The requests are sorted by priority : coarsest mip first (as a tile is the fallback of all of its descendants),
+    // then most samples first. Samples that are not a tile of the texture are skipped.
+    const std::vector<virtual_tile_request_t> &process(const std::span<const u32> feedback);
+
+  public:
+    std::vector<virtual_tile_request_t> requests{};
+
+    virtual_texture_feedback_statistics_t statistics{};
+
+  private:
+    u32 num_mips{};
+
+    // Samples per tile of the feedback being processed. Only the requested tiles' counters are non zero, and they are
+    // reset once the requests are gathered.
+    std::vector<u32> sample_counts{};
+};
+
+// A page table entry : the physical page in the low 16 bits, and the mip of the tile it holds in the next 8 bits.
+inline u32 pack_virtual_page_table_entry(const u32 page, const u32 mip)
+{
+    return page | (mip << 16u);
+}
+
+inline u32 get_virtual_page_table_entry_page(const u32 entry)
+{
+    return entry & 0xffffu;
+}
+
+inline u32 get_virtual_page_table_entry_mip(const u32 entry)
+{
+    return entry >> 16u;
+}
+
+// Entries changed since the last clear_dirty_regions, as a rectangle per mip (empty if max_x < min_x), so that only
+// those are uploaded to the GPU.
+struct virtual_page_table_region_t
+{
+    u32 min_x{~0u};
+    u32 min_y{~0u};
+    u32 max_x{};
+    u32 max_y{};
+
+    bool is_empty() const
+    {
+        return max_x < min_x;
+    }
+};
+
+class virtual_page_table_t
+{
+  public:
+    // Every entry points to root_page, the page of the last mip's tile.
+    virtual_page_table_t(const u32 num_mips, const u32 root_page);
+
+    // Points the tile, and its descendants that were pointing to a coarser tile, to page.
+    void map(const virtual_tile_t &tile, const u32 page);
+
+    // Points the tile, and its descendants that were pointing to it, to the tile's closest resident ancestor. Throws
+    // for the last mip's tile.
+    void unmap(const virtual_tile_t &tile);
+
+    u32 get_entry(const virtual_tile_t &tile) const
+    {
+        return entries[get_virtual_tile_index(num_mips, tile)];
+    }
+
+    // The entries of a mip, in row major order.
+    std::span<const u32> get_mip_entries(const u32 mip) const
+    {
+        const u32 first_entry = get_virtual_tile_index(num_mips, {.mip = mip});
+        const u32 num_tiles_per_side = 1u << (num_mips - 1u - mip);
+        return std::span(entries).subspan(first_entry, num_tiles_per_side * num_tiles_per_side);
+    }
+
+    const std::vector<virtual_page_table_region_t> &get_dirty_regions() const
+    {
+        return dirty_regions;
+    }
+
+    void clear_dirty_regions();
+
+  public:
+    // Entries written since the page table was created.
+    u64 num_written_entries{};
+
+  private:
+    // Replaces the entries of the tile's subtree that point to min_mip (the mapped or unmapped tile's mip) or to a
+    // coarser mip with new_entry. The subtrees of entries pointing to a finer mip are skipped, as all of their
+    // descendants do too.
+    void replace_entries(const virtual_tile_t &tile, const u32 min_mip, const u32 new_entry);
+
+  private:
+    u32 num_mips{};
+
+    std::vector<u32> entries{};
+    std::vector<virtual_page_table_region_t> dirty_regions{};
+};
+
+// Least recently used order of the physical pages, as an intrusive doubly linked list. Pages are either in the list
+// (free or holding a tile that can be evicted) or locked out of it (a tile being loaded, or a pinned tile).
+class virtual_page_cache_t
+{
+  public:
+    static constexpr u32 INVALID_PAGE = ~0u;
+    static constexpr u32 INVALID_TILE_INDEX = ~0u;
+
+    // Every page starts free and unlocked, page 0 being the least recently used.
+    explicit virtual_page_cache_t(const u32 num_pages);
+
+    // Moves the page to the most recently used end of the list (if it is unlocked).
+    void touch(const u32 page, const u64 update_index);
+
+    // Locks and returns the least recently used page, if it was not used in the last eviction_delay updates (as the
+    // GPU may still be reading it). The tile it held (get_page_tile) must be evicted by the caller. Returns
+    // INVALID_PAGE if no page can be reused.
+    u32 acquire(const u64 update_index, const u64 eviction_delay);
+
+    // Puts an acquired page back, holding tile_index : as the most recently used page, or as the least recently used
+    // one if the page is free (INVALID_TILE_INDEX), so that it is reused first.
+    void release(const u32 page, const u32 tile_index, const u64 update_index);
+
+    u32 get_page_tile(const u32 page) const
+    {
+        return page_tiles[page];
+    }
+
+    u32 get_num_pages() const
+    {
+        return static_cast<u32>(page_tiles.size());
+    }
+
+  private:
+    void unlink(const u32 page);
+    void link_front(const u32 page);
+    void link_back(const u32 page);
+
+  private:
+    std::vector<u32> page_tiles{};
+    std::vector<u64> last_used_updates{};
+
+    std::vector<u32> previous_pages{};
+    std::vector<u32> next_pages{};
+    std::vector<u8> locked{};
+
+    // Most and least recently used ends of the list.
+    u32 front_page{INVALID_PAGE};
+    u32 back_page{INVALID_PAGE};
+};
+
+struct virtual_texture_settings_t
+{
+    u32 num_pages{1024u};
+
+    u32 max_tile_loads_per_update{32u};
+    u32 max_pending_loads{64u};
+
+    // A page used by the feedback is not reused for this many updates, as the GPU may still be reading it (usually
+    // the number of frames in flight).
+    u32 eviction_delay_in_updates{3u};
+};
+
+struct virtual_texture_statistics_t
+{
+    u32 num_resident_tiles{};
+    u32 num_pending_loads{};
+
+    // During the last update.
+    u32 num_requested_tiles{};
+    u32 num_missing_tiles{};
+    u32 num_issued_loads{};
+    u32 num_completed_loads{};
+    u32 num_evicted_tiles{};
+    u64 num_loaded_bytes{};
+
+    // Requests that could not be loaded because every page was used too recently.
+    u32 num_deferred_loads{};
+
+    f32 feedback_time_in_ms{};
+    f32 update_time_in_ms{};
+};
+
+class virtual_texture_t
+{
+  public:
+    // Reads the archive's header, and loads the last mip's tile (which always stays resident) into page 0.
+    // page_storage is where the tiles are loaded, get_page_storage_size() texels (usually mapped upload memory, that
+    // is copied to the physical texture when a load completes). If it is empty, the virtual texture allocates it.
+    // Throws if the archive is invalid, or if there are less than 2 pages or more than 65536.
+    virtual_texture_t(const std::filesystem::path &path, const virtual_texture_settings_t &settings,
+                      const std::span<u32> page_storage = {});
+
+    // Waits for the pending loads.
+    ~virtual_texture_t();
+
+    virtual_texture_t(const virtual_texture_t &) = delete;
+    virtual_texture_t &operator=(const virtual_texture_t &) = delete;
+
+    // Maps the tiles whose loads completed since the last update, processes the feedback of a frame, and issues the
+    // loads of the missing tiles (at most max_tile_loads_per_update, and max_pending_loads at once). If job_system is
+    // not null, the loads run on it and complete during a later update. Otherwise, they complete before update
+    // returns. Throws if a load failed.
+    void update(const std::span<const u32> feedback, job_system_t *const job_system = nullptr);
+
+    u32 get_page_size() const
+    {
+        return header.tile_size + 2u * header.tile_border;
+    }
+
+    u32 get_page_storage_size() const
+    {
+        return settings.num_pages * get_page_size() * get_page_size();
+    }
+
+    // The texels of a page, in row major order.
+    std::span<const u32> get_page(const u32 page) const
+    {
+        const size_t page_stride = static_cast<size_t>(get_page_size()) * get_page_size();
+        return page_storage.subspan(page * page_stride, page_stride);
+    }
+
+    const virtual_texture_archive_header_t &get_header() const
+    {
+        return header;
+    }
+
+    bool is_resident(const virtual_tile_t &tile) const
+    {
+        return tile_states[get_virtual_tile_index(header.num_mips, tile)] == tile_state_t::resident;
+    }
+
+    const virtual_page_table_t &get_page_table() const
+    {
+        return page_table;
+    }
+
+  public:
+    // Pages whose load completed during the last update, that must be copied to the physical texture.
+    std::vector<u32> updated_pages{};
+
+    virtual_texture_statistics_t statistics{};
+
+  private:
+    enum class tile_state_t : u8
+    {
+        evicted,
+        loading,
+        resident,
+    };
+
+    struct tile_load_t
+    {
+        u32 tile_index{};
+        u32 page{};
+    };
+
+    void load_tile(const tile_load_t &load);
+    void complete_loads();
+
+  private:
+    virtual_texture_settings_t settings{};
+    file_reader_t file;
+
+    virtual_texture_archive_header_t header{};
+
+    virtual_texture_feedback_processor_t feedback_processor;
+    virtual_page_cache_t page_cache;
+    virtual_page_table_t page_table;
+
+    std::vector<u32> owned_page_storage{};
+    std::span<u32> page_storage{};
+
+    std::vector<tile_state_t> tile_states{};
+    u64 update_index{};
+
+    // Loads are issued by update, and completed by the job system's workers.
+    std::mutex load_mutex{};
+    std::condition_variable load_condition_variable{};
+    std::vector<tile_load_t> completed_loads{};
+    u32 num_pending_loads{};
+    std::string load_error{};
+};
+} // namespace nether
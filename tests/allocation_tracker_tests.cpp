@@ -0,0 +1,258 @@
+#include "test_framework.hpp"
+
+#include "allocation_tracker.hpp"
+
+#include <thread>
+
+// The tests are linked with allocation_hooks.cpp, so operator new is tracked. No other test sets a memory tag, so the
+// counters of the tags used here only change with the allocations of the tests.
+namespace
+{
+using namespace nether;
+using namespace nether::memory;
+
+const cpu_memory_counters_t &get_cpu_counters(const memory_snapshot_t &snapshot, const memory_tag_t tag)
+{
+    return snapshot.cpu[static_cast<u32>(tag)];
+}
+} // namespace
+
+NETHER_TEST(allocation_tracker_counts_allocations_per_tag)
+{
+    const memory_snapshot_t initial_snapshot = take_memory_snapshot();
+
+    std::array<void *, 3> allocations{};
+    {
+        const memory_tag_scope_t tag_scope(memory_tag_t::assets);
+        NETHER_CHECK(get_current_memory_tag() == memory_tag_t::assets);
+
+        {
+            const memory_tag_scope_t nested_tag_scope(memory_tag_t::shaders);
+            NETHER_CHECK(get_current_memory_tag() == memory_tag_t::shaders);
+        }
+
+        for (void *&allocation : allocations)
+        {
+            allocation = tracked_allocate(100u);
+        }
+    }
+
+    NETHER_CHECK(get_current_memory_tag() == memory_tag_t::untagged);
+
+    const memory_snapshot_t snapshot = take_memory_snapshot();
+    const cpu_memory_counters_t &initial_counters = get_cpu_counters(initial_snapshot, memory_tag_t::assets);
+    const cpu_memory_counters_t &counters = get_cpu_counters(snapshot, memory_tag_t::assets);
+    NETHER_CHECK(counters.live_bytes == initial_counters.live_bytes + 300u);
+    NETHER_CHECK(counters.live_allocations == initial_counters.live_allocations + 3u);
+    NETHER_CHECK(counters.num_allocations == initial_counters.num_allocations + 3u);
+    NETHER_CHECK(counters.allocated_bytes == initial_counters.allocated_bytes + 300u);
+
+    // Frees are attributed to the tag of the allocation, whatever the current tag.
+    for (void *const allocation : allocations)
+    {
+        const memory_tag_scope_t tag_scope(memory_tag_t::render);
+        tracked_free(allocation);
+    }
+
+    const memory_snapshot_t final_snapshot = take_memory_snapshot();
+    NETHER_CHECK(get_cpu_counters(final_snapshot, memory_tag_t::assets).live_bytes == initial_counters.live_bytes);
+    NETHER_CHECK(get_cpu_counters(final_snapshot, memory_tag_t::assets).num_allocations ==
+                 initial_counters.num_allocations + 3u);
+
+    tracked_free(nullptr);
+}
+
+NETHER_TEST(allocation_tracker_tracks_operator_new)
+{
+    struct alignas(256) aligned_block_t
+    {
+        std::array<u8, 512> data{};
+    };
+
+    const memory_snapshot_t initial_snapshot = take_memory_snapshot();
+    {
+        const memory_tag_scope_t tag_scope(memory_tag_t::ui);
+
+        const std::unique_ptr<std::array<u8, 1000>> block = std::make_unique<std::array<u8, 1000>>();
+        const std::unique_ptr<aligned_block_t> aligned_block = std::make_unique<aligned_block_t>();
+        NETHER_CHECK(reinterpret_cast<uintptr_t>(aligned_block.get()) % 256u == 0u);
+
+        const memory_snapshot_t snapshot = take_memory_snapshot();
+        NETHER_CHECK(get_cpu_counters(snapshot, memory_tag_t::ui).live_bytes ==
+                     get_cpu_counters(initial_snapshot, memory_tag_t::ui).live_bytes + 1000u + 512u);
+    }
+
+    NETHER_CHECK(get_cpu_counters(take_memory_snapshot(), memory_tag_t::ui).live_bytes ==
+                 get_cpu_counters(initial_snapshot, memory_tag_t::ui).live_bytes);
+
+    // Every alignment up to a page.
+    for (size_t alignment = 1u; alignment <= 4096u; alignment *= 2u)
+    {
+        u8 *const allocation = static_cast<u8 *>(tracked_allocate(alignment * 3u, alignment));
+        NETHER_CHECK(reinterpret_cast<uintptr_t>(allocation) % alignment == 0u);
+        std::memset(allocation, 0xab, alignment * 3u);
+        tracked_free(allocation);
+    }
+}
+
+NETHER_TEST(allocation_tracker_counts_allocations_across_threads)
+{
+    constexpr u32 NUM_THREADS = 4u;
+    constexpr u32 NUM_ALLOCATIONS_PER_THREAD = 1000u;
+
+    const memory_snapshot_t initial_snapshot = take_memory_snapshot();
+
+    // Allocated by the threads, and freed by this thread after they exited (so their blocks have been released, and
+    // the counts must survive). Reserved up front, so that the only allocations of the threads are the tracked ones.
+    std::vector<std::vector<void *>> allocations(NUM_THREADS);
+    for (std::vector<void *> &thread_allocations : allocations)
+    {
+        thread_allocations.reserve(2u * NUM_ALLOCATIONS_PER_THREAD);
+    }
+
+    for (u32 round = 0u; round < 2u; round++)
+    {
+        std::vector<std::thread> threads{};
+        for (u32 thread_index = 0u; thread_index < NUM_THREADS; thread_index++)
+        {
+            threads.emplace_back([&, thread_index]() {
+                const memory_tag_scope_t tag_scope(memory_tag_t::shaders);
+                for (u32 i = 0u; i < NUM_ALLOCATIONS_PER_THREAD; i++)
+                {
+                    allocations[thread_index].push_back(tracked_allocate(16u));
+                }
+            });
+        }
+
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    const memory_snapshot_t snapshot = take_memory_snapshot();
+    const cpu_memory_counters_t &initial_counters = get_cpu_counters(initial_snapshot, memory_tag_t::shaders);
+    NETHER_CHECK(get_cpu_counters(snapshot, memory_tag_t::shaders).live_bytes ==
+                 initial_counters.live_bytes + 2u * NUM_THREADS * NUM_ALLOCATIONS_PER_THREAD * 16u);
+    NETHER_CHECK(get_cpu_counters(snapshot, memory_tag_t::shaders).num_allocations ==
+                 initial_counters.num_allocations + 2u * NUM_THREADS * NUM_ALLOCATIONS_PER_THREAD);
+
+    for (const std::vector<void *> &thread_allocations : allocations)
+    {
+        for (void *const allocation : thread_allocations)
+        {
+            tracked_free(allocation);
+        }
+    }
+
+    NETHER_CHECK(get_cpu_counters(take_memory_snapshot(), memory_tag_t::shaders).live_bytes ==
+                 initial_counters.live_bytes);
+}
+
+NETHER_TEST(allocation_tracker_gpu_allocations_and_callstack_samples)
+{
+    const memory_snapshot_t initial_snapshot = take_memory_snapshot();
+    const gpu_memory_counters_t initial_counters =
+        initial_snapshot.gpu[static_cast<u32>(memory_tag_t::render)][static_cast<u32>(gpu_heap_type_t::upload)];
+
+    gpu_allocation_t gpu_allocation{};
+    {
+        const memory_tag_scope_t tag_scope(memory_tag_t::render);
+        gpu_allocation = register_gpu_allocation(gpu_heap_type_t::upload, 1u << 20u);
+    }
+
+    NETHER_CHECK(gpu_allocation.tag == memory_tag_t::render);
+
+    const gpu_memory_counters_t counters =
+        take_memory_snapshot().gpu[static_cast<u32>(memory_tag_t::render)][static_cast<u32>(gpu_heap_type_t::upload)];
+    NETHER_CHECK(counters.live_bytes == initial_counters.live_bytes + (1u << 20u));
+    NETHER_CHECK(counters.num_resources == initial_counters.num_resources + 1u);
+
+    unregister_gpu_allocation(gpu_allocation);
+    NETHER_CHECK(take_memory_snapshot()
+                     .gpu[static_cast<u32>(memory_tag_t::render)][static_cast<u32>(gpu_heap_type_t::upload)]
+                     .live_bytes == initial_counters.live_bytes);
+
+    // Every 4th allocation of this thread is sampled, all at the same callstack.
+    reset_callstack_samples();
+    set_callstack_sampling_interval(4u);
+    {
+        const memory_tag_scope_t tag_scope(memory_tag_t::assets);
+        for (u32 i = 0u; i < 400u; i++)
+        {
+            tracked_free(tracked_allocate(64u));
+        }
+    }
+    set_callstack_sampling_interval(0u);
+
+    const std::vector<callstack_sample_t> samples = get_callstack_samples();
+    NETHER_CHECK(!samples.empty());
+
+    u64 num_asset_samples = 0u;
+    for (const callstack_sample_t &sample : samples)
+    {
+        if (sample.tag == memory_tag_t::assets)
+        {
+            num_asset_samples += sample.num_samples;
+            NETHER_CHECK(sample.sampled_bytes == sample.num_samples * 64u);
+        }
+    }
+    NETHER_CHECK(num_asset_samples == 100u);
+    NETHER_CHECK(get_num_dropped_callstack_samples() == 0u);
+
+    reset_callstack_samples();
+    NETHER_CHECK(get_callstack_samples().empty());
+}
+
+NETHER_TEST(memory_telemetry_frame_churn_and_export)
+{
+    const std::filesystem::path export_directory = std::filesystem::temp_directory_path() / "nether-tests" / "memory";
+    std::filesystem::remove_all(export_directory);
+
+    job_system_t job_system(2u);
+    {
+        memory_telemetry_t memory_telemetry(
+            {
+                .history_size = 8u,
+                .export_interval_in_frames = 4u,
+                .export_directory = export_directory,
+            },
+            &job_system);
+
+        // Frame i makes i allocations of 32 bytes under the render tag.
+        for (u32 frame = 0u; frame < 20u; frame++)
+        {
+            {
+                const memory_tag_scope_t tag_scope(memory_tag_t::render);
+                for (u32 i = 0u; i < frame; i++)
+                {
+                    tracked_free(tracked_allocate(32u));
+                }
+            }
+
+            memory_telemetry.end_frame();
+
+            const memory_churn_t &churn =
+                memory_telemetry.statistics.frame_churn[static_cast<u32>(memory_tag_t::render)];
+            NETHER_CHECK(churn.num_allocations == frame);
+            NETHER_CHECK(churn.allocated_bytes == frame * 32u);
+        }
+
+        NETHER_CHECK(memory_telemetry.get_num_frames() == 20u);
+        NETHER_CHECK(memory_telemetry.get_last_snapshot().frame_index == 20u);
+    }
+
+    // The export is flushed when the telemetry is destroyed, with the last 8 frames.
+    std::ifstream json_file(export_directory / "memory_telemetry.json");
+    const std::string json((std::istreambuf_iterator<char>(json_file)), std::istreambuf_iterator<char>());
+
+    NETHER_CHECK(json.find("\"frame\": 12,") == std::string::npos);
+    NETHER_CHECK(json.find("\"frame\": 13,") != std::string::npos);
+    NETHER_CHECK(json.find("\"frame\": 20,") != std::string::npos);
+    NETHER_CHECK(json.find("\"render\": {\"live_bytes\": ") != std::string::npos);
+    NETHER_CHECK(json.find("\"allocations\": 19, \"allocated_bytes\": 608}") != std::string::npos);
+    NETHER_CHECK(json.find("\"callstacks\": [") != std::string::npos);
+    NETHER_CHECK(!std::filesystem::exists(export_directory / "memory_telemetry.json.tmp"));
+
+    NETHER_CHECK_THROWS(memory_telemetry_t({.history_size = 0u}));
+}
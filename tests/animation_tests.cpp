@@ -0,0 +1,454 @@
+#include "test_framework.hpp"
+
+#include "animation.hpp"
+
+#include <numbers>
+#include <random>
+
+// The SIMD paths are compared against scalar versions : sample_animation_clip_joint for sampling, and get_joint_matrix
+// with plain matrix products for the hierarchy.
+namespace
+{
+using namespace nether;
+
+float4_t axis_angle_rotation(const float3_t &axis, const f32 angle)
+{
+    const float3_t normalized_axis = normalize(axis);
+    const f32 sin_half_angle = std::sin(0.5f * angle);
+
+    return float4_t{normalized_axis.x * sin_half_angle, normalized_axis.y * sin_half_angle,
+                    normalized_axis.z * sin_half_angle, std::cos(0.5f * angle)};
+}
+
+// Same as get_rotation_angle in animation.cpp.
+f64 get_rotation_angle(const float4_t &a, const float4_t &b)
+{
+    const f64 sign = f64{a.x} * b.x + f64{a.y} * b.y + f64{a.z} * b.z + f64{a.w} * b.w < 0.0 ? -1.0 : 1.0;
+    const f64 a_components[4] = {a.x, a.y, a.z, a.w};
+    const f64 b_components[4] = {b.x * sign, b.y * sign, b.z * sign, b.w * sign};
+
+    f64 difference_length_squared = 0.0;
+    f64 sum_length_squared = 0.0;
+    for (u32 i = 0u; i < 4u; i++)
+    {
+        difference_length_squared += (a_components[i] - b_components[i]) * (a_components[i] - b_components[i]);
+        sum_length_squared += (a_components[i] + b_components[i]) * (a_components[i] + b_components[i]);
+    }
+
+    return 4.0 * std::atan2(std::sqrt(difference_length_squared), std::sqrt(sum_length_squared));
+}
+
+// A chain of joints along y.
+skeleton_t create_chain_skeleton(const u32 num_joints)
+{
+    std::vector<u32> parent_indices(num_joints);
+    std::vector<joint_transform_t> bind_pose(num_joints);
+    for (u32 i = 0u; i < num_joints; i++)
+    {
+        parent_indices[i] = i == 0u ? skeleton_t::INVALID_JOINT_INDEX : i - 1u;
+        bind_pose[i].translation = {0.0f, i == 0u ? 0.0f : 0.5f, 0.0f};
+        bind_pose[i].rotation = axis_angle_rotation({0.0f, 0.0f, 1.0f}, 0.05f * static_cast<f32>(i));
+    }
+
+    return create_skeleton(parent_indices, bind_pose);
+}
+
+// Every joint sways around a different axis, with a different phase. The root also moves.
+raw_animation_clip_t create_sway_clip(const u32 num_joints, const u32 num_frames)
+{
+    raw_animation_clip_t clip = {
+        .sample_rate = 30.0f,
+        .num_frames = num_frames,
+        .num_joints = num_joints,
+        .samples = std::vector<joint_transform_t>(static_cast<size_t>(num_frames) * num_joints),
+    };
+
+    for (u32 frame = 0u; frame < num_frames; frame++)
+    {
+        const f32 time = static_cast<f32>(frame) / clip.sample_rate;
+        for (u32 joint = 0u; joint < num_joints; joint++)
+        {
+            const f32 phase = 2.0f * std::numbers::pi_v<f32> * time + 0.4f * static_cast<f32>(joint);
+            const float3_t axis = {std::cos(0.7f * static_cast<f32>(joint)), 0.3f,
+                                   std::sin(0.7f * static_cast<f32>(joint))};
+
+            clip.samples[frame * num_joints + joint] = joint_transform_t{
+                .rotation = axis_angle_rotation(axis, 0.6f * std::sin(phase)),
+                .translation = {joint == 0u ? 0.2f * std::sin(phase) : 0.0f, joint == 0u ? 0.0f : 0.5f, 0.0f},
+            };
+        }
+    }
+
+    return clip;
+}
+
+void check_matrices_near(const float4x4_t &a, const float4x4_t &b, const f32 tolerance)
+{
+    for (u32 row = 0u; row < 4u; row++)
+    {
+        for (u32 column = 0u; column < 4u; column++)
+        {
+            NETHER_CHECK_NEAR(a.m[row][column], b.m[row][column], tolerance);
+        }
+    }
+}
+
+std::vector<animated_character_t> create_characters(const std::span<const animation_clip_t> clips,
+                                                    const u32 num_characters)
+{
+    std::vector<animated_character_t> characters(num_characters);
+    for (u32 i = 0u; i < num_characters; i++)
+    {
+        animated_character_t &character = characters[i];
+        character.num_layers = static_cast<u32>(clips.size());
+        for (u32 layer = 0u; layer < character.num_layers; layer++)
+        {
+            character.layers[layer].clip = &clips[layer];
+            character.layers[layer].time_in_s = 0.013f * static_cast<f32>(i * (layer + 1u));
+            character.layers[layer].weight = 0.25f + 0.5f * static_cast<f32>(layer);
+        }
+        character.world_matrix = translation_matrix({static_cast<f32>(i), 0.0f, 2.0f});
+    }
+
+    return characters;
+}
+} // namespace
+
+NETHER_TEST(animation_quantization_round_trip)
+{
+    std::mt19937 random_engine(40u);
+    std::uniform_real_distribution<f32> distribution(-1.0f, 1.0f);
+
+    constexpr u32 NUM_JOINTS = 64u;
+
+    // Two identical frames, so that both are kept and sampling returns the dequantized keys.
+    raw_animation_clip_t raw_clip = {.num_frames = 2u, .num_joints = NUM_JOINTS};
+    raw_clip.samples.resize(2u * NUM_JOINTS);
+    for (u32 i = 0u; i < NUM_JOINTS; i++)
+    {
+        joint_transform_t &sample = raw_clip.samples[i];
+        sample.rotation = axis_angle_rotation(
+            {distribution(random_engine), distribution(random_engine), distribution(random_engine)},
+            distribution(random_engine) * std::numbers::pi_v<f32>);
+        sample.translation = {distribution(random_engine), distribution(random_engine) * 10.0f, 0.5f};
+
+        raw_clip.samples[NUM_JOINTS + i] = sample;
+    }
+
+    const animation_clip_t clip = compress_animation_clip(raw_clip);
+    NETHER_CHECK(clip.get_num_rotation_keys() == 2u * NUM_JOINTS);
+
+    for (u32 i = 0u; i < NUM_JOINTS; i++)
+    {
+        const joint_transform_t &expected = raw_clip.samples[i];
+        const joint_transform_t sample = sample_animation_clip_joint(clip, 0.0f, i);
+
+        NETHER_CHECK(get_rotation_angle(sample.rotation, expected.rotation) < 3e-4);
+
+        // Both frames are the same, so the range is empty and the translation is exact.
+        NETHER_CHECK_NEAR(sample.translation.x, expected.translation.x, 1e-6f);
+        NETHER_CHECK_NEAR(sample.translation.y, expected.translation.y, 1e-6f);
+        NETHER_CHECK_NEAR(sample.translation.z, expected.translation.z, 1e-6f);
+    }
+
+    // q and -q are the same rotation.
+    for (u32 i = 0u; i < 2u * NUM_JOINTS; i++)
+    {
+        float4_t &rotation = raw_clip.samples[i].rotation;
+        rotation = float4_t{-rotation.x, -rotation.y, -rotation.z, -rotation.w};
+    }
+
+    const animation_clip_t negated_clip = compress_animation_clip(raw_clip);
+    for (u32 i = 0u; i < negated_clip.get_num_rotation_keys(); i++)
+    {
+        for (u32 component = 0u; component < 3u; component++)
+        {
+            NETHER_CHECK(negated_clip.rotation_keys[i].values[component] ==
+                         clip.rotation_keys[i].values[component]);
+        }
+    }
+}
+
+NETHER_TEST(animation_compression_error_is_bounded)
+{
+    constexpr u32 NUM_JOINTS = 20u;
+    constexpr u32 NUM_FRAMES = 121u;
+
+    const raw_animation_clip_t raw_clip = create_sway_clip(NUM_JOINTS, NUM_FRAMES);
+
+    for (const f32 max_rotation_error : {0.0005f, 0.002f, 0.01f})
+    {
+        const animation_compression_settings_t settings = {
+            .max_rotation_error_in_radians = max_rotation_error,
+            .max_translation_error = 0.001f,
+        };
+        const animation_clip_t clip = compress_animation_clip(raw_clip, settings);
+
+        NETHER_CHECK(clip.get_num_rotation_keys() < NUM_FRAMES * NUM_JOINTS);
+        NETHER_CHECK(clip.get_num_translation_keys() < NUM_FRAMES * NUM_JOINTS);
+        NETHER_CHECK(clip.get_size_in_bytes() < raw_clip.samples.size() * sizeof(joint_transform_t));
+
+        // Every track keeps its first and last frame.
+        for (u32 joint = 0u; joint < NUM_JOINTS; joint++)
+        {
+            NETHER_CHECK(clip.rotation_key_frames[clip.rotation_track_offsets[joint]] == 0u);
+            NETHER_CHECK(clip.rotation_key_frames[clip.rotation_track_offsets[joint + 1u] - 1u] == NUM_FRAMES - 1u);
+        }
+
+        for (u32 frame = 0u; frame < NUM_FRAMES; frame++)
+        {
+            for (u32 joint = 0u; joint < NUM_JOINTS; joint++)
+            {
+                const joint_transform_t &expected = raw_clip.samples[frame * NUM_JOINTS + joint];
+                const joint_transform_t sample =
+                    sample_animation_clip_joint(clip, static_cast<f32>(frame) / raw_clip.sample_rate, joint);
+
+                // Some slack for the f32 sampling of the frame position.
+                NETHER_CHECK(get_rotation_angle(sample.rotation, expected.rotation) <= max_rotation_error + 1e-5);
+                NETHER_CHECK(length(sample.translation - expected.translation) <= settings.max_translation_error);
+            }
+        }
+    }
+
+    // Larger errors remove more keys.
+    const animation_clip_t precise_clip = compress_animation_clip(raw_clip, {.max_rotation_error_in_radians = 0.0005f});
+    const animation_clip_t coarse_clip = compress_animation_clip(raw_clip, {.max_rotation_error_in_radians = 0.01f});
+    NETHER_CHECK(coarse_clip.get_num_rotation_keys() < precise_clip.get_num_rotation_keys());
+}
+
+NETHER_TEST(animation_sampling_matches_scalar)
+{
+    // Not a multiple of 8, so the last SoA transform has padding lanes.
+    constexpr u32 NUM_JOINTS = 13u;
+
+    const animation_clip_t clip = compress_animation_clip(create_sway_clip(NUM_JOINTS, 91u));
+
+    std::vector<joint_transform_soa_t> pose(get_num_soa_transforms(NUM_JOINTS));
+    animation_sampling_context_t context{};
+
+    // Forward (cursors move), backward (cursors are searched for again) and past the end (clamped).
+    for (const f32 time_in_s : {0.0f, 0.01f, 0.4f, 0.41f, 1.234f, 0.2f, 2.99f, 3.0f, 5.0f, -1.0f})
+    {
+        sample_animation_clip(clip, time_in_s, context, pose);
+
+        for (u32 joint = 0u; joint < NUM_JOINTS; joint++)
+        {
+            const joint_transform_t expected = sample_animation_clip_joint(clip, time_in_s, joint);
+            const joint_transform_t sample = get_joint_transform(pose, joint);
+
+            NETHER_CHECK_NEAR(sample.rotation.x, expected.rotation.x, 1e-5f);
+            NETHER_CHECK_NEAR(sample.rotation.y, expected.rotation.y, 1e-5f);
+            NETHER_CHECK_NEAR(sample.rotation.z, expected.rotation.z, 1e-5f);
+            NETHER_CHECK_NEAR(sample.rotation.w, expected.rotation.w, 1e-5f);
+            NETHER_CHECK_NEAR(sample.translation.x, expected.translation.x, 1e-5f);
+            NETHER_CHECK_NEAR(sample.translation.y, expected.translation.y, 1e-5f);
+            NETHER_CHECK_NEAR(sample.translation.z, expected.translation.z, 1e-5f);
+        }
+
+        for (u32 joint = NUM_JOINTS; joint < static_cast<u32>(pose.size()) * joint_transform_soa_t::NUM_LANES; joint++)
+        {
+            const joint_transform_t padding = get_joint_transform(pose, joint);
+            NETHER_CHECK(padding.rotation.w == 1.0f && padding.rotation.x == 0.0f);
+            NETHER_CHECK(padding.translation.x == 0.0f && padding.translation.y == 0.0f);
+        }
+    }
+}
+
+NETHER_TEST(animation_blend_poses)
+{
+    constexpr u32 NUM_JOINTS = 9u;
+    const u32 num_soa_transforms = get_num_soa_transforms(NUM_JOINTS);
+
+    std::vector<joint_transform_soa_t> a(num_soa_transforms);
+    std::vector<joint_transform_soa_t> b(num_soa_transforms);
+    std::vector<joint_transform_soa_t> result(num_soa_transforms);
+
+    const float4_t rotation = axis_angle_rotation({0.0f, 1.0f, 0.0f}, 1.0f);
+    for (u32 i = 0u; i < NUM_JOINTS; i++)
+    {
+        set_joint_transform(a, i, {.rotation = {0.0f, 0.0f, 0.0f, 1.0f}, .translation = {1.0f, 0.0f, 0.0f}});
+
+        // Odd joints store the rotation negated, which must not change the result.
+        const f32 sign = (i % 2u) ? -1.0f : 1.0f;
+        set_joint_transform(b, i,
+                            {.rotation = {rotation.x * sign, rotation.y * sign, rotation.z * sign, rotation.w * sign},
+                             .translation = {5.0f, 4.0f, 0.0f}});
+    }
+
+    const pose_blend_layer_t layers[] = {{a, 1.0f}, {b, 3.0f}};
+    blend_poses(layers, result);
+
+    const float4_t expected_rotation = axis_angle_rotation({0.0f, 1.0f, 0.0f}, 0.75f);
+    for (u32 i = 0u; i < NUM_JOINTS; i++)
+    {
+        const joint_transform_t transform = get_joint_transform(result, i);
+
+        NETHER_CHECK_NEAR(transform.translation.x, 4.0f, 1e-5f);
+        NETHER_CHECK_NEAR(transform.translation.y, 3.0f, 1e-5f);
+
+        // nlerp is not slerp : the angle is close to, but not exactly, the weighted average.
+        NETHER_CHECK(get_rotation_angle(transform.rotation, expected_rotation) < 0.02);
+        NETHER_CHECK_NEAR(std::abs(transform.rotation.y), std::sin(0.5f * 0.75f), 0.01f);
+    }
+
+    // A single layer is returned as is (up to normalization).
+    const pose_blend_layer_t single_layer[] = {{b, 0.5f}};
+    blend_poses(single_layer, result);
+    for (u32 i = 0u; i < NUM_JOINTS; i++)
+    {
+        NETHER_CHECK(get_rotation_angle(get_joint_transform(result, i).rotation, rotation) < 1e-4);
+    }
+
+    const pose_blend_layer_t zero_weight_layers[] = {{a, 0.0f}, {b, 0.0f}};
+    NETHER_CHECK_THROWS(blend_poses(zero_weight_layers, result));
+}
+
+NETHER_TEST(animation_model_matrices_match_scalar)
+{
+    // Two chains under a common root, so that parents are not always the previous joint.
+    const std::vector<u32> parent_indices = {skeleton_t::INVALID_JOINT_INDEX, 0u, 1u, 0u, 3u, 2u, 4u, 5u, 6u, 8u, 9u};
+    const u32 num_joints = static_cast<u32>(parent_indices.size());
+
+    std::vector<joint_transform_t> bind_pose(num_joints);
+    std::vector<joint_transform_soa_t> local_pose(get_num_soa_transforms(num_joints));
+    for (u32 i = 0u; i < num_joints; i++)
+    {
+        bind_pose[i].translation = {0.1f * static_cast<f32>(i), 0.5f, -0.2f};
+        set_joint_transform(local_pose, i,
+                            {.rotation = axis_angle_rotation({1.0f, static_cast<f32>(i), 0.5f}, 0.3f * i),
+                             .translation = {0.3f, 0.4f * static_cast<f32>(i), 0.1f}});
+    }
+
+    const skeleton_t skeleton = create_skeleton(parent_indices, bind_pose);
+
+    std::vector<float4x4_t> model_matrices(num_joints);
+    compute_model_matrices(skeleton, local_pose, model_matrices);
+
+    std::vector<float4x4_t> expected_model_matrices(num_joints);
+    for (u32 i = 0u; i < num_joints; i++)
+    {
+        expected_model_matrices[i] = get_joint_matrix(get_joint_transform(local_pose, i));
+        if (parent_indices[i] != skeleton_t::INVALID_JOINT_INDEX)
+        {
+            expected_model_matrices[i] = expected_model_matrices[i] * expected_model_matrices[parent_indices[i]];
+        }
+
+        check_matrices_near(model_matrices[i], expected_model_matrices[i], 1e-5f);
+    }
+
+    const float4x4_t world_matrix = rotation_y_matrix(0.5f) * translation_matrix({1.0f, 2.0f, 3.0f});
+    std::vector<float4x4_t> skinning_matrices(num_joints);
+    compute_skinning_matrices(skeleton, model_matrices, world_matrix, skinning_matrices);
+    for (u32 i = 0u; i < num_joints; i++)
+    {
+        check_matrices_near(skinning_matrices[i],
+                            skeleton.inverse_bind_matrices[i] * expected_model_matrices[i] * world_matrix, 1e-4f);
+    }
+}
+
+NETHER_TEST(animation_bind_pose_skinning_is_world_matrix)
+{
+    const skeleton_t skeleton = create_chain_skeleton(10u);
+
+    // No layers : the bind pose, whose skinning matrices only place the mesh in the world.
+    std::vector<animated_character_t> characters(3u);
+    for (u32 i = 0u; i < characters.size(); i++)
+    {
+        characters[i].world_matrix =
+            rotation_x_matrix(0.2f * i) * translation_matrix({static_cast<f32>(i), 1.0f, 0.0f});
+    }
+
+    std::vector<float4x4_t> skinning_matrices(characters.size() * skeleton.get_num_joints());
+    const animation_statistics_t statistics = animate_characters(skeleton, characters, skinning_matrices);
+    NETHER_CHECK(statistics.num_characters == 3u);
+    NETHER_CHECK(statistics.num_skinning_matrices == 30u);
+
+    for (u32 i = 0u; i < characters.size(); i++)
+    {
+        for (u32 joint = 0u; joint < skeleton.get_num_joints(); joint++)
+        {
+            check_matrices_near(skinning_matrices[i * skeleton.get_num_joints() + joint], characters[i].world_matrix,
+                                1e-5f);
+        }
+    }
+
+    std::vector<float4x4_t> too_few_skinning_matrices(skinning_matrices.size() - 1u);
+    NETHER_CHECK_THROWS(animate_characters(skeleton, characters, too_few_skinning_matrices));
+}
+
+NETHER_TEST(animation_parallel_matches_serial)
+{
+    constexpr u32 NUM_JOINTS = 30u;
+    constexpr u32 NUM_CHARACTERS = 200u;
+
+    job_system_t job_system(3u);
+
+    const skeleton_t skeleton = create_chain_skeleton(NUM_JOINTS);
+    const std::array<animation_clip_t, 2> clips = {
+        compress_animation_clip(create_sway_clip(NUM_JOINTS, 60u)),
+        compress_animation_clip(create_sway_clip(NUM_JOINTS, 45u)),
+    };
+
+    std::vector<animated_character_t> serial_characters = create_characters(clips, NUM_CHARACTERS);
+    std::vector<animated_character_t> parallel_characters = create_characters(clips, NUM_CHARACTERS);
+
+    std::vector<float4x4_t> serial_skinning_matrices(NUM_CHARACTERS * NUM_JOINTS);
+    std::vector<float4x4_t> parallel_skinning_matrices(NUM_CHARACTERS * NUM_JOINTS);
+
+    // A few frames, so that the sampling contexts are reused.
+    for (u32 frame = 0u; frame < 4u; frame++)
+    {
+        for (u32 i = 0u; i < NUM_CHARACTERS; i++)
+        {
+            for (u32 layer = 0u; layer < 2u; layer++)
+            {
+                serial_characters[i].layers[layer].time_in_s += 0.1f;
+                parallel_characters[i].layers[layer].time_in_s += 0.1f;
+            }
+        }
+
+        animate_characters(skeleton, serial_characters, serial_skinning_matrices);
+        const animation_statistics_t statistics =
+            animate_characters(skeleton, parallel_characters, parallel_skinning_matrices, &job_system);
+        NETHER_CHECK(statistics.num_characters == NUM_CHARACTERS);
+
+        NETHER_CHECK(std::memcmp(serial_skinning_matrices.data(), parallel_skinning_matrices.data(),
+                                 serial_skinning_matrices.size() * sizeof(float4x4_t)) == 0);
+    }
+
+    // A clip for another skeleton is rejected.
+    const animation_clip_t other_clip = compress_animation_clip(create_sway_clip(NUM_JOINTS + 1u, 10u));
+    serial_characters[7].layers[1].clip = &other_clip;
+    NETHER_CHECK_THROWS(animate_characters(skeleton, serial_characters, serial_skinning_matrices));
+}
+
+NETHER_TEST(animation_invalid_inputs_throw)
+{
+    const std::vector<u32> parent_indices = {skeleton_t::INVALID_JOINT_INDEX, 2u, 0u};
+    const std::vector<joint_transform_t> bind_pose(3u);
+    NETHER_CHECK_THROWS(create_skeleton(parent_indices, bind_pose));
+    NETHER_CHECK_THROWS(create_skeleton(parent_indices, std::span(bind_pose).first(2u)));
+
+    raw_animation_clip_t raw_clip = create_sway_clip(4u, 10u);
+    raw_clip.samples.pop_back();
+    NETHER_CHECK_THROWS(compress_animation_clip(raw_clip));
+
+    NETHER_CHECK_THROWS(compress_animation_clip(raw_animation_clip_t{}));
+}
+
+NETHER_TEST(animation_pack_joint_influence)
+{
+    const joint_influence_t influence = pack_joint_influence({3u, 7u, 0u, 255u}, {0.5f, 0.25f, 0.25f, 0.0f});
+    NETHER_CHECK(influence.joint_indices == (3u | (7u << 8u) | (255u << 24u)));
+
+    u32 total_weight = 0u;
+    for (u32 i = 0u; i < 4u; i++)
+    {
+        total_weight += (influence.joint_weights >> (i * 8u)) & 0xffu;
+    }
+    NETHER_CHECK(total_weight == 255u);
+    NETHER_CHECK_NEAR(static_cast<f32>(influence.joint_weights & 0xffu), 127.5f, 1.0f);
+
+    NETHER_CHECK_THROWS(pack_joint_influence({256u, 0u, 0u, 0u}, {1.0f, 0.0f, 0.0f, 0.0f}));
+    NETHER_CHECK_THROWS(pack_joint_influence({0u, 0u, 0u, 0u}, {0.0f, 0.0f, 0.0f, 0.0f}));
+}
@@ -0,0 +1,88 @@
+#include "test_framework.hpp"
+
+#include "benchmark.hpp"
+
+// The parts of nether-bench that are not timing dependent.
+namespace
+{
+using namespace nether;
+
+bench::benchmark_result_t create_result(const std::string_view name, const f64 median_time_in_ns)
+{
+    return bench::benchmark_result_t{
+        .name = std::string(name),
+        .num_iterations_per_sample = 1000u,
+        .num_samples = 10u,
+        .median_time_in_ns = median_time_in_ns,
+        .mean_time_in_ns = median_time_in_ns + 1.0,
+        .min_time_in_ns = median_time_in_ns - 1.0,
+        .max_time_in_ns = median_time_in_ns + 2.0,
+        .standard_deviation_in_ns = 0.5,
+        .items_per_second = 1.0e9 / median_time_in_ns,
+    };
+}
+} // namespace
+
+NETHER_TEST(benchmark_options)
+{
+    const std::array<std::string_view, 8> arguments = {"--filter", "bvh/", "--samples", "5",
+                                                       "--cpu",    "-1",   "--threshold", "2.5"};
+    const std::optional<bench::benchmark_options_t> options = bench::parse_benchmark_options(arguments);
+
+    NETHER_CHECK(options.has_value());
+    NETHER_CHECK(options->filter == "bvh/");
+    NETHER_CHECK(options->num_samples == 5u);
+    NETHER_CHECK(options->cpu_index == -1);
+    NETHER_CHECK_NEAR(options->regression_threshold_percent, 2.5f, 1e-6f);
+
+    const std::array<std::string_view, 2> invalid_number = {"--samples", "five"};
+    NETHER_CHECK_THROWS(bench::parse_benchmark_options(invalid_number));
+
+    const std::array<std::string_view, 1> unknown_option = {"--fast"};
+    NETHER_CHECK_THROWS(bench::parse_benchmark_options(unknown_option));
+}
+
+NETHER_TEST(benchmark_results_round_trip)
+{
+    const std::array<bench::benchmark_result_t, 2> results = {
+        create_result("bvh/build", 1.5e6),
+        create_result("clustered_lighting/build(4096 lights, parallel)", 250.25),
+    };
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "nether-tests" / "benchmarks.json";
+    std::filesystem::create_directories(path.parent_path());
+    bench::write_benchmark_results(path, results);
+
+    const std::vector<bench::benchmark_result_t> loaded_results = bench::load_benchmark_results(path);
+    NETHER_CHECK(loaded_results.size() == results.size());
+    for (u32 i = 0u; i < results.size(); i++)
+    {
+        NETHER_CHECK(loaded_results[i].name == results[i].name);
+        NETHER_CHECK(loaded_results[i].num_iterations_per_sample == results[i].num_iterations_per_sample);
+        NETHER_CHECK(loaded_results[i].num_samples == results[i].num_samples);
+        NETHER_CHECK_NEAR(loaded_results[i].median_time_in_ns, results[i].median_time_in_ns, 1e-3);
+        NETHER_CHECK_NEAR(loaded_results[i].items_per_second, results[i].items_per_second, 1.0);
+    }
+}
+
+NETHER_TEST(benchmark_regressions)
+{
+    const std::array<bench::benchmark_result_t, 3> baseline = {
+        create_result("a", 100.0),
+        create_result("b", 100.0),
+        create_result("removed", 100.0),
+    };
+    const std::array<bench::benchmark_result_t, 3> results = {
+        create_result("a", 109.0),
+        create_result("b", 120.0),
+        create_result("added", 100.0),
+    };
+
+    const std::vector<bench::benchmark_comparison_t> comparisons =
+        bench::compare_benchmark_results(baseline, results, 10.0f);
+
+    NETHER_CHECK(comparisons.size() == 2u);
+    NETHER_CHECK(comparisons[0].name == "a" && !comparisons[0].regression);
+    NETHER_CHECK(comparisons[1].name == "b" && comparisons[1].regression);
+    NETHER_CHECK_NEAR(comparisons[1].change_percent, 20.0, 1e-9);
+}
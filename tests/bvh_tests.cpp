@@ -0,0 +1,176 @@
+#include "test_framework.hpp"
+
+#include "bvh.hpp"
+
+#include <random>
+
+// Every query is compared against a brute force loop over the primitives.
+namespace
+{
+using namespace nether;
+
+struct bvh_test_scene_t
+{
+    std::mt19937 random_engine{1u};
+    std::uniform_real_distribution<f32> position_distribution{-100.0f, 100.0f};
+    std::uniform_real_distribution<f32> extent_distribution{0.01f, 2.0f};
+
+    std::vector<aabb_t> primitive_bounds{};
+
+    float3_t random_position()
+    {
+        return {position_distribution(random_engine), position_distribution(random_engine),
+                position_distribution(random_engine)};
+    }
+};
+
+std::vector<aabb_t> create_primitive_bounds(bvh_test_scene_t &scene, const u32 num_primitives)
+{
+    std::vector<aabb_t> primitive_bounds(num_primitives);
+    for (aabb_t &bounds : primitive_bounds)
+    {
+        const float3_t center = scene.random_position();
+        const float3_t extents = {scene.extent_distribution(scene.random_engine),
+                                  scene.extent_distribution(scene.random_engine),
+                                  scene.extent_distribution(scene.random_engine)};
+        bounds = {center - extents, center + extents};
+    }
+
+    return primitive_bounds;
+}
+
+f32 intersect_ray_brute_force(const std::span<const aabb_t> primitive_bounds, const ray_t &ray)
+{
+    const float3_t inverse_direction = {1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z};
+
+    f32 closest_t = INFINITY;
+    for (const aabb_t &bounds : primitive_bounds)
+    {
+        const f32 tx0 = (bounds.min.x - ray.origin.x) * inverse_direction.x;
+        const f32 tx1 = (bounds.max.x - ray.origin.x) * inverse_direction.x;
+        const f32 ty0 = (bounds.min.y - ray.origin.y) * inverse_direction.y;
+        const f32 ty1 = (bounds.max.y - ray.origin.y) * inverse_direction.y;
+        const f32 tz0 = (bounds.min.z - ray.origin.z) * inverse_direction.z;
+        const f32 tz1 = (bounds.max.z - ray.origin.z) * inverse_direction.z;
+
+        const f32 entry = std::max({std::min(tx0, tx1), std::min(ty0, ty1), std::min(tz0, tz1), 0.0f});
+        const f32 exit = std::min({std::max(tx0, tx1), std::max(ty0, ty1), std::max(tz0, tz1)});
+        if (entry <= exit)
+        {
+            closest_t = std::min(closest_t, entry);
+        }
+    }
+
+    return closest_t;
+}
+
+void check_queries(bvh_test_scene_t &scene, const bvh_t &bvh)
+{
+    const std::span<const aabb_t> primitive_bounds = scene.primitive_bounds;
+
+    std::vector<u32> result{};
+    std::vector<u32> expected_result{};
+    for (u32 i = 0u; i < 50u; i++)
+    {
+        const float3_t center = scene.random_position();
+        const aabb_t query_bounds = {center - float3_t{10.0f, 10.0f, 10.0f}, center + float3_t{10.0f, 10.0f, 10.0f}};
+
+        result.clear();
+        bvh.query_aabb(query_bounds, result);
+        std::sort(result.begin(), result.end());
+
+        expected_result.clear();
+        for (u32 k = 0u; k < primitive_bounds.size(); k++)
+        {
+            if (overlaps(primitive_bounds[k], query_bounds))
+            {
+                expected_result.push_back(k);
+            }
+        }
+        NETHER_CHECK(result == expected_result);
+
+        // A box shaped frustum around the query bounds.
+        const frustum_t frustum = {.planes = {
+                                       float4_t{1.0f, 0.0f, 0.0f, -query_bounds.min.x},
+                                       float4_t{-1.0f, 0.0f, 0.0f, query_bounds.max.x},
+                                       float4_t{0.0f, 1.0f, 0.0f, -query_bounds.min.y},
+                                       float4_t{0.0f, -1.0f, 0.0f, query_bounds.max.y},
+                                       float4_t{0.0f, 0.0f, 1.0f, -query_bounds.min.z},
+                                       float4_t{0.0f, 0.0f, -1.0f, query_bounds.max.z},
+                                   }};
+
+        result.clear();
+        bvh.query_frustum(frustum, result);
+        std::sort(result.begin(), result.end());
+
+        expected_result.clear();
+        for (u32 k = 0u; k < primitive_bounds.size(); k++)
+        {
+            if (intersects(frustum, primitive_bounds[k]))
+            {
+                expected_result.push_back(k);
+            }
+        }
+        NETHER_CHECK(result == expected_result);
+
+        const ray_t ray = {.origin = center, .direction = normalize(scene.random_position())};
+        const ray_hit_t ray_hit = bvh.intersect_ray(ray);
+        const f32 expected_t = intersect_ray_brute_force(primitive_bounds, ray);
+        if (expected_t == INFINITY)
+        {
+            NETHER_CHECK(ray_hit.t == INFINITY);
+            NETHER_CHECK(ray_hit.primitive_index == ray_hit_t::INVALID_PRIMITIVE);
+        }
+        else
+        {
+            NETHER_CHECK_NEAR(ray_hit.t, expected_t, 1e-3f);
+        }
+    }
+}
+
+void check_build_and_refit(const u32 num_primitives, const bool with_duplicates)
+{
+    job_system_t job_system{};
+
+    bvh_test_scene_t scene{};
+    scene.primitive_bounds = create_primitive_bounds(scene, num_primitives);
+    if (with_duplicates)
+    {
+        std::fill_n(scene.primitive_bounds.begin(), num_primitives / 5u, scene.primitive_bounds.front());
+    }
+
+    bvh_t bvh{};
+    bvh.build(scene.primitive_bounds, &job_system);
+    check_queries(scene, bvh);
+
+    for (aabb_t &bounds : scene.primitive_bounds)
+    {
+        const float3_t offset = {scene.position_distribution(scene.random_engine) * 0.1f, 1.0f, 0.0f};
+        bounds = {bounds.min + offset, bounds.max + offset};
+    }
+
+    bvh.refit(scene.primitive_bounds, &job_system);
+    check_queries(scene, bvh);
+
+    bvh.build(scene.primitive_bounds);
+    check_queries(scene, bvh);
+}
+} // namespace
+
+NETHER_TEST(bvh_queries_with_few_primitives)
+{
+    for (const u32 num_primitives : {1u, 2u, 3u, 7u, 100u})
+    {
+        check_build_and_refit(num_primitives, false);
+    }
+}
+
+NETHER_TEST(bvh_queries_with_duplicate_primitives)
+{
+    check_build_and_refit(5000u, true);
+}
+
+NETHER_TEST(bvh_queries_with_parallel_build)
+{
+    check_build_and_refit(200000u, false);
+}
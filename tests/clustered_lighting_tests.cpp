@@ -0,0 +1,169 @@
+#include "test_framework.hpp"
+
+#include "clustered_lighting.hpp"
+
+#include <random>
+
+// The clusters are compared against a scalar version of the builder's tests (see clustered_lighting.cpp).
+namespace
+{
+using namespace nether;
+
+constexpr f32 X_SCALE = 1.358f;
+constexpr f32 Y_SCALE = 2.414f;
+constexpr f32 NEAR_PLANE = 0.1f;
+constexpr f32 MAX_DEPTH = 500.0f;
+
+std::vector<light_t> create_lights(const u32 num_lights)
+{
+    std::mt19937 random_engine(2u);
+    std::uniform_real_distribution<f32> distribution(-1.0f, 1.0f);
+    std::uniform_real_distribution<f32> unit_distribution(0.0f, 1.0f);
+
+    std::vector<light_t> lights(num_lights);
+    for (light_t &light : lights)
+    {
+        light.position = {distribution(random_engine) * 100.0f, distribution(random_engine) * 30.0f,
+                          distribution(random_engine) * 150.0f + 60.0f};
+        light.range = 1.0f + unit_distribution(random_engine) * 10.0f;
+        light.color = {1.0f, 1.0f, 1.0f};
+
+        if (unit_distribution(random_engine) < 0.3f)
+        {
+            light.type = light_type_t::spot;
+            light.direction = normalize(
+                float3_t{distribution(random_engine), distribution(random_engine), distribution(random_engine)});
+            light.spot_cos_outer_angle = std::cos(0.2f + unit_distribution(random_engine));
+        }
+    }
+
+    return lights;
+}
+
+bool intersects_cluster(const light_t &light, const float4x4_t &view_matrix, const aabb_t &cluster_bounds)
+{
+    const float4_t view_position = transform_point(light.position, view_matrix);
+    const float3_t position = {view_position.x, view_position.y, view_position.z};
+
+    const float3_t distance = max(max(cluster_bounds.min - position, position - cluster_bounds.max), float3_t{});
+    if (dot(distance, distance) > light.range * light.range)
+    {
+        return false;
+    }
+
+    if (light.type != light_type_t::spot)
+    {
+        return true;
+    }
+
+    // Cone vs the cluster's bounding sphere.
+    const float3_t direction = {
+        light.direction.x * view_matrix.m[0][0] + light.direction.y * view_matrix.m[1][0] +
+            light.direction.z * view_matrix.m[2][0],
+        light.direction.x * view_matrix.m[0][1] + light.direction.y * view_matrix.m[1][1] +
+            light.direction.z * view_matrix.m[2][1],
+        light.direction.x * view_matrix.m[0][2] + light.direction.y * view_matrix.m[1][2] +
+            light.direction.z * view_matrix.m[2][2],
+    };
+
+    const float3_t center = get_center(cluster_bounds);
+    const f32 radius = length(cluster_bounds.max - center);
+
+    const float3_t to_center = center - position;
+    const f32 squared_length = dot(to_center, to_center);
+    const f32 axis_length = dot(to_center, direction);
+    const f32 cos_angle = light.spot_cos_outer_angle;
+    const f32 sin_angle = std::sqrt(1.0f - cos_angle * cos_angle);
+
+    const f32 distance_to_cone =
+        cos_angle * std::sqrt(std::max(squared_length - axis_length * axis_length, 0.0f)) - axis_length * sin_angle;
+
+    return distance_to_cone <= radius && axis_length <= radius + light.range && axis_length >= -radius;
+}
+
+void check_clusters(const light_cluster_builder_t &light_cluster_builder, const std::span<const light_t> lights,
+                    const float4x4_t &view_matrix)
+{
+    const u32 num_clusters_x = light_cluster_builder.num_clusters_x;
+    const u32 num_clusters_y = light_cluster_builder.num_clusters_y;
+    const u32 num_clusters_z = light_cluster_builder.num_clusters_z;
+
+    for (u32 z = 0u; z < num_clusters_z; z++)
+    {
+        const f32 near_depth = NEAR_PLANE * std::pow(MAX_DEPTH / NEAR_PLANE, static_cast<f32>(z) / num_clusters_z);
+        const f32 far_depth = NEAR_PLANE * std::pow(MAX_DEPTH / NEAR_PLANE, static_cast<f32>(z + 1u) / num_clusters_z);
+
+        for (u32 y = 0u; y < num_clusters_y; y++)
+        {
+            for (u32 x = 0u; x < num_clusters_x; x++)
+            {
+                const f32 top = 1.0f - 2.0f * y / num_clusters_y;
+                const f32 bottom = 1.0f - 2.0f * (y + 1u) / num_clusters_y;
+                const f32 left = 2.0f * x / num_clusters_x - 1.0f;
+                const f32 right = 2.0f * (x + 1u) / num_clusters_x - 1.0f;
+
+                aabb_t cluster_bounds{};
+                for (const f32 depth : {near_depth, far_depth})
+                {
+                    cluster_bounds =
+                        merge(cluster_bounds, float3_t{left * depth / X_SCALE, top * depth / Y_SCALE, depth});
+                    cluster_bounds =
+                        merge(cluster_bounds, float3_t{right * depth / X_SCALE, bottom * depth / Y_SCALE, depth});
+                }
+
+                std::vector<u32> expected_light_indices{};
+                for (u32 i = 0u; i < lights.size(); i++)
+                {
+                    if (intersects_cluster(lights[i], view_matrix, cluster_bounds))
+                    {
+                        expected_light_indices.push_back(i);
+                    }
+                }
+
+                const light_cluster_t &cluster =
+                    light_cluster_builder.clusters[light_cluster_builder.get_cluster_index(x, y, z)];
+                std::vector<u32> light_indices(light_cluster_builder.light_indices.begin() + cluster.offset,
+                                               light_cluster_builder.light_indices.begin() + cluster.offset +
+                                                   cluster.count);
+                std::sort(light_indices.begin(), light_indices.end());
+
+                if (expected_light_indices.size() > light_cluster_builder_t::MAX_LIGHTS_PER_CLUSTER)
+                {
+                    NETHER_CHECK(light_indices.size() == light_cluster_builder_t::MAX_LIGHTS_PER_CLUSTER);
+                }
+                else
+                {
+                    NETHER_CHECK(light_indices == expected_light_indices);
+                }
+            }
+        }
+    }
+}
+} // namespace
+
+NETHER_TEST(clustered_lighting_matches_brute_force)
+{
+    job_system_t job_system{};
+
+    const float4x4_t view_matrix = rotation_y_matrix(0.3f) * translation_matrix({1.0f, 2.0f, 3.0f});
+
+    for (const u32 num_lights : {0u, 1u, 13u, 1000u, 4096u})
+    {
+        const std::vector<light_t> lights = create_lights(num_lights);
+
+        for (const std::array<u32, 3> num_clusters :
+             {std::array<u32, 3>{16u, 9u, 24u}, std::array<u32, 3>{32u, 18u, 48u}})
+        {
+            light_cluster_builder_t light_cluster_builder(num_clusters[0], num_clusters[1], num_clusters[2]);
+            light_cluster_builder.set_projection(X_SCALE, Y_SCALE, NEAR_PLANE, MAX_DEPTH);
+
+            light_cluster_builder.build(lights, view_matrix, &job_system);
+            NETHER_CHECK(light_cluster_builder.statistics.num_lights == num_lights);
+            check_clusters(light_cluster_builder, lights, view_matrix);
+
+            // Rebuilding (serially) gives the same result.
+            light_cluster_builder.build(lights, view_matrix);
+            check_clusters(light_cluster_builder, lights, view_matrix);
+        }
+    }
+}
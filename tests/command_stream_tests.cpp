@@ -0,0 +1,141 @@
+#include "test_framework.hpp"
+
+#include "command_stream.hpp"
+
+#include <numeric>
+
+namespace
+{
+using namespace nether;
+
+constexpr std::array<u32, 5> ROOT_CONSTANTS = {1u, 2u, 3u, 4u, 5u};
+
+void record_draws(command_stream_t &stream, const u32 num_draws)
+{
+    stream.resource_barrier(0u, resource_state_t::present, resource_state_t::render_target);
+    stream.clear_render_target({0.0f, 0.0f, 0.0f, 1.0f});
+    stream.clear_depth(0.0f);
+
+    for (u32 i = 0u; i < num_draws; i++)
+    {
+        stream.set_pipeline(i % 3u);
+        stream.set_index_buffer(256u, 72u, index_format_t::u16);
+        stream.set_root_constants(0u, ROOT_CONSTANTS);
+        stream.draw_indexed_instanced(36u, 1u + i);
+    }
+}
+} // namespace
+
+NETHER_TEST(command_stream_record_and_iterate)
+{
+    constexpr u32 NUM_DRAWS = 3000u;
+
+    memory::linear_arena_t arena(64u * 1024u * 1024u);
+    command_stream_t stream(arena);
+    record_draws(stream, NUM_DRAWS);
+    NETHER_CHECK(stream.get_num_commands() == 3u + 4u * NUM_DRAWS);
+
+    u32 num_commands = 0u;
+    u32 num_draws = 0u;
+    u32 root_constants_sum = 0u;
+    stream.for_each_command([&](const command_header_t &header) {
+        num_commands++;
+        NETHER_CHECK(header.size % 8u == 0u);
+
+        if (header.type == command_type_t::draw_indexed_instanced)
+        {
+            const auto &command = reinterpret_cast<const draw_indexed_instanced_command_t &>(header);
+            NETHER_CHECK(command.instance_count == 1u + num_draws);
+            num_draws++;
+        }
+        else if (header.type == command_type_t::set_root_constants)
+        {
+            const auto &command = reinterpret_cast<const set_root_constants_command_t &>(header);
+            NETHER_CHECK(command.num_values == ROOT_CONSTANTS.size());
+            for (u32 i = 0u; i < command.num_values; i++)
+            {
+                root_constants_sum += command.get_values()[i];
+            }
+        }
+    });
+
+    NETHER_CHECK(num_commands == stream.get_num_commands());
+    NETHER_CHECK(num_draws == NUM_DRAWS);
+    NETHER_CHECK(root_constants_sum == 15u * NUM_DRAWS);
+
+    NETHER_CHECK(validate(stream, {3u, 1u}).empty());
+
+    // One line per command.
+    const std::string text = to_string(stream);
+    NETHER_CHECK(static_cast<u32>(std::count(text.begin(), text.end(), '\n')) == stream.get_num_commands());
+}
+
+NETHER_TEST(command_stream_validation_errors)
+{
+    memory::linear_arena_t arena(1024u * 1024u);
+    command_stream_t stream(arena);
+
+    // No pipeline and no index buffer are set.
+    stream.draw_indexed_instanced(3u, 1u);
+    // Pipeline out of range.
+    stream.set_pipeline(7u);
+    // Null index buffer.
+    stream.set_index_buffer(0u, 4u, index_format_t::u32);
+    // Transition to the same state, from a state the resource is not in, and of a resource out of range.
+    stream.resource_barrier(0u, resource_state_t::present, resource_state_t::present);
+    stream.resource_barrier(0u, resource_state_t::render_target, resource_state_t::present);
+    stream.resource_barrier(4u, resource_state_t::common, resource_state_t::present);
+    // More root constants than a root signature can hold.
+    const std::array<u32, 70> root_constants{};
+    stream.set_root_constants(0u, root_constants);
+    // Empty draw.
+    stream.draw_indexed_instanced(0u, 1u);
+
+    NETHER_CHECK(validate(stream, {3u, 1u}).size() == 9u);
+}
+
+NETHER_TEST(command_stream_copies)
+{
+    memory::linear_arena_t arena(1024u * 1024u);
+    command_stream_t stream(arena);
+
+    // Resource 0 is the destination, resource 1 the (upload heap) source.
+    stream.resource_barrier(0u, resource_state_t::common, resource_state_t::copy_destination);
+    stream.copy_buffer_region(0u, 160u, 1u, 0u, 80u);
+    stream.copy_buffer_region(0u, 800u, 1u, 80u, 240u);
+    stream.resource_barrier(0u, resource_state_t::copy_destination, resource_state_t::shader_resource);
+    NETHER_CHECK(validate(stream, {1u, 2u}).empty());
+    NETHER_CHECK(to_string(stream).find("1: copy_buffer_region destination=0 offset=160 source=1 offset=0 size=80") !=
+                 std::string::npos);
+
+    // A copy into a buffer in a read state, an empty copy, a copy within a buffer, and resources out of range.
+    stream.copy_buffer_region(0u, 0u, 1u, 0u, 80u);
+    stream.copy_buffer_region(1u, 0u, 0u, 0u, 0u);
+    stream.copy_buffer_region(1u, 0u, 1u, 80u, 80u);
+    stream.copy_buffer_region(5u, 0u, 1u, 0u, 80u);
+    NETHER_CHECK(validate(stream, {1u, 2u}).size() == 4u);
+}
+
+NETHER_TEST(command_stream_commands_larger_than_a_chunk)
+{
+    memory::linear_arena_t arena(1024u * 1024u);
+    command_stream_t stream(arena);
+
+    const std::vector<u32> root_constants(8000u, 1u);
+    stream.set_root_constants(0u, root_constants);
+    stream.draw_indexed_instanced(1u, 1u);
+
+    u32 num_commands = 0u;
+    u32 root_constants_sum = 0u;
+    stream.for_each_command([&](const command_header_t &header) {
+        num_commands++;
+        if (header.type == command_type_t::set_root_constants)
+        {
+            const auto &command = reinterpret_cast<const set_root_constants_command_t &>(header);
+            root_constants_sum = std::accumulate(command.get_values(), command.get_values() + command.num_values, 0u);
+        }
+    });
+
+    NETHER_CHECK(num_commands == 2u);
+    NETHER_CHECK(root_constants_sum == 8000u);
+}
@@ -0,0 +1,166 @@
+#include "test_framework.hpp"
+
+#include "debug_draw.hpp"
+
+#include <thread>
+
+namespace
+{
+using namespace nether;
+
+bool is_near(const float3_t &a, const float3_t &b)
+{
+    return length(a - b) < 1e-4f;
+}
+
+// Whether the line joins the two points, in either direction.
+bool joins(const debug_line_t &line, const float3_t &a, const float3_t &b)
+{
+    return (is_near(line.start, a) && is_near(line.end, b)) || (is_near(line.start, b) && is_near(line.end, a));
+}
+} // namespace
+
+NETHER_TEST(debug_draw_shapes)
+{
+    debug_draw_t debug_draw{};
+
+    const u32 red = make_debug_color(255u, 0u, 0u);
+    NETHER_CHECK(red == 0xff0000ffu);
+
+    debug_draw.draw_box(aabb_t{.min = {-1.0f, -2.0f, -3.0f}, .max = {1.0f, 2.0f, 3.0f}}, red);
+    NETHER_CHECK(debug_draw.get_num_lines(debug_draw_mode_t::depth_tested) == 12u);
+
+    std::vector<debug_line_t> lines(64u);
+    debug_draw.write_lines(lines);
+
+    // Every edge of the box joins two corners that differ in a single axis.
+    for (u32 i = 0u; i < 12u; i++)
+    {
+        const float3_t delta = lines[i].end - lines[i].start;
+        const u32 num_changed_axes = (delta.x != 0.0f) + (delta.y != 0.0f) + (delta.z != 0.0f);
+        NETHER_CHECK(num_changed_axes == 1u);
+        NETHER_CHECK(lines[i].color == red);
+    }
+
+    // The circles of a sphere are closed, and on the sphere.
+    debug_draw.draw_sphere({1.0f, 2.0f, 3.0f}, 2.0f, red, 16u, debug_draw_mode_t::on_top);
+    NETHER_CHECK(debug_draw.get_num_lines(debug_draw_mode_t::on_top) == 3u * 16u);
+
+    const std::array<debug_line_range_t, NUM_DEBUG_DRAW_MODES> ranges = debug_draw.write_lines(lines);
+    NETHER_CHECK(ranges[0].num_lines == 0u);
+    NETHER_CHECK(ranges[1].first_line == 0u && ranges[1].num_lines == 48u);
+    NETHER_CHECK(is_near(lines[0].start, lines[45].end));
+    for (u32 i = 0u; i < 48u; i++)
+    {
+        NETHER_CHECK_NEAR(length(lines[i].start - float3_t{1.0f, 2.0f, 3.0f}), 2.0f, 1e-4f);
+    }
+
+    NETHER_CHECK_THROWS(debug_draw.draw_sphere({}, 1.0f, red, 2u));
+
+    // A 90 degree frustum with a square aspect ratio looking down +z : the far face at distance 10 spans [-10, 10].
+    debug_draw.draw_frustum({}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}, std::numbers::pi_v<f32> * 0.5f, 1.0f, 1.0f,
+                            10.0f, red);
+    debug_draw.write_lines(lines);
+    NETHER_CHECK(joins(lines[0], {-1.0f, -1.0f, 1.0f}, {1.0f, -1.0f, 1.0f}));
+    NETHER_CHECK(joins(lines[1], {-10.0f, -10.0f, 10.0f}, {10.0f, -10.0f, 10.0f}));
+    NETHER_CHECK(joins(lines[2], {-1.0f, -1.0f, 1.0f}, {-10.0f, -10.0f, 10.0f}));
+
+    // The transformed box is translated.
+    debug_draw.draw_box(aabb_t{.min = {0.0f, 0.0f, 0.0f}, .max = {1.0f, 1.0f, 1.0f}},
+                        translation_matrix({5.0f, 0.0f, 0.0f}), red);
+    debug_draw.write_lines(lines);
+    NETHER_CHECK(joins(lines[0], {5.0f, 0.0f, 0.0f}, {6.0f, 0.0f, 0.0f}));
+}
+
+NETHER_TEST(debug_draw_merges_threads_and_modes)
+{
+    constexpr u32 NUM_THREADS = 4u;
+    constexpr u32 NUM_LINES_PER_THREAD = 3u * debug_draw_t::CHUNK_SIZE + 5u;
+
+    debug_draw_t debug_draw{};
+    job_system_t job_system(3u);
+
+    // Every line of a thread has the thread's index in its color and its index in its start, and every fourth line
+    // is drawn on top.
+    for (u32 frame = 0u; frame < 2u; frame++)
+    {
+        std::vector<std::thread> threads{};
+        for (u32 thread_index = 0u; thread_index < NUM_THREADS; thread_index++)
+        {
+            threads.emplace_back([&, thread_index]() {
+                for (u32 i = 0u; i < NUM_LINES_PER_THREAD; i++)
+                {
+                    debug_draw.draw_line({static_cast<f32>(i), 0.0f, 0.0f}, {}, thread_index,
+                                         i % 4u == 0u ? debug_draw_mode_t::on_top : debug_draw_mode_t::depth_tested);
+                }
+            });
+        }
+
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        std::vector<debug_line_t> lines(NUM_THREADS * NUM_LINES_PER_THREAD);
+        const std::array<debug_line_range_t, NUM_DEBUG_DRAW_MODES> ranges = debug_draw.write_lines(lines, &job_system);
+
+        const u32 num_on_top_lines_per_thread = (NUM_LINES_PER_THREAD + 3u) / 4u;
+        NETHER_CHECK(ranges[0].first_line == 0u);
+        NETHER_CHECK(ranges[0].num_lines == NUM_THREADS * (NUM_LINES_PER_THREAD - num_on_top_lines_per_thread));
+        NETHER_CHECK(ranges[1].first_line == ranges[0].num_lines);
+        NETHER_CHECK(ranges[1].num_lines == NUM_THREADS * num_on_top_lines_per_thread);
+        NETHER_CHECK(debug_draw.statistics.num_dropped_lines == 0u);
+        NETHER_CHECK(debug_draw.get_num_lines(debug_draw_mode_t::depth_tested) == 0u);
+
+        // The lines of each thread stay in order within each mode.
+        for (u32 mode = 0u; mode < NUM_DEBUG_DRAW_MODES; mode++)
+        {
+            std::array<u32, NUM_THREADS> num_thread_lines{};
+            for (u32 i = ranges[mode].first_line; i < ranges[mode].first_line + ranges[mode].num_lines; i++)
+            {
+                const u32 thread_index = lines[i].color;
+                const u32 line_index = static_cast<u32>(lines[i].start.x);
+
+                u32 expected_line_index = num_thread_lines[thread_index]++;
+                expected_line_index = mode == 1u ? expected_line_index * 4u
+                                                 : expected_line_index + expected_line_index / 3u + 1u;
+                NETHER_CHECK(line_index == expected_line_index);
+            }
+        }
+    }
+
+    // Threads that exited left their buffers to the threads created after them, which may reuse their ids.
+    NETHER_CHECK(debug_draw.statistics.num_threads >= NUM_THREADS);
+    NETHER_CHECK(debug_draw.statistics.num_threads <= 2u * NUM_THREADS);
+}
+
+NETHER_TEST(debug_draw_drops_lines_past_the_buffer)
+{
+    debug_draw_t debug_draw{};
+
+    for (u32 i = 0u; i < 10u; i++)
+    {
+        debug_draw.draw_line({}, {}, 1u, debug_draw_mode_t::depth_tested);
+        debug_draw.draw_line({}, {}, 2u, debug_draw_mode_t::on_top);
+    }
+
+    std::vector<debug_line_t> lines(15u);
+    const std::array<debug_line_range_t, NUM_DEBUG_DRAW_MODES> ranges = debug_draw.write_lines(lines);
+    NETHER_CHECK(ranges[0].num_lines == 10u);
+    NETHER_CHECK(ranges[1].first_line == 10u && ranges[1].num_lines == 5u);
+    NETHER_CHECK(lines[14].color == 2u);
+    NETHER_CHECK(debug_draw.statistics.num_dropped_lines == 5u);
+
+    // Cleared lines are not written.
+    debug_draw.draw_line({}, {}, 1u);
+    debug_draw.clear();
+    NETHER_CHECK(debug_draw.write_lines(lines)[0].num_lines == 0u);
+
+    // A second debug draw used from the same thread has its own buffers.
+    debug_draw_t other_debug_draw{};
+    debug_draw.draw_line({}, {}, 1u);
+    other_debug_draw.draw_line({}, {}, 2u);
+    other_debug_draw.draw_line({}, {}, 2u);
+    NETHER_CHECK(debug_draw.get_num_lines(debug_draw_mode_t::depth_tested) == 1u);
+    NETHER_CHECK(other_debug_draw.get_num_lines(debug_draw_mode_t::depth_tested) == 2u);
+}
@@ -0,0 +1,157 @@
+#include "test_framework.hpp"
+
+#include "ecs.hpp"
+
+namespace
+{
+using namespace nether;
+
+struct position_t
+{
+    f32 x{};
+    f32 y{};
+    f32 z{};
+};
+
+struct velocity_t
+{
+    f32 x{};
+    f32 y{};
+    f32 z{};
+};
+
+struct tag_t
+{
+};
+
+struct large_component_t
+{
+    f64 values[5]{};
+};
+
+// Enough entities to fill many chunks.
+constexpr u32 NUM_ENTITIES = 100000u;
+
+std::vector<ecs::entity_t> create_entities(ecs::world_t &world)
+{
+    std::vector<ecs::entity_t> entities{};
+    for (u32 i = 0u; i < NUM_ENTITIES; i++)
+    {
+        entities.push_back(
+            world.create_entity(position_t{static_cast<f32>(i), 0.0f, 0.0f}, velocity_t{1.0f, 2.0f, 3.0f}));
+    }
+
+    return entities;
+}
+} // namespace
+
+NETHER_TEST(ecs_add_and_remove_components_keep_data)
+{
+    ecs::world_t world{};
+    const std::vector<ecs::entity_t> entities = create_entities(world);
+
+    for (u32 i = 0u; i < NUM_ENTITIES; i += 2u)
+    {
+        world.add_component(entities[i], tag_t{});
+    }
+    for (u32 i = 0u; i < NUM_ENTITIES; i += 3u)
+    {
+        world.add_component(entities[i], large_component_t{});
+    }
+    for (u32 i = 0u; i < NUM_ENTITIES; i += 6u)
+    {
+        world.remove_component<velocity_t>(entities[i]);
+    }
+
+    for (u32 i = 0u; i < NUM_ENTITIES; i++)
+    {
+        const position_t *const position = world.get_component<position_t>(entities[i]);
+        NETHER_CHECK(position && position->x == static_cast<f32>(i));
+        NETHER_CHECK(world.has_component<tag_t>(entities[i]) == (i % 2u == 0u));
+        NETHER_CHECK(world.has_component<large_component_t>(entities[i]) == (i % 3u == 0u));
+        NETHER_CHECK(world.has_component<velocity_t>(entities[i]) == (i % 6u != 0u));
+    }
+}
+
+NETHER_TEST(ecs_queries_match_every_archetype)
+{
+    ecs::world_t world{};
+    const std::vector<ecs::entity_t> entities = create_entities(world);
+
+    for (u32 i = 0u; i < NUM_ENTITIES; i += 2u)
+    {
+        world.add_component(entities[i], tag_t{});
+    }
+
+    ecs::query_t query = world.create_query<position_t, velocity_t>();
+    world.for_each<position_t, velocity_t>(
+        query, [](const ecs::entity_t, position_t &position, const velocity_t &velocity) { position.y += velocity.y; });
+
+    job_system_t job_system(3u);
+    world.parallel_for_each_chunk<position_t, velocity_t>(
+        job_system, query,
+        [](const u32, const u32 count, const ecs::entity_t *const, position_t *const positions,
+           velocity_t *const velocities) {
+            for (u32 i = 0u; i < count; i++)
+            {
+                positions[i].y += velocities[i].y;
+            }
+        });
+
+    u32 num_matches = 0u;
+    world.for_each<position_t>(query, [&](const ecs::entity_t, const position_t &position) {
+        NETHER_CHECK(position.y == 4.0f);
+        num_matches++;
+    });
+    NETHER_CHECK(num_matches == NUM_ENTITIES);
+
+    ecs::query_t tag_query = world.create_query<position_t, tag_t>();
+    num_matches = 0u;
+    world.for_each<position_t>(tag_query, [&](const ecs::entity_t, const position_t &) { num_matches++; });
+    NETHER_CHECK(num_matches == NUM_ENTITIES / 2u);
+}
+
+NETHER_TEST(ecs_command_buffer_playback)
+{
+    ecs::world_t world{};
+    const std::vector<ecs::entity_t> entities = create_entities(world);
+
+    ecs::command_buffer_t command_buffer{};
+    for (u32 i = 0u; i < NUM_ENTITIES; i += 5u)
+    {
+        command_buffer.destroy_entity(entities[i]);
+    }
+    command_buffer.create_entity(position_t{7.0f, 7.0f, 7.0f}, tag_t{});
+
+    std::vector<ecs::entity_t> created_entities{};
+    command_buffer.playback(world, &created_entities);
+
+    NETHER_CHECK(created_entities.size() == 1u);
+    NETHER_CHECK(world.get_component<position_t>(created_entities[0])->x == 7.0f);
+    NETHER_CHECK(world.has_component<tag_t>(created_entities[0]));
+    NETHER_CHECK(world.get_num_entities() == NUM_ENTITIES - NUM_ENTITIES / 5u + 1u);
+
+    for (u32 i = 0u; i < NUM_ENTITIES; i++)
+    {
+        if (i % 5u == 0u)
+        {
+            NETHER_CHECK(!world.is_alive(entities[i]));
+            continue;
+        }
+
+        NETHER_CHECK(world.get_component<position_t>(entities[i])->x == static_cast<f32>(i));
+    }
+}
+
+NETHER_TEST(ecs_destroyed_entity_handles_are_not_reused)
+{
+    ecs::world_t world{};
+
+    const ecs::entity_t entity = world.create_entity(position_t{});
+    world.destroy_entity(entity);
+
+    const ecs::entity_t new_entity = world.create_entity(position_t{});
+    NETHER_CHECK(!world.is_alive(entity));
+    NETHER_CHECK(world.is_alive(new_entity));
+    NETHER_CHECK(!(new_entity == entity));
+}
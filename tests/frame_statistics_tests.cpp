@@ -0,0 +1,142 @@
+#include "test_framework.hpp"
+
+#include "frame_statistics.hpp"
+
+#include <thread>
+
+namespace
+{
+using namespace nether;
+} // namespace
+
+NETHER_TEST(frame_statistics_histogram_buckets)
+{
+    for (u64 value = 0u; value <= 0xffffffffu; value = value < 100000u ? value + 1u : value + value / 100u + 1u)
+    {
+        const u32 bucket_index = duration_histogram_t::get_bucket_index(static_cast<u32>(value));
+        NETHER_CHECK(bucket_index < duration_histogram_t::NUM_BUCKETS);
+
+        // Buckets cover their value with a relative error of at most 1/64.
+        const u64 upper_bound = duration_histogram_t::get_bucket_upper_bound(bucket_index);
+        NETHER_CHECK(upper_bound >= value && upper_bound - value <= value / 64u + 1u);
+        NETHER_CHECK(bucket_index == 0u || duration_histogram_t::get_bucket_upper_bound(bucket_index - 1u) < value);
+    }
+
+    NETHER_CHECK(duration_histogram_t::get_bucket_index(0xffffffffu) == duration_histogram_t::NUM_BUCKETS - 1u);
+}
+
+NETHER_TEST(frame_statistics_histogram_percentiles)
+{
+    std::mt19937 random_engine(1u);
+    std::lognormal_distribution<f64> distribution(9.5, 0.5);
+
+    duration_histogram_t histogram{};
+    std::vector<u32> values{};
+    for (u32 i = 0u; i < 100000u; i++)
+    {
+        const u32 value = static_cast<u32>(distribution(random_engine));
+        values.push_back(value);
+        histogram.record(value);
+    }
+    std::sort(values.begin(), values.end());
+
+    for (const f32 percentile : {0.0f, 1.0f, 50.0f, 95.0f, 99.0f, 99.9f, 100.0f})
+    {
+        const u64 rank = std::max<u64>(1u, static_cast<u64>(std::ceil(percentile / 100.0 * values.size())));
+        const u32 exact_value = values[rank - 1u];
+        const u32 value = histogram.get_percentile(percentile);
+
+        NETHER_CHECK(value >= exact_value && value <= exact_value + exact_value / 64u + 1u);
+    }
+
+    NETHER_CHECK(histogram.get_min() == values.front() && histogram.get_max() == values.back());
+
+    duration_histogram_t merged_histogram{};
+    merged_histogram.merge(histogram);
+    merged_histogram.merge(histogram);
+    NETHER_CHECK(merged_histogram.get_count() == 2u * values.size());
+    NETHER_CHECK(merged_histogram.get_percentile(50.0f) == histogram.get_percentile(50.0f));
+
+    const duration_histogram_t empty_histogram{};
+    NETHER_CHECK(empty_histogram.get_percentile(50.0f) == 0u);
+    NETHER_CHECK(summarize(empty_histogram).count == 0u);
+}
+
+NETHER_TEST(frame_statistics_spsc_ring_buffer)
+{
+    constexpr u64 NUM_VALUES = 2000000u;
+
+    const std::unique_ptr<spsc_ring_buffer_t<u64, 1024u>> ring_buffer =
+        std::make_unique<spsc_ring_buffer_t<u64, 1024u>>();
+
+    // Checks can not throw on the consumer thread, so it counts values that arrive out of order.
+    u64 num_out_of_order_values = 0u;
+    std::thread consumer_thread([&]() {
+        u64 expected_value = 0u;
+        u64 value = 0u;
+        while (expected_value < NUM_VALUES)
+        {
+            if (ring_buffer->pop(value))
+            {
+                num_out_of_order_values += value != expected_value ? 1u : 0u;
+                expected_value++;
+            }
+        }
+    });
+
+    for (u64 i = 0u; i < NUM_VALUES;)
+    {
+        i += ring_buffer->push(i) ? 1u : 0u;
+    }
+    consumer_thread.join();
+
+    NETHER_CHECK(num_out_of_order_values == 0u);
+}
+
+NETHER_TEST(frame_statistics_hitches_and_export)
+{
+    static constexpr std::array<std::string_view, 2> PHASE_NAMES = {"update", "render"};
+
+    const std::filesystem::path export_directory = std::filesystem::temp_directory_path() / "nether-tests" / "frames";
+    std::filesystem::remove_all(export_directory);
+
+    job_system_t job_system(2u);
+    {
+        frame_statistics_t frame_statistics(PHASE_NAMES,
+                                            {
+                                                .window_time_in_s = 0.05f,
+                                                .hitch_ratio = 2.0f,
+                                                .export_directory = export_directory,
+                                            },
+                                            &job_system);
+
+        for (u32 i = 0u; i < 200u; i++)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(i == 150u ? 8000u : 500u));
+            frame_statistics.end_phase(0u);
+            std::this_thread::sleep_for(std::chrono::microseconds(300u));
+            frame_statistics.end_phase(1u);
+            frame_statistics.end_frame();
+        }
+
+        NETHER_CHECK(frame_statistics.get_num_frames() == 200u);
+        NETHER_CHECK(frame_statistics.get_num_hitches() >= 1u);
+        NETHER_CHECK(std::ranges::any_of(frame_statistics.get_recent_hitches(),
+                                         [](const frame_hitch_t &hitch) { return hitch.frame_index == 150u; }));
+    }
+
+    // The export is flushed when the frame statistics are destroyed.
+    std::ifstream csv_file(export_directory / "frame_statistics.csv");
+    std::string line{};
+    std::getline(csv_file, line);
+    NETHER_CHECK(line == "frame,frame_time_ms,update_ms,render_ms,hitch");
+
+    u32 num_rows = 0u;
+    while (std::getline(csv_file, line))
+    {
+        num_rows++;
+    }
+    NETHER_CHECK(num_rows >= 199u && num_rows <= 200u);
+
+    NETHER_CHECK(std::filesystem::exists(export_directory / "frame_statistics.json"));
+}
@@ -0,0 +1,204 @@
+#include "test_framework.hpp"
+
+#include "gpu_scene.hpp"
+
+#include <random>
+
+namespace
+{
+using namespace nether;
+
+gpu_scene_object_t create_object(const u32 id)
+{
+    return {
+        .model_matrix = translation_matrix({static_cast<f32>(id), 0.0f, 0.0f}),
+        .color = {static_cast<f32>(id), 1.0f, 1.0f, 1.0f},
+    };
+}
+
+// Applies the copies to a CPU side copy of the GPU buffer, as CopyBufferRegion would.
+void apply_uploads(const gpu_scene_t &gpu_scene, const std::span<const u8> staging,
+                   std::vector<gpu_scene_object_t> &gpu_objects)
+{
+    for (const gpu_scene_upload_t &upload : gpu_scene.uploads)
+    {
+        std::memcpy(reinterpret_cast<u8 *>(gpu_objects.data()) + upload.destination_offset,
+                    staging.data() + upload.staging_offset, upload.size);
+    }
+}
+} // namespace
+
+NETHER_TEST(gpu_scene_dirty_objects_are_coalesced_into_ranges)
+{
+    constexpr u32 NUM_OBJECTS = 1000u;
+    constexpr u64 RECORD_SIZE = sizeof(gpu_scene_object_t);
+
+    gpu_scene_t gpu_scene({.capacity = NUM_OBJECTS, .max_range_gap = 4u});
+    for (u32 i = 0u; i < NUM_OBJECTS; i++)
+    {
+        NETHER_CHECK(gpu_scene.add_object(create_object(i)) == i);
+    }
+
+    std::vector<u8> staging(NUM_OBJECTS * RECORD_SIZE);
+
+    // New objects are dirty.
+    NETHER_CHECK(gpu_scene.write_uploads(staging).size() == 1u);
+    NETHER_CHECK(gpu_scene.statistics.num_uploaded_bytes == NUM_OBJECTS * RECORD_SIZE);
+    NETHER_CHECK(gpu_scene.write_uploads(staging).empty());
+
+    // 10 and 14 are 3 clean objects apart and are merged, 100 is on its own, and [200, 210) is a single range.
+    for (const u32 object_index : {14u, 10u, 100u})
+    {
+        gpu_scene.set_object(object_index, create_object(object_index + NUM_OBJECTS));
+    }
+
+    for (u32 object_index = 200u; object_index < 210u; object_index++)
+    {
+        gpu_scene.set_object(object_index, create_object(object_index + NUM_OBJECTS));
+    }
+
+    const std::span<const gpu_scene_upload_t> uploads = gpu_scene.write_uploads(staging);
+    NETHER_CHECK(uploads.size() == 3u);
+    NETHER_CHECK(uploads[0].destination_offset == 10u * RECORD_SIZE && uploads[0].size == 5u * RECORD_SIZE);
+    NETHER_CHECK(uploads[1].destination_offset == 100u * RECORD_SIZE && uploads[1].size == RECORD_SIZE);
+    NETHER_CHECK(uploads[2].destination_offset == 200u * RECORD_SIZE && uploads[2].size == 10u * RECORD_SIZE);
+
+    // Ranges are back to back in the staging memory.
+    NETHER_CHECK(uploads[0].staging_offset == 0u);
+    NETHER_CHECK(uploads[1].staging_offset == 5u * RECORD_SIZE);
+    NETHER_CHECK(uploads[2].staging_offset == 6u * RECORD_SIZE);
+
+    NETHER_CHECK(gpu_scene.statistics.num_dirty_objects == 13u);
+    NETHER_CHECK(gpu_scene.statistics.num_uploaded_objects == 16u);
+    NETHER_CHECK(reinterpret_cast<const gpu_scene_object_t *>(staging.data())[4].color.x == 14.0f + NUM_OBJECTS);
+    NETHER_CHECK(reinterpret_cast<const gpu_scene_object_t *>(staging.data())[5].color.x == 100.0f + NUM_OBJECTS);
+
+    // Without merging, the 5 objects [10, 15) are 2 ranges.
+    gpu_scene_t unmerged_gpu_scene({.capacity = 64u, .max_range_gap = 0u});
+    for (u32 i = 0u; i < 64u; i++)
+    {
+        unmerged_gpu_scene.add_object(create_object(i));
+    }
+
+    unmerged_gpu_scene.write_uploads(staging);
+    unmerged_gpu_scene.set_object(10u, create_object(1u));
+    unmerged_gpu_scene.set_object(14u, create_object(1u));
+    NETHER_CHECK(unmerged_gpu_scene.write_uploads(staging).size() == 2u);
+}
+
+NETHER_TEST(gpu_scene_unchanged_objects_are_not_uploaded)
+{
+    gpu_scene_t gpu_scene({.capacity = 16u});
+    const u32 object_index = gpu_scene.add_object(create_object(1u));
+
+    std::vector<u8> staging(16u * sizeof(gpu_scene_object_t));
+    gpu_scene.write_uploads(staging);
+
+    NETHER_CHECK(!gpu_scene.update_object(object_index, create_object(1u)));
+    NETHER_CHECK(!gpu_scene.is_dirty(object_index));
+    NETHER_CHECK(gpu_scene.update_object(object_index, create_object(2u)));
+    NETHER_CHECK(gpu_scene.is_dirty(object_index));
+    NETHER_CHECK(gpu_scene.write_uploads(staging).size() == 1u);
+    NETHER_CHECK(!gpu_scene.is_dirty(object_index));
+}
+
+NETHER_TEST(gpu_scene_uploads_that_do_not_fit_are_deferred)
+{
+    constexpr u64 RECORD_SIZE = sizeof(gpu_scene_object_t);
+
+    gpu_scene_t gpu_scene({.capacity = 64u});
+    for (u32 i = 0u; i < 20u; i++)
+    {
+        gpu_scene.add_object(create_object(i));
+    }
+
+    std::vector<gpu_scene_object_t> gpu_objects(64u);
+
+    // Room for 8 records (and a half, which is not used).
+    std::vector<u8> staging(8u * RECORD_SIZE + RECORD_SIZE / 2u);
+
+    u32 num_calls = 0u;
+    do
+    {
+        gpu_scene.write_uploads(staging);
+        apply_uploads(gpu_scene, staging, gpu_objects);
+        NETHER_CHECK(gpu_scene.statistics.num_uploaded_bytes <= 8u * RECORD_SIZE);
+        num_calls++;
+    } while (gpu_scene.statistics.num_deferred_objects > 0u);
+
+    NETHER_CHECK(num_calls == 3u);
+    for (u32 i = 0u; i < 20u; i++)
+    {
+        NETHER_CHECK(gpu_objects[i].color.x == static_cast<f32>(i));
+    }
+}
+
+NETHER_TEST(gpu_scene_buffer_matches_the_objects)
+{
+    constexpr u32 CAPACITY = 20000u;
+
+    job_system_t job_system(3u);
+    gpu_scene_t gpu_scene({.capacity = CAPACITY});
+    std::vector<gpu_scene_object_t> gpu_objects(CAPACITY);
+    std::vector<u32> object_indices{};
+
+    // The staging memory is larger than a block of the parallel copy, and smaller than the whole scene.
+    std::vector<u8> staging(CAPACITY * sizeof(gpu_scene_object_t) / 2u);
+
+    std::mt19937 random_engine(5u);
+    for (u32 frame = 0u; frame < 40u; frame++)
+    {
+        // Random additions, removals and changes, from a few objects to most of the scene.
+        const u32 num_changes = 1u << (random_engine() % 15u);
+        for (u32 i = 0u; i < num_changes; i++)
+        {
+            const u32 operation = random_engine() % 8u;
+            if ((operation == 0u || object_indices.empty()) && gpu_scene.get_num_objects() < CAPACITY)
+            {
+                object_indices.push_back(gpu_scene.add_object(create_object(random_engine())));
+            }
+            else if (operation == 1u && !object_indices.empty())
+            {
+                const u32 index = random_engine() % object_indices.size();
+                gpu_scene.remove_object(object_indices[index]);
+                object_indices[index] = object_indices.back();
+                object_indices.pop_back();
+            }
+            else if (!object_indices.empty())
+            {
+                gpu_scene.set_object(object_indices[random_engine() % object_indices.size()],
+                                     create_object(random_engine()));
+            }
+        }
+
+        gpu_scene.write_uploads(staging, frame % 2u ? &job_system : nullptr);
+        apply_uploads(gpu_scene, staging, gpu_objects);
+
+        if (gpu_scene.statistics.num_deferred_objects == 0u)
+        {
+            for (const u32 object_index : object_indices)
+            {
+                NETHER_CHECK(std::memcmp(&gpu_objects[object_index], &gpu_scene.get_object(object_index),
+                                         sizeof(gpu_scene_object_t)) == 0);
+            }
+        }
+    }
+
+    NETHER_CHECK(gpu_scene.get_num_objects() == object_indices.size());
+}
+
+NETHER_TEST(gpu_scene_object_indices_are_reused)
+{
+    gpu_scene_t gpu_scene({.capacity = 2u});
+    const u32 first_object_index = gpu_scene.add_object(create_object(1u));
+    const u32 second_object_index = gpu_scene.add_object(create_object(2u));
+    NETHER_CHECK_THROWS(gpu_scene.add_object(create_object(3u)));
+
+    gpu_scene.remove_object(first_object_index);
+    NETHER_CHECK(!gpu_scene.is_dirty(first_object_index));
+    NETHER_CHECK(gpu_scene.get_num_objects() == 1u);
+    NETHER_CHECK(gpu_scene.add_object(create_object(3u)) == first_object_index);
+    NETHER_CHECK(gpu_scene.get_object(second_object_index).color.x == 2.0f);
+
+    NETHER_CHECK_THROWS(gpu_scene.remove_object(5u));
+}
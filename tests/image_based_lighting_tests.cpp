@@ -0,0 +1,375 @@
+#include "test_framework.hpp"
+
+#include "image_based_lighting.hpp"
+#include "vertex_compression.hpp"
+
+namespace
+{
+using namespace nether;
+
+constexpr f32 PI = std::numbers::pi_v<f32>;
+
+// A sky above a dimmer ground, with smooth variations in every channel.
+float3_t get_sky_radiance(const float3_t &direction)
+{
+    const f32 sky = std::max(direction.y, 0.0f);
+    return float3_t{0.2f + 2.0f * sky * sky, 0.5f + 0.5f * direction.x, 1.0f + 0.4f * direction.x * direction.z};
+}
+
+cubemap_t create_environment(const u32 size, float3_t (*const get_radiance)(const float3_t &))
+{
+    cubemap_t cubemap{.size = size};
+    for (u32 face = 0u; face < cubemap_t::NUM_FACES; face++)
+    {
+        for (u32 y = 0u; y < size; y++)
+        {
+            for (u32 x = 0u; x < size; x++)
+            {
+                cubemap.texels.push_back(
+                    get_radiance(get_cubemap_direction(face, (static_cast<f32>(x) + 0.5f) / static_cast<f32>(size),
+                                                       (static_cast<f32>(y) + 0.5f) / static_cast<f32>(size))));
+            }
+        }
+    }
+
+    return cubemap;
+}
+
+// Calls the function with the direction and solid angle of every texel of the environment's first mip.
+template <typename Function> void for_each_texel(const cubemap_t &environment, const Function &function)
+{
+    const f32 texel_size = 2.0f / static_cast<f32>(environment.size);
+    for (u32 face = 0u; face < cubemap_t::NUM_FACES; face++)
+    {
+        for (u32 y = 0u; y < environment.size; y++)
+        {
+            for (u32 x = 0u; x < environment.size; x++)
+            {
+                const f32 a = (static_cast<f32>(x) + 0.5f) * texel_size - 1.0f;
+                const f32 b = (static_cast<f32>(y) + 0.5f) * texel_size - 1.0f;
+                const f32 squared_length = 1.0f + a * a + b * b;
+
+                function(get_cubemap_direction(face, (a + 1.0f) * 0.5f, (b + 1.0f) * 0.5f),
+                         environment.texels[environment.get_texel_index(0u, face, x, y)],
+                         texel_size * texel_size / (squared_length * std::sqrt(squared_length)));
+            }
+        }
+    }
+}
+
+f32 get_ggx_distribution(const f32 n_dot_h, const f32 alpha)
+{
+    const f32 denominator = n_dot_h * n_dot_h * (alpha * alpha - 1.0f) + 1.0f;
+    return alpha * alpha / (PI * denominator * denominator);
+}
+} // namespace
+
+NETHER_TEST(ibl_hdr_image_round_trip)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "nether-tests";
+    std::filesystem::create_directories(directory);
+    const std::filesystem::path path = directory / "environment.hdr";
+
+    // Run length encoded (40 texels wide) and flat (4 texels wide) scanlines.
+    for (const u32 width : {40u, 4u})
+    {
+        hdr_image_t image{.width = width, .height = 3u};
+        for (u32 i = 0u; i < width * 3u; i++)
+        {
+            const f32 value = static_cast<f32>(i + 1u);
+            image.texels.push_back(float3_t{value * 0.01f, value, value * 100.0f});
+        }
+
+        write_hdr_image(path, image);
+        const hdr_image_t read = read_hdr_image(path);
+        NETHER_CHECK(read.width == width && read.height == 3u);
+
+        // The shared exponent keeps 8 bits of the largest channel.
+        for (u32 i = 0u; i < width * 3u; i++)
+        {
+            NETHER_CHECK_NEAR(read.texels[i].y, image.texels[i].y, image.texels[i].z / 128.0f);
+            NETHER_CHECK_NEAR(read.texels[i].z, image.texels[i].z, image.texels[i].z / 128.0f);
+        }
+    }
+
+    // A scanline of runs : 8 texels of (0.5, 0.25, 0.125).
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "#?RADIANCE\n# made by hand\n\n-Y 1 +X 8\n";
+        const std::array<u8, 12> scanline = {2u, 2u, 0u, 8u, 136u, 128u, 136u, 64u, 136u, 32u, 136u, 128u};
+        file.write(reinterpret_cast<const char *>(scanline.data()), scanline.size());
+    }
+
+    const hdr_image_t runs = read_hdr_image(path);
+    NETHER_CHECK(runs.width == 8u && runs.height == 1u);
+    for (const float3_t &texel : runs.texels)
+    {
+        NETHER_CHECK(texel.x == 0.5f && texel.y == 0.25f && texel.z == 0.125f);
+    }
+
+    // A truncated image, and a file that is not an image.
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "#?RADIANCE\n\n-Y 2 +X 2\n\x01\x02\x03";
+    }
+    NETHER_CHECK_THROWS(read_hdr_image(path));
+
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "P6\n2 2\n255\n";
+    }
+    NETHER_CHECK_THROWS(read_hdr_image(path));
+}
+
+NETHER_TEST(ibl_cubemap_from_a_panorama)
+{
+    NETHER_CHECK_NEAR(get_cubemap_direction(0u, 0.5f, 0.5f).x, 1.0f, 1e-6f);
+    NETHER_CHECK_NEAR(get_cubemap_direction(3u, 0.5f, 0.5f).y, -1.0f, 1e-6f);
+    NETHER_CHECK_NEAR(get_cubemap_direction(5u, 0.5f, 0.5f).z, -1.0f, 1e-6f);
+
+    // The top right corner of +z is the top left corner of +x (D3D's orientation).
+    const float3_t corner = get_cubemap_direction(4u, 1.0f, 0.0f);
+    const float3_t other_corner = get_cubemap_direction(0u, 0.0f, 0.0f);
+    NETHER_CHECK_NEAR(length(corner - other_corner), 0.0f, 1e-6f);
+
+    // A panorama of a smooth function of the direction converts to the cubemap of that function.
+    const auto get_radiance = [](const float3_t &direction) {
+        return float3_t{1.0f + direction.x, 1.0f + direction.y, 1.0f + direction.z};
+    };
+
+    hdr_image_t panorama{.width = 256u, .height = 128u};
+    for (u32 y = 0u; y < panorama.height; y++)
+    {
+        for (u32 x = 0u; x < panorama.width; x++)
+        {
+            const f32 phi = 2.0f * PI * (static_cast<f32>(x) + 0.5f) / static_cast<f32>(panorama.width);
+            const f32 theta = PI * (static_cast<f32>(y) + 0.5f) / static_cast<f32>(panorama.height);
+            panorama.texels.push_back(get_radiance(
+                float3_t{std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)}));
+        }
+    }
+
+    job_system_t job_system(3u);
+    cubemap_t cubemap = equirectangular_to_cubemap(panorama, 32u, &job_system);
+    const cubemap_t expected = create_environment(32u, +[](const float3_t &direction) {
+        return float3_t{1.0f + direction.x, 1.0f + direction.y, 1.0f + direction.z};
+    });
+
+    NETHER_CHECK(cubemap.size == 32u && cubemap.num_mips == 1u);
+    for (size_t i = 0u; i < cubemap.texels.size(); i++)
+    {
+        NETHER_CHECK(length(cubemap.texels[i] - expected.texels[i]) < 0.02f);
+    }
+
+    // The mips of a constant cubemap are constant.
+    generate_cubemap_mips(cubemap, &job_system);
+    NETHER_CHECK(cubemap.num_mips == 6u);
+    NETHER_CHECK(cubemap.texels.size() == cubemap.get_texel_index(5u, cubemap_t::NUM_FACES, 0u, 0u));
+
+    cubemap_t constant = create_environment(8u, +[](const float3_t &) { return float3_t{1.0f, 2.0f, 3.0f}; });
+    generate_cubemap_mips(constant);
+    NETHER_CHECK(constant.num_mips == 4u);
+    for (const float3_t &texel : constant.texels)
+    {
+        NETHER_CHECK(texel.x == 1.0f && texel.y == 2.0f && texel.z == 3.0f);
+    }
+
+    cubemap_t odd = create_environment(6u, get_sky_radiance);
+    NETHER_CHECK_THROWS(generate_cubemap_mips(odd));
+    NETHER_CHECK_THROWS(cubemap_from_faces(std::span<const hdr_image_t>(&panorama, 1u)));
+    NETHER_CHECK_THROWS(equirectangular_to_cubemap(hdr_image_t{}, 32u));
+}
+
+NETHER_TEST(ibl_irradiance_sh9_matches_a_brute_force_integration)
+{
+    // The irradiance of a constant environment is pi times its radiance.
+    const sh9_t constant = compute_irradiance_sh9(create_environment(16u, +[](const float3_t &) {
+        return float3_t{1.0f, 0.5f, 0.0f};
+    }));
+    const float3_t constant_irradiance = evaluate_sh9(constant, normalize(float3_t{0.3f, -0.5f, 0.8f}));
+    NETHER_CHECK_NEAR(constant_irradiance.x, PI, 1e-4f);
+    NETHER_CHECK_NEAR(constant_irradiance.y, PI * 0.5f, 1e-4f);
+    NETHER_CHECK_NEAR(constant_irradiance.z, 0.0f, 1e-4f);
+
+    const cubemap_t environment = create_environment(32u, get_sky_radiance);
+    job_system_t job_system(3u);
+    const sh9_t sh = compute_irradiance_sh9(environment, &job_system);
+
+    // Projections on the job system and on a single thread are identical.
+    const sh9_t single_thread_sh = compute_irradiance_sh9(environment);
+    NETHER_CHECK(std::memcmp(&sh, &single_thread_sh, sizeof(sh9_t)) == 0);
+
+    // The integral of the radiance times the clamped cosine, over every texel.
+    for (const float3_t &normal : {float3_t{0.0f, 1.0f, 0.0f}, float3_t{0.0f, -1.0f, 0.0f},
+                                   normalize(float3_t{1.0f, 0.2f, -0.4f}), normalize(float3_t{-0.3f, 0.1f, 0.9f})})
+    {
+        f64 solid_angle_sum = 0.0;
+        std::array<f64, 3> irradiance{};
+        for_each_texel(environment, [&](const float3_t &direction, const float3_t &radiance, const f32 solid_angle) {
+            const f64 weight = std::max(dot(normal, direction), 0.0f) * solid_angle;
+            irradiance[0] += radiance.x * weight;
+            irradiance[1] += radiance.y * weight;
+            irradiance[2] += radiance.z * weight;
+            solid_angle_sum += solid_angle;
+        });
+
+        const f64 scale = 4.0 * std::numbers::pi / solid_angle_sum;
+        const float3_t result = evaluate_sh9(sh, normal);
+        NETHER_CHECK_NEAR(result.x, irradiance[0] * scale, irradiance[0] * scale * 0.03 + 0.01);
+        NETHER_CHECK_NEAR(result.y, irradiance[1] * scale, irradiance[1] * scale * 0.03 + 0.01);
+        NETHER_CHECK_NEAR(result.z, irradiance[2] * scale, irradiance[2] * scale * 0.03 + 0.01);
+    }
+}
+
+NETHER_TEST(ibl_specular_prefilter_matches_a_brute_force_integration)
+{
+    job_system_t job_system(3u);
+    const specular_prefilter_settings_t settings{.size = 32u, .num_mips = 5u, .num_samples = 256u};
+
+    // A constant environment stays constant at every roughness.
+    cubemap_t constant = create_environment(64u, +[](const float3_t &) { return float3_t{1.0f, 2.0f, 3.0f}; });
+    generate_cubemap_mips(constant);
+    const cubemap_t prefiltered_constant = prefilter_specular(constant, settings, &job_system);
+    NETHER_CHECK(prefiltered_constant.size == 32u && prefiltered_constant.num_mips == 5u);
+    for (const float3_t &texel : prefiltered_constant.texels)
+    {
+        NETHER_CHECK_NEAR(texel.x, 1.0f, 1e-4f);
+        NETHER_CHECK_NEAR(texel.z, 3.0f, 1e-4f);
+    }
+
+    cubemap_t environment = create_environment(64u, get_sky_radiance);
+    generate_cubemap_mips(environment, &job_system);
+    const cubemap_t prefiltered = prefilter_specular(environment, settings, &job_system);
+
+    // Roughness 0 is the environment's mip of the same size.
+    for (u32 i = 0u; i < 6u * 32u * 32u; i++)
+    {
+        const float3_t &texel = prefiltered.texels[i];
+        const float3_t &source = environment.texels[environment.get_texel_index(1u, 0u, 0u, 0u) + i];
+        NETHER_CHECK(texel.x == source.x && texel.y == source.y && texel.z == source.z);
+    }
+
+    // With n = v = r, the prefiltered radiance is the average of the radiance weighted by D(h) * n.l.
+    for (const u32 mip : {2u, 4u})
+    {
+        const f32 roughness = static_cast<f32>(mip) / 4.0f;
+        const u32 mip_size = 32u >> mip;
+
+        for (const u32 face : {0u, 2u, 3u, 5u})
+        {
+            // The texel at the left edge of the face, half way down.
+            const float3_t normal = get_cubemap_direction(face, 0.5f / static_cast<f32>(mip_size),
+                                                          (static_cast<f32>(mip_size / 2u) + 0.5f) /
+                                                              static_cast<f32>(mip_size));
+
+            f64 weight_sum = 0.0;
+            std::array<f64, 3> radiance_sum{};
+            const auto add_texel = [&](const float3_t &direction, const float3_t &radiance, const f32 solid_angle) {
+                const f32 n_dot_l = dot(normal, direction);
+                if (n_dot_l <= 0.0f)
+                {
+                    return;
+                }
+
+                const f32 n_dot_h = dot(normal, normalize(normal + direction));
+                const f64 weight = get_ggx_distribution(n_dot_h, roughness * roughness) * n_dot_l * solid_angle;
+                radiance_sum[0] += radiance.x * weight;
+                radiance_sum[1] += radiance.y * weight;
+                radiance_sum[2] += radiance.z * weight;
+                weight_sum += weight;
+            };
+            for_each_texel(environment, add_texel);
+
+            const float3_t &texel = prefiltered.texels[prefiltered.get_texel_index(mip, face, 0u, mip_size / 2u)];
+            for (u32 channel = 0u; channel < 3u; channel++)
+            {
+                const f64 expected = radiance_sum[channel] / weight_sum;
+                NETHER_CHECK_NEAR((&texel.x)[channel], expected, expected * 0.05 + 0.01);
+            }
+        }
+    }
+
+    NETHER_CHECK_THROWS(prefilter_specular(create_environment(64u, get_sky_radiance), settings));
+    NETHER_CHECK_THROWS(prefilter_specular(environment, specular_prefilter_settings_t{.size = 32u, .num_mips = 7u}));
+    NETHER_CHECK_THROWS(prefilter_specular(environment, specular_prefilter_settings_t{.size = 128u}));
+}
+
+NETHER_TEST(ibl_brdf_lut_matches_a_brute_force_integration)
+{
+    job_system_t job_system(3u);
+    const brdf_lut_t brdf_lut = compute_brdf_lut(32u, 1024u, &job_system);
+    NETHER_CHECK(brdf_lut.size == 32u && brdf_lut.texels.size() == 32u * 32u);
+
+    // The integrals of (1 - Fc) * f / F and Fc * f / F times n.l over the hemisphere, with n = +z and v in the xz
+    // plane.
+    for (const auto &[x, y] : {std::pair{4u, 12u}, std::pair{16u, 16u}, std::pair{28u, 30u}, std::pair{1u, 24u}})
+    {
+        const f32 n_dot_v = (static_cast<f32>(x) + 0.5f) / 32.0f;
+        const f32 roughness = (static_cast<f32>(y) + 0.5f) / 32.0f;
+        const f32 alpha = roughness * roughness;
+        const f32 k = alpha * 0.5f;
+        const float3_t v{std::sqrt(1.0f - n_dot_v * n_dot_v), 0.0f, n_dot_v};
+
+        constexpr u32 NUM_THETAS = 512u;
+        constexpr u32 NUM_PHIS = 256u;
+        f64 scale = 0.0;
+        f64 bias = 0.0;
+        for (u32 i = 0u; i < NUM_THETAS; i++)
+        {
+            const f32 theta = (static_cast<f32>(i) + 0.5f) * 0.5f * PI / NUM_THETAS;
+            const f32 solid_angle = std::sin(theta) * (0.5f * PI / NUM_THETAS) * (2.0f * PI / NUM_PHIS);
+
+            for (u32 j = 0u; j < NUM_PHIS; j++)
+            {
+                const f32 phi = (static_cast<f32>(j) + 0.5f) * 2.0f * PI / NUM_PHIS;
+                const float3_t l{std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)};
+                const float3_t h = normalize(l + v);
+
+                const f32 n_dot_l = l.z;
+                const f32 geometry = n_dot_v / (n_dot_v * (1.0f - k) + k) * n_dot_l / (n_dot_l * (1.0f - k) + k);
+                const f32 brdf = get_ggx_distribution(h.z, alpha) * geometry / (4.0f * n_dot_v);
+                const f32 fresnel = std::pow(1.0f - dot(v, h), 5.0f);
+
+                scale += (1.0f - fresnel) * brdf * solid_angle;
+                bias += fresnel * brdf * solid_angle;
+            }
+        }
+
+        const float2_t &texel = brdf_lut.texels[y * 32u + x];
+        NETHER_CHECK_NEAR(texel.x, scale, 0.01);
+        NETHER_CHECK_NEAR(texel.y, bias, 0.01);
+    }
+
+    NETHER_CHECK_THROWS(compute_brdf_lut(32u, 0u));
+}
+
+NETHER_TEST(ibl_dds_files)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "nether-tests";
+    std::filesystem::create_directories(directory);
+    const std::filesystem::path path = directory / "specular.dds";
+
+    cubemap_t cubemap = create_environment(4u, get_sky_radiance);
+    generate_cubemap_mips(cubemap);
+    write_dds(path, to_dds_image(cubemap));
+
+    // Every face with its 3 mips (16 + 4 + 1 texels).
+    const dds_image_t image = read_dds(path);
+    NETHER_CHECK(image.format == dds_format_t::r16g16b16a16_float && image.is_cubemap);
+    NETHER_CHECK(image.width == 4u && image.height == 4u && image.num_mips == 3u);
+    NETHER_CHECK(image.data.size() == 6u * 21u * 8u);
+
+    const u16 *const data = reinterpret_cast<const u16 *>(image.data.data());
+    const float3_t &face_1 = cubemap.texels[cubemap.get_texel_index(0u, 1u, 0u, 0u)];
+    const float3_t &face_1_mip_2 = cubemap.texels[cubemap.get_texel_index(2u, 1u, 0u, 0u)];
+    NETHER_CHECK_NEAR(f16_to_f32(data[21u * 4u]), face_1.x, 1e-2f);
+    NETHER_CHECK_NEAR(f16_to_f32(data[21u * 4u + 2u]), face_1.z, 1e-2f);
+    NETHER_CHECK_NEAR(f16_to_f32(data[(21u + 20u) * 4u + 1u]), face_1_mip_2.y, 1e-2f);
+    NETHER_CHECK(f16_to_f32(data[21u * 4u + 3u]) == 1.0f);
+
+    const dds_image_t sh_image = to_dds_image(compute_irradiance_sh9(cubemap));
+    NETHER_CHECK(sh_image.width == 9u && sh_image.height == 1u && sh_image.data.size() == 9u * 16u);
+
+    const dds_image_t brdf_lut_image = to_dds_image(compute_brdf_lut(8u, 16u));
+    NETHER_CHECK(brdf_lut_image.format == dds_format_t::r16g16_float && brdf_lut_image.data.size() == 8u * 8u * 4u);
+}
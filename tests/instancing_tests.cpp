@@ -0,0 +1,119 @@
+#include "test_framework.hpp"
+
+#include "instancing.hpp"
+
+#include <random>
+
+namespace
+{
+using namespace nether;
+} // namespace
+
+NETHER_TEST(instancing_groups_packets_and_keeps_their_order)
+{
+    constexpr u32 NUM_DRAW_PACKETS = 100000u;
+
+    instance_batcher_t instance_batcher{};
+    std::vector<instance_data_t> instance_data(NUM_DRAW_PACKETS);
+
+    std::mt19937 random_engine(1u);
+    for (u32 i = 0u; i < NUM_DRAW_PACKETS; i++)
+    {
+        // The color identifies the packet in the instance data.
+        instance_batcher.add_draw_packet({
+            .mesh_index = static_cast<u32>(random_engine() % 50u),
+            .pipeline_index = static_cast<u32>(random_engine() % 2u),
+            .material_index = static_cast<u32>(random_engine() % 3u),
+            .color = {static_cast<f32>(i), 0.0f, 0.0f, 0.0f},
+        });
+    }
+
+    const std::span<const instanced_draw_t> instanced_draws = instance_batcher.build(instance_data);
+    NETHER_CHECK(instanced_draws.size() == 2u * 3u * 50u);
+    NETHER_CHECK(instance_batcher.statistics.num_draw_packets == NUM_DRAW_PACKETS);
+    NETHER_CHECK(instance_batcher.statistics.num_instanced_draws == instanced_draws.size());
+
+    u32 num_instances = 0u;
+    for (u32 i = 0u; i < instanced_draws.size(); i++)
+    {
+        const instanced_draw_t &instanced_draw = instanced_draws[i];
+        NETHER_CHECK(instanced_draw.first_instance == num_instances);
+        num_instances += instanced_draw.instance_count;
+
+        // Ordered by pipeline, then material.
+        if (i > 0u)
+        {
+            const instanced_draw_t &previous_draw = instanced_draws[i - 1u];
+            NETHER_CHECK(previous_draw.pipeline_index < instanced_draw.pipeline_index ||
+                         (previous_draw.pipeline_index == instanced_draw.pipeline_index &&
+                          previous_draw.material_index <= instanced_draw.material_index));
+        }
+
+        for (u32 k = 0u; k < instanced_draw.instance_count; k++)
+        {
+            const f32 draw_packet_index = instance_data[instanced_draw.first_instance + k].color.x;
+            const draw_packet_t &draw_packet = instance_batcher.draw_packets[static_cast<u32>(draw_packet_index)];
+
+            NETHER_CHECK(draw_packet.mesh_index == instanced_draw.mesh_index);
+            NETHER_CHECK(draw_packet.pipeline_index == instanced_draw.pipeline_index);
+            NETHER_CHECK(draw_packet.material_index == instanced_draw.material_index);
+
+            if (k > 0u)
+            {
+                NETHER_CHECK(draw_packet_index > instance_data[instanced_draw.first_instance + k - 1u].color.x);
+            }
+        }
+    }
+
+    NETHER_CHECK(num_instances == NUM_DRAW_PACKETS);
+}
+
+NETHER_TEST(instancing_reset_clears_packets)
+{
+    instance_batcher_t instance_batcher{};
+    std::vector<instance_data_t> instance_data(1u);
+
+    instance_batcher.add_draw_packet({.mesh_index = 1u});
+    NETHER_CHECK(instance_batcher.build(instance_data).size() == 1u);
+
+    instance_batcher.reset();
+    NETHER_CHECK(instance_batcher.build(instance_data).empty());
+}
+
+NETHER_TEST(instancing_object_indices_follow_the_instance_order)
+{
+    constexpr u32 NUM_DRAW_PACKETS = 1000u;
+
+    instance_batcher_t instance_batcher{};
+    std::mt19937 random_engine(2u);
+    for (u32 i = 0u; i < NUM_DRAW_PACKETS; i++)
+    {
+        instance_batcher.add_draw_packet({
+            .mesh_index = static_cast<u32>(random_engine() % 10u),
+            .pipeline_index = static_cast<u32>(random_engine() % 2u),
+            .color = {static_cast<f32>(i), 0.0f, 0.0f, 0.0f},
+            .object_index = i,
+        });
+    }
+
+    std::vector<instance_data_t> instance_data(NUM_DRAW_PACKETS);
+    const std::span<const instanced_draw_t> instance_data_draws = instance_batcher.build(instance_data);
+    const std::vector<instanced_draw_t> instanced_draws(instance_data_draws.begin(), instance_data_draws.end());
+
+    std::vector<u32> object_indices(NUM_DRAW_PACKETS);
+    const std::span<const instanced_draw_t> object_index_draws = instance_batcher.build(object_indices);
+
+    NETHER_CHECK(object_index_draws.size() == instanced_draws.size());
+    for (size_t i = 0u; i < instanced_draws.size(); i++)
+    {
+        NETHER_CHECK(object_index_draws[i].first_instance == instanced_draws[i].first_instance);
+        NETHER_CHECK(object_index_draws[i].instance_count == instanced_draws[i].instance_count);
+    }
+
+    for (u32 i = 0u; i < NUM_DRAW_PACKETS; i++)
+    {
+        NETHER_CHECK(static_cast<f32>(object_indices[i]) == instance_data[i].color.x);
+    }
+
+    NETHER_CHECK_THROWS(instance_batcher.build(std::span(object_indices).first(NUM_DRAW_PACKETS - 1u)));
+}
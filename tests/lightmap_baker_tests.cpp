@@ -0,0 +1,268 @@
+#include "test_framework.hpp"
+
+#include "lightmap_baker.hpp"
+
+namespace
+{
+using namespace nether;
+
+// The engine's cube, with clockwise front faces.
+constexpr std::array<float3_t, 8> CUBE_POSITIONS = {
+    float3_t{-1.0f, -1.0f, -1.0f}, float3_t{-1.0f, 1.0f, -1.0f}, float3_t{1.0f, 1.0f, -1.0f},
+    float3_t{1.0f, -1.0f, -1.0f},  float3_t{-1.0f, -1.0f, 1.0f}, float3_t{-1.0f, 1.0f, 1.0f},
+    float3_t{1.0f, 1.0f, 1.0f},    float3_t{1.0f, -1.0f, 1.0f},
+};
+
+constexpr std::array<u32, 36> CUBE_INDICES = {
+    0u, 1u, 2u, 0u, 2u, 3u, 4u, 6u, 5u, 4u, 7u, 6u, 4u, 5u, 1u, 4u, 1u, 0u,
+    3u, 2u, 6u, 3u, 6u, 7u, 1u, 5u, 6u, 1u, 6u, 2u, 4u, 0u, 3u, 4u, 3u, 7u,
+};
+
+// A square of 2 units on the xz plane, facing up (see create_plane).
+constexpr std::array<float3_t, 4> PLANE_POSITIONS = {
+    float3_t{-1.0f, 0.0f, -1.0f},
+    float3_t{-1.0f, 0.0f, 1.0f},
+    float3_t{1.0f, 0.0f, 1.0f},
+    float3_t{1.0f, 0.0f, -1.0f},
+};
+
+constexpr std::array<u32, 6> PLANE_INDICES = {0u, 1u, 2u, 0u, 2u, 3u};
+
+lightmap_mesh_t create_plane(const f32 half_size)
+{
+    return lightmap_mesh_t{
+        .positions = PLANE_POSITIONS,
+        .indices = PLANE_INDICES,
+        .model_matrix = scaling_matrix({half_size, 1.0f, half_size}),
+    };
+}
+
+// The lightmap texel of a point of the plane mesh, given as the weights of its corners 0 and 2 (on the diagonal that
+// both triangles share).
+float4_t sample_plane(const lightmap_t &lightmap, const lightmap_atlas_t &atlas, const u32 mesh_index,
+                      const f32 weight_0)
+{
+    const float2_t &uv_0 = atlas.mesh_uvs[mesh_index][0];
+    const float2_t &uv_2 = atlas.mesh_uvs[mesh_index][2];
+
+    const f32 u = uv_0.x * weight_0 + uv_2.x * (1.0f - weight_0);
+    const f32 v = uv_0.y * weight_0 + uv_2.y * (1.0f - weight_0);
+
+    const u32 x = std::min(static_cast<u32>(u * static_cast<f32>(lightmap.width)), lightmap.width - 1u);
+    const u32 y = std::min(static_cast<u32>(v * static_cast<f32>(lightmap.height)), lightmap.height - 1u);
+    return lightmap.texels[y * lightmap.width + x];
+}
+} // namespace
+
+NETHER_TEST(lightmap_unwrap_packs_disjoint_charts)
+{
+    const std::array<lightmap_mesh_t, 3> meshes = {
+        lightmap_mesh_t{.positions = CUBE_POSITIONS, .indices = CUBE_INDICES},
+        lightmap_mesh_t{
+            .positions = CUBE_POSITIONS,
+            .indices = CUBE_INDICES,
+            .model_matrix = scaling_matrix({4.0f, 0.5f, 2.0f}) * translation_matrix({0.0f, 3.0f, 0.0f}),
+        },
+        create_plane(10.0f),
+    };
+
+    const lightmap_bake_settings_t settings{.texels_per_unit = 4.0f, .atlas_width = 128u, .chart_padding = 2u};
+    const lightmap_atlas_t atlas = unwrap_lightmap(meshes, settings);
+
+    // A chart per face of the cubes, and one for the plane, each of 2 triangles.
+    NETHER_CHECK(atlas.charts.size() == 13u);
+    NETHER_CHECK(atlas.chart_triangles.size() == 26u);
+    NETHER_CHECK(atlas.width == 128u);
+
+    // The plane is 20 units wide, so its chart is 81 texels wide (plus one for the texel centers on its edges).
+    NETHER_CHECK(atlas.charts.back().width == 81u && atlas.charts.back().height == 81u);
+
+    // Charts are in the atlas, and at least the padding apart.
+    for (u32 i = 0u; i < static_cast<u32>(atlas.charts.size()); i++)
+    {
+        const lightmap_chart_t &a = atlas.charts[i];
+        NETHER_CHECK(a.num_triangles == 2u);
+        NETHER_CHECK(a.x >= settings.chart_padding && a.y >= settings.chart_padding);
+        NETHER_CHECK(a.x + a.width + settings.chart_padding <= atlas.width);
+        NETHER_CHECK(a.y + a.height + settings.chart_padding <= atlas.height);
+
+        for (u32 j = i + 1u; j < static_cast<u32>(atlas.charts.size()); j++)
+        {
+            const lightmap_chart_t &b = atlas.charts[j];
+            const bool is_apart = a.x + a.width + settings.chart_padding <= b.x ||
+                                  b.x + b.width + settings.chart_padding <= a.x ||
+                                  a.y + a.height + settings.chart_padding <= b.y ||
+                                  b.y + b.height + settings.chart_padding <= a.y;
+            NETHER_CHECK(is_apart);
+        }
+    }
+
+    // The UVs of every corner are in their chart, and the UVs of a chart keep the proportions of its triangles.
+    for (const lightmap_chart_t &chart : atlas.charts)
+    {
+        for (u32 i = chart.first_triangle; i < chart.first_triangle + chart.num_triangles; i++)
+        {
+            for (u32 corner = 0u; corner < 3u; corner++)
+            {
+                const float2_t &uv = atlas.mesh_uvs[chart.mesh_index][atlas.chart_triangles[i] * 3u + corner];
+                const f32 x = uv.x * static_cast<f32>(atlas.width);
+                const f32 y = uv.y * static_cast<f32>(atlas.height);
+
+                NETHER_CHECK(x >= static_cast<f32>(chart.x) && x <= static_cast<f32>(chart.x + chart.width));
+                NETHER_CHECK(y >= static_cast<f32>(chart.y) && y <= static_cast<f32>(chart.y + chart.height));
+            }
+        }
+    }
+
+    const std::vector<float2_t> &plane_uvs = atlas.mesh_uvs[2];
+    NETHER_CHECK_NEAR(std::abs(plane_uvs[2].x - plane_uvs[0].x) * static_cast<f32>(atlas.width), 80.0f, 1e-3f);
+    NETHER_CHECK_NEAR(std::abs(plane_uvs[2].y - plane_uvs[0].y) * static_cast<f32>(atlas.height), 80.0f, 1e-3f);
+}
+
+NETHER_TEST(lightmap_bake_of_an_open_plane_sees_the_sky)
+{
+    // Every ray of an upward plane leaves the scene, so every sample is exactly pi * the sky radiance.
+    const std::array<lightmap_mesh_t, 1> meshes = {create_plane(2.0f)};
+    const lightmap_bake_settings_t settings{
+        .atlas_width = 64u,
+        .sky_radiance = {0.5f, 1.0f, 2.0f},
+        .num_dilation_iterations = 2u,
+    };
+
+    lightmap_baker_t baker(meshes, {}, settings);
+    NETHER_CHECK(baker.statistics.num_triangles == 2u);
+    NETHER_CHECK(baker.statistics.num_texels == 17u * 17u);
+
+    NETHER_CHECK(baker.render_pass());
+    NETHER_CHECK(baker.is_converged());
+    NETHER_CHECK(baker.statistics.num_samples == settings.samples_per_pass);
+    NETHER_CHECK(baker.statistics.relative_error == 0.0f);
+    NETHER_CHECK(baker.statistics.num_rays == 17u * 17u * settings.samples_per_pass);
+
+    const lightmap_t lightmap = baker.resolve();
+    const lightmap_chart_t &chart = baker.get_atlas().charts[0];
+
+    // The chart and its dilated padding are filled, the texels further away are not.
+    const u32 first = chart.x - settings.num_dilation_iterations;
+    const u32 last = chart.x + chart.width + settings.num_dilation_iterations - 1u;
+    for (u32 x = first; x <= last; x++)
+    {
+        const float4_t &texel = lightmap.texels[chart.y * lightmap.width + x];
+        NETHER_CHECK_NEAR(texel.x, 0.5f * std::numbers::pi_v<f32>, 1e-4f);
+        NETHER_CHECK_NEAR(texel.y, 1.0f * std::numbers::pi_v<f32>, 1e-4f);
+        NETHER_CHECK_NEAR(texel.z, 2.0f * std::numbers::pi_v<f32>, 1e-4f);
+        NETHER_CHECK(texel.w == 1.0f);
+    }
+
+    NETHER_CHECK(lightmap.texels[chart.y * lightmap.width + last + 1u].w == 0.0f);
+}
+
+NETHER_TEST(lightmap_bake_of_a_shadowed_plane)
+{
+    // A cube just above the center of a plane, below a point light : the texels under the cube are in its shadow and
+    // occluded, and the texels near the plane's corners are lit as by the shaders.
+    const std::array<lightmap_mesh_t, 2> meshes = {
+        create_plane(5.0f),
+        lightmap_mesh_t{
+            .positions = CUBE_POSITIONS,
+            .indices = CUBE_INDICES,
+            .model_matrix = translation_matrix({0.0f, 1.1f, 0.0f}),
+        },
+    };
+
+    const std::array<light_t, 1> lights = {
+        light_t{.position = {0.0f, 10.0f, 0.0f}, .range = 30.0f, .color = {20.0f, 20.0f, 20.0f}},
+    };
+
+    const lightmap_bake_settings_t settings{
+        .atlas_width = 128u,
+        .max_samples = 64u,
+        .max_bounces = 0u,
+        .sky_radiance = {},
+    };
+
+    lightmap_baker_t baker(meshes, lights, settings);
+    while (!baker.render_pass())
+    {
+    }
+
+    // Without bounces and sky, the irradiance only has noise in the penumbra.
+    NETHER_CHECK(baker.statistics.num_samples < 64u);
+    NETHER_CHECK(baker.statistics.num_rays > 0u);
+
+    const lightmap_t lightmap = baker.resolve();
+
+    const float4_t under_box = sample_plane(lightmap, baker.get_atlas(), 0u, 0.5f);
+    NETHER_CHECK(under_box.x == 0.0f);
+    NETHER_CHECK(under_box.w < 0.1f);
+
+    // Near the corner (-4, 0, -4).
+    const float4_t corner = sample_plane(lightmap, baker.get_atlas(), 0u, 0.9f);
+    const f32 squared_distance = 4.0f * 4.0f * 2.0f + 10.0f * 10.0f;
+    const f32 window = 1.0f - squared_distance / (30.0f * 30.0f);
+    const f32 expected = 20.0f * window * window / squared_distance * (10.0f / std::sqrt(squared_distance));
+    NETHER_CHECK_NEAR(corner.x, expected, expected * 0.05f);
+    NETHER_CHECK(corner.w == 1.0f);
+
+    // Samples only depend on their texel and pass, so a bake on the job system gives the same lightmap.
+    job_system_t job_system(3u);
+    lightmap_baker_t parallel_baker(meshes, lights, settings, &job_system);
+    while (!parallel_baker.render_pass(&job_system))
+    {
+    }
+
+    const lightmap_t parallel_lightmap = parallel_baker.resolve(&job_system);
+    NETHER_CHECK(parallel_baker.statistics.num_rays == baker.statistics.num_rays);
+    NETHER_CHECK(std::memcmp(parallel_lightmap.texels.data(), lightmap.texels.data(),
+                             lightmap.texels.size() * sizeof(float4_t)) == 0);
+}
+
+NETHER_TEST(lightmap_file_round_trip)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "nether-tests";
+    std::filesystem::create_directories(directory);
+    const std::filesystem::path path = directory / "lightmap.dds";
+
+    lightmap_t lightmap{.width = 3u, .height = 2u};
+    for (u32 i = 0u; i < 6u; i++)
+    {
+        const f32 value = static_cast<f32>(i);
+        lightmap.texels.push_back(float4_t{value, value * 0.5f, value * 100.0f, 1.0f / (value + 1.0f)});
+    }
+
+    write_lightmap(path, lightmap);
+    NETHER_CHECK(std::filesystem::file_size(path) == 4u + 124u + 20u + 6u * 8u);
+
+    const lightmap_t read = read_lightmap(path);
+    NETHER_CHECK(read.width == 3u && read.height == 2u);
+    for (u32 i = 0u; i < 6u; i++)
+    {
+        NETHER_CHECK_NEAR(read.texels[i].x, lightmap.texels[i].x, 1e-3f);
+        NETHER_CHECK_NEAR(read.texels[i].y, lightmap.texels[i].y, 1e-3f);
+        NETHER_CHECK_NEAR(read.texels[i].z, lightmap.texels[i].z, lightmap.texels[i].z * 1e-3f);
+        NETHER_CHECK_NEAR(read.texels[i].w, lightmap.texels[i].w, 1e-3f);
+    }
+
+    // A file that is not a lightmap.
+    {
+        std::ofstream file(path, std::ios::binary);
+        const std::array<u8, 256> zeros{};
+        file.write(reinterpret_cast<const char *>(zeros.data()), zeros.size());
+    }
+    NETHER_CHECK_THROWS(read_lightmap(path));
+}
+
+NETHER_TEST(lightmap_unwrap_throws_when_the_atlas_is_too_small)
+{
+    const std::array<lightmap_mesh_t, 1> meshes = {create_plane(10.0f)};
+
+    // 81 texels wide (and as high), with the padding.
+    NETHER_CHECK_THROWS(unwrap_lightmap(meshes, lightmap_bake_settings_t{.atlas_width = 84u}));
+    NETHER_CHECK_THROWS(
+        unwrap_lightmap(meshes, lightmap_bake_settings_t{.atlas_width = 128u, .max_atlas_height = 84u}));
+    NETHER_CHECK(unwrap_lightmap(meshes, lightmap_bake_settings_t{.atlas_width = 85u, .max_atlas_height = 85u})
+                     .height == 85u);
+
+    NETHER_CHECK_THROWS(unwrap_lightmap(meshes, lightmap_bake_settings_t{.texels_per_unit = 0.0f}));
+    NETHER_CHECK_THROWS(lightmap_baker_t(meshes, {}, lightmap_bake_settings_t{.samples_per_pass = 0u}));
+}
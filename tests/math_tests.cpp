@@ -0,0 +1,71 @@
+#include "test_framework.hpp"
+
+#include "scene.hpp"
+
+namespace
+{
+using namespace nether;
+
+void check_near(const float4_t &value, const float4_t &expected)
+{
+    NETHER_CHECK_NEAR(value.x, expected.x, 1e-5f);
+    NETHER_CHECK_NEAR(value.y, expected.y, 1e-5f);
+    NETHER_CHECK_NEAR(value.z, expected.z, 1e-5f);
+    NETHER_CHECK_NEAR(value.w, expected.w, 1e-5f);
+}
+} // namespace
+
+NETHER_TEST(math_look_to_matrix)
+{
+    // Looking down -x from (5, 1, 0) : the camera's right is +z.
+    const float4x4_t view_matrix = look_to_matrix({5.0f, 1.0f, 0.0f}, {-2.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f});
+
+    check_near(transform_point({5.0f, 1.0f, 0.0f}, view_matrix), {0.0f, 0.0f, 0.0f, 1.0f});
+    check_near(transform_point({2.0f, 1.0f, 0.0f}, view_matrix), {0.0f, 0.0f, 3.0f, 1.0f});
+    check_near(transform_point({5.0f, 3.0f, 0.0f}, view_matrix), {0.0f, 2.0f, 0.0f, 1.0f});
+    check_near(transform_point({5.0f, 1.0f, 1.0f}, view_matrix), {1.0f, 0.0f, 0.0f, 1.0f});
+}
+
+NETHER_TEST(math_perspective_reverse_z_matrix)
+{
+    constexpr f32 NEAR_PLANE = 0.1f;
+    const float4x4_t projection_matrix = perspective_reverse_z_matrix(to_radians(90.0f), 2.0f, NEAR_PLANE);
+
+    // Depth is 1 at the near plane, and goes to 0 at infinity.
+    const float4_t near_point = transform_point({0.0f, 0.0f, NEAR_PLANE}, projection_matrix);
+    NETHER_CHECK_NEAR(near_point.z / near_point.w, 1.0f, 1e-6f);
+
+    const float4_t far_point = transform_point({0.0f, 0.0f, 1.0e6f}, projection_matrix);
+    NETHER_CHECK_NEAR(far_point.z / far_point.w, 0.0f, 1e-6f);
+
+    // With a 90 degree field of view, the top of the frustum is at y = z, and the right at x = z * aspect_ratio.
+    const float4_t corner_point = transform_point({20.0f, 10.0f, 10.0f}, projection_matrix);
+    NETHER_CHECK_NEAR(corner_point.x / corner_point.w, 1.0f, 1e-5f);
+    NETHER_CHECK_NEAR(corner_point.y / corner_point.w, 1.0f, 1e-5f);
+}
+
+NETHER_TEST(math_camera_update)
+{
+    scene::camera_component_t camera{.target_yaw = to_radians(90.0f)};
+
+    for (u32 i = 0u; i < 2000u; i++)
+    {
+        scene::update_camera(camera, camera.front, 1.0f);
+    }
+
+    // The camera has turned to +x, and moves along it at full speed.
+    NETHER_CHECK_NEAR(camera.front.x, 1.0f, 1e-3f);
+    NETHER_CHECK_NEAR(camera.right.z, -1.0f, 1e-3f);
+    NETHER_CHECK_NEAR(length(camera.velocity), 1.0f, 1e-3f);
+    NETHER_CHECK_NEAR(camera.velocity.x, 1.0f, 1e-2f);
+
+    // Without input the camera comes to a stop.
+    for (u32 i = 0u; i < 2000u; i++)
+    {
+        scene::update_camera(camera, {}, 1.0f);
+    }
+    NETHER_CHECK_NEAR(length(camera.velocity), 0.0f, 1e-3f);
+
+    // The camera's position ends up at the origin of its view space.
+    check_near(transform_point(camera.position, scene::get_view_matrix(camera)), {0.0f, 0.0f, 0.0f, 1.0f});
+}
@@ -0,0 +1,114 @@
+#include "test_framework.hpp"
+
+#include "memory.hpp"
+
+namespace
+{
+using namespace nether;
+} // namespace
+
+NETHER_TEST(memory_linear_arena_alignment_and_rewind)
+{
+    memory::linear_arena_t arena(1024u);
+
+    const u8 *const first = static_cast<u8 *>(arena.allocate(3u, 1u));
+    const u8 *const second = static_cast<u8 *>(arena.allocate(8u, 16u));
+    NETHER_CHECK(reinterpret_cast<uintptr_t>(second) % 16u == 0u);
+    NETHER_CHECK(second > first);
+
+    const memory::linear_arena_t::marker_t marker = arena.get_marker();
+    arena.allocate(100u);
+    arena.rewind(marker);
+    NETHER_CHECK(arena.get_marker() == marker);
+
+    if constexpr (memory::POISON_MEMORY)
+    {
+        const u8 *const poisoned = static_cast<u8 *>(arena.allocate(4u));
+        NETHER_CHECK(poisoned[0] == memory::ALLOCATED_MEMORY_PATTERN);
+        arena.rewind(marker);
+        NETHER_CHECK(poisoned[0] == memory::FREED_MEMORY_PATTERN);
+    }
+
+    NETHER_CHECK_THROWS(arena.allocate(2000u));
+
+    arena.reset();
+    NETHER_CHECK(arena.get_statistics().used == 0u);
+    NETHER_CHECK(arena.get_statistics().peak_used >= 100u);
+}
+
+NETHER_TEST(memory_linear_arena_as_container_allocator)
+{
+    memory::linear_arena_t arena(1024u);
+
+    std::pmr::vector<i32> pmr_values(&arena);
+    for (i32 i = 0; i < 50; i++)
+    {
+        pmr_values.push_back(i);
+    }
+    NETHER_CHECK(pmr_values[49] == 49);
+
+    arena.reset();
+
+    std::vector<i32, memory::arena_allocator_t<i32>> values{memory::arena_allocator_t<i32>(arena)};
+    for (i32 i = 0; i < 50; i++)
+    {
+        values.push_back(i);
+    }
+    NETHER_CHECK(values[10] == 10);
+}
+
+NETHER_TEST(memory_scratch_scopes_nest)
+{
+    u8 *inner_allocation = nullptr;
+    {
+        memory::scratch_scope_t scope{};
+        scope.get_arena().allocate(64u);
+        {
+            memory::scratch_scope_t inner_scope{};
+            inner_allocation = static_cast<u8 *>(inner_scope.get_arena().allocate(8u));
+        }
+
+        // The inner scope's memory is reused once it ends.
+        NETHER_CHECK(static_cast<u8 *>(scope.get_arena().allocate(8u)) == inner_allocation);
+    }
+
+    NETHER_CHECK(memory::get_scratch_arena().get_marker() == 0u);
+}
+
+NETHER_TEST(memory_pool_allocator_blocks)
+{
+    memory::pool_allocator_t pool(24u, 8u, 4u);
+
+    std::array<void *, 10> blocks{};
+    for (void *&block : blocks)
+    {
+        block = pool.allocate();
+    }
+
+    NETHER_CHECK(pool.statistics.num_chunks == 3u);
+    NETHER_CHECK(pool.statistics.num_allocated_blocks == 10u);
+    for (u32 i = 0u; i < blocks.size(); i++)
+    {
+        for (u32 j = i + 1u; j < blocks.size(); j++)
+        {
+            NETHER_CHECK(blocks[i] != blocks[j]);
+        }
+    }
+
+    // Freed blocks are reused first.
+    pool.deallocate(blocks[3]);
+    NETHER_CHECK(pool.allocate() == blocks[3]);
+
+    struct object_t
+    {
+        i32 a{};
+        f64 b{};
+    };
+
+    object_t *const object = pool.create<object_t>(object_t{1, 2.0});
+    NETHER_CHECK(object->a == 1 && object->b == 2.0);
+    pool.destroy(object);
+
+    // The block size is fixed.
+    NETHER_CHECK_THROWS(static_cast<void>(pool.allocate(64u, 8u)));
+}
@@ -0,0 +1,98 @@
+#include "test_framework.hpp"
+
+#include "occlusion_culling.hpp"
+
+#include <random>
+
+namespace
+{
+using namespace nether;
+
+constexpr std::array<float3_t, 8> BOX_POSITIONS = {
+    float3_t{-1.0f, -1.0f, -1.0f}, float3_t{-1.0f, 1.0f, -1.0f}, float3_t{1.0f, 1.0f, -1.0f},
+    float3_t{1.0f, -1.0f, -1.0f},  float3_t{-1.0f, -1.0f, 1.0f}, float3_t{-1.0f, 1.0f, 1.0f},
+    float3_t{1.0f, 1.0f, 1.0f},    float3_t{1.0f, -1.0f, 1.0f},
+};
+
+constexpr std::array<u16, 36> BOX_INDICES = {0u, 1u, 2u, 0u, 2u, 3u, 4u, 6u, 5u, 4u, 7u, 6u, 4u, 5u, 1u, 4u, 1u, 0u,
+                                             3u, 2u, 6u, 3u, 6u, 7u, 1u, 5u, 6u, 1u, 6u, 2u, 4u, 0u, 3u, 4u, 3u, 7u};
+
+// A camera at the origin looking down +z.
+float4x4_t get_view_projection_matrix()
+{
+    return perspective_reverse_z_matrix(to_radians(45.0f), 16.0f / 9.0f, 0.1f);
+}
+} // namespace
+
+NETHER_TEST(occlusion_culling_wall_hides_boxes_behind_it)
+{
+    occlusion_culler_t occlusion_culler(384u, 216u);
+    occlusion_culler.begin_frame(get_view_projection_matrix());
+
+    // A 4x4 wall at z = 10.
+    occlusion_culler.add_occluder(BOX_POSITIONS, BOX_INDICES,
+                                  scaling_matrix({2.0f, 2.0f, 0.5f}) * translation_matrix({0.0f, 0.0f, 10.0f}));
+    occlusion_culler.rasterize();
+
+    NETHER_CHECK(occlusion_culler.statistics.num_rasterized_triangles > 0u);
+    NETHER_CHECK(occlusion_culler.get_depth(192u, 108u) > 0.0f);
+    NETHER_CHECK(occlusion_culler.get_depth(0u, 0u) == 0.0f);
+
+    // The wall covers |x| and |y| up to about 4.2 at z = 20, so boxes behind it are only visible if they stick out.
+    NETHER_CHECK(!occlusion_culler.is_visible({{-1.0f, -1.0f, 20.0f}, {1.0f, 1.0f, 22.0f}}));
+    NETHER_CHECK(!occlusion_culler.is_visible({{-3.0f, -3.0f, 20.0f}, {3.0f, 3.0f, 22.0f}}));
+    NETHER_CHECK(occlusion_culler.is_visible({{-1.0f, -1.0f, 5.0f}, {1.0f, 1.0f, 6.0f}}));
+    NETHER_CHECK(occlusion_culler.is_visible({{4.0f, -1.0f, 20.0f}, {6.0f, 1.0f, 22.0f}}));
+    NETHER_CHECK(occlusion_culler.is_visible({{3.0f, -1.0f, 20.0f}, {4.5f, 1.0f, 22.0f}}));
+    NETHER_CHECK(occlusion_culler.is_visible({{-5.0f, -3.0f, 20.0f}, {3.0f, 3.0f, 22.0f}}));
+
+    // Boxes crossing the near plane are always visible, boxes behind the camera never are.
+    NETHER_CHECK(occlusion_culler.is_visible({{-1.0f, -1.0f, -1.0f}, {1.0f, 1.0f, 1.0f}}));
+    NETHER_CHECK(!occlusion_culler.is_visible({{-1.0f, -1.0f, -5.0f}, {1.0f, 1.0f, -4.0f}}));
+}
+
+NETHER_TEST(occlusion_culling_parallel_matches_serial)
+{
+    job_system_t job_system{};
+
+    std::mt19937 random_engine(1u);
+    std::uniform_real_distribution<f32> distribution(-50.0f, 50.0f);
+    std::uniform_real_distribution<f32> depth_distribution(5.0f, 200.0f);
+
+    std::vector<float4x4_t> occluder_matrices{};
+    for (u32 i = 0u; i < 200u; i++)
+    {
+        occluder_matrices.push_back(scaling_matrix({3.0f, 3.0f, 3.0f}) *
+                                    translation_matrix({distribution(random_engine) * 0.5f,
+                                                        distribution(random_engine) * 0.2f,
+                                                        depth_distribution(random_engine) * 0.3f + 5.0f}));
+    }
+
+    std::vector<aabb_t> occludee_bounds(10000u);
+    for (aabb_t &bounds : occludee_bounds)
+    {
+        const float3_t center = {distribution(random_engine), distribution(random_engine) * 0.5f,
+                                 depth_distribution(random_engine)};
+        bounds = {center - float3_t{0.5f, 0.5f, 0.5f}, center + float3_t{0.5f, 0.5f, 0.5f}};
+    }
+
+    const auto test_occludees = [&](job_system_t *const job_system) {
+        occlusion_culler_t occlusion_culler(384u, 216u);
+        occlusion_culler.begin_frame(get_view_projection_matrix());
+        for (const float4x4_t &occluder_matrix : occluder_matrices)
+        {
+            occlusion_culler.add_occluder(BOX_POSITIONS, BOX_INDICES, occluder_matrix);
+        }
+        occlusion_culler.rasterize(job_system);
+
+        std::vector<u8> visibility(occludee_bounds.size());
+        occlusion_culler.test_occludees(occludee_bounds, visibility, job_system);
+
+        NETHER_CHECK(occlusion_culler.statistics.num_occludees_tested == occludee_bounds.size());
+        NETHER_CHECK(occlusion_culler.statistics.num_occluded > 0u);
+
+        return visibility;
+    };
+
+    NETHER_CHECK(test_occludees(nullptr) == test_occludees(&job_system));
+}
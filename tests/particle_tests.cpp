@@ -0,0 +1,258 @@
+#include "test_framework.hpp"
+
+#include "particles.hpp"
+
+// The AVX2 integration is compared against a scalar integration of the same particles, which evaluates every force
+// field separately.
+namespace
+{
+using namespace nether;
+
+struct scalar_particle_t
+{
+    float3_t position{};
+    float3_t velocity{};
+    f32 age{};
+};
+
+scalar_particle_t get_particle(const particle_pool_t &pool, const u32 index)
+{
+    return scalar_particle_t{
+        .position = {pool.position_x[index], pool.position_y[index], pool.position_z[index]},
+        .velocity = {pool.velocity_x[index], pool.velocity_y[index], pool.velocity_z[index]},
+        .age = pool.age[index],
+    };
+}
+
+void integrate_scalar(scalar_particle_t &particle, const std::span<const force_field_t> force_fields,
+                      const f32 delta_time)
+{
+    float3_t acceleration{};
+    for (const force_field_t &field : force_fields)
+    {
+        if (field.type == force_field_type_t::directional)
+        {
+            acceleration = acceleration + field.vector * field.strength;
+        }
+        else if (field.type == force_field_type_t::point)
+        {
+            const float3_t offset = field.vector - particle.position;
+            const f32 distance = length(offset);
+            const f32 falloff = std::max(1.0f - distance / field.radius, 0.0f);
+            acceleration = acceleration + offset * (field.strength * falloff / std::max(distance, 1e-6f));
+        }
+        else
+        {
+            acceleration = acceleration - particle.velocity * field.strength;
+        }
+    }
+
+    particle.velocity = particle.velocity + acceleration * delta_time;
+    particle.position = particle.position + particle.velocity * delta_time;
+    particle.age += delta_time;
+}
+
+particle_emitter_desc_t create_emitter_desc(const u32 seed)
+{
+    return particle_emitter_desc_t{
+        .position = {static_cast<f32>(seed), 0.0f, 0.0f},
+        .direction = {0.0f, 1.0f, 0.0f},
+        .spread_angle_in_radians = 0.6f,
+        .emission_radius = 0.5f,
+        .min_speed = 2.0f,
+        .max_speed = 4.0f,
+        .min_lifetime_in_s = 0.5f,
+        .max_lifetime_in_s = 1.5f,
+        .emission_rate = 6000.0f,
+        .max_particles = 5003u,
+        .start_color = {1.0f, 0.5f, 0.0f, 1.0f},
+        .end_color = {0.0f, 0.0f, 1.0f, 0.0f},
+        .start_size = 0.2f,
+        .end_size = 0.0f,
+        .seed = seed,
+    };
+}
+
+const std::array<force_field_t, 4> FORCE_FIELDS = {
+    force_field_t{.type = force_field_type_t::directional, .vector = {0.0f, -1.0f, 0.0f}, .strength = 9.81f},
+    force_field_t{.type = force_field_type_t::point, .vector = {1.0f, 2.0f, 0.0f}, .strength = 20.0f, .radius = 3.0f},
+    force_field_t{.type = force_field_type_t::point, .vector = {-1.0f, 1.0f, 1.0f}, .strength = -5.0f, .radius = 1.0f},
+    force_field_t{.type = force_field_type_t::drag, .strength = 0.3f},
+};
+} // namespace
+
+NETHER_TEST(particles_integration_matches_scalar)
+{
+    particle_system_t particle_system{};
+    particle_emitter_desc_t desc = create_emitter_desc(1u);
+    desc.min_lifetime_in_s = 100.0f;
+    desc.max_lifetime_in_s = 100.0f;
+    particle_system.add_emitter(desc);
+
+    particle_system.update(0.5f);
+    const particle_pool_t &pool = particle_system.emitters[0].pool;
+    NETHER_CHECK(pool.count == 3000u);
+
+    particle_system.force_fields.assign(FORCE_FIELDS.begin(), FORCE_FIELDS.end());
+
+    // Nothing dies, so the particles keep their indices and the new ones are appended.
+    for (u32 step = 0u; step < 4u; step++)
+    {
+        std::vector<scalar_particle_t> expected_particles(pool.count);
+        for (u32 i = 0u; i < pool.count; i++)
+        {
+            expected_particles[i] = get_particle(pool, i);
+            integrate_scalar(expected_particles[i], FORCE_FIELDS, 1.0f / 60.0f);
+        }
+
+        particle_system.update(1.0f / 60.0f);
+
+        for (u32 i = 0u; i < expected_particles.size(); i++)
+        {
+            const scalar_particle_t particle = get_particle(pool, i);
+            NETHER_CHECK_NEAR(particle.position.x, expected_particles[i].position.x, 1e-5f);
+            NETHER_CHECK_NEAR(particle.position.y, expected_particles[i].position.y, 1e-5f);
+            NETHER_CHECK_NEAR(particle.position.z, expected_particles[i].position.z, 1e-5f);
+            NETHER_CHECK_NEAR(particle.velocity.x, expected_particles[i].velocity.x, 1e-4f);
+            NETHER_CHECK_NEAR(particle.velocity.y, expected_particles[i].velocity.y, 1e-4f);
+            NETHER_CHECK_NEAR(particle.velocity.z, expected_particles[i].velocity.z, 1e-4f);
+            NETHER_CHECK_NEAR(particle.age, expected_particles[i].age, 1e-6f);
+        }
+    }
+}
+
+NETHER_TEST(particles_dead_particles_are_removed)
+{
+    particle_system_t particle_system{};
+    particle_system.add_emitter(create_emitter_desc(2u));
+
+    u32 previous_count = 0u;
+    for (u32 frame = 0u; frame < 240u; frame++)
+    {
+        particle_system.update(1.0f / 60.0f);
+
+        const particle_pool_t &pool = particle_system.emitters[0].pool;
+        NETHER_CHECK(pool.count <= 5003u);
+        NETHER_CHECK(pool.count == previous_count + particle_system.statistics.num_emitted_particles -
+                                       particle_system.statistics.num_killed_particles);
+        previous_count = pool.count;
+
+        // Only the particles emitted this frame can have an age of 0, and none have outlived their lifetime.
+        for (u32 i = 0u; i < pool.count; i++)
+        {
+            NETHER_CHECK(pool.age[i] < pool.lifetime[i]);
+            NETHER_CHECK(pool.lifetime[i] >= 0.5f && pool.lifetime[i] <= 1.5f);
+        }
+    }
+
+    // After the longest lifetime, particles die as fast as they are emitted : 6000 per second, with an average
+    // lifetime of 1 second, but at most 5003 of them.
+    NETHER_CHECK(particle_system.statistics.num_killed_particles > 0u);
+    NETHER_CHECK(particle_system.get_num_particles() > 4000u);
+}
+
+NETHER_TEST(particles_emission_rate)
+{
+    particle_system_t particle_system{};
+    particle_emitter_desc_t desc = create_emitter_desc(3u);
+    desc.emission_rate = 90.0f;
+    desc.min_lifetime_in_s = 100.0f;
+    desc.max_lifetime_in_s = 100.0f;
+    particle_system.add_emitter(desc);
+
+    // 1.5 particles per frame : the fractional particles carry over to the next frame.
+    for (u32 frame = 0u; frame < 60u; frame++)
+    {
+        particle_system.update(1.0f / 60.0f);
+    }
+    NETHER_CHECK(particle_system.get_num_particles() == 90u || particle_system.get_num_particles() == 89u);
+
+    // Particles that do not fit are dropped.
+    particle_system.emitters[0].desc.emission_rate = 1e6f;
+    particle_system.update(1.0f / 60.0f);
+    NETHER_CHECK(particle_system.get_num_particles() == desc.max_particles);
+    particle_system.update(1.0f / 60.0f);
+    NETHER_CHECK(particle_system.statistics.num_emitted_particles == 0u);
+}
+
+NETHER_TEST(particles_parallel_matches_serial)
+{
+    job_system_t job_system(3u);
+
+    particle_system_t serial_particle_system{};
+    particle_system_t parallel_particle_system{};
+    for (u32 i = 0u; i < 5u; i++)
+    {
+        particle_emitter_desc_t desc = create_emitter_desc(10u + i);
+        desc.max_particles = 3000u + 7000u * i;
+        desc.emission_rate = 2000.0f * static_cast<f32>(i + 1u);
+
+        serial_particle_system.add_emitter(desc);
+        parallel_particle_system.add_emitter(desc);
+    }
+    serial_particle_system.force_fields.assign(FORCE_FIELDS.begin(), FORCE_FIELDS.end());
+    parallel_particle_system.force_fields.assign(FORCE_FIELDS.begin(), FORCE_FIELDS.end());
+
+    for (u32 frame = 0u; frame < 120u; frame++)
+    {
+        serial_particle_system.update(1.0f / 60.0f);
+        parallel_particle_system.update(1.0f / 60.0f, &job_system);
+    }
+
+    const u32 num_particles = serial_particle_system.get_num_particles();
+    NETHER_CHECK(num_particles > particle_system_t::CHUNK_SIZE * 2u);
+    NETHER_CHECK(parallel_particle_system.get_num_particles() == num_particles);
+
+    std::vector<particle_vertex_t> serial_vertices(serial_particle_system.get_max_particles());
+    std::vector<particle_vertex_t> parallel_vertices(parallel_particle_system.get_max_particles());
+    NETHER_CHECK(serial_particle_system.write_vertices(serial_vertices) == num_particles);
+    NETHER_CHECK(parallel_particle_system.write_vertices(parallel_vertices, &job_system) == num_particles);
+
+    NETHER_CHECK(std::memcmp(serial_vertices.data(), parallel_vertices.data(),
+                             num_particles * sizeof(particle_vertex_t)) == 0);
+}
+
+NETHER_TEST(particles_write_vertices)
+{
+    particle_system_t particle_system{};
+    particle_system.add_emitter(create_emitter_desc(4u));
+    particle_system.add_emitter(create_emitter_desc(5u));
+    particle_system.update(0.1f);
+    particle_system.update(0.25f);
+
+    const u32 num_particles = particle_system.get_num_particles();
+    std::vector<particle_vertex_t> vertices(num_particles);
+    NETHER_CHECK(particle_system.write_vertices(vertices) == num_particles);
+
+    // The second emitter's particles follow the first's.
+    u32 vertex_index = 0u;
+    for (const particle_emitter_t &emitter : particle_system.emitters)
+    {
+        const particle_pool_t &pool = emitter.pool;
+        for (u32 i = 0u; i < pool.count; i++)
+        {
+            const particle_vertex_t &vertex = vertices[vertex_index++];
+            const f32 t = pool.age[i] / pool.lifetime[i];
+
+            NETHER_CHECK(vertex.position.x == pool.position_x[i]);
+            NETHER_CHECK(vertex.position.y == pool.position_y[i]);
+            NETHER_CHECK(vertex.position.z == pool.position_z[i]);
+            NETHER_CHECK_NEAR(vertex.size, 0.2f * (1.0f - t), 1e-6f);
+
+            // start_color = (1, 0.5, 0, 1), end_color = (0, 0, 1, 0).
+            const f32 expected_channels[4] = {1.0f - t, 0.5f * (1.0f - t), t, 1.0f - t};
+            for (u32 channel = 0u; channel < 4u; channel++)
+            {
+                const f32 value = static_cast<f32>((vertex.color >> (channel * 8u)) & 0xffu);
+                NETHER_CHECK_NEAR(value, expected_channels[channel] * 255.0f, 0.51f);
+            }
+        }
+    }
+
+    std::vector<particle_vertex_t> too_few_vertices(num_particles - 1u);
+    NETHER_CHECK_THROWS(particle_system.write_vertices(too_few_vertices));
+
+    particle_emitter_desc_t invalid_desc = create_emitter_desc(6u);
+    invalid_desc.max_particles = 0u;
+    NETHER_CHECK_THROWS(particle_system.add_emitter(invalid_desc));
+}
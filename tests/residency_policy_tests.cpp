@@ -0,0 +1,88 @@
+#include "test_framework.hpp"
+
+#include "residency_policy.hpp"
+
+namespace
+{
+using namespace nether;
+
+constexpr u64 MEBIBYTE = 1024u * 1024u;
+} // namespace
+
+NETHER_TEST(residency_policy_evicts_least_recently_used)
+{
+    residency_policy_t residency_policy{};
+    const u32 a = residency_policy.register_resource(10u, 0u);
+    const u32 b = residency_policy.register_resource(10u, 0u);
+    const u32 c = residency_policy.register_resource(10u, 0u);
+
+    // 30 bytes with a budget of 20 : b is the only resource that was not used this frame.
+    residency_policy.mark_used(a, 5u);
+    residency_policy.mark_used(c, 5u);
+    const residency_changes_t &changes = residency_policy.update(5u, 20u);
+    NETHER_CHECK(changes.evicted_resources.size() == 1u && changes.evicted_resources[0] == b);
+    NETHER_CHECK(!residency_policy.is_resident(b));
+
+    residency_policy.mark_used(b, 10u);
+    const residency_changes_t &next_changes = residency_policy.update(10u, 20u);
+    NETHER_CHECK(next_changes.resident_resources.size() == 1u);
+    NETHER_CHECK(residency_policy.is_resident(b));
+    NETHER_CHECK(next_changes.evicted_resources.size() == 2u);
+    NETHER_CHECK(next_changes.evicted_resources[0] == a && next_changes.evicted_resources[1] == c);
+
+    // Handles are reused once unregistered.
+    residency_policy.unregister_resource(c);
+    NETHER_CHECK(residency_policy.statistics.num_resources == 2u);
+    NETHER_CHECK(residency_policy.statistics.resident_bytes == 10u);
+    NETHER_CHECK(residency_policy.register_resource(5u, 11u) == c);
+    NETHER_CHECK(residency_policy.statistics.get_hit_rate() < 1.0);
+}
+
+NETHER_TEST(residency_policy_hysteresis)
+{
+    residency_policy_t residency_policy{};
+    for (u32 i = 0u; i < 10u; i++)
+    {
+        residency_policy.register_resource(10u, 0u);
+    }
+
+    // Under the high watermark nothing is evicted, over it enough is evicted to get back to the low watermark.
+    NETHER_CHECK(residency_policy.update(10u, 106u).evicted_resources.empty());
+    NETHER_CHECK(residency_policy.update(10u, 100u).evicted_resources.size() == 2u);
+}
+
+NETHER_TEST(residency_policy_keeps_used_resources_resident)
+{
+    constexpr u32 NUM_RESOURCES = 4000u;
+    constexpr u32 NUM_FRAMES = 2000u;
+
+    residency_policy_t residency_policy{};
+    std::vector<u32> handles{};
+    for (u32 i = 0u; i < NUM_RESOURCES; i++)
+    {
+        handles.push_back(residency_policy.register_resource(MEBIBYTE, 0u));
+    }
+    residency_policy.update(0u, 600u * MEBIBYTE);
+
+    // A sliding window, like a camera moving through a streamed world.
+    for (u32 frame_index = 1u; frame_index <= NUM_FRAMES; frame_index++)
+    {
+        const u32 window_start = frame_index % 3600u;
+        for (u32 i = 0u; i < 400u; i++)
+        {
+            residency_policy.mark_used(handles[window_start + i], frame_index);
+        }
+
+        const residency_changes_t &changes = residency_policy.update(frame_index, 600u * MEBIBYTE);
+        for (u32 i = 0u; i < 400u; i++)
+        {
+            NETHER_CHECK(residency_policy.is_resident(handles[window_start + i]));
+        }
+        for (const u32 evicted_resource : changes.evicted_resources)
+        {
+            NETHER_CHECK(evicted_resource < handles[window_start] || evicted_resource >= handles[window_start] + 400u);
+        }
+    }
+
+    NETHER_CHECK(residency_policy.statistics.resident_bytes <= 600u * MEBIBYTE);
+}
@@ -0,0 +1,165 @@
+#include "test_framework.hpp"
+
+#include "shader_archive.hpp"
+
+namespace
+{
+using namespace nether;
+
+constexpr u32 NUM_SHADERS = 2000u;
+
+std::filesystem::path get_test_directory()
+{
+    const std::filesystem::path test_directory = std::filesystem::temp_directory_path() / "nether-tests";
+    std::filesystem::create_directories(test_directory);
+
+    return test_directory;
+}
+
+void write_file(const std::filesystem::path &path, const std::span<const u8> data)
+{
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+struct test_archive_t
+{
+    std::vector<std::vector<u8>> bytecodes{};
+    std::vector<u64> keys{};
+
+    shader_archive_writer_t writer{SHADER_ARCHIVE_FLAG_DEBUG};
+};
+
+// Random bytecode, where every fourth shader is a copy of the previous one.
+test_archive_t create_test_archive()
+{
+    test_archive_t test_archive{};
+    test_archive.bytecodes.resize(NUM_SHADERS);
+
+    std::mt19937 random_engine(1u);
+    for (u32 i = 0u; i < NUM_SHADERS; i++)
+    {
+        if (i % 4u == 3u)
+        {
+            test_archive.bytecodes[i] = test_archive.bytecodes[i - 1u];
+        }
+        else
+        {
+            test_archive.bytecodes[i].resize(2000u + random_engine() % 6000u);
+            for (u8 &value : test_archive.bytecodes[i])
+            {
+                value = static_cast<u8>(random_engine());
+            }
+        }
+
+        const u64 key = get_shader_archive_key(L"shaders/shader_" + std::to_wstring(i / 16u) + L".hlsl",
+                                               i % 2u ? L"ps_6_6" : L"vs_6_6", L"main", i % 16u);
+        test_archive.keys.push_back(key);
+        test_archive.writer.add(key, test_archive.bytecodes[i],
+                                {
+                                    .shader_path = "shader.hlsl",
+                                    .target_profile = "vs_6_6",
+                                    .entry_point = "main",
+                                    .defines = "A B",
+                                    .permutation_mask = i,
+                                });
+    }
+
+    return test_archive;
+}
+
+bool throws_on_open(const std::filesystem::path &path)
+{
+    try
+    {
+        const shader_archive_t shader_archive(path);
+    }
+    catch (const std::runtime_error &)
+    {
+        return true;
+    }
+
+    return false;
+}
+} // namespace
+
+NETHER_TEST(shader_archive_keys)
+{
+    NETHER_CHECK(get_shader_archive_key(L"shaders\\a.hlsl", L"vs_6_6", L"main", 1u) ==
+                 get_shader_archive_key(L"shaders/a.hlsl", L"vs_6_6", L"main", 1u));
+    NETHER_CHECK(get_shader_archive_key(L"ab", L"c", L"main", 1u) != get_shader_archive_key(L"a", L"bc", L"main", 1u));
+    NETHER_CHECK(get_shader_archive_key(L"a", L"b", L"main", 1u) != get_shader_archive_key(L"a", L"b", L"main", 2u));
+}
+
+NETHER_TEST(shader_archive_round_trip)
+{
+    const test_archive_t test_archive = create_test_archive();
+    NETHER_CHECK(test_archive.writer.get_num_entries() == NUM_SHADERS);
+    NETHER_CHECK(test_archive.writer.get_num_blobs() == NUM_SHADERS - NUM_SHADERS / 4u);
+
+    const std::filesystem::path archive_path = get_test_directory() / "shader_archive.bin";
+    test_archive.writer.write(archive_path);
+
+    const shader_archive_t shader_archive(archive_path);
+    NETHER_CHECK(shader_archive.get_num_entries() == NUM_SHADERS);
+    NETHER_CHECK(shader_archive.get_flags() == SHADER_ARCHIVE_FLAG_DEBUG);
+
+    for (u32 i = 0u; i < NUM_SHADERS; i++)
+    {
+        const u32 entry_index = shader_archive.find(test_archive.keys[i]);
+        NETHER_CHECK(entry_index != shader_archive_t::INVALID_ENTRY_INDEX);
+
+        const std::span<const u8> bytecode = shader_archive.get_bytecode(entry_index);
+        NETHER_CHECK(std::ranges::equal(bytecode, test_archive.bytecodes[i]));
+        NETHER_CHECK(reinterpret_cast<uintptr_t>(bytecode.data()) % shader_archive_writer_t::BLOB_ALIGNMENT == 0u);
+
+        const shader_archive_metadata_t metadata = shader_archive.get_metadata(entry_index);
+        NETHER_CHECK(metadata.permutation_mask == i);
+        NETHER_CHECK(metadata.shader_path == "shader.hlsl" && metadata.entry_point == "main");
+        NETHER_CHECK(metadata.defines == "A B");
+    }
+
+    NETHER_CHECK(shader_archive.find(12345u) == shader_archive_t::INVALID_ENTRY_INDEX);
+}
+
+NETHER_TEST(shader_archive_duplicate_keys_throw)
+{
+    const std::vector<u8> bytecode(16u, 1u);
+
+    shader_archive_writer_t writer{};
+    writer.add(1u, bytecode, {});
+    writer.add(1u, bytecode, {});
+
+    NETHER_CHECK_THROWS(writer.build());
+}
+
+NETHER_TEST(shader_archive_corrupted_files_throw)
+{
+    const std::vector<u8> archive = create_test_archive().writer.build();
+    const std::filesystem::path archive_path = get_test_directory() / "corrupted_shader_archive.bin";
+
+    // Wrong magic.
+    std::vector<u8> corrupted_archive = archive;
+    corrupted_archive[0] ^= 1u;
+    write_file(archive_path, corrupted_archive);
+    NETHER_CHECK(throws_on_open(archive_path));
+
+    // Truncated.
+    corrupted_archive = archive;
+    corrupted_archive.resize(corrupted_archive.size() - 64u);
+    write_file(archive_path, corrupted_archive);
+    NETHER_CHECK(throws_on_open(archive_path));
+
+    // Keys out of order.
+    corrupted_archive = archive;
+    std::swap_ranges(corrupted_archive.begin() + sizeof(shader_archive_header_t),
+                     corrupted_archive.begin() + sizeof(shader_archive_header_t) + sizeof(u64),
+                     corrupted_archive.begin() + sizeof(shader_archive_header_t) + sizeof(u64));
+    write_file(archive_path, corrupted_archive);
+    NETHER_CHECK(throws_on_open(archive_path));
+
+    // Empty and missing files.
+    write_file(archive_path, {});
+    NETHER_CHECK(throws_on_open(archive_path));
+    NETHER_CHECK(throws_on_open(get_test_directory() / "missing_shader_archive.bin"));
+}
@@ -0,0 +1,165 @@
+#include "test_framework.hpp"
+
+#include "task_graph.hpp"
+
+#include <thread>
+
+// Checks that fail inside a task throw, which execute rethrows once the graph has completed.
+namespace
+{
+using namespace nether;
+
+void sleep_for_ms(const u32 duration_in_ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_in_ms));
+}
+
+void check_dependency_order(job_system_t *const job_system)
+{
+    std::array<std::atomic<u32>, 8> completion_order{};
+    std::atomic<u32> num_completed_tasks{0u};
+    const auto complete = [&](const u32 task_index) { completion_order[task_index] = num_completed_tasks++; };
+
+    task_graph_t task_graph{};
+    const auto device = task_graph.add_task("device", {}, [&]() {
+        sleep_for_ms(20u);
+        complete(0u);
+    });
+    const auto queue = task_graph.add_task("queue", {device}, [&]() {
+        sleep_for_ms(5u);
+        complete(1u);
+    });
+    const auto heaps = task_graph.add_task("heaps", {device}, [&]() {
+        sleep_for_ms(5u);
+        complete(2u);
+    });
+    const auto root_signature = task_graph.add_task("root signature", {device}, [&]() {
+        sleep_for_ms(5u);
+        complete(3u);
+    });
+    const auto shaders = task_graph.add_task("shaders", {}, [&]() {
+        sleep_for_ms(40u);
+        complete(4u);
+    });
+    const auto swapchain = task_graph.add_task(
+        "swapchain", {queue, heaps},
+        [&]() {
+            NETHER_CHECK(job_system_t::get_thread_index() == 0u);
+            complete(5u);
+        },
+        task_affinity_t::calling_thread);
+    const auto pipelines = task_graph.add_task("pipelines", {root_signature, shaders}, [&]() {
+        sleep_for_ms(10u);
+        complete(6u);
+    });
+    task_graph.add_task("end", {swapchain, pipelines}, [&]() { complete(7u); });
+
+    task_graph.execute(job_system);
+
+    NETHER_CHECK(completion_order[0] < completion_order[1] && completion_order[0] < completion_order[2] &&
+                 completion_order[0] < completion_order[3]);
+    NETHER_CHECK(completion_order[1] < completion_order[5] && completion_order[2] < completion_order[5]);
+    NETHER_CHECK(completion_order[3] < completion_order[6] && completion_order[4] < completion_order[6]);
+    NETHER_CHECK(completion_order[5] < completion_order[7] && completion_order[6] < completion_order[7]);
+
+    const task_graph_report_t &report = task_graph.get_report();
+    NETHER_CHECK(report.critical_path.size() == 3u);
+    NETHER_CHECK(report.critical_path[0] == shaders && report.critical_path[1] == pipelines);
+    if (job_system)
+    {
+        NETHER_CHECK(report.wall_time_in_ms < report.serial_time_in_ms);
+    }
+}
+} // namespace
+
+NETHER_TEST(task_graph_runs_tasks_after_their_dependencies)
+{
+    job_system_t job_system(3u);
+
+    check_dependency_order(nullptr);
+    check_dependency_order(&job_system);
+}
+
+NETHER_TEST(task_graph_skips_dependents_of_failed_tasks)
+{
+    job_system_t job_system(2u);
+
+    bool ran_dependent_task = false;
+    bool ran_independent_task = false;
+
+    task_graph_t task_graph{};
+    const auto failing_task = task_graph.add_task("fail", {}, []() { throw std::runtime_error("Task failed"); });
+    const auto dependent_task = task_graph.add_task("dependent", {failing_task}, [&]() { ran_dependent_task = true; });
+    task_graph.add_task("indirectly dependent", {dependent_task}, [&]() { ran_dependent_task = true; });
+    task_graph.add_task("independent", {}, [&]() { ran_independent_task = true; });
+
+    NETHER_CHECK_THROWS(task_graph.execute(&job_system));
+    NETHER_CHECK(!ran_dependent_task && ran_independent_task);
+    NETHER_CHECK(task_graph.get_report().tasks[1].skipped && task_graph.get_report().tasks[2].skipped);
+}
+
+NETHER_TEST(task_graph_rejects_unknown_dependencies)
+{
+    task_graph_t task_graph{};
+    NETHER_CHECK_THROWS(task_graph.add_task("task", {0u}, []() {}));
+
+    // The graph is still usable.
+    task_graph.execute();
+}
+
+NETHER_TEST(task_graph_random_graphs)
+{
+    job_system_t job_system(3u);
+    std::mt19937 random_engine(3u);
+
+    for (u32 i = 0u; i < 200u; i++)
+    {
+        const u32 num_tasks = 1u + random_engine() % 40u;
+
+        std::vector<std::atomic<bool>> completed(num_tasks);
+        std::vector<std::vector<u32>> dependencies(num_tasks);
+
+        task_graph_t task_graph{};
+        for (u32 task_index = 0u; task_index < num_tasks; task_index++)
+        {
+            for (u32 dependency = 0u; dependency < task_index && dependencies[task_index].size() < 2u; dependency++)
+            {
+                if (random_engine() % 5u == 0u)
+                {
+                    dependencies[task_index].push_back(dependency);
+                }
+            }
+
+            const auto function = [&, task_index]() {
+                for (const u32 dependency : dependencies[task_index])
+                {
+                    NETHER_CHECK(completed[dependency].load());
+                }
+                completed[task_index] = true;
+            };
+            const task_affinity_t affinity =
+                random_engine() % 4u == 0u ? task_affinity_t::calling_thread : task_affinity_t::any_thread;
+
+            switch (dependencies[task_index].size())
+            {
+            case 0u:
+                task_graph.add_task("task", {}, function, affinity);
+                break;
+            case 1u:
+                task_graph.add_task("task", {dependencies[task_index][0]}, function, affinity);
+                break;
+            default:
+                task_graph.add_task("task", {dependencies[task_index][0], dependencies[task_index][1]}, function,
+                                    affinity);
+                break;
+            }
+        }
+
+        task_graph.execute(&job_system);
+
+        for (u32 task_index = 0u; task_index < num_tasks; task_index++)
+        {
+            NETHER_CHECK(completed[task_index].load());
+        }
+    }
+}
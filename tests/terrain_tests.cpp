@@ -0,0 +1,309 @@
+#include "test_framework.hpp"
+
+#include "terrain.hpp"
+
+// A 65^2 heightmap split into tiles of 16 quads (3 depths, 4 x 4 leaves). A default frustum_t has no planes, so every
+// node is inside it.
+namespace
+{
+using namespace nether;
+
+constexpr u32 TILE_RESOLUTION = 16u;
+constexpr u32 HEIGHTMAP_SIZE = 4u * TILE_RESOLUTION + 1u;
+
+constexpr terrain_archive_desc_t ARCHIVE_DESC = {
+    .tile_resolution = TILE_RESOLUTION,
+    .sample_spacing = 2.0f,
+    .height_scale = 100.0f,
+};
+
+// Rolling hills with noise on top, so that every inner node has a non zero error.
+std::vector<u16> create_heightmap()
+{
+    std::vector<u16> heights(HEIGHTMAP_SIZE * HEIGHTMAP_SIZE);
+
+    std::mt19937 random_engine(3u);
+    for (u32 z = 0u; z < HEIGHTMAP_SIZE; z++)
+    {
+        for (u32 x = 0u; x < HEIGHTMAP_SIZE; x++)
+        {
+            const f32 hills = 0.5f + 0.3f * std::sin(0.15f * x) * std::cos(0.1f * z);
+            const f32 noise = 0.05f * static_cast<f32>(random_engine() % 1000u) / 1000.0f;
+            heights[z * HEIGHTMAP_SIZE + x] = static_cast<u16>((hills + noise) * 65535.0f);
+        }
+    }
+
+    return heights;
+}
+
+std::filesystem::path write_test_archive(const std::vector<u16> &heights)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "nether-tests" / "terrain.bin";
+    std::filesystem::create_directories(path.parent_path());
+    write_terrain_archive(path, heights, HEIGHTMAP_SIZE, ARCHIVE_DESC);
+
+    return path;
+}
+
+// Selects and streams until no tile is missing for the view (or max_updates is reached).
+void stream_all_tiles(terrain_t &terrain, const terrain_view_t &view, const u32 max_updates = 100u)
+{
+    for (u32 update = 0u; update < max_updates; update++)
+    {
+        terrain.select_patches(view);
+        terrain.stream_tiles();
+        if (terrain.statistics.num_requested_tiles == 0u)
+        {
+            return;
+        }
+    }
+}
+
+// Height of the node's surface at a sample of the full resolution heightmap, interpolated over the node's triangles
+// (split along the diagonal from the quad's first sample, as the shader's index buffer does).
+f32 get_node_surface_height(const std::vector<u16> &heights, const u32 stride, const u32 sample_x, const u32 sample_z)
+{
+    const u32 quad_x = std::min(sample_x / stride, (HEIGHTMAP_SIZE - 1u) / stride - 1u) * stride;
+    const u32 quad_z = std::min(sample_z / stride, (HEIGHTMAP_SIZE - 1u) / stride - 1u) * stride;
+    const f32 a = static_cast<f32>(sample_x - quad_x) / stride;
+    const f32 b = static_cast<f32>(sample_z - quad_z) / stride;
+
+    const auto get_height = [&](const u32 x, const u32 z) {
+        return static_cast<f32>(heights[z * HEIGHTMAP_SIZE + x]);
+    };
+
+    const f32 h00 = get_height(quad_x, quad_z);
+    const f32 h10 = get_height(quad_x + stride, quad_z);
+    const f32 h01 = get_height(quad_x, quad_z + stride);
+    const f32 h11 = get_height(quad_x + stride, quad_z + stride);
+
+    return a >= b ? h00 + a * (h10 - h00) + b * (h11 - h10) : h00 + b * (h01 - h00) + a * (h11 - h01);
+}
+} // namespace
+
+NETHER_TEST(terrain_node_bounds_and_errors)
+{
+    const std::vector<u16> heights = create_heightmap();
+    const terrain_t terrain(write_test_archive(heights), terrain_settings_t{});
+
+    const terrain_archive_header_t &header = terrain.get_header();
+    NETHER_CHECK(header.num_depths == 3u);
+    NETHER_CHECK(header.num_nodes == 21u);
+
+    const f32 height_to_world = ARCHIVE_DESC.height_scale / 65535.0f;
+    for (u32 depth = 0u; depth < header.num_depths; depth++)
+    {
+        const u32 stride = 1u << (header.num_depths - 1u - depth);
+        for (u32 z = 0u; z < (1u << depth); z++)
+        {
+            for (u32 x = 0u; x < (1u << depth); x++)
+            {
+                const terrain_node_t &node = terrain.get_node(terrain_t::get_node_index(depth, x, z));
+
+                // The node's height range is the range of the full resolution samples it covers, and its error is at
+                // least the largest difference between its surface and them.
+                f32 min_height = std::numeric_limits<f32>::max();
+                f32 max_height = std::numeric_limits<f32>::lowest();
+                f32 max_error = 0.0f;
+                for (u32 sample_z = z * TILE_RESOLUTION * stride; sample_z <= (z + 1u) * TILE_RESOLUTION * stride;
+                     sample_z++)
+                {
+                    for (u32 sample_x = x * TILE_RESOLUTION * stride;
+                         sample_x <= (x + 1u) * TILE_RESOLUTION * stride; sample_x++)
+                    {
+                        const f32 height = heights[sample_z * HEIGHTMAP_SIZE + sample_x];
+                        min_height = std::min(min_height, height * height_to_world);
+                        max_height = std::max(max_height, height * height_to_world);
+
+                        const f32 surface_height = get_node_surface_height(heights, stride, sample_x, sample_z);
+                        max_error = std::max(max_error, std::abs(surface_height - height) * height_to_world);
+                    }
+                }
+
+                NETHER_CHECK_NEAR(node.min_height, min_height, 1e-4f);
+                NETHER_CHECK_NEAR(node.max_height, max_height, 1e-4f);
+                NETHER_CHECK(node.geometric_error >= max_error - 1e-4f);
+                NETHER_CHECK(depth + 1u < header.num_depths ? node.geometric_error > 0.0f
+                                                             : node.geometric_error == 0.0f);
+            }
+        }
+    }
+}
+
+NETHER_TEST(terrain_streamed_tiles_match_heightmap)
+{
+    const std::vector<u16> heights = create_heightmap();
+    const std::filesystem::path path = write_test_archive(heights);
+    terrain_t terrain(path, terrain_settings_t{.cache_capacity_in_tiles = 32u});
+
+    // An error scale this large refines every node, down to the leaves.
+    stream_all_tiles(terrain, terrain_view_t{.camera_position = {64.0f, 500.0f, 64.0f},
+                                             .screen_space_error_scale = 1e9f});
+
+    const terrain_archive_header_t &header = terrain.get_header();
+    NETHER_CHECK(terrain.statistics.num_resident_tiles == header.num_nodes);
+    NETHER_CHECK(terrain.patches.size() == 16u);
+    NETHER_CHECK(terrain.get_tile_storage_size() ==
+                 terrain_t::get_tile_storage_size(read_terrain_archive_header(path),
+                                                  terrain_settings_t{.cache_capacity_in_tiles = 32u}));
+
+    for (u32 depth = 0u; depth < header.num_depths; depth++)
+    {
+        const u32 stride = 1u << (header.num_depths - 1u - depth);
+        for (u32 z = 0u; z < (1u << depth); z++)
+        {
+            for (u32 x = 0u; x < (1u << depth); x++)
+            {
+                const u32 node_index = terrain_t::get_node_index(depth, x, z);
+                NETHER_CHECK(terrain.is_resident(node_index));
+
+                const std::span<const u16> tile = terrain.get_tile(node_index);
+                bool tile_matches = true;
+                for (u32 sample_z = 0u; sample_z <= TILE_RESOLUTION; sample_z++)
+                {
+                    for (u32 sample_x = 0u; sample_x <= TILE_RESOLUTION; sample_x++)
+                    {
+                        const u32 heightmap_x = (x * TILE_RESOLUTION + sample_x) * stride;
+                        const u32 heightmap_z = (z * TILE_RESOLUTION + sample_z) * stride;
+                        tile_matches &= tile[sample_z * (TILE_RESOLUTION + 1u) + sample_x] ==
+                                        heights[heightmap_z * HEIGHTMAP_SIZE + heightmap_x];
+                    }
+                }
+                NETHER_CHECK(tile_matches);
+            }
+        }
+    }
+
+    for (const terrain_patch_t &patch : terrain.patches)
+    {
+        NETHER_CHECK(patch.depth == header.num_depths - 1u);
+        NETHER_CHECK(patch.sample_spacing == ARCHIVE_DESC.sample_spacing);
+        NETHER_CHECK(patch.first_sample % terrain.get_slot_stride() == 0u);
+        NETHER_CHECK(patch.first_sample < terrain.get_tile_storage_size());
+    }
+}
+
+NETHER_TEST(terrain_patches_cover_terrain_once)
+{
+    const std::vector<u16> heights = create_heightmap();
+    terrain_t terrain(write_test_archive(heights),
+                      terrain_settings_t{.origin = {-10.0f, 5.0f, 20.0f}, .max_screen_space_error_in_pixels = 64.0f});
+
+    // A camera above a corner : the patches get coarser away from it.
+    const terrain_view_t view = {
+        .camera_position = {-10.0f, 120.0f, 20.0f},
+        .screen_space_error_scale = get_screen_space_error_scale(
+            perspective_reverse_z_matrix(to_radians(60.0f), 16.0f / 9.0f, 0.1f), 1080.0f),
+    };
+    stream_all_tiles(terrain, view);
+
+    NETHER_CHECK(terrain.statistics.num_requested_tiles == 0u);
+
+    // Count how many patches cover each quad of the full resolution heightmap.
+    std::vector<u32> coverage((HEIGHTMAP_SIZE - 1u) * (HEIGHTMAP_SIZE - 1u));
+    std::array<u32, 3> num_patches_per_depth{};
+    for (const terrain_patch_t &patch : terrain.patches)
+    {
+        num_patches_per_depth[patch.depth]++;
+
+        const u32 stride = static_cast<u32>(patch.sample_spacing / ARCHIVE_DESC.sample_spacing);
+        const u32 first_x = static_cast<u32>((patch.origin.x + 10.0f) / ARCHIVE_DESC.sample_spacing);
+        const u32 first_z = static_cast<u32>((patch.origin.y - 20.0f) / ARCHIVE_DESC.sample_spacing);
+        for (u32 z = first_z; z < first_z + TILE_RESOLUTION * stride; z++)
+        {
+            for (u32 x = first_x; x < first_x + TILE_RESOLUTION * stride; x++)
+            {
+                coverage[z * (HEIGHTMAP_SIZE - 1u) + x]++;
+            }
+        }
+    }
+
+    NETHER_CHECK(std::ranges::all_of(coverage, [](const u32 count) { return count == 1u; }));
+
+    // Detailed patches near the camera, and coarser ones further away.
+    NETHER_CHECK(num_patches_per_depth[2] > 0u);
+    NETHER_CHECK(num_patches_per_depth[1] > 0u);
+
+    // Patches that were not refined are detailed enough for the view.
+    for (const terrain_patch_t &patch : terrain.patches)
+    {
+        const u32 x = static_cast<u32>((patch.origin.x + 10.0f) / (patch.sample_spacing * TILE_RESOLUTION));
+        const u32 z = static_cast<u32>((patch.origin.y - 20.0f) / (patch.sample_spacing * TILE_RESOLUTION));
+        const aabb_t bounds = terrain.get_node_bounds(patch.depth, x, z);
+        const float3_t closest_point = min(max(view.camera_position, bounds.min), bounds.max);
+        const f32 distance = std::max(length(view.camera_position - closest_point), 1e-3f);
+
+        const terrain_node_t &node = terrain.get_node(terrain_t::get_node_index(patch.depth, x, z));
+        NETHER_CHECK(node.geometric_error * view.screen_space_error_scale / distance <= 64.0f ||
+                     patch.depth == terrain.get_header().num_depths - 1u);
+    }
+}
+
+NETHER_TEST(terrain_cache_stays_bounded)
+{
+    const std::vector<u16> heights = create_heightmap();
+    terrain_t terrain(write_test_archive(heights),
+                      terrain_settings_t{.cache_capacity_in_tiles = 9u, .eviction_delay_in_updates = 1u});
+
+    // The camera sweeps over the terrain, so tiles keep being evicted and reloaded.
+    u32 num_evicted_tiles = 0u;
+    for (u32 update = 0u; update < 200u; update++)
+    {
+        const f32 t = static_cast<f32>(update) / 200.0f;
+        terrain.select_patches(terrain_view_t{.camera_position = {128.0f * t, 20.0f, 128.0f * (1.0f - t)},
+                                              .screen_space_error_scale = 20.0f});
+        terrain.stream_tiles();
+        num_evicted_tiles += terrain.statistics.num_evicted_tiles;
+
+        NETHER_CHECK(terrain.statistics.num_resident_tiles <= 9u);
+
+        // Every resident tile has a resident parent.
+        bool parents_resident = true;
+        for (u32 depth = 1u; depth < terrain.get_header().num_depths; depth++)
+        {
+            for (u32 z = 0u; z < (1u << depth); z++)
+            {
+                for (u32 x = 0u; x < (1u << depth); x++)
+                {
+                    parents_resident &= !terrain.is_resident(terrain_t::get_node_index(depth, x, z)) ||
+                                        terrain.is_resident(terrain_t::get_node_index(depth - 1u, x / 2u, z / 2u));
+                }
+            }
+        }
+        NETHER_CHECK(parents_resident);
+
+        for (const terrain_patch_t &patch : terrain.patches)
+        {
+            NETHER_CHECK(patch.first_sample < terrain.get_tile_storage_size());
+        }
+    }
+
+    NETHER_CHECK(num_evicted_tiles > 0u);
+    NETHER_CHECK(terrain.is_resident(0u));
+}
+
+NETHER_TEST(terrain_invalid_inputs_throw)
+{
+    const std::vector<u16> heights = create_heightmap();
+    const std::filesystem::path path = write_test_archive(heights);
+
+    // 64 = 16 * 4 quads, but 65 samples per side are needed.
+    NETHER_CHECK_THROWS(write_terrain_archive(path.parent_path() / "invalid_terrain.bin",
+                                              std::span(heights).first(64u * 64u), 64u, ARCHIVE_DESC));
+    NETHER_CHECK_THROWS(write_terrain_archive(path.parent_path() / "invalid_terrain.bin", heights, 65u,
+                                              terrain_archive_desc_t{.tile_resolution = 48u}));
+
+    NETHER_CHECK_THROWS(terrain_t(path, terrain_settings_t{.cache_capacity_in_tiles = 4u}));
+
+    std::vector<u16> too_small_storage(16u);
+    NETHER_CHECK_THROWS(terrain_t(path, terrain_settings_t{}, too_small_storage));
+
+    // Truncated archive.
+    {
+        std::ofstream file(path.parent_path() / "invalid_terrain.bin", std::ios::binary);
+        const terrain_archive_header_t header = {.magic = TERRAIN_ARCHIVE_MAGIC, .version = TERRAIN_ARCHIVE_VERSION};
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    }
+    NETHER_CHECK_THROWS(terrain_t(path.parent_path() / "invalid_terrain.bin", terrain_settings_t{}));
+    NETHER_CHECK_THROWS(terrain_t(path.parent_path() / "missing_terrain.bin", terrain_settings_t{}));
+}
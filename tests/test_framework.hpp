@@ -0,0 +1,84 @@
+#pragma once
+
+#include "common.hpp"
+
+// A minimal unit test framework. Tests are functions registered with NETHER_TEST. A failed check throws, which fails
+// the test (and skips the rest of it), and the runner moves on to the next test.
+namespace nether::tests
+{
+using test_function_t = void (*)();
+
+struct test_t
+{
+    std::string name{};
+    test_function_t function{};
+};
+
+// Every test registered with NETHER_TEST, in registration order.
+std::vector<test_t> &get_tests();
+
+struct test_registrar_t
+{
+    test_registrar_t(const std::string_view name, const test_function_t function)
+    {
+        get_tests().push_back({.name = std::string(name), .function = function});
+    }
+};
+
+class check_failure_t : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+inline void check(const bool condition, const std::string_view expression,
+                  const std::source_location source_location = std::source_location::current())
+{
+    if (!condition)
+    {
+        throw check_failure_t(
+            std::format("{}:{} : check failed : {}", source_location.file_name(), source_location.line(), expression));
+    }
+}
+
+inline void check_near(const f64 value, const f64 expected, const f64 tolerance, const std::string_view expression,
+                       const std::source_location source_location = std::source_location::current())
+{
+    if (!(std::abs(value - expected) <= tolerance))
+    {
+        throw check_failure_t(std::format("{}:{} : check failed : {} (got {}, expected {} +- {})",
+                                          source_location.file_name(), source_location.line(), expression, value,
+                                          expected, tolerance));
+    }
+}
+} // namespace nether::tests
+
+#define NETHER_TEST(name)                                                                                              \
+    static void name();                                                                                                \
+    static const nether::tests::test_registrar_t name##_registrar(#name, name);                                       \
+    static void name()
+
+#define NETHER_CHECK(expression) nether::tests::check(static_cast<bool>(expression), #expression)
+
+#define NETHER_CHECK_NEAR(value, expected, tolerance)                                                                  \
+    nether::tests::check_near((value), (expected), (tolerance), #value " == " #expected)
+
+// Checks that the expression throws a std::runtime_error.
+#define NETHER_CHECK_THROWS(expression)                                                                                \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        bool threw = false;                                                                                            \
+        try                                                                                                            \
+        {                                                                                                              \
+            expression;                                                                                                \
+        }                                                                                                              \
+        catch (const nether::tests::check_failure_t &)                                                                 \
+        {                                                                                                              \
+            throw;                                                                                                     \
+        }                                                                                                              \
+        catch (const std::runtime_error &)                                                                             \
+        {                                                                                                              \
+            threw = true;                                                                                              \
+        }                                                                                                              \
+        nether::tests::check(threw, #expression " throws");                                                            \
+    } while (false)
@@ -0,0 +1,45 @@
+#include "test_framework.hpp"
+
+// Runs the tests registered with NETHER_TEST. Usage : nether-tests [filter], where only the tests whose name contains
+// filter are run. Returns 1 if a test failed.
+namespace nether::tests
+{
+std::vector<test_t> &get_tests()
+{
+    static std::vector<test_t> tests{};
+    return tests;
+}
+} // namespace nether::tests
+
+int main(int argc, char **argv)
+{
+    const std::string_view filter = argc > 1 ? argv[1] : "";
+
+    u32 num_tests = 0u;
+    u32 num_failed_tests = 0u;
+
+    for (const nether::tests::test_t &test : nether::tests::get_tests())
+    {
+        if (test.name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        num_tests++;
+
+        try
+        {
+            test.function();
+            std::cout << std::format("[ passed ] {}", test.name) << std::endl;
+        }
+        catch (std::exception &e)
+        {
+            num_failed_tests++;
+            std::cout << std::format("[ FAILED ] {} :: {}", test.name, e.what()) << std::endl;
+        }
+    }
+
+    std::cout << std::format("{} of {} tests passed", num_tests - num_failed_tests, num_tests) << std::endl;
+
+    return num_failed_tests > 0u ? 1 : 0;
+}
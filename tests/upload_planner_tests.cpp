@@ -0,0 +1,113 @@
+#include "test_framework.hpp"
+
+#include "upload_planner.hpp"
+
+#include <random>
+
+// Random requests are planned, and the plan is executed on the CPU (staging writes, then copies) to check that every
+// request ends up at its placement.
+namespace
+{
+using namespace nether;
+
+void check_upload_plan(const std::span<const upload_request_t> upload_requests, const upload_planner_config_t &config,
+                       std::mt19937 &random_engine)
+{
+    std::vector<std::vector<u8>> sources(upload_requests.size());
+    for (u32 i = 0u; i < upload_requests.size(); i++)
+    {
+        sources[i].resize(upload_requests[i].size);
+        for (u8 &value : sources[i])
+        {
+            value = static_cast<u8>(random_engine());
+        }
+    }
+
+    const upload_plan_t upload_plan = plan_uploads(upload_requests, config);
+    NETHER_CHECK(upload_plan.placements.size() == upload_requests.size());
+
+    std::vector<std::vector<u8>> destination_buffers(upload_plan.destination_buffer_sizes.size());
+    for (u32 i = 0u; i < destination_buffers.size(); i++)
+    {
+        destination_buffers[i].assign(upload_plan.destination_buffer_sizes[i], 0xabu);
+    }
+
+    for (u32 i = 0u; i < upload_requests.size(); i++)
+    {
+        const upload_placement_t &placement = upload_plan.placements[i];
+        NETHER_CHECK(placement.destination_offset % std::max<u64>(upload_requests[i].alignment, 1u) == 0u);
+        NETHER_CHECK(placement.destination_offset + upload_requests[i].size <=
+                     upload_plan.destination_buffer_sizes[placement.destination_buffer_index]);
+    }
+
+    std::vector<u8> staging_buffer(config.staging_buffer_size);
+    for (const upload_batch_t &batch : upload_plan.batches)
+    {
+        NETHER_CHECK(batch.staging_size <= config.staging_buffer_size);
+
+        // Garbage from the previous batch must not leak into this one.
+        for (u8 &value : staging_buffer)
+        {
+            value = static_cast<u8>(random_engine());
+        }
+
+        for (u32 i = batch.first_staging_write; i < batch.first_staging_write + batch.num_staging_writes; i++)
+        {
+            const staging_write_t &staging_write = upload_plan.staging_writes[i];
+            NETHER_CHECK(staging_write.staging_offset + staging_write.size <= batch.staging_size);
+
+            std::memcpy(&staging_buffer[staging_write.staging_offset],
+                        &sources[staging_write.request_index][staging_write.source_offset], staging_write.size);
+        }
+
+        for (u32 i = batch.first_copy; i < batch.first_copy + batch.num_copies; i++)
+        {
+            const upload_copy_t &copy = upload_plan.copies[i];
+            NETHER_CHECK(copy.staging_offset + copy.size <= batch.staging_size);
+            NETHER_CHECK(copy.destination_offset + copy.size <=
+                         destination_buffers[copy.destination_buffer_index].size());
+
+            std::memcpy(&destination_buffers[copy.destination_buffer_index][copy.destination_offset],
+                        &staging_buffer[copy.staging_offset], copy.size);
+        }
+    }
+
+    for (u32 i = 0u; i < upload_requests.size(); i++)
+    {
+        const upload_placement_t &placement = upload_plan.placements[i];
+        NETHER_CHECK(upload_requests[i].size == 0u ||
+                     std::memcmp(&destination_buffers[placement.destination_buffer_index][placement.destination_offset],
+                                 sources[i].data(), upload_requests[i].size) == 0);
+    }
+}
+} // namespace
+
+NETHER_TEST(upload_planner_random_requests)
+{
+    std::mt19937 random_engine(7u);
+
+    constexpr std::array<u64, 6> ALIGNMENTS = {1u, 2u, 4u, 12u, 16u, 256u};
+
+    for (u32 i = 0u; i < 300u; i++)
+    {
+        const upload_planner_config_t config = {
+            .staging_buffer_size = 64u + random_engine() % 4096u,
+            .destination_buffer_size = 128u + random_engine() % 8192u,
+        };
+
+        // Mostly small requests, some larger than the staging buffer (which are split over several batches), and
+        // some empty ones.
+        std::vector<upload_request_t> upload_requests(random_engine() % 60u);
+        for (upload_request_t &upload_request : upload_requests)
+        {
+            upload_request.size = random_engine() % 10u == 0u ? random_engine() % 20000u : random_engine() % 300u;
+            if (random_engine() % 20u == 0u)
+            {
+                upload_request.size = 0u;
+            }
+            upload_request.alignment = ALIGNMENTS[random_engine() % ALIGNMENTS.size()];
+        }
+
+        check_upload_plan(upload_requests, config, random_engine);
+    }
+}
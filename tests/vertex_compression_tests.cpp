@@ -0,0 +1,217 @@
+#include "test_framework.hpp"
+
+#include "vertex_compression.hpp"
+
+#include <random>
+
+namespace
+{
+using namespace nether;
+
+f32 get_angle(const float3_t &a, const float3_t &b)
+{
+    return std::atan2(length(cross(a, b)), dot(a, b));
+}
+
+// Random unit vectors, plus the poles and the diagonals of the lower hemisphere, where the octahedral encoding folds.
+std::vector<float3_t> create_directions(const u32 count)
+{
+    std::vector<float3_t> directions = {
+        {0.0f, 0.0f, 1.0f},   {0.0f, 0.0f, -1.0f},  {1.0f, 0.0f, 0.0f},  {-1.0f, 0.0f, 0.0f},
+        {0.0f, 1.0f, 0.0f},   {0.0f, -1.0f, 0.0f},  {1.0f, 1.0f, -1.0f}, {-1.0f, 1.0f, -1.0f},
+        {1.0f, -1.0f, -1.0f}, {-1.0f, -1.0f, -1.0f},
+    };
+
+    std::mt19937 generator(7u);
+    std::normal_distribution<f32> distribution{};
+    while (directions.size() < count)
+    {
+        const float3_t direction = {distribution(generator), distribution(generator), distribution(generator)};
+        if (length(direction) > 1e-3f)
+        {
+            directions.push_back(direction);
+        }
+    }
+
+    for (float3_t &direction : directions)
+    {
+        direction = normalize(direction);
+    }
+
+    return directions;
+}
+} // namespace
+
+NETHER_TEST(vertex_compression_positions_are_within_half_a_quantization_step)
+{
+    std::mt19937 generator(3u);
+    std::uniform_real_distribution<f32> distribution(-50.0f, 150.0f);
+
+    std::vector<float3_t> positions(10000u);
+    for (float3_t &position : positions)
+    {
+        position = {distribution(generator), distribution(generator) * 0.01f, distribution(generator)};
+    }
+
+    const compressed_mesh_vertices_t compressed_vertices = compress_mesh_vertices({.positions = positions});
+    NETHER_CHECK(compressed_vertices.positions.size() == positions.size());
+
+    f32 max_error = 0.0f;
+    for (size_t i = 0u; i < positions.size(); i++)
+    {
+        const float3_t decoded_position = compressed_vertices.decode_position(compressed_vertices.positions[i]);
+        const float3_t error = decoded_position - positions[i];
+
+        // Each axis is quantized over its own extent. The tolerance covers the float rounding of the decoding.
+        NETHER_CHECK(std::abs(error.x) <= compressed_vertices.position_scale.x * 0.5f + 1e-4f);
+        NETHER_CHECK(std::abs(error.y) <= compressed_vertices.position_scale.y * 0.5f + 1e-4f);
+        NETHER_CHECK(std::abs(error.z) <= compressed_vertices.position_scale.z * 0.5f + 1e-4f);
+        max_error = std::max({max_error, std::abs(error.x), std::abs(error.y), std::abs(error.z)});
+    }
+
+    NETHER_CHECK_NEAR(compressed_vertices.statistics.positions.max_error, max_error, 1e-6f);
+}
+
+NETHER_TEST(vertex_compression_flat_and_single_vertex_meshes_are_exact)
+{
+    const std::array<float3_t, 3> flat_positions = {
+        float3_t{-1.0f, 2.0f, 0.0f},
+        float3_t{1.0f, 2.0f, 0.0f},
+        float3_t{0.0f, 2.0f, 1.0f},
+    };
+
+    const compressed_mesh_vertices_t flat_vertices = compress_mesh_vertices({.positions = flat_positions});
+    NETHER_CHECK(flat_vertices.position_scale.y == 0.0f);
+    for (size_t i = 0u; i < flat_positions.size(); i++)
+    {
+        NETHER_CHECK(flat_vertices.decode_position(flat_vertices.positions[i]).y == 2.0f);
+    }
+
+    const std::array<float3_t, 1> single_position = {float3_t{3.0f, -4.0f, 5.0f}};
+    const compressed_mesh_vertices_t single_vertex = compress_mesh_vertices({.positions = single_position});
+    const float3_t decoded_position = single_vertex.decode_position(single_vertex.positions[0]);
+    NETHER_CHECK(decoded_position.x == 3.0f && decoded_position.y == -4.0f && decoded_position.z == 5.0f);
+    NETHER_CHECK(single_vertex.statistics.positions.max_error == 0.0f);
+}
+
+NETHER_TEST(vertex_compression_normals_and_tangents_round_trip)
+{
+    const std::vector<float3_t> directions = create_directions(20000u);
+
+    f32 max_normal_angle = 0.0f;
+    f32 max_tangent_angle = 0.0f;
+    for (size_t i = 0u; i < directions.size(); i++)
+    {
+        const float3_t &direction = directions[i];
+        max_normal_angle = std::max(max_normal_angle, get_angle(direction, decode_normal(encode_normal(direction))));
+
+        const f32 sign = i % 2u ? -1.0f : 1.0f;
+        const float4_t decoded_tangent = decode_tangent(encode_tangent({direction.x, direction.y, direction.z, sign}));
+        NETHER_CHECK(decoded_tangent.w == sign);
+        max_tangent_angle = std::max(
+            max_tangent_angle, get_angle(direction, {decoded_tangent.x, decoded_tangent.y, decoded_tangent.z}));
+    }
+
+    // 16 bit octahedral normals are accurate to about 0.002 degrees, and the 15 bit tangents to about twice that.
+    NETHER_CHECK(max_normal_angle < to_radians(0.005f));
+    NETHER_CHECK(max_tangent_angle < to_radians(0.01f));
+}
+
+NETHER_TEST(vertex_compression_half_conversion)
+{
+    // Exactly representable values.
+    for (const f32 value : {0.0f, 1.0f, -2.0f, 0.5f, 1024.0f, 65504.0f, -65504.0f, 6.103515625e-05f})
+    {
+        NETHER_CHECK(f16_to_f32(f32_to_f16(value)) == value);
+    }
+
+    NETHER_CHECK(f32_to_f16(1.0f) == 0x3c00u);
+    NETHER_CHECK(f32_to_f16(-0.0f) == 0x8000u);
+
+    // Halfway between 1 and the next half (1 + 2^-10) rounds to even (1), and just above it rounds up.
+    NETHER_CHECK(f32_to_f16(1.0f + 0.00048828125f) == 0x3c00u);
+    NETHER_CHECK(f32_to_f16(1.0f + 0.00049f) == 0x3c01u);
+
+    // Out of range values are clamped to the largest finite half.
+    NETHER_CHECK(f32_to_f16(1e6f) == 0x7bffu);
+    NETHER_CHECK(f32_to_f16(-std::numeric_limits<f32>::infinity()) == 0xfbffu);
+
+    // Denormals.
+    NETHER_CHECK(f32_to_f16(5.9604645e-08f) == 0x0001u);
+    NETHER_CHECK(f16_to_f32(0x0001u) == 5.9604645e-08f);
+    NETHER_CHECK(f32_to_f16(1e-10f) == 0x0000u);
+
+    NETHER_CHECK(std::isnan(f16_to_f32(f32_to_f16(std::numeric_limits<f32>::quiet_NaN()))));
+
+    // UVs in [0, 1] are within half a half-precision step (2^-12 below 1).
+    for (u32 i = 0u; i <= 1000u; i++)
+    {
+        const float2_t uv = {i / 1000.0f, 1.0f - i / 1000.0f};
+        const float2_t decoded_uv = decode_uv(encode_uv(uv));
+        NETHER_CHECK(std::abs(decoded_uv.x - uv.x) <= 0.000245f);
+        NETHER_CHECK(std::abs(decoded_uv.y - uv.y) <= 0.000245f);
+    }
+}
+
+NETHER_TEST(vertex_compression_colors_round_trip)
+{
+    const float4_t decoded_color = decode_color(encode_color({1.0f, 0.5f, -1.0f}));
+    NETHER_CHECK(decoded_color.x == 1.0f);
+    NETHER_CHECK_NEAR(decoded_color.y, 128.0f / 255.0f, 1e-6f);
+    NETHER_CHECK(decoded_color.z == 0.0f);
+    NETHER_CHECK(decoded_color.w == 1.0f);
+
+    NETHER_CHECK(encode_color({1.0f, 0.0f, 0.0f}) == 0xff0000ffu);
+}
+
+NETHER_TEST(vertex_compression_statistics)
+{
+    const std::vector<float3_t> directions = create_directions(5000u);
+    const std::vector<float4_t> tangents(directions.size(), float4_t{1.0f, 0.0f, 0.0f, 1.0f});
+    const std::vector<float2_t> uvs(directions.size(), float2_t{0.25f, 0.75f});
+
+    job_system_t job_system{};
+    const compressed_mesh_vertices_t compressed_vertices = compress_mesh_vertices(
+        {.positions = directions, .normals = directions, .tangents = tangents, .uvs = uvs}, &job_system);
+
+    const vertex_compression_statistics_t &statistics = compressed_vertices.statistics;
+    NETHER_CHECK(statistics.positions.uncompressed_size_in_bytes == 5000u * 12u);
+    NETHER_CHECK(statistics.positions.compressed_size_in_bytes == 5000u * 8u);
+    NETHER_CHECK(statistics.normals.compressed_size_in_bytes == 5000u * 4u);
+    NETHER_CHECK(statistics.tangents.uncompressed_size_in_bytes == 5000u * 16u);
+    NETHER_CHECK(statistics.colors.uncompressed_size_in_bytes == 0u);
+    NETHER_CHECK(statistics.get_uncompressed_size_in_bytes() == 5000u * (12u + 12u + 16u + 8u));
+    NETHER_CHECK(statistics.get_compressed_size_in_bytes() == 5000u * (8u + 4u + 4u + 4u));
+
+    NETHER_CHECK(compressed_vertices.colors.empty());
+    NETHER_CHECK(statistics.normals.max_error > 0.0f && statistics.normals.max_error < to_radians(0.005f));
+    NETHER_CHECK(statistics.uvs.max_error == 0.0f);
+
+    // The serial and parallel compressions are identical.
+    const compressed_mesh_vertices_t serial_vertices =
+        compress_mesh_vertices({.positions = directions, .normals = directions, .tangents = tangents, .uvs = uvs});
+    NETHER_CHECK(serial_vertices.normals == compressed_vertices.normals);
+    NETHER_CHECK(serial_vertices.statistics.normals.max_error == statistics.normals.max_error);
+
+    NETHER_CHECK_THROWS(compress_mesh_vertices({.positions = directions, .uvs = std::span(uvs).first(10u)}));
+}
+
+NETHER_TEST(vertex_compression_indices_round_trip)
+{
+    std::vector<u32> indices = {0u, 1u, 2u, 2u, 1u, 3u, 100000u, 5u, 0xffffffffu, 0u};
+    for (u32 i = 0u; i < 3000u; i++)
+    {
+        indices.push_back(i / 2u + (i % 3u));
+    }
+
+    const std::vector<u8> data = compress_indices(indices);
+    NETHER_CHECK(data.size() < indices.size() * sizeof(u32) / 3u);
+
+    std::vector<u32> decompressed_indices(indices.size());
+    decompress_indices(data, decompressed_indices);
+    NETHER_CHECK(decompressed_indices == indices);
+
+    // Truncated data, or data holding more indices than requested.
+    NETHER_CHECK_THROWS(decompress_indices(std::span(data).first(data.size() - 1u), decompressed_indices));
+    NETHER_CHECK_THROWS(decompress_indices(data, std::span(decompressed_indices).first(indices.size() - 1u)));
+}
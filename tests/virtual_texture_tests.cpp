@@ -0,0 +1,389 @@
+#include "test_framework.hpp"
+
+#include "virtual_texture.hpp"
+
+// A 256^2 texture split into tiles of 32 texels with a border of 2 (4 mips, 8 x 8 tiles in the first mip).
+namespace
+{
+using namespace nether;
+
+constexpr u32 TILE_SIZE = 32u;
+constexpr u32 TILE_BORDER = 2u;
+constexpr u32 TEXTURE_SIZE = 8u * TILE_SIZE;
+constexpr u32 NUM_MIPS = 4u;
+
+std::vector<u32> create_texels()
+{
+    std::vector<u32> texels(TEXTURE_SIZE * TEXTURE_SIZE);
+
+    std::mt19937 random_engine(5u);
+    for (u32 &texel : texels)
+    {
+        texel = static_cast<u32>(random_engine());
+    }
+
+    return texels;
+}
+
+std::filesystem::path write_test_archive(const std::vector<u32> &texels)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "nether-tests" / "virtual_texture.bin";
+    std::filesystem::create_directories(path.parent_path());
+    write_virtual_texture_archive(path, texels, TEXTURE_SIZE, {.tile_size = TILE_SIZE, .tile_border = TILE_BORDER});
+
+    return path;
+}
+
+// The page table entry of every tile must point to the tile itself if it is resident, and otherwise to its closest
+// resident ancestor.
+bool is_page_table_consistent(const virtual_page_table_t &page_table, const std::vector<u32> &tile_pages)
+{
+    for (u32 tile_index = 0u; tile_index < get_num_virtual_tiles(NUM_MIPS); tile_index++)
+    {
+        virtual_tile_t tile = get_virtual_tile(NUM_MIPS, tile_index);
+        const u32 entry = page_table.get_entry(tile);
+
+        while (tile_pages[get_virtual_tile_index(NUM_MIPS, tile)] == virtual_page_cache_t::INVALID_PAGE)
+        {
+            tile = {.mip = tile.mip + 1u, .x = tile.x / 2u, .y = tile.y / 2u};
+        }
+
+        if (entry != pack_virtual_page_table_entry(tile_pages[get_virtual_tile_index(NUM_MIPS, tile)], tile.mip))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+} // namespace
+
+NETHER_TEST(virtual_texture_tile_indices)
+{
+    NETHER_CHECK(get_num_virtual_tiles(NUM_MIPS) == 1u + 4u + 16u + 64u);
+    for (u32 tile_index = 0u; tile_index < get_num_virtual_tiles(NUM_MIPS); tile_index++)
+    {
+        const virtual_tile_t tile = get_virtual_tile(NUM_MIPS, tile_index);
+        NETHER_CHECK(get_virtual_tile_index(NUM_MIPS, tile) == tile_index);
+
+        const virtual_tile_t unpacked_tile = unpack_virtual_tile_id(pack_virtual_tile_id(tile));
+        NETHER_CHECK(unpacked_tile.mip == tile.mip && unpacked_tile.x == tile.x && unpacked_tile.y == tile.y);
+    }
+
+    NETHER_CHECK(get_virtual_tile(NUM_MIPS, 0u).mip == NUM_MIPS - 1u);
+    NETHER_CHECK(get_virtual_tile_index(NUM_MIPS, {.mip = 0u, .x = 7u, .y = 7u}) == 84u);
+}
+
+NETHER_TEST(virtual_texture_feedback_is_deduplicated_and_prioritized)
+{
+    virtual_texture_feedback_processor_t feedback_processor(NUM_MIPS);
+
+    const u32 fine_tile = pack_virtual_tile_id({.mip = 0u, .x = 3u, .y = 5u});
+    const u32 other_fine_tile = pack_virtual_tile_id({.mip = 0u, .x = 4u, .y = 5u});
+    const u32 coarse_tile = pack_virtual_tile_id({.mip = 2u, .x = 1u, .y = 0u});
+
+    const std::array<u32, 10> feedback = {
+        fine_tile,
+        INVALID_VIRTUAL_TILE_ID,
+        other_fine_tile,
+        fine_tile,
+        coarse_tile,
+        pack_virtual_tile_id({.mip = 0u, .x = 8u, .y = 0u}),
+        pack_virtual_tile_id({.mip = NUM_MIPS, .x = 0u, .y = 0u}),
+        fine_tile,
+        other_fine_tile,
+        INVALID_VIRTUAL_TILE_ID,
+    };
+
+    const std::vector<virtual_tile_request_t> &requests = feedback_processor.process(feedback);
+    NETHER_CHECK(requests.size() == 3u);
+    NETHER_CHECK(feedback_processor.statistics.num_samples == 6u);
+    NETHER_CHECK(feedback_processor.statistics.num_invalid_samples == 2u);
+
+    // Coarsest first, then most samples first.
+    NETHER_CHECK(requests[0].tile_index == get_virtual_tile_index(NUM_MIPS, unpack_virtual_tile_id(coarse_tile)));
+    NETHER_CHECK(requests[0].num_samples == 1u);
+    NETHER_CHECK(requests[1].tile_index == get_virtual_tile_index(NUM_MIPS, unpack_virtual_tile_id(fine_tile)));
+    NETHER_CHECK(requests[1].num_samples == 3u);
+    NETHER_CHECK(requests[2].num_samples == 2u);
+
+    // The counters are reset between feedback buffers.
+    feedback_processor.process(std::span(feedback).first(1u));
+    NETHER_CHECK(feedback_processor.requests.size() == 1u && feedback_processor.requests[0].num_samples == 1u);
+}
+
+NETHER_TEST(virtual_texture_page_table_points_to_closest_resident_ancestor)
+{
+    const u32 num_tiles = get_num_virtual_tiles(NUM_MIPS);
+
+    virtual_page_table_t page_table(NUM_MIPS, 0u);
+    std::vector<u32> tile_pages(num_tiles, virtual_page_cache_t::INVALID_PAGE);
+    tile_pages[0] = 0u;
+    NETHER_CHECK(is_page_table_consistent(page_table, tile_pages));
+
+    // Tiles are mapped and unmapped in any order, as loads complete out of order and children can outlive their
+    // parents.
+    std::mt19937 random_engine(9u);
+    u32 next_page = 1u;
+    for (u32 i = 0u; i < 2000u; i++)
+    {
+        const u32 tile_index = 1u + random_engine() % (num_tiles - 1u);
+        const virtual_tile_t tile = get_virtual_tile(NUM_MIPS, tile_index);
+
+        page_table.clear_dirty_regions();
+        if (tile_pages[tile_index] == virtual_page_cache_t::INVALID_PAGE)
+        {
+            tile_pages[tile_index] = next_page++ % 65536u;
+            page_table.map(tile, tile_pages[tile_index]);
+        }
+        else
+        {
+            tile_pages[tile_index] = virtual_page_cache_t::INVALID_PAGE;
+            page_table.unmap(tile);
+        }
+
+        // The tile's own entry always changes.
+        const virtual_page_table_region_t &dirty_region = page_table.get_dirty_regions()[tile.mip];
+        NETHER_CHECK(dirty_region.min_x <= tile.x && tile.x <= dirty_region.max_x);
+        NETHER_CHECK(dirty_region.min_y <= tile.y && tile.y <= dirty_region.max_y);
+        NETHER_CHECK(page_table.get_dirty_regions()[NUM_MIPS - 1u].is_empty());
+
+        if (i % 50u == 0u)
+        {
+            NETHER_CHECK(is_page_table_consistent(page_table, tile_pages));
+        }
+    }
+
+    NETHER_CHECK(is_page_table_consistent(page_table, tile_pages));
+    NETHER_CHECK_THROWS(page_table.unmap({.mip = NUM_MIPS - 1u}));
+}
+
+NETHER_TEST(virtual_texture_page_cache_recycles_least_recently_used)
+{
+    virtual_page_cache_t page_cache(4u);
+
+    // Free pages are reused first, whatever the eviction delay, page 0 first.
+    for (u32 page = 0u; page < 4u; page++)
+    {
+        NETHER_CHECK(page_cache.acquire(1u, 3u) == page);
+        page_cache.release(page, 10u + page, 1u);
+    }
+
+    // Every page was used during update 1.
+    NETHER_CHECK(page_cache.acquire(2u, 3u) == virtual_page_cache_t::INVALID_PAGE);
+
+    page_cache.touch(0u, 2u);
+    page_cache.touch(2u, 3u);
+
+    NETHER_CHECK(page_cache.acquire(4u, 3u) == 1u);
+    NETHER_CHECK(page_cache.get_page_tile(1u) == 11u);
+    NETHER_CHECK(page_cache.acquire(4u, 3u) == 3u);
+
+    // Page 0 was used during update 2, so it can only be reused from update 5.
+    NETHER_CHECK(page_cache.acquire(4u, 3u) == virtual_page_cache_t::INVALID_PAGE);
+    NETHER_CHECK(page_cache.acquire(5u, 3u) == 0u);
+
+    // Acquired pages are locked : touching them does nothing until they are released. Free pages are put back at the
+    // least recently used end.
+    page_cache.touch(1u, 6u);
+    page_cache.release(1u, 20u, 6u);
+    page_cache.release(3u, virtual_page_cache_t::INVALID_TILE_INDEX, 6u);
+    NETHER_CHECK(page_cache.acquire(7u, 3u) == 3u);
+    NETHER_CHECK(page_cache.acquire(7u, 3u) == 2u);
+    NETHER_CHECK(page_cache.acquire(7u, 3u) == virtual_page_cache_t::INVALID_PAGE);
+    NETHER_CHECK(page_cache.acquire(9u, 3u) == 1u);
+}
+
+NETHER_TEST(virtual_texture_streamed_tiles_match_texture)
+{
+    const std::vector<u32> texels = create_texels();
+    const std::filesystem::path path = write_test_archive(texels);
+
+    const virtual_texture_archive_header_t header = read_virtual_texture_archive_header(path);
+    NETHER_CHECK(header.num_mips == NUM_MIPS);
+    NETHER_CHECK(header.num_tiles == get_num_virtual_tiles(NUM_MIPS));
+
+    virtual_texture_t virtual_texture(path, {.num_pages = 128u, .max_tile_loads_per_update = 16u});
+    NETHER_CHECK(virtual_texture.is_resident({.mip = NUM_MIPS - 1u}));
+    NETHER_CHECK(virtual_texture.updated_pages.size() == 1u);
+
+    // Every tile of the first 2 mips.
+    std::vector<u32> feedback{};
+    for (u32 mip = 0u; mip < 2u; mip++)
+    {
+        for (u32 y = 0u; y < (8u >> mip); y++)
+        {
+            for (u32 x = 0u; x < (8u >> mip); x++)
+            {
+                feedback.push_back(pack_virtual_tile_id({.mip = mip, .x = x, .y = y}));
+            }
+        }
+    }
+
+    u32 num_updates = 0u;
+    do
+    {
+        virtual_texture.update(feedback);
+        num_updates++;
+    } while (virtual_texture.statistics.num_missing_tiles > 0u && num_updates < 100u);
+
+    // 16 loads per update, coarsest first.
+    NETHER_CHECK(num_updates == 6u);
+    NETHER_CHECK(virtual_texture.statistics.num_resident_tiles == 81u);
+    NETHER_CHECK(virtual_texture.statistics.num_evicted_tiles == 0u);
+
+    const u32 page_size = virtual_texture.get_page_size();
+    for (u32 tile_index = 0u; tile_index < header.num_tiles; tile_index++)
+    {
+        const virtual_tile_t tile = get_virtual_tile(NUM_MIPS, tile_index);
+        if (tile.mip > 1u && tile.mip != NUM_MIPS - 1u)
+        {
+            NETHER_CHECK(!virtual_texture.is_resident(tile));
+            continue;
+        }
+
+        NETHER_CHECK(virtual_texture.is_resident(tile));
+
+        const u32 entry = virtual_texture.get_page_table().get_entry(tile);
+        NETHER_CHECK(get_virtual_page_table_entry_mip(entry) == tile.mip);
+        const std::span<const u32> page = virtual_texture.get_page(get_virtual_page_table_entry_page(entry));
+
+        // Mip 1 texels are the rounded average of the 2 x 2 texels of mip 0, per channel.
+        const auto get_texel = [&](const i32 x, const i32 y) {
+            const i32 mip_size = static_cast<i32>(TEXTURE_SIZE >> tile.mip);
+            const u32 clamped_x = static_cast<u32>(std::clamp(x, 0, mip_size - 1)) << tile.mip;
+            const u32 clamped_y = static_cast<u32>(std::clamp(y, 0, mip_size - 1)) << tile.mip;
+            if (tile.mip == 0u)
+            {
+                return texels[clamped_y * TEXTURE_SIZE + clamped_x];
+            }
+
+            u32 result = 0u;
+            for (u32 shift = 0u; shift < 32u; shift += 8u)
+            {
+                u32 sum = 0u;
+                for (u32 i = 0u; i < 4u; i++)
+                {
+                    sum += (texels[(clamped_y + i / 2u) * TEXTURE_SIZE + clamped_x + i % 2u] >> shift) & 0xffu;
+                }
+                result |= ((sum + 2u) / 4u) << shift;
+            }
+
+            return result;
+        };
+
+        if (tile.mip > 1u)
+        {
+            continue;
+        }
+
+        u32 num_mismatches = 0u;
+        for (u32 y = 0u; y < page_size; y++)
+        {
+            for (u32 x = 0u; x < page_size; x++)
+            {
+                const i32 texel_x = static_cast<i32>(tile.x * TILE_SIZE + x) - static_cast<i32>(TILE_BORDER);
+                const i32 texel_y = static_cast<i32>(tile.y * TILE_SIZE + y) - static_cast<i32>(TILE_BORDER);
+                num_mismatches += page[y * page_size + x] != get_texel(texel_x, texel_y);
+            }
+        }
+
+        NETHER_CHECK(num_mismatches == 0u);
+    }
+
+    std::filesystem::remove(path);
+}
+
+NETHER_TEST(virtual_texture_cache_stays_bounded)
+{
+    const std::filesystem::path path = write_test_archive(create_texels());
+
+    job_system_t job_system(3u);
+    {
+        // The window needs at most 13 tiles.
+        constexpr u32 NUM_PAGES = 16u;
+        virtual_texture_t virtual_texture(
+            path, {.num_pages = NUM_PAGES, .max_tile_loads_per_update = 4u, .eviction_delay_in_updates = 2u});
+
+        // A window of tiles that moves over the first mip, with every ancestor of its tiles requested too.
+        u64 num_evicted_tiles = 0u;
+        u64 num_completed_loads = 0u;
+        std::vector<u32> feedback{};
+        for (u32 update = 0u; update < 200u; update++)
+        {
+            feedback.clear();
+            const u32 window_x = (update / 10u) % 7u;
+            for (u32 i = 0u; i < 4u; i++)
+            {
+                for (u32 mip = 0u; mip < NUM_MIPS; mip++)
+                {
+                    feedback.push_back(pack_virtual_tile_id(
+                        {.mip = mip, .x = (window_x + i % 2u) >> mip, .y = (3u + i / 2u) >> mip}));
+                }
+            }
+
+            virtual_texture.update(feedback, &job_system);
+
+            // Some loads stay pending over an update, while the others complete before the next one (the workers may
+            // not get to run otherwise, on a machine with few cores).
+            if (update % 2u == 1u)
+            {
+                job_system.wait_for_idle();
+            }
+
+            const virtual_texture_statistics_t &statistics = virtual_texture.statistics;
+            NETHER_CHECK(statistics.num_resident_tiles + statistics.num_pending_loads <= NUM_PAGES);
+            NETHER_CHECK(statistics.num_issued_loads <= 4u);
+            NETHER_CHECK(virtual_texture.is_resident({.mip = NUM_MIPS - 1u}));
+
+            num_evicted_tiles += statistics.num_evicted_tiles;
+            num_completed_loads += statistics.num_completed_loads;
+        }
+
+        NETHER_CHECK(num_evicted_tiles > 0u);
+        NETHER_CHECK(num_completed_loads > NUM_PAGES);
+
+        // Wait for the last loads, so that the final window is resident.
+        job_system.wait_for_idle();
+        virtual_texture.update(feedback, &job_system);
+        job_system.wait_for_idle();
+        virtual_texture.update(feedback, &job_system);
+        NETHER_CHECK(virtual_texture.statistics.num_missing_tiles == 0u);
+        for (const u32 tile_id : feedback)
+        {
+            NETHER_CHECK(virtual_texture.is_resident(unpack_virtual_tile_id(tile_id)));
+        }
+
+        // Destroyed with loads possibly in flight.
+        feedback.assign(1u, pack_virtual_tile_id({.mip = 0u, .x = 0u, .y = 0u}));
+        virtual_texture.update(feedback, &job_system);
+    }
+
+    std::filesystem::remove(path);
+}
+
+NETHER_TEST(virtual_texture_invalid_inputs_throw)
+{
+    const std::vector<u32> texels = create_texels();
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "nether-tests" / "invalid.bin";
+    std::filesystem::create_directories(path.parent_path());
+
+    NETHER_CHECK_THROWS(write_virtual_texture_archive(path, texels, TEXTURE_SIZE, {.tile_size = 48u}));
+    NETHER_CHECK_THROWS(write_virtual_texture_archive(path, std::span(texels).first(1000u), TEXTURE_SIZE, {}));
+
+    const std::filesystem::path archive_path = write_test_archive(texels);
+    NETHER_CHECK_THROWS(virtual_texture_t(archive_path, {.num_pages = 1u}));
+
+    // Truncated archive.
+    std::filesystem::resize_file(archive_path, std::filesystem::file_size(archive_path) - 1u);
+    NETHER_CHECK_THROWS(read_virtual_texture_archive_header(archive_path));
+
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "not a virtual texture archive, but long enough to hold a header";
+    }
+    NETHER_CHECK_THROWS(read_virtual_texture_archive_header(path));
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(archive_path);
+}
@@ -0,0 +1,100 @@
+#include "common.hpp"
+
+#include "image_based_lighting.hpp"
+
+#include <bit>
+#include <chrono>
+
+// Offline tool that precomputes the image based lighting of an HDR environment on all cores (see
+// image_based_lighting.hpp), and writes it as DDS files to the output directory : the environment cubemap with its mips
+// (environment.dds), the prefiltered specular cubemap (specular.dds), the irradiance spherical harmonics
+// (irradiance_sh.dds) and the BRDF LUT (brdf_lut.dds).
+// Usage : nether-ibl-baker <output directory> <equirectangular .hdr | +x -x +y -y +z -z face .hdr files>
+namespace
+{
+using namespace nether;
+
+constexpr u32 BRDF_LUT_SIZE = 128u;
+constexpr u32 BRDF_LUT_NUM_SAMPLES = 1024u;
+
+f32 get_time_in_ms(const std::chrono::steady_clock::time_point &start_time)
+{
+    return std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        if (argc != 3 && argc != 8)
+        {
+            throw std::runtime_error("Usage : nether-ibl-baker <output directory> <equirectangular .hdr | +x -x +y -y "
+                                     "+z -z face .hdr files>");
+        }
+
+        const std::filesystem::path output_directory = argv[1];
+        std::filesystem::create_directories(output_directory);
+
+        job_system_t job_system{};
+        const specular_prefilter_settings_t settings{};
+
+        auto start_time = std::chrono::steady_clock::now();
+
+        // Panoramas are converted to faces of a quarter of their width, at least as large as the specular cubemap.
+        cubemap_t environment{};
+        if (argc == 3)
+        {
+            const hdr_image_t panorama = read_hdr_image(argv[2]);
+            environment = equirectangular_to_cubemap(
+                panorama, std::max(std::bit_ceil(std::max(panorama.width / 4u, 1u)), settings.size), &job_system);
+        }
+        else
+        {
+            std::vector<hdr_image_t> faces{};
+            for (i32 i = 2; i < argc; i++)
+            {
+                faces.push_back(read_hdr_image(argv[i]));
+            }
+
+            environment = cubemap_from_faces(faces);
+        }
+
+        generate_cubemap_mips(environment, &job_system);
+        write_dds(output_directory / "environment.dds", to_dds_image(environment));
+
+        std::cout << std::format("Environment of {}x{} faces and {} mips ({:.1f} ms)", environment.size,
+                                 environment.size, environment.num_mips, get_time_in_ms(start_time))
+                  << std::endl;
+
+        start_time = std::chrono::steady_clock::now();
+        const sh9_t sh = compute_irradiance_sh9(environment, &job_system);
+        write_dds(output_directory / "irradiance_sh.dds", to_dds_image(sh));
+
+        std::cout << std::format("Irradiance spherical harmonics ({:.1f} ms)", get_time_in_ms(start_time))
+                  << std::endl;
+
+        start_time = std::chrono::steady_clock::now();
+        const cubemap_t specular = prefilter_specular(environment, settings, &job_system);
+        write_dds(output_directory / "specular.dds", to_dds_image(specular));
+
+        std::cout << std::format("Specular cubemap of {}x{} faces, {} mips of {} samples ({:.1f} ms)", specular.size,
+                                 specular.size, specular.num_mips, settings.num_samples, get_time_in_ms(start_time))
+                  << std::endl;
+
+        start_time = std::chrono::steady_clock::now();
+        write_dds(output_directory / "brdf_lut.dds",
+                  to_dds_image(compute_brdf_lut(BRDF_LUT_SIZE, BRDF_LUT_NUM_SAMPLES, &job_system)));
+
+        std::cout << std::format("BRDF LUT of {}x{} texels and {} samples ({:.1f} ms)", BRDF_LUT_SIZE, BRDF_LUT_SIZE,
+                                 BRDF_LUT_NUM_SAMPLES, get_time_in_ms(start_time))
+                  << std::endl;
+    }
+    catch (std::exception &e)
+    {
+        std::cout << e.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "common.hpp"
+
+#include "lightmap_baker.hpp"
+
+#include <chrono>
+
+// Offline tool that bakes the lightmap of the demo scene's static geometry (the floor, the cube at rest above it, and
+// the main light) on all cores, printing the progress of every pass, and writes it as a DDS file (see
+// lightmap_baker.hpp). The UVs of the lightmap are given by unwrap_lightmap with the same settings.
+// Usage : nether-lightmap-baker <lightmap path> [texels per unit] [max samples per texel] [target relative error]
+namespace
+{
+using namespace nether;
+
+constexpr std::array<float3_t, 8> CUBE_POSITIONS = {
+    float3_t{-1.0f, -1.0f, -1.0f}, float3_t{-1.0f, 1.0f, -1.0f}, float3_t{1.0f, 1.0f, -1.0f},
+    float3_t{1.0f, -1.0f, -1.0f},  float3_t{-1.0f, -1.0f, 1.0f}, float3_t{-1.0f, 1.0f, 1.0f},
+    float3_t{1.0f, 1.0f, 1.0f},    float3_t{1.0f, -1.0f, 1.0f},
+};
+
+constexpr std::array<u32, 36> CUBE_INDICES = {
+    0u, 1u, 2u, 0u, 2u, 3u, 4u, 6u, 5u, 4u, 7u, 6u, 4u, 5u, 1u, 4u, 1u, 0u,
+    3u, 2u, 6u, 3u, 6u, 7u, 1u, 5u, 6u, 1u, 6u, 2u, 4u, 0u, 3u, 4u, 3u, 7u,
+};
+} // namespace
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        if (argc < 2)
+        {
+            throw std::runtime_error("Usage : nether-lightmap-baker <lightmap path> [texels per unit] [max samples per "
+                                     "texel] [target relative error]");
+        }
+
+        const std::filesystem::path lightmap_path = argv[1];
+
+        lightmap_bake_settings_t settings{};
+        if (argc > 2)
+        {
+            settings.texels_per_unit = std::stof(argv[2]);
+        }
+        if (argc > 3)
+        {
+            settings.max_samples = static_cast<u32>(std::stoul(argv[3]));
+        }
+        if (argc > 4)
+        {
+            settings.target_relative_error = std::stof(argv[4]);
+        }
+
+        // Same transforms and light as the demo scene in main.cpp.
+        const std::array<lightmap_mesh_t, 2> meshes = {
+            lightmap_mesh_t{
+                .positions = CUBE_POSITIONS,
+                .indices = CUBE_INDICES,
+                .model_matrix = scaling_matrix({40.0f, 0.2f, 40.0f}) * translation_matrix({0.0f, -3.0f, 20.0f}),
+            },
+            lightmap_mesh_t{
+                .positions = CUBE_POSITIONS,
+                .indices = CUBE_INDICES,
+                .model_matrix = translation_matrix({0.0f, 0.0f, 5.0f}),
+            },
+        };
+
+        const std::array<light_t, 1> lights = {
+            light_t{.position = {0.0f, 7.0f, 10.0f}, .range = 30.0f, .color = {40.0f, 40.0f, 40.0f}},
+        };
+
+        const auto start_time = std::chrono::steady_clock::now();
+
+        job_system_t job_system{};
+        lightmap_baker_t baker(meshes, lights, settings, &job_system);
+
+        std::cout << std::format("{} triangles, {} charts, {} texels in a {}x{} atlas (setup {:.1f} ms)",
+                                 baker.statistics.num_triangles, baker.statistics.num_charts,
+                                 baker.statistics.num_texels, baker.get_atlas().width, baker.get_atlas().height,
+                                 baker.statistics.setup_time_in_ms)
+                  << std::endl;
+
+        bool is_converged = baker.is_converged();
+        while (!is_converged)
+        {
+            is_converged = baker.render_pass(&job_system);
+
+            std::cout << std::format("{:5} samples per texel : {:.2f} Mrays/s, relative error {:.4f} ({:.1f} ms)",
+                                     baker.statistics.num_samples, baker.statistics.rays_per_second * 1e-6f,
+                                     baker.statistics.relative_error, baker.statistics.pass_time_in_ms)
+                      << std::endl;
+        }
+
+        write_lightmap(lightmap_path, baker.resolve(&job_system));
+
+        std::cout << std::format("Wrote {} ({} rays, resolve {:.1f} ms) in {:.1f} s", lightmap_path.string(),
+                                 baker.statistics.num_rays, baker.statistics.resolve_time_in_ms,
+                                 std::chrono::duration<f32>(std::chrono::steady_clock::now() - start_time).count())
+                  << std::endl;
+    }
+    catch (std::exception &e)
+    {
+        std::cout << e.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
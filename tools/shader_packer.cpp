@@ -0,0 +1,143 @@
+#include "common.hpp"
+
+#include "shader_archive.hpp"
+#include "shader_permutations.hpp"
+
+#include <chrono>
+
+// Offline tool that compiles every permutation of the shaders listed in a manifest, and packs the bytecode into a
+// shader archive (see shader_archive.hpp).
+// Usage : nether-shader-packer [manifest path] [archive path]
+// Run from the repository root, as shader paths in the manifest (and the keys of the archive) are relative to it.
+static constexpr std::string_view DEFAULT_MANIFEST_PATH = "shaders/shader_manifest.txt";
+
+struct manifest_entry_t
+{
+    std::wstring shader_path{};
+    std::wstring target_profile{};
+    std::wstring entry_point{};
+};
+
+// Each line is '<path> <target profile> <entry point>'. Empty lines and lines starting with '#' are ignored.
+static std::vector<manifest_entry_t> parse_manifest(const std::filesystem::path &manifest_path)
+{
+    std::ifstream manifest_file(manifest_path);
+    if (!manifest_file.is_open())
+    {
+        throw std::runtime_error(std::format("Failed to open shader manifest {}", manifest_path.string()));
+    }
+
+    std::vector<manifest_entry_t> entries{};
+
+    std::string line{};
+    u32 line_number = 0u;
+    while (std::getline(manifest_file, line))
+    {
+        line_number++;
+
+        std::istringstream line_stream(line);
+
+        std::string shader_path{};
+        std::string target_profile{};
+        std::string entry_point{};
+        if (!(line_stream >> shader_path) || shader_path.starts_with('#'))
+        {
+            continue;
+        }
+
+        if (!(line_stream >> target_profile >> entry_point))
+        {
+            throw std::runtime_error(std::format("{}:{} : expected '<path> <target profile> <entry point>'",
+                                                 manifest_path.string(), line_number));
+        }
+
+        entries.push_back({
+            .shader_path = std::wstring(shader_path.begin(), shader_path.end()),
+            .target_profile = std::wstring(target_profile.begin(), target_profile.end()),
+            .entry_point = std::wstring(entry_point.begin(), entry_point.end()),
+        });
+    }
+
+    return entries;
+}
+
+// Shader paths, profiles and axes are ASCII.
+static std::string to_ascii(const std::wstring_view string)
+{
+    std::string result(string.size(), '\0');
+    std::transform(string.begin(), string.end(), result.begin(),
+                   [](const wchar_t character) { return static_cast<char>(character); });
+
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        const std::filesystem::path manifest_path = argc > 1 ? argv[1] : DEFAULT_MANIFEST_PATH;
+        const std::filesystem::path archive_path = argc > 2 ? argv[2] : nether::DEFAULT_SHADER_ARCHIVE_PATH;
+
+        const auto start_time = std::chrono::steady_clock::now();
+
+        nether::shader_archive_writer_t archive_writer(NETHER_DEBUG ? nether::SHADER_ARCHIVE_FLAG_DEBUG : 0u);
+
+        for (const manifest_entry_t &manifest_entry : parse_manifest(manifest_path))
+        {
+            nether::shader_compiler::shader_permutation_set_t permutation_set(
+                manifest_entry.shader_path, manifest_entry.target_profile, manifest_entry.entry_point);
+            permutation_set.compile_all();
+
+            const std::string shader_path = to_ascii(manifest_entry.shader_path);
+            const std::string target_profile = to_ascii(manifest_entry.target_profile);
+            const std::string entry_point = to_ascii(manifest_entry.entry_point);
+
+            for (u32 permutation_mask = 0u; permutation_mask < permutation_set.get_num_permutations();
+                 permutation_mask++)
+            {
+                std::string defines{};
+                for (u32 axis_index = 0u; axis_index < static_cast<u32>(permutation_set.axes.size()); axis_index++)
+                {
+                    if (permutation_mask & (1u << axis_index))
+                    {
+                        defines += defines.empty() ? "" : " ";
+                        defines += to_ascii(permutation_set.axes[axis_index]);
+                    }
+                }
+
+                IDxcBlob *const blob = permutation_set.get(permutation_mask);
+                archive_writer.add(
+                    nether::get_shader_archive_key(manifest_entry.shader_path, manifest_entry.target_profile,
+                                                   manifest_entry.entry_point, permutation_mask),
+                    std::span(static_cast<const u8 *>(blob->GetBufferPointer()), blob->GetBufferSize()),
+                    {
+                        .shader_path = shader_path,
+                        .target_profile = target_profile,
+                        .entry_point = entry_point,
+                        .defines = defines,
+                        .permutation_mask = permutation_mask,
+                    });
+            }
+
+            std::cout << std::format("{} ({}, {}) :: {} permutations, compiled {}", shader_path, target_profile,
+                                     entry_point, permutation_set.get_num_permutations(),
+                                     permutation_set.statistics.num_compiled)
+                      << std::endl;
+        }
+
+        archive_writer.write(archive_path);
+
+        std::cout << std::format("Wrote {} entries ({} unique blobs) to {} in {:.1f} s",
+                                 archive_writer.get_num_entries(), archive_writer.get_num_blobs(),
+                                 archive_path.string(),
+                                 std::chrono::duration<f32>(std::chrono::steady_clock::now() - start_time).count())
+                  << std::endl;
+    }
+    catch (std::exception &e)
+    {
+        std::cout << e.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
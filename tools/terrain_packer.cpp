@@ -0,0 +1,79 @@
+#include "common.hpp"
+
+#include "terrain.hpp"
+
+#include <chrono>
+
+// Offline tool that splits a square heightmap into a terrain archive (see terrain.hpp).
+// Usage : nether-terrain-packer <heightmap path> <archive path> [tile resolution] [sample spacing] [height scale]
+// The heightmap is raw little endian unorm16 samples in row major order (the .r16 export of most terrain tools), with
+// tile_resolution * 2^n + 1 samples per side.
+int main(int argc, char **argv)
+{
+    try
+    {
+        if (argc < 3)
+        {
+            throw std::runtime_error("Usage : nether-terrain-packer <heightmap path> <archive path> [tile resolution] "
+                                     "[sample spacing] [height scale]");
+        }
+
+        const std::filesystem::path heightmap_path = argv[1];
+        const std::filesystem::path archive_path = argv[2];
+
+        nether::terrain_archive_desc_t desc{};
+        if (argc > 3)
+        {
+            desc.tile_resolution = static_cast<u32>(std::stoul(argv[3]));
+        }
+        if (argc > 4)
+        {
+            desc.sample_spacing = std::stof(argv[4]);
+        }
+        if (argc > 5)
+        {
+            desc.height_scale = std::stof(argv[5]);
+        }
+
+        const auto start_time = std::chrono::steady_clock::now();
+
+        std::ifstream heightmap_file(heightmap_path, std::ios::binary);
+        if (!heightmap_file.is_open())
+        {
+            throw std::runtime_error(std::format("Failed to open heightmap {}", heightmap_path.string()));
+        }
+
+        const u64 num_samples = std::filesystem::file_size(heightmap_path) / sizeof(u16);
+        const u32 size = static_cast<u32>(std::sqrt(static_cast<f64>(num_samples)));
+        if (static_cast<u64>(size) * size != num_samples)
+        {
+            throw std::runtime_error(std::format("Heightmap {} has {} samples, which is not a square",
+                                                 heightmap_path.string(), num_samples));
+        }
+
+        std::vector<u16> heights(num_samples);
+        heightmap_file.read(reinterpret_cast<char *>(heights.data()),
+                            static_cast<std::streamsize>(heights.size() * sizeof(u16)));
+        if (!heightmap_file)
+        {
+            throw std::runtime_error(std::format("Failed to read heightmap {}", heightmap_path.string()));
+        }
+
+        nether::job_system_t job_system{};
+        nether::write_terrain_archive(archive_path, heights, size, desc, &job_system);
+
+        const nether::terrain_archive_header_t header = nether::read_terrain_archive_header(archive_path);
+        std::cout << std::format("Wrote {} ({}^2 samples, {} depths, {} tiles of {} quads, {} bytes) in {:.1f} s",
+                                 archive_path.string(), size, header.num_depths, header.num_nodes,
+                                 header.tile_resolution, header.file_size,
+                                 std::chrono::duration<f32>(std::chrono::steady_clock::now() - start_time).count())
+                  << std::endl;
+    }
+    catch (std::exception &e)
+    {
+        std::cout << e.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}